@@ -133,6 +133,8 @@ namespace Ogre
                          uint16 sliceIdx = std::numeric_limits<uint16>::max() );
         TextureGpu *getTexture( uint8 texType ) const;
 
+        void notifyTexturesUsed( float distanceToCamera ) override;
+
         /// Same as setTexture, but samplerblockPtr is a raw samplerblock retrieved from HlmsManager,
         /// and is assumed to have its reference count already be incremented for us
         /// (note HlmsManager::getSamplerblock() already increments the ref. count).
@@ -407,6 +407,15 @@ namespace Ogre
         return mTextures[texType];
     }
     //-----------------------------------------------------------------------------------
+    void OGRE_HLMS_TEXTURE_BASE_CLASS::notifyTexturesUsed( float distanceToCamera )
+    {
+        for( size_t i = 0; i < OGRE_HLMS_TEXTURE_BASE_MAX_TEX; ++i )
+        {
+            if( mTextures[i] )
+                mTextures[i]->notifyUsed( distanceToCamera );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void OGRE_HLMS_TEXTURE_BASE_CLASS::setSamplerblock( uint8 texType, const HlmsSamplerblock &params )
     {
         HlmsManager *hlmsManager = mCreator->getHlmsManager();
@@ -152,6 +152,7 @@ namespace Ogre
         mObjectData.mWorldAabb->setFromAabb( aabb, mObjectData.mIndex );
         mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
         mObjectData.mWorldRadius[mObjectData.mIndex] = aabb.getRadius();
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
     }
     //-----------------------------------------------------------------------------------
     const String &IfdProbeVisualizer::getMovableType() const { return BLANKSTRING; }
@@ -75,6 +75,9 @@ namespace Ogre
         uint8 mUvSource[NUM_UNLIT_TEXTURE_TYPES];
         uint8 mBlendModes[NUM_UNLIT_TEXTURE_TYPES];
         bool  mEnabledAnimationMatrices[NUM_UNLIT_TEXTURE_TYPES];
+        /// Animation matrices we enabled ourselves because the texture was packed into a
+        /// bigger pool (see TextureGpuManager::setAutoPackingMaxResolution)
+        bool mPackedAnimationMatrices[NUM_UNLIT_TEXTURE_TYPES];
         bool  mEnablePlanarReflection[NUM_UNLIT_TEXTURE_TYPES];
 
         uint8 mTextureSwizzles[NUM_UNLIT_TEXTURE_TYPES];
@@ -84,6 +87,14 @@ namespace Ogre
         void uploadToConstBuffer( char *dstPtr, uint8 dirtyFlags ) override;
         void uploadToExtraBuffer( char *dstPtr ) override;
 
+        /// Enables (or disables) the animation matrices of the texture units
+        /// whose textures are packed, so that their UVs get remapped.
+        void updatePackedAnimationMatrices();
+
+        /// Throws if texture has TextureFlags::AllowAutoPacking but samplerblock doesn't clamp
+        static void checkAutoPackingSampler( const TextureGpu       *texture,
+                                             const HlmsSamplerblock *samplerblock );
+
     public:
         /** Valid parameters in params:
         @param params
@@ -155,6 +166,18 @@ namespace Ogre
         using HlmsUnlitBaseTextureDatablock::setTexture;
 
         void setTexture( uint8 texUnit, const String &name, const HlmsSamplerblock *refParams = 0 );
+        /// See HlmsUnlitBaseTextureDatablock::setTexture.
+        /// Textures with TextureFlags::AllowAutoPacking must be sampled with TAM_CLAMP
+        void setTexture( uint8 texType, TextureGpu *texture, const HlmsSamplerblock *refParams = 0,
+                         uint16 sliceIdx = std::numeric_limits<uint16>::max() );
+        /// See HlmsUnlitBaseTextureDatablock::_setTexture
+        void _setTexture( uint8 texType, TextureGpu *texture,
+                          const HlmsSamplerblock *samplerblockPtr = 0,
+                          uint16 sliceIdx = std::numeric_limits<uint16>::max() );
+        /// See HlmsUnlitBaseTextureDatablock::setSamplerblock
+        void setSamplerblock( uint8 texType, const HlmsSamplerblock &params );
+        /// See HlmsUnlitBaseTextureDatablock::_setSamplerblock
+        void _setSamplerblock( uint8 texType, const HlmsSamplerblock *samplerblockPtr );
 
         /** Sets the final swizzle when sampling the given texture. e.g.
             calling setTextureSwizzle( 0, R_MASK, G_MASK, R_MASK, G_MASK );
@@ -203,6 +226,10 @@ namespace Ogre
 
         /** Enables the animation of the given texture unit.
             Calling this function triggers a HlmsDatablock::flushRenderables.
+        @remarks
+            Textures packed into a bigger TexturePool (see
+            TextureGpuManager::setAutoPackingMaxResolution) get their animation matrix
+            enabled automatically, and their UV scale is applied on top of the matrix.
         @param textureUnit
             Texture unit. Must be in range [0; NUM_UNLIT_TEXTURE_TYPES)
         @param bEnable
@@ -234,6 +261,9 @@ namespace Ogre
 
         void calculateHash() override;
 
+        void notifyTextureChanged( TextureGpu *texture, TextureGpuListener::Reason reason,
+                                   void *extraData ) override;
+
         static const uint32 MaterialSizeInGpu;
         static const uint32 MaterialSizeInGpuAligned;
     };
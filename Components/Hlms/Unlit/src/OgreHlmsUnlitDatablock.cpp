@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "OgreTextureFilters.h"
 #include "OgreTextureGpu.h"
 #include "OgreTextureGpuManager.h"
+#include "OgreVector2.h"
 
 #define _OgreHlmsTextureBaseClassExport _OgreHlmsUnlitExport
 #define OGRE_HLMS_TEXTURE_BASE_CLASS HlmsUnlitBaseTextureDatablock
@@ -96,6 +97,7 @@ namespace Ogre
         memset( mBlendModes, 0, sizeof( mBlendModes ) );
 
         memset( mEnabledAnimationMatrices, 0, sizeof( mEnabledAnimationMatrices ) );
+        memset( mPackedAnimationMatrices, 0, sizeof( mPackedAnimationMatrices ) );
         memset( mEnablePlanarReflection, 0, sizeof( mEnablePlanarReflection ) );
 
         String paramVal;
@@ -259,16 +261,71 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsUnlitDatablock::uploadToExtraBuffer( char *dstPtr )
     {
+        const Matrix4 *textureMatrices = mTextureMatrices;
+
+        // Packed textures only cover the top-left portion of their slice. Remap
+        // the UVs after the user's animation (i.e. uv = scale * matrix * uv + offset)
+        Matrix4 packedMatrices[NUM_UNLIT_TEXTURE_TYPES];
+        for( size_t i = 0; i < NUM_UNLIT_TEXTURE_TYPES; ++i )
+        {
+            if( mEnabledAnimationMatrices[i] && mTextures[i] && mTextures[i]->getTexturePool() )
+            {
+                const Vector2 uvScale = mTextures[i]->getInternalUvScale();
+                if( uvScale != Vector2::UNIT_SCALE )
+                {
+                    if( textureMatrices == mTextureMatrices )
+                    {
+                        for( size_t j = 0; j < NUM_UNLIT_TEXTURE_TYPES; ++j )
+                            packedMatrices[j] = mTextureMatrices[j];
+                        textureMatrices = packedMatrices;
+                    }
+
+                    const Vector2 uvOffset = mTextures[i]->getInternalUvOffset();
+                    for( size_t j = 0; j < 4u; ++j )
+                    {
+                        packedMatrices[i][0][j] =
+                            packedMatrices[i][0][j] * uvScale.x + packedMatrices[i][3][j] * uvOffset.x;
+                        packedMatrices[i][1][j] =
+                            packedMatrices[i][1][j] * uvScale.y + packedMatrices[i][3][j] * uvOffset.y;
+                    }
+                }
+            }
+        }
+
 #if !OGRE_DOUBLE_PRECISION
-        memcpy( dstPtr, mTextureMatrices, sizeof( mTextureMatrices ) );
+        memcpy( dstPtr, textureMatrices, sizeof( mTextureMatrices ) );
 #else
         float *RESTRICT_ALIAS dstFloat = reinterpret_cast<float * RESTRICT_ALIAS>( dstPtr );
 
         for( size_t i = 0; i < NUM_UNLIT_TEXTURE_TYPES * 4; ++i )
-            *dstFloat++ = (float)mTextureMatrices[0][0][i];
+            *dstFloat++ = (float)textureMatrices[0][0][i];
 #endif
     }
     //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::updatePackedAnimationMatrices()
+    {
+        for( uint8 i = 0; i < NUM_UNLIT_TEXTURE_TYPES; ++i )
+        {
+            const bool isPacked = mTextures[i] && mTextures[i]->getTexturePool() &&
+                                  mTextures[i]->getInternalUvScale() != Vector2::UNIT_SCALE;
+
+            if( isPacked && !mEnabledAnimationMatrices[i] )
+            {
+                setEnableAnimationMatrix( i, true );
+                mPackedAnimationMatrices[i] = true;
+            }
+            else if( !isPacked && mPackedAnimationMatrices[i] )
+            {
+                setEnableAnimationMatrix( i, false );
+            }
+            else if( isPacked )
+            {
+                // The pool may have changed; the UV scale must be reuploaded
+                scheduleConstBufferUpdate();
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsUnlitDatablock::setTexture( uint8 texUnit, const String &name,
                                          const HlmsSamplerblock *refParams )
     {
@@ -289,6 +346,51 @@ namespace Ogre
         setTexture( texUnit, texture, refParams );
     }
     //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::checkAutoPackingSampler( const TextureGpu *texture,
+                                                      const HlmsSamplerblock *samplerblock )
+    {
+        // Packed textures share their slice with the padding around them (and the slice with
+        // other textures' mips), thus only clamping is correct
+        if( texture && samplerblock && texture->allowsAutoPacking() &&
+            ( samplerblock->mU != TAM_CLAMP || samplerblock->mV != TAM_CLAMP ) )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Texture '" + texture->getNameStr() +
+                             "' was created with TextureFlags::AllowAutoPacking and can only be "
+                             "sampled with TAM_CLAMP",
+                         "HlmsUnlitDatablock::checkAutoPackingSampler" );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::setTexture( uint8 texType, TextureGpu *texture,
+                                         const HlmsSamplerblock *refParams, uint16 sliceIdx )
+    {
+        // Without refParams the current samplerblock is kept, or a default (clamping) one is used
+        checkAutoPackingSampler( texture, refParams ? refParams : mSamplerblocks[texType] );
+        HlmsUnlitBaseTextureDatablock::setTexture( texType, texture, refParams, sliceIdx );
+        updatePackedAnimationMatrices();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::_setTexture( uint8 texType, TextureGpu *texture,
+                                          const HlmsSamplerblock *samplerblockPtr, uint16 sliceIdx )
+    {
+        checkAutoPackingSampler( texture, samplerblockPtr );
+        HlmsUnlitBaseTextureDatablock::_setTexture( texType, texture, samplerblockPtr, sliceIdx );
+        updatePackedAnimationMatrices();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::setSamplerblock( uint8 texType, const HlmsSamplerblock &params )
+    {
+        checkAutoPackingSampler( mTextures[texType], &params );
+        HlmsUnlitBaseTextureDatablock::setSamplerblock( texType, params );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::_setSamplerblock( uint8 texType, const HlmsSamplerblock *samplerblockPtr )
+    {
+        checkAutoPackingSampler( mTextures[texType], samplerblockPtr );
+        HlmsUnlitBaseTextureDatablock::_setSamplerblock( texType, samplerblockPtr );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsUnlitDatablock::setUseColour( bool useColour )
     {
         if( mHasColour != useColour )
@@ -370,6 +472,8 @@ namespace Ogre
     {
         assert( textureUnit < NUM_UNLIT_TEXTURE_TYPES );
 
+        mPackedAnimationMatrices[textureUnit] = false;
+
         if( mEnabledAnimationMatrices[textureUnit] != bEnable )
         {
             mEnabledAnimationMatrices[textureUnit] = bEnable;
@@ -437,4 +541,17 @@ namespace Ogre
     }
     //-----------------------------------------------------------------------------------
     TextureGpu *HlmsUnlitDatablock::getEmissiveTexture() const { return getTexture( 0 ); }
+    //-----------------------------------------------------------------------------------
+    void HlmsUnlitDatablock::notifyTextureChanged( TextureGpu *texture,
+                                                   TextureGpuListener::Reason reason, void *extraData )
+    {
+        HlmsUnlitBaseTextureDatablock::notifyTextureChanged( texture, reason, extraData );
+
+        // The TexturePool (and therefore whether it's packed) is known once Resident
+        if( reason == TextureGpuListener::GainedResidency ||
+            reason == TextureGpuListener::LostResidency || reason == TextureGpuListener::Deleted )
+        {
+            updatePackedAnimationMatrices();
+        }
+    }
 }  // namespace Ogre
@@ -40,6 +40,7 @@ namespace Ogre
     class Camera;
     class CompositorShadowNode;
     class CompositorWorkspace;
+    class RenderQueueSnapshot;
     typedef vector<TextureGpu *>::type TextureGpuVec;
 
     /** \addtogroup Core
@@ -77,6 +78,9 @@ namespace Ogre
 
         HlmsManager *mHlmsManager;
 
+        /// Only created when CompositorPassSceneDef::mCacheRenderQueue is set
+        RenderQueueSnapshot *mRenderQueueSnapshot;
+
         void notifyPassSceneAfterShadowMapsListeners();
         void notifyPassSceneAfterFrustumCullingListeners();
 
@@ -107,6 +111,12 @@ namespace Ogre
 
         bool getUpdateShadowNode() const { return mUpdateShadowNode; }
 
+        /** Forces the next execution to perform frustum culling again, when
+            CompositorPassSceneDef::mCacheRenderQueue is set. Does nothing otherwise.
+            See RenderQueueSnapshot for the changes that need it.
+        */
+        void invalidateRenderQueueSnapshot();
+
         void notifyCleared() override;
 
         const CompositorPassSceneDef *getDefinition() const { return mDefinition; }
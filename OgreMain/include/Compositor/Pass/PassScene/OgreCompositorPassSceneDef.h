@@ -146,6 +146,18 @@ namespace Ogre
         /// the most recent frustum culling execution are used.
         bool mReuseCullData;
 
+        /** When true, the sorted contents of the RenderQueue::FAST render queues are stored after
+            rendering and replayed on the following frames (skipping their frustum culling and
+            sorting) as long as the camera and the objects in those render queues don't change.
+            See RenderQueueSnapshot.
+        @remarks
+            Pays off for static cameras looking at static scenes. The cache depends on
+            ObjectMemoryManager::getChangeCounter, thus only objects whose world bounds
+            actually changed invalidate it. SceneManager::setIncrementalTransformUpdates
+            additionally avoids recalculating the bounds of the objects that didn't move.
+        */
+        bool mCacheRenderQueue;
+
         /// Same as CompositorPassDef::mFlushCommandBuffers, but executed after the shadow node
         /// Note you may end up flushing twice if the shadow node also has flushing of its own
         ///
@@ -205,6 +217,7 @@ namespace Ogre
             mLodBias( 1.0f ),
             mInstancedStereo( false ),
             mReuseCullData( false ),
+            mCacheRenderQueue( false ),
             mFlushCommandBuffersAfterShadowNode( false ),
             mUvBakingSet( 0xFF ),
             mBakeLightingOnly( false ),
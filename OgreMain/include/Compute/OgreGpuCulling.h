@@ -0,0 +1,317 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreGpuCulling_H_
+#define _OgreGpuCulling_H_
+
+#include "OgrePrerequisites.h"
+
+#include "CommandBuffer/OgreCbDrawCall.h"
+#include "OgreResourceTransition.h"
+
+#include "ogrestd/vector.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    /**
+    @class GpuCulling
+        Performs frustum and (optionally) Hi-Z occlusion culling on the GPU using a compute job,
+        and writes the results as indexed indirect draw arguments (CbDrawIndexed layout) so they
+        can be consumed by an IndirectBufferPacked without any CPU readback.
+
+        The world Aabbs and the draws stay resident in GPU memory. Each tracked MovableObject
+        owns a slot (stored in the object itself, thus looking it up is free) and the CPU only
+        touches the objects that changed:
+            - SceneManager::updateAllBounds calls updateObject for the tracked objects whose
+              world bounds changed.
+            - MovableObject calls updateObject when its visibility flags change, and
+              untrackObject when it gets destroyed.
+            - Draws whose arguments are the same as in the previous pass aren't uploaded again.
+        Thus the CPU cost of a still scene doesn't depend on how many objects it has.
+
+        The usual way to use it is through RenderQueue::setGpuCulling, which takes care of
+        everything; objects get tracked the first time they're drawn. The manual usage is:
+        @code
+            gpuCulling->gatherObjects( objMemoryManager, 0, 255 );  // Tracks new objects
+            gpuCulling->reserveDraws( maxDraws );
+            gpuCulling->clearDraws();
+            for( each renderable to draw )
+                gpuCulling->addDraw( gpuCulling->trackObject( movableObject ), drawArgs );
+            gpuCulling->upload();
+            gpuCulling->cull( camera, hiZTexture, visibilityMask );
+            // Draw i lives at getIndirectBuffer() offset i * sizeof( CbDrawIndexed )
+        @endcode
+    @remarks
+        The compute job "Compute/Tools/GpuCulling" must be available. It is bundled
+        in Samples/Media/Compute/Tools.
+    @par
+        Culled draws are not removed; their instanceCount is set to 0. Thus draw i always
+        lives at getIndirectBuffer() offset i * sizeof( CbDrawIndexed ).
+    @par
+        Everything but reserveDraws, upload and cull works without a GPU (i.e. VaoManager
+        can be null). cullOnCpu performs the same frustum test the shader does, which is
+        useful for debugging and for validating the bookkeeping.
+    */
+    class _OgreExport GpuCulling : public OgreAllocatedObj
+    {
+    public:
+        /// GPU layout of each object. Matches the ObjectBounds struct in the shaders
+        /// (std430 / StructuredBuffer, 32 bytes per object)
+        struct ObjectBounds
+        {
+            float  center[3];
+            uint32 visibilityFlags;
+            float  halfSize[3];
+            uint32 padding;
+        };
+
+        /// GPU layout of each draw. The shaders see it as 6 consecutive uints
+        struct DrawEntry
+        {
+            CbDrawIndexed drawArgs;
+            /// Slot of the ObjectBounds this draw is culled against
+            uint32 slot;
+        };
+
+        static const uint32 ThreadsPerGroup = 64u;
+        static const uint32 InvalidSlot = 0xFFFFFFFFu;
+
+    protected:
+        struct SlotInfo
+        {
+            MovableObject const *owner;
+            bool                 dirty;
+        };
+
+        /// ObjectMemoryManager::getChangeCounter of each render queue, as last seen by
+        /// gatherObjects
+        struct ChangeCounters
+        {
+            ObjectMemoryManager const *memoryManager;
+            vector<uint32>::type       perRenderQueue;
+        };
+
+        HlmsCompute *mHlmsCompute;
+        VaoManager  *mVaoManager;
+
+        /// CPU mirror of mObjectBoundsBuffer. One per slot
+        vector<ObjectBounds>::type mObjectBounds;
+        vector<SlotInfo>::type     mSlots;
+        vector<uint32>::type       mFreeSlots;
+        size_t                     mNumObjects;
+        /// Slots modified since the last upload()
+        vector<uint32>::type         mDirtySlots;
+        vector<ChangeCounters>::type mChangeCounters;
+
+        /// CPU mirror of mDrawEntriesBuffer. Entries in [mNumDraws; mDraws.size())
+        /// are kept from previous passes, so they can be compared against
+        vector<DrawEntry>::type mDraws;
+        size_t                  mNumDraws;
+        /// Draws that differ from the ones in GPU memory
+        vector<uint32>::type mDirtyDraws;
+        /// Set when the draws buffer was recreated and holds garbage
+        bool mAllDrawsDirty;
+
+        /// Draw args after cullOnCpu
+        vector<CbDrawIndexed>::type mCpuCulledDrawArgs;
+
+        UavBufferPacked      *mObjectBoundsBuffer;
+        UavBufferPacked      *mDrawEntriesBuffer;
+        UavBufferPacked      *mCulledDrawArgsBuffer;
+        IndirectBufferPacked *mIndirectBuffer;
+
+        TextureGpu *mHiZ;
+
+        /// Kept alive because ShaderParams::setManualValueEx doesn't copy the data
+        float mFrustumPlanes[6 * 4];
+
+        ResourceTransitionArray mResourceTransitions;
+
+        void destroyDrawBuffers();
+        void destroyBuffers();
+
+        void markDirty( uint32 slot );
+
+        /// Converts the current bounds and flags of a tracked object into the GPU layout
+        static ObjectBounds packTrackedObject( const MovableObject *movableObject );
+
+        /// Returns the change counters gatherObjects last saw for the given memory manager
+        ChangeCounters &getChangeCounters( const ObjectMemoryManager &memoryManager );
+
+    public:
+        GpuCulling( HlmsCompute *hlmsCompute, VaoManager *vaoManager );
+        ~GpuCulling();
+
+        /// Converts a world Aabb and its flags into the GPU layout
+        static ObjectBounds packObjectBounds( const Aabb &aabb, uint32 visibilityFlags );
+
+        /** Returns true if the object passes the visibility mask and is not fully
+            outside any of the 6 planes. Same logic as the compute shader.
+        @param planes
+            Array of 6 planes, normals pointing inwards (i.e. Frustum::getFrustumPlanes)
+        */
+        static bool isVisible( const ObjectBounds &bounds, const Plane *planes,
+                               uint32 visibilityMask );
+
+        /** Starts tracking the given object, if it isn't already.
+            The object keeps its slot until it gets destroyed or untrackObject is called.
+        @remarks
+            The world bounds of the object must be up to date.
+            Objects tracked by another GpuCulling are moved to this one.
+        @return
+            The slot of the object.
+        */
+        uint32 trackObject( const MovableObject *movableObject );
+
+        /// Stops tracking the given object and releases its slot. Does nothing if not tracked
+        void untrackObject( const MovableObject *movableObject );
+
+        /** Refreshes the bounds and flags of a tracked object from its current ones,
+            queueing them for upload if they changed. Must be called from the main thread.
+        @remarks
+            MovableObject and SceneManager already call this when needed.
+            Does nothing if the object isn't tracked by us.
+        @return
+            True if the bounds or flags changed.
+        */
+        bool updateObject( const MovableObject *movableObject );
+
+        /** Starts tracking the objects added to the given render queue range since the last call.
+        @remarks
+            Render queues whose ObjectMemoryManager::getChangeCounter is the same as in the
+            last call are not walked. Objects that were already tracked are not touched, as
+            updateObject keeps them up to date.
+        @par
+            Invisible objects (i.e. without VisibilityFlags::LAYER_VISIBILITY) and
+            empty slots are not tracked.
+        @param firstRq
+            First render queue to gather, inclusive.
+        @param lastRq
+            Last render queue to gather, exclusive.
+        @return
+            Number of objects that started being tracked.
+        */
+        size_t gatherObjects( ObjectMemoryManager &memoryManager, size_t firstRq, size_t lastRq );
+
+        /// Returns the slot of the given object, or InvalidSlot if it isn't tracked by us
+        uint32 getSlot( const MovableObject *movableObject ) const;
+
+        /// Number of tracked objects
+        size_t getNumObjects() const { return mNumObjects; }
+        /// Number of slots, including the ones that are free
+        size_t getNumSlots() const { return mSlots.size(); }
+        /// Number of slots to be uploaded by the next upload()
+        size_t getNumDirtySlots() const { return mDirtySlots.size(); }
+
+        const MovableObject *getObject( uint32 slot ) const { return mSlots[slot].owner; }
+
+        const ObjectBounds &getObjectBounds( uint32 slot ) const { return mObjectBounds[slot]; }
+
+        /** Ensures the draw buffers can hold maxDraws draws, so that getIndirectBuffer()
+            stays the same until the next call. Requires a VaoManager.
+        */
+        void reserveDraws( size_t maxDraws );
+
+        /** Removes all draws. Must be called before adding the draws of each pass.
+            Their contents are kept so that addDraw only uploads the ones that changed.
+        */
+        void clearDraws() { mNumDraws = 0u; }
+
+        /** Adds a draw to be culled against the object in the given slot.
+        @return
+            Index of the draw in the indirect buffer.
+        */
+        uint32 addDraw( uint32 slot, const CbDrawIndexed &drawArgs );
+
+        size_t getNumDraws() const { return mNumDraws; }
+        /// Number of draws to be uploaded by the next upload()
+        size_t getNumDirtyDraws() const { return mAllDrawsDirty ? mNumDraws : mDirtyDraws.size(); }
+
+        const DrawEntry &getDraw( size_t idx ) const { return mDraws[idx]; }
+
+        /** Uploads the dirty object bounds and draws to the GPU.
+            (Re)creates the bounds buffer if it's too small, in which case all bounds are
+            uploaded.
+        */
+        void upload();
+
+        /// Optional Hi-Z texture used by the RenderQueue integration. See cull
+        void        setHiZTexture( TextureGpu *hiZ ) { mHiZ = hiZ; }
+        TextureGpu *getHiZTexture() const { return mHiZ; }
+
+        /** Dispatches the culling compute job. Afterwards getIndirectBuffer() contains
+            the draw args, with instanceCount = 0 for the culled draws.
+        @param camera
+            Camera to cull against.
+        @param hiZ
+            Optional. Depth pyramid where each texel of each mip contains the farthest depth
+            of its footprint (i.e. max depth, or min depth if reverse depth is used).
+            Depth must be in range [0; 1]. When null, only frustum culling is performed.
+        @param visibilityMask
+            Objects whose visibility flags don't pass this mask are culled.
+            Only the user bits of the flags are kept, plus VisibilityFlags::LAYER_VISIBILITY
+            which is set for every tracked object. Thus passing LAYER_VISIBILITY only
+            performs the frustum (and Hi-Z) test.
+        */
+        void cull( const Camera *camera, TextureGpu *hiZ, uint32 visibilityMask );
+
+        /** CPU reference path. Performs frustum culling and writes the results into
+            an array retrievable via getCpuCulledDrawArgs. Doesn't need upload().
+        @return
+            Number of visible draws.
+        */
+        size_t cullOnCpu( const Camera *camera, uint32 visibilityMask );
+
+        /// Same as cullOnCpu, but against the given planes
+        size_t cullOnCpu( const Plane *planes, uint32 visibilityMask );
+
+        const vector<CbDrawIndexed>::type &getCpuCulledDrawArgs() const
+        {
+            return mCpuCulledDrawArgs;
+        }
+
+        /// Valid after reserveDraws(). One CbDrawIndexed per draw.
+        IndirectBufferPacked *getIndirectBuffer() const { return mIndirectBuffer; }
+        UavBufferPacked      *getObjectBoundsBuffer() const { return mObjectBoundsBuffer; }
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -313,6 +313,7 @@ namespace Ogre
             WorldMat,
             InheritOrientation,
             InheritScale,
+            DirtyFlags,
             NumMemoryTypes
         };
 
@@ -386,6 +387,7 @@ namespace Ogre
             VisibilityFlags,
             QueryFlags,
             LightMask,
+            BoundsDirty,
             NumMemoryTypes
         };
 
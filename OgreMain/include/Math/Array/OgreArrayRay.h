@@ -51,6 +51,21 @@ namespace Ogre
         ArrayMaskR intersects( const ArrayAabb &aabb ) const
         {
             ArrayVector3 invDir = Mathlib::SetAll( 1.0f ) / mDirection;
+            ArrayReal    distance;
+            return intersects( aabb, invDir, distance );
+        }
+
+        /** Same as intersects( const ArrayAabb & ), but takes the precalculated inverse of
+            mDirection (useful when testing the same rays against many Aabbs).
+        @param invDir
+            1.0 / mDirection
+        @param outDistance [out]
+            Distance along the ray to the entry point. 0 if the origin is inside the Aabb.
+            Only meaningful for the lanes where the returned mask is set.
+        */
+        ArrayMaskR intersects( const ArrayAabb &aabb, const ArrayVector3 &invDir,
+                               ArrayReal &outDistance ) const
+        {
             ArrayVector3 intersectAtMinPlane = ( aabb.getMinimum() - mOrigin ) * invDir;
             ArrayVector3 intersectAtMaxPlane = ( aabb.getMaximum() - mOrigin ) * invDir;
 
@@ -59,27 +74,37 @@ namespace Ogre
             ArrayVector3 maxIntersect = intersectAtMinPlane;
             maxIntersect.makeCeil( intersectAtMaxPlane );
 
-            ArrayReal tmin, tmax;
-            tmin = minIntersect.mChunkBase[0];
-            tmax = maxIntersect.mChunkBase[0];
+            for( size_t i = 0; i < 3u; ++i )
+            {
+                // When the ray is parallel to a slab and its origin lies on one of the slab's
+                // planes (e.g. flat Aabbs), we get 0 * inf = NaN. The ray touches the slab, so that
+                // slab must not restrict it. The min/max above don't propagate NaNs consistently
+                // across platforms, so test for them explicitly (NaN <= NaN is false).
+                const ArrayMaskR minPlaneIsNumber = Mathlib::CompareLessEqual(
+                    intersectAtMinPlane.mChunkBase[i], intersectAtMinPlane.mChunkBase[i] );
+                const ArrayMaskR maxPlaneIsNumber = Mathlib::CompareLessEqual(
+                    intersectAtMaxPlane.mChunkBase[i], intersectAtMaxPlane.mChunkBase[i] );
 
-#if OGRE_CPU == OGRE_CPU_ARM && OGRE_USE_SIMD == 1
-            // ARM's NEON behaves the way we want, by propagating NaNs. No need to do anything weird
-            tmin = Mathlib::Max( Mathlib::Max( minIntersect.mChunkBase[0], minIntersect.mChunkBase[1] ),
-                                 minIntersect.mChunkBase[2] );
-            tmax = Mathlib::Min( Mathlib::Min( maxIntersect.mChunkBase[0], maxIntersect.mChunkBase[1] ),
-                                 maxIntersect.mChunkBase[2] );
-#else
-            // We need to do weird min/max so that NaNs get propagated
-            //(happens if mOrigin is in the AABB's border)
-            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[1], tmax ) );
-            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[1], tmin ) );
+                minIntersect.mChunkBase[i] = Mathlib::CmovRobust(
+                    minIntersect.mChunkBase[i], Mathlib::MAX_NEG, minPlaneIsNumber );
+                minIntersect.mChunkBase[i] = Mathlib::CmovRobust(
+                    minIntersect.mChunkBase[i], Mathlib::MAX_NEG, maxPlaneIsNumber );
+                maxIntersect.mChunkBase[i] = Mathlib::CmovRobust(
+                    maxIntersect.mChunkBase[i], Mathlib::MAX_POS, minPlaneIsNumber );
+                maxIntersect.mChunkBase[i] = Mathlib::CmovRobust(
+                    maxIntersect.mChunkBase[i], Mathlib::MAX_POS, maxPlaneIsNumber );
+            }
 
-            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[2], tmax ) );
-            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[2], tmin ) );
-#endif
-            // tmax >= max( tmin, 0 )
-            return Mathlib::CompareGreaterEqual( tmax, Mathlib::Max( tmin, ARRAY_REAL_ZERO ) );
+            const ArrayReal tmin = Mathlib::Max(
+                Mathlib::Max( minIntersect.mChunkBase[0], minIntersect.mChunkBase[1] ),
+                minIntersect.mChunkBase[2] );
+            const ArrayReal tmax = Mathlib::Min(
+                Mathlib::Min( maxIntersect.mChunkBase[0], maxIntersect.mChunkBase[1] ),
+                maxIntersect.mChunkBase[2] );
+
+            outDistance = Mathlib::Max( tmin, ARRAY_REAL_ZERO );
+            // tmax >= max( tmin, 0 ). Inclusive, so that flat Aabbs and grazing hits count
+            return Mathlib::CompareGreaterEqual( tmax, outDistance );
         }
     };
 }  // namespace Ogre
@@ -100,6 +100,16 @@ namespace Ogre
         */
         uint32 *RESTRICT_ALIAS mLightMask;
 
+        /** Ours is mBoundsDirty[mIndex]. When true, mWorldAabb & mWorldRadius must be
+            recalculated even if our parent node didn't move (e.g. mLocalAabb changed,
+            or we were attached to a different node).
+        @remarks
+            Only used when SceneManager::setIncrementalTransformUpdates is enabled.
+            Code that writes to mLocalAabb or mLocalRadius directly must set it.
+            Must be the last member; see ObjectDataArrayMemoryManager::getFirstNode
+        */
+        bool *RESTRICT_ALIAS mBoundsDirty;
+
         ObjectData() :
             mIndex( 0 ),
             mParents( 0 ),
@@ -109,7 +119,8 @@ namespace Ogre
             mDistanceToCamera( 0 ),
             mVisibilityFlags( 0 ),
             mQueryFlags( 0 ),
-            mLightMask( 0 )
+            mLightMask( 0 ),
+            mBoundsDirty( 0 )
         {
             mUpperDistance[0] = 0;
             mUpperDistance[1] = 0;
@@ -136,6 +147,7 @@ namespace Ogre
             mVisibilityFlags[mIndex] = inCopy.mVisibilityFlags[inCopy.mIndex];
             mQueryFlags[mIndex] = inCopy.mQueryFlags[inCopy.mIndex];
             mLightMask[mIndex] = inCopy.mLightMask[inCopy.mIndex];
+            mBoundsDirty[mIndex] = true;
         }
 
         /** Advances all pointers to the next pack, i.e. if we're processing 4
@@ -155,6 +167,7 @@ namespace Ogre
             mVisibilityFlags += ARRAY_PACKED_REALS;
             mQueryFlags += ARRAY_PACKED_REALS;
             mLightMask += ARRAY_PACKED_REALS;
+            mBoundsDirty += ARRAY_PACKED_REALS;
         }
 
         void advancePack( size_t numAdvance )
@@ -171,6 +184,7 @@ namespace Ogre
             mVisibilityFlags += ARRAY_PACKED_REALS * numAdvance;
             mQueryFlags += ARRAY_PACKED_REALS * numAdvance;
             mLightMask += ARRAY_PACKED_REALS * numAdvance;
+            mBoundsDirty += ARRAY_PACKED_REALS * numAdvance;
         }
 
         /** Advances all pointers needed by MovableObject::updateAllBounds to the next pack,
@@ -186,6 +200,7 @@ namespace Ogre
             ++mWorldAabb;
             mLocalRadius += ARRAY_PACKED_REALS;
             mWorldRadius += ARRAY_PACKED_REALS;
+            mBoundsDirty += ARRAY_PACKED_REALS;
         }
 
         /** Advances all pointers needed by MovableObject::cullFrustum to the next pack,
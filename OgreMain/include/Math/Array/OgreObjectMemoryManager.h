@@ -62,6 +62,9 @@ namespace Ogre
         /// Tracks total number of objects in all render queues.
         size_t mTotalObjects;
 
+        /// One per render queue. See getChangeCounter
+        vector<uint32>::type mChangeCounters;
+
         /// Dummy node where to point ObjectData::mParents[i] when they're unused slots.
         SceneNode  *mDummyNode;
         Transform   mDummyTransformPtrs;
@@ -182,6 +185,30 @@ namespace Ogre
         */
         size_t getFirstObjectData( ObjectData &outObjectData, size_t renderQueue );
 
+        /** Returns a counter that is incremented every time something that affects the culling
+            results of the given render queue may have changed: objects were created, destroyed,
+            moved to/from that render queue, their world bounds changed or their
+            visibility changed.
+            Bounds recalculated to the same values (e.g. every frame, when
+            SceneManager::setIncrementalTransformUpdates is disabled) don't count.
+        @remarks
+            Used to tell whether cached culling results are still valid (see
+            CompositorPassSceneDef::mCacheRenderQueue). Only compare it for equality.
+        @param renderQueue
+            Render queue ID. May be out of bounds, in which case 0 is returned.
+        */
+        uint32 getChangeCounter( size_t renderQueue ) const
+        {
+            return renderQueue < mChangeCounters.size() ? mChangeCounters[renderQueue] : 0u;
+        }
+
+        /// Increments getChangeCounter. Must be called from the main thread.
+        void _notifyObjectsChanged( size_t renderQueue )
+        {
+            if( renderQueue < mChangeCounters.size() )
+                ++mChangeCounters[renderQueue];
+        }
+
         // Derived from ArrayMemoryManager::RebaseListener
         void buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                             ArrayMemoryManager::PtrdiffVec &outDiffsList ) override;
@@ -33,6 +33,19 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    namespace TransformDirtyFlags
+    {
+        enum TransformDirtyFlags
+        {
+            /// Position, orientation, scale, inheritance or parent changed since the last
+            /// time the derived transform was calculated by SceneManager::updateAllTransforms
+            LocalDirty = 1u << 0u,
+            /// The derived transform was recalculated in the last updateAllTransforms.
+            /// Children and attached objects must be updated as well
+            DerivedChanged = 1u << 1u
+        };
+    }
+
     /** Represents the transform of a single object, arranged in SoA (Structure of Arrays) */
     struct Transform
     {
@@ -74,6 +87,9 @@ namespace Ogre
         /// Ours is mInheritScale[mIndex]
         bool *RESTRICT_ALIAS mInheritScale;
 
+        /// Bitmask of TransformDirtyFlags. Ours is mDirtyFlags[mIndex]
+        uint8 *RESTRICT_ALIAS mDirtyFlags;
+
         Transform() :
             mIndex( 0 ),
             mParents( 0 ),
@@ -86,7 +102,8 @@ namespace Ogre
             mDerivedScale( 0 ),
             mDerivedTransform( 0 ),
             mInheritOrientation( 0 ),
-            mInheritScale( 0 )
+            mInheritScale( 0 ),
+            mDirtyFlags( 0 )
         {
         }
 
@@ -138,6 +155,9 @@ namespace Ogre
 
             mInheritOrientation[mIndex] = inCopy.mInheritOrientation[inCopy.mIndex];
             mInheritScale[mIndex] = inCopy.mInheritScale[inCopy.mIndex];
+
+            // The slot changed, it may now be in a block that is otherwise clean
+            mDirtyFlags[mIndex] = TransformDirtyFlags::LocalDirty;
         }
 
         /** Rebases all the pointers from our SoA structs so that they point to a new location
@@ -174,6 +194,8 @@ namespace Ogre
                 newBasePtrs[NodeArrayMemoryManager::InheritOrientation] + diff );
             mInheritScale =
                 reinterpret_cast<bool *>( newBasePtrs[NodeArrayMemoryManager::InheritScale] + diff );
+            mDirtyFlags =
+                reinterpret_cast<uint8 *>( newBasePtrs[NodeArrayMemoryManager::DirtyFlags] + diff );
         }
 
         /** Advances all pointers to the next pack, i.e. if we're processing 4 elements at a time, move
@@ -192,6 +214,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS;
             mInheritOrientation += ARRAY_PACKED_REALS;
             mInheritScale += ARRAY_PACKED_REALS;
+            mDirtyFlags += ARRAY_PACKED_REALS;
         }
 
         void advancePack( size_t numAdvance )
@@ -207,6 +230,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS * numAdvance;
             mInheritOrientation += ARRAY_PACKED_REALS * numAdvance;
             mInheritScale += ARRAY_PACKED_REALS * numAdvance;
+            mDirtyFlags += ARRAY_PACKED_REALS * numAdvance;
         }
     };
 }  // namespace Ogre
@@ -0,0 +1,107 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreBCnEncoder_H_
+#define _OgreBCnEncoder_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    struct TextureBox;
+
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Image
+     *  @{
+     */
+
+    /** CPU encoder for the BC1, BC3, BC4, BC5 & BC7 block compressed formats.
+    @remarks
+        Meant for compressing textures at load time (see TextureFilter::CompressBCn), thus it
+        favours speed over quality: colour endpoints come from the principal axis of each block,
+        refined once with a least squares fit. BC7 only uses mode 6 (single subset, RGBA
+        endpoints with 4-bit indices), which handles colour and alpha together well.
+    @par
+        All functions are reentrant and can be called from multiple threads concurrently.
+    */
+    class _OgreExport BCnEncoder
+    {
+    public:
+        /// Encodes 16 RGBA8 pixels (row major) into an 8-byte BC1 block. Alpha is ignored.
+        static void encodeBlockBC1( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock );
+        /// Encodes 16 RGBA8 pixels (row major) into a 16-byte BC3 block.
+        static void encodeBlockBC3( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock );
+        /** Encodes 16 unsigned 8-bit values into an 8-byte BC4_UNORM block.
+        @param values
+            Pointer to the first value.
+        @param stride
+            Distance in bytes between consecutive values, so that a channel of RGBA8 pixels can
+            be encoded directly.
+        */
+        static void encodeBlockBC4( const uint8 *RESTRICT_ALIAS values, size_t stride,
+                                    uint8 *RESTRICT_ALIAS outBlock );
+        /// Same as encodeBlockBC4, for BC4_SNORM. A value of -128 is treated as -127.
+        static void encodeBlockBC4Snorm( const int8 *RESTRICT_ALIAS values, size_t stride,
+                                         uint8 *RESTRICT_ALIAS outBlock );
+        /// Encodes 16 RGBA8 pixels (row major) into a 16-byte BC7 block.
+        static void encodeBlockBC7( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock );
+
+        /** Returns true if compress() can encode srcFormat into dstFormat.
+            Supported pairs (sRGB variants included) are:
+                RGBA8_UNORM -> BC1_UNORM, BC3_UNORM, BC7_UNORM
+                R8_UNORM    -> BC4_UNORM
+                R8_SNORM    -> BC4_SNORM
+                RG8_UNORM   -> BC5_UNORM
+                RG8_SNORM   -> BC5_SNORM
+        */
+        static bool isSupported( PixelFormatGpu srcFormat, PixelFormatGpu dstFormat );
+
+        /** Compresses a whole uncompressed box (all slices) into dstBox.
+            Partial blocks at the borders (i.e. mips smaller than 4x4) replicate the last
+            row / column.
+        @param srcBox
+            Uncompressed source. Must be of srcFormat.
+        @param dstBox
+            Destination with the same resolution as srcBox. Must be of dstFormat.
+        */
+        static void compress( const TextureBox &srcBox, PixelFormatGpu srcFormat,
+                              const TextureBox &dstBox, PixelFormatGpu dstFormat );
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -0,0 +1,132 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreBatchRaySceneQuery_H_
+#define _OgreBatchRaySceneQuery_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Array/OgreArrayRay.h"
+#include "OgreRawPtr.h"
+#include "OgreSceneQuery.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    struct BatchRayHit
+    {
+        MovableObject *movable;
+        /// Distance along the ray. 0 if the ray's origin is inside the object's Aabb
+        Real distance;
+    };
+
+    /**
+    @class BatchRaySceneQuery
+        Casts many rays at once against the world Aabbs of all entities, spreading the rays
+        across the SceneManager worker threads (see SceneManager::executeUserScalableTask).
+
+        Rays are packed in groups of ARRAY_PACKED_REALS (ArrayRay) and each entity passing
+        the query mask is tested against all the packets at once.
+
+        Results are written into buffers provided by the caller, thus executing the
+        query does not allocate memory (except the first time, or when the number of rays grows).
+    @remarks
+        Like RaySceneQuery, results are based on world Aabbs, not on the actual geometry.
+    @par
+        Must be executed from the main thread, after SceneManager::updateSceneGraph.
+        Create it with SceneManager::createBatchRayQuery and destroy it with
+        SceneManager::destroyQuery.
+    */
+    class _OgreExport BatchRaySceneQuery : public SceneQuery, public UniformScalableTask
+    {
+    protected:
+        uint32 mMaxHitsPerRay;
+
+        RawSimdUniquePtr<ArrayRay, MEMCATEGORY_SCENE_CONTROL>     mRayPackets;
+        RawSimdUniquePtr<ArrayVector3, MEMCATEGORY_SCENE_CONTROL> mInvDirPackets;
+
+        /// Only valid during execute()
+        Ray const   *mRays;
+        size_t       mNumRays;
+        BatchRayHit *mOutHits;
+        uint32      *mOutNumHits;
+
+        /// Inserts the hit keeping the ray's hits sorted by distance,
+        /// discarding the furthest one if there's no more room
+        inline void addHit( size_t rayIdx, MovableObject *movable, Real distance );
+
+        /// Executes the query for the rays packets in range [firstPacket; lastPacket)
+        void executeRange( size_t firstPacket, size_t lastPacket );
+
+    public:
+        BatchRaySceneQuery( SceneManager *creator );
+        ~BatchRaySceneQuery() override;
+
+        /** Sets the maximum number of hits recorded per ray.
+        @remarks
+            When a ray hits more objects, the closest ones are kept.
+            Default is 1 (i.e. only the closest hit).
+        @param maxHitsPerRay
+            Must be > 0
+        */
+        void   setMaxHitsPerRay( uint32 maxHitsPerRay );
+        uint32 getMaxHitsPerRay() const { return mMaxHitsPerRay; }
+
+        /** Casts all the rays. Blocks until all worker threads are done.
+        @param rays
+            Array of rays to cast.
+        @param numRays
+            Number of rays in the array.
+        @param outHits [out]
+            Array with at least numRays * getMaxHitsPerRay() elements.
+            The hits of ray i are stored starting at outHits[i * getMaxHitsPerRay()],
+            sorted by distance (closest first).
+        @param outNumHits [out]
+            Array with at least numRays elements. Number of hits of each ray.
+        */
+        void execute( const Ray *rays, size_t numRays, BatchRayHit *outHits, uint32 *outNumHits );
+
+        /// UniformScalableTask overload. Don't call directly.
+        void execute( size_t threadId, size_t numThreads ) override;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -481,6 +481,69 @@ namespace Ogre
         void setFreeOnClose( bool free ) { mFreeOnClose = free; }
     };
 
+    /** Read-only stream over a file mapped into the address space (mmap / MapViewOfFile).
+    @remarks
+        Unlike a MemoryDataStream pre-buffering a FileStreamDataStream, no heap copy of the
+        file is made; pages are faulted in by the OS on first access and can be evicted
+        under memory pressure. getCurrentPtr() allows consumers (e.g. the Mesh2 serializer)
+        to read data in place instead of copying it out.
+    @par
+        If the file could not be mapped, isMapped() returns false and the stream is empty.
+    */
+    class _OgreExport MemoryMappedDataStream final : public DataStream
+    {
+    protected:
+        /// Pointer to the start of the mapped view
+        uchar *mData;
+        /// Pointer to the current position in the mapped view
+        uchar *mPos;
+        /// Pointer to the end of the mapped view
+        uchar *mEnd;
+        /// File mapping object (Windows only)
+        void *mMappingHandle;
+
+    public:
+        /** Maps the given file.
+        @param name The name to give the stream
+        @param fullPath Path to the file in the filesystem
+        */
+        MemoryMappedDataStream( const String &name, const String &fullPath );
+        ~MemoryMappedDataStream() override;
+
+        /// Returns true if the file was successfully mapped
+        bool isMapped() const { return mData != 0; }
+
+        /** Get a pointer to the start of the mapped view. */
+        const uchar *getPtr() const { return mData; }
+
+        /** Get a pointer to the current position in the mapped view. */
+        const uchar *getCurrentPtr() const { return mPos; }
+
+        /** @copydoc DataStream::read
+         */
+        size_t read( void *buf, size_t count ) override;
+
+        /** @copydoc DataStream::skip
+         */
+        void skip( long count ) override;
+
+        /** @copydoc DataStream::seek
+         */
+        void seek( size_t pos ) override;
+
+        /** @copydoc DataStream::tell
+         */
+        size_t tell() const override;
+
+        /** @copydoc DataStream::eof
+         */
+        bool eof() const override;
+
+        /** @copydoc DataStream::close
+         */
+        void close() override;
+    };
+
     /** Common subclass of DataStream for handling data from
         std::basic_istream.
     */
@@ -100,6 +100,13 @@ namespace Ogre
         /// @copydoc Archive::open
         DataStreamPtr open( const String &filename, bool readOnly = true ) override;
 
+        /** Opens the file as a read-only MemoryMappedDataStream instead of a FileStreamDataStream.
+        @return
+            Null if the file could not be mapped (or the platform lacks support);
+            callers should fall back to open().
+        */
+        DataStreamPtr openMemoryMapped( const String &filename );
+
         /// @copydoc Archive::create
         DataStreamPtr create( const String &filename ) override;
 
@@ -70,6 +70,11 @@ namespace Ogre
                            CodecDataPtr &pData ) const override;
         /// @copydoc Codec::decode
         DecodeResult decode( DataStreamPtr &input ) const override;
+        /// @copydoc ImageCodec2::decodeStreaming
+        /// FreeImage still decodes the whole bitmap, but rows are converted to the
+        /// supported format in small batches instead of into a full size copy.
+        bool decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                              uint32 maxRowsPerBatch = 64u ) const override;
 
         virtual String getType() const override;
 
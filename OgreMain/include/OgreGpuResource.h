@@ -195,6 +195,22 @@ namespace Ogre
         */
         uint32 getPendingResidencyChanges() const;
 
+        /** Marks the resource as used ("touched") in the current frame, at the given distance
+            from the camera. When touched more than once in the same frame, the lowest
+            distance is kept.
+        @remarks
+            TextureGpuManager uses this to decide what to stream first and what to page out,
+            see TextureGpuManager::setPriorityStreaming.
+            To account for the size on screen, pass the distance divided by the radius of the
+            object using this resource.
+        */
+        void notifyUsed( float distanceToCamera );
+
+        /// See notifyUsed
+        uint32 getLastFrameUsed() const { return mLastFrameUsed; }
+        /// Lowest distance passed to notifyUsed during getLastFrameUsed()
+        float getLowestDistanceToCamera() const { return mLowestDistanceToCamera; }
+
         IdString getName() const;
         /// Retrieves a user-friendly name. May involve a look up.
         /// NOT THREAD SAFE. ONLY CALL FROM MAIN THREAD.
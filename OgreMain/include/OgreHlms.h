@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "OgreHlmsPso.h"
 #include "OgreStringVector.h"
 #include "Threading/OgreLightweightMutex.h"
+#include "ogrestd/unordered_map.h"
 #if !OGRE_NO_JSON
 #    include "OgreHlmsJson.h"
 #endif
@@ -87,6 +88,7 @@ namespace Ogre
     {
     public:
         friend class HlmsDiskCache;
+        friend class HlmsCompiledTemplate;
 
         enum PrecisionMode
         {
@@ -178,12 +180,34 @@ namespace Ogre
 
                 return setProperties == _r.setProperties && piecesEqual;
             }
+
+            /// Same as operator== against RenderableCache( properties, _pieces )
+            /// without having to construct it.
+            bool equals( const HlmsPropertyVec &properties, const PiecesMap *_pieces ) const
+            {
+                if( setProperties != properties )
+                    return false;
+
+                for( size_t i = 0; i < NumShaderTypes; ++i )
+                {
+                    if( _pieces ? pieces[i] != _pieces[i] : !pieces[i].empty() )
+                        return false;
+                }
+
+                return true;
+            }
+
+            static uint64 calculateHash( const HlmsPropertyVec &properties, const PiecesMap *_pieces );
         };
 
         struct PassCache
         {
             HlmsPropertyVec properties;
             HlmsPassPso     passPso;
+            /// HlmsCache::setProperties returned by preparePassHash, which may have more properties
+            /// than 'properties' (implementations can set more after preparePassHashBase).
+            /// Empty until a PSO gets created with this pass. Not part of the comparison.
+            HlmsPropertyVec passCacheProperties;
 
             bool operator==( const PassCache &_r ) const
             {
@@ -220,15 +244,38 @@ namespace Ogre
         typedef vector<char>::type        TextureNameStrings;
         typedef vector<TextureRegs>::type TextureRegsVec;
 
+        /// Shader code loaded from HlmsDiskCache that hasn't been compiled yet.
+        /// It gets compiled the first time a Renderable needs it.
+        struct PreprocessedShaderCode
+        {
+            RenderableCache mergedCache;
+            String          source[NumShaderTypes];
+
+            PreprocessedShaderCode( const RenderableCache &_mergedCache,
+                                    const String _source[NumShaderTypes] );
+        };
+
         typedef vector<PassCache>::type       PassCacheVec;
         typedef vector<RenderableCache>::type RenderableCacheVec;
         typedef vector<ShaderCodeCache>::type ShaderCodeCacheVec;
 
-        PassCacheVec       mPassCache;
-        RenderableCacheVec mRenderableCache;
+        /// Maps RenderableCache::calculateHash to indices in mRenderableCache, so
+        /// addRenderableCache doesn't have to compare against every entry.
+        typedef unordered_multimap<uint64, uint32>::type RenderableCacheIndex;
+
+        PassCacheVec         mPassCache;
+        RenderableCacheVec   mRenderableCache;
+        RenderableCacheIndex mRenderableCacheIndex;
         ShaderCodeCacheVec mShaderCodeCache;  // GUARDED_BY( mMutex )
         HlmsCacheVec       mShaderCache;      // GUARDED_BY( mMutex )
 
+        /// Keyed by RenderableCache::calculateHash of PreprocessedShaderCode::mergedCache
+        typedef unordered_multimap<uint64, PreprocessedShaderCode>::type PreprocessedShaderCodeMap;
+        PreprocessedShaderCodeMap mPreprocessedShaderCode;  // GUARDED_BY( mMutex )
+
+        /// See HlmsDiskCache::startBackgroundSave. May be null.
+        HlmsDiskCache *mBackgroundDiskCache;
+
         typedef std::vector<HlmsPropertyVec> HlmsPropertyVecVec;
         typedef std::vector<PiecesMap>       PiecesMapVec;
 
@@ -240,8 +287,13 @@ namespace Ogre
             HlmsPropertyVec setProperties;
             PiecesMap       pieces;
 
+            /// See _compileRecordedPso. Used instead of the Renderable when it's null.
+            HlmsPso const *recordedPso;
+
             // Prevent false cache sharing
             uint8_t padding[64];
+
+            ThreadData() : recordedPso( 0 ) {}
         };
 
         typedef std::vector<ThreadData> ThreadDataVec;
@@ -315,6 +367,14 @@ namespace Ogre
         bool   mDebugOutputProperties;
         uint8  mPrecisionMode;  ///< See PrecisionMode
         bool   mFastShaderBuildHack;
+        bool   mPrecompiledTemplates;
+
+        typedef std::pair<Archive *, String>                            CompiledTemplateKey;
+        typedef map<CompiledTemplateKey, HlmsCompiledTemplate *>::type CompiledTemplateMap;
+
+        /// Template files parsed once by getCompiledTemplate, see setPrecompiledTemplates
+        CompiledTemplateMap mCompiledTemplates;  // GUARDED_BY( mCompiledTemplatesMutex )
+        LightweightMutex    mCompiledTemplatesMutex;
 
     public:
         struct DatablockCustomPieceFile
@@ -388,12 +448,26 @@ namespace Ogre
 
         typedef std::vector<Expression> ExpressionVec;
 
+        struct MathOp
+        {
+            size_t       opIdx;  ///< Which of @pset, @padd, @psub, etc.
+            StringVector args;
+        };
+
+        typedef vector<MathOp>::type MathOpVec;
+
         inline int interpretAsNumberThenAsProperty( const String &argValue, size_t tid ) const;
 
         static void copy( String &outBuffer, const SubStringRef &inSubString, size_t length );
         static void repeat( String &outBuffer, const SubStringRef &inSubString, size_t length,
                             size_t passNum, const String &counterVar );
 
+        /// Copies inBuffer into outBuffer without the @pset, @padd, etc. which are returned
+        /// in outMathOps in order of appearance instead of being executed. See parseMath.
+        /// Returns true on syntax error.
+        static bool  stripMathOps( const String &inBuffer, String &outBuffer, MathOpVec &outMathOps );
+        static int32 executeMathOp( size_t opIdx, int32 op1, int32 op2 );
+
         bool parseMath( const String &inBuffer, String &outBuffer, size_t tid );
         bool parseForEach( const String &inBuffer, String &outBuffer, size_t tid ) const;
         bool parseProperties( String &inBuffer, String &outBuffer, size_t tid ) const;
@@ -426,6 +500,13 @@ namespace Ogre
                                            size_t tid ) const;
         static size_t evaluateExpressionEnd( const SubStringRef &outSubString );
 
+        /// Splits the expression (i.e. the contents of "@property( ... )") into a tree
+        /// of tokens. Returns true on syntax error.
+        static bool tokenizeExpression( const SubStringRef &subString, ExpressionVec &outExpressions );
+        /// Assigns their ExpressionType to the tokens and groups comparisons so that they
+        /// take precedence over && and ||. Does not recurse into children.
+        static void classifyExpression( ExpressionVec &expression, bool &outSyntaxError );
+
         static void evaluateParamArgs( SubStringRef &outSubString, StringVector &outArgs,
                                        bool &outSyntaxError );
 
@@ -449,11 +530,25 @@ namespace Ogre
         /// Retrieves a cache entry using the returned value from @addRenderableCache
         const RenderableCache &getRenderableCache( uint32 hash ) const;
 
+        /// Stores passCache.setProperties in mPassCache so HlmsDiskCache can record them.
+        void recordPassCacheProperties( const HlmsCache &passCache );
+
         HlmsCache       *addStubShaderCache( uint32 hash );
         const HlmsCache *addShaderCache( uint32 hash, const HlmsPso &pso );
         const HlmsCache *getShaderCache( uint32 hash ) const;
         virtual void     clearShaderCache();
 
+        /// Returns the template file parsed into an HlmsCompiledTemplate, parsing it the
+        /// first time it is requested. The returned pointer is owned by Hlms.
+        const HlmsCompiledTemplate *getCompiledTemplate( Archive *archive, const String &filename );
+        void                        clearCompiledTemplates();
+
+        /// Runs parseMath, parseForEach & parseProperties on the given template file.
+        /// The result is left in inOutString, outString is used as scratch.
+        /// Returns true on syntax error.
+        bool parseTemplateFile( Archive *archive, const String &filename, String &inOutString,
+                                String &outString, size_t tid );
+
         void processPieces( Archive *archive, const StringVector &pieceFiles, size_t tid );
         void hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
                              FastArray<uint8> &fileContents ) const;
@@ -473,11 +568,25 @@ namespace Ogre
                                                   const String &debugFilenameOutput, uint32 finalHash,
                                                   ShaderType shaderType, size_t tid );
 
+        /// Compiles already preprocessed shader code into codeCache.shaders.
+        /// Unlike the other overload, it doesn't add it to the shader code cache.
+        void compileShaderCode( ShaderCodeCache &codeCache, const String source[NumShaderTypes],
+                                uint32 shaderCounter, size_t tid );
+
     public:
         void _compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
                                                    const String           source[NumShaderTypes],
                                                    const uint32 shaderCounter, size_t tid );
 
+        /** Stores preprocessed shader code without compiling it. It gets compiled
+            the first time createShaderCacheEntry needs a shader with the same properties
+            and pieces, skipping the template parsing.
+        @remarks
+            Used by HlmsDiskCache::applyTo when lazy compilation is requested.
+        */
+        void _addPreprocessedShaderCode( const RenderableCache &mergedCache,
+                                         const String           source[NumShaderTypes] );
+
         /** Compiles input properties and adds it to the shader code cache
         @param codeCache [in/out]
             All variables must be filled except for ShaderCodeCache::shaders which is the output
@@ -501,6 +610,8 @@ namespace Ogre
             The renderable who owns the renderableHash. Not used by the base class, but
             derived implementations may overload this function and take advantage of
             some of the direct access it provides.
+            queuedRenderable.renderable is null when creating a PSO recorded by HlmsDiskCache
+            in a previous session (see _compileRecordedPso).
         @param reservedStubEntry
             If nullptr, then we create a new ptr in addShaderCache()
             If non null, then reservedStubEntry IS the entry returned from a previously called
@@ -608,6 +719,22 @@ namespace Ogre
         /// Returns true if shaders are being compiled with Fast Shader Build Hack (D3D11 only)
         bool getFastShaderBuildHack() const;
 
+        /** When enabled, each template file (e.g. PixelShader_ps.glsl and all the piece files)
+            is parsed only once into an HlmsCompiledTemplate, with its @property expressions
+            already tokenized and its property names already hashed.
+            New shader variants are then generated by evaluating that tree against their
+            properties, instead of scanning the text again with parseMath, parseForEach and
+            parseProperties for every variant.
+
+            The generated shaders are exactly the same. Templates the compiled form
+            can't handle automatically use the text parser.
+        @remarks
+            Default is false while this path is new. Changes take effect on the next generated
+            shader.
+        */
+        void setPrecompiledTemplates( bool bPrecompiledTemplates );
+        bool getPrecompiledTemplates() const { return mPrecompiledTemplates; }
+
         uint8 getParticleSystemConstSlot() const { return mParticleSystemConstSlot; }
         uint8 getParticleSystemSlot() const { return mParticleSystemSlot; }
 
@@ -961,6 +1088,32 @@ namespace Ogre
                                     const size_t passCacheIdx, const QueuedRenderable &queuedRenderable,
                                     bool casterPass, ParallelHlmsCompileQueue &parallelQueue );
 
+        /** Similar to getMaterialSerial01(), but for a PSO recorded by HlmsDiskCache in a
+            previous session instead of a Renderable that is in the scene.
+            See HlmsDiskCache::warmUpPsos.
+        @param passCache
+            Rebuilt from the recorded pass. Its hash must match the index in mPassCache.
+        @param passCacheIdx
+            See getMaterialSerial01()
+        @param renderableHash
+            Return value of addRenderableCache() for the recorded renderable properties.
+        @param recordedPso
+            Provides the macroblock, blendblock and vertex layout that would otherwise come
+            from the Renderable. Must stay alive until parallelQueue is done with it.
+        @param parallelQueue [in/out]
+            Queue to push our work to
+        @return
+            False if the PSO already exists, true if it was queued.
+        */
+        bool _warmUpRecordedPso( const HlmsCache &passCache, size_t passCacheIdx,
+                                 uint32 renderableHash, const HlmsPso &recordedPso,
+                                 ParallelHlmsCompileQueue &parallelQueue );
+
+        /// Called by ParallelHlmsCompileQueue to finish the job started in _warmUpRecordedPso()
+        void _compileRecordedPso( const HlmsCache &passCache, HlmsCache *reservedStubEntry,
+                                  uint32 renderableHash, uint32 finalHash,
+                                  const HlmsPso &recordedPso, size_t tid );
+
         /** Fills the constant buffers. Gets executed right before drawing the mesh.
         @param cache
             Current cache of Shaders to be used.
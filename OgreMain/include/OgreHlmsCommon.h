@@ -173,6 +173,32 @@ namespace Ogre
         return _left.keyName < _right.keyName;
     }
 
+    /** Same as std::lower_bound( properties.begin(), properties.end(), key, OrderPropertyByIdString )
+        but returns an index, and is branchless.
+    @remarks
+        Property keys are hashes, so the outcome of each comparison is random and a regular
+        binary search mispredicts about half of them. Hlms performs this search thousands of
+        times per shader and per Renderable, on vectors of tens to a few hundred entries, where
+        a conditional move is considerably faster.
+    */
+    inline size_t findPropertyLowerBound( const HlmsPropertyVec &properties, IdString key )
+    {
+        size_t numEntries = properties.size();
+        if( numEntries == 0u )
+            return 0u;
+
+        const HlmsProperty *first = &properties[0];
+        const HlmsProperty *base = first;
+        while( numEntries > 1u )
+        {
+            const size_t half = numEntries >> 1u;
+            base = base[half].keyName < key ? base + half : base;
+            numEntries -= half;
+        }
+
+        return static_cast<size_t>( base - first ) + ( base->keyName < key ? 1u : 0u );
+    }
+
     typedef vector<std::pair<IdString, String> >::type HlmsParamVec;
 
     inline bool OrderParamVecByKey( const std::pair<IdString, String> &_left,
@@ -0,0 +1,207 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreHlmsCompiledTemplate_H_
+#define _OgreHlmsCompiledTemplate_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreHlms.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    /** An Hlms template file (e.g. PixelShader_ps.glsl or one of its piece files) parsed once
+        into a tree of text chunks, @foreach loops and @property blocks, with the math
+        operations (@pset, @padd, etc.) extracted, the @property expressions tokenized and
+        their property names hashed into IdStrings.
+
+        generate() produces exactly the same output as running Hlms::parseMath,
+        Hlms::parseForEach and Hlms::parseProperties on the original text, without scanning,
+        copying and tokenizing the whole template again for every shader variant.
+    @remarks
+        Pieces (@piece, @insertpiece, @undefpiece) and counters (@counter, @value, etc.)
+        are copied to the output untouched since they depend on other files.
+    @par
+        Templates the tree can't reproduce exactly (syntax errors, blocks whose @end is
+        glued to the @end of the enclosing block, etc.) are flagged as invalid. The caller
+        must then use the text parser instead. See Hlms::setPrecompiledTemplates.
+    */
+    class _OgreExport HlmsCompiledTemplate : public OgreAllocatedObj
+    {
+    protected:
+        /// A literal number or a property, resolved when generating
+        struct Operand
+        {
+            IdString property;
+            int32    number;
+            bool     isNumber;
+
+            Operand() : number( 0 ), isNumber( true ) {}
+        };
+
+        struct MathOp
+        {
+            size_t   opIdx;
+            IdString dstProperty;
+            Operand  op1;
+            Operand  op2;
+        };
+
+        typedef vector<MathOp>::type MathOpVec;
+
+        struct ExpressionToken
+        {
+            uint8 type;  ///< Hlms::ExpressionType
+            bool  negated;
+            /// When true, 'value' references the counter of an enclosing @foreach
+            /// (e.g. "hlms_shadowmap@n_is_point_light") and must be resolved when generating.
+            bool    isDynamic;
+            Operand operand;  ///< Only for Hlms::EXPR_VAR
+            String  value;    ///< Only when isDynamic
+
+            std::vector<ExpressionToken> children;
+        };
+
+        typedef std::vector<ExpressionToken> ExpressionTokenVec;
+
+        enum NodeType
+        {
+            NodeText,
+            NodeForeach,
+            NodeProperty
+        };
+
+        struct Node
+        {
+            NodeType type;
+            /// NodeText: Range in mSource to output.
+            /// NodeForeach: Range in mSource with the arguments. Only used when isDynamic.
+            size_t start;
+            size_t end;
+            /// Contains '@' that may be replaced by the counter of an enclosing @foreach
+            bool isDynamic;
+
+            ExpressionTokenVec expression;  ///< NodeProperty only
+
+            /// NodeForeach only
+            Operand count;
+            Operand startIdx;
+            String  counterVar;
+
+            /// Body of the @foreach, or body of the @property when it evaluates to true
+            std::vector<Node> children;
+            /// Body of the @else, NodeProperty only
+            std::vector<Node> elseChildren;
+
+            Node( NodeType _type, size_t _start, size_t _end ) :
+                type( _type ),
+                start( _start ),
+                end( _end ),
+                isDynamic( false )
+            {
+            }
+        };
+
+        typedef std::vector<Node> NodeVec;
+
+        struct Counter
+        {
+            String const *name;
+            size_t        value;
+            Counter( const String *_name, size_t _value ) : name( _name ), value( _value ) {}
+        };
+
+        typedef vector<Counter>::type CounterVec;
+
+        String    mOriginalSource;
+        String    mSource;  ///< mOriginalSource without the math operations
+        MathOpVec mMathOps;
+        NodeVec   mNodes;
+        bool      mValid;
+
+        static Operand parseMathOperand( const String &arg );
+        static Operand parseForeachOperand( const String &arg );
+        static int32   resolve( const Operand &operand, const HlmsPropertyVec &properties,
+                                int32 defaultVal );
+
+        /// Applies the counters of the enclosing @foreach loops, from outermost to innermost,
+        /// to the range [start; end) of inBuffer the same way Hlms::repeat would.
+        static void applyCounters( const String &inBuffer, size_t start, size_t end,
+                                   const CounterVec &counters, String &outBuffer );
+
+        static bool parseForeachArgs( const String &inBuffer, size_t start, Node &outNode );
+
+        bool compileExpression( Hlms::ExpressionVec &expression, ExpressionTokenVec &outTokens,
+                                bool inForeach );
+        bool compileBlock( size_t start, size_t end, bool inForeach, NodeVec &outNodes );
+
+        int32 evaluate( const ExpressionTokenVec &expression, const HlmsPropertyVec &properties,
+                        const CounterVec &counters ) const;
+        bool  generate( const NodeVec &nodes, const HlmsPropertyVec &properties,
+                        CounterVec &counters, String &outBuffer ) const;
+
+    public:
+        /// Parses the template. Check isValid() before using it.
+        HlmsCompiledTemplate( const String &source );
+
+        /// False if the template can't be generated by this class and must go through
+        /// the text parser.
+        bool isValid() const { return mValid; }
+
+        /// The template as it was passed to the constructor
+        const String &getOriginalSource() const { return mOriginalSource; }
+
+        /** Generates the template for the given set of properties.
+        @param inOutProperties
+            Properties to evaluate the template with. The template's math operations
+            (@pset, @padd, etc.) modify it, just like Hlms::parseMath does.
+        @param outBuffer [out]
+            The template after the math, @foreach and @property passes.
+        @return
+            False on error (e.g. @foreach with a negative start). inOutProperties is then
+            left untouched and the caller must use the text parser instead.
+        */
+        bool generate( HlmsPropertyVec &inOutProperties, String &outBuffer ) const;
+    };
+
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
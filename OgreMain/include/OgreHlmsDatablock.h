@@ -607,6 +607,13 @@ namespace Ogre
         /// See HlmsDatablock::getDiffuseColour
         virtual TextureGpu *getEmissiveTexture() const;
 
+        /** Calls GpuResource::notifyUsed on the textures used by this datablock.
+            RenderQueue calls it every frame for the renderables it renders, while
+            TextureGpuManager::getPriorityStreaming is enabled.
+            The default implementation notifies getDiffuseTexture & getEmissiveTexture.
+        */
+        virtual void notifyTexturesUsed( float distanceToCamera );
+
         /**
         @remarks
             It's possible to set both saveOitd & saveOriginal to true, but will likely double
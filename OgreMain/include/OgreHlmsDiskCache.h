@@ -30,6 +30,11 @@ THE SOFTWARE.
 
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
+
+#include "ogrestd/unordered_set.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -124,12 +129,31 @@ namespace Ogre
                                     Depending on the API and Driver, building the PSO can be very fast
                                     or take significant time.
 
-                                    Note that due to a technical issue, this information is currently
-                                    being saved to disk but the PSO is not rebuilt (i.e. the information
-                                    is not used). Because of it, certain platforms may still experience
-                                    some stalls at runtime, due to the driver translating the Microcode
-                                    to the internal ISA.
+                                    applyTo does not rebuild the PSOs. Call warmUpPsos afterwards
+                                    to rebuild every PSO used in previous sessions, including those
+                                    for objects that are not visible yet. Otherwise certain platforms
+                                    may still experience some stalls at runtime, due to the driver
+                                    translating the Microcode to the internal ISA.
     @endcode
+
+        The file is a header followed by a list of records (one per shader, PSO or custom piece
+        file), each with its own size and checksum. New records can be appended at any time, see
+        startBackgroundSave. Duplicated records are skipped when loading, and a record that was
+        only partially written (e.g. the app crashed while saving) ends the file.
+
+        To keep the cache up to date without ever saving it all at once:
+    @code
+        DataStreamPtr file = archive->open( filename, false );  // Read-write
+        diskCache.loadFrom( file );
+        diskCache.applyTo( hlms, numThreads, true );  // Compile on first use
+        diskCache.warmUpPsos( hlms, sceneManager );  // Optional. Build the recorded PSOs now
+
+        if( !diskCache.canAppendTo( hlms ) )
+            file = archive->create( filename );  // Out of date. Start a new file
+        diskCache.startBackgroundSave( hlms, file );
+    @endcode
+        Files that have grown from many appends can be compacted offline by calling loadFrom
+        and then saveTo into a new file.
     */
     class _OgreExport HlmsDiskCache : public OgreAllocatedObj
     {
@@ -141,6 +165,7 @@ namespace Ogre
 
             SourceCode();
             SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache );
+            SourceCode( const Hlms::PreprocessedShaderCode &preprocessedShaderCode );
         };
 
         typedef vector<SourceCode>::type SourceCodeVec;
@@ -149,6 +174,9 @@ namespace Ogre
         {
             Hlms::RenderableCache renderableCache;
             HlmsPropertyVec       passProperties;
+            /// Properties of the HlmsCache returned by Hlms::preparePassHash. Usually a few more
+            /// than passProperties. Needed to rebuild the PSO. Empty if unknown.
+            HlmsPropertyVec       passCacheProperties;
             HlmsPso               pso;
             HlmsMacroblock        macroblock;
             HlmsBlendblock        blendblock;
@@ -179,6 +207,16 @@ namespace Ogre
             DatablockCustomPiecesCacheVec datablockCustomPieceFiles;
         };
 
+        enum RecordType
+        {
+            RecordDatablockCustomPieces,
+            RecordSourceCode,
+            RecordPso
+        };
+
+        /// Hash of every record in the file. Used to skip duplicates.
+        typedef unordered_set<uint64>::type RecordHashSet;
+
         bool         mTemplatesOutOfDate;
         Cache        mCache;
         HlmsManager *mHlmsManager;
@@ -188,15 +226,62 @@ namespace Ogre
         bool         mFastShaderBuildHack;
         uint16       mDebugStrSize;
 
+        RecordHashSet mSavedRecords;
+        /// Where the last valid record read by loadFrom ends. 0 if loading failed.
+        size_t mValidStreamSize;
+        /// Hlms the loaded cache was successfully applied to.
+        Hlms *mAppliedTo;
+
+        Hlms           *mBackgroundSaveHlms;
+        DataStreamPtr   mBackgroundSaveStream;
+        ThreadHandlePtr mBackgroundSaveThread;
+        WaitableEvent   mBackgroundSaveEvent;
+
+        LightweightMutex              mPendingMutex;
+        DatablockCustomPiecesCacheVec mPendingCustomPieceFiles;  // GUARDED_BY( mPendingMutex )
+        SourceCodeVec                 mPendingSourceCode;        // GUARDED_BY( mPendingMutex )
+        PsoVec                        mPendingPso;               // GUARDED_BY( mPendingMutex )
+        bool                          mStopBackgroundSave;       // GUARDED_BY( mPendingMutex )
+
+        /// Returns false if the properties reference a datablock custom piece file
+        /// that was generated from memory.
+        static bool isCacheable( const Hlms *hlms, const HlmsPropertyVec &properties );
+        /// Adds the datablock custom piece files the properties reference.
+        static void addCustomPieceFiles( const Hlms *hlms, const HlmsPropertyVec &properties,
+                                         DatablockCustomPiecesCacheVec &outCustomPieceFiles );
+
+        /** Stores in outDiff the properties that are in fullProperties but not in baseProperties,
+            or have a different value. Both must be sorted (see Hlms::setProperty).
+        @return
+            False if fullProperties lacks some of the baseProperties, thus outDiff is not enough
+            to rebuild fullProperties with mergeProperties.
+        */
+        static bool diffProperties( const HlmsPropertyVec &baseProperties,
+                                    const HlmsPropertyVec &fullProperties, HlmsPropertyVec &outDiff );
+        /// Inverse of diffProperties. Sets the properties in diff to inOutProperties.
+        static void mergeProperties( HlmsPropertyVec &inOutProperties, const HlmsPropertyVec &diff );
+
+        void writeHeader( DataStreamPtr &dataStream );
+
         void save( DataStreamPtr &dataStream, const IdString &hashedString );
         void save( DataStreamPtr &dataStream, const String &string );
         void save( DataStreamPtr &dataStream, const HlmsPropertyVec &properties );
         void save( DataStreamPtr &dataStream, const Hlms::RenderableCache &renderableCache );
+        void save( DataStreamPtr &dataStream, const DatablockCustomPiecesCache &datablockPiece );
+        void save( DataStreamPtr &dataStream, const SourceCode &sourceCode );
+        void save( DataStreamPtr &dataStream, const Pso &pso );
+
+        /// Writes the entry as a record, unless an identical record has already been saved.
+        template <typename T>
+        void saveRecord( DataStreamPtr &dataStream, RecordType recordType, const T &entry );
 
         void load( DataStreamPtr &dataStream, IdString &hashedString );
         void load( DataStreamPtr &dataStream, String &string );
         void load( DataStreamPtr &dataStream, HlmsPropertyVec &properties );
         void load( DataStreamPtr &dataStream, Hlms::RenderableCache &renderableCache );
+        void load( DataStreamPtr &dataStream, DatablockCustomPiecesCache &datablockPiece );
+        void load( DataStreamPtr &dataStream, SourceCode &sourceCode );
+        void load( DataStreamPtr &dataStream, Pso &pso );
 
     public:
         HlmsDiskCache( HlmsManager *hlmsManager );
@@ -205,11 +290,79 @@ namespace Ogre
         void clearCache();
 
         void copyFrom( Hlms *hlms );
-        void applyTo( Hlms *hlms, size_t numThreads );
+
+        /** Sends the loaded shaders to the Hlms.
+        @param hlms
+            Hlms to apply the cache to. Its shader cache is cleared.
+        @param numThreads
+            Number of threads used to compile the shaders. Ignored when lazyCompilation is true.
+        @param lazyCompilation
+            When false, every cached shader is compiled now.
+            When true, shaders are kept preprocessed and compiled the first time a Renderable
+            needs them. Startup only pays for the shaders that are actually used, but the
+            first use still pays for their compilation.
+        */
+        void applyTo( Hlms *hlms, size_t numThreads, bool lazyCompilation = false );
+
+        /** Builds every PSO in the loaded cache that the Hlms doesn't have yet, i.e. every PSO
+            that was used while the cache was recorded. Unlike CompositorPassWarmUp, this
+            includes PSOs for objects that are not currently visible, or not even loaded.
+
+            The PSOs are compiled from the worker threads of the SceneManager when the
+            RenderSystem supports it (see RenderQueue::warmUpShadersTrigger).
+        @remarks
+            applyTo must have been called first with the same Hlms, and succeeded.
+            Call it outside of rendering (e.g. after loading a level). Each PSO is rebuilt
+            with the properties of its pass as recorded; so if the scene no longer
+            has the same passes (e.g. different shadow node settings) some of these
+            PSOs may never be used.
+        @param hlms
+            Hlms the cache was applied to.
+        @param sceneManager
+            Provides the RenderQueue and worker threads.
+        @return
+            Number of PSOs that were built.
+        */
+        size_t warmUpPsos( Hlms *hlms, SceneManager *sceneManager );
 
         void saveTo( DataStreamPtr &dataStream );
         void loadFrom( DataStreamPtr &dataStream );
 
+        /** Returns true if the cache loaded with loadFrom was applied to the given Hlms, and
+            it is still up to date; thus new entries can be appended to the same file.
+        */
+        bool canAppendTo( const Hlms *hlms ) const;
+
+        /** Starts saving every shader and PSO generated by the Hlms from now on, from
+            a background thread and as soon as they're created. This removes the need
+            to call copyFrom & saveTo, and the stall they cause with big caches.
+        @param hlms
+            Hlms to watch. Only one HlmsDiskCache can save an Hlms in the background at a time.
+        @param dataStream
+            When canAppendTo( hlms ) returns true, this must be the stream loadFrom was called
+            with, opened with write access. New records get appended after the loaded ones.
+            Otherwise it must be a new empty file; the current contents of the Hlms are
+            written first (like saveTo does).
+            The stream must not be used by anyone else until stopBackgroundSave.
+        */
+        void startBackgroundSave( Hlms *hlms, DataStreamPtr &dataStream );
+
+        /** Waits for the pending entries to be written and stops saving in the background.
+            Called automatically when this HlmsDiskCache or the Hlms are destroyed.
+        */
+        void stopBackgroundSave();
+
+        bool isSavingInBackground() const { return mBackgroundSaveHlms != 0; }
+
+        /// Called by Hlms when it creates a new shader. Can be called from any thread.
+        void _notifyShaderCodeCacheEntryCreated( const Hlms                  *hlms,
+                                                 const Hlms::ShaderCodeCache &codeCache );
+        /// Called by Hlms when it creates a new PSO. Can be called from any thread.
+        void _notifyPsoCreated( const Hlms *hlms, const Hlms::RenderableCache &renderableCache,
+                                uint32 finalHash, const HlmsCache *psoCache );
+
+        unsigned long _backgroundSaveThread();
+
         static void _compileShadersThread( CompilerJobParams &threadHandle, size_t threadIdx );
     };
 
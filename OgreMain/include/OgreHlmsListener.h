@@ -81,6 +81,7 @@ namespace Ogre
         @param properties
             Combined properties of both renderableCacheProperties & passCache.setProperties
         @param queuedRenderable
+            See Hlms::createShaderCacheEntry. The renderable may be null.
         @param tid
             Thread Idx
         */
@@ -136,7 +137,7 @@ namespace Ogre
         @param properties
             The current contents of Hlms::mSetProperties
         @param queuedRenderable
-            See Hlms::createShaderCacheEntry
+            See Hlms::createShaderCacheEntry. The renderable may be null.
         @param tid
             Thread Idx
         */
@@ -31,10 +31,14 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "OgreCommon.h"
+#include "OgreImageCodec2.h"
+#include "OgreSharedPtr.h"
 #include "OgreTextureGpu.h"
 
 namespace Ogre
 {
+    class UniformScalableTaskExecutor;
+
     /** \addtogroup Core
      *  @{
      */
@@ -71,6 +75,13 @@ namespace Ogre
         /// A bool to determine if we delete the buffer or the calling app does
         bool mAutoDelete;
 
+        /// When not null, mBuffer points inside this (memory mapped) stream, which is kept
+        /// alive for as long as we reference it. Such data is read-only.
+        DataStreamPtr mBackingStream;
+
+        /// If mBuffer lives in mBackingStream, replaces it with a heap copy we can write to
+        void detachFromBackingStream();
+
         void flipAroundY( uint8 mipLevel );
         void flipAroundX( uint8 mipLevel, void *pTempBuffer );
 
@@ -278,9 +289,25 @@ namespace Ogre
         /// This version tries both.
         void load2( DataStreamPtr &stream, const String &filename );
 
+        /** Decodes an image file from a stream without loading it into an Image2; the
+            listener receives the image a few rows at a time instead.
+            See ImageCodec2::decodeStreaming.
+        @remarks
+            The codec is found the same way as load2.
+        @return
+            False if the listener aborted.
+        */
+        static bool decodeStreaming( DataStreamPtr &stream, const String &filename,
+                                     ImageCodec2::StreamingListener *listener,
+                                     uint32 maxRowsPerBatch = 64u );
+
     protected:
         void load( DataStreamPtr &stream, Codec *pCodec );
 
+        /// Finds the codec for the stream by extension, falling back to magic numbers.
+        /// Throws if none was found.
+        static Codec *findCodec( DataStreamPtr &stream, const String &filename );
+
     public:
         /** Save the image as a file.
         @remarks
@@ -415,16 +442,31 @@ namespace Ogre
             True if the filter should be applied in linear space.
         @param filter
             The type of filter to use.
+        @param executor
+            Optional. When present, each mip is split across threads: cubemap faces run in
+            parallel, and so do groups of rows when using the bilinear filter on RGBA8 or
+            RGBA32_FLOAT. See TextureGpuManager, which exposes its multiload pool this way.
         @return
             False if failed to generate and mipmaps properties won't be changed. True on success.
         */
-        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR );
+        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR,
+                              UniformScalableTaskExecutor *executor = 0 );
 
         /// Static function to get an image type string from a stream via magic numbers
         static String getFileExtFromMagic( DataStreamPtr &stream );
 
         void _setAutoDelete( bool autoDelete );
         bool getAutoDelete() const;
+
+        /** Returns true if the pixel data points directly into a memory mapped file
+            (e.g. OITD or DDS opened via FileSystemArchive::openMemoryMapped) instead of
+            a heap allocation owned by this Image2.
+        @remarks
+            The mapping stays alive while any Image2 references it. The data is read-only;
+            functions that modify the image (flip, resize, generateMipmaps, setColourAt)
+            transparently make a private heap copy first.
+        */
+        bool isMemoryMapped() const { return mBackingStream.get() != 0; }
     };
 
     /** @} */
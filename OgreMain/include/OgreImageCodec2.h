@@ -76,12 +76,78 @@ namespace Ogre
             uint8                      numMipmaps;
             bool                       freeOnDestruction;
 
+            /// When set, box.data points inside this stream's memory (i.e. a
+            /// MemoryMappedDataStream whose contents already are in Image2's layout),
+            /// freeOnDestruction is false, and Image2 keeps the stream alive.
+            DataStreamPtr backingStream;
+
         public:
             String dataType() const override { return "ImageData2"; }
         };
 
+        /** Receives an image a few rows at a time. See ImageCodec2::decodeStreaming.
+        @remarks
+            Mips, slices and rows are delivered in order: all rows of mip 0 (slice by slice),
+            then mip 1, etc.
+        */
+        class _OgreExport StreamingListener
+        {
+        public:
+            virtual ~StreamingListener();
+
+            /** Called once before any row is delivered.
+            @param header
+                Resolution, format and number of mips of the image. header.box.data is null.
+            @return
+                False to abort decoding.
+            */
+            virtual bool headerDecoded( const ImageData2 &header ) = 0;
+
+            /** Called with consecutive rows of the image.
+            @param rows
+                The decoded rows. rows.data points to the first row (i.e. rows.y is 0)
+                and rows.height is the number of rows. Only valid during this call.
+            @param mipLevel
+                Mip level these rows belong to.
+            @param zOrSlice
+                Depth or slice these rows belong to.
+            @param firstRow
+                Index of the first row in rows, relative to the top of the image.
+            @return
+                False to abort decoding.
+            */
+            virtual bool rowsDecoded( const TextureBox &rows, uint8 mipLevel, uint32 zOrSlice,
+                                      uint32 firstRow ) = 0;
+        };
+
     public:
         String getDataType() const override { return "ImageCodec2"; }
+
+        /** Decodes an image while handing it over to the listener a few rows at a time,
+            instead of returning it in an ImageData2 (which is what decode does).
+            Useful for huge images (e.g. heightmaps) that are going to be copied somewhere
+            else anyway.
+        @remarks
+            This is not scanline decoding: codecs may still decode the whole image internally
+            before delivering the first row. stb_image and FreeImage can't decode scanlines
+            incrementally, so STBIImageCodec and FreeImageCodec2 do. What they save is the
+            extra full size copy decode() makes when the pixels need converting (e.g. RGB
+            expanded to RGBA, FreeImage formats converted to a supported one), which is done
+            one batch of rows at a time instead.
+
+            The default implementation calls decode() and delivers its rows, so it works
+            with every codec but saves nothing. Codecs override it when they can do better.
+        @param input
+            The stream to decode.
+        @param listener
+            Receives the image. Can't be null.
+        @param maxRowsPerBatch
+            Maximum number of rows per StreamingListener::rowsDecoded call.
+        @return
+            False if the listener aborted.
+        */
+        virtual bool decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                                      uint32 maxRowsPerBatch = 64u ) const;
     };
 
     /** @} */
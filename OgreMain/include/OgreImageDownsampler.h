@@ -28,6 +28,8 @@ THE SOFTWARE.
 #ifndef _OgreImageDownsampler_H_
 #define _OgreImageDownsampler_H_
 
+#include "OgrePrerequisites.h"
+
 namespace Ogre
 {
     /** \addtogroup Core
@@ -60,6 +62,19 @@ namespace Ogre
     ImageDownsampler2D downscale2x_A8;
     ImageDownsampler2D downscale2x_XA88;
 
+    /** Specialized version of ImageDownsampler2D for the bilinear filter (c_filterKernels[1]),
+        vectorized with SSE2 / NEON. Results are bit-exact with the generic version.
+        Only writes destination rows in range [rowStart; rowEnd), so that multiple threads
+        can work on the same image.
+    */
+    typedef void( ImageDownsampler2DBilinear )( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
+                                                int32 dstHeight, int32 dstBytesPerRow,
+                                                int32 srcBytesPerRow, int32 rowStart, int32 rowEnd );
+
+    ImageDownsampler2DBilinear downscale2xBilinear_XXXA8888;
+    ImageDownsampler2DBilinear downscale2xBilinear_sRGB_XXXA8888;
+    ImageDownsampler2DBilinear downscale2xBilinear_Float32_XXXA;
+
     //
     //  3D versions
     //
@@ -484,6 +484,14 @@ namespace Ogre
         /// hurt loading times with unnecessary disk access
         static bool msUseTimestampAsHash;
 
+        /// When true and the mesh lives in a FileSystem archive, the file is memory mapped
+        /// instead of being read into a heap copy. Vertex and index blobs that are suitably
+        /// aligned (see MESH_VERSION_2_1_ALIGNED) are then handed to the VaoManager directly
+        /// from the mapped pages, without intermediate copies.
+        ///
+        /// Disabled by default. Falls back to regular loading if mapping fails.
+        static bool msUseMemoryMappedFiles;
+
         void prepareForShadowMapping( bool forceSameBuffers );
 
         /// Returns true if the mesh is ready for rendering with valid shadow mapping Vaos
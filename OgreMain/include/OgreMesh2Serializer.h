@@ -66,6 +66,9 @@ namespace Ogre
 
         /// OGRE version v2.0+
         MESH_VERSION_2_1,
+        /// Same as MESH_VERSION_2_1 but with 16-byte aligned vertex & index data,
+        /// suitable for zero-copy loading via Mesh::msUseMemoryMappedFiles
+        MESH_VERSION_2_1_ALIGNED,
         MESH_VERSION_LEGACY  // R0 & R1 (beta)
     };
 
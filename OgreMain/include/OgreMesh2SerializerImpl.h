@@ -99,6 +99,10 @@ namespace Ogre
             uint32               numIndices;
             void                *indexData;
             OperationType        operationType;
+            /// When true, vertexBuffers / indexData point directly into the memory of the
+            /// stream being imported (see readBlobInPlace) and must not be freed.
+            bool vertexDataInPlace;
+            bool indexDataInPlace;
 
             SubMeshLod();
         };
@@ -189,6 +193,29 @@ namespace Ogre
 
         virtual void createSubMeshVao( SubMesh *sm, SubMeshLodVec &submeshLods, uint8 numVaoPasses );
 
+        /// Frees the vertex & index data of the given LODs that wasn't handed over yet.
+        /// Used for cleaning up after an exception.
+        void freeSubMeshLodData( SubMeshLodVec &submeshLods );
+
+        /** Returns a pointer to the next sizeBytes of the stream and skips them, if the stream
+            is memory backed (MemoryDataStream or MemoryMappedDataStream), no endian conversion
+            is needed and the data is 16-byte aligned (mBlobAlignment). Returns a null pointer
+            otherwise, in which case nothing is consumed.
+        @remarks
+            The returned pointer is only valid while the stream is alive.
+        */
+        const void *readBlobInPlace( DataStreamPtr &stream, size_t sizeBytes );
+
+        /// Writes the leading padding so that the blob written next starts at a file offset
+        /// multiple of mBlobAlignment. Returns the padding used. No-op if mBlobAlignment == 0.
+        uint8 writeBlobPadding();
+        /// Writes the trailing padding; so that each blob takes exactly mBlobAlignment
+        /// extra bytes, regardless of its offset.
+        void writeBlobPaddingTail( uint8 padding );
+        /// Reading counterparts of writeBlobPadding & writeBlobPaddingTail
+        uint8 readBlobPadding( DataStreamPtr &stream );
+        void  skipBlobPaddingTail( DataStreamPtr &stream, uint8 padding );
+
         /// Flip an entire vertex buffer to/from little endian
         /// working on the data pointer passed in pData
         void flipLittleEndian( void *pData, VertexBufferPacked *vertexBuffer );
@@ -217,6 +244,23 @@ namespace Ogre
         uint64      mCalculatedHash[2];  // Calculated when exporting
         ushort      exportedLodCount;    // Needed to limit exported Edge data, when exporting
         VaoManager *mVaoManager;
+        /// Vertex & index blobs are padded so they start at file offsets multiple of this value.
+        /// 0 means no padding (the regular format).
+        uint8 mBlobAlignment;
+    };
+
+    /** Same as MeshSerializerImpl, but every vertex and index blob is padded so that it
+        starts at a file offset multiple of 16 bytes.
+    @remarks
+        When the file is memory mapped (see Mesh::msUseMemoryMappedFiles) the blobs are then
+        aligned in memory too, and are handed to the VaoManager in place instead of being
+        copied to temporary buffers first.
+    */
+    class _OgrePrivate MeshSerializerImpl_v2_1_R2_Aligned final : public MeshSerializerImpl
+    {
+    public:
+        MeshSerializerImpl_v2_1_R2_Aligned( VaoManager *vaoManager );
+        ~MeshSerializerImpl_v2_1_R2_Aligned() override;
     };
 
     class _OgrePrivate MeshSerializerImpl_v2_1_R1 : public MeshSerializerImpl
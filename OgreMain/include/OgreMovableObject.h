@@ -142,6 +142,10 @@ namespace Ogre
         /// The memory manager used to allocate the ObjectData.
         ObjectMemoryManager *mObjectMemoryManager;
 
+        /// GpuCulling tracking this object, and our slot in it. Set by the GpuCulling
+        mutable GpuCulling *mGpuCulling;
+        mutable uint32      mGpuCullingSlot;
+
 #if OGRE_DEBUG_MODE
         mutable bool mCachedAabbOutOfDate;
 #endif
@@ -161,6 +165,9 @@ namespace Ogre
         Aabb  updateSingleWorldAabb();
         float updateSingleWorldRadius();
 
+        /// Tells our ObjectMemoryManager that culling results of our render queue may change.
+        void notifyCullingChanged();
+
     public:
         /** Index in the vector holding this MO reference (could be our parent node, or a global
             array tracking all movable objecst to avoid memory leaks). Used for O(1) removals.
@@ -278,8 +285,19 @@ namespace Ogre
         /** @see SceneManager::updateAllBounds
         @remarks
             We don't pass by reference on purpose (avoid implicit aliasing)
+        @param dirtyOnly
+            When true, blocks whose ObjectData::mBoundsDirty is clear and whose parents' derived
+            transforms didn't change this frame are skipped.
+            @see SceneManager::setIncrementalTransformUpdates
+        @param outChangedObjects
+            Optional. Out. Objects tracked by a GpuCulling in the blocks whose bounds changed,
+            so that only those get uploaded. See GpuCulling::updateObject
+        @return
+            True if the world bounds of at least one block changed. Blocks that were
+            recalculated to the same values don't count.
         */
-        static void updateAllBounds( const size_t numNodes, ObjectData t );
+        static bool updateAllBounds( const size_t numNodes, ObjectData t, bool dirtyOnly = false,
+                                     FastArray<MovableObject *> *outChangedObjects = 0 );
 
     private:
         static inline ArrayReal calculateCameraDistance( uint32                    _cameraSortMode,
@@ -354,6 +372,7 @@ namespace Ogre
         friend void LodStrategy::lodUpdateImpl( const size_t numNodes, ObjectData t,
                                                 const Camera *camera, Real bias ) const;
         friend void LodStrategy::lodSet( ObjectData &t, Real lodValues[ARRAY_PACKED_REALS] );
+        friend class GpuCulling;
 
         /** Tells this object whether to be visible or not, if it has a renderable component.
         @note An alternative approach of making an object invisible is to detach it
@@ -56,18 +56,24 @@ namespace Ogre
                     ( flags & VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) |
                     ( mObjectData.mVisibilityFlags[mObjectData.mIndex] &
                         ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline void MovableObject::addVisibilityFlags( uint32 flags )
     {
         mObjectData.mVisibilityFlags[mObjectData.mIndex] |=
                                         flags & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline void MovableObject::removeVisibilityFlags( uint32 flags )
     {
         mObjectData.mVisibilityFlags[mObjectData.mIndex] &=
                                         ~(flags & VisibilityFlags::RESERVED_VISIBILITY_FLAGS);
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline uint32 MovableObject::getVisibilityFlags() const
@@ -114,6 +120,8 @@ namespace Ogre
             mObjectData.mUpperDistance[0][mObjectData.mIndex] = dist;
             mObjectData.mUpperDistance[1][mObjectData.mIndex] = std::min(dist, mObjectData.mUpperDistance[1][mObjectData.mIndex]);
         }
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline Real MovableObject::getRenderingDistance() const
@@ -128,6 +136,8 @@ namespace Ogre
         {
             mObjectData.mUpperDistance[1][mObjectData.mIndex] = std::min(dist, mObjectData.mUpperDistance[0][mObjectData.mIndex]);
         }
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline Real MovableObject::getShadowRenderingDistance() const
@@ -144,6 +154,8 @@ namespace Ogre
             mObjectData.mVisibilityFlags[mObjectData.mIndex] |= VisibilityFlags::LAYER_VISIBILITY;
         else
             mObjectData.mVisibilityFlags[mObjectData.mIndex] &= ~VisibilityFlags::LAYER_VISIBILITY;
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline bool MovableObject::getVisible() const
@@ -158,6 +170,8 @@ namespace Ogre
             mObjectData.mVisibilityFlags[mObjectData.mIndex] |= VisibilityFlags::LAYER_SHADOW_CASTER;
         else
             mObjectData.mVisibilityFlags[mObjectData.mIndex] &= ~VisibilityFlags::LAYER_SHADOW_CASTER;
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------------------
     inline bool MovableObject::getCastShadows() const
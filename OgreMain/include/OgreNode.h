@@ -254,6 +254,16 @@ namespace Ogre
         /// Returns a direct access to the Transform state
         Transform &_getTransform() { return mTransform; }
 
+        /** Flags our transform to be recalculated in the next SceneManager::updateAllTransforms
+            when SceneManager::setIncrementalTransformUpdates is enabled.
+            All setters (setPosition, setOrientation, etc) already call this.
+            Only needed when writing into _getTransform() directly.
+        */
+        void _setTransformDirty()
+        {
+            mTransform.mDirtyFlags[mTransform.mIndex] |= TransformDirtyFlags::LocalDirty;
+        }
+
         /// Called by SceneManager when it is telling we're a static node being dirty
         /// Don't call this directly. @see SceneManager::notifyStaticDirty
         virtual void _notifyStaticDirty() const;
@@ -706,8 +716,12 @@ namespace Ogre
         /** @see SceneManager::updateAllTransforms()
         @remarks
             We don't pass by reference on purpose (avoid implicit aliasing)
+        @param dirtyOnly
+            When true, blocks of ARRAY_PACKED_REALS nodes where no node is flagged as
+            TransformDirtyFlags::LocalDirty and no parent has TransformDirtyFlags::DerivedChanged
+            are skipped. See SceneManager::setIncrementalTransformUpdates
         */
-        static void updateAllTransforms( const size_t numNodes, Transform t );
+        static void updateAllTransforms( const size_t numNodes, Transform t, bool dirtyOnly = false );
 
         /** Gets the local position, relative to this node, of the given world-space position */
         virtual_l2 Vector3 convertWorldToLocalPosition( const Vector3 &worldPos );
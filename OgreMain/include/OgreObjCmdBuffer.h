@@ -116,6 +116,8 @@ namespace Ogre
             void execute() override;
         };
 
+        /// box may be bigger than dstBox when it was padded for a packed texture.
+        /// See TextureGpuManager::setAutoPackingMaxResolution
         class UploadFromStagingTex : public Cmd
         {
             StagingTexture *stagingTexture;
@@ -146,10 +148,16 @@ namespace Ogre
             TextureGpu *texture;
             uint32      dstSliceOrDepth;
             uint32      millisecondsTaken;
+            /// Microseconds spent in each TextureLoadStage that runs in the worker thread
+            uint64 usFileIo;
+            uint64 usDecode;
+            uint64 usFilters;
+            uint64 usStagingCopy;
 
         public:
+            /// usStages is indexed by TextureLoadStage
             LogProfilingData( TextureGpu *_textureGpu, uint32 _dstSliceOrDepth,
-                              uint64 microsecondsTaken );
+                              uint64 microsecondsTaken, const uint64 *usStages );
             void execute() override;
         };
 #endif
@@ -492,7 +492,9 @@ THE SOFTWARE.
 #endif
 
 // Find perfect alignment (should supports SIMD alignment if SIMD available)
-#if OGRE_CPU == OGRE_CPU_X86
+#if OGRE_CPU == OGRE_CPU_X86 && OGRE_USE_SIMD_AVX2 == 1
+#    define OGRE_SIMD_ALIGNMENT 32
+#elif OGRE_CPU == OGRE_CPU_X86
 #    define OGRE_SIMD_ALIGNMENT 16
 #else
 #    define OGRE_SIMD_ALIGNMENT 16
@@ -139,6 +139,7 @@ namespace Ogre
     class AxisAlignedBox;
     class AxisAlignedBoxSceneQuery;
     class Barrier;
+    class BatchRaySceneQuery;
     class BillboardSet;
     class Bone;
     class BoneMemoryManager;
@@ -183,6 +184,7 @@ namespace Ogre
     struct FrameEvent;
     class FrameListener;
     class Frustum;
+    class GpuCulling;
     struct GpuLogicalBufferStruct;
     struct GpuNamedConstants;
     class GpuProgramParameters;
@@ -199,6 +201,8 @@ namespace Ogre
     class Hlms;
     struct HlmsBlendblock;
     struct HlmsCache;
+    class HlmsCompiledTemplate;
+    class HlmsDiskCache;
     class HlmsCompute;
     class HlmsComputeJob;
     struct HlmsComputePso;
@@ -233,6 +237,7 @@ namespace Ogre
     class Matrix3;
     class Matrix4;
     class MemoryDataStream;
+    class MemoryMappedDataStream;
     class MemoryManager;
     class Mesh;
     class MeshManager;
@@ -293,6 +298,7 @@ namespace Ogre
     class SceneManagerEnumerator;
     class SceneNode;
     class SceneQuery;
+    class SceneQueryBvh;
     class SceneQueryListener;
     class ScriptCompiler;
     class ScriptCompilerManager;
@@ -315,6 +321,7 @@ namespace Ogre
     class SubItem;
     class SubMesh;
     class TagPoint;
+    class TaskScheduler;
     class Technique;
     class TempBlendedBufferInfo;
     class TexBufferPacked;
@@ -83,6 +83,11 @@ namespace Ogre
         floats (which are often not supported by other radix sorters). doubles
         are not supported; you will need to implement your functor object to convert
         to float if you wish to use this sort routine.
+        64-bit unsigned integers (i.e. uint64 hashes) are supported too.
+    @par
+        Passes in which all values share the same byte are skipped, since they
+        wouldn't change the order. This is common when the keys don't use all of
+        their bits.
     */
     template <class TContainer, class TContainerValueType, typename TCompValueType>
     class RadixSort
@@ -92,8 +97,8 @@ namespace Ogre
 
     protected:
         /// Alpha-pass counters of values (histogram)
-        /// 4 of them so we can radix sort a maximum of a 32bit value
-        int mCounters[4][256];
+        /// 8 of them so we can radix sort a maximum of a 64bit value
+        int mCounters[8][256];
         /// Beta-pass offsets
         int mOffsets[256];
         /// Sort area size
@@ -304,6 +309,10 @@ namespace Ogre
 
             for( p = 0; p < mNumPasses - 1; ++p )
             {
+                // All values have the same byte: this pass would be a plain copy
+                if( mCounters[p][getByte( p, prevValue )] == mSortSize )
+                    continue;
+
                 sortPass( p );
                 // flip src/dst
                 SortVector *tmp = mSrc;
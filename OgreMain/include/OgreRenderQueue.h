@@ -32,9 +32,12 @@ THE SOFTWARE.
 
 #include "OgreHlmsCommon.h"
 #include "OgreIteratorWrappers.h"
+#include "OgreMatrix4.h"
+#include "OgreRadixSort.h"
 #include "OgreSharedPtr.h"
 #include "Threading/OgreLightweightMutex.h"
 #include "Threading/OgreSemaphore.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -44,6 +47,7 @@ namespace Ogre
 {
     class Camera;
     class MovableObject;
+    class RenderQueueSnapshot;
 
     /** \addtogroup Core
      *  @{
@@ -82,26 +86,50 @@ namespace Ogre
             QueuedRenderable queuedRenderable;
             uint32           renderableHash;
             uint32           finalHash;
+            /// When not null, queuedRenderable is empty and the PSO is created from this
+            /// recorded one instead. See RenderQueue::warmUpRecordedPso.
+            HlmsPso const *recordedPso;
         };
 
     protected:
+        /// Used when the SceneManager routes its work through a TaskScheduler. Each
+        /// one drains mRequests and then returns, instead of blocking a worker until
+        /// stopAndWait() like updateThread() does.
+        struct CompileTask final : public UniformScalableTask
+        {
+            ParallelHlmsCompileQueue *queue;
+            /// Tid handed to the Hlms. Unique among the CompileTasks running at the same time.
+            size_t tid;
+
+            void execute( size_t threadId, size_t numThreads ) override;
+        };
+
         std::vector<Request> mRequests;  // GUARDED_BY( mMutex )
         LightweightMutex     mMutex;
         Semaphore            mSemaphore;
         std::atomic<bool>    mKeepCompiling;
 
+        /// Not null between start() and stopAndWait() if the SceneManager uses a TaskScheduler.
+        TaskScheduler *mTaskScheduler;
+        HlmsManager   *mHlmsManager;
+        /// One per SceneManager worker thread
+        std::vector<CompileTask> mCompileTasks;
+        /// Indices to mCompileTasks not currently scheduled.
+        std::vector<size_t> mIdleCompileTasks;  // GUARDED_BY( mMutex )
+        /// TaskScheduler::TaskId of every CompileTask scheduled since start()
+        std::vector<uint32> mScheduledTasks;
+
         bool               mExceptionFound;     // GUARDED_BY( mMutex )
         std::exception_ptr mThreadedException;  // GUARDED_BY( mMutex )
 
+        /// Shared by updateWarmUpThread() and warmUpSerial().
+        void compileWarmUpRequest( const Request &request, HlmsManager *hlmsManager,
+                                   const HlmsCache *passCaches, size_t tid );
+
     public:
         ParallelHlmsCompileQueue();
 
-        inline void pushRequest( const Request &&request )
-        {
-            ScopedLock lock( mMutex );
-            mRequests.emplace_back( request );
-            mSemaphore.increment();
-        }
+        void pushRequest( const Request &&request );
 
         inline void pushWarmUpRequest( const Request &&request ) { mRequests.emplace_back( request ); }
 
@@ -109,12 +137,17 @@ namespace Ogre
             gets called and will keep compiling those shaders until stopAndWait() is called.
 
             The work is done in updateThread() and is in charge of compiling shaders AND generating PSOs.
+
+            If the SceneManager uses a TaskScheduler, no thread is taken over. Instead
+            pushRequest() schedules CompileTasks on demand, which return once there is
+            nothing left to compile.
         @remarks
             This function must not be called if RenderSystem::supportsMultithreadedShaderCompilation
             is false.
         @param sceneManager
+        @param hlmsManager
         */
-        void start( SceneManager *sceneManager );
+        void start( SceneManager *sceneManager, HlmsManager *hlmsManager );
         /** Signals worker threads we won't be submitting more work, so they should stop once they're
             done compiling all pending shaders / PSOs.
 
@@ -125,6 +158,9 @@ namespace Ogre
         /// The actual work done by the job queues.
         void updateThread( size_t threadIdx, HlmsManager *hlmsManager );
 
+        /// The actual work done by each CompileTask.
+        void updateTask( CompileTask *compileTask );
+
         /// Similar to start() and stopAndWait() at the same time: It assumes all work has already been
         /// gathered in mRequests via pushWarmUpRequest() (instead of gather it as we go)
         /// and fires all threads to compile the shaders and PSOs in parallel.
@@ -171,6 +207,9 @@ namespace Ogre
     */
     class _OgreExport RenderQueue : public OgreAllocatedObj
     {
+        /// Lets the unit tests run the sort without a SceneManager
+        friend class RenderQueueSortTestAccess;
+
     public:
         enum Modes
         {
@@ -214,6 +253,8 @@ namespace Ogre
         struct ThreadRenderQueue
         {
             QueuedRenderableArray q;
+            /// Indices into q (before sorting) of the last sorted result. See setReuseSortOrder
+            FastArray<uint32> lastOrder;
             /// The padding prevents false cache sharing when multithreading.
             uint8 padding[128];
         };
@@ -226,9 +267,50 @@ namespace Ogre
             QueuedRenderableArray          mQueuedRenderables;
             RqSortMode                     mSortMode;
             bool                           mSorted;
+            bool                           mReuseSortOrder;
             Modes                          mMode;
 
-            RenderQueueGroup() : mSortMode( NormalSort ), mSorted( false ), mMode( FAST ) {}
+            RenderQueueGroup() :
+                mSortMode( NormalSort ),
+                mSorted( false ),
+                mReuseSortOrder( false ),
+                mMode( FAST )
+            {
+            }
+        };
+
+        struct SortKey
+        {
+            uint64 hash;
+            uint32 idx;
+        };
+        typedef std::vector<SortKey> SortKeyVec;
+
+        struct SortKeyFunctor
+        {
+            uint64 operator()( const SortKey &sortKey ) const { return sortKey.hash; }
+        };
+
+        /// Per worker thread scratch memory used while sorting
+        struct ThreadSortScratch
+        {
+            RadixSort<SortKeyVec, SortKey, uint64> radixSort;
+            SortKeyVec                             keys;
+            QueuedRenderableArray                  tmp;
+        };
+
+        /// Sorts each ThreadRenderQueue of mPendingSortRqs from its own worker thread
+        struct SortTask final : public UniformScalableTask
+        {
+            RenderQueue *renderQueue;
+            void         execute( size_t threadId, size_t numThreads ) override;
+        };
+
+        struct MergeHead
+        {
+            QueuedRenderable const *itor;
+            QueuedRenderable const *end;
+            size_t                  threadIdx;
         };
 
         typedef vector<IndirectBufferPacked *>::type IndirectBufferPackedVec;
@@ -270,6 +352,15 @@ namespace Ogre
 
         ParallelHlmsCompileQueue mParallelHlmsCompileQueue;
 
+        SortTask                       mSortTask;
+        FastArray<uint8>               mPendingSortRqs;
+        std::vector<ThreadSortScratch> mThreadSortScratch;
+        FastArray<MergeHead>           mMergeHeads;
+
+        GpuCulling *mGpuCulling;
+        uint8       mGpuCullingFirstRq;
+        uint8       mGpuCullingLastRq;
+
         /** Returns a new (or an existing) indirect buffer that can hold the requested number of
         draws.
         @param numDraws
@@ -299,13 +390,28 @@ namespace Ogre
                                   HlmsCache passCache[], const RenderQueueGroup &renderQueueGroup,
                                   ParallelHlmsCompileQueue *parallelCompileQueue,
                                   IndirectBufferPacked *indirectBuffer, unsigned char *indirectDraw,
-                                  unsigned char *startIndirectDraw );
+                                  unsigned char *startIndirectDraw, GpuCulling *gpuCulling );
         void renderGL3V1( RenderSystem *rs, bool casterPass, bool dualParaboloid, HlmsCache passCache[],
                           const RenderQueueGroup   &renderQueueGroup,
                           ParallelHlmsCompileQueue *parallelCompileQueue );
 
         void warmUpShaders( bool casterPass, const RenderQueueGroup &renderQueueGroup );
 
+        /// Sorts all of the per-thread queues of the RQs in range [firstRq; lastRq) that need it,
+        /// each thread's queue in a different worker thread
+        void sortPerThreadQueues( uint8 firstRq, uint8 lastRq );
+        /// Sorts threadQueue.q by hash (stable). See setReuseSortOrder
+        static void sortThreadQueue( ThreadRenderQueue &threadQueue, ThreadSortScratch &scratch,
+                                     bool reuseSortOrder );
+        /// Merges the already sorted per-thread queues into mQueuedRenderables (k-way merge)
+        /// mergeHeads is scratch memory.
+        static void mergeSortedThreadQueues( RenderQueueGroup     &renderQueueGroup,
+                                             FastArray<MergeHead> &mergeHeads );
+
+        /// Reports the textures of everything queued in [firstRq; lastRq) as used,
+        /// for TextureGpuManager::setPriorityStreaming. See HlmsDatablock::notifyTexturesUsed
+        void notifyTexturesUsed( uint8 firstRq, uint8 lastRq );
+
     public:
         RenderQueue( HlmsManager *hlmsManager, SceneManager *sceneManager, VaoManager *vaoManager );
         ~RenderQueue();
@@ -386,6 +492,24 @@ namespace Ogre
         void warmUpShadersCollect( uint8 firstRq, uint8 lastRq, bool casterPass );
         void warmUpShadersTrigger( RenderSystem *rs );
 
+        /** Queues the compilation of a PSO that was used in a previous session (see
+            HlmsDiskCache::warmUpPsos), even if no Renderable currently uses it.
+            Call warmUpShadersTrigger() afterwards to compile all queued PSOs.
+        @param hlms
+            Hlms the PSO belongs to. Must not be HLMS_LOW_LEVEL.
+        @param passCache
+            Pass cache as returned by Hlms::preparePassHash, rebuilt from the recorded pass.
+        @param renderableHash
+            As returned by Hlms::addRenderableCache.
+        @param recordedPso
+            Provides the macroblock, blendblock and vertex layout that would otherwise
+            come from the Renderable. Must stay alive until warmUpShadersTrigger() returns.
+        @return
+            False if the PSO already existed and nothing was queued.
+        */
+        bool warmUpRecordedPso( Hlms *hlms, const HlmsCache &passCache, uint32 renderableHash,
+                                const HlmsPso &recordedPso );
+
         void _warmUpShadersThread( size_t threadIdx );
 
         void _compileShadersThread( size_t threadIdx );
@@ -417,6 +541,150 @@ namespace Ogre
         */
         void       setSortRenderQueue( uint8 rqId, RqSortMode sortMode );
         RqSortMode getSortRenderQueue( uint8 rqId ) const;
+
+        /** Sorting normally radix sorts each worker thread's list and merges them.
+            When this setting is enabled, we first try to reorder the renderables using
+            the order from the last time this RQ was sorted and fix it with an insertion sort.
+            If that takes too much work (e.g. the visible set changed too much) we fall back
+            to the regular sort.
+        @remarks
+            This pays off when the same RQ is rendered from a camera whose visible set
+            barely changes from frame to frame. If the RQ gets rendered by multiple passes
+            with very different visible sets (e.g. shadow maps) the reordering will fail
+            most of the time and the attempt is wasted work.
+        @param rqId
+            ID of the render queue
+        @param bReuse
+            True to try to reuse last sort order. Default is false.
+        */
+        void setReuseSortOrder( uint8 rqId, bool bReuse );
+        bool getReuseSortOrder( uint8 rqId ) const;
+
+        /** Culls the FAST render queues in range [firstRq; lastRq) on the GPU instead of the CPU.
+        @remarks
+            The SceneManager skips the frustum planes test when culling those render queues
+            (visibility flags, rendering distance and LOD are still evaluated on the CPU).
+            Objects get tracked by the GpuCulling the first time they're drawn, and after that
+            the SceneManager only uploads the bounds of the ones that changed. Every indexed
+            draw gets its own entry in GpuCulling::getIndirectBuffer(), and the cull compute
+            job is dispatched right before executing the command buffer.
+            Thus culled objects still cost a (zero-instance) indirect draw, but no CPU time.
+        @par
+            Shadow caster passes, instanced stereo and RenderSystems without indirect buffers
+            keep using CPU culling.
+        @par
+            Because the frustum test is skipped on the CPU, the bounds of the visible objects
+            gathered for those render queues (e.g. used by focused shadow camera setups) cover
+            all of their objects.
+        @param gpuCulling
+            GpuCulling to use. Null to disable. The pointer must remain valid until disabled.
+            Use GpuCulling::setHiZTexture to enable occlusion culling.
+        @param firstRq
+            First render queue to cull on the GPU, inclusive.
+        @param lastRq
+            Last render queue to cull on the GPU, exclusive.
+        */
+        void        setGpuCulling( GpuCulling *gpuCulling, uint8 firstRq, uint8 lastRq );
+        GpuCulling *getGpuCulling() const { return mGpuCulling; }
+        uint8       getGpuCullingFirstRq() const { return mGpuCullingFirstRq; }
+        uint8       getGpuCullingLastRq() const { return mGpuCullingLastRq; }
+
+        /// Returns true if the given render queue will be culled by the GpuCulling
+        /// when rendering a pass of the given type. See setGpuCulling
+        bool isGpuCulled( uint8 rqId, bool casterPass ) const;
+
+        /** Stores the sorted contents of all FAST RQs in range [firstRq; lastRq) into the snapshot.
+            Must be called after render().
+        */
+        void _recordSnapshot( RenderQueueSnapshot &snapshot, uint8 firstRq, uint8 lastRq ) const;
+
+        /** Fills the FAST RQs with the contents stored in the snapshot. They're flagged as
+            sorted, so addRenderableV2 can't be called on them until clear() is called.
+            Must be called after clear().
+        */
+        void _restoreSnapshot( const RenderQueueSnapshot &snapshot );
+    };
+
+    /** Holds the (already sorted) contents of the RenderQueue::FAST render queues generated by
+        a scene pass, so they can be replayed in the following frames as long as the camera and
+        the objects in those render queues don't change.
+    @remarks
+        Replaying skips frustum culling, RenderQueue::addRenderableV2 and sorting of those
+        render queues. The rest of the render queues are processed as usual.
+        See CompositorPassSceneDef::mCacheRenderQueue.
+    @par
+        The snapshot is invalidated automatically when objects in the cached render queues are
+        created, destroyed, moved, their visibility changed or their world bounds were recalculated
+        (see ObjectMemoryManager::getChangeCounter); or when the camera or the pass settings change.
+    @par
+        Changes that are not tracked (e.g. calling setDatablock or setVisible on a SubItem directly,
+        or changing the sorting mode of a render queue) require calling invalidate() manually.
+    */
+    class _OgreExport RenderQueueSnapshot : public OgreAllocatedObj
+    {
+        friend class RenderQueue;
+
+    public:
+        /// Everything the recorded contents depend on. A snapshot recorded with a key
+        /// can only be replayed by a pass with an identical key.
+        struct Key
+        {
+            Matrix4 viewMatrix;
+            Matrix4 projectionMatrix;
+            Matrix4 lodViewMatrix;
+            /// See SceneManager::getRenderQueueChangeKey
+            uint64 changeKey;
+            uint32 visibilityMask;
+            uint8  firstRq;
+            uint8  lastRq;
+            bool   casterPass;
+            bool   reflected;
+
+            Key();
+
+            bool operator==( const Key &other ) const;
+        };
+
+    private:
+        struct Entry
+        {
+            uint8                       rqId;
+            FastArray<QueuedRenderable> queuedRenderables;
+        };
+
+        typedef vector<Entry>::type EntryVec;
+
+        EntryVec mEntries;
+        size_t   mNumEntries;
+
+        Key mKey;
+
+        bool mValid;
+        /// The next RenderQueue::render must be recorded into this snapshot
+        bool mPendingRecord;
+
+    public:
+        RenderQueueSnapshot();
+
+        /// Forces the next frame to perform culling, and record a new snapshot.
+        void invalidate();
+
+        /// True if there is a recorded snapshot that could be replayed.
+        bool isValid() const { return mValid; }
+
+        /** Checks whether the recorded contents can be replayed by a pass with the given key.
+            If they can't, the snapshot is invalidated and flagged to be recorded again
+            (with this key) by the next RenderQueue::render.
+        @return
+            True if the snapshot can be replayed.
+        */
+        bool _prepareReplay( const Key &key );
+
+        /// True if the next RenderQueue::render must be recorded into this snapshot.
+        bool _isPendingRecord() const { return mPendingRecord; }
+
+        /// Called by RenderQueue::_recordSnapshot once the contents have been recorded.
+        void _notifyRecorded();
     };
 
 #define OGRE_RQ_MAKE_MASK( x ) ( ( 1 << ( x ) ) - 1 )
@@ -65,6 +65,11 @@ namespace Ogre
                            CodecDataPtr &pData ) const override;
         /// @copydoc Codec::decode
         DecodeResult decode( DataStreamPtr &input ) const override;
+        /// @copydoc ImageCodec2::decodeStreaming
+        /// stb_image still decodes the whole image, but rows are handed out from its own
+        /// buffer, so RGB images are expanded to RGBA a batch at a time instead of copied.
+        bool decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                              uint32 maxRowsPerBatch = 64u ) const override;
 
         String getType() const override;
 
@@ -48,6 +48,7 @@ Torus Knot Software Ltd.
 #include "OgreResourceGroupManager.h"
 #include "OgreSceneQuery.h"
 #include "Threading/OgreThreads.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -83,6 +84,7 @@ namespace Ogre
     struct EntityMaterialLodChangedEvent;
     class CompositorShadowNode;
     class UniformScalableTask;
+    class RenderQueueSnapshot;
 
     class RadialDensityMask;
 
@@ -104,6 +106,9 @@ namespace Ogre
         /// Whether we should immediately add to render queue v2 objects
         bool addToRenderQueue;
         bool cullingLights;
+        /// Whether RQs in RenderQueue::FAST mode should be skipped because their
+        /// contents were restored from a RenderQueueSnapshot
+        bool skipFastRqs;
         /** Memory manager of the objects to cull. Could contain all Lights, all Entity, etc.
             Could be more than one depending on the high level cull system (i.e. tree-based sys)
             Must be const (it is read only for all threads).
@@ -120,6 +125,7 @@ namespace Ogre
             casterPass( false ),
             addToRenderQueue( true ),
             cullingLights( false ),
+            skipFastRqs( false ),
             objectMemManager( 0 ),
             camera( 0 ),
             lodCamera( 0 )
@@ -133,6 +139,7 @@ namespace Ogre
             casterPass( _casterPass ),
             addToRenderQueue( _addToRenderQueue ),
             cullingLights( _cullingLights ),
+            skipFastRqs( false ),
             objectMemManager( _objectMemManager ),
             camera( _camera ),
             lodCamera( _lodCamera )
@@ -433,6 +440,10 @@ namespace Ogre
         */
         bool mStaticEntitiesDirty;
 
+        /// One per mEntityMemoryManager. Null when scene query BVHs are disabled.
+        /// @see setSceneQueryBvhEnabled
+        SceneQueryBvh *mSceneQueryBvh[NUM_SCENE_MEMORY_MANAGER_TYPES];
+
         PrePassMode   mPrePassMode;
         TextureGpuVec mPrePassTextures;
         TextureGpu   *mPrePassDepthTexture;
@@ -800,12 +811,15 @@ namespace Ogre
         enum RequestType
         {
             CULL_FRUSTUM,
+            /// Adds the results of chunked CULL_FRUSTUM requests to the RenderQueue
+            COLLECT_CULLED_OBJECTS,
             UPDATE_ALL_ANIMATIONS,
             UPDATE_ALL_TRANSFORMS,
             UPDATE_ALL_BONE_TO_TAG_TRANSFORMS,
             UPDATE_ALL_TAG_ON_TAG_TRANSFORMS,
             UPDATE_ALL_BOUNDS,
             UPDATE_ALL_LODS,
+            UPDATE_SCENE_QUERY_BVH,
             BUILD_LIGHT_LIST01,
             BUILD_LIGHT_LIST02,
             WARM_UP_SHADERS,
@@ -832,6 +846,91 @@ namespace Ogre
         Barrier                      *mWorkerThreadsBarrier;
         ThreadHandleVec               mWorkerThreads;
 
+        /// Routes our requests (updateWorkerThreadImpl) through a TaskScheduler
+        struct WorkerThreadsTask final : public UniformScalableTask
+        {
+            SceneManager *sceneManager;
+            void          execute( size_t threadId, size_t numThreads ) override;
+        };
+
+        /// When not null, replaces mWorkerThreads. See setTaskScheduler
+        TaskScheduler    *mTaskScheduler;
+        WorkerThreadsTask mWorkerThreadsTask;
+        /// TaskScheduler::TaskId of the last request sent to mTaskScheduler
+        uint32 mPendingWorkerTask;
+
+        /// Contiguous range of nodes or objects processed by a single chunk of a ChunkedTask
+        struct WorkChunk
+        {
+            /// Used by UPDATE_ALL_*TRANSFORMS
+            Transform t;
+            /// Used by everything else
+            ObjectData           objData;
+            size_t               numElements;
+            ObjectMemoryManager *memoryManager;
+            uint8                renderQueue;
+            /// CULL_FRUSTUM: Whether the frustum test is performed by the GpuCulling
+            bool gpuCulled;
+            /// UPDATE_ALL_BOUNDS: Whether MovableObject::updateAllBounds changed anything
+            bool boundsChanged;
+        };
+
+        /** A request sent to mTaskScheduler split in chunks of at most mTaskChunkSize nodes
+            or objects, instead of one chunk per worker thread. Unlike mWorkerThreadsTask it
+            carries its own parameters, thus several of them can be in flight at the same time.
+            See fireChunkedTask.
+        */
+        struct ChunkedTask final : public UniformScalableTask
+        {
+            SceneManager        *sceneManager;
+            RequestType          requestType;
+            FastArray<WorkChunk> chunks;
+            /// UPDATE_ALL_BOUNDS: One per chunk when GPU culling is enabled, empty otherwise.
+            /// Objects tracked by the GpuCulling whose bounds changed
+            FastArray<MovableObject::MovableObjectArray> changedObjects;
+            void execute( size_t threadId, size_t numThreads ) override;
+        };
+
+        /// Pointers never change so the scheduler can hold them. [0; mNumChunkedTasks) are in use
+        FastArray<ChunkedTask *> mChunkedTasks;
+        size_t                   mNumChunkedTasks;
+        /// TaskScheduler::TaskId of mChunkedTasks[mNumChunkedTasks - 1u]
+        uint32 mLastChunkedTask;
+        /// See setTaskChunkSize
+        size_t mTaskChunkSize;
+        /// When true, updateAllTransforms & co. return without waiting for their ChunkedTasks.
+        /// Set by updateSceneGraph, which waits once after the bounds.
+        bool mChainChunkedTasks;
+
+        /// The CULL_FRUSTUM task being collected by COLLECT_CULLED_OBJECTS
+        ChunkedTask const *mCullTask;
+        /// Visible objects found by each chunk of mCullTask
+        FastArray<MovableObject::MovableObjectArray> mCullChunkVisibleObjects;
+        /// Computed once by fireChunkedCullFrustum. [0] is for render queues culled by the
+        /// GpuCulling, [1] for everything else
+        CullFrustumPreparedData mCullPreparedData[2];
+        uint32                  mCullVisibilityMask;
+
+        /// See setIncrementalTransformUpdates
+        bool mIncrementalTransformUpdates;
+
+        struct ChangedBoundsEntry
+        {
+            ObjectMemoryManager *memoryManager;
+            size_t               renderQueue;
+        };
+        typedef FastArray<ChangedBoundsEntry> ChangedBoundsEntryArray;
+
+        /// One per worker thread. Render queues whose bounds changed in
+        /// updateAllBoundsThread, to bump their ObjectMemoryManager::getChangeCounter
+        vector<ChangedBoundsEntryArray>::type mChangedBoundsPerThread;
+        /// One per worker thread. Objects tracked by the GpuCulling whose bounds
+        /// changed in updateAllBoundsThread
+        vector<MovableObject::MovableObjectArray>::type mChangedGpuCulledPerThread;
+
+        /// See _setRenderQueueSnapshot
+        RenderQueueSnapshot *mRenderQueueSnapshot;
+
         /** Contains MovableObjects to be visited and rendered.
         @rermarks
             Declared here to avoid allocating and deallocating every frame. Declared as array of
@@ -918,12 +1017,64 @@ namespace Ogre
         void updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
                                                 size_t                        threadIdx );
 
+        /// Appends to task.chunks the nodes in range [t; t + numNodes) in chunks of mTaskChunkSize
+        void addTransformChunks( ChunkedTask &task, Transform t, size_t numNodes );
+        /// Appends to task.chunks the objects in range [objData; objData + numObjs)
+        /// in chunks of mTaskChunkSize
+        void addObjectChunks( ChunkedTask &task, ObjectData objData, size_t numObjs,
+                              ObjectMemoryManager *memoryManager, uint8 renderQueue,
+                              bool gpuCulled = false );
+
+        /// Whether fine-grained ChunkedTasks should be used. See setTaskScheduler
+        bool useChunkedTasks() const { return mTaskScheduler && !mForceMainThread; }
+
+        /// Returns an unused ChunkedTask. It stays in use until waitForChunkedTasks
+        ChunkedTask &allocateChunkedTask( RequestType requestType );
+
+        /** Sends the task to mTaskScheduler without waiting. It won't start until the
+            previous ChunkedTask finished, thus consecutive phases (e.g. the transforms of
+            each hierarchy depth, then the bounds) run back to back in the worker threads
+            without returning to the main thread in between.
+        @param numChunks
+            Usually task.chunks.size(). Requests that still work per thread
+            (i.e. UPDATE_ALL_ANIMATIONS) use mNumWorkerThreads.
+        */
+        void fireChunkedTask( ChunkedTask &task, size_t numChunks );
+
+        /// Waits for all the ChunkedTasks in flight and bumps the change
+        /// counters of the render queues whose bounds they changed
+        void waitForChunkedTasks();
+
+        /// Executes a single chunk of a ChunkedTask
+        void executeChunk( ChunkedTask &task, size_t chunkIdx );
+
+        /// fireCullFrustumThreads when mTaskScheduler is set. Culls in chunks of mTaskChunkSize
+        /// objects, then adds the results to the RenderQueue in one chunk per worker thread
+        void fireChunkedCullFrustum( const CullFrustumRequest &request );
+        /// COLLECT_CULLED_OBJECTS. Same output cullFrustum would have produced in threadIdx.
+        void collectCulledObjects( const CullFrustumRequest &request, size_t threadIdx );
+
         /** Updates the world aabbs from the given request inside a thread. @see updateAllTransforms
         @param threadIdx
             Thread index so we know at which point we should start at.
             Must be unique for each worker thread
         */
         void updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager, size_t threadIdx );
+        /// Uploads the bounds of the given objects (collected by updateAllBounds) and clears the array
+        void updateGpuCulledObjects( GpuCulling *gpuCulling,
+                                     MovableObject::MovableObjectArray &changedObjects );
+
+        /// Returns a value that changes whenever an object in the FAST render queues
+        /// in range [firstRq; lastRq) changed. See ObjectMemoryManager::getChangeCounter
+        uint64 getRenderQueueChangeKey( uint8 firstRq, uint8 lastRq ) const;
+
+        /** Checks whether mRenderQueueSnapshot can be replayed for the given pass.
+            If it can't, prepares it to be recorded by _renderPhase02.
+        @return
+            True if the snapshot can be replayed.
+        */
+        bool prepareRenderQueueSnapshot( const Camera *cullCamera, const Camera *lodCamera,
+                                         uint8 firstRq, uint8 lastRq );
 
         /**
         @param threadIdx
@@ -932,6 +1083,13 @@ namespace Ogre
         */
         void updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx );
 
+        /** Refits or rebuilds the scene query BVHs flagged for update. @see updateSceneQueryBvh
+        @param threadIdx
+            Thread index so we know which trees we should process.
+            Must be unique for each worker thread
+        */
+        void updateSceneQueryBvhThread( size_t threadIdx );
+
         /** Low level culling, culls all objects against the given frustum active cameras. This
             includes checking visibility flags (both scene and viewport's)
             @see MovableObject::cullFrustum
@@ -1368,6 +1526,28 @@ namespace Ogre
         }
         ObjectMemoryManager &_getLightMemoryManager() { return mLightMemoryManager; }
 
+        /** Enables a Bounding Volume Hierarchy per entity memory manager & render queue that
+            DefaultRaySceneQuery, DefaultSphereSceneQuery and DefaultAxisAlignedBoxSceneQuery
+            use to avoid iterating through every MovableObject.
+        @remarks
+            The trees are refitted every frame in updateSceneGraph (right after updating the
+            world Aabbs), and fully rebuilt when objects are created, destroyed or moved;
+            which is why this is disabled by default: it only pays off when there are
+            many objects and queries are issued often.
+        @par
+            Queries issued before the trees are updated (e.g. after creating objects but before
+            the next updateSceneGraph) fall back to the linear search.
+        */
+        void setSceneQueryBvhEnabled( bool bEnabled );
+        bool getSceneQueryBvhEnabled() const { return mSceneQueryBvh[0] != 0; }
+
+        /// Returns the BVH of the given entity memory manager. Null if disabled.
+        /// @see setSceneQueryBvhEnabled
+        SceneQueryBvh *_getSceneQueryBvh( SceneMemoryMgrTypes sceneType ) const
+        {
+            return mSceneQueryBvh[sceneType];
+        }
+
         ObjectMemoryManager &_getParticleSysDefMemoryManager() { return mParticleSysDefMemoryManager; }
         ObjectMemoryManager &_getParticleSysMemoryManager() { return mParticleSysMemoryManager; }
 
@@ -1926,6 +2106,14 @@ namespace Ogre
         */
         void updateAllBounds( const ObjectMemoryManagerVec &objectMemManager );
 
+        /** Refits the scene query BVHs whose bounds were updated in this frame, and rebuilds
+            the ones whose layout changed. Does nothing if they are disabled.
+            Ought to be called right after updateAllBounds. @see setSceneQueryBvhEnabled
+        @remarks
+            @see updateAllTransforms remarks
+        */
+        void updateSceneQueryBvh();
+
         /** Updates the Lod values of all objects relative to the given camera.
          */
         void updateAllLods( const Camera *lodCamera, Real lodBias, uint8 firstRq, uint8 lastRq );
@@ -1977,6 +2165,17 @@ namespace Ogre
         virtual void _renderPhase02( Camera *camera, const Camera *lodCamera, uint8 firstRq,
                                      uint8 lastRq, bool includeOverlays );
 
+        /** Sets the snapshot the next _cullPhase01 & _renderPhase02 will replay (if still valid)
+            or record into. Set it to null after rendering.
+            See CompositorPassSceneDef::mCacheRenderQueue
+        @param snapshot
+            Snapshot to use. Can be null. Ignored by passes that reuse cull data.
+        */
+        void _setRenderQueueSnapshot( RenderQueueSnapshot *snapshot )
+        {
+            mRenderQueueSnapshot = snapshot;
+        }
+
         void cullLights( Camera *camera, Light::LightTypes startType, Light::LightTypes endType,
                          LightArray &outLights );
 
@@ -2293,6 +2492,17 @@ namespace Ogre
             certain objects; see SceneQuery for details.
         */
         virtual RaySceneQuery *createRayQuery( const Ray &ray, uint32 mask = QUERY_ENTITY_DEFAULT_MASK );
+        /** Creates a BatchRaySceneQuery for this scene manager.
+        @remarks
+            This method creates a new instance of a query object for casting many rays
+            at once, using the worker threads. See BatchRaySceneQuery for full details.
+        @par
+            The instance returned from this method must be destroyed by calling
+            SceneManager::destroyQuery when it is no longer required.
+        @param mask The query mask to apply to this query; can be used to filter out
+            certain objects; see SceneQuery for details.
+        */
+        virtual BatchRaySceneQuery *createBatchRayQuery( uint32 mask = QUERY_ENTITY_DEFAULT_MASK );
         // PyramidSceneQuery* createPyramidQuery(const Pyramid& p, unsigned long mask = 0xFFFFFFFF);
         /** Creates an IntersectionSceneQuery for this scene manager.
         @remarks
@@ -2697,6 +2907,10 @@ namespace Ogre
         IlluminationRenderStage _getCurrentRenderStage() const { return mIlluminationStage; }
 
     protected:
+        /// Sends mRequestType to the worker threads (or the TaskScheduler) without waiting
+        void fireWorkerThreads();
+        /// Waits for the request sent via fireWorkerThreads to finish
+        void waitForWorkerThreads();
         void fireWorkerThreadsAndWait();
 
         /** Launches cullFrustum on all worker threads with the requested parameters
@@ -2729,6 +2943,66 @@ namespace Ogre
         */
         void waitForPendingUserScalableTask();
 
+        /** Makes all the work normally sent to SceneManager's worker threads (culling, transform
+            & bounds updates, light lists, ParticleSystemManager2, ForwardClustered, user tasks
+            sent via executeUserScalableTask, etc) run in the given TaskScheduler instead.
+            SceneManager's own worker threads are stopped while a scheduler is set.
+        @remarks
+            Transform, bounds & LOD updates and frustum culling are split in chunks of
+            getTaskChunkSize() nodes or objects, no matter how many threads there are, so idle
+            threads can steal chunks from busy ones. updateSceneGraph sends the transforms,
+            skeletal animations, tag points and bounds as a chain of dependent tasks and only
+            waits once, at the end. Culling is followed by a dependent task that adds the
+            results to the RenderQueue.
+        @par
+            The rest of the requests (light lists, ParticleSystemManager2, ForwardClustered,
+            user tasks) keep their per-thread data, thus they are still split in
+            getNumWorkerThreads() chunks.
+        @par
+            Parallel shader compilation during RenderQueue::render is the exception: each
+            compile request is sent as a single-chunk task as it arrives (see
+            ParallelHlmsCompileQueue::pushRequest), so no scheduler thread sits waiting for work.
+        @par
+            The scheduler can be shared with other SceneManagers and with the user, but all of
+            them must issue work from the same thread.
+            If the SceneManager was created with 0 worker threads, this setting has no effect.
+        @param taskScheduler
+            Scheduler to use. Must outlive this SceneManager, or be unset first.
+            Null to go back to SceneManager's own worker threads.
+        */
+        void setTaskScheduler( TaskScheduler *taskScheduler );
+        TaskScheduler *getTaskScheduler() const { return mTaskScheduler; }
+
+        /** Max number of nodes or objects processed by each chunk when a TaskScheduler is set.
+            Smaller chunks balance better; bigger ones have less overhead.
+        @param chunkSize
+            Rounded up to a multiple of ARRAY_PACKED_REALS. Default is 512.
+        */
+        void   setTaskChunkSize( size_t chunkSize );
+        size_t getTaskChunkSize() const { return mTaskChunkSize; }
+
+        /** When enabled, updateSceneGraph skips the packs of ARRAY_PACKED_REALS nodes whose
+            local transforms and parents didn't change since the last update, and only
+            recalculates the world bounds of objects whose node (or local bounds) changed.
+            This is a big win in scenes where most nodes stay still most of the time.
+        @remarks
+            Disabled by default because the SoA memory can be written directly. When enabled:
+                - Whoever writes directly to a node's Transform (i.e. Node::_getTransform())
+                  must call Node::_setTransformDirty afterwards.
+                - Whoever writes directly to ObjectData::mLocalAabb or mLocalRadius must
+                  set ObjectData::mBoundsDirty. All MovableObjects in OgreMain already do.
+        @par
+            Skipping works per pack: if one node in the pack changed, the whole pack (and
+            all of its children) are updated.
+            Static nodes are only updated when the static scene is flagged as dirty, and their
+            children will be conservatively updated every frame after that.
+        */
+        void setIncrementalTransformUpdates( bool bEnabled )
+        {
+            mIncrementalTransformUpdates = bEnabled;
+        }
+        bool getIncrementalTransformUpdates() const { return mIncrementalTransformUpdates; }
+
         /** Called from the worker thread, polls to process frustum culling
             requests when a sync is performed
         */
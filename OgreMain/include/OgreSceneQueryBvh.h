@@ -0,0 +1,201 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreSceneQueryBvh_H_
+#define _OgreSceneQueryBvh_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Simple/OgreAabb.h"
+
+#include "ogrestd/vector.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    struct ObjectData;
+
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    /**
+    @class SceneQueryBvh
+        Bounding Volume Hierarchy built out of the world Aabbs stored in the ObjectData of
+        an ObjectMemoryManager. There is one tree per render queue.
+
+        The trees are used by DefaultRaySceneQuery, DefaultSphereSceneQuery and
+        DefaultAxisAlignedBoxSceneQuery to avoid testing every MovableObject linearly.
+
+        Each frame (after MovableObject::updateAllBounds) the trees are refitted. A tree gets
+        fully rebuilt when its layout changed (objects were created, destroyed, moved to another
+        render queue, or the memory got rebased/defragmented) or when refitting degraded
+        its quality too much.
+    @remarks
+        Leaves reference slots, not MovableObjects. Visibility & query flags are read from
+        the ObjectData at query time; thus changing them does not require a rebuild.
+    @par
+        Like the linear path, queries must be performed after SceneManager::updateSceneGraph
+        and before moving objects again. A tree whose layout doesn't match the memory
+        manager anymore is reported as out of date via isUpToDate, and the caller must fall back
+        to the linear search.
+    */
+    class _OgreExport SceneQueryBvh : public OgreAllocatedObj
+    {
+    public:
+        /// Max number of slots referenced by a leaf
+        static const uint32 MaxLeafSize = 4u;
+
+        struct Node
+        {
+            Vector3 vMin;
+            /// When count == 0 it's the index to the first child (the second one is right after).
+            /// Otherwise it's the index to the first entry in Tree::slots
+            uint32 firstIdx;
+            Vector3 vMax;
+            /// Number of slots in this leaf. 0 if it's an internal node
+            uint32 count;
+        };
+
+        typedef vector<Node>::type NodeVec;
+
+    protected:
+        struct Tree
+        {
+            /// Parents are always before their children, thus refitting
+            /// can be done by iterating in reverse order.
+            NodeVec              nodes;
+            vector<uint32>::type slots;
+            /// Owners at the time the tree was built, indexed by slot.
+            /// Used to detect slot reuse (object destroyed & another one created)
+            vector<MovableObject *>::type owners;
+            /// Base address of the ObjectData at build time (detects rebase)
+            MovableObject **ownerBase;
+            size_t          numSlots;
+            /// Sum of the surface area of all nodes when the tree was built
+            Real builtCost;
+            /// Whether SceneManager must refit or rebuild this tree in the next update
+            bool pendingUpdate;
+
+            vector<Vector3>::type tmpCentroids;
+
+            Tree();
+        };
+
+        typedef vector<Tree>::type TreeVec;
+
+        ObjectMemoryManager *mMemoryManager;
+        TreeVec              mTrees;
+
+        /// When refitting makes the tree cost grow beyond builtCost * mRebuildThreshold
+        /// the tree is rebuilt from scratch.
+        Real mRebuildThreshold;
+
+        /// Returns bounds enclosing both the world Aabb and the bounding sphere of the slot
+        static void getSlotBounds( const ObjectData &objData, size_t slot, Vector3 &outMin,
+                                   Vector3 &outMax );
+
+        static Real getSurfaceArea( const Node &node );
+
+        void rebuild( Tree &tree, const ObjectData &objData, size_t numSlots );
+        /// Returns false if the tree needs to be rebuilt
+        bool refit( Tree &tree, const ObjectData &objData );
+
+    public:
+        SceneQueryBvh( ObjectMemoryManager *memoryManager );
+        ~SceneQueryBvh();
+
+        ObjectMemoryManager *getMemoryManager() const { return mMemoryManager; }
+
+        /** When refitting makes the sum of the surface areas of all nodes bigger than
+            the one at build time multiplied by this threshold, the tree is rebuilt.
+        @param threshold
+            Must be >= 1. Default is 2.
+        */
+        void setRebuildThreshold( Real threshold );
+        Real getRebuildThreshold() const { return mRebuildThreshold; }
+
+        /// Returns true if the tree for the given render queue matches the current layout
+        /// of the memory manager and can be used to perform queries.
+        bool isUpToDate( size_t renderQueue ) const;
+
+        /** Main thread. Prepares the trees for _updateTree.
+        @param boundsUpdated
+            True if the world Aabbs of the memory manager were updated this frame.
+            When false, only trees whose layout changed will be updated.
+        @return
+            True if at least one tree needs _updateTree to be called.
+        */
+        bool _prepareForUpdate( bool boundsUpdated );
+
+        /// Number of trees (i.e. render queues) to iterate in _updateTree
+        size_t _getNumTrees() const { return mTrees.size(); }
+
+        /** Refits or rebuilds the tree of the given render queue, if it was flagged
+            by _prepareForUpdate. Different render queues can be updated from different
+            threads in parallel.
+        */
+        void _updateTree( size_t renderQueue );
+
+        /// Returns the nodes of the tree. Useful for debugging.
+        const NodeVec &getNodes( size_t renderQueue ) const { return mTrees[renderQueue].nodes; }
+
+        /** Returns all objects in the given render queue whose world Aabb intersects the given one.
+        @return
+            False if the listener requested to stop.
+        */
+        bool queryAabb( size_t renderQueue, const Aabb &aabb, uint32 queryMask,
+                        SceneQueryListener *listener ) const;
+
+        /** Returns all objects in the given render queue whose bounding sphere (world Aabb's
+            center and world radius) intersects the given sphere.
+        @return
+            False if the listener requested to stop.
+        */
+        bool querySphere( size_t renderQueue, const Sphere &sphere, uint32 queryMask,
+                          SceneQueryListener *listener ) const;
+
+        /** Returns all objects in the given render queue whose world Aabb is hit by the ray.
+            The distance is 0 if the ray's origin is inside the Aabb.
+        @return
+            False if the listener requested to stop.
+        */
+        bool queryRay( size_t renderQueue, const Ray &ray, uint32 queryMask,
+                       RaySceneQueryListener *listener ) const;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -982,6 +982,7 @@ namespace Ogre
                     ID_LOD_UPDATE_LIST,
                     ID_LOD_CAMERA,
                     ID_CULL_REUSE_DATA,
+                    ID_CACHE_RENDER_QUEUE,
                     ID_CULL_CAMERA,
                     ID_MATERIAL_SCHEME,
                     ID_VISIBILITY_MASK,
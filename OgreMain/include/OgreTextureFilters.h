@@ -59,6 +59,10 @@ namespace Ogre
             TypePrepareForNormalMapping         = 1u << 2u,
             TypeLeaveChannelR                   = 1u << 3u,
             TypePremultiplyAlpha                = 1u << 4u,
+            /// See CompressBCn
+            TypeCompressBCn                     = 1u << 5u,
+            /// Use BC7 instead of BC1/BC3 for RGBA8 textures. Requires TypeCompressBCn
+            TypeCompressBCnPreferBC7            = 1u << 6u,
             // clang-format on
 
             TypeGenerateDefaultMipmaps = TypeGenerateSwMipmaps | TypeGenerateHwMipmaps
@@ -157,6 +161,40 @@ namespace Ogre
         public:
             void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
         };
+        //-----------------------------------------------------------------------------------
+        /** Compresses uncompressed textures into BCn on the worker thread:
+                RGBA8 -> BC1 (if fully opaque), BC3, or BC7 with TypeCompressBCnPreferBC7
+                RG8   -> BC5
+                R8    -> BC4
+            Only 2D, 2D array & cubemap textures whose resolution is a multiple of 4 are
+            compressed, and only if the RenderSystem supports the BCn format.
+        @remarks
+            HW mipmap generation is not possible on compressed textures; thus when mipmaps
+            are requested they're generated in SW before compressing.
+        @par
+            Compression is slow. See TextureGpuManager::setBCnCompressionCache to store the
+            results on disk and pay the cost only once per asset.
+        */
+        class _OgreExport CompressBCn : public FilterBase
+        {
+            uint32 mFilters;
+
+            static String getCacheFilename( const Image2 &image, PixelFormatGpu dstFormat,
+                                            bool generateMipmaps );
+            static bool   loadFromCache( Archive *cache, const String &filename, Image2 &image,
+                                         PixelFormatGpu dstFormat );
+            static void   saveToCache( Archive *cache, const String &filename, const Image2 &image );
+
+        public:
+            CompressBCn( uint32 filters ) : mFilters( filters ) {}
+
+            /// Returns the BCn format srcFormat will be compressed to.
+            /// Returns srcFormat if it can't or won't be compressed.
+            static PixelFormatGpu getDestinationFormat( uint32 filters, const Image2 &image,
+                                                        PixelFormatGpu           srcFormat,
+                                                        const TextureGpuManager *textureManager );
+            void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
+        };
     }  // namespace TextureFilter
     /** @} */
     /** @} */
@@ -182,6 +182,17 @@ namespace Ogre
             ///
             /// This flag requires RenderToTexture.
             TilerMemoryless = 1u << 15u,
+            /// Allows this texture to be packed into a bigger TexturePool when its
+            /// resolution is small enough.
+            /// See TextureGpuManager::setAutoPackingMaxResolution.
+            ///
+            /// Only set it on textures whose consumers apply TextureGpu::getInternalUvScale
+            /// and getInternalUvOffset to their UVs (e.g. HlmsUnlit), and sample them with
+            /// TAM_CLAMP. HlmsPbs, Terra, decals and light masks
+            /// do not, and would sample outside the texture.
+            ///
+            /// This flag requires AutomaticBatching.
+            AllowAutoPacking = 1u << 16u,
             // clang-format on
         };
     }
@@ -476,6 +487,19 @@ namespace Ogre
 
         uint16 getInternalSliceStart() const;
 
+        /** Maps UVs of this texture to the TexturePool's slice:
+                sliceUv = uv * getInternalUvScale() + getInternalUvOffset()
+            Always (1, 1) unless the texture was packed into a bigger pool, which can
+            only happen with TextureFlags::AllowAutoPacking.
+            See TextureGpuManager::setAutoPackingMaxResolution.
+        @remarks
+            Packed textures live at the top-left of the slice. Their region is inset by half
+            a texel so that UVs in range [0; 1] never filter in texels outside the texture.
+        */
+        Vector2 getInternalUvScale() const;
+        /// See getInternalUvScale. Always (0, 0) unless the texture was packed.
+        Vector2 getInternalUvOffset() const;
+
         virtual void               setTextureType( TextureTypes::TextureTypes textureType );
         TextureTypes::TextureTypes getTextureType() const;
         TextureTypes::TextureTypes getInternalTextureType() const;
@@ -663,6 +687,7 @@ namespace Ogre
         bool isManualTexture() const;
         bool isPoolOwner() const;
         bool isDiscardableContent() const;
+        bool allowsAutoPacking() const;
         bool isTilerMemoryless() const { return ( mTextureFlags & TextureFlags::TilerMemoryless ) != 0; }
 
         /// OpenGL RenderWindows are a bit specific:
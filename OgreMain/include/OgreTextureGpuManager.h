@@ -38,13 +38,19 @@ THE SOFTWARE.
 #include "Threading/OgreLightweightMutex.h"
 #include "Threading/OgreSemaphore.h"
 #include "Threading/OgreThreads.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Threading/OgreWaitableEvent.h"
 
 #include "ogrestd/list.h"
 #include "ogrestd/map.h"
 #include "ogrestd/set.h"
 
+#ifdef OGRE_PROFILING_TEXTURES
+#    include "OgreTimer.h"
+#endif
+
 #include <atomic>
+#include <limits>
 
 #include "OgreHeaderPrefix.h"
 
@@ -122,6 +128,31 @@ namespace Ogre
         };
     }
 
+    namespace TextureLoadStage
+    {
+        /// Stages a texture goes through while being loaded.
+        /// See TextureGpuManager::getLoadingStats
+        enum TextureLoadStage
+        {
+            /// Opening the file (Worker thread). Most codecs read the file while decoding,
+            /// thus the actual reads are usually accounted in Decode
+            FileIo,
+            /// Parsing and decompressing the image (Worker thread)
+            Decode,
+            /// Running TextureFilter::FilterBase::_executeStreaming (Worker thread)
+            Filters,
+            /// Copying the image into the StagingTexture (Worker thread)
+            StagingCopy,
+            /// Copying from the StagingTexture to the final texture (Main thread)
+            GpuUpload,
+            /// Time the texture spent waiting in queues for the worker thread,
+            /// for a StagingTexture or for the main thread. It's derived as the
+            /// time from Resident to ReadyForRendering minus all other stages.
+            Waiting,
+            NumTextureLoadStages
+        };
+    }
+
     /**
     @class TextureGpuManager
         This class manages all textures (i.e. TextureGpu) since Ogre 2.2
@@ -238,7 +269,9 @@ namespace Ogre
         thread can keep executing your code (like moving on to the next Item
         or Datablock you're instantiating)
     */
-    class _OgreExport TextureGpuManager : public OgreAllocatedObj, public TextureGpuListener
+    class _OgreExport TextureGpuManager : public OgreAllocatedObj,
+                                          public TextureGpuListener,
+                                          public UniformScalableTaskExecutor
     {
     public:
         /// Specifies the minimum squared resolution & number of slices to keep around
@@ -264,6 +297,48 @@ namespace Ogre
 
         typedef vector<BudgetEntry>::type BudgetEntryVec;
 
+        /// Timings of a single texture. See TextureGpuManager::getLoadingStats
+        struct TextureLoadTimings
+        {
+            String name;
+            /// Microseconds spent on each TextureLoadStage
+            uint64 usStages[TextureLoadStage::NumTextureLoadStages];
+            /// Microseconds it took to go from Resident to ReadyForRendering
+            uint64 usTotal;
+            size_t sizeBytes;
+        };
+
+        typedef vector<TextureLoadTimings>::type TextureLoadTimingsVec;
+
+        struct LoadingStats
+        {
+            TextureLoadTimingsVec textures;
+            /// Sum of all textures' TextureLoadTimings::usStages
+            uint64 usStagesAccum[TextureLoadStage::NumTextureLoadStages];
+            uint64 usTotalAccum;
+
+            /// Largest number of load requests waiting for the worker thread
+            size_t maxPendingLoadRequests;
+            /// Largest number of images waiting for a StagingTexture to upload them
+            size_t maxQueuedImages;
+
+            /// Bytes of StagingTextures in use + available, sampled every _update
+            /// while there was streaming work.
+            size_t maxStagingTextureBytes;
+            uint64 accumStagingTextureBytes;
+            /// See setStagingTextureMaxBudgetBytes
+            size_t stagingTextureMaxBudgetBytes;
+            /// Bytes the worker thread preloaded in its last iteration
+            size_t maxPreloadedBytes;
+            uint64 accumPreloadedBytes;
+            /// See setWorkerThreadMaxPreloadBytes
+            size_t maxPreloadBytes;
+            uint32 numSamples;
+
+            LoadingStats();
+            void reset();
+        };
+
         struct MetadataCacheEntry
         {
             String                     aliasName;
@@ -407,13 +482,15 @@ namespace Ogre
             FilterBaseArray filters;
 #ifdef OGRE_PROFILING_TEXTURES
             uint64 microsecondsTaken;
+            /// Only the stages that run in the worker thread are filled
+            uint64 usStages[TextureLoadStage::NumTextureLoadStages];
 #endif
 
             QueuedImage( Image2 &srcImage, TextureGpu *_dstTexture, uint32 _dstSliceOrDepth,
                          FilterBaseArray &inOutFilters
 #ifdef OGRE_PROFILING_TEXTURES
                          ,
-                         uint64 _microsecondsTaken
+                         uint64 _microsecondsTaken, const uint64 *_usStages
 #endif
             );
             void  destroy();
@@ -426,6 +503,24 @@ namespace Ogre
 
         typedef vector<QueuedImage>::type QueuedImageVec;
 
+        /// Sorts streaming work when priority streaming is on. See setPriorityStreaming
+        struct StreamingPriorityCmp
+        {
+            uint32 frameCount;
+
+            StreamingPriorityCmp( uint32 _frameCount ) : frameCount( _frameCount ) {}
+
+            bool operator()( const TextureGpu *a, const TextureGpu *b ) const;
+            bool operator()( const LoadRequest &a, const LoadRequest &b ) const
+            {
+                return ( *this )( a.texture, b.texture );
+            }
+            bool operator()( const QueuedImage &a, const QueuedImage &b ) const
+            {
+                return ( *this )( a.dstTexture, b.dstTexture );
+            }
+        };
+
         /**
         @class PartialImage
             In certain cases, more than one QueuedImage is needed because the texture is being
@@ -553,9 +648,36 @@ namespace Ogre
         Semaphore                    mMultiLoadsSemaphore;
         std::atomic<uint32>          mPendingMultiLoads;
 
+        /// A UniformScalableTask the multiload threads help with while idle.
+        /// See executeUniformScalableTask()
+        struct HelperTask
+        {
+            UniformScalableTask *task;
+            size_t               numChunks;
+            std::atomic<size_t>  nextChunk;
+            /// How many threads were woken up to help. Protected by mMultiLoadsMutex
+            uint32 wakeTickets;
+            /// How many threads are currently helping. Protected by mMultiLoadsMutex
+            std::atomic<uint32> numHelpers;
+
+            HelperTask( UniformScalableTask *_task, size_t _numChunks ) :
+                task( _task ),
+                numChunks( _numChunks ),
+                nextChunk( 0u ),
+                wakeTickets( 0u ),
+                numHelpers( 0u )
+            {
+            }
+
+            /// Executes chunks until there are none left
+            void runChunks();
+        };
+        /// Protected by mMultiLoadsMutex
+        FastArray<HelperTask *> mHelperTasks;
+
         TexturePoolList  mTexturePool;
         ResourceEntryMap mEntries;
-        /// Protects mEntries
+        /// Protects mEntries & mMetadataCache
         mutable LightweightMutex mEntriesMutex;
 
         size_t mEntriesToProcessPerIteration;
@@ -570,7 +692,26 @@ namespace Ogre
 
         StagingTextureVec mTmpAvailableStagingTex;
 
+        /// Also protected by mEntriesMutex
         MetadataCacheMap mMetadataCache;
+        /// See setTextureMetadataCacheFile
+        String mMetadataCacheFile;
+
+        /// See setBCnCompressionCache
+        Archive *mBCnCompressionCache;
+
+        /// See setPriorityStreaming
+        bool   mPriorityStreaming;
+        size_t mStreamingVramBudget;
+        /// Textures we paged out to honour mStreamingVramBudget, to be
+        /// brought back once they get used again
+        set<TextureGpu *>::type mTexturesEvictedByBudget;
+
+        /// See setUseMemoryMappedFiles
+        bool mUseMemoryMappedFiles;
+
+        /// See setAutoPackingMaxResolution
+        uint32 mAutoPackingMaxResolution;
 
         typedef vector<AsyncTextureTicket *>::type AsyncTextureTicketVec;
         AsyncTextureTicketVec                      mAsyncTextureTickets;
@@ -645,8 +786,18 @@ namespace Ogre
         RenderSystem *mRenderSystem;
 
 #ifdef OGRE_PROFILING_TEXTURES
-        std::map<IdString, Timer> mProfilingData;
+        struct ProfilingEntry
+        {
+            Timer  timer;
+            uint64 usStages[TextureLoadStage::NumTextureLoadStages];
+            ProfilingEntry();
+        };
+        std::map<IdString, ProfilingEntry> mProfilingData;
 #endif
+        LoadingStats mLoadingStats;
+
+        /// Samples queue depths and staging memory into mLoadingStats
+        void sampleLoadingStats( size_t pendingLoadRequests );
 
         // Be able to hold up to a 2x2 cubemap RGBA8 for when a
         // image raises an exception in the worker thread
@@ -684,6 +835,13 @@ namespace Ogre
         /// Assumes we're protected by mMutex! Called from main thread.
         void fullfillBudget();
 
+        /// Assumes we're protected by mMutex! Called from main thread.
+        void sortStreamingByPriority();
+
+        /// Pages out least recently used textures when above mStreamingVramBudget,
+        /// and brings back those that got used again. Called from main thread.
+        void enforceStreamingVramBudget();
+
         /// Must be called from worker thread.
         void mergeUsageStatsIntoPrevStats();
 
@@ -707,6 +865,10 @@ namespace Ogre
         static void       processQueuedImage( QueuedImage &queuedImage, ThreadData &workerData,
                                               StreamingData &streamingData );
 
+        /// Returns true if the texture may be placed in a bigger TexturePool.
+        /// See setAutoPackingMaxResolution
+        static bool canAutoPack( const TextureGpu *texture );
+
         static void addTransitionToLoadedCmd( ObjCmdBuffer *commandBuffer, TextureGpu *texture,
                                               void *sysRamCopy, bool toSysRam );
 
@@ -755,6 +917,159 @@ namespace Ogre
         DefaultMipmapGen::DefaultMipmapGen getDefaultMipmapGeneration() const;
         DefaultMipmapGen::DefaultMipmapGen getDefaultMipmapGenerationCubemaps() const;
 
+        /** Sets the archive where TextureFilter::CompressBCn stores the results of compressing
+            textures to BCn, and where it looks for them before compressing.
+            Entries are keyed by a hash of the source pixels, thus editing a texture
+            automatically invalidates its entry.
+        @remarks
+            The archive is accessed from the worker thread(s). Don't change it while
+            textures are being streamed.
+            If the archive is read only, new results won't be stored.
+        @param cache
+            Archive to use. Null to disable the cache (default).
+        */
+        void     setBCnCompressionCache( Archive *cache );
+        Archive *getBCnCompressionCache() const { return mBCnCompressionCache; }
+
+        /** By default textures are streamed in the order they were requested. When priority
+            streaming is enabled, pending loads are sorted every _update so that textures used
+            (see GpuResource::notifyUsed) in the last frame go first, closest to the camera
+            first. Then come textures reported in older frames (most recently used first), and
+            last those no one ever reported, which keep their relative order.
+        @remarks
+            Like multiload, this means textures may finish loading out of order.
+            Feed it by calling notifyUsed every frame on the textures of visible objects
+            RenderQueue does it for the datablocks of the renderables it renders
+            (see HlmsDatablock::notifyTexturesUsed) while priority streaming is enabled.
+        @param bEnabled
+            True to enable.
+        @param vramBudgetBytes
+            When non-zero, and the textures loaded from file exceed this many bytes in VRAM, the
+            least recently used ones (that were reported via notifyUsed and haven't been used for
+            at least 2 frames) are paged out. Textures with GpuPageOutStrategy::Discard go back
+            to OnStorage, the rest to OnSystemRam.
+            Paged out textures are automatically made Resident again the next time they're used.
+        */
+        void   setPriorityStreaming( bool bEnabled, size_t vramBudgetBytes = 0u );
+        bool   getPriorityStreaming() const { return mPriorityStreaming; }
+        size_t getStreamingVramBudget() const { return mStreamingVramBudget; }
+
+        /// Streaming order of setPriorityStreaming. Returns true if a must be loaded before b.
+        /// T must have getLastFrameUsed & getLowestDistanceToCamera, like GpuResource.
+        template <typename T>
+        static bool _isStreamedBefore( const T &a, const T &b, uint32 frameCount )
+        {
+            const uint32 rankA = getStreamingRank( a, frameCount );
+            const uint32 rankB = getStreamingRank( b, frameCount );
+            if( rankA != rankB )
+                return rankA < rankB;
+            if( rankA == 0u )
+                return a.getLowestDistanceToCamera() < b.getLowestDistanceToCamera();
+            if( rankA == 1u )
+                return frameCount - a.getLastFrameUsed() < frameCount - b.getLastFrameUsed();
+            return false;
+        }
+
+        /// Returns true if the VRAM budget of setPriorityStreaming may page out a texture:
+        /// it must have been reported at some point, but not in the last 2 frames.
+        template <typename T>
+        static bool _isPageOutCandidate( const T &a, uint32 frameCount )
+        {
+            return a.getLowestDistanceToCamera() != std::numeric_limits<float>::max() &&
+                   frameCount - a.getLastFrameUsed() > 2u;
+        }
+
+        /// Returns true if candidate a must be paged out before b.
+        /// Least recently used first. On ties, farthest first.
+        template <typename T>
+        static bool _isPagedOutBefore( const T &a, const T &b )
+        {
+            if( a.getLastFrameUsed() != b.getLastFrameUsed() )
+                return a.getLastFrameUsed() < b.getLastFrameUsed();
+            return a.getLowestDistanceToCamera() > b.getLowestDistanceToCamera();
+        }
+
+    private:
+        /// 0 = used in the current or previous frame (we may run before the user notifies us),
+        /// 1 = reported in an older frame, 2 = never reported. See _isStreamedBefore
+        template <typename T>
+        static uint32 getStreamingRank( const T &a, uint32 frameCount )
+        {
+            if( a.getLowestDistanceToCamera() == std::numeric_limits<float>::max() )
+                return 2u;
+            return frameCount - a.getLastFrameUsed() <= 1u ? 0u : 1u;
+        }
+
+    public:
+
+        /** When true, OITD and DDS textures living in a FileSystem archive are memory mapped
+            by the worker thread instead of being read into a heap Image2. When the file's
+            contents already match the GPU layout (always for OITD; for DDS when it's not a
+            cubemap, doesn't need decompression, and has no row padding) the mips are copied
+            straight from the mapped pages into the StagingTexture, saving one allocation and
+            one full copy per texture.
+        @remarks
+            Disabled by default. Falls back to regular loading when mapping fails, when
+            a loading listener is installed, or when the PremultiplyAlpha filter is requested.
+            Don't change it while textures are being streamed.
+        */
+        void setUseMemoryMappedFiles( bool bUseMemoryMappedFiles );
+        bool getUseMemoryMappedFiles() const { return mUseMemoryMappedFiles; }
+
+        /** Textures with TextureFlags::AutomaticBatching normally only share a TexturePool with
+            textures of the exact same resolution and mipmap count. Thousands of small UI icons
+            of slightly different sizes thus end up in hundreds of nearly empty pools, each one
+            needing its own descriptor and breaking batches.
+
+            When enabled, batched textures created with TextureFlags::AllowAutoPacking whose
+            width and height are both <= maxResolution are placed in pools rounded up to the
+            next power of 2 in each axis (e.g. 20x30 and 32x24 both go to a 32x32 pool).
+            Each texture lives at the top-left of its slice, and TextureGpu::getInternalUvScale
+            & getInternalUvOffset map UVs to the portion of the slice it covers.
+        @remarks
+            Packing is opt-in per texture because only HlmsUnlit applies the UV transform.
+            HlmsPbs, Terra, decals and light masks don't, so never set
+            TextureFlags::AllowAutoPacking on textures they may use.
+
+            Packed textures can only be sampled with TAM_CLAMP. When streamed, the rest of
+            their slice is filled by repeating their last column and row, so bilinear
+            filtering at every mip behaves like clamping the texture on its own.
+
+            A pool always has the same number of mipmaps as the textures it holds, so every
+            mip of the pool gets written. Textures with mipmaps are only packed if every mip
+            keeps the same proportion of the slice, i.e. their width and height are multiples
+            of 2^(numMipmaps - 1). Compressed formats and textures that keep a system RAM copy
+            are never packed. Intended for UI, sprites and the like.
+
+            Packed textures are also placed in pools created with reservePoolId whose
+            resolution is either the texture's own or the rounded up one.
+            Must be set before textures are loaded.
+        @param maxResolution
+            0 to disable (default).
+        */
+        void   setAutoPackingMaxResolution( uint32 maxResolution );
+        uint32 getAutoPackingMaxResolution() const { return mAutoPackingMaxResolution; }
+
+        /// Resolution of the TexturePool a texture with TextureFlags::AutomaticBatching is
+        /// created in. Its own resolution, or rounded up to the next power of 2 when packed.
+        static void _getPoolResolutionFor( uint32 width, uint32 height, uint8 numMipmaps,
+                                           bool allowAutoPacking, uint32 autoPackingMaxResolution,
+                                           uint32 &outWidth, uint32 &outHeight );
+
+        /// Returns true if a texture fits in a pool with the given resolution and mipmaps.
+        /// The pixel format and pool ID must be checked separately.
+        static bool _isPoolCompatible( uint32 poolWidth, uint32 poolHeight, uint8 poolNumMipmaps,
+                                       uint32 width, uint32 height, uint8 numMipmaps,
+                                       bool allowAutoPacking, uint32 autoPackingMaxResolution );
+
+        /** Fills the part of the box outside [0; usedWidth) x [0; usedHeight) by repeating
+            the last column and row of that region. Used on the mips of packed textures.
+            See setAutoPackingMaxResolution.
+        @param box
+            Uncompressed 2D box to pad.
+        */
+        static void _padPackedTexture( const TextureBox &box, uint32 usedWidth, uint32 usedHeight );
+
         /** When false, TextureFlags::TilerMemoryless will be ignored (including implicit MSAA surfaces).
             Useful if you're rendering a heavy scene and run out of tile memory on mobile / TBDR.
         @param bAllowMemoryLess
@@ -793,6 +1108,10 @@ namespace Ogre
         unsigned long _updateStreamingWorkerThread( ThreadHandle *threadHandle );
 
     protected:
+        /// Opens loadRequest.name from loadRequest.archive, memory mapped if possible and
+        /// requested (see setUseMemoryMappedFiles). May throw.
+        DataStreamPtr openFromArchive( const LoadRequest &loadRequest );
+
         /// This function processes a load request coming from main thread. It basically
         /// gets called once per Image to load. Usually that means once per texture,
         /// but in the case of Cubemaps being made up from multiple separate images,
@@ -1074,6 +1393,44 @@ namespace Ogre
                                          bool bCreateReservedPools );
         void exportTextureMetadataCache( String &outJson );
 
+        /** Binary counterpart of exportTextureMetadataCache. The format is compact and meant to
+            be read back by the same build of Ogre on the same machine (it is native endian),
+            typically as a startup cache. Use the JSON version for anything else.
+        @param outData [out]
+            Serialized cache. Existing contents are overwritten.
+        */
+        void exportTextureMetadataCacheBinary( vector<uint8>::type &outData ) const;
+
+        /** Binary counterpart of importTextureMetadataCache.
+            Entries are read in place from data, so this is very fast even with tens of
+            thousands of textures; and all reserved pools are created in a single pass.
+        @param data
+            Data written by exportTextureMetadataCacheBinary.
+        @return
+            False if the data is not a valid cache (wrong version, truncated, etc). In that case
+            nothing is imported. Caches are disposable, so this is not treated as an error.
+        */
+        bool importTextureMetadataCacheBinary( const void *data, size_t sizeBytes,
+                                               bool bCreateReservedPools );
+
+        /// Memory maps the file and calls importTextureMetadataCacheBinary.
+        /// Returns false if the file doesn't exist or isn't a valid cache.
+        bool loadTextureMetadataCacheBinary( const String &fullPath, bool bCreateReservedPools );
+        /// Writes exportTextureMetadataCacheBinary to the file. Returns false on I/O failure
+        bool saveTextureMetadataCacheBinary( const String &fullPath ) const;
+
+        /** Sets a binary metadata cache to warm-start from. The file is loaded immediately
+            (if it exists; see loadTextureMetadataCacheBinary) and it is automatically written
+            back when the TextureGpuManager gets destroyed, so the next run starts with every
+            texture's metadata known and every reserved pool already created.
+        @remarks
+            Call this right after initialization, before creating textures.
+        @param fullPath
+            Path in the filesystem. Empty to disable (default).
+        */
+        void setTextureMetadataCacheFile( const String &fullPath, bool bCreateReservedPools = true );
+        const String &getTextureMetadataCacheFile() const { return mMetadataCacheFile; }
+
         void getMemoryStats( size_t &outTextureBytesCpu, size_t &outTextureBytesGpu,
                              size_t &outUsedStagingTextureBytes,
                              size_t &outAvailableStagingTextureBytes );
@@ -1136,6 +1493,15 @@ namespace Ogre
         */
         void setMultiLoadPool( uint32 numThreads );
 
+        /** Implements UniformScalableTaskExecutor by lending the threads from setMultiLoadPool
+            to the caller, e.g. so that Image2::generateMipmaps can split its work.
+        @remarks
+            The calling thread always participates. If there is no multiload pool, or the pool
+            threads are all busy loading textures, the task simply runs on the calling thread.
+            Safe to call from any thread, including the streaming and multiload threads.
+        */
+        void executeUniformScalableTask( UniformScalableTask *task, size_t numChunks ) override;
+
         /** Background streaming works by having a bunch of preallocated StagingTextures so
             we're ready to start uploading as soon as we see a request to load a texture
             from file.
@@ -1307,6 +1673,45 @@ namespace Ogre
         bool getProfileLoadingTime() const { return false; }
 #endif
 
+        /** Returns the timings gathered while setProfileLoadingTime is enabled:
+            per texture & per stage timings (see TextureLoadStage), queue depths
+            and staging memory utilization.
+        @remarks
+            Only textures that were uploaded to the GPU by the worker thread
+            (i.e. not the ones loaded to OnSystemRam) are recorded.
+            Always empty if Ogre wasn't compiled with OGRE_PROFILING_TEXTURES
+        */
+        const LoadingStats &getLoadingStats() const { return mLoadingStats; }
+
+        void resetLoadingStats();
+
+        /** Dumps getLoadingStats as CSV strings, in the same format OfflineProfiler uses.
+        @param outCsvPerTexture [out]
+            One row per texture with the milliseconds spent on each stage.
+        @param outCsvAccum [out]
+            One row per stage with the accumulated milliseconds and its % of the total.
+        */
+        void dumpLoadingStatsStr( String &outCsvPerTexture, String &outCsvAccum ) const;
+
+        /// Dumps getLoadingStats as a JSON string
+        void dumpLoadingStatsJson( String &outJson ) const;
+
+        /** Writes the output of dumpLoadingStatsStr & dumpLoadingStatsJson to disk.
+        @param fullPathPerTexture
+            Full path to the per-texture CSV. Leave empty to skip.
+        @param fullPathAccum
+            Full path to the per-stage CSV. Leave empty to skip.
+        @param fullPathJson
+            Full path to the JSON file. Leave empty to skip.
+        */
+        void dumpLoadingStats( const String &fullPathPerTexture, const String &fullPathAccum,
+                               const String &fullPathJson = BLANKSTRING ) const;
+
+        /// Adds the time spent on a stage to the texture being profiled.
+        /// Called by ObjCmdBuffer from the main thread.
+        void _addLoadingStageTime( TextureGpu *texture, TextureLoadStage::TextureLoadStage stage,
+                                   uint64 microseconds );
+
         /// This function CAN be called from any thread
         const String *findAliasNameStr( IdString idName ) const;
         /// This function CAN be called from any thread
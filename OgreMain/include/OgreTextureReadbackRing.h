@@ -0,0 +1,220 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreTextureReadbackRing_H_
+#define _OgreTextureReadbackRing_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+#include "OgreTextureBox.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreSemaphore.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
+
+#include "ogrestd/deque.h"
+#include "ogrestd/vector.h"
+
+#include <atomic>
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    class _OgreExport TextureReadbackListener
+    {
+    public:
+        virtual ~TextureReadbackListener();
+
+        /** Called when the contents of a texture sent via TextureReadbackRing::readback are
+            available in CPU memory.
+        @remarks
+            When TextureReadbackRing was created with worker threads, this function gets called
+            from those worker threads (possibly more than one at the same time).
+            Otherwise it gets called from TextureReadbackRing::poll or flush.
+        @param box
+            The downloaded data. It's only valid until this function returns.
+        @param pixelFormat
+            Pixel format of the data in box.
+        @param frameId
+            The value that was passed to TextureReadbackRing::readback.
+        */
+        virtual void readbackFinished( const TextureBox &box, PixelFormatGpu pixelFormat,
+                                       uint64 frameId ) = 0;
+    };
+
+    /** Keeps a ring of AsyncTextureTickets so that textures (e.g. a render target every frame)
+        can be continuously downloaded to the CPU without ever stalling the GPU.
+
+        Each call to readback() grabs the next free ticket and issues the download; poll()
+        checks the oldest in-flight tickets and delivers the finished ones in issue order
+        via TextureReadbackListener. Tickets are recycled automatically once delivered.
+    @remarks
+        AsyncTextureTicket::map & unmap must happen on the main thread. When worker threads
+        are requested, the mapped data is copied as is into a CPU buffer owned by the slot, the
+        ticket is unmapped and recycled right away, and a worker thread converts the data to the
+        destination pixel format (if needed) and invokes the listener. This keeps expensive work
+        such as pixel format conversion or encoding to disk off the main thread.
+    @par
+        readback(), poll() and flush() must all be called from the main thread.
+    */
+    class _OgreExport TextureReadbackRing : public OgreAllocatedObj
+    {
+    protected:
+        enum SlotState
+        {
+            SlotFree,
+            /// The ticket has a pending download.
+            SlotDownloading,
+            /// The ticket is free again, but a worker thread is still using cpuData.
+            SlotProcessing
+        };
+
+        struct Slot
+        {
+            AsyncTextureTicket *ticket;
+            uint64              frameId;
+            /// Data handed to the listener, in the destination format
+            uint8     *cpuData;
+            TextureBox cpuBox;
+            /// Unconverted copy of the ticket's data, for a worker thread to convert
+            /// into cpuData. Only used with worker threads & a destination format
+            uint8             *rawData;
+            TextureBox         rawBox;
+            std::atomic<uint8> state;
+
+            Slot();
+        };
+
+        TextureGpuManager       *mTextureManager;
+        TextureReadbackListener *mListener;
+
+        Slot  *mSlots;
+        size_t mNumSlots;
+        /// Next slot to be used by readback()
+        size_t mNextSlot;
+        /// Oldest slot in SlotDownloading state (if mNumDownloading > 0)
+        size_t mOldestSlot;
+        size_t mNumDownloading;
+
+        PixelFormatGpu mSrcPixelFormat;
+        PixelFormatGpu mDstPixelFormat;
+
+        ThreadHandleVec     mWorkerThreads;
+        LightweightMutex    mJobMutex;
+        deque<Slot *>::type mJobs;
+        Semaphore           mJobsAvailable;
+        WaitableEvent       mJobFinished;
+        std::atomic<size_t> mNumPendingJobs;
+        std::atomic<bool>   mExitThreads;
+
+        /// Maps the ticket from the given slot (stalling if it isn't ready yet) and
+        /// either delivers it to the listener or hands it to a worker thread.
+        void processSlot( Slot &slot );
+
+        /// Issues the download of the texture into the slot's ticket
+        virtual void downloadToSlot( Slot &slot, TextureGpu *texture, uint8 mipLevel );
+
+        /// Waits until the worker threads processed all the slots handed to them.
+        void waitForWorkers();
+
+    public:
+        /**
+        @param textureManager
+            Manager used to create and destroy the AsyncTextureTickets.
+        @param width
+            Width of the region to download. Textures passed to readback() must match.
+        @param height
+            Height of the region to download. Textures passed to readback() must match.
+        @param pixelFormat
+            Pixel format of the textures that will be passed to readback().
+        @param numTickets
+            Number of downloads that can be in flight. 3 is usually enough to never stall.
+        @param listener
+            Listener that will receive the data. Can't be null.
+        @param numWorkerThreads
+            When 0, the listener is called from poll() & flush() with the mapped
+            ticket data directly (unless dstPixelFormat needs a conversion).
+        @param dstPixelFormat
+            Pixel format the data is converted to before being sent to the listener.
+            PFG_UNKNOWN to leave the data as is. Compressed formats aren't supported.
+        */
+        TextureReadbackRing( TextureGpuManager *textureManager, uint32 width, uint32 height,
+                             PixelFormatGpu pixelFormat, size_t numTickets,
+                             TextureReadbackListener *listener, size_t numWorkerThreads = 0u,
+                             PixelFormatGpu dstPixelFormat = PFG_UNKNOWN );
+        virtual ~TextureReadbackRing();
+
+        /** Issues an async download of the given texture. Never stalls.
+        @param texture
+            Texture to download. Its resolution at the given mip must match the one
+            this ring was created with.
+        @param frameId
+            Arbitrary value handed back to the listener to identify this download.
+        @param mipLevel
+            Mip level to download.
+        @return
+            False if all tickets are still in flight (or being processed by workers)
+            in which case nothing is downloaded. Either skip this frame or call poll().
+        */
+        bool readback( TextureGpu *texture, uint64 frameId, uint8 mipLevel = 0u );
+
+        /** Delivers all the downloads that have finished, in the same order they were issued.
+            Never stalls.
+        @return
+            Number of downloads that were delivered (or handed to a worker thread).
+        */
+        size_t poll();
+
+        /// Delivers all pending downloads, stalling if necessary, and waits for
+        /// the worker threads to finish processing them.
+        void flush();
+
+        /// Number of downloads issued that haven't been delivered yet.
+        size_t getNumInFlight() const { return mNumDownloading; }
+        size_t getNumTickets() const { return mNumSlots; }
+
+        /// Entry point of the worker threads. For internal use.
+        unsigned long _updateWorkerThread( ThreadHandle *threadHandle );
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
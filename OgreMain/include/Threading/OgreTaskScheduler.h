@@ -0,0 +1,193 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreTaskScheduler_H_
+#define _OgreTaskScheduler_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreSemaphore.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include "ogrestd/deque.h"
+#include "ogrestd/vector.h"
+
+#include <atomic>
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** A work-stealing task scheduler.
+
+        Tasks are UniformScalableTasks split into an arbitrary number of chunks. Each chunk
+        calls UniformScalableTask::execute( chunkIdx, numChunks ). Unlike SceneManager's
+        barrier-based worker threads, the number of chunks is not tied to the number of threads:
+        splitting the work in more chunks than threads lets idle threads steal chunks from busy
+        ones, so a single slow chunk no longer stalls everyone else.
+
+        Tasks may depend on other tasks. A task won't start until all of its dependencies
+        finished, which allows building graphs (e.g. transforms -> bounds -> culling) that
+        run without returning to the calling thread in between.
+    @remarks
+        addTask, waitFor & waitForAll must always be called from the same thread (usually the
+        main thread). That thread helps executing chunks while it waits.
+    @par
+        Tasks must not call addTask or wait on other tasks from within execute().
+    @par
+        The scheduler can be shared by SceneManager (see SceneManager::setTaskScheduler), and
+        thus by ParticleSystemManager2, ForwardClustered and user tasks sent via
+        SceneManager::executeUserScalableTask; as well as directly by the user.
+    */
+    class _OgreExport TaskScheduler : public OgreAllocatedObj, public UniformScalableTaskExecutor
+    {
+    public:
+        /// Monotonically increasing. Ids from tasks that were recycled are always
+        /// considered finished.
+        typedef uint32 TaskId;
+
+    protected:
+        struct WorkItem
+        {
+            uint32 taskIdx;
+            uint32 chunkIdx;
+        };
+
+        struct Task
+        {
+            UniformScalableTask *task;
+            uint32               numChunks;
+            std::atomic<uint32>  pendingChunks;
+            std::atomic<bool>    finished;
+            /// Protected by mGraphMutex
+            uint32 pendingDependencies;
+            /// Protected by mGraphMutex
+            vector<uint32>::type dependents;
+
+            Task();
+        };
+
+        struct WorkerQueue
+        {
+            LightweightMutex      mutex;
+            deque<WorkItem>::type items;
+        };
+
+        /// Index 0 is reserved for the thread calling addTask/waitFor.
+        /// Worker thread i uses mQueues[i + 1]
+        WorkerQueue *mQueues;
+        size_t       mNumQueues;
+
+        Task  *mTasks;
+        uint32 mMaxTasks;
+        uint32 mNumTasks;
+        /// Id of mTasks[0]
+        TaskId mFirstTaskId;
+
+        std::atomic<uint32> mNumUnfinishedTasks;
+
+        LightweightMutex mGraphMutex;
+
+        Semaphore         mWakeUpWorkers;
+        std::atomic<bool> mExitThreads;
+        ThreadHandleVec   mWorkerThreads;
+
+        std::atomic<uint32> mNumStolenChunks;
+
+        /// Must be called while holding mGraphMutex
+        void enqueueChunks( uint32 taskIdx );
+        void onTaskFinished( uint32 taskIdx );
+
+        bool popOrSteal( size_t queueIdx, WorkItem &outItem );
+        void executeWorkItem( const WorkItem &item );
+
+        /// Recycles all tasks. All of them must be finished
+        void resetGraph();
+
+    public:
+        /**
+        @param numWorkerThreads
+            Number of threads to spawn. The thread calling waitFor also executes chunks,
+            thus a value of PlatformInformation::getNumLogicalCores() - 1 is usually a good fit.
+            Can be 0, in which case everything runs in waitFor.
+        @param maxTasks
+            Max number of tasks alive at the same time. Finished tasks are recycled
+            automatically once all tasks are finished.
+        */
+        TaskScheduler( size_t numWorkerThreads, uint32 maxTasks = 1024u );
+        ~TaskScheduler() override;
+
+        size_t getNumWorkerThreads() const { return mWorkerThreads.size(); }
+
+        /** Schedules a task.
+        @param task
+            Task to run. Pointer must remain valid until the task is finished.
+        @param numChunks
+            Number of chunks to split the task in. The task's execute() will be called
+            numChunks times, with threadId in range [0; numChunks) and numThreads = numChunks.
+            Use more chunks than threads for better load balancing.
+        @param dependencies
+            Array of tasks that must finish before this one starts. Can be null.
+        @param numDependencies
+            Number of elements in the dependencies array.
+        @return
+            Id of the new task, to be used with waitFor or as a dependency.
+        */
+        TaskId addTask( UniformScalableTask *task, size_t numChunks, const TaskId *dependencies = 0,
+                        size_t numDependencies = 0u );
+
+        /// Returns false if addTask would throw because maxTasks tasks are still in flight.
+        bool canAddTask() const;
+
+        bool isTaskFinished( TaskId taskId ) const;
+
+        /// Blocks until the given task is finished. The calling thread executes chunks
+        /// (of any task) while waiting.
+        void waitFor( TaskId taskId );
+
+        /// Blocks until all tasks are finished.
+        void waitForAll();
+
+        /// UniformScalableTaskExecutor override. Same as waitFor( addTask( task, numChunks ) ),
+        /// thus it must be called from the same thread as addTask.
+        void executeUniformScalableTask( UniformScalableTask *task, size_t numChunks ) override;
+
+        /// Number of chunks executed by a thread other than the one they were assigned to.
+        /// Useful for profiling.
+        uint32 getNumStolenChunks() const { return mNumStolenChunks.load( std::memory_order_relaxed ); }
+
+        /// Worker thread entry point. Don't call directly.
+        unsigned long _updateWorkerThread( ThreadHandle *threadHandle );
+    };
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
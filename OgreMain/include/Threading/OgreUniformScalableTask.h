@@ -55,6 +55,23 @@ namespace Ogre
         */
         virtual void execute( size_t threadId, size_t numThreads ) = 0;
     };
+
+    /** Something that can run a UniformScalableTask split in chunks, possibly across
+        multiple threads. Used by code that is not tied to a SceneManager (e.g. see
+        Image2::generateMipmaps) to borrow threads from whoever owns them.
+        See TextureGpuManager and TaskScheduler.
+    */
+    class _OgreExport UniformScalableTaskExecutor
+    {
+    public:
+        virtual ~UniformScalableTaskExecutor() {}
+
+        /** Calls task->execute( chunkIdx, numChunks ) for every chunkIdx in range
+            [0; numChunks) and returns once all of them finished.
+            The calling thread may execute chunks too.
+        */
+        virtual void executeUniformScalableTask( UniformScalableTask *task, size_t numChunks ) = 0;
+    };
 };  // namespace Ogre
 
 #endif
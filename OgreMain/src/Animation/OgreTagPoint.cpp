@@ -171,6 +171,10 @@ namespace Ogre
             }
 #endif
 
+            // Always recalculated, let our children know
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                t.mDirtyFlags[j] = TransformDirtyFlags::DerivedChanged;
+
             t.advancePack();
         }
     }
@@ -218,6 +222,10 @@ namespace Ogre
             }
 #endif
 
+            // Always recalculated, let our children know
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                t.mDirtyFlags[j] = TransformDirtyFlags::DerivedChanged;
+
             t.advancePack();
         }
     }
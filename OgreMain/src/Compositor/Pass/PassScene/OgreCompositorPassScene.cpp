@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "OgreHlms.h"
 #include "OgreHlmsManager.h"
 #include "OgrePixelFormatGpuUtils.h"
+#include "OgreRenderQueue.h"
 #include "OgreSceneManager.h"
 #include "OgreViewport.h"
 
@@ -57,7 +58,8 @@ namespace Ogre
         mSsrTexture( 0 ),
         mDepthTextureNoMsaa( 0 ),
         mRefractionsTexture( 0 ),
-        mHlmsManager( Root::getSingleton().getHlmsManager() )
+        mHlmsManager( Root::getSingleton().getHlmsManager() ),
+        mRenderQueueSnapshot( 0 )
     {
         initialize( rtv );
 
@@ -137,9 +139,22 @@ namespace Ogre
 
         if( mDefinition->mRefractionsTexture != IdString() )
             mRefractionsTexture = parentNode->getDefinedTexture( mDefinition->mRefractionsTexture );
+
+        if( mDefinition->mCacheRenderQueue && !mDefinition->mReuseCullData )
+            mRenderQueueSnapshot = OGRE_NEW RenderQueueSnapshot();
     }
     //-----------------------------------------------------------------------------------
-    CompositorPassScene::~CompositorPassScene() {}
+    CompositorPassScene::~CompositorPassScene()
+    {
+        OGRE_DELETE mRenderQueueSnapshot;
+        mRenderQueueSnapshot = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void CompositorPassScene::invalidateRenderQueueSnapshot()
+    {
+        if( mRenderQueueSnapshot )
+            mRenderQueueSnapshot->invalidate();
+    }
     //-----------------------------------------------------------------------------------
     void CompositorPassScene::notifyPassSceneAfterShadowMapsListeners()
     {
@@ -301,6 +316,7 @@ namespace Ogre
                                        mSsrTexture );
         sceneManager->_setRefractions( mDepthTextureNoMsaa, mRefractionsTexture );
         sceneManager->_setCurrentCompositorPass( this );
+        sceneManager->_setRenderQueueSnapshot( mRenderQueueSnapshot );
 
         viewport->_updateCullPhase01( mCamera, mCullCamera, usedLodCamera, mDefinition->mFirstRQ,
                                       mDefinition->mLastRQ, mDefinition->mReuseCullData );
@@ -313,6 +329,8 @@ namespace Ogre
         viewport->_updateRenderPhase02( mCamera, usedLodCamera, mDefinition->mFirstRQ,
                                         mDefinition->mLastRQ );
 
+        sceneManager->_setRenderQueueSnapshot( 0 );
+
         if( mDefinition->mCameraCubemapReorient )
         {
             // Restore orientation
@@ -0,0 +1,598 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Compute/OgreGpuCulling.h"
+
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "OgreCamera.h"
+#include "OgreHlmsCompute.h"
+#include "OgreHlmsComputeJob.h"
+#include "OgreMovableObject.h"
+#include "OgreProfiler.h"
+#include "OgreRenderSystem.h"
+#include "OgreTextureGpu.h"
+#include "Vao/OgreIndirectBufferPacked.h"
+#include "Vao/OgreUavBufferPacked.h"
+#include "Vao/OgreVaoManager.h"
+
+namespace Ogre
+{
+    static_assert( sizeof( GpuCulling::ObjectBounds ) == 32u,
+                   "ObjectBounds must match the std430 layout used by the shaders" );
+    static_assert( sizeof( CbDrawIndexed ) == 5u * sizeof( uint32 ),
+                   "CbDrawIndexed must match the layout expected by the APIs' indirect draws" );
+    static_assert( sizeof( GpuCulling::DrawEntry ) == 6u * sizeof( uint32 ),
+                   "DrawEntry must match the layout used by the shaders" );
+
+    /// Dirty slots (or draws) closer than this are uploaded in the same call,
+    /// as a few redundant bytes are cheaper than an extra upload
+    static const uint32 c_maxDirtySlotGap = 8u;
+
+    GpuCulling::GpuCulling( HlmsCompute *hlmsCompute, VaoManager *vaoManager ) :
+        mHlmsCompute( hlmsCompute ),
+        mVaoManager( vaoManager ),
+        mNumObjects( 0u ),
+        mNumDraws( 0u ),
+        mAllDrawsDirty( false ),
+        mObjectBoundsBuffer( 0 ),
+        mDrawEntriesBuffer( 0 ),
+        mCulledDrawArgsBuffer( 0 ),
+        mIndirectBuffer( 0 ),
+        mHiZ( 0 )
+    {
+        memset( mFrustumPlanes, 0, sizeof( mFrustumPlanes ) );
+    }
+    //-------------------------------------------------------------------------
+    GpuCulling::~GpuCulling()
+    {
+        // Objects may outlive us
+        vector<SlotInfo>::type::const_iterator itor = mSlots.begin();
+        vector<SlotInfo>::type::const_iterator endt = mSlots.end();
+
+        while( itor != endt )
+        {
+            if( itor->owner )
+            {
+                itor->owner->mGpuCulling = 0;
+                itor->owner->mGpuCullingSlot = InvalidSlot;
+            }
+            ++itor;
+        }
+
+        destroyBuffers();
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::destroyDrawBuffers()
+    {
+        if( mIndirectBuffer )
+        {
+            mVaoManager->destroyIndirectBuffer( mIndirectBuffer );
+            mIndirectBuffer = 0;
+        }
+        if( mCulledDrawArgsBuffer )
+        {
+            mVaoManager->destroyUavBuffer( mCulledDrawArgsBuffer );
+            mCulledDrawArgsBuffer = 0;
+        }
+        if( mDrawEntriesBuffer )
+        {
+            mVaoManager->destroyUavBuffer( mDrawEntriesBuffer );
+            mDrawEntriesBuffer = 0;
+        }
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::destroyBuffers()
+    {
+        destroyDrawBuffers();
+        if( mObjectBoundsBuffer )
+        {
+            mVaoManager->destroyUavBuffer( mObjectBoundsBuffer );
+            mObjectBoundsBuffer = 0;
+        }
+    }
+    //-------------------------------------------------------------------------
+    GpuCulling::ObjectBounds GpuCulling::packObjectBounds( const Aabb &aabb, uint32 visibilityFlags )
+    {
+        ObjectBounds retVal;
+        retVal.center[0] = static_cast<float>( aabb.mCenter.x );
+        retVal.center[1] = static_cast<float>( aabb.mCenter.y );
+        retVal.center[2] = static_cast<float>( aabb.mCenter.z );
+        retVal.visibilityFlags = visibilityFlags;
+        retVal.halfSize[0] = static_cast<float>( aabb.mHalfSize.x );
+        retVal.halfSize[1] = static_cast<float>( aabb.mHalfSize.y );
+        retVal.halfSize[2] = static_cast<float>( aabb.mHalfSize.z );
+        retVal.padding = 0u;
+        return retVal;
+    }
+    //-------------------------------------------------------------------------
+    bool GpuCulling::isVisible( const ObjectBounds &bounds, const Plane *planes,
+                                uint32 visibilityMask )
+    {
+        if( !( bounds.visibilityFlags & visibilityMask ) )
+            return false;
+
+        for( size_t i = 0; i < 6u; ++i )
+        {
+            const Vector3 &n = planes[i].normal;
+            const Real dist = n.x * bounds.center[0] + n.y * bounds.center[1] +
+                              n.z * bounds.center[2] + planes[i].d;
+            const Real maxAbsDist = Math::Abs( n.x ) * bounds.halfSize[0] +
+                                    Math::Abs( n.y ) * bounds.halfSize[1] +
+                                    Math::Abs( n.z ) * bounds.halfSize[2];
+            if( dist < -maxAbsDist )
+                return false;
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    GpuCulling::ObjectBounds GpuCulling::packTrackedObject( const MovableObject *movableObject )
+    {
+        const ObjectData &objData = movableObject->mObjectData;
+        // Keep the user bits, which is what the visibility mask is tested against,
+        // and LAYER_VISIBILITY so that this bit can be used to skip the test
+        const uint32 gpuFlags = objData.mVisibilityFlags[objData.mIndex] &
+                                ( VisibilityFlags::RESERVED_VISIBILITY_FLAGS |
+                                  VisibilityFlags::LAYER_VISIBILITY );
+        return packObjectBounds( objData.mWorldAabb->getAsAabb( objData.mIndex ), gpuFlags );
+    }
+    //-------------------------------------------------------------------------
+    uint32 GpuCulling::trackObject( const MovableObject *movableObject )
+    {
+        if( movableObject->mGpuCulling == this )
+            return movableObject->mGpuCullingSlot;
+
+        if( movableObject->mGpuCulling )
+            movableObject->mGpuCulling->untrackObject( movableObject );
+
+        uint32 slot;
+        if( !mFreeSlots.empty() )
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32>( mSlots.size() );
+            SlotInfo slotInfo;
+            slotInfo.owner = 0;
+            slotInfo.dirty = false;
+            mSlots.push_back( slotInfo );
+            mObjectBounds.push_back( packObjectBounds( Aabb::BOX_ZERO, 0u ) );
+        }
+
+        mSlots[slot].owner = movableObject;
+        mObjectBounds[slot] = packTrackedObject( movableObject );
+        markDirty( slot );
+
+        movableObject->mGpuCulling = this;
+        movableObject->mGpuCullingSlot = slot;
+        ++mNumObjects;
+
+        return slot;
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::untrackObject( const MovableObject *movableObject )
+    {
+        if( movableObject->mGpuCulling != this )
+            return;
+
+        // No draw can reference a free slot, thus there is no need to upload it
+        const uint32 slot = movableObject->mGpuCullingSlot;
+        mSlots[slot].owner = 0;
+        mFreeSlots.push_back( slot );
+        --mNumObjects;
+
+        movableObject->mGpuCulling = 0;
+        movableObject->mGpuCullingSlot = InvalidSlot;
+    }
+    //-------------------------------------------------------------------------
+    bool GpuCulling::updateObject( const MovableObject *movableObject )
+    {
+        if( movableObject->mGpuCulling != this )
+            return false;
+
+        const uint32 slot = movableObject->mGpuCullingSlot;
+        const ObjectBounds bounds = packTrackedObject( movableObject );
+
+        // The SceneManager reports whole SIMD blocks. Skip the objects in them that didn't change
+        if( memcmp( &mObjectBounds[slot], &bounds, sizeof( bounds ) ) == 0 )
+            return false;
+
+        mObjectBounds[slot] = bounds;
+        markDirty( slot );
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::markDirty( uint32 slot )
+    {
+        if( !mSlots[slot].dirty )
+        {
+            mSlots[slot].dirty = true;
+            mDirtySlots.push_back( slot );
+        }
+    }
+    //-------------------------------------------------------------------------
+    GpuCulling::ChangeCounters &GpuCulling::getChangeCounters(
+        const ObjectMemoryManager &memoryManager )
+    {
+        // There are very few memory managers. A linear search is fine
+        vector<ChangeCounters>::type::iterator itor = mChangeCounters.begin();
+        vector<ChangeCounters>::type::iterator endt = mChangeCounters.end();
+
+        while( itor != endt && itor->memoryManager != &memoryManager )
+            ++itor;
+
+        if( itor == endt )
+        {
+            ChangeCounters changeCounters;
+            changeCounters.memoryManager = &memoryManager;
+            mChangeCounters.push_back( changeCounters );
+            itor = mChangeCounters.end() - 1u;
+        }
+
+        return *itor;
+    }
+    //-------------------------------------------------------------------------
+    size_t GpuCulling::gatherObjects( ObjectMemoryManager &memoryManager, size_t firstRq,
+                                      size_t lastRq )
+    {
+        OgreProfile( "GpuCulling::gatherObjects" );
+
+        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+        firstRq = std::min( firstRq, numRenderQueues );
+        lastRq = std::min( lastRq, numRenderQueues );
+
+        vector<uint32>::type &changeCounters = getChangeCounters( memoryManager ).perRenderQueue;
+        while( changeCounters.size() < numRenderQueues )
+        {
+            // Never seen before. Force a walk
+            changeCounters.push_back( ~memoryManager.getChangeCounter( changeCounters.size() ) );
+        }
+
+        size_t numNewObjects = 0u;
+
+        for( size_t rq = firstRq; rq < lastRq; ++rq )
+        {
+            const uint32 changeCounter = memoryManager.getChangeCounter( rq );
+            if( changeCounters[rq] == changeCounter )
+            {
+                // Nothing was created, destroyed, moved or changed visibility in this
+                // render queue; and no bounds changed. Thus there's nothing new
+                continue;
+            }
+            changeCounters[rq] = changeCounter;
+
+            ObjectData objData;
+            const size_t totalObjs = memoryManager.getFirstObjectData( objData, rq );
+
+            for( size_t i = 0; i < totalObjs; i += ARRAY_PACKED_REALS )
+            {
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    // Empty slots have mVisibilityFlags = 0. Tracked objects
+                    // are kept up to date by updateObject
+                    MovableObject *owner = objData.mOwner[j];
+                    if( ( objData.mVisibilityFlags[j] & VisibilityFlags::LAYER_VISIBILITY ) &&
+                        owner->mGpuCulling != this )
+                    {
+                        trackObject( owner );
+                        ++numNewObjects;
+                    }
+                }
+
+                objData.advancePack();
+            }
+        }
+
+        return numNewObjects;
+    }
+    //-------------------------------------------------------------------------
+    uint32 GpuCulling::getSlot( const MovableObject *movableObject ) const
+    {
+        return movableObject->mGpuCulling == this ? movableObject->mGpuCullingSlot : InvalidSlot;
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::reserveDraws( size_t maxDraws )
+    {
+        if( mDrawEntriesBuffer && mDrawEntriesBuffer->getNumElements() >= maxDraws )
+            return;
+
+        destroyDrawBuffers();
+
+        // Round up to avoid frequent reallocations when a few draws are added
+        const size_t capacity = alignToNextMultiple<size_t>( std::max<size_t>( maxDraws, 1u ),
+                                                             ThreadsPerGroup );
+        const size_t capacityDrawArgsUints = capacity * sizeof( CbDrawIndexed ) / sizeof( uint32 );
+
+        mDrawEntriesBuffer =
+            mVaoManager->createUavBuffer( capacity, sizeof( DrawEntry ), BB_FLAG_UAV, 0, false );
+        mCulledDrawArgsBuffer = mVaoManager->createUavBuffer( capacityDrawArgsUints, sizeof( uint32 ),
+                                                              BB_FLAG_UAV, 0, false );
+        mIndirectBuffer = mVaoManager->createIndirectBuffer( capacity * sizeof( CbDrawIndexed ),
+                                                             BT_DEFAULT, 0, false );
+        mAllDrawsDirty = true;
+    }
+    //-------------------------------------------------------------------------
+    uint32 GpuCulling::addDraw( uint32 slot, const CbDrawIndexed &drawArgs )
+    {
+        OGRE_ASSERT_LOW( slot < mSlots.size() && mSlots[slot].owner && "Invalid slot" );
+        DrawEntry drawEntry;
+        drawEntry.drawArgs = drawArgs;
+        drawEntry.slot = slot;
+
+        const uint32 drawIdx = static_cast<uint32>( mNumDraws++ );
+        if( drawIdx == mDraws.size() )
+        {
+            mDraws.push_back( drawEntry );
+            mDirtyDraws.push_back( drawIdx );
+        }
+        else if( memcmp( &mDraws[drawIdx], &drawEntry, sizeof( drawEntry ) ) != 0 )
+        {
+            // Else it's the same draw as in the previous pass (the usual case),
+            // which is already in GPU memory
+            mDraws[drawIdx] = drawEntry;
+            mDirtyDraws.push_back( drawIdx );
+        }
+
+        return drawIdx;
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::upload()
+    {
+        OgreProfile( "GpuCulling::upload" );
+
+        const size_t numSlots = mSlots.size();
+
+        if( numSlots && ( !mObjectBoundsBuffer || mObjectBoundsBuffer->getNumElements() < numSlots ) )
+        {
+            if( mObjectBoundsBuffer )
+                mVaoManager->destroyUavBuffer( mObjectBoundsBuffer );
+
+            // Round up to avoid frequent reallocations when a few objects are added
+            const size_t capacity = alignToNextMultiple<size_t>( numSlots, ThreadsPerGroup );
+            mObjectBoundsBuffer = mVaoManager->createUavBuffer( capacity, sizeof( ObjectBounds ),
+                                                                BB_FLAG_UAV, 0, false );
+            // The new buffer holds garbage. Free slots are never referenced by a draw,
+            // but it's simpler to upload everything
+            mObjectBoundsBuffer->upload( &mObjectBounds[0], 0u, numSlots );
+
+            vector<uint32>::type::const_iterator itor = mDirtySlots.begin();
+            vector<uint32>::type::const_iterator endt = mDirtySlots.end();
+            while( itor != endt )
+                mSlots[*itor++].dirty = false;
+            mDirtySlots.clear();
+        }
+        else if( !mDirtySlots.empty() )
+        {
+            std::sort( mDirtySlots.begin(), mDirtySlots.end() );
+
+            vector<uint32>::type::const_iterator itor = mDirtySlots.begin();
+            vector<uint32>::type::const_iterator endt = mDirtySlots.end();
+
+            while( itor != endt )
+            {
+                // Coalesce nearby slots into a single upload
+                const uint32 rangeStart = *itor;
+                uint32 rangeEnd = rangeStart + 1u;
+                mSlots[*itor].dirty = false;
+                ++itor;
+                while( itor != endt && *itor - rangeEnd <= c_maxDirtySlotGap )
+                {
+                    rangeEnd = *itor + 1u;
+                    mSlots[*itor].dirty = false;
+                    ++itor;
+                }
+
+                mObjectBoundsBuffer->upload( &mObjectBounds[rangeStart], rangeStart,
+                                             rangeEnd - rangeStart );
+            }
+
+            mDirtySlots.clear();
+        }
+
+        if( mNumDraws )
+        {
+            OGRE_ASSERT_LOW( mDrawEntriesBuffer &&
+                             mDrawEntriesBuffer->getNumElements() >= mNumDraws &&
+                             "Call reserveDraws() first!" );
+
+            if( mAllDrawsDirty )
+            {
+                // Draws kept from previous passes are compared against by addDraw,
+                // thus they must be in GPU memory too
+                mDrawEntriesBuffer->upload( &mDraws[0], 0u, mDraws.size() );
+                mDirtyDraws.clear();
+                mAllDrawsDirty = false;
+            }
+            else if( !mDirtyDraws.empty() )
+            {
+                // Draws of several passes may be dirty if upload() wasn't called in between
+                std::sort( mDirtyDraws.begin(), mDirtyDraws.end() );
+                mDirtyDraws.erase( std::unique( mDirtyDraws.begin(), mDirtyDraws.end() ),
+                                   mDirtyDraws.end() );
+
+                vector<uint32>::type::iterator itor = mDirtyDraws.begin();
+                vector<uint32>::type::iterator endt = mDirtyDraws.end();
+
+                while( itor != endt && *itor < mNumDraws )
+                {
+                    // Coalesce nearby draws into a single upload
+                    const uint32 rangeStart = *itor;
+                    uint32 rangeEnd = rangeStart + 1u;
+                    ++itor;
+                    while( itor != endt && *itor < mNumDraws &&
+                           *itor - rangeEnd <= c_maxDirtySlotGap )
+                    {
+                        rangeEnd = *itor + 1u;
+                        ++itor;
+                    }
+
+                    mDrawEntriesBuffer->upload( &mDraws[rangeStart], rangeStart,
+                                                rangeEnd - rangeStart );
+                }
+
+                // Draws past mNumDraws stay dirty until a pass uses them again
+                mDirtyDraws.erase( mDirtyDraws.begin(), itor );
+            }
+        }
+    }
+    //-------------------------------------------------------------------------
+    void GpuCulling::cull( const Camera *camera, TextureGpu *hiZ, uint32 visibilityMask )
+    {
+        const size_t numDraws = mNumDraws;
+        if( !numDraws )
+            return;
+
+        OGRE_ASSERT_LOW( mObjectBoundsBuffer && mObjectBoundsBuffer->getNumElements() >= mSlots.size() &&
+                         mDirtySlots.empty() && !mAllDrawsDirty && "Call upload() first!" );
+
+        HlmsComputeJob *job = mHlmsCompute->findComputeJobNoThrow( "Compute/Tools/GpuCulling" );
+
+        if( !job )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "To use GpuCulling, Ogre must be build with JSON support "
+                         "and you must include the resources bundled at "
+                         "Samples/Media/Compute/Tools",
+                         "GpuCulling::cull" );
+        }
+
+        OgreProfileGpuBegin( "GpuCulling::cull" );
+
+        DescriptorSetUav::BufferSlot bufferSlot( DescriptorSetUav::BufferSlot::makeEmpty() );
+        bufferSlot.buffer = mObjectBoundsBuffer;
+        bufferSlot.access = ResourceAccess::Read;
+        job->_setUavBuffer( 0, bufferSlot );
+        bufferSlot.buffer = mDrawEntriesBuffer;
+        bufferSlot.access = ResourceAccess::Read;
+        job->_setUavBuffer( 1, bufferSlot );
+        bufferSlot.buffer = mCulledDrawArgsBuffer;
+        bufferSlot.access = ResourceAccess::Write;
+        job->_setUavBuffer( 2, bufferSlot );
+
+        job->setProperty( "use_hiz", hiZ ? 1 : 0 );
+        job->setNumTexUnits( hiZ ? 1u : 0u );
+        if( hiZ )
+        {
+            DescriptorSetTexture2::TextureSlot texSlot(
+                DescriptorSetTexture2::TextureSlot::makeEmpty() );
+            texSlot.texture = hiZ;
+            job->setTexture( 0, texSlot );
+        }
+
+        const Plane *planes = camera->getFrustumPlanes();
+        for( size_t i = 0; i < 6u; ++i )
+        {
+            mFrustumPlanes[i * 4u + 0u] = static_cast<float>( planes[i].normal.x );
+            mFrustumPlanes[i * 4u + 1u] = static_cast<float>( planes[i].normal.y );
+            mFrustumPlanes[i * 4u + 2u] = static_cast<float>( planes[i].normal.z );
+            mFrustumPlanes[i * 4u + 3u] = static_cast<float>( planes[i].d );
+        }
+
+        RenderSystem *renderSystem = mHlmsCompute->getRenderSystem();
+
+        ShaderParams &shaderParams = job->getShaderParams( "default" );
+        shaderParams.mParams.clear();
+
+        ShaderParams::Param param;
+        param.name = "frustumPlanes";
+        param.setManualValueEx( mFrustumPlanes, 6u * 4u );
+        shaderParams.mParams.push_back( param );
+
+        const uint32 numDraws_visibilityMask[2] = { static_cast<uint32>( numDraws ), visibilityMask };
+        param.name = "numDraws_visibilityMask";
+        param.setManualValue( numDraws_visibilityMask, 2u );
+        shaderParams.mParams.push_back( param );
+
+        if( hiZ )
+        {
+            const Matrix4 viewProjMatrix =
+                camera->getProjectionMatrixWithRSDepth() * camera->getViewMatrix( true );
+            param.name = "viewProjMatrix";
+            param.setManualValue( viewProjMatrix );
+            shaderParams.mParams.push_back( param );
+
+            // Converts NDC depth to [0; 1]. OpenGL may be in range [-1; 1]
+            const float depthScale = renderSystem->getRSDepthRange() == 2.0f ? 0.5f : 1.0f;
+            const float hiZParams[4] = { static_cast<float>( hiZ->getWidth() ),
+                                         static_cast<float>( hiZ->getHeight() ),
+                                         static_cast<float>( hiZ->getNumMipmaps() - 1u ),
+                                         depthScale };
+            param.name = "hiZSize_maxMip_depthScale";
+            param.setManualValue( hiZParams, 4u );
+            shaderParams.mParams.push_back( param );
+
+            param.name = "reverseDepth";
+            param.setManualValue( static_cast<uint32>( renderSystem->isReverseDepth() ? 1u : 0u ) );
+            shaderParams.mParams.push_back( param );
+        }
+
+        shaderParams.setDirty();
+
+        job->setNumThreadGroups(
+            static_cast<uint32>( ( numDraws + ThreadsPerGroup - 1u ) / ThreadsPerGroup ), 1u, 1u );
+
+        job->analyzeBarriers( mResourceTransitions );
+        renderSystem->executeResourceTransition( mResourceTransitions );
+        mHlmsCompute->dispatch( job, 0, 0 );
+
+        // Indirect buffers can't be written by compute shaders in all APIs; thus we copy them
+        mCulledDrawArgsBuffer->copyTo( mIndirectBuffer, 0u, 0u,
+                                       numDraws * sizeof( CbDrawIndexed ) / sizeof( uint32 ) );
+
+        OgreProfileGpuEnd( "GpuCulling::cull" );
+    }
+    //-------------------------------------------------------------------------
+    size_t GpuCulling::cullOnCpu( const Camera *camera, uint32 visibilityMask )
+    {
+        return cullOnCpu( camera->getFrustumPlanes(), visibilityMask );
+    }
+    //-------------------------------------------------------------------------
+    size_t GpuCulling::cullOnCpu( const Plane *planes, uint32 visibilityMask )
+    {
+        OgreProfile( "GpuCulling::cullOnCpu" );
+
+        const size_t numDraws = mNumDraws;
+        mCpuCulledDrawArgs.resize( numDraws );
+
+        size_t numVisible = 0u;
+        for( size_t i = 0u; i < numDraws; ++i )
+        {
+            mCpuCulledDrawArgs[i] = mDraws[i].drawArgs;
+            if( isVisible( mObjectBounds[mDraws[i].slot], planes, visibilityMask ) )
+                ++numVisible;
+            else
+                mCpuCulledDrawArgs[i].instanceCount = 0u;
+        }
+
+        return numVisible;
+    }
+}  // namespace Ogre
@@ -0,0 +1,44 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre4d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include <OgreStableHeaders.h>
+
+#include "Math/Array/OgreArrayVector2.h"
+
+#if __OGRE_HAVE_SSE && OGRE_USE_SIMD_AVX2 == 1
+
+namespace Ogre
+{
+    const ArrayVector2 ArrayVector2::ZERO( _mm256_setzero_ps(), _mm256_setzero_ps() );
+    const ArrayVector2 ArrayVector2::UNIT_X( _mm256_set1_ps( 1.0f ), _mm256_setzero_ps() );
+    const ArrayVector2 ArrayVector2::UNIT_Y( _mm256_setzero_ps(), _mm256_set1_ps( 1.0f ) );
+    const ArrayVector2 ArrayVector2::NEGATIVE_UNIT_X( _mm256_set1_ps( -1.0f ), _mm256_setzero_ps() );
+    const ArrayVector2 ArrayVector2::NEGATIVE_UNIT_Y( _mm256_setzero_ps(), _mm256_set1_ps( -1.0f ) );
+    const ArrayVector2 ArrayVector2::UNIT_SCALE( _mm256_set1_ps( 1.0f ), _mm256_set1_ps( 1.0f ) );
+}  // namespace Ogre
+#endif
@@ -56,6 +56,8 @@ namespace Ogre
             OGRE_MALLOC_SIMD( sizeof( ArrayVector3 ), MEMCATEGORY_SCENE_OBJECTS ) );
         mDummyTransformPtrs.mDerivedTransform = reinterpret_cast<Matrix4 *>(
             OGRE_MALLOC_SIMD( sizeof( Matrix4 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
+        mDummyTransformPtrs.mDirtyFlags = reinterpret_cast<uint8 *>(
+            OGRE_MALLOC_SIMD( sizeof( uint8 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
 
         /*mDummyTransformPtrs.mDerivedTransform = reinterpret_cast<ArrayMatrix4*>( OGRE_MALLOC_SIMD(
                                                 sizeof( ArrayMatrix4 ), MEMCATEGORY_SCENE_OBJECTS ) );
@@ -69,6 +71,8 @@ namespace Ogre
         *mDummyTransformPtrs.mDerivedScale = ArrayVector3::UNIT_SCALE;
         for( int i = 0; i < ARRAY_PACKED_REALS; ++i )
             mDummyTransformPtrs.mDerivedTransform[i] = Matrix4::IDENTITY;
+        // The dummy never changes, so it never forces its children to update
+        memset( mDummyTransformPtrs.mDirtyFlags, 0, sizeof( uint8 ) * ARRAY_PACKED_REALS );
 
         mDummyNode = new SceneNode( mDummyTransformPtrs );
     }
@@ -98,6 +102,7 @@ namespace Ogre
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedScale, MEMCATEGORY_SCENE_OBJECTS );
 
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedTransform, MEMCATEGORY_SCENE_OBJECTS );
+        OGRE_FREE_SIMD( mDummyTransformPtrs.mDirtyFlags, MEMCATEGORY_SCENE_OBJECTS );
         /*OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritOrientation, MEMCATEGORY_SCENE_OBJECTS );
         OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritScale, MEMCATEGORY_SCENE_OBJECTS );*/
         mDummyTransformPtrs = Transform();
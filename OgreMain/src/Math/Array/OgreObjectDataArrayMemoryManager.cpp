@@ -49,6 +49,7 @@ namespace Ogre
             1 * sizeof( Ogre::uint32 ),      // ArrayMemoryManager::VisibilityFlags
             1 * sizeof( Ogre::uint32 ),      // ArrayMemoryManager::QueryFlags
             1 * sizeof( Ogre::uint32 ),      // ArrayMemoryManager::LightMask
+            1 * sizeof( bool ),              // ArrayMemoryManager::BoundsDirty
         };
     const CleanupRoutines ObjectDataArrayMemoryManager::ObjCleanupRoutines[NumMemoryTypes] = {
         cleanerFlat,       // ArrayMemoryManager::Parent
@@ -63,6 +64,7 @@ namespace Ogre
         cleanerFlat,       // ArrayMemoryManager::VisibilityFlags
         cleanerFlat,       // ArrayMemoryManager::QueryFlags
         cleanerFlat,       // ArrayMemoryManager::LightMask
+        cleanerFlat,       // ArrayMemoryManager::BoundsDirty
     };
     //-----------------------------------------------------------------------------------
     ObjectDataArrayMemoryManager::ObjectDataArrayMemoryManager(
@@ -122,6 +124,8 @@ namespace Ogre
                                                           nextSlotBase * mElementsMemSizes[QueryFlags] );
         outData.mLightMask = reinterpret_cast<uint32 *>( mMemoryPools[LightMask] +
                                                          nextSlotBase * mElementsMemSizes[LightMask] );
+        outData.mBoundsDirty = reinterpret_cast<bool *>( mMemoryPools[BoundsDirty] +
+                                                         nextSlotBase * mElementsMemSizes[BoundsDirty] );
 
         // Set default values
         outData.mParents[nextSlotIdx] = mDummyNode;
@@ -136,6 +140,7 @@ namespace Ogre
         outData.mVisibilityFlags[nextSlotIdx] = MovableObject::getDefaultVisibilityFlags();
         outData.mQueryFlags[nextSlotIdx] = MovableObject::getDefaultQueryFlags();
         outData.mLightMask[nextSlotIdx] = MovableObject::getDefaultLightMask();
+        outData.mBoundsDirty[nextSlotIdx] = true;
     }
     //-----------------------------------------------------------------------------------
     void ObjectDataArrayMemoryManager::destroyNode( ObjectData &inOutData )
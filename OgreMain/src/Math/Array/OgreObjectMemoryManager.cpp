@@ -59,6 +59,8 @@ namespace Ogre
 
         mDummyTransformPtrs.mDerivedTransform = reinterpret_cast<Matrix4 *>(
             OGRE_MALLOC_SIMD( sizeof( Matrix4 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
+        mDummyTransformPtrs.mDirtyFlags = reinterpret_cast<uint8 *>(
+            OGRE_MALLOC_SIMD( sizeof( uint8 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
         /*mDummyTransformPtrs.mInheritOrientation= OGRE_MALLOC_SIMD( sizeof( bool ) * ARRAY_PACKED_REALS,
                                                                     MEMCATEGORY_SCENE_OBJECTS );
         mDummyTransformPtrs.mInheritScale       = OGRE_MALLOC_SIMD( sizeof( bool ) * ARRAY_PACKED_REALS,
@@ -69,6 +71,8 @@ namespace Ogre
         *mDummyTransformPtrs.mDerivedScale = ArrayVector3::UNIT_SCALE;
         for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
             mDummyTransformPtrs.mDerivedTransform[i] = Matrix4::IDENTITY;
+        // The dummy never changes, so it never forces its children to update
+        memset( mDummyTransformPtrs.mDirtyFlags, 0, sizeof( uint8 ) * ARRAY_PACKED_REALS );
 
         mDummyNode = new SceneNode( mDummyTransformPtrs );
         mDummyObject = new NullEntity();
@@ -102,6 +106,7 @@ namespace Ogre
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedScale, MEMCATEGORY_SCENE_OBJECTS );
 
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedTransform, MEMCATEGORY_SCENE_OBJECTS );
+        OGRE_FREE_SIMD( mDummyTransformPtrs.mDirtyFlags, MEMCATEGORY_SCENE_OBJECTS );
         /*OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritOrientation, MEMCATEGORY_SCENE_OBJECTS );
         OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritScale, MEMCATEGORY_SCENE_OBJECTS );*/
         mDummyTransformPtrs = Transform();
@@ -123,6 +128,7 @@ namespace Ogre
                 (uint16)mMemoryManagers.size(), 100, mDummyNode, mDummyObject, 100,
                 ArrayMemoryManager::MAX_MEMORY_SLOTS, this ) );
             mMemoryManagers.back().initialize();
+            mChangeCounters.push_back( 0u );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -134,6 +140,7 @@ namespace Ogre
         mgr.createNewNode( outObjectData );
 
         ++mTotalObjects;
+        ++mChangeCounters[renderQueue];
     }
     //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::objectMoved( ObjectData &inOutObjectData, size_t oldRenderQueue,
@@ -150,6 +157,9 @@ namespace Ogre
         mgr.destroyNode( inOutObjectData );
 
         inOutObjectData = tmp;
+
+        ++mChangeCounters[oldRenderQueue];
+        ++mChangeCounters[newRenderQueue];
     }
     //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::objectDestroyed( ObjectData &outObjectData, size_t renderQueue )
@@ -158,6 +168,7 @@ namespace Ogre
         mgr.destroyNode( outObjectData );
 
         --mTotalObjects;
+        ++mChangeCounters[renderQueue];
     }
     //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::migrateTo( ObjectData &inOutObjectData, size_t renderQueue,
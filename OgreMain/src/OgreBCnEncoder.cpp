@@ -0,0 +1,657 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreBCnEncoder.h"
+
+#include "OgreException.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+
+namespace Ogre
+{
+    namespace
+    {
+        /// Computes the mean and principal axis (normalized) of 16 points with N channels.
+        /// Returns false if all points are the same.
+        template <size_t N>
+        bool computePrincipalAxis( const float *RESTRICT_ALIAS points, float *RESTRICT_ALIAS outMean,
+                                   float *RESTRICT_ALIAS outAxis )
+        {
+            for( size_t c = 0u; c < N; ++c )
+                outMean[c] = 0.0f;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                for( size_t c = 0u; c < N; ++c )
+                    outMean[c] += points[i * N + c];
+            }
+            for( size_t c = 0u; c < N; ++c )
+                outMean[c] *= 1.0f / 16.0f;
+
+            float cov[N][N];
+            for( size_t a = 0u; a < N; ++a )
+            {
+                for( size_t b = 0u; b < N; ++b )
+                    cov[a][b] = 0.0f;
+            }
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                float d[N];
+                for( size_t c = 0u; c < N; ++c )
+                    d[c] = points[i * N + c] - outMean[c];
+                for( size_t a = 0u; a < N; ++a )
+                {
+                    for( size_t b = 0u; b < N; ++b )
+                        cov[a][b] += d[a] * d[b];
+                }
+            }
+
+            // Start the power iteration from the column with the largest variance
+            size_t start = 0u;
+            for( size_t c = 1u; c < N; ++c )
+            {
+                if( cov[c][c] > cov[start][start] )
+                    start = c;
+            }
+            if( cov[start][start] <= 1e-4f )
+                return false;
+
+            for( size_t c = 0u; c < N; ++c )
+                outAxis[c] = cov[c][start];
+
+            for( size_t iteration = 0u; iteration < 8u; ++iteration )
+            {
+                float v[N];
+                float maxComponent = 0.0f;
+                for( size_t a = 0u; a < N; ++a )
+                {
+                    v[a] = 0.0f;
+                    for( size_t b = 0u; b < N; ++b )
+                        v[a] += cov[a][b] * outAxis[b];
+                    maxComponent = std::max( maxComponent, std::abs( v[a] ) );
+                }
+                if( maxComponent <= 1e-8f )
+                    break;
+                for( size_t c = 0u; c < N; ++c )
+                    outAxis[c] = v[c] / maxComponent;
+            }
+
+            float lengthSq = 0.0f;
+            for( size_t c = 0u; c < N; ++c )
+                lengthSq += outAxis[c] * outAxis[c];
+            const float invLength = 1.0f / std::sqrt( lengthSq );
+            for( size_t c = 0u; c < N; ++c )
+                outAxis[c] *= invLength;
+
+            return true;
+        }
+        //-------------------------------------------------------------------------------------
+        /// Projects the points onto the axis and returns the extremes as endpoints
+        template <size_t N>
+        void computeEndpoints( const float *RESTRICT_ALIAS points, const float *RESTRICT_ALIAS mean,
+                               const float *RESTRICT_ALIAS axis, float insetFraction,
+                               float *RESTRICT_ALIAS outMin, float *RESTRICT_ALIAS outMax )
+        {
+            float tMin = std::numeric_limits<float>::max();
+            float tMax = -std::numeric_limits<float>::max();
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                float t = 0.0f;
+                for( size_t c = 0u; c < N; ++c )
+                    t += ( points[i * N + c] - mean[c] ) * axis[c];
+                tMin = std::min( tMin, t );
+                tMax = std::max( tMax, t );
+            }
+
+            const float inset = ( tMax - tMin ) * insetFraction;
+            tMin += inset;
+            tMax -= inset;
+
+            for( size_t c = 0u; c < N; ++c )
+            {
+                outMin[c] = Math::Clamp( mean[c] + axis[c] * tMin, 0.0f, 255.0f );
+                outMax[c] = Math::Clamp( mean[c] + axis[c] * tMax, 0.0f, 255.0f );
+            }
+        }
+        //-------------------------------------------------------------------------------------
+        /// Least squares fit of both endpoints given the interpolation weight of each point
+        /// towards endpoint 1. Returns false if the system is singular.
+        template <size_t N>
+        bool refineEndpoints( const float *RESTRICT_ALIAS points, const float *RESTRICT_ALIAS weights,
+                              float *RESTRICT_ALIAS outE0, float *RESTRICT_ALIAS outE1 )
+        {
+            float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+            float ax[N], bx[N];
+            for( size_t c = 0u; c < N; ++c )
+            {
+                ax[c] = 0.0f;
+                bx[c] = 0.0f;
+            }
+
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const float b = weights[i];
+                const float a = 1.0f - b;
+                aa += a * a;
+                bb += b * b;
+                ab += a * b;
+                for( size_t c = 0u; c < N; ++c )
+                {
+                    ax[c] += a * points[i * N + c];
+                    bx[c] += b * points[i * N + c];
+                }
+            }
+
+            const float det = aa * bb - ab * ab;
+            if( std::abs( det ) <= 1e-6f )
+                return false;
+
+            const float invDet = 1.0f / det;
+            for( size_t c = 0u; c < N; ++c )
+            {
+                outE0[c] = Math::Clamp( ( ax[c] * bb - bx[c] * ab ) * invDet, 0.0f, 255.0f );
+                outE1[c] = Math::Clamp( ( bx[c] * aa - ax[c] * ab ) * invDet, 0.0f, 255.0f );
+            }
+            return true;
+        }
+        //-------------------------------------------------------------------------------------
+        uint16 packRgb565( const float *RESTRICT_ALIAS c )
+        {
+            const uint16 r = static_cast<uint16>( c[0] * ( 31.0f / 255.0f ) + 0.5f );
+            const uint16 g = static_cast<uint16>( c[1] * ( 63.0f / 255.0f ) + 0.5f );
+            const uint16 b = static_cast<uint16>( c[2] * ( 31.0f / 255.0f ) + 0.5f );
+            return static_cast<uint16>( ( r << 11u ) | ( g << 5u ) | b );
+        }
+        //-------------------------------------------------------------------------------------
+        void unpackRgb565( uint16 v, int32 *RESTRICT_ALIAS outRgb )
+        {
+            const int32 r = ( v >> 11u ) & 0x1F;
+            const int32 g = ( v >> 5u ) & 0x3F;
+            const int32 b = v & 0x1F;
+            outRgb[0] = ( r << 3 ) | ( r >> 2 );
+            outRgb[1] = ( g << 2 ) | ( g >> 4 );
+            outRgb[2] = ( b << 3 ) | ( b >> 2 );
+        }
+        //-------------------------------------------------------------------------------------
+        /// Orders the endpoints for 4-colour mode and picks the closest palette entry per pixel.
+        /// Returns the squared error.
+        uint32 finalizeBC1( const uint8 *RESTRICT_ALIAS rgba, uint16 &inOutC0, uint16 &inOutC1,
+                            uint32 &outIndices )
+        {
+            if( inOutC0 < inOutC1 )
+                std::swap( inOutC0, inOutC1 );
+
+            int32 palette[4][3];
+            unpackRgb565( inOutC0, palette[0] );
+            unpackRgb565( inOutC1, palette[1] );
+            for( size_t c = 0u; c < 3u; ++c )
+            {
+                palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+                palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+            }
+
+            // With equal endpoints only index 0 is guaranteed to decode the same everywhere
+            const size_t numEntries = inOutC0 == inOutC1 ? 1u : 4u;
+
+            uint32 totalError = 0u;
+            outIndices = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                uint32 bestError = std::numeric_limits<uint32>::max();
+                uint32 bestIdx = 0u;
+                for( size_t k = 0u; k < numEntries; ++k )
+                {
+                    const int32 dr = palette[k][0] - rgba[i * 4u + 0u];
+                    const int32 dg = palette[k][1] - rgba[i * 4u + 1u];
+                    const int32 db = palette[k][2] - rgba[i * 4u + 2u];
+                    const uint32 error = static_cast<uint32>( dr * dr + dg * dg + db * db );
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        bestIdx = static_cast<uint32>( k );
+                    }
+                }
+                totalError += bestError;
+                outIndices |= bestIdx << ( i * 2u );
+            }
+
+            return totalError;
+        }
+        //-------------------------------------------------------------------------------------
+        template <typename T>
+        void encodeBlockBC4Impl( const T *RESTRICT_ALIAS values, size_t stride,
+                                 uint8 *RESTRICT_ALIAS outBlock, int32 minValue )
+        {
+            int32 v[16];
+            int32 vMin = std::numeric_limits<int32>::max();
+            int32 vMax = std::numeric_limits<int32>::min();
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const T *valuePtr = reinterpret_cast<const T *>(
+                    reinterpret_cast<const uint8 *>( values ) + i * stride );
+                v[i] = std::max<int32>( *valuePtr, minValue );
+                vMin = std::min( vMin, v[i] );
+                vMax = std::max( vMax, v[i] );
+            }
+
+            // a0 > a1 selects the 8 value mode
+            outBlock[0] = static_cast<uint8>( vMax );
+            outBlock[1] = static_cast<uint8>( vMin );
+
+            uint64 indices = 0u;
+            if( vMax != vMin )
+            {
+                int32 palette[8];
+                palette[0] = vMax;
+                palette[1] = vMin;
+                for( int32 k = 2; k < 8; ++k )
+                    palette[k] = ( ( 8 - k ) * vMax + ( k - 1 ) * vMin ) / 7;
+
+                for( size_t i = 0u; i < 16u; ++i )
+                {
+                    int32 bestError = std::numeric_limits<int32>::max();
+                    uint64 bestIdx = 0u;
+                    for( size_t k = 0u; k < 8u; ++k )
+                    {
+                        const int32 error = std::abs( palette[k] - v[i] );
+                        if( error < bestError )
+                        {
+                            bestError = error;
+                            bestIdx = k;
+                        }
+                    }
+                    indices |= bestIdx << ( i * 3u );
+                }
+            }
+
+            for( size_t i = 0u; i < 6u; ++i )
+                outBlock[2u + i] = static_cast<uint8>( indices >> ( i * 8u ) );
+        }
+        //-------------------------------------------------------------------------------------
+        static const int32 c_bc7Weights4[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                                                 34, 38, 43, 47, 51, 55, 60, 64 };
+        //-------------------------------------------------------------------------------------
+        /// Quantizes an RGBA endpoint to 7 bits per channel plus a shared p-bit (BC7 mode 6)
+        void quantizeBC7Endpoint( const float *RESTRICT_ALIAS endpoint, int32 *RESTRICT_ALIAS outQ,
+                                  int32 &outPBit )
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for( int32 pBit = 0; pBit < 2; ++pBit )
+            {
+                int32 q[4];
+                float error = 0.0f;
+                for( size_t c = 0u; c < 4u; ++c )
+                {
+                    q[c] = static_cast<int32>(
+                        Math::Clamp( ( endpoint[c] - static_cast<float>( pBit ) ) * 0.5f + 0.5f,
+                                     0.0f, 127.0f ) );
+                    const float diff = static_cast<float>( ( q[c] << 1 ) | pBit ) - endpoint[c];
+                    error += diff * diff;
+                }
+                if( error < bestError )
+                {
+                    bestError = error;
+                    outPBit = pBit;
+                    for( size_t c = 0u; c < 4u; ++c )
+                        outQ[c] = q[c];
+                }
+            }
+        }
+        //-------------------------------------------------------------------------------------
+        struct Bc7Mode6Endpoints
+        {
+            int32 q[2][4];
+            int32 pBit[2];
+        };
+        //-------------------------------------------------------------------------------------
+        uint32 findBC7Indices( const uint8 *RESTRICT_ALIAS rgba, const Bc7Mode6Endpoints &endpoints,
+                               uint8 *RESTRICT_ALIAS outIndices )
+        {
+            int32 e[2][4];
+            for( size_t j = 0u; j < 2u; ++j )
+            {
+                for( size_t c = 0u; c < 4u; ++c )
+                    e[j][c] = ( endpoints.q[j][c] << 1 ) | endpoints.pBit[j];
+            }
+
+            int32 palette[16][4];
+            for( size_t k = 0u; k < 16u; ++k )
+            {
+                const int32 w = c_bc7Weights4[k];
+                for( size_t c = 0u; c < 4u; ++c )
+                    palette[k][c] = ( ( 64 - w ) * e[0][c] + w * e[1][c] + 32 ) >> 6;
+            }
+
+            uint32 totalError = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                uint32 bestError = std::numeric_limits<uint32>::max();
+                uint8 bestIdx = 0u;
+                for( size_t k = 0u; k < 16u; ++k )
+                {
+                    uint32 error = 0u;
+                    for( size_t c = 0u; c < 4u; ++c )
+                    {
+                        const int32 diff = palette[k][c] - rgba[i * 4u + c];
+                        error += static_cast<uint32>( diff * diff );
+                    }
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        bestIdx = static_cast<uint8>( k );
+                    }
+                }
+                totalError += bestError;
+                outIndices[i] = bestIdx;
+            }
+
+            return totalError;
+        }
+        //-------------------------------------------------------------------------------------
+        void putBits( uint8 *RESTRICT_ALIAS block, uint32 &inOutBitPos, uint32 value, uint32 numBits )
+        {
+            for( uint32 b = 0u; b < numBits; ++b )
+            {
+                if( ( value >> b ) & 0x01u )
+                    block[inOutBitPos >> 3u] |= static_cast<uint8>( 1u << ( inOutBitPos & 0x07u ) );
+                ++inOutBitPos;
+            }
+        }
+        //-------------------------------------------------------------------------------------
+        typedef void ( *EncodeBlockFunc )( const uint8 *RESTRICT_ALIAS, uint8 *RESTRICT_ALIAS );
+
+        void encodeRgbaToBC4Unorm( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+        {
+            BCnEncoder::encodeBlockBC4( rgba, 4u, outBlock );
+        }
+        void encodeRgbaToBC4Snorm( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+        {
+            BCnEncoder::encodeBlockBC4Snorm( reinterpret_cast<const int8 *>( rgba ), 4u, outBlock );
+        }
+        void encodeRgbaToBC5Unorm( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+        {
+            BCnEncoder::encodeBlockBC4( rgba, 4u, outBlock );
+            BCnEncoder::encodeBlockBC4( rgba + 1u, 4u, outBlock + 8u );
+        }
+        void encodeRgbaToBC5Snorm( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+        {
+            BCnEncoder::encodeBlockBC4Snorm( reinterpret_cast<const int8 *>( rgba ), 4u, outBlock );
+            BCnEncoder::encodeBlockBC4Snorm( reinterpret_cast<const int8 *>( rgba + 1u ), 4u,
+                                             outBlock + 8u );
+        }
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::encodeBlockBC1( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+    {
+        float points[16 * 3];
+        for( size_t i = 0u; i < 16u; ++i )
+        {
+            for( size_t c = 0u; c < 3u; ++c )
+                points[i * 3u + c] = static_cast<float>( rgba[i * 4u + c] );
+        }
+
+        float mean[3], axis[3];
+        uint16 c0, c1;
+        if( computePrincipalAxis<3>( points, mean, axis ) )
+        {
+            float eMin[3], eMax[3];
+            computeEndpoints<3>( points, mean, axis, 1.0f / 16.0f, eMin, eMax );
+            c0 = packRgb565( eMax );
+            c1 = packRgb565( eMin );
+        }
+        else
+        {
+            c0 = packRgb565( mean );
+            c1 = c0;
+        }
+
+        uint32 indices;
+        uint32 error = finalizeBC1( rgba, c0, c1, indices );
+
+        if( error > 0u && c0 != c1 )
+        {
+            // Refit the endpoints to the chosen indices, keep it if it's better
+            static const float c_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            float weights[16];
+            for( size_t i = 0u; i < 16u; ++i )
+                weights[i] = c_weights[( indices >> ( i * 2u ) ) & 0x03u];
+
+            float e0[3], e1[3];
+            if( refineEndpoints<3>( points, weights, e0, e1 ) )
+            {
+                uint16 refinedC0 = packRgb565( e0 );
+                uint16 refinedC1 = packRgb565( e1 );
+                uint32 refinedIndices;
+                const uint32 refinedError =
+                    finalizeBC1( rgba, refinedC0, refinedC1, refinedIndices );
+                if( refinedError < error )
+                {
+                    c0 = refinedC0;
+                    c1 = refinedC1;
+                    indices = refinedIndices;
+                }
+            }
+        }
+
+        outBlock[0] = static_cast<uint8>( c0 );
+        outBlock[1] = static_cast<uint8>( c0 >> 8u );
+        outBlock[2] = static_cast<uint8>( c1 );
+        outBlock[3] = static_cast<uint8>( c1 >> 8u );
+        for( size_t i = 0u; i < 4u; ++i )
+            outBlock[4u + i] = static_cast<uint8>( indices >> ( i * 8u ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::encodeBlockBC3( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+    {
+        encodeBlockBC4( rgba + 3u, 4u, outBlock );
+        encodeBlockBC1( rgba, outBlock + 8u );
+    }
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::encodeBlockBC4( const uint8 *RESTRICT_ALIAS values, size_t stride,
+                                     uint8 *RESTRICT_ALIAS outBlock )
+    {
+        encodeBlockBC4Impl<uint8>( values, stride, outBlock, 0 );
+    }
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::encodeBlockBC4Snorm( const int8 *RESTRICT_ALIAS values, size_t stride,
+                                          uint8 *RESTRICT_ALIAS outBlock )
+    {
+        encodeBlockBC4Impl<int8>( values, stride, outBlock, -127 );
+    }
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::encodeBlockBC7( const uint8 *RESTRICT_ALIAS rgba, uint8 *RESTRICT_ALIAS outBlock )
+    {
+        float points[16 * 4];
+        for( size_t i = 0u; i < 64u; ++i )
+            points[i] = static_cast<float>( rgba[i] );
+
+        float mean[4], axis[4];
+        float e0[4], e1[4];
+        if( computePrincipalAxis<4>( points, mean, axis ) )
+            computeEndpoints<4>( points, mean, axis, 0.0f, e0, e1 );
+        else
+        {
+            for( size_t c = 0u; c < 4u; ++c )
+                e0[c] = e1[c] = mean[c];
+        }
+
+        Bc7Mode6Endpoints endpoints;
+        quantizeBC7Endpoint( e0, endpoints.q[0], endpoints.pBit[0] );
+        quantizeBC7Endpoint( e1, endpoints.q[1], endpoints.pBit[1] );
+
+        uint8 indices[16];
+        uint32 error = findBC7Indices( rgba, endpoints, indices );
+
+        if( error > 0u )
+        {
+            // Refit the endpoints to the chosen indices, keep it if it's better
+            float weights[16];
+            for( size_t i = 0u; i < 16u; ++i )
+                weights[i] = static_cast<float>( c_bc7Weights4[indices[i]] ) * ( 1.0f / 64.0f );
+
+            if( refineEndpoints<4>( points, weights, e0, e1 ) )
+            {
+                Bc7Mode6Endpoints refined;
+                quantizeBC7Endpoint( e0, refined.q[0], refined.pBit[0] );
+                quantizeBC7Endpoint( e1, refined.q[1], refined.pBit[1] );
+
+                uint8 refinedIndices[16];
+                const uint32 refinedError = findBC7Indices( rgba, refined, refinedIndices );
+                if( refinedError < error )
+                {
+                    endpoints = refined;
+                    memcpy( indices, refinedIndices, sizeof( indices ) );
+                }
+            }
+        }
+
+        // The MSB of the first index is implicitly 0 (anchor). Swap the endpoints if needed.
+        if( indices[0] & 0x08u )
+        {
+            for( size_t c = 0u; c < 4u; ++c )
+                std::swap( endpoints.q[0][c], endpoints.q[1][c] );
+            std::swap( endpoints.pBit[0], endpoints.pBit[1] );
+            for( size_t i = 0u; i < 16u; ++i )
+                indices[i] = static_cast<uint8>( 15u - indices[i] );
+        }
+
+        memset( outBlock, 0, 16u );
+        uint32 bitPos = 0u;
+        putBits( outBlock, bitPos, 1u << 6u, 7u );  // Mode 6
+        for( size_t c = 0u; c < 4u; ++c )
+        {
+            putBits( outBlock, bitPos, static_cast<uint32>( endpoints.q[0][c] ), 7u );
+            putBits( outBlock, bitPos, static_cast<uint32>( endpoints.q[1][c] ), 7u );
+        }
+        putBits( outBlock, bitPos, static_cast<uint32>( endpoints.pBit[0] ), 1u );
+        putBits( outBlock, bitPos, static_cast<uint32>( endpoints.pBit[1] ), 1u );
+        putBits( outBlock, bitPos, indices[0], 3u );
+        for( size_t i = 1u; i < 16u; ++i )
+            putBits( outBlock, bitPos, indices[i], 4u );
+    }
+    //-----------------------------------------------------------------------------------
+    bool BCnEncoder::isSupported( PixelFormatGpu srcFormat, PixelFormatGpu dstFormat )
+    {
+        srcFormat = PixelFormatGpuUtils::getEquivalentLinear( srcFormat );
+        dstFormat = PixelFormatGpuUtils::getEquivalentLinear( dstFormat );
+
+        switch( dstFormat )
+        {
+        case PFG_BC1_UNORM:
+        case PFG_BC3_UNORM:
+        case PFG_BC7_UNORM:
+            return srcFormat == PFG_RGBA8_UNORM;
+        case PFG_BC4_UNORM:
+            return srcFormat == PFG_R8_UNORM;
+        case PFG_BC4_SNORM:
+            return srcFormat == PFG_R8_SNORM;
+        case PFG_BC5_UNORM:
+            return srcFormat == PFG_RG8_UNORM;
+        case PFG_BC5_SNORM:
+            return srcFormat == PFG_RG8_SNORM;
+        default:
+            return false;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BCnEncoder::compress( const TextureBox &srcBox, PixelFormatGpu srcFormat,
+                               const TextureBox &dstBox, PixelFormatGpu dstFormat )
+    {
+        OGRE_ASSERT_LOW( isSupported( srcFormat, dstFormat ) );
+        OGRE_ASSERT_LOW( srcBox.width == dstBox.width && srcBox.height == dstBox.height );
+
+        EncodeBlockFunc encodeBlock = 0;
+        switch( PixelFormatGpuUtils::getEquivalentLinear( dstFormat ) )
+        {
+        case PFG_BC1_UNORM:
+            encodeBlock = &BCnEncoder::encodeBlockBC1;
+            break;
+        case PFG_BC3_UNORM:
+            encodeBlock = &BCnEncoder::encodeBlockBC3;
+            break;
+        case PFG_BC7_UNORM:
+            encodeBlock = &BCnEncoder::encodeBlockBC7;
+            break;
+        case PFG_BC4_UNORM:
+            encodeBlock = &encodeRgbaToBC4Unorm;
+            break;
+        case PFG_BC4_SNORM:
+            encodeBlock = &encodeRgbaToBC4Snorm;
+            break;
+        case PFG_BC5_UNORM:
+            encodeBlock = &encodeRgbaToBC5Unorm;
+            break;
+        case PFG_BC5_SNORM:
+            encodeBlock = &encodeRgbaToBC5Snorm;
+            break;
+        default:
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Unsupported format " +
+                             String( PixelFormatGpuUtils::toString( dstFormat ) ),
+                         "BCnEncoder::compress" );
+        }
+
+        const size_t bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( srcFormat );
+        const uint32 width = srcBox.width;
+        const uint32 height = srcBox.height;
+        const uint32 depthOrSlices = srcBox.getDepthOrSlices();
+
+        // Unused channels stay at 0, except alpha
+        uint8 block[16 * 4];
+        memset( block, 0, sizeof( block ) );
+        if( bytesPerPixel < 4u )
+        {
+            for( size_t i = 0u; i < 16u; ++i )
+                block[i * 4u + 3u] = 0xFF;
+        }
+
+        for( uint32 z = 0u; z < depthOrSlices; ++z )
+        {
+            for( uint32 y = 0u; y < height; y += 4u )
+            {
+                for( uint32 x = 0u; x < width; x += 4u )
+                {
+                    for( uint32 py = 0u; py < 4u; ++py )
+                    {
+                        const uint32 srcY = std::min( y + py, height - 1u );
+                        for( uint32 px = 0u; px < 4u; ++px )
+                        {
+                            const uint32 srcX = std::min( x + px, width - 1u );
+                            const uint8 *srcPixel =
+                                reinterpret_cast<const uint8 *>( srcBox.at( srcX, srcY, z ) );
+                            memcpy( &block[( py * 4u + px ) * 4u], srcPixel, bytesPerPixel );
+                        }
+                    }
+
+                    encodeBlock( block, reinterpret_cast<uint8 *>( dstBox.at( x, y, z ) ) );
+                }
+            }
+        }
+    }
+}  // namespace Ogre
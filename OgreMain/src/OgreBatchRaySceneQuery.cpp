@@ -0,0 +1,218 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreBatchRaySceneQuery.h"
+
+#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "OgreMovableObject.h"
+#include "OgreSceneManager.h"
+
+namespace Ogre
+{
+    BatchRaySceneQuery::BatchRaySceneQuery( SceneManager *creator ) :
+        SceneQuery( creator ),
+        mMaxHitsPerRay( 1u ),
+        mRays( 0 ),
+        mNumRays( 0 ),
+        mOutHits( 0 ),
+        mOutNumHits( 0 )
+    {
+        // No world geometry results supported
+        mSupportedWorldFragments.insert( SceneQuery::WFT_NONE );
+    }
+    //-----------------------------------------------------------------------
+    BatchRaySceneQuery::~BatchRaySceneQuery() {}
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::setMaxHitsPerRay( uint32 maxHitsPerRay )
+    {
+        assert( maxHitsPerRay > 0u );
+        mMaxHitsPerRay = std::max( maxHitsPerRay, 1u );
+    }
+    //-----------------------------------------------------------------------
+    inline void BatchRaySceneQuery::addHit( size_t rayIdx, MovableObject *movable, Real distance )
+    {
+        uint32 &numHits = mOutNumHits[rayIdx];
+        BatchRayHit *hits = mOutHits + rayIdx * mMaxHitsPerRay;
+
+        if( numHits == mMaxHitsPerRay )
+        {
+            if( distance >= hits[numHits - 1u].distance )
+                return;
+            --numHits;  // Discard the furthest one
+        }
+
+        uint32 pos = numHits;
+        while( pos > 0u && hits[pos - 1u].distance > distance )
+        {
+            hits[pos] = hits[pos - 1u];
+            --pos;
+        }
+
+        hits[pos].movable = movable;
+        hits[pos].distance = distance;
+        ++numHits;
+    }
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::executeRange( size_t firstPacket, size_t lastPacket )
+    {
+        ArrayRay *RESTRICT_ALIAS rayPackets = mRayPackets.get();
+        ArrayVector3 *RESTRICT_ALIAS invDirPackets = mInvDirPackets.get();
+
+        // Pack our rays into SoA. Trailing lanes get a dummy ray, and are never reported
+        for( size_t i = firstPacket * ARRAY_PACKED_REALS; i < lastPacket * ARRAY_PACKED_REALS; ++i )
+        {
+            const Ray ray = i < mNumRays ? mRays[i] : Ray();
+            const Vector3 &dir = ray.getDirection();
+            rayPackets[i / ARRAY_PACKED_REALS].mOrigin.setFromVector3( ray.getOrigin(),
+                                                                       i % ARRAY_PACKED_REALS );
+            rayPackets[i / ARRAY_PACKED_REALS].mDirection.setFromVector3( dir, i % ARRAY_PACKED_REALS );
+            invDirPackets[i / ARRAY_PACKED_REALS].setFromVector3(
+                Vector3( Real( 1.0 ) / dir.x, Real( 1.0 ) / dir.y, Real( 1.0 ) / dir.z ),
+                i % ARRAY_PACKED_REALS );
+
+            if( i < mNumRays )
+                mOutNumHits[i] = 0u;
+        }
+
+        const size_t lastRayIdx = std::min( lastPacket * ARRAY_PACKED_REALS, mNumRays );
+
+        OGRE_ALIGNED_DECL( Real, scalarDistance[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            ObjectMemoryManager &memoryManager =
+                mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+
+            const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+
+            const size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
+            const size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
+
+            for( size_t rq = firstRq; rq < lastRq; ++rq )
+            {
+                ObjectData objData;
+                const size_t totalObjs = memoryManager.getFirstObjectData( objData, rq );
+
+                for( size_t j = 0; j < totalObjs; j += ARRAY_PACKED_REALS )
+                {
+                    for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                    {
+                        // Filter by query mask and visibility first. This is cheaper
+                        // than testing the object against all of our rays.
+                        // There's no need to check objData.mOwner[k] is null because
+                        // we set mVisibilityFlags to 0 on slot removals
+                        if( !( objData.mQueryFlags[k] & mQueryMask ) ||
+                            !( objData.mVisibilityFlags[k] & VisibilityFlags::LAYER_VISIBILITY ) )
+                        {
+                            continue;
+                        }
+
+#if OGRE_DEBUG_MODE
+                        // Queries must be performed after all bounds have been updated
+                        //(i.e. SceneManager::updateSceneGraph does this for you), and don't
+                        // move the objects between that call and this query.
+                        assert( !objData.mOwner[k]->isCachedAabbOutOfDate() &&
+                                "Perform the queries after MovableObject::updateAllBounds has been "
+                                "called!" );
+#endif
+
+                        ArrayAabb objAabb( ArrayVector3::ZERO, ArrayVector3::ZERO );
+                        objAabb.setAll( objData.mWorldAabb->getAsAabb( k ) );
+
+                        MovableObject *owner = objData.mOwner[k];
+
+                        for( size_t p = firstPacket; p < lastPacket; ++p )
+                        {
+                            ArrayReal distance;
+                            const ArrayMaskR hitMask =
+                                rayPackets[p].intersects( objAabb, invDirPackets[p], distance );
+                            const uint32 scalarMask = BooleanMask4::getScalarMask( hitMask );
+
+                            if( scalarMask )
+                            {
+                                CastArrayToReal( scalarDistance, distance );
+                                const size_t packetRayIdx = p * ARRAY_PACKED_REALS;
+                                for( size_t l = 0; l < ARRAY_PACKED_REALS; ++l )
+                                {
+                                    if( IS_BIT_SET( l, scalarMask ) && packetRayIdx + l < lastRayIdx )
+                                        addHit( packetRayIdx + l, owner, scalarDistance[l] );
+                                }
+                            }
+                        }
+                    }
+
+                    objData.advancePack();
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::execute( size_t threadId, size_t numThreads )
+    {
+        const size_t numPackets = ( mNumRays + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+        const size_t packetsPerThread = ( numPackets + numThreads - 1u ) / numThreads;
+
+        const size_t firstPacket = std::min( threadId * packetsPerThread, numPackets );
+        const size_t lastPacket = std::min( firstPacket + packetsPerThread, numPackets );
+
+        if( firstPacket != lastPacket )
+            executeRange( firstPacket, lastPacket );
+    }
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::execute( const Ray *rays, size_t numRays, BatchRayHit *outHits,
+                                      uint32 *outNumHits )
+    {
+        assert( mFirstRq < mLastRq && "This query will never hit any result!" );
+
+        if( !numRays )
+            return;
+
+        const size_t numPackets = ( numRays + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+        if( mRayPackets.size() < numPackets )
+        {
+            RawSimdUniquePtr<ArrayRay, MEMCATEGORY_SCENE_CONTROL> rayPackets( numPackets );
+            RawSimdUniquePtr<ArrayVector3, MEMCATEGORY_SCENE_CONTROL> invDirPackets( numPackets );
+            mRayPackets.swap( rayPackets );
+            mInvDirPackets.swap( invDirPackets );
+        }
+
+        mRays = rays;
+        mNumRays = numRays;
+        mOutHits = outHits;
+        mOutNumHits = outNumHits;
+
+        mParentSceneMgr->executeUserScalableTask( this, true );
+
+        mRays = 0;
+        mNumRays = 0;
+        mOutHits = 0;
+        mOutNumHits = 0;
+    }
+}  // namespace Ogre
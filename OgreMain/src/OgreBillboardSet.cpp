@@ -146,6 +146,7 @@ namespace Ogre
             aabb.merge( newMax );
             mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
             mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
             return newBill;
         }
@@ -483,10 +484,12 @@ namespace Ogre
         {
             mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
             mObjectData.mLocalRadius[mObjectData.mIndex] = radius;
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
         }
         //-----------------------------------------------------------------------
         void BillboardSet::_updateBounds()
         {
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
             if( mActiveBillboards.empty() )
             {
                 // No billboards, null bbox
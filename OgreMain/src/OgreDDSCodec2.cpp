@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "OgreDDSCodec2.h"
 
 #include "OgreBitwise.h"
+#include "OgreDataStream.h"
 #include "OgreException.h"
 #include "OgreImage2.h"
 #include "OgreLogManager.h"
@@ -875,6 +876,28 @@ namespace Ogre
                                                                               imgData->format,         //
                                                                               imgData->numMipmaps,     //
                                                                               rowAlignment );
+        // When the file is mapped and its contents already match Image2's layout (single slice
+        // so there's no face/mip reordering, no decompression, no 24-bit expansion, and rows
+        // need no padding) point straight into it instead of copying it to the heap.
+        const MemoryMappedDataStream *mappedStream =
+            dynamic_cast<const MemoryMappedDataStream *>( stream.get() );
+        if( mappedStream && !decompressDXT && header.pixelFormat.rgbBits != 24u &&
+            imgData->box.numSlices == 1u && stream->size() - stream->tell() >= requiredBytes &&
+            requiredBytes == PixelFormatGpuUtils::calculateSizeBytes(
+                                 imgData->box.width, imgData->box.height, imgData->box.depth,
+                                 imgData->box.numSlices, imgData->format, imgData->numMipmaps, 1u ) )
+        {
+            imgData->box.data = const_cast<uchar *>( mappedStream->getCurrentPtr() );
+            imgData->freeOnDestruction = false;
+            imgData->backingStream = stream;
+            stream->skip( static_cast<long>( requiredBytes ) );
+
+            DecodeResult ret;
+            ret.first.reset();
+            ret.second = CodecDataPtr( imgData );
+            return ret;
+        }
+
         // Bind output buffer
         imgData->box.data = OGRE_MALLOC_SIMD( requiredBytes, MEMCATEGORY_RESOURCE );
 
@@ -35,6 +35,19 @@ THE SOFTWARE.
 
 #include <fstream>
 
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32 || OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+#    define WIN32_LEAN_AND_MEAN
+#    if !defined( NOMINMAX ) && defined( _MSC_VER )
+#        define NOMINMAX  // required to stop windows.h messing up std::min
+#    endif
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 namespace Ogre
 {
     //-----------------------------------------------------------------------
@@ -466,6 +479,123 @@ namespace Ogre
     }
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
+    MemoryMappedDataStream::MemoryMappedDataStream( const String &name, const String &fullPath ) :
+        DataStream( name, READ ),
+        mData( 0 ),
+        mPos( 0 ),
+        mEnd( 0 ),
+        mMappingHandle( 0 )
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        HANDLE fileHandle = CreateFileA( fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+        if( fileHandle == INVALID_HANDLE_VALUE )
+            return;
+
+        LARGE_INTEGER fileSize;
+        if( GetFileSizeEx( fileHandle, &fileSize ) && fileSize.QuadPart > 0 )
+        {
+            HANDLE mappingHandle = CreateFileMappingA( fileHandle, 0, PAGE_READONLY, 0, 0, 0 );
+            if( mappingHandle )
+            {
+                void *data = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+                if( data )
+                {
+                    mData = static_cast<uchar *>( data );
+                    mSize = static_cast<size_t>( fileSize.QuadPart );
+                    mMappingHandle = mappingHandle;
+                }
+                else
+                {
+                    CloseHandle( mappingHandle );
+                }
+            }
+        }
+        // The mapping keeps its own reference to the file
+        CloseHandle( fileHandle );
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+        // CreateFileMapping is not available. Leave unmapped so callers fall back.
+        (void)fullPath;
+#else
+        const int fd = ::open( fullPath.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return;
+
+        struct stat tagStat;
+        if( fstat( fd, &tagStat ) == 0 && tagStat.st_size > 0 )
+        {
+            void *data =
+                mmap( 0, static_cast<size_t>( tagStat.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( data != MAP_FAILED )
+            {
+                mData = static_cast<uchar *>( data );
+                mSize = static_cast<size_t>( tagStat.st_size );
+            }
+        }
+        // The mapping keeps its own reference to the file
+        ::close( fd );
+#endif
+
+        if( !mData )
+            mAccess = 0;
+
+        mPos = mData;
+        mEnd = mData + mSize;
+    }
+    //-----------------------------------------------------------------------
+    MemoryMappedDataStream::~MemoryMappedDataStream() { close(); }
+    //-----------------------------------------------------------------------
+    size_t MemoryMappedDataStream::read( void *buf, size_t count )
+    {
+        size_t cnt = count;
+        // Read over end of memory?
+        if( mPos + cnt > mEnd )
+            cnt = static_cast<size_t>( mEnd - mPos );
+        if( cnt == 0 )
+            return 0;
+
+        memcpy( buf, mPos, cnt );
+        mPos += cnt;
+        return cnt;
+    }
+    //-----------------------------------------------------------------------
+    void MemoryMappedDataStream::skip( long count )
+    {
+        size_t newpos = (size_t)( ( mPos - mData ) + count );
+        assert( mData + newpos <= mEnd );
+
+        mPos = mData + newpos;
+    }
+    //-----------------------------------------------------------------------
+    void MemoryMappedDataStream::seek( size_t pos )
+    {
+        assert( mData + pos <= mEnd );
+        mPos = mData + pos;
+    }
+    //-----------------------------------------------------------------------
+    size_t MemoryMappedDataStream::tell() const { return static_cast<size_t>( mPos - mData ); }
+    //-----------------------------------------------------------------------
+    bool MemoryMappedDataStream::eof() const { return mPos >= mEnd; }
+    //-----------------------------------------------------------------------
+    void MemoryMappedDataStream::close()
+    {
+        mAccess = 0;
+        if( mData )
+        {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+            UnmapViewOfFile( mData );
+            CloseHandle( static_cast<HANDLE>( mMappingHandle ) );
+            mMappingHandle = 0;
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+            munmap( mData, mSize );
+#endif
+            mData = 0;
+            mPos = 0;
+            mEnd = 0;
+        }
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
     FileStreamDataStream::FileStreamDataStream( std::ifstream *s, bool freeOnClose ) :
         DataStream(),
         mInStream( s ),
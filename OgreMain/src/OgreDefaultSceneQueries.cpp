@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "Math/Array/OgreBooleanMask.h"
 #include "Math/Array/OgreMathlib.h"
 #include "OgreRoot.h"
+#include "OgreSceneQueryBvh.h"
 
 namespace Ogre
 {
@@ -134,10 +135,14 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        const Aabb queryAabb = Aabb::newFromExtents( mAABB.getMinimum(), mAABB.getMaximum() );
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
                 mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+            const SceneQueryBvh *bvh =
+                mParentSceneMgr->_getSceneQueryBvh( static_cast<SceneMemoryMgrTypes>( i ) );
 
             const size_t numRenderQueues = memoryManager.getNumRenderQueues();
 
@@ -147,9 +152,16 @@ namespace Ogre
 
             for( size_t j = firstRq; j < lastRq && keepIterating; ++j )
             {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+                if( bvh && bvh->isUpToDate( j ) )
+                {
+                    keepIterating = bvh->queryAabb( j, queryAabb, mQueryMask, listener );
+                }
+                else
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -224,6 +236,8 @@ namespace Ogre
         {
             ObjectMemoryManager &memoryManager =
                 mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+            const SceneQueryBvh *bvh =
+                mParentSceneMgr->_getSceneQueryBvh( static_cast<SceneMemoryMgrTypes>( i ) );
 
             const size_t numRenderQueues = memoryManager.getNumRenderQueues();
 
@@ -233,9 +247,16 @@ namespace Ogre
 
             for( size_t j = firstRq; j < lastRq && keepIterating; ++j )
             {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+                if( bvh && bvh->isUpToDate( j ) )
+                {
+                    keepIterating = bvh->queryRay( j, mRay, mQueryMask, listener );
+                }
+                else
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -367,6 +388,8 @@ namespace Ogre
         {
             ObjectMemoryManager &memoryManager =
                 mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+            const SceneQueryBvh *bvh =
+                mParentSceneMgr->_getSceneQueryBvh( static_cast<SceneMemoryMgrTypes>( i ) );
 
             const size_t numRenderQueues = memoryManager.getNumRenderQueues();
 
@@ -376,9 +399,16 @@ namespace Ogre
 
             for( size_t j = firstRq; j < lastRq && keepIterating; ++j )
             {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+                if( bvh && bvh->isUpToDate( j ) )
+                {
+                    keepIterating = bvh->querySphere( j, mSphere, mQueryMask, listener );
+                }
+                else
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -375,6 +375,24 @@ namespace Ogre
         return DataStreamPtr( stream );
     }
     //---------------------------------------------------------------------
+    DataStreamPtr FileSystemArchive::openMemoryMapped( const String &filename )
+    {
+#ifdef _OGRE_FILESYSTEM_ARCHIVE_UNICODE
+        // MemoryMappedDataStream only accepts narrow paths
+        return DataStreamPtr();
+#else
+        const String full_path = concatenate_path( mName, filename );
+
+        MemoryMappedDataStream *stream = OGRE_NEW MemoryMappedDataStream( filename, full_path );
+        if( !stream->isMapped() )
+        {
+            OGRE_DELETE stream;
+            return DataStreamPtr();
+        }
+        return DataStreamPtr( stream );
+#endif
+    }
+    //---------------------------------------------------------------------
     DataStreamPtr FileSystemArchive::create( const String &filename )
     {
         if( isReadOnly() )
@@ -71,6 +71,180 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    namespace
+    {
+        /** Converts the bitmap to something we can consume, and returns the format of its
+            data (origFormat) and the format it must be converted to (supportedFormat).
+            supportedFormat is PFG_UNKNOWN if the image can't be handled.
+        @return
+            The bitmap to use. The input bitmap is unloaded if it had to be replaced.
+        */
+        FIBITMAP *prepareBitmapForDecoding( FIBITMAP *fiBitmap, PixelFormatGpu &origFormat,
+                                            PixelFormatGpu &supportedFormat )
+        {
+            FREE_IMAGE_TYPE imageType = FreeImage_GetImageType( fiBitmap );
+            FREE_IMAGE_COLOR_TYPE colourType = FreeImage_GetColorType( fiBitmap );
+            unsigned bpp = FreeImage_GetBPP( fiBitmap );
+            origFormat = PFG_UNKNOWN;
+            supportedFormat = PFG_UNKNOWN;
+
+            switch( imageType )
+            {
+            case FIT_UNKNOWN:
+            case FIT_COMPLEX:
+            case FIT_DOUBLE:
+            default:
+                // Unsupported. Caller must throw
+                return fiBitmap;
+            case FIT_BITMAP:
+                // Standard image type
+                // Perform any colour conversions for greyscale
+                if( colourType == FIC_MINISWHITE || colourType == FIC_MINISBLACK )
+                {
+                    FIBITMAP *newBitmap = FreeImage_ConvertToGreyscale( fiBitmap );
+                    // free old bitmap and replace
+                    FreeImage_Unload( fiBitmap );
+                    fiBitmap = newBitmap;
+                    // get new formats
+                    bpp = FreeImage_GetBPP( fiBitmap );
+                }
+                // Perform any colour conversions for RGB
+                else if( bpp < 8 || colourType == FIC_PALETTE || colourType == FIC_CMYK )
+                {
+                    FIBITMAP *newBitmap = NULL;
+                    if( FreeImage_IsTransparent( fiBitmap ) )
+                    {
+                        // convert to 32 bit to preserve the transparency
+                        // (the alpha byte will be 0 if pixel is transparent)
+                        newBitmap = FreeImage_ConvertTo32Bits( fiBitmap );
+                    }
+                    else
+                    {
+                        // no transparency - only 3 bytes are needed
+                        newBitmap = FreeImage_ConvertTo24Bits( fiBitmap );
+                    }
+
+                    // free old bitmap and replace
+                    FreeImage_Unload( fiBitmap );
+                    fiBitmap = newBitmap;
+                    // get new formats
+                    bpp = FreeImage_GetBPP( fiBitmap );
+                }
+
+                // by this stage, 8-bit is greyscale, 16/24/32 bit are RGB[A]
+                switch( bpp )
+                {
+                case 8:
+                    supportedFormat = PFG_R8_UNORM;
+                    break;
+                case 16:
+                    // Determine 555 or 565 from green mask
+                    // cannot be 16-bit greyscale since that's FIT_UINT16
+                    if( FreeImage_GetGreenMask( fiBitmap ) == FI16_565_GREEN_MASK )
+                    {
+                        supportedFormat = PFG_B5G6R5_UNORM;
+                    }
+                    else
+                    {
+                        // FreeImage doesn't support 4444 format so must be 1555
+                        supportedFormat = PFG_B5G5R5A1_UNORM;
+                    }
+                    break;
+                case 24:
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_RGB
+                    origFormat = PFG_RGB8_UNORM;
+                    supportedFormat = PFG_RGBA8_UNORM;
+#else
+                    origFormat = PFG_BGR8_UNORM;
+                    // Do NOT use PFG_BGRA8_UNORM. That format MUST be avoided
+                    supportedFormat = PFG_RGBA8_UNORM;
+#endif
+                    break;
+                case 32:
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_RGB
+                    origFormat = PFG_RGBA8_UNORM;
+                    supportedFormat = PFG_RGBA8_UNORM;
+#else
+                    origFormat = PFG_BGRA8_UNORM;
+                    // Do NOT use PFG_BGRA8_UNORM. That format MUST be avoided
+                    supportedFormat = PFG_RGBA8_UNORM;
+#endif
+                    break;
+                }
+                break;
+            case FIT_UINT16:
+                // 16-bit greyscale
+                supportedFormat = PFG_R16_UNORM;
+                break;
+            case FIT_INT16:
+                // 16-bit greyscale
+                supportedFormat = PFG_R16_SNORM;
+                break;
+            case FIT_UINT32:
+                supportedFormat = PFG_R32_UINT;
+                break;
+            case FIT_INT32:
+                supportedFormat = PFG_R32_SINT;
+                break;
+            case FIT_FLOAT:
+                // Single-component floating point data
+                supportedFormat = PFG_R32_FLOAT;
+                break;
+            case FIT_RGB16:
+                origFormat = PFG_RGB16_UNORM;
+                supportedFormat = PFG_RGBA16_UNORM;
+                break;
+            case FIT_RGBA16:
+                supportedFormat = PFG_RGBA16_UNORM;
+                break;
+            case FIT_RGBF:
+                supportedFormat = PFG_RGB32_FLOAT;
+                break;
+            case FIT_RGBAF:
+                supportedFormat = PFG_RGBA32_FLOAT;
+                break;
+            };
+
+            if( origFormat == PFG_UNKNOWN )
+                origFormat = supportedFormat;
+
+            return fiBitmap;
+        }
+        //---------------------------------------------------------------------
+        unsigned DLL_CALLCONV freeImageReadFromDataStream( void *buffer, unsigned size,
+                                                           unsigned count, fi_handle handle )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( handle );
+            return static_cast<unsigned>( stream->read( buffer, size_t( size ) * count ) / size );
+        }
+        //---------------------------------------------------------------------
+        int DLL_CALLCONV freeImageSeekDataStream( fi_handle handle, long offset, int origin )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( handle );
+            switch( origin )
+            {
+            case SEEK_SET:
+                stream->seek( static_cast<size_t>( offset ) );
+                break;
+            case SEEK_CUR:
+                stream->skip( offset );
+                break;
+            case SEEK_END:
+                stream->seek( static_cast<size_t>( static_cast<long>( stream->size() ) + offset ) );
+                break;
+            default:
+                return -1;
+            }
+            return 0;
+        }
+        //---------------------------------------------------------------------
+        long DLL_CALLCONV freeImageTellDataStream( fi_handle handle )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( handle );
+            return static_cast<long>( stream->tell() );
+        }
+    }  // namespace
+
     FreeImageCodec2::RegisteredCodecList FreeImageCodec2::msCodecList;
     //---------------------------------------------------------------------
     void FreeImageLoadErrorHandler2( FREE_IMAGE_FORMAT fif, const char *message )
@@ -473,133 +647,17 @@ namespace Ogre
         }
 
         // Must derive format first, this may perform conversions
-        FREE_IMAGE_TYPE imageType = FreeImage_GetImageType( fiBitmap );
-        FREE_IMAGE_COLOR_TYPE colourType = FreeImage_GetColorType( fiBitmap );
-        unsigned bpp = FreeImage_GetBPP( fiBitmap );
-        PixelFormatGpu origFormat = PFG_UNKNOWN;
-        PixelFormatGpu supportedFormat = PFG_UNKNOWN;
+        PixelFormatGpu origFormat;
+        PixelFormatGpu supportedFormat;
+        fiBitmap = prepareBitmapForDecoding( fiBitmap, origFormat, supportedFormat );
 
-        switch( imageType )
+        if( supportedFormat == PFG_UNKNOWN )
         {
-        case FIT_UNKNOWN:
-        case FIT_COMPLEX:
-        case FIT_DOUBLE:
-        default:
+            FreeImage_Unload( fiBitmap );
             FreeImage_CloseMemory( fiMem );
             OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND, "Unknown or unsupported image format",
                          "FreeImageCodec2::decode" );
-            break;
-        case FIT_BITMAP:
-            // Standard image type
-            // Perform any colour conversions for greyscale
-            if( colourType == FIC_MINISWHITE || colourType == FIC_MINISBLACK )
-            {
-                FIBITMAP *newBitmap = FreeImage_ConvertToGreyscale( fiBitmap );
-                // free old bitmap and replace
-                FreeImage_Unload( fiBitmap );
-                fiBitmap = newBitmap;
-                // get new formats
-                bpp = FreeImage_GetBPP( fiBitmap );
-            }
-            // Perform any colour conversions for RGB
-            else if( bpp < 8 || colourType == FIC_PALETTE || colourType == FIC_CMYK )
-            {
-                FIBITMAP *newBitmap = NULL;
-                if( FreeImage_IsTransparent( fiBitmap ) )
-                {
-                    // convert to 32 bit to preserve the transparency
-                    // (the alpha byte will be 0 if pixel is transparent)
-                    newBitmap = FreeImage_ConvertTo32Bits( fiBitmap );
-                }
-                else
-                {
-                    // no transparency - only 3 bytes are needed
-                    newBitmap = FreeImage_ConvertTo24Bits( fiBitmap );
-                }
-
-                // free old bitmap and replace
-                FreeImage_Unload( fiBitmap );
-                fiBitmap = newBitmap;
-                // get new formats
-                bpp = FreeImage_GetBPP( fiBitmap );
-            }
-
-            // by this stage, 8-bit is greyscale, 16/24/32 bit are RGB[A]
-            switch( bpp )
-            {
-            case 8:
-                supportedFormat = PFG_R8_UNORM;
-                break;
-            case 16:
-                // Determine 555 or 565 from green mask
-                // cannot be 16-bit greyscale since that's FIT_UINT16
-                if( FreeImage_GetGreenMask( fiBitmap ) == FI16_565_GREEN_MASK )
-                {
-                    supportedFormat = PFG_B5G6R5_UNORM;
-                }
-                else
-                {
-                    // FreeImage doesn't support 4444 format so must be 1555
-                    supportedFormat = PFG_B5G5R5A1_UNORM;
-                }
-                break;
-            case 24:
-#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_RGB
-                origFormat = PFG_RGB8_UNORM;
-                supportedFormat = PFG_RGBA8_UNORM;
-#else
-                origFormat = PFG_BGR8_UNORM;
-                // Do NOT use PFG_BGRA8_UNORM. That format MUST be avoided
-                supportedFormat = PFG_RGBA8_UNORM;
-#endif
-                break;
-            case 32:
-#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_RGB
-                origFormat = PFG_RGBA8_UNORM;
-                supportedFormat = PFG_RGBA8_UNORM;
-#else
-                origFormat = PFG_BGRA8_UNORM;
-                // Do NOT use PFG_BGRA8_UNORM. That format MUST be avoided
-                supportedFormat = PFG_RGBA8_UNORM;
-#endif
-                break;
-            }
-            break;
-        case FIT_UINT16:
-            // 16-bit greyscale
-            supportedFormat = PFG_R16_UNORM;
-            break;
-        case FIT_INT16:
-            // 16-bit greyscale
-            supportedFormat = PFG_R16_SNORM;
-            break;
-        case FIT_UINT32:
-            supportedFormat = PFG_R32_UINT;
-            break;
-        case FIT_INT32:
-            supportedFormat = PFG_R32_SINT;
-            break;
-        case FIT_FLOAT:
-            // Single-component floating point data
-            supportedFormat = PFG_R32_FLOAT;
-            break;
-        case FIT_RGB16:
-            origFormat = PFG_RGB16_UNORM;
-            supportedFormat = PFG_RGBA16_UNORM;
-            break;
-        case FIT_RGBA16:
-            supportedFormat = PFG_RGBA16_UNORM;
-            break;
-        case FIT_RGBF:
-            supportedFormat = PFG_RGB32_FLOAT;
-            break;
-        case FIT_RGBAF:
-            supportedFormat = PFG_RGBA32_FLOAT;
-            break;
-        };
-
-        if( origFormat == PFG_UNKNOWN )
-            origFormat = supportedFormat;
+        }
 
         ImageData2 *imgData = OGRE_NEW ImageData2();
         imgData->box.width = FreeImage_GetWidth( fiBitmap );
@@ -636,6 +694,84 @@ namespace Ogre
         return ret;
     }
     //---------------------------------------------------------------------
+    bool FreeImageCodec2::decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                                           uint32 maxRowsPerBatch ) const
+    {
+        // Let FreeImage read straight from the stream rather than buffering the whole file
+        FreeImageIO io;
+        io.read_proc = freeImageReadFromDataStream;
+        io.write_proc = 0;
+        io.seek_proc = freeImageSeekDataStream;
+        io.tell_proc = freeImageTellDataStream;
+
+        FIBITMAP *fiBitmap =
+            FreeImage_LoadFromHandle( (FREE_IMAGE_FORMAT)mFreeImageType, &io, input.get() );
+        if( !fiBitmap )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR, "Error decoding image",
+                         "FreeImageCodec2::decodeStreaming" );
+        }
+
+        PixelFormatGpu origFormat;
+        PixelFormatGpu supportedFormat;
+        fiBitmap = prepareBitmapForDecoding( fiBitmap, origFormat, supportedFormat );
+
+        if( supportedFormat == PFG_UNKNOWN )
+        {
+            FreeImage_Unload( fiBitmap );
+            OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND, "Unknown or unsupported image format",
+                         "FreeImageCodec2::decodeStreaming" );
+        }
+
+        ImageData2 header;
+        header.box.width = FreeImage_GetWidth( fiBitmap );
+        header.box.height = FreeImage_GetHeight( fiBitmap );
+        header.box.depth = 1u;
+        header.box.numSlices = 1u;
+        header.box.bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( supportedFormat );
+        header.box.bytesPerRow = (uint32)PixelFormatGpuUtils::getSizeBytes(
+            header.box.width, 1u, 1u, 1u, supportedFormat, 4u );
+        header.box.bytesPerImage = size_t( header.box.bytesPerRow ) * size_t( header.box.height );
+        header.textureType = TextureTypes::Type2D;
+        header.format = supportedFormat;
+        header.numMipmaps = 1u;
+        header.freeOnDestruction = false;
+
+        bool retVal = listener->headerDecoded( header );
+
+        maxRowsPerBatch = std::max( maxRowsPerBatch, 1u );
+        void *rowsData = OGRE_MALLOC_SIMD( size_t( header.box.bytesPerRow ) * maxRowsPerBatch,
+                                           MEMCATEGORY_RESOURCE );
+
+        const uint32 pitch = FreeImage_GetPitch( fiBitmap );
+
+        for( uint32 y = 0u; y < header.box.height && retVal; y += maxRowsPerBatch )
+        {
+            TextureBox rows = header.box;
+            rows.height = std::min( maxRowsPerBatch, header.box.height - y );
+            rows.bytesPerImage = size_t( rows.bytesPerRow ) * rows.height;
+            rows.data = rowsData;
+
+            // FreeImage stores scanlines bottom to top. Point to the lowest
+            // scanline of this batch and flip while converting
+            TextureBox srcBox( rows.width, rows.height, 1u, 1u,
+                               PixelFormatGpuUtils::getBytesPerPixel( origFormat ), pitch,
+                               size_t( pitch ) * rows.height );
+            srcBox.data = FreeImage_GetScanLine( fiBitmap,
+                                                 (int)( header.box.height - y - rows.height ) );
+
+            PixelFormatGpuUtils::bulkPixelConversion( srcBox, origFormat, rows, supportedFormat,
+                                                      true );
+
+            retVal = listener->rowsDecoded( rows, 0u, 0u, y );
+        }
+
+        OGRE_FREE_SIMD( rowsData, MEMCATEGORY_RESOURCE );
+        FreeImage_Unload( fiBitmap );
+
+        return retVal;
+    }
+    //---------------------------------------------------------------------
     String FreeImageCodec2::getType() const { return mType; }
     //---------------------------------------------------------------------
     String FreeImageCodec2::magicNumberToFileExt( const char *magicNumberPtr, size_t maxbytes ) const
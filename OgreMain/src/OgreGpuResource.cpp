@@ -32,6 +32,8 @@ THE SOFTWARE.
 
 #include "Vao/OgreVaoManager.h"
 
+#include <limits>
+
 namespace Ogre
 {
     namespace GpuResidency
@@ -56,7 +58,7 @@ namespace Ogre
         mPendingResidencyChanges( 0 ),
         mRank( 1 ),
         mLastFrameUsed( vaoManager->getFrameCount() ),
-        mLowestDistanceToCamera( 0 ),
+        mLowestDistanceToCamera( std::numeric_limits<float>::max() ),
         mVaoManager( vaoManager ),
         mName( name )
     {
@@ -85,6 +87,20 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     uint32 GpuResource::getPendingResidencyChanges() const { return mPendingResidencyChanges; }
     //-----------------------------------------------------------------------------------
+    void GpuResource::notifyUsed( float distanceToCamera )
+    {
+        const uint32 frameCount = mVaoManager->getFrameCount();
+        if( mLastFrameUsed != frameCount )
+        {
+            mLastFrameUsed = frameCount;
+            mLowestDistanceToCamera = distanceToCamera;
+        }
+        else
+        {
+            mLowestDistanceToCamera = std::min( mLowestDistanceToCamera, distanceToCamera );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     IdString GpuResource::getName() const { return mName; }
     //-----------------------------------------------------------------------------------
     String GpuResource::getNameStr() const
@@ -39,6 +39,8 @@ THE SOFTWARE.
 #include "OgreForward3D.h"
 #include "OgreHighLevelGpuProgram.h"
 #include "OgreHighLevelGpuProgramManager.h"
+#include "OgreHlmsCompiledTemplate.h"
+#include "OgreHlmsDiskCache.h"
 #include "OgreHlmsListener.h"
 #include "OgreHlmsManager.h"
 #include "OgreLight.h"
@@ -281,6 +283,7 @@ namespace Ogre
 
     Hlms::Hlms( HlmsTypes type, const String &typeName, Archive *dataFolder,
                 ArchiveVec *libraryFolders ) :
+        mBackgroundDiskCache( 0 ),
         mDataFolder( dataFolder ),
         mHlmsManager( 0 ),
         mShadersGenerated( 0u ),
@@ -313,6 +316,7 @@ namespace Ogre
 #endif
         mPrecisionMode( PrecisionFull32 ),
         mFastShaderBuildHack( false ),
+        mPrecompiledTemplates( false ),
         mDefaultDatablock( 0 ),
         mType( type ),
         mTypeName( typeName ),
@@ -349,7 +353,11 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     Hlms::~Hlms()
     {
+        if( mBackgroundDiskCache )
+            mBackgroundDiskCache->stopBackgroundSave();
+
         clearShaderCache();
+        clearCompiledTemplates();
 
         _destroyAllDatablocks();
 
@@ -527,53 +535,39 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Hlms::setProperty( size_t tid, IdString key, int32 value )
     {
-        HlmsProperty p( key, value );
-        HlmsPropertyVec::iterator it = std::lower_bound(
-            mT[tid].setProperties.begin(), mT[tid].setProperties.end(), p, OrderPropertyByIdString );
-        if( it == mT[tid].setProperties.end() || it->keyName != p.keyName )
-            mT[tid].setProperties.insert( it, p );
-        else
-            *it = p;
+        setProperty( mT[tid].setProperties, key, value );
     }
     //-----------------------------------------------------------------------------------
     int32 Hlms::getProperty( size_t tid, IdString key, int32 defaultVal ) const
     {
-        HlmsProperty p( key, 0 );
-        HlmsPropertyVec::const_iterator it = std::lower_bound(
-            mT[tid].setProperties.begin(), mT[tid].setProperties.end(), p, OrderPropertyByIdString );
-        if( it != mT[tid].setProperties.end() && it->keyName == p.keyName )
-            defaultVal = it->value;
-
-        return defaultVal;
+        return getProperty( mT[tid].setProperties, key, defaultVal );
     }
     //-----------------------------------------------------------------------------------
     void Hlms::unsetProperty( size_t tid, IdString key )
     {
-        HlmsProperty p( key, 0 );
-        HlmsPropertyVec::iterator it = std::lower_bound(
-            mT[tid].setProperties.begin(), mT[tid].setProperties.end(), p, OrderPropertyByIdString );
-        if( it != mT[tid].setProperties.end() && it->keyName == p.keyName )
-            mT[tid].setProperties.erase( it );
+        HlmsPropertyVec &properties = mT[tid].setProperties;
+        const size_t idx = findPropertyLowerBound( properties, key );
+        if( idx != properties.size() && properties[idx].keyName == key )
+            properties.erase( properties.begin() + static_cast<ptrdiff_t>( idx ) );
     }
     //-----------------------------------------------------------------------------------
     void Hlms::setProperty( HlmsPropertyVec &properties, IdString key, int32 value )
     {
-        HlmsProperty p( key, value );
-        HlmsPropertyVec::iterator it =
-            std::lower_bound( properties.begin(), properties.end(), p, OrderPropertyByIdString );
-        if( it == properties.end() || it->keyName != p.keyName )
-            properties.insert( it, p );
+        const size_t idx = findPropertyLowerBound( properties, key );
+        if( idx == properties.size() || properties[idx].keyName != key )
+        {
+            properties.insert( properties.begin() + static_cast<ptrdiff_t>( idx ),
+                               HlmsProperty( key, value ) );
+        }
         else
-            *it = p;
+            properties[idx].value = value;
     }
     //-----------------------------------------------------------------------------------
     int32 Hlms::getProperty( const HlmsPropertyVec &properties, IdString key, int32 defaultVal )
     {
-        HlmsProperty p( key, 0 );
-        HlmsPropertyVec::const_iterator it =
-            std::lower_bound( properties.begin(), properties.end(), p, OrderPropertyByIdString );
-        if( it != properties.end() && it->keyName == p.keyName )
-            defaultVal = it->value;
+        const size_t idx = findPropertyLowerBound( properties, key );
+        if( idx != properties.size() && properties[idx].keyName == key )
+            defaultVal = properties[idx].value;
 
         return defaultVal;
     }
@@ -712,12 +706,29 @@ namespace Ogre
         outSubString =
             SubStringRef( &outSubString.getOriginalBuffer(), outSubString.getStart() + expEnd + 1 );
 
+        ExpressionVec outExpressions;
+        bool syntaxError = tokenizeExpression( subString, outExpressions );
+
+        bool retVal = false;
+
+        if( !syntaxError )
+            retVal = evaluateExpressionRecursive( outExpressions, syntaxError, tid ) != 0;
+
+        if( syntaxError )
+            printf( "Syntax Error at line %lu\n", calculateLineCount( subString ) );
+
+        outSyntaxError = syntaxError;
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::tokenizeExpression( const SubStringRef &subString, ExpressionVec &outExpressions )
+    {
         bool textStarted = false;
         bool syntaxError = false;
         bool nextExpressionNegates = false;
 
         std::vector<Expression *> expressionParents;
-        ExpressionVec outExpressions;
         outExpressions.clear();
         outExpressions.resize( 1 );
 
@@ -794,24 +805,101 @@ namespace Ogre
             ++it;
         }
 
-        bool retVal = false;
-
         if( !expressionParents.empty() )
             syntaxError = true;
 
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    int32 Hlms::evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError,
+                                             const size_t tid ) const
+    {
+        bool syntaxError = outSyntaxError;
+        classifyExpression( expression, syntaxError );
+
+        ExpressionVec::iterator itor = expression.begin();
+        ExpressionVec::iterator endt = expression.end();
+
+        // Evaluate the individual properties.
+        while( itor != endt && !syntaxError )
+        {
+            Expression &exp = *itor;
+            if( exp.type == EXPR_VAR )
+            {
+                char *endPtr;
+                exp.result = static_cast<int32>( strtol( exp.value.c_str(), &endPtr, 10 ) );
+                if( exp.value.c_str() == endPtr )
+                {
+                    // This isn't a number. Let's try if it's a variable
+                    exp.result = getProperty( tid, exp.value );
+                }
+            }
+            else
+            {
+                exp.result = evaluateExpressionRecursive( exp.children, syntaxError, tid );
+            }
+
+            ++itor;
+        }
+
+        // Perform operations between the different properties.
+        int32 retVal = 1;
         if( !syntaxError )
-            retVal = evaluateExpressionRecursive( outExpressions, syntaxError, tid ) != 0;
+        {
+            itor = expression.begin();
 
-        if( syntaxError )
-            printf( "Syntax Error at line %lu\n", calculateLineCount( subString ) );
+            ExpressionType nextOperation = EXPR_VAR;
+
+            while( itor != endt )
+            {
+                int32 result = itor->negated ? !itor->result : itor->result;
+
+                switch( nextOperation )
+                {
+                case EXPR_OPERATOR_OR:
+                    retVal = ( retVal != 0 ) | ( result != 0 );
+                    break;
+                case EXPR_OPERATOR_AND:
+                    retVal = ( retVal != 0 ) & ( result != 0 );
+                    break;
+                case EXPR_OPERATOR_LE:
+                    retVal = retVal < result;
+                    break;
+                case EXPR_OPERATOR_LEEQ:
+                    retVal = retVal <= result;
+                    break;
+                case EXPR_OPERATOR_EQ:
+                    retVal = retVal == result;
+                    break;
+                case EXPR_OPERATOR_NEQ:
+                    retVal = retVal != result;
+                    break;
+                case EXPR_OPERATOR_GR:
+                    retVal = retVal > result;
+                    break;
+                case EXPR_OPERATOR_GREQ:
+                    retVal = retVal >= result;
+                    break;
+
+                case EXPR_OBJECT:
+                case EXPR_VAR:
+                    if( !itor->isOperator() )
+                        retVal = result;
+                    break;
+                }
+
+                nextOperation = itor->type;
+
+                ++itor;
+            }
+        }
 
         outSyntaxError = syntaxError;
 
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    int32 Hlms::evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError,
-                                             const size_t tid ) const
+    void Hlms::classifyExpression( ExpressionVec &expression, bool &outSyntaxError )
     {
         bool syntaxError = outSyntaxError;
         bool lastExpWasOperator = true;
@@ -899,86 +987,7 @@ namespace Ogre
             }
         }
 
-        // Evaluate the individual properties.
-        itor = expression.begin();
-        while( itor != endt && !syntaxError )
-        {
-            Expression &exp = *itor;
-            if( exp.type == EXPR_VAR )
-            {
-                char *endPtr;
-                exp.result = static_cast<int32>( strtol( exp.value.c_str(), &endPtr, 10 ) );
-                if( exp.value.c_str() == endPtr )
-                {
-                    // This isn't a number. Let's try if it's a variable
-                    exp.result = getProperty( tid, exp.value );
-                }
-                lastExpWasOperator = false;
-            }
-            else
-            {
-                exp.result = evaluateExpressionRecursive( exp.children, syntaxError, tid );
-                lastExpWasOperator = false;
-            }
-
-            ++itor;
-        }
-
-        // Perform operations between the different properties.
-        int32 retVal = 1;
-        if( !syntaxError )
-        {
-            itor = expression.begin();
-
-            ExpressionType nextOperation = EXPR_VAR;
-
-            while( itor != endt )
-            {
-                int32 result = itor->negated ? !itor->result : itor->result;
-
-                switch( nextOperation )
-                {
-                case EXPR_OPERATOR_OR:
-                    retVal = ( retVal != 0 ) | ( result != 0 );
-                    break;
-                case EXPR_OPERATOR_AND:
-                    retVal = ( retVal != 0 ) & ( result != 0 );
-                    break;
-                case EXPR_OPERATOR_LE:
-                    retVal = retVal < result;
-                    break;
-                case EXPR_OPERATOR_LEEQ:
-                    retVal = retVal <= result;
-                    break;
-                case EXPR_OPERATOR_EQ:
-                    retVal = retVal == result;
-                    break;
-                case EXPR_OPERATOR_NEQ:
-                    retVal = retVal != result;
-                    break;
-                case EXPR_OPERATOR_GR:
-                    retVal = retVal > result;
-                    break;
-                case EXPR_OPERATOR_GREQ:
-                    retVal = retVal >= result;
-                    break;
-
-                case EXPR_OBJECT:
-                case EXPR_VAR:
-                    if( !itor->isOperator() )
-                        retVal = result;
-                    break;
-                }
-
-                nextOperation = itor->type;
-
-                ++itor;
-            }
-        }
-
         outSyntaxError = syntaxError;
-
-        return retVal;
     }
     //-----------------------------------------------------------------------------------
     size_t Hlms::evaluateExpressionEnd( const SubStringRef &outSubString )
@@ -1157,7 +1166,7 @@ namespace Ogre
         return opValue;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseMath( const String &inBuffer, String &outBuffer, const size_t tid )
+    bool Hlms::stripMathOps( const String &inBuffer, String &outBuffer, MathOpVec &outMathOps )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1200,13 +1209,9 @@ namespace Ogre
 
             if( !syntaxError )
             {
-                const IdString dstProperty = argValues[0];
-                const size_t idx = argValues.size() == 3 ? 1 : 0;
-                const int op1Value = interpretAsNumberThenAsProperty( argValues[idx], tid );
-                const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1], tid );
-
-                int result = c_operations[keyword].opFunc( op1Value, op2Value );
-                setProperty( tid, dstProperty, result );
+                outMathOps.push_back( MathOp() );
+                outMathOps.back().opIdx = keyword;
+                outMathOps.back().args.swap( argValues );
             }
             else
             {
@@ -1249,6 +1254,35 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
+    int32 Hlms::executeMathOp( size_t opIdx, int32 op1, int32 op2 )
+    {
+        return c_operations[opIdx].opFunc( op1, op2 );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseMath( const String &inBuffer, String &outBuffer, const size_t tid )
+    {
+        MathOpVec mathOps;
+        const bool syntaxError = stripMathOps( inBuffer, outBuffer, mathOps );
+
+        MathOpVec::const_iterator itor = mathOps.begin();
+        MathOpVec::const_iterator endt = mathOps.end();
+
+        while( itor != endt )
+        {
+            const StringVector &argValues = itor->args;
+
+            const IdString dstProperty = argValues[0];
+            const size_t idx = argValues.size() == 3 ? 1 : 0;
+            const int op1Value = interpretAsNumberThenAsProperty( argValues[idx], tid );
+            const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1], tid );
+
+            setProperty( tid, dstProperty, executeMathOp( itor->opIdx, op1Value, op2Value ) );
+            ++itor;
+        }
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
     bool Hlms::parseForEach( const String &inBuffer, String &outBuffer, const size_t tid ) const
     {
         outBuffer.clear();
@@ -1715,24 +1749,76 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
+    uint64 Hlms::RenderableCache::calculateHash( const HlmsPropertyVec &properties,
+                                                 const PiecesMap *_pieces )
+    {
+        // FNV-1a, one 32-bit word at a time. Collisions are fine, entries are compared anyway.
+        const uint64 prime = 0x100000001b3ull;
+        uint64 retVal = 0xcbf29ce484222325ull;
+
+        HlmsPropertyVec::const_iterator itor = properties.begin();
+        HlmsPropertyVec::const_iterator endt = properties.end();
+
+        while( itor != endt )
+        {
+            retVal = ( retVal ^ itor->keyName.getU32Value() ) * prime;
+            retVal = ( retVal ^ static_cast<uint32>( itor->value ) ) * prime;
+            ++itor;
+        }
+
+        if( _pieces )
+        {
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+            {
+                PiecesMap::const_iterator itPiece = _pieces[i].begin();
+                PiecesMap::const_iterator enPiece = _pieces[i].end();
+
+                while( itPiece != enPiece )
+                {
+                    retVal = ( retVal ^ static_cast<uint32>( i ) ) * prime;
+                    retVal = ( retVal ^ itPiece->first.getU32Value() ) * prime;
+
+                    String::const_iterator itChar = itPiece->second.begin();
+                    String::const_iterator enChar = itPiece->second.end();
+                    while( itChar != enChar )
+                        retVal = ( retVal ^ static_cast<uint8>( *itChar++ ) ) * prime;
+
+                    ++itPiece;
+                }
+            }
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
     uint32 Hlms::addRenderableCache( const HlmsPropertyVec &renderableSetProperties,
                                      const PiecesMap *pieces )
     {
         assert( mRenderableCache.size() <= HlmsBits::RenderableMask );
 
-        RenderableCache cacheEntry( renderableSetProperties, pieces );
+        const uint64 hash = RenderableCache::calculateHash( renderableSetProperties, pieces );
 
-        RenderableCacheVec::iterator it =
-            std::find( mRenderableCache.begin(), mRenderableCache.end(), cacheEntry );
-        if( it == mRenderableCache.end() )
+        std::pair<RenderableCacheIndex::const_iterator, RenderableCacheIndex::const_iterator> range =
+            mRenderableCacheIndex.equal_range( hash );
+
+        uint32 idx = std::numeric_limits<uint32>::max();
+        while( range.first != range.second && idx == std::numeric_limits<uint32>::max() )
         {
-            mRenderableCache.push_back( cacheEntry );
-            it = mRenderableCache.end() - 1;
+            if( mRenderableCache[range.first->second].equals( renderableSetProperties, pieces ) )
+                idx = range.first->second;
+            ++range.first;
+        }
+
+        if( idx == std::numeric_limits<uint32>::max() )
+        {
+            idx = static_cast<uint32>( mRenderableCache.size() );
+            mRenderableCache.push_back( RenderableCache( renderableSetProperties, pieces ) );
+            mRenderableCacheIndex.insert( RenderableCacheIndex::value_type( hash, idx ) );
         }
 
         // 3 bits for mType (see getMaterial)
         return ( static_cast<uint32>( mType ) << HlmsBits::HlmsTypeShift ) |
-               ( static_cast<uint32>( it - mRenderableCache.begin() ) << HlmsBits::RenderableShift );
+               ( idx << HlmsBits::RenderableShift );
     }
     //-----------------------------------------------------------------------------------
     const Hlms::RenderableCache &Hlms::getRenderableCache( uint32 hash ) const
@@ -1811,6 +1897,11 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     bool Hlms::getFastShaderBuildHack() const { return mFastShaderBuildHack; }
     //-----------------------------------------------------------------------------------
+    void Hlms::setPrecompiledTemplates( bool bPrecompiledTemplates )
+    {
+        mPrecompiledTemplates = bPrecompiledTemplates;
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::setMaxNonCasterDirectionalLights( uint16 maxLights ) { mNumLightsLimit = maxLights; }
     //-----------------------------------------------------------------------------------
     void Hlms::setStaticBranchingLights( bool staticBranchingLights )
@@ -1842,6 +1933,7 @@ namespace Ogre
     void Hlms::reloadFrom( Archive *newDataFolder, ArchiveVec *libraryFolders )
     {
         clearShaderCache();
+        clearCompiledTemplates();
 
         if( libraryFolders )
         {
@@ -2032,6 +2124,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
+    void Hlms::recordPassCacheProperties( const HlmsCache &passCache )
+    {
+        const size_t passIdx = ( passCache.hash >> HlmsBits::PassShift ) & HlmsBits::PassMask;
+        if( passIdx < mPassCache.size() && mPassCache[passIdx].passCacheProperties.empty() )
+            mPassCache[passIdx].passCacheProperties = passCache.setProperties;
+    }
+    //-----------------------------------------------------------------------------------
     HlmsCache *Hlms::addStubShaderCache( uint32 hash )
     {
         HlmsCache cache( hash, mType, HlmsPso() );
@@ -2102,10 +2201,101 @@ namespace Ogre
         shaderCache.clear();
 
         mShaderCodeCache.clear();
+        mPreprocessedShaderCode.clear();
         mShadersGenerated = 0u;
         mShaderCodeCacheDirty = true;
     }
     //-----------------------------------------------------------------------------------
+    const HlmsCompiledTemplate *Hlms::getCompiledTemplate( Archive *archive, const String &filename )
+    {
+        const CompiledTemplateKey key( archive, filename );
+
+        HlmsCompiledTemplate *retVal = 0;
+
+        mCompiledTemplatesMutex.lock();
+        CompiledTemplateMap::const_iterator itor = mCompiledTemplates.find( key );
+        if( itor != mCompiledTemplates.end() )
+            retVal = itor->second;
+        mCompiledTemplatesMutex.unlock();
+
+        if( !retVal )
+        {
+            // Parse outside the lock. If another thread beat us to it, keep theirs.
+            DataStreamPtr inFile = archive->open( filename );
+
+            String source;
+            source.resize( inFile->size() );
+            if( !source.empty() )
+                inFile->read( &source[0], inFile->size() );
+
+            retVal = OGRE_NEW HlmsCompiledTemplate( source );
+
+            mCompiledTemplatesMutex.lock();
+            std::pair<CompiledTemplateMap::iterator, bool> inserted =
+                mCompiledTemplates.insert( CompiledTemplateMap::value_type( key, retVal ) );
+            if( !inserted.second )
+            {
+                OGRE_DELETE retVal;
+                retVal = inserted.first->second;
+            }
+            mCompiledTemplatesMutex.unlock();
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::clearCompiledTemplates()
+    {
+        ScopedLock lock( mCompiledTemplatesMutex );
+
+        CompiledTemplateMap::const_iterator itor = mCompiledTemplates.begin();
+        CompiledTemplateMap::const_iterator endt = mCompiledTemplates.end();
+
+        while( itor != endt )
+        {
+            OGRE_DELETE itor->second;
+            ++itor;
+        }
+
+        mCompiledTemplates.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseTemplateFile( Archive *archive, const String &filename, String &inOutString,
+                                  String &outString, const size_t tid )
+    {
+        if( mPrecompiledTemplates )
+        {
+            const HlmsCompiledTemplate *compiledTemplate = getCompiledTemplate( archive, filename );
+            if( compiledTemplate->isValid() &&
+                compiledTemplate->generate( mT[tid].setProperties, inOutString ) )
+            {
+                return false;
+            }
+
+            // Fallback to the text parser.
+            inOutString = compiledTemplate->getOriginalSource();
+        }
+        else
+        {
+            DataStreamPtr inFile = archive->open( filename );
+
+            inOutString.resize( inFile->size() );
+            inFile->read( &inOutString[0], inFile->size() );
+        }
+
+        bool syntaxError = false;
+
+        syntaxError |= this->parseMath( inOutString, outString, tid );
+        while( !syntaxError && outString.find( "@foreach" ) != String::npos )
+        {
+            syntaxError |= this->parseForEach( outString, inOutString, tid );
+            inOutString.swap( outString );
+        }
+        syntaxError |= this->parseProperties( outString, inOutString, tid );
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::processPieces( Archive *archive, const StringVector &pieceFiles, const size_t tid )
     {
         StringVector::const_iterator itor = pieceFiles.begin();
@@ -2118,21 +2308,10 @@ namespace Ogre
             const String::size_type extPos1 = itor->find( ".any" );
             if( extPos0 == itor->size() - mShaderFileExt.size() || extPos1 == itor->size() - 4u )
             {
-                DataStreamPtr inFile = archive->open( *itor );
-
                 String inString;
                 String outString;
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
-
-                this->parseMath( inString, outString, tid );
-                while( outString.find( "@foreach" ) != String::npos )
-                {
-                    this->parseForEach( outString, inString, tid );
-                    inString.swap( outString );
-                }
-                this->parseProperties( outString, inString, tid );
+                this->parseTemplateFile( archive, *itor, inString, outString, tid );
                 this->parseUndefPieces( inString, outString, tid );
                 this->collectPieces( outString, inString, tid );
                 this->parseCounter( inString, outString, tid );
@@ -2283,18 +2462,20 @@ namespace Ogre
         return gp;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::_compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
-                                                     const String source[NumShaderTypes],
-                                                     const uint32 shaderCounter, const size_t tid )
+    Hlms::PreprocessedShaderCode::PreprocessedShaderCode( const RenderableCache &_mergedCache,
+                                                          const String _source[NumShaderTypes] ) :
+        mergedCache( _mergedCache )
+    {
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            source[i] = _source[i];
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::compileShaderCode( ShaderCodeCache &codeCache, const String source[NumShaderTypes],
+                                  const uint32 shaderCounter, const size_t tid )
     {
-        OgreProfileExhaustive( "Hlms::_compileShaderFromPreprocessedSource" );
-
         const uint32 uniqueName = mType * 100000000u + shaderCounter;
 
-        ShaderCodeCache codeCache( mergedCache.pieces );
-        codeCache.mergedCache.setProperties = mergedCache.setProperties;
-
-        codeCache.mergedCache.setProperties.swap( mT[tid].setProperties );
+        mT[tid].setProperties = codeCache.mergedCache.setProperties;
 
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
@@ -2324,16 +2505,37 @@ namespace Ogre
             }
         }
 
-        codeCache.mergedCache.setProperties.swap( mT[tid].setProperties );
-
         // Ensure code didn't accidentally modify mSetProperties
-        OGRE_ASSERT_HIGH( codeCache.mergedCache.setProperties == mergedCache.setProperties );
+        OGRE_ASSERT_HIGH( codeCache.mergedCache.setProperties == mT[tid].setProperties );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
+                                                     const String source[NumShaderTypes],
+                                                     const uint32 shaderCounter, const size_t tid )
+    {
+        OgreProfileExhaustive( "Hlms::_compileShaderFromPreprocessedSource" );
+
+        ShaderCodeCache codeCache( mergedCache.pieces );
+        codeCache.mergedCache.setProperties = mergedCache.setProperties;
+
+        compileShaderCode( codeCache, source, shaderCounter, tid );
 
         ScopedLock lock( mMutex );
         mShaderCodeCache.push_back( codeCache );
         mShaderCodeCacheDirty = true;
     }
     //-----------------------------------------------------------------------------------
+    void Hlms::_addPreprocessedShaderCode( const RenderableCache &mergedCache,
+                                           const String source[NumShaderTypes] )
+    {
+        const uint64 hash =
+            RenderableCache::calculateHash( mergedCache.setProperties, mergedCache.pieces );
+
+        ScopedLock lock( mMutex );
+        mPreprocessedShaderCode.insert( PreprocessedShaderCodeMap::value_type(
+            hash, PreprocessedShaderCode( mergedCache, source ) ) );
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::compileShaderCode( ShaderCodeCache &codeCache, const uint32 shaderCounter,
                                   const size_t tid )
     {
@@ -2443,23 +2645,13 @@ namespace Ogre
                 processPieces( mDataFolder, mPieceFiles[i], tid );
 
                 // Generate the shader file.
-                DataStreamPtr inFile = mDataFolder->open( filename );
-
                 String inString;
                 String outString;
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
-
                 bool syntaxError = false;
 
-                syntaxError |= this->parseMath( inString, outString, tid );
-                while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-                {
-                    syntaxError |= this->parseForEach( outString, inString, tid );
-                    inString.swap( outString );
-                }
-                syntaxError |= this->parseProperties( outString, inString, tid );
+                syntaxError |=
+                    this->parseTemplateFile( mDataFolder, filename, inString, outString, tid );
                 syntaxError |= this->parseUndefPieces( inString, outString, tid );
                 while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
                                          outString.find( "@insertpiece" ) != String::npos ) )
@@ -2497,6 +2689,9 @@ namespace Ogre
             }
         }
 
+        if( mBackgroundDiskCache )
+            mBackgroundDiskCache->_notifyShaderCodeCacheEntryCreated( this, codeCache );
+
         ScopedLock lock( mMutex );
         mShaderCodeCache.push_back( codeCache );
         mShaderCodeCacheDirty = true;
@@ -2516,19 +2711,31 @@ namespace Ogre
         const RenderableCache &renderableCache = getRenderableCache( renderableHash );
         mT[tid].setProperties.reserve( passCache.setProperties.size() +
                                        renderableCache.setProperties.size() );
-        // Copy the properties from the renderable
-        mT[tid].setProperties.insert( mT[tid].setProperties.end(), renderableCache.setProperties.begin(),
-                                      renderableCache.setProperties.end() );
         {
-            // Now copy the properties from the pass (one by one, since be must maintain the order)
-            HlmsPropertyVec::const_iterator itor = passCache.setProperties.begin();
-            HlmsPropertyVec::const_iterator endt = passCache.setProperties.end();
+            // Both are sorted, so merge them in one go. The pass' properties take precedence.
+            HlmsPropertyVec &mergedProperties = mT[tid].setProperties;
 
-            while( itor != endt )
+            HlmsPropertyVec::const_iterator itRenderable = renderableCache.setProperties.begin();
+            HlmsPropertyVec::const_iterator enRenderable = renderableCache.setProperties.end();
+            HlmsPropertyVec::const_iterator itPass = passCache.setProperties.begin();
+            HlmsPropertyVec::const_iterator enPass = passCache.setProperties.end();
+
+            while( itRenderable != enRenderable && itPass != enPass )
             {
-                setProperty( tid, itor->keyName, itor->value );
-                ++itor;
+                if( itRenderable->keyName < itPass->keyName )
+                {
+                    mergedProperties.push_back( *itRenderable++ );
+                }
+                else
+                {
+                    if( itRenderable->keyName == itPass->keyName )
+                        ++itRenderable;
+                    mergedProperties.push_back( *itPass++ );
+                }
             }
+
+            mergedProperties.insert( mergedProperties.end(), itRenderable, enRenderable );
+            mergedProperties.insert( mergedProperties.end(), itPass, enPass );
         }
 
         mT[tid].textureNameStrings.clear();
@@ -2557,6 +2764,8 @@ namespace Ogre
         codeCache.mergedCache.setProperties.swap( mT[tid].setProperties );
         {
             bool bIsInCache;
+            bool bIsPreprocessed = false;
+            String preprocessedSource[NumShaderTypes];
 
             uint32_t shaderCounter = 0u;
             {
@@ -2572,10 +2781,44 @@ namespace Ogre
                         codeCache.shaders[i] = itCodeCache->shaders[i];
                 }
                 else
+                {
                     shaderCounter = mShadersGenerated++;
+
+                    if( !mPreprocessedShaderCode.empty() )
+                    {
+                        // Loaded from HlmsDiskCache but not compiled yet?
+                        const RenderableCache &mergedCache = codeCache.mergedCache;
+                        std::pair<PreprocessedShaderCodeMap::iterator,
+                                  PreprocessedShaderCodeMap::iterator>
+                            range = mPreprocessedShaderCode.equal_range( RenderableCache::calculateHash(
+                                mergedCache.setProperties, mergedCache.pieces ) );
+
+                        while( range.first != range.second && !bIsPreprocessed )
+                        {
+                            PreprocessedShaderCode &preprocessed = range.first->second;
+                            if( preprocessed.mergedCache == mergedCache )
+                            {
+                                for( size_t i = 0; i < NumShaderTypes; ++i )
+                                    preprocessedSource[i].swap( preprocessed.source[i] );
+                                mPreprocessedShaderCode.erase( range.first );
+                                bIsPreprocessed = true;
+                            }
+                            else
+                                ++range.first;
+                        }
+                    }
+                }
             }
 
-            if( !bIsInCache )
+            if( bIsPreprocessed )
+            {
+                // Skip the templates. This entry is already in the HlmsDiskCache,
+                // thus it doesn't make the cache dirty.
+                compileShaderCode( codeCache, preprocessedSource, shaderCounter, tid );
+                ScopedLock lock( mMutex );
+                mShaderCodeCache.push_back( codeCache );
+            }
+            else if( !bIsInCache )
                 compileShaderCode( codeCache, shaderCounter, tid );
             else
             {
@@ -2594,9 +2837,23 @@ namespace Ogre
 
         bool casterPass = getProperty( tid, HlmsBaseProp::ShadowCaster ) != 0;
 
-        const HlmsDatablock *datablock = queuedRenderable.renderable->getDatablock();
-        pso.macroblock = datablock->getMacroblock( casterPass );
-        pso.blendblock = datablock->getBlendblock( casterPass );
+        // Without a Renderable, we're creating a PSO recorded in a previous session
+        const HlmsPso *recordedPso = queuedRenderable.renderable ? 0 : mT[tid].recordedPso;
+        OGRE_ASSERT_LOW( ( queuedRenderable.renderable || recordedPso ) &&
+                         "Either a Renderable or a recorded PSO is required" );
+
+        const HlmsDatablock *datablock = 0;
+        if( queuedRenderable.renderable )
+        {
+            datablock = queuedRenderable.renderable->getDatablock();
+            pso.macroblock = datablock->getMacroblock( casterPass );
+            pso.blendblock = datablock->getBlendblock( casterPass );
+        }
+        else
+        {
+            pso.macroblock = recordedPso->macroblock;
+            pso.blendblock = recordedPso->blendblock;
+        }
         pso.pass = passCache.pso.pass;
 
         applyStrongMacroblockRules( pso );
@@ -2629,10 +2886,18 @@ namespace Ogre
 
             pso.enablePrimitiveRestart = false;
         }
+        else
+        {
+            pso.operationType = recordedPso->operationType;
+            pso.vertexElements = recordedPso->vertexElements;
+            pso.enablePrimitiveRestart = recordedPso->enablePrimitiveRestart;
+        }
 
 #if OGRE_DEBUG_MODE >= OGRE_DEBUG_MEDIUM
         LogManager::getSingleton().logMessage(
-            "Compiling new PSO for datablock: " + datablock->getName().getFriendlyText(), LML_TRIVIAL );
+            datablock ? "Compiling new PSO for datablock: " + datablock->getName().getFriendlyText()
+                      : String( "Compiling new PSO recorded in a previous session" ),
+            LML_TRIVIAL );
 #endif
         mRenderSystem->_hlmsPipelineStateObjectCreated( &pso );
 
@@ -2651,6 +2916,9 @@ namespace Ogre
 
         applyTextureRegisters( retVal, tid );
 
+        if( mBackgroundDiskCache )
+            mBackgroundDiskCache->_notifyPsoCreated( this, renderableCache, finalHash, retVal );
+
         return retVal;
     }
     //-----------------------------------------------------------------------------------
@@ -3657,6 +3925,8 @@ namespace Ogre
 
             if( !lastReturnedValue )
             {
+                recordPassCacheProperties( passCache );
+
                 // Low level is a special case because it doesn't (yet?) support parallel compilation
                 if( !parallelQueue || mType == HLMS_LOW_LEVEL )
                 {
@@ -3670,7 +3940,7 @@ namespace Ogre
                     lastReturnedValue = stubEntry;
 
                     parallelQueue->pushRequest(
-                        { &passCache, stubEntry, queuedRenderable, hash[0], finalHash } );
+                        { &passCache, stubEntry, queuedRenderable, hash[0], finalHash, nullptr } );
                 }
             }
         }
@@ -3714,11 +3984,13 @@ namespace Ogre
                 // Low level is a special case because it doesn't (yet?) support parallel compilation
                 if( mType != HLMS_LOW_LEVEL )
                 {
+                    recordPassCacheProperties( passCache );
+
                     // Create the entry now, but we'll fill it from a worker thread
                     HlmsCache *stubEntry = addStubShaderCache( finalHash );
                     parallelQueue.pushWarmUpRequest(
                         { reinterpret_cast<const HlmsCache *>( passCacheIdx ), stubEntry,
-                          queuedRenderable, hash[0], finalHash } );
+                          queuedRenderable, hash[0], finalHash, nullptr } );
                 }
             }
         }
@@ -3728,6 +4000,34 @@ namespace Ogre
         return lastReturnedValue;
     }
     //-----------------------------------------------------------------------------------
+    bool Hlms::_warmUpRecordedPso( const HlmsCache &passCache, const size_t passCacheIdx,
+                                   const uint32 renderableHash, const HlmsPso &recordedPso,
+                                   ParallelHlmsCompileQueue &parallelQueue )
+    {
+        OGRE_ASSERT_LOW( mType != HLMS_LOW_LEVEL );
+
+        const uint32 finalHash = renderableHash | passCache.hash;
+
+        if( this->getShaderCache( finalHash ) )
+            return false;
+
+        HlmsCache *stubEntry = addStubShaderCache( finalHash );
+        parallelQueue.pushWarmUpRequest( { reinterpret_cast<const HlmsCache *>( passCacheIdx ),
+                                           stubEntry, QueuedRenderable(), renderableHash, finalHash,
+                                           &recordedPso } );
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_compileRecordedPso( const HlmsCache &passCache, HlmsCache *reservedStubEntry,
+                                    uint32 renderableHash, uint32 finalHash,
+                                    const HlmsPso &recordedPso, size_t tid )
+    {
+        mT[tid].recordedPso = &recordedPso;
+        createShaderCacheEntry( renderableHash, passCache, finalHash, QueuedRenderable(),
+                                reservedStubEntry, tid );
+        mT[tid].recordedPso = 0;
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::setDebugOutputPath( bool enableDebugOutput, bool outputProperties, const String &path )
     {
         mDebugOutput = enableDebugOutput;
@@ -3877,6 +4177,7 @@ namespace Ogre
     void Hlms::_changeRenderSystem( RenderSystem *newRs )
     {
         clearShaderCache();
+        clearCompiledTemplates();
         mRenderSystem = newRs;
 
         mShaderProfile = "unset!";
@@ -0,0 +1,507 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreHlmsCompiledTemplate.h"
+
+#include "OgreStringConverter.h"
+
+namespace Ogre
+{
+    namespace
+    {
+        /// Keywords that Hlms::findBlockEnd relies on. A @foreach counter that is a prefix
+        /// of one of them would be substituted inside them by Hlms::repeat, altering the
+        /// structure of the template, which this class can't reproduce.
+        const char *c_structureKeywords[] = { "end", "else", "foreach", "property", "piece" };
+
+        bool isCounterVarSupported( const String &counterVar )
+        {
+            if( counterVar.empty() )
+                return true;
+
+            // Expression tokens are resolved one at a time, so the counter must not be able
+            // to turn into (or glue itself with) operators.
+            if( counterVar.find_first_of( "=<>!" ) != String::npos )
+                return false;
+
+            for( size_t i = 0u; i < sizeof( c_structureKeywords ) / sizeof( c_structureKeywords[0] );
+                 ++i )
+            {
+                if( !strncmp( c_structureKeywords[i], counterVar.c_str(), counterVar.size() ) )
+                    return false;
+            }
+
+            return true;
+        }
+
+        bool containsAt( const String &buffer, size_t start, size_t end )
+        {
+            return memchr( buffer.c_str() + start, '@', end - start ) != 0;
+        }
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    HlmsCompiledTemplate::HlmsCompiledTemplate( const String &source ) :
+        mOriginalSource( source ),
+        mValid( false )
+    {
+        Hlms::MathOpVec mathOps;
+        if( Hlms::stripMathOps( mOriginalSource, mSource, mathOps ) )
+            return;
+
+        mMathOps.reserve( mathOps.size() );
+
+        Hlms::MathOpVec::const_iterator itor = mathOps.begin();
+        Hlms::MathOpVec::const_iterator endt = mathOps.end();
+
+        while( itor != endt )
+        {
+            const StringVector &argValues = itor->args;
+            const size_t idx = argValues.size() == 3u ? 1u : 0u;
+
+            MathOp mathOp;
+            mathOp.opIdx = itor->opIdx;
+            mathOp.dstProperty = argValues[0];
+            mathOp.op1 = parseMathOperand( argValues[idx] );
+            mathOp.op2 = parseMathOperand( argValues[idx + 1u] );
+            mMathOps.push_back( mathOp );
+
+            ++itor;
+        }
+
+        mValid = compileBlock( 0u, mSource.size(), false, mNodes );
+        if( !mValid )
+            mNodes.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    HlmsCompiledTemplate::Operand HlmsCompiledTemplate::parseMathOperand( const String &arg )
+    {
+        // Same as Hlms::interpretAsNumberThenAsProperty
+        Operand retVal;
+        retVal.number = StringConverter::parseInt( arg, -std::numeric_limits<int>::max() );
+        retVal.isNumber = retVal.number != -std::numeric_limits<int>::max();
+        if( !retVal.isNumber )
+            retVal.property = arg;
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    HlmsCompiledTemplate::Operand HlmsCompiledTemplate::parseForeachOperand( const String &arg )
+    {
+        // Same as Hlms::parseForEach & Hlms::evaluateExpressionRecursive
+        Operand retVal;
+        char *endPtr;
+        retVal.number = static_cast<int32>( strtol( arg.c_str(), &endPtr, 10 ) );
+        retVal.isNumber = arg.c_str() != endPtr;
+        if( !retVal.isNumber )
+            retVal.property = arg;
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    inline int32 HlmsCompiledTemplate::resolve( const Operand &operand,
+                                                const HlmsPropertyVec &properties, int32 defaultVal )
+    {
+        if( operand.isNumber )
+            return operand.number;
+        return Hlms::getProperty( properties, operand.property, defaultVal );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsCompiledTemplate::applyCounters( const String &inBuffer, size_t start, size_t end,
+                                              const CounterVec &counters, String &outBuffer )
+    {
+        if( counters.size() == 1u )
+        {
+            Hlms::repeat( outBuffer, SubStringRef( &inBuffer, start, end ), end - start,
+                          counters[0].value, *counters[0].name );
+            return;
+        }
+
+        String tmp[2];
+        tmp[0].assign( inBuffer, start, end - start );
+
+        CounterVec::const_iterator itor = counters.begin();
+        CounterVec::const_iterator endt = counters.end();
+
+        while( itor != endt )
+        {
+            tmp[1].clear();
+            Hlms::repeat( tmp[1], SubStringRef( &tmp[0], 0u ), tmp[0].size(), itor->value,
+                          *itor->name );
+            tmp[0].swap( tmp[1] );
+            ++itor;
+        }
+
+        outBuffer += tmp[0];
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::parseForeachArgs( const String &inBuffer, size_t start, Node &outNode )
+    {
+        StringVector argValues;
+        bool syntaxError = false;
+
+        SubStringRef subString( &inBuffer, start );
+        Hlms::evaluateParamArgs( subString, argValues, syntaxError );
+
+        if( syntaxError )
+            return false;
+
+        outNode.count = parseForeachOperand( argValues[0] );
+        outNode.counterVar.clear();
+        if( argValues.size() > 1u )
+            outNode.counterVar = argValues[1];
+        outNode.startIdx = Operand();
+        if( argValues.size() > 2u )
+            outNode.startIdx = parseForeachOperand( argValues[2] );
+
+        return isCounterVarSupported( outNode.counterVar );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compileExpression( Hlms::ExpressionVec &expression,
+                                                  ExpressionTokenVec &outTokens, bool inForeach )
+    {
+        bool syntaxError = false;
+        Hlms::classifyExpression( expression, syntaxError );
+        if( syntaxError )
+            return false;
+
+        outTokens.resize( expression.size() );
+
+        for( size_t i = 0u; i < expression.size(); ++i )
+        {
+            Hlms::Expression &exp = expression[i];
+            ExpressionToken &token = outTokens[i];
+
+            token.type = static_cast<uint8>( exp.type );
+            token.negated = exp.negated;
+            token.isDynamic = false;
+
+            if( exp.type == Hlms::EXPR_VAR )
+            {
+                if( inForeach && exp.value.find( '@' ) != String::npos )
+                {
+                    token.isDynamic = true;
+                    token.value.swap( exp.value );
+                }
+                else
+                {
+                    token.operand = parseForeachOperand( exp.value );
+                }
+            }
+            else if( !compileExpression( exp.children, token.children, inForeach ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compileBlock( size_t start, size_t end, bool inForeach,
+                                             NodeVec &outNodes )
+    {
+        // This mirrors the offsets used by Hlms::parseForEach & Hlms::parseProperties,
+        // including the character they skip after the keyword and after each @end / @else.
+        // The text parser runs each pass over the output of the previous one, so any block
+        // where that skipped character falls outside its enclosing block (or is the start
+        // of another keyword) would be parsed differently; we bail out on those.
+        const size_t bufferSize = mSource.size();
+
+        SubStringRef subString( &mSource, start, end );
+
+        while( true )
+        {
+            const size_t posForeach = subString.find( "@foreach" );
+            const size_t posProperty = subString.find( "@property" );
+            const size_t pos = std::min( posForeach, posProperty );
+
+            const size_t textEnd = pos == String::npos ? end : subString.getStart() + pos;
+            if( textEnd != subString.getStart() )
+            {
+                outNodes.push_back( Node( NodeText, subString.getStart(), textEnd ) );
+                outNodes.back().isDynamic =
+                    inForeach && containsAt( mSource, subString.getStart(), textEnd );
+            }
+
+            if( pos == String::npos )
+                break;
+
+            const bool isForeach = posForeach < posProperty;
+            const size_t argsStart =
+                textEnd + ( isForeach ? sizeof( "@foreach" ) : sizeof( "@property" ) );
+            if( argsStart > end || mSource[argsStart - 1u] == '@' )
+                return false;
+
+            const size_t expEnd = Hlms::evaluateExpressionEnd( SubStringRef( &mSource, argsStart ) );
+            if( expEnd == String::npos || argsStart + expEnd >= end )
+                return false;
+
+            const size_t argsEnd = argsStart + expEnd;
+
+            bool syntaxError = false;
+            SubStringRef blockSubString( &mSource, argsEnd + 1u );
+            const bool isElse = Hlms::findBlockEnd( blockSubString, syntaxError, !isForeach );
+            if( syntaxError )
+                return false;
+
+            outNodes.push_back( Node( isForeach ? NodeForeach : NodeProperty, argsStart, argsEnd ) );
+            Node &node = outNodes.back();
+
+            if( isForeach )
+            {
+                node.isDynamic = inForeach && containsAt( mSource, argsStart, argsEnd );
+                if( !node.isDynamic && !parseForeachArgs( mSource, argsStart, node ) )
+                    return false;
+            }
+            else
+            {
+                Hlms::ExpressionVec expression;
+                if( Hlms::tokenizeExpression( SubStringRef( &mSource, argsStart, argsEnd ),
+                                              expression ) ||
+                    !compileExpression( expression, node.expression, inForeach ) )
+                {
+                    return false;
+                }
+            }
+
+            if( !compileBlock( blockSubString.getStart(), blockSubString.getEnd(),
+                               inForeach || isForeach, node.children ) )
+            {
+                return false;
+            }
+
+            if( isElse )
+            {
+                const size_t elseStart = blockSubString.getEnd() + sizeof( "@else" );
+                if( elseStart > end || mSource[elseStart - 1u] == '@' )
+                    return false;
+
+                blockSubString = SubStringRef( &mSource, elseStart );
+                Hlms::findBlockEnd( blockSubString, syntaxError );
+                if( syntaxError ||
+                    !compileBlock( blockSubString.getStart(), blockSubString.getEnd(), inForeach,
+                                   node.elseChildren ) )
+                {
+                    return false;
+                }
+            }
+
+            size_t nextStart = blockSubString.getEnd() + sizeof( "@end" );
+            if( nextStart > end )
+            {
+                // At the top level the text parser just clamps to the end of the buffer
+                if( end != bufferSize )
+                    return false;
+                nextStart = end;
+            }
+            else if( mSource[nextStart - 1u] == '@' )
+            {
+                return false;
+            }
+
+            subString = SubStringRef( &mSource, nextStart, end );
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    int32 HlmsCompiledTemplate::evaluate( const ExpressionTokenVec &expression,
+                                          const HlmsPropertyVec &properties,
+                                          const CounterVec &counters ) const
+    {
+        // Same as the last two steps of Hlms::evaluateExpressionRecursive
+        int32 retVal = 1;
+        uint8 nextOperation = Hlms::EXPR_VAR;
+
+        ExpressionTokenVec::const_iterator itor = expression.begin();
+        ExpressionTokenVec::const_iterator endt = expression.end();
+
+        while( itor != endt )
+        {
+            int32 result;
+            if( itor->type == Hlms::EXPR_VAR )
+            {
+                if( itor->isDynamic )
+                {
+                    String value;
+                    applyCounters( itor->value, 0u, itor->value.size(), counters, value );
+                    result = resolve( parseForeachOperand( value ), properties, 0 );
+                }
+                else
+                {
+                    result = resolve( itor->operand, properties, 0 );
+                }
+            }
+            else
+            {
+                result = evaluate( itor->children, properties, counters );
+            }
+
+            if( itor->negated )
+                result = !result;
+
+            switch( nextOperation )
+            {
+            case Hlms::EXPR_OPERATOR_OR:
+                retVal = ( retVal != 0 ) | ( result != 0 );
+                break;
+            case Hlms::EXPR_OPERATOR_AND:
+                retVal = ( retVal != 0 ) & ( result != 0 );
+                break;
+            case Hlms::EXPR_OPERATOR_LE:
+                retVal = retVal < result;
+                break;
+            case Hlms::EXPR_OPERATOR_LEEQ:
+                retVal = retVal <= result;
+                break;
+            case Hlms::EXPR_OPERATOR_EQ:
+                retVal = retVal == result;
+                break;
+            case Hlms::EXPR_OPERATOR_NEQ:
+                retVal = retVal != result;
+                break;
+            case Hlms::EXPR_OPERATOR_GR:
+                retVal = retVal > result;
+                break;
+            case Hlms::EXPR_OPERATOR_GREQ:
+                retVal = retVal >= result;
+                break;
+            default:
+                if( itor->type == Hlms::EXPR_OBJECT || itor->type == Hlms::EXPR_VAR )
+                    retVal = result;
+                break;
+            }
+
+            nextOperation = itor->type;
+
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::generate( const NodeVec &nodes, const HlmsPropertyVec &properties,
+                                         CounterVec &counters, String &outBuffer ) const
+    {
+        NodeVec::const_iterator itor = nodes.begin();
+        NodeVec::const_iterator endt = nodes.end();
+
+        while( itor != endt )
+        {
+            const Node &node = *itor;
+
+            switch( node.type )
+            {
+            case NodeText:
+                if( node.isDynamic )
+                    applyCounters( mSource, node.start, node.end, counters, outBuffer );
+                else
+                    outBuffer.append( mSource, node.start, node.end - node.start );
+                break;
+            case NodeProperty:
+            {
+                const bool result = evaluate( node.expression, properties, counters ) != 0;
+                if( !generate( result ? node.children : node.elseChildren, properties, counters,
+                               outBuffer ) )
+                {
+                    return false;
+                }
+                break;
+            }
+            case NodeForeach:
+            {
+                const Node *foreachArgs = &node;
+
+                Node dynamicArgs( NodeForeach, 0u, 0u );
+                if( node.isDynamic )
+                {
+                    String args;
+                    applyCounters( mSource, node.start, node.end, counters, args );
+                    // Hlms::evaluateExpressionEnd expects something after the ')'
+                    args.append( ") " );
+                    if( !parseForeachArgs( args, 0u, dynamicArgs ) )
+                        return false;
+                    foreachArgs = &dynamicArgs;
+                }
+
+                const int32 count = resolve( foreachArgs->count, properties, 0 );
+                const int32 start = resolve( foreachArgs->startIdx, properties, -1 );
+                if( start < 0 )
+                    return false;
+
+                for( int32 i = start; i < count; ++i )
+                {
+                    counters.push_back( Counter( &foreachArgs->counterVar, static_cast<size_t>( i ) ) );
+                    const bool success = generate( node.children, properties, counters, outBuffer );
+                    counters.pop_back();
+                    if( !success )
+                        return false;
+                }
+                break;
+            }
+            }
+
+            ++itor;
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::generate( HlmsPropertyVec &inOutProperties, String &outBuffer ) const
+    {
+        OGRE_ASSERT_LOW( mValid );
+
+        HlmsPropertyVec backupProperties;
+        if( !mMathOps.empty() )
+            backupProperties = inOutProperties;
+
+        MathOpVec::const_iterator itor = mMathOps.begin();
+        MathOpVec::const_iterator endt = mMathOps.end();
+
+        while( itor != endt )
+        {
+            const int32 op1Value = resolve( itor->op1, inOutProperties, 0 );
+            const int32 op2Value = resolve( itor->op2, inOutProperties, 0 );
+            Hlms::setProperty( inOutProperties, itor->dstProperty,
+                               Hlms::executeMathOp( itor->opIdx, op1Value, op2Value ) );
+            ++itor;
+        }
+
+        outBuffer.clear();
+        outBuffer.reserve( mSource.size() );
+
+        CounterVec counters;
+        if( !generate( mNodes, inOutProperties, counters, outBuffer ) )
+        {
+            if( !mMathOps.empty() )
+                inOutProperties.swap( backupProperties );
+            return false;
+        }
+
+        return true;
+    }
+}  // namespace Ogre
@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "OgreProfiler.h"
 #include "OgreString.h"
 #include "OgreStringConverter.h"
+#include "OgreTextureGpu.h"
 
 namespace Ogre
 {
@@ -603,6 +604,16 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     TextureGpu *HlmsDatablock::getEmissiveTexture() const { return 0; }
     //-----------------------------------------------------------------------------------
+    void HlmsDatablock::notifyTexturesUsed( float distanceToCamera )
+    {
+        TextureGpu *diffuseTex = getDiffuseTexture();
+        if( diffuseTex )
+            diffuseTex->notifyUsed( distanceToCamera );
+        TextureGpu *emissiveTex = getEmissiveTexture();
+        if( emissiveTex && emissiveTex != diffuseTex )
+            emissiveTex->notifyUsed( distanceToCamera );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDatablock::saveTextures( const String &folderPath, set<String>::type &savedTextures,
                                       bool saveOitd, bool saveOriginal,
                                       HlmsTextureExportListener *listener )
@@ -33,10 +33,20 @@ THE SOFTWARE.
 #include "OgreHlmsManager.h"
 #include "OgreLogManager.h"
 #include "OgreProfiler.h"
+#include "OgreRenderQueue.h"
 #include "OgreRenderSystem.h"
+#include "OgreSceneManager.h"
 #include "OgreStringConverter.h"
 #include "Threading/OgreThreads.h"
 
+#include "Hash/MurmurHash3.h"
+
+#if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+#    define OGRE_HASH128_FUNC MurmurHash3_x86_128
+#else
+#    define OGRE_HASH128_FUNC MurmurHash3_x64_128
+#endif
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
 #    include "iOS/macUtils.h"
 #endif
@@ -45,18 +55,66 @@ THE SOFTWARE.
 
 namespace Ogre
 {
-    static const uint16 c_hlmsDiskCacheVersion = 5u;
+    static const uint16 c_hlmsDiskCacheVersion = 7u;
+
+    /// How Pso::passCacheProperties is stored in a Pso record.
+    enum PassCachePropertiesEncoding
+    {
+        PassCachePropertiesUnknown,
+        /// Only the properties that differ from passProperties (see diffProperties).
+        PassCachePropertiesDiff,
+        PassCachePropertiesFull
+    };
+
+    /// Grows as it gets written. Records are serialized into it first, as the record's
+    /// header needs their size and hash.
+    class RecordDataStream final : public DataStream
+    {
+        vector<uint8>::type mData;
+
+    public:
+        RecordDataStream() : DataStream( WRITE ) {}
+
+        size_t read( void *, size_t ) override { return 0u; }
+        size_t write( const void *buf, size_t count ) override
+        {
+            const uint8 *data = reinterpret_cast<const uint8 *>( buf );
+            mData.insert( mData.end(), data, data + count );
+            mSize = mData.size();
+            return count;
+        }
+        void   skip( long ) override {}
+        void   seek( size_t ) override {}
+        size_t tell() const override { return mData.size(); }
+        bool   eof() const override { return true; }
+        void   close() override {}
+
+        const vector<uint8>::type &getData() const { return mData; }
+    };
+
+    static unsigned long backgroundSaveThread( ThreadHandle *threadHandle );
+    THREAD_DECLARE( backgroundSaveThread );
 
     HlmsDiskCache::HlmsDiskCache( HlmsManager *hlmsManager ) :
         mTemplatesOutOfDate( false ),
-        mHlmsManager( hlmsManager )
+        mHlmsManager( hlmsManager ),
+        mValidStreamSize( 0u ),
+        mAppliedTo( 0 ),
+        mBackgroundSaveHlms( 0 ),
+        mStopBackgroundSave( false )
     {
     }
     //-----------------------------------------------------------------------------------
-    HlmsDiskCache::~HlmsDiskCache() { clearCache(); }
+    HlmsDiskCache::~HlmsDiskCache()
+    {
+        stopBackgroundSave();
+        clearCache();
+    }
     //-----------------------------------------------------------------------------------
     void HlmsDiskCache::clearCache()
     {
+        OGRE_ASSERT_LOW( !mBackgroundSaveHlms && "Call stopBackgroundSave first!" );
+
         mTemplatesOutOfDate = false;
         memset( mCache.templateHash, 0, sizeof( mCache.templateHash ) );
         mCache.type = 255;
@@ -64,6 +122,9 @@ namespace Ogre
         mCache.pso.clear();
         mCache.datablockCustomPieceFiles.clear();
         mShaderProfile.clear();
+        mSavedRecords.clear();
+        mValidStreamSize = 0u;
+        mAppliedTo = 0;
 
         mNativeShadingLangVer = 0u;
         mPrecisionMode = Hlms::PrecisionFull32;
@@ -84,12 +145,20 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    HlmsDiskCache::SourceCode::SourceCode( const Hlms::PreprocessedShaderCode &preprocessedShaderCode ) :
+        mergedCache( preprocessedShaderCode.mergedCache )
+    {
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            this->sourceFile[i] = preprocessedShaderCode.source[i];
+    }
+    //-----------------------------------------------------------------------------------
     HlmsDiskCache::Pso::Pso() : renderableCache( HlmsPropertyVec(), 0 ) {}
     //-----------------------------------------------------------------------------------
     HlmsDiskCache::Pso::Pso( const Hlms::RenderableCache &srcRenderableCache,
                              const Hlms::PassCache &srcPassCache, const HlmsCache *srcPsoCache ) :
         renderableCache( srcRenderableCache ),
         passProperties( srcPassCache.properties ),
+        passCacheProperties( srcPassCache.passCacheProperties ),
         pso( srcPsoCache->pso ),
         macroblock( *srcPsoCache->pso.macroblock ),
         blendblock( *srcPsoCache->pso.blendblock )
@@ -135,21 +204,7 @@ namespace Ogre
 
             while( itor != endt )
             {
-                bool bCacheable = true;
-
-                for( size_t i = 0u; i < NumShaderTypes; ++i )
-                {
-                    const int32 customPieceName =
-                        hlms->getProperty( itor->mergedCache.setProperties,
-                                           HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
-                    if( customPieceName &&
-                        !hlms->isDatablockCustomPieceFileCacheable( customPieceName ) )
-                    {
-                        bCacheable = false;
-                    }
-                }
-
-                if( bCacheable )
+                if( isCacheable( hlms, itor->mergedCache.setProperties ) )
                 {
                     SourceCode sourceCode( *itor );
                     mCache.sourceCode.push_back( sourceCode );
@@ -158,6 +213,15 @@ namespace Ogre
             }
         }
 
+        {
+            // Copy shaders loaded from a cache that haven't been used yet (they're still cacheable)
+            ScopedLock lock( hlms->mMutex );
+            mCache.sourceCode.reserve( mCache.sourceCode.size() +
+                                       hlms->mPreprocessedShaderCode.size() );
+            for( const auto &itPair : hlms->mPreprocessedShaderCode )
+                mCache.sourceCode.push_back( SourceCode( itPair.second ) );
+        }
+
         {
             // Copy PSOs
             mCache.pso.reserve( hlms->mShaderCache.size() );
@@ -175,21 +239,7 @@ namespace Ogre
                 // const uint32 inputLayout    = (finalHash >> HlmsBits::InputLayoutShift) & //
                 //                              (uint32)HlmsBits::InputLayoutMask;
 
-                bool bCacheable = true;
-
-                for( size_t i = 0u; i < NumShaderTypes; ++i )
-                {
-                    const int32 customPieceName =
-                        hlms->getProperty( hlms->mRenderableCache[renderableIdx].setProperties,
-                                           HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
-                    if( customPieceName &&
-                        !hlms->isDatablockCustomPieceFileCacheable( customPieceName ) )
-                    {
-                        bCacheable = false;
-                    }
-                }
-
-                if( bCacheable )
+                if( isCacheable( hlms, hlms->mRenderableCache[renderableIdx].setProperties ) )
                 {
                     Pso pso( hlms->mRenderableCache[renderableIdx], hlms->mPassCache[passIdx], *itor );
                     mCache.pso.push_back( pso );
@@ -199,6 +249,70 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::isCacheable( const Hlms *hlms, const HlmsPropertyVec &properties )
+    {
+        for( size_t i = 0u; i < NumShaderTypes; ++i )
+        {
+            const int32 customPieceName =
+                Hlms::getProperty( properties, HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
+            if( customPieceName && !hlms->isDatablockCustomPieceFileCacheable( customPieceName ) )
+                return false;
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::addCustomPieceFiles( const Hlms *hlms, const HlmsPropertyVec &properties,
+                                             DatablockCustomPiecesCacheVec &outCustomPieceFiles )
+    {
+        for( size_t i = 0u; i < NumShaderTypes; ++i )
+        {
+            const int32 customPieceName =
+                Hlms::getProperty( properties, HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
+            if( customPieceName )
+            {
+                Hlms::DatablockCustomPieceFileMap::const_iterator itor =
+                    hlms->mDatablockCustomPieceFiles.find( customPieceName );
+                OGRE_ASSERT_LOW( itor != hlms->mDatablockCustomPieceFiles.end() );
+
+                DatablockCustomPiecesCache cacheEntry;
+                cacheEntry.filename = itor->second.filename;
+                cacheEntry.resourceGroup = itor->second.resourceGroup;
+                itor->second.getCodeChecksum( cacheEntry.sourceCodeHash );
+                outCustomPieceFiles.push_back( cacheEntry );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::diffProperties( const HlmsPropertyVec &baseProperties,
+                                        const HlmsPropertyVec &fullProperties,
+                                        HlmsPropertyVec &outDiff )
+    {
+        outDiff.clear();
+
+        size_t numInBase = 0u;
+        for( const HlmsProperty &property : fullProperties )
+        {
+            const size_t idx = findPropertyLowerBound( baseProperties, property.keyName );
+            if( idx != baseProperties.size() && baseProperties[idx].keyName == property.keyName )
+            {
+                ++numInBase;
+                if( baseProperties[idx].value == property.value )
+                    continue;
+            }
+            outDiff.push_back( property );
+        }
+
+        return numInBase == baseProperties.size();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::mergeProperties( HlmsPropertyVec &inOutProperties,
+                                         const HlmsPropertyVec &diff )
+    {
+        for( const HlmsProperty &property : diff )
+            Hlms::setProperty( inOutProperties, property.keyName, property.value );
+    }
+    //-----------------------------------------------------------------------------------
     struct CompilerJobParams
     {
         Hlms *hlms;
@@ -268,8 +382,10 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void HlmsDiskCache::applyTo( Hlms *hlms, const size_t numThreads )
+    void HlmsDiskCache::applyTo( Hlms *hlms, const size_t numThreads, const bool lazyCompilation )
     {
+        mAppliedTo = 0;
+
         LogManager::getSingleton().logMessage( "Applying HlmsDiskCache " +
                                                StringConverter::toString( hlms->getType() ) );
 
@@ -369,6 +485,17 @@ namespace Ogre
             }
         }
 
+        if( lazyCompilation )
+        {
+            // Compile shaders when they're first needed. If the templates changed, the cached
+            // source can't be used and shaders will be generated from the templates instead.
+            if( !mTemplatesOutOfDate )
+            {
+                for( const SourceCode &sourceCode : mCache.sourceCode )
+                    hlms->_addPreprocessedShaderCode( sourceCode.mergedCache, sourceCode.sourceFile );
+            }
+        }
+        else
         {
             CompilerJobParams jobParams( hlms, mCache.sourceCode, mTemplatesOutOfDate );
 
@@ -436,6 +563,111 @@ namespace Ogre
         }
 
         hlms->_tagShaderCodeCacheUpToDate();
+        mAppliedTo = hlms;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t HlmsDiskCache::warmUpPsos( Hlms *hlms, SceneManager *sceneManager )
+    {
+        if( mAppliedTo != hlms )
+        {
+            LogManager::getSingleton().logMessage(
+                "WARNING: HlmsDiskCache::warmUpPsos called without a successful applyTo on Hlms " +
+                StringConverter::toString( hlms->getType() ) + ". Skipping." );
+            return 0u;
+        }
+
+        OgreProfileBeginGroup( "HlmsDiskCache::warmUpPsos", OGREPROF_RENDERING );
+
+        RenderQueue *renderQueue = sceneManager->getRenderQueue();
+
+        size_t numPsos = 0u;
+
+        // loadFrom released the blocks right away, but the RenderSystem needs them active
+        // to create the PSOs. Hold a reference until the worker threads are done with them.
+        // Reserved upfront because the requests point into this vector.
+        vector<HlmsPso>::type recordedPsos;
+        recordedPsos.reserve( mCache.pso.size() );
+
+        for( const Pso &pso : mCache.pso )
+        {
+            // Recorded without the full pass properties. We can't rebuild it.
+            if( pso.passCacheProperties.empty() )
+                continue;
+
+            const uint32 renderableHash = hlms->addRenderableCache( pso.renderableCache.setProperties,
+                                                                    pso.renderableCache.pieces );
+
+            Hlms::PassCache passCacheKey;
+            passCacheKey.passPso = pso.pso.pass;
+            passCacheKey.properties = pso.passProperties;
+
+            Hlms::PassCacheVec::iterator it =
+                std::find( hlms->mPassCache.begin(), hlms->mPassCache.end(), passCacheKey );
+            if( it == hlms->mPassCache.end() )
+            {
+                assert( hlms->mPassCache.size() <= (uint32)HlmsBits::PassMask &&
+                        "Too many passes combinations, we'll overflow "
+                        "the bits assigned in the hash!" );
+                hlms->mPassCache.push_back( passCacheKey );
+                it = hlms->mPassCache.end() - 1u;
+            }
+
+            // Record them again if the Hlms appends to this cache
+            if( it->passCacheProperties.empty() )
+                it->passCacheProperties = pso.passCacheProperties;
+
+            // Rebuild what Hlms::preparePassHash would've returned for this pass
+            const uint32 passHash = static_cast<uint32>( it - hlms->mPassCache.begin() )
+                                    << HlmsBits::PassShift;
+            HlmsCache passCache( passHash, hlms->getType(), HlmsPso() );
+            passCache.setProperties = pso.passCacheProperties;
+            passCache.pso.pass = pso.pso.pass;
+
+            recordedPsos.push_back( pso.pso );
+            HlmsPso &recordedPso = recordedPsos.back();
+            recordedPso.macroblock = mHlmsManager->getMacroblock( pso.macroblock );
+            recordedPso.blendblock = mHlmsManager->getBlendblock( pso.blendblock );
+
+            if( renderQueue->warmUpRecordedPso( hlms, passCache, renderableHash, recordedPso ) )
+            {
+                ++numPsos;
+            }
+            else
+            {
+                mHlmsManager->destroyMacroblock( recordedPso.macroblock );
+                mHlmsManager->destroyBlendblock( recordedPso.blendblock );
+                recordedPsos.pop_back();
+            }
+        }
+
+        renderQueue->warmUpShadersTrigger( hlms->getRenderSystem() );
+
+        for( const HlmsPso &recordedPso : recordedPsos )
+        {
+            mHlmsManager->destroyMacroblock( recordedPso.macroblock );
+            mHlmsManager->destroyBlendblock( recordedPso.blendblock );
+        }
+
+        OgreProfileEndGroup( "HlmsDiskCache::warmUpPsos", OGREPROF_RENDERING );
+
+        LogManager::getSingleton().logMessage( "HlmsDiskCache: Built " +
+                                               StringConverter::toString( numPsos ) +
+                                               " recorded PSOs for Hlms " +
+                                               StringConverter::toString( hlms->getType() ) );
+
+        return numPsos;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::canAppendTo( const Hlms *hlms ) const
+    {
+#if OGRE_DEBUG_STR_SIZE > 0
+        const uint16 debugStrSize = OGRE_DEBUG_STR_SIZE;
+#else
+        const uint16 debugStrSize = 0u;
+#endif
+        // Records we'd append must be in the same format as the ones already in the file
+        return mAppliedTo == hlms && !mTemplatesOutOfDate && mValidStreamSize > 0u &&
+               mDebugStrSize == debugStrSize;
     }
     //-----------------------------------------------------------------------------------
     template <typename T>
@@ -503,112 +735,161 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void HlmsDiskCache::saveTo( DataStreamPtr &dataStream )
+    void HlmsDiskCache::save( DataStreamPtr &dataStream,
+                              const DatablockCustomPiecesCache &datablockPiece )
     {
-        LogManager::getSingleton().logMessage( "Saving HlmsDiskCache to " + dataStream->getName() );
-
-        write<uint16>( dataStream, c_hlmsDiskCacheVersion );
-#if OGRE_DEBUG_STR_SIZE > 0
-        write<uint16>( dataStream, OGRE_DEBUG_STR_SIZE );
-#else
-        write<uint16>( dataStream, 0 );
-#endif
-        write<uint16>( dataStream, OGRE_HASH_BITS );
-        write( dataStream, mCache.templateHash );
-        write( dataStream, mCache.type );
-        save( dataStream, mShaderProfile );
+        write( dataStream, datablockPiece.sourceCodeHash );
+        save( dataStream, datablockPiece.filename );
+        save( dataStream, datablockPiece.resourceGroup );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::save( DataStreamPtr &dataStream, const SourceCode &sourceCode )
+    {
+        save( dataStream, sourceCode.mergedCache );
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            save( dataStream, sourceCode.sourceFile[i] );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::save( DataStreamPtr &dataStream, const Pso &pso )
+    {
+        // Macroblock, Blendblock & InputLayoutId change between runs. They're redundant (the
+        // blocks & vertex elements are saved) and loadFrom sets them again, so skip them.
+        // This also lets duplicates be detected.
+        Hlms::RenderableCache renderableCache( HlmsPropertyVec(), pso.renderableCache.pieces );
+        renderableCache.setProperties.reserve( pso.renderableCache.setProperties.size() );
+        for( const HlmsProperty &property : pso.renderableCache.setProperties )
+        {
+            if( property.keyName != HlmsPsoProp::Macroblock &&
+                property.keyName != HlmsPsoProp::Blendblock &&
+                property.keyName != HlmsPsoProp::InputLayoutId )
+            {
+                renderableCache.setProperties.push_back( property );
+            }
+        }
 
-        write<uint16>( dataStream, mNativeShadingLangVer );
-        write<uint8>( dataStream, mPrecisionMode );
-        write<bool>( dataStream, mFastShaderBuildHack );
+        save( dataStream, renderableCache );
+        save( dataStream, pso.passProperties );
 
-        write<uint32>( dataStream, static_cast<uint32>( mCache.datablockCustomPieceFiles.size() ) );
-        for( const DatablockCustomPiecesCache &datablockPiece : mCache.datablockCustomPieceFiles )
+        // passCacheProperties are mostly the same as passProperties. Only save the difference
+        if( pso.passCacheProperties.empty() )
+            write<uint8>( dataStream, PassCachePropertiesUnknown );
+        else
         {
-            write( dataStream, datablockPiece.sourceCodeHash );
-            save( dataStream, datablockPiece.filename );
-            save( dataStream, datablockPiece.resourceGroup );
+            HlmsPropertyVec passPropertiesDiff;
+            if( diffProperties( pso.passProperties, pso.passCacheProperties, passPropertiesDiff ) )
+            {
+                write<uint8>( dataStream, PassCachePropertiesDiff );
+                save( dataStream, passPropertiesDiff );
+            }
+            else
+            {
+                write<uint8>( dataStream, PassCachePropertiesFull );
+                save( dataStream, pso.passCacheProperties );
+            }
         }
 
-        {
-            // Save shaders
-            write<uint32>( dataStream, static_cast<uint32>( mCache.sourceCode.size() ) );
+        write<uint32>( dataStream, static_cast<uint32>( pso.pso.vertexElements.size() ) );
+        VertexElement2VecVec::const_iterator itElem = pso.pso.vertexElements.begin();
+        VertexElement2VecVec::const_iterator enElem = pso.pso.vertexElements.end();
 
-            SourceCodeVec::const_iterator itor = mCache.sourceCode.begin();
-            SourceCodeVec::const_iterator endt = mCache.sourceCode.end();
+        while( itElem != enElem )
+        {
+            write<uint32>( dataStream, static_cast<uint32>( itElem->size() ) );
+            VertexElement2Vec::const_iterator itElem2 = itElem->begin();
+            VertexElement2Vec::const_iterator enElem2 = itElem->end();
 
-            while( itor != endt )
+            while( itElem2 != enElem2 )
             {
-                save( dataStream, itor->mergedCache );
-                for( size_t i = 0; i < NumShaderTypes; ++i )
-                    save( dataStream, itor->sourceFile[i] );
-
-                ++itor;
+                write( dataStream, itElem2->mType );
+                write( dataStream, itElem2->mSemantic );
+                write( dataStream, itElem2->mInstancingStepRate );
+                ++itElem2;
             }
+
+            ++itElem;
         }
 
-        {
-            // Save PSOs
-            write<uint32>( dataStream, static_cast<uint32>( mCache.pso.size() ) );
+        write( dataStream, pso.pso.operationType );
+        write( dataStream, pso.pso.enablePrimitiveRestart );
+        write( dataStream, pso.pso.sampleMask );
+        write( dataStream, pso.pso.pass );
+
+        write( dataStream, pso.macroblock.mScissorTestEnabled );
+        write( dataStream, pso.macroblock.mDepthClamp );
+        write( dataStream, pso.macroblock.mDepthCheck );
+        write( dataStream, pso.macroblock.mDepthWrite );
+        write( dataStream, pso.macroblock.mDepthFunc );
+        write( dataStream, pso.macroblock.mDepthBiasConstant );
+        write( dataStream, pso.macroblock.mDepthBiasSlopeScale );
+        write( dataStream, pso.macroblock.mCullMode );
+        write( dataStream, pso.macroblock.mPolygonMode );
+
+        write( dataStream, pso.blendblock.mAlphaToCoverage );
+        write( dataStream, pso.blendblock.mBlendChannelMask );
+        write<uint8>( dataStream, pso.blendblock.mIsTransparent & 0x02u );
+        write( dataStream, pso.blendblock.mSeparateBlend );
+        write( dataStream, pso.blendblock.mSourceBlendFactor );
+        write( dataStream, pso.blendblock.mDestBlendFactor );
+        write( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
+        write( dataStream, pso.blendblock.mDestBlendFactorAlpha );
+        write( dataStream, pso.blendblock.mBlendOperation );
+        write( dataStream, pso.blendblock.mBlendOperationAlpha );
+    }
+    //-----------------------------------------------------------------------------------
+    template <typename T>
+    void HlmsDiskCache::saveRecord( DataStreamPtr &dataStream, RecordType recordType, const T &entry )
+    {
+        RecordDataStream *recordData = OGRE_NEW RecordDataStream();
+        DataStreamPtr recordStream( recordData );
+        write<uint8>( recordStream, static_cast<uint8>( recordType ) );
+        save( recordStream, entry );
 
-            PsoVec::const_iterator itor = mCache.pso.begin();
-            PsoVec::const_iterator endt = mCache.pso.end();
+        const vector<uint8>::type &payload = recordData->getData();
 
-            while( itor != endt )
-            {
-                save( dataStream, itor->renderableCache );
-                save( dataStream, itor->passProperties );
+        uint64 hash[2];
+        OGRE_HASH128_FUNC( payload.data(), static_cast<int>( payload.size() ), IdString::Seed, hash );
 
-                write<uint32>( dataStream, static_cast<uint32>( itor->pso.vertexElements.size() ) );
-                VertexElement2VecVec::const_iterator itElem = itor->pso.vertexElements.begin();
-                VertexElement2VecVec::const_iterator enElem = itor->pso.vertexElements.end();
+        if( !mSavedRecords.insert( hash[0] ).second )
+            return;  // Already in the file
 
-                while( itElem != enElem )
-                {
-                    write<uint32>( dataStream, static_cast<uint32>( itElem->size() ) );
-                    VertexElement2Vec::const_iterator itElem2 = itElem->begin();
-                    VertexElement2Vec::const_iterator enElem2 = itElem->end();
+        write<uint32>( dataStream, static_cast<uint32>( payload.size() ) );
+        write( dataStream, hash );
+        dataStream->write( payload.data(), payload.size() );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::writeHeader( DataStreamPtr &dataStream )
+    {
+        write<uint16>( dataStream, c_hlmsDiskCacheVersion );
+#if OGRE_DEBUG_STR_SIZE > 0
+        write<uint16>( dataStream, OGRE_DEBUG_STR_SIZE );
+#else
+        write<uint16>( dataStream, 0 );
+#endif
+        write<uint16>( dataStream, OGRE_HASH_BITS );
+        write( dataStream, mCache.templateHash );
+        write( dataStream, mCache.type );
+        save( dataStream, mShaderProfile );
 
-                    while( itElem2 != enElem2 )
-                    {
-                        write( dataStream, itElem2->mType );
-                        write( dataStream, itElem2->mSemantic );
-                        write( dataStream, itElem2->mInstancingStepRate );
-                        ++itElem2;
-                    }
+        write<uint16>( dataStream, mNativeShadingLangVer );
+        write<uint8>( dataStream, mPrecisionMode );
+        write<bool>( dataStream, mFastShaderBuildHack );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveTo( DataStreamPtr &dataStream )
+    {
+        LogManager::getSingleton().logMessage( "Saving HlmsDiskCache to " + dataStream->getName() );
 
-                    ++itElem;
-                }
+        writeHeader( dataStream );
 
-                write( dataStream, itor->pso.operationType );
-                write( dataStream, itor->pso.enablePrimitiveRestart );
-                write( dataStream, itor->pso.sampleMask );
-                write( dataStream, itor->pso.pass );
-
-                write( dataStream, itor->macroblock.mScissorTestEnabled );
-                write( dataStream, itor->macroblock.mDepthClamp );
-                write( dataStream, itor->macroblock.mDepthCheck );
-                write( dataStream, itor->macroblock.mDepthWrite );
-                write( dataStream, itor->macroblock.mDepthFunc );
-                write( dataStream, itor->macroblock.mDepthBiasConstant );
-                write( dataStream, itor->macroblock.mDepthBiasSlopeScale );
-                write( dataStream, itor->macroblock.mCullMode );
-                write( dataStream, itor->macroblock.mPolygonMode );
-
-                write( dataStream, itor->blendblock.mAlphaToCoverage );
-                write( dataStream, itor->blendblock.mBlendChannelMask );
-                write<uint8>( dataStream, itor->blendblock.mIsTransparent & 0x02u );
-                write( dataStream, itor->blendblock.mSeparateBlend );
-                write( dataStream, itor->blendblock.mSourceBlendFactor );
-                write( dataStream, itor->blendblock.mDestBlendFactor );
-                write( dataStream, itor->blendblock.mSourceBlendFactorAlpha );
-                write( dataStream, itor->blendblock.mDestBlendFactorAlpha );
-                write( dataStream, itor->blendblock.mBlendOperation );
-                write( dataStream, itor->blendblock.mBlendOperationAlpha );
+        mSavedRecords.clear();
 
-                ++itor;
-            }
-        }
+        // Custom piece files must come first, as the other records may need them
+        for( const DatablockCustomPiecesCache &datablockPiece : mCache.datablockCustomPieceFiles )
+            saveRecord( dataStream, RecordDatablockCustomPieces, datablockPiece );
+        for( const SourceCode &sourceCode : mCache.sourceCode )
+            saveRecord( dataStream, RecordSourceCode, sourceCode );
+        for( const Pso &pso : mCache.pso )
+            saveRecord( dataStream, RecordPso, pso );
     }
     //-----------------------------------------------------------------------------------
     template <typename T>
@@ -706,6 +987,109 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::load( DataStreamPtr &dataStream, DatablockCustomPiecesCache &datablockPiece )
+    {
+        read( dataStream, datablockPiece.sourceCodeHash );
+        load( dataStream, datablockPiece.filename );
+        load( dataStream, datablockPiece.resourceGroup );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::load( DataStreamPtr &dataStream, SourceCode &sourceCode )
+    {
+        load( dataStream, sourceCode.mergedCache );
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            load( dataStream, sourceCode.sourceFile[i] );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::load( DataStreamPtr &dataStream, Pso &pso )
+    {
+        pso.pso.vertexElements.clear();
+
+        load( dataStream, pso.renderableCache );
+        load( dataStream, pso.passProperties );
+
+        pso.passCacheProperties.clear();
+        const uint8 passCachePropertiesEncoding = read<uint8>( dataStream );
+        if( passCachePropertiesEncoding == PassCachePropertiesDiff )
+        {
+            HlmsPropertyVec passPropertiesDiff;
+            load( dataStream, passPropertiesDiff );
+            pso.passCacheProperties = pso.passProperties;
+            mergeProperties( pso.passCacheProperties, passPropertiesDiff );
+        }
+        else if( passCachePropertiesEncoding == PassCachePropertiesFull )
+        {
+            load( dataStream, pso.passCacheProperties );
+        }
+
+        const uint32 numVertexElements = read<uint32>( dataStream );
+        pso.pso.vertexElements.reserve( numVertexElements );
+
+        for( size_t j = 0; j < numVertexElements; ++j )
+        {
+            pso.pso.vertexElements.push_back( VertexElement2Vec() );
+            VertexElement2Vec &vertexElements = pso.pso.vertexElements.back();
+
+            const uint32 numVertexElements2 = read<uint32>( dataStream );
+            vertexElements.reserve( numVertexElements2 );
+
+            for( size_t k = 0; k < numVertexElements2; ++k )
+            {
+                VertexElementType type = read<VertexElementType>( dataStream );
+                VertexElementSemantic semantic = read<VertexElementSemantic>( dataStream );
+                uint32 instancingStepRate = read<uint32>( dataStream );
+                vertexElements.push_back( VertexElement2( type, semantic ) );
+                vertexElements.back().mInstancingStepRate = instancingStepRate;
+            }
+        }
+
+        read( dataStream, pso.pso.operationType );
+        read( dataStream, pso.pso.enablePrimitiveRestart );
+        read( dataStream, pso.pso.sampleMask );
+        read( dataStream, pso.pso.pass );
+
+        read( dataStream, pso.macroblock.mScissorTestEnabled );
+        read( dataStream, pso.macroblock.mDepthClamp );
+        read( dataStream, pso.macroblock.mDepthCheck );
+        read( dataStream, pso.macroblock.mDepthWrite );
+        read( dataStream, pso.macroblock.mDepthFunc );
+        read( dataStream, pso.macroblock.mDepthBiasConstant );
+        read( dataStream, pso.macroblock.mDepthBiasSlopeScale );
+        read( dataStream, pso.macroblock.mCullMode );
+        read( dataStream, pso.macroblock.mPolygonMode );
+
+        read( dataStream, pso.blendblock.mAlphaToCoverage );
+        read( dataStream, pso.blendblock.mBlendChannelMask );
+        read( dataStream, pso.blendblock.mIsTransparent );
+        read( dataStream, pso.blendblock.mSeparateBlend );
+        read( dataStream, pso.blendblock.mSourceBlendFactor );
+        read( dataStream, pso.blendblock.mDestBlendFactor );
+        read( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
+        read( dataStream, pso.blendblock.mDestBlendFactorAlpha );
+        read( dataStream, pso.blendblock.mBlendOperation );
+        read( dataStream, pso.blendblock.mBlendOperationAlpha );
+
+        // We retrieve the Macroblock & Blendblock from HlmsManager and immediately remove them
+        // This allows us to create a permanent pointer, while the actual internal pointer is
+        // released (i.e. it becomes inactive)
+        pso.pso.macroblock = mHlmsManager->getMacroblock( pso.macroblock );
+        mHlmsManager->destroyMacroblock( pso.pso.macroblock );
+
+        pso.pso.blendblock = mHlmsManager->getBlendblock( pso.blendblock );
+        mHlmsManager->destroyBlendblock( pso.pso.blendblock );
+
+        uint16 inputLayoutId =
+            mHlmsManager->_getInputLayoutId( pso.pso.vertexElements, pso.pso.operationType );
+
+        // Reset these properties because they may be different now
+        Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Macroblock,
+                           pso.pso.macroblock->mLifetimeId );
+        Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Blendblock,
+                           pso.pso.blendblock->mLifetimeId );
+        Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::InputLayoutId,
+                           inputLayoutId );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDiskCache::loadFrom( DataStreamPtr &dataStream )
     {
         LogManager::getSingleton().logMessage( "Loading HlmsDiskCache from " + dataStream->getName() );
@@ -749,116 +1133,203 @@ namespace Ogre
         read<uint8>( dataStream, mPrecisionMode );
         read<bool>( dataStream, mFastShaderBuildHack );
 
+        mValidStreamSize = dataStream->tell();
+
+        // 0 if unknown
+        const size_t streamSize = dataStream->size();
+
+        vector<uint8>::type payload;
+
+        while( true )
         {
-            // Load datablock's custom pieces
-            // (Those that came from files. The ones from memory cannot be cached).
-            const uint32 numPieceFiles = read<uint32>( dataStream );
-            mCache.datablockCustomPieceFiles.reserve( numPieceFiles );
-            for( size_t i = 0u; i < numPieceFiles; ++i )
+            uint32 payloadSize = 0u;
+            uint64 hash[2];
+            if( dataStream->read( &payloadSize, sizeof( payloadSize ) ) != sizeof( payloadSize ) )
+                break;  // End of file
+
+            // A record only partially written (e.g. the app crashed while saving) or
+            // garbage past it fails these checks. Everything after it is ignored.
+            bool bValidRecord = payloadSize > 0u &&
+                                dataStream->read( hash, sizeof( hash ) ) == sizeof( hash );
+            if( bValidRecord && streamSize > 0u )
+                bValidRecord = payloadSize <= streamSize - dataStream->tell();
+            if( bValidRecord )
             {
-                DatablockCustomPiecesCache datablockPiece;
-                read( dataStream, datablockPiece.sourceCodeHash );
-                load( dataStream, datablockPiece.filename );
-                load( dataStream, datablockPiece.resourceGroup );
-                mCache.datablockCustomPieceFiles.emplace_back( datablockPiece );
+                payload.resize( payloadSize );
+                bValidRecord = dataStream->read( payload.data(), payloadSize ) == payloadSize;
+            }
+            if( bValidRecord )
+            {
+                uint64 payloadHash[2];
+                OGRE_HASH128_FUNC( payload.data(), static_cast<int>( payloadSize ), IdString::Seed,
+                                   payloadHash );
+                bValidRecord = payloadHash[0] == hash[0] && payloadHash[1] == hash[1];
             }
-        }
 
-        {
-            // Load shaders
-            uint32 numEntries = read<uint32>( dataStream );
-            mCache.sourceCode.reserve( numEntries );
+            if( !bValidRecord )
+            {
+                LogManager::getSingleton().logMessage(
+                    "HlmsDiskCache: Found an incomplete record. Ignoring the rest of the file." );
+                break;
+            }
+
+            mValidStreamSize = dataStream->tell();
+
+            if( !mSavedRecords.insert( hash[0] ).second )
+                continue;  // Duplicated
+
+            DataStreamPtr recordStream(
+                OGRE_NEW MemoryDataStream( payload.data(), payloadSize, false, true ) );
 
-            SourceCode sourceCode;
-            for( size_t i = 0; i < numEntries; ++i )
+            const uint8 recordType = read<uint8>( recordStream );
+            switch( recordType )
             {
-                load( dataStream, sourceCode.mergedCache );
-                for( size_t j = 0; j < NumShaderTypes; ++j )
-                    load( dataStream, sourceCode.sourceFile[j] );
+            case RecordDatablockCustomPieces:
+            {
+                DatablockCustomPiecesCache datablockPiece;
+                load( recordStream, datablockPiece );
+                mCache.datablockCustomPieceFiles.emplace_back( datablockPiece );
+                break;
+            }
+            case RecordSourceCode:
+            {
+                SourceCode sourceCode;
+                load( recordStream, sourceCode );
                 mCache.sourceCode.push_back( sourceCode );
+                break;
+            }
+            case RecordPso:
+            {
+                Pso pso;
+                load( recordStream, pso );
+                mCache.pso.push_back( pso );
+                break;
+            }
+            default:
+                // Unknown record. Written by a newer version? Skip it.
+                break;
             }
         }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::startBackgroundSave( Hlms *hlms, DataStreamPtr &dataStream )
+    {
+        OGRE_ASSERT_LOW( !mBackgroundSaveHlms && "Already saving in the background!" );
+        OGRE_ASSERT_LOW( !hlms->mBackgroundDiskCache &&
+                         "Another HlmsDiskCache is already saving this Hlms in the background!" );
 
+        if( canAppendTo( hlms ) )
+        {
+            LogManager::getSingleton().logMessage( "Appending new entries to HlmsDiskCache " +
+                                                   dataStream->getName() );
+            // Overwrite whatever comes after the last valid record
+            dataStream->seek( mValidStreamSize );
+        }
+        else
         {
-            // Load PSOs
-            const uint32 numEntries = read<uint32>( dataStream );
-            mCache.pso.reserve( numEntries );
+            copyFrom( hlms );
+            saveTo( dataStream );
+        }
 
-            Pso pso;
-            for( size_t i = 0; i < numEntries; ++i )
-            {
-                load( dataStream, pso.renderableCache );
-                load( dataStream, pso.passProperties );
+        mBackgroundSaveStream = dataStream;
+        mStopBackgroundSave = false;
+        mBackgroundSaveThread =
+            Threads::CreateThread( THREAD_GET( backgroundSaveThread ), 0, this );
 
-                const uint32 numVertexElements = read<uint32>( dataStream );
-                pso.pso.vertexElements.reserve( numVertexElements );
+        mBackgroundSaveHlms = hlms;
+        hlms->mBackgroundDiskCache = this;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::stopBackgroundSave()
+    {
+        if( !mBackgroundSaveHlms )
+            return;
 
-                for( size_t j = 0; j < numVertexElements; ++j )
-                {
-                    pso.pso.vertexElements.push_back( VertexElement2Vec() );
-                    VertexElement2Vec &vertexElements = pso.pso.vertexElements.back();
+        mBackgroundSaveHlms->mBackgroundDiskCache = 0;
+        mBackgroundSaveHlms = 0;
 
-                    const uint32 numVertexElements2 = read<uint32>( dataStream );
-                    vertexElements.reserve( numVertexElements2 );
+        {
+            ScopedLock lock( mPendingMutex );
+            mStopBackgroundSave = true;
+        }
+        mBackgroundSaveEvent.wake();
+        Threads::WaitForThreads( 1u, &mBackgroundSaveThread );
+        mBackgroundSaveThread.reset();
+        mBackgroundSaveStream.reset();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::_notifyShaderCodeCacheEntryCreated( const Hlms *hlms,
+                                                            const Hlms::ShaderCodeCache &codeCache )
+    {
+        const HlmsPropertyVec &properties = codeCache.mergedCache.setProperties;
+        if( !isCacheable( hlms, properties ) )
+            return;
 
-                    for( size_t k = 0; k < numVertexElements2; ++k )
-                    {
-                        VertexElementType type = read<VertexElementType>( dataStream );
-                        VertexElementSemantic semantic = read<VertexElementSemantic>( dataStream );
-                        uint32 instancingStepRate = read<uint32>( dataStream );
-                        vertexElements.push_back( VertexElement2( type, semantic ) );
-                        vertexElements.back().mInstancingStepRate = instancingStepRate;
-                    }
-                }
+        SourceCode sourceCode( codeCache );
 
-                read( dataStream, pso.pso.operationType );
-                read( dataStream, pso.pso.enablePrimitiveRestart );
-                read( dataStream, pso.pso.sampleMask );
-                read( dataStream, pso.pso.pass );
-
-                read( dataStream, pso.macroblock.mScissorTestEnabled );
-                read( dataStream, pso.macroblock.mDepthClamp );
-                read( dataStream, pso.macroblock.mDepthCheck );
-                read( dataStream, pso.macroblock.mDepthWrite );
-                read( dataStream, pso.macroblock.mDepthFunc );
-                read( dataStream, pso.macroblock.mDepthBiasConstant );
-                read( dataStream, pso.macroblock.mDepthBiasSlopeScale );
-                read( dataStream, pso.macroblock.mCullMode );
-                read( dataStream, pso.macroblock.mPolygonMode );
-
-                read( dataStream, pso.blendblock.mAlphaToCoverage );
-                read( dataStream, pso.blendblock.mBlendChannelMask );
-                read( dataStream, pso.blendblock.mIsTransparent );
-                read( dataStream, pso.blendblock.mSeparateBlend );
-                read( dataStream, pso.blendblock.mSourceBlendFactor );
-                read( dataStream, pso.blendblock.mDestBlendFactor );
-                read( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
-                read( dataStream, pso.blendblock.mDestBlendFactorAlpha );
-                read( dataStream, pso.blendblock.mBlendOperation );
-                read( dataStream, pso.blendblock.mBlendOperationAlpha );
-
-                // We retrieve the Macroblock & Blendblock from HlmsManager and immediately remove them
-                // This allows us to create a permanent pointer, while the actual internal pointer is
-                // released (i.e. it becomes inactive)
-                pso.pso.macroblock = mHlmsManager->getMacroblock( pso.macroblock );
-                mHlmsManager->destroyMacroblock( pso.pso.macroblock );
-
-                pso.pso.blendblock = mHlmsManager->getBlendblock( pso.blendblock );
-                mHlmsManager->destroyBlendblock( pso.pso.blendblock );
-
-                uint16 inputLayoutId =
-                    mHlmsManager->_getInputLayoutId( pso.pso.vertexElements, pso.pso.operationType );
-
-                // Reset these properties because they may be different now
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Macroblock,
-                                   pso.pso.macroblock->mLifetimeId );
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Blendblock,
-                                   pso.pso.blendblock->mLifetimeId );
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::InputLayoutId,
-                                   inputLayoutId );
+        ScopedLock lock( mPendingMutex );
+        addCustomPieceFiles( hlms, properties, mPendingCustomPieceFiles );
+        mPendingSourceCode.push_back( sourceCode );
+        mBackgroundSaveEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::_notifyPsoCreated( const Hlms *hlms,
+                                           const Hlms::RenderableCache &renderableCache,
+                                           uint32 finalHash, const HlmsCache *psoCache )
+    {
+        if( !isCacheable( hlms, renderableCache.setProperties ) )
+            return;
 
-                mCache.pso.push_back( pso );
+        const uint32 passIdx = ( finalHash >> HlmsBits::PassShift ) &  //
+                               (uint32)HlmsBits::PassMask;
+        Pso pso( renderableCache, hlms->mPassCache[passIdx], psoCache );
+
+        ScopedLock lock( mPendingMutex );
+        addCustomPieceFiles( hlms, renderableCache.setProperties, mPendingCustomPieceFiles );
+        mPendingPso.push_back( pso );
+        mBackgroundSaveEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    static unsigned long backgroundSaveThread( ThreadHandle *threadHandle )
+    {
+        Threads::SetThreadName( threadHandle, "HlmsDiskCache" );
+
+        HlmsDiskCache *diskCache = reinterpret_cast<HlmsDiskCache *>( threadHandle->getUserParam() );
+        return diskCache->_backgroundSaveThread();
+    }
+    //-----------------------------------------------------------------------------------
+    unsigned long HlmsDiskCache::_backgroundSaveThread()
+    {
+        DatablockCustomPiecesCacheVec customPieceFiles;
+        SourceCodeVec sourceCode;
+        PsoVec pso;
+
+        bool bStop = false;
+        while( !bStop )
+        {
+            mBackgroundSaveEvent.wait();
+
+            {
+                ScopedLock lock( mPendingMutex );
+                customPieceFiles.swap( mPendingCustomPieceFiles );
+                sourceCode.swap( mPendingSourceCode );
+                pso.swap( mPendingPso );
+                bStop = mStopBackgroundSave;
             }
+
+            // Custom piece files must come first, as the other records may need them
+            for( const DatablockCustomPiecesCache &datablockPiece : customPieceFiles )
+                saveRecord( mBackgroundSaveStream, RecordDatablockCustomPieces, datablockPiece );
+            for( const SourceCode &entry : sourceCode )
+                saveRecord( mBackgroundSaveStream, RecordSourceCode, entry );
+            for( const Pso &entry : pso )
+                saveRecord( mBackgroundSaveStream, RecordPso, entry );
+
+            customPieceFiles.clear();
+            sourceCode.clear();
+            pso.clear();
         }
+
+        return 0;
     }
 }  // namespace Ogre
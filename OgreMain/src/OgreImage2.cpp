@@ -41,11 +41,165 @@ THE SOFTWARE.
 #include "OgreResourceGroupManager.h"
 #include "OgreStagingTexture.h"
 #include "OgreTextureGpuManager.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 namespace Ogre
 {
+    namespace
+    {
+        /// Returns the SIMD version of the bilinear downsampler Image2::getDownsamplerFunctions
+        /// would pick for the given format, or null if there isn't one
+        ImageDownsampler2DBilinear *getBilinearDownsampler( PixelFormatGpu format,
+                                                            bool gammaCorrected )
+        {
+            switch( format )
+            {
+            case PFG_RGBA8_UNORM:
+            case PFG_RGBA8_UNORM_SRGB:
+            case PFG_RGBA8_UINT:
+            case PFG_BGRA8_UNORM:
+            case PFG_BGRA8_UNORM_SRGB:
+                return gammaCorrected ? downscale2xBilinear_sRGB_XXXA8888
+                                      : downscale2xBilinear_XXXA8888;
+            case PFG_RGBA32_FLOAT:
+                return downscale2xBilinear_Float32_XXXA;
+            default:
+                return 0;
+            }
+        }
+
+        /// Splits the rows of a bilinear downsample across multiple chunks
+        struct BilinearDownsampleTask : public UniformScalableTask
+        {
+            ImageDownsampler2DBilinear *downsampler;
+            uint8 *dstPtr;
+            uint8 const *srcPtr;
+            int32 dstWidth;
+            int32 dstHeight;
+            int32 dstBytesPerRow;
+            int32 srcBytesPerRow;
+
+            void execute( size_t chunkIdx, size_t numChunks ) override
+            {
+                const size_t height = static_cast<size_t>( dstHeight );
+                const int32 rowStart = static_cast<int32>( height * chunkIdx / numChunks );
+                const int32 rowEnd = static_cast<int32>( height * ( chunkIdx + 1u ) / numChunks );
+                ( *downsampler )( dstPtr, srcPtr, dstWidth, dstHeight, dstBytesPerRow, srcBytesPerRow,
+                                  rowStart, rowEnd );
+            }
+
+            void run( UniformScalableTaskExecutor *executor )
+            {
+                // Small enough chunks to balance the load, big enough to be worth it
+                const size_t c_rowsPerChunk = 64u;
+                const size_t numChunks =
+                    executor ? std::max<size_t>( size_t( dstHeight ) / c_rowsPerChunk, 1u ) : 1u;
+                if( numChunks > 1u )
+                    executor->executeUniformScalableTask( this, numChunks );
+                else
+                    execute( 0u, 1u );
+            }
+        };
+
+        /// Downsamples each cubemap face in a different chunk
+        struct CubeDownsampleTask : public UniformScalableTask
+        {
+            ImageDownsamplerCube *downsampler;
+            TextureBox box0;
+            TextureBox box1;
+            int32 dstWidth;
+            int32 dstHeight;
+            int32 srcWidth;
+            int32 srcHeight;
+            const FilterKernel *filter;
+
+            void execute( size_t chunkIdx, size_t numChunks ) override
+            {
+                uint8 const *upFaces[6];
+                for( size_t j = 0; j < 6; ++j )
+                    upFaces[j] = reinterpret_cast<uint8 *>( box0.at( 0, 0, j ) );
+
+                for( size_t j = chunkIdx; j < 6u; j += numChunks )
+                {
+                    uint8 *downFace = reinterpret_cast<uint8 *>( box1.at( 0, 0, j ) );
+                    ( *downsampler )( downFace, upFaces, dstWidth, dstHeight,
+                                      static_cast<int32>( box1.bytesPerRow ), srcWidth, srcHeight,
+                                      static_cast<int32>( box0.bytesPerRow ), filter->kernel,
+                                      filter->kernelStartX, filter->kernelEndX, filter->kernelStartY,
+                                      filter->kernelEndY, static_cast<uint8>( j ) );
+                }
+            }
+        };
+    }  // namespace
+
     ImageCodec2::~ImageCodec2() {}
     //-----------------------------------------------------------------------------------
+    ImageCodec2::StreamingListener::~StreamingListener() {}
+    //-----------------------------------------------------------------------------------
+    bool ImageCodec2::decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                                       uint32 maxRowsPerBatch ) const
+    {
+        DecodeResult res = decode( input );
+        const ImageData2 *pData = static_cast<const ImageData2 *>( res.second.get() );
+
+        ImageData2 header;
+        header.box = pData->box;
+        header.box.data = 0;
+        header.textureType = pData->textureType;
+        header.format = pData->format;
+        header.numMipmaps = pData->numMipmaps;
+        header.freeOnDestruction = false;
+
+        if( !listener->headerDecoded( header ) )
+            return false;
+
+        const PixelFormatGpu format = pData->format;
+        const bool isCompressed = PixelFormatGpuUtils::isCompressed( format );
+        maxRowsPerBatch = std::max( maxRowsPerBatch, 1u );
+
+        for( uint8 mip = 0u; mip < pData->numMipmaps; ++mip )
+        {
+            const uint32 width = std::max( pData->box.width >> mip, 1u );
+            const uint32 height = std::max( pData->box.height >> mip, 1u );
+            const uint32 depth = std::max( pData->box.depth >> mip, 1u );
+            const uint32 numSlices = pData->box.numSlices;
+
+            const uint32 bytesPerRow =
+                (uint32)PixelFormatGpuUtils::getSizeBytes( width, 1u, 1u, 1u, format, 4u );
+            TextureBox mipBox( width, height, depth, numSlices,
+                               PixelFormatGpuUtils::getBytesPerPixel( format ), bytesPerRow,
+                               PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, format, 4u ) );
+            mipBox.data = PixelFormatGpuUtils::advancePointerToMip(
+                pData->box.data, pData->box.width, pData->box.height, pData->box.depth, numSlices, mip,
+                format );
+            if( isCompressed )
+                mipBox.setCompressedPixelFormat( format );
+
+            // Compressed formats are delivered a whole slice at a time
+            const uint32 rowsPerBatch = isCompressed ? height : maxRowsPerBatch;
+
+            for( uint32 z = 0u; z < mipBox.getDepthOrSlices(); ++z )
+            {
+                for( uint32 y = 0u; y < height; y += rowsPerBatch )
+                {
+                    TextureBox rows = mipBox;
+                    rows.height = std::min( rowsPerBatch, height - y );
+                    rows.depth = 1u;
+                    rows.numSlices = 1u;
+                    rows.bytesPerImage = size_t( rows.bytesPerRow ) * rows.height;
+                    if( isCompressed )
+                        rows.bytesPerImage = mipBox.bytesPerImage;
+                    rows.data = mipBox.at( 0u, y, z );
+
+                    if( !listener->rowsDecoded( rows, mip, z, y ) )
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
     Image2::Image2() :
         mWidth( 0 ),
         mHeight( 0 ),
@@ -69,14 +223,33 @@ namespace Ogre
     {
         OgreProfileExhaustive( "Image2::freeMemory" );
 
+        if( mBackingStream )
+        {
+            // The buffer belongs to the mapping. Just drop our reference to it
+            mBuffer = NULL;
+            mBackingStream.reset();
+        }
         // Only delete if this was not a dynamic image (meaning app holds & destroys buffer)
-        if( mBuffer && mAutoDelete )
+        else if( mBuffer && mAutoDelete )
         {
             OGRE_FREE_SIMD( mBuffer, MEMCATEGORY_RESOURCE );
             mBuffer = NULL;
         }
     }
     //-----------------------------------------------------------------------------------
+    void Image2::detachFromBackingStream()
+    {
+        if( !mBackingStream )
+            return;
+
+        const size_t totalBytes = getSizeBytes();
+        void *buffer = OGRE_MALLOC_SIMD( totalBytes, MEMCATEGORY_RESOURCE );
+        memcpy( buffer, mBuffer, totalBytes );
+        mBuffer = buffer;
+        mAutoDelete = true;
+        mBackingStream.reset();
+    }
+    //-----------------------------------------------------------------------------------
     Image2 &Image2::operator=( const Image2 &img )
     {
         OgreProfileExhaustive( "Image2::operator =" );
@@ -101,6 +274,7 @@ namespace Ogre
         else
         {
             mBuffer = img.mBuffer;
+            mBackingStream = img.mBackingStream;
         }
 
         return *this;
@@ -199,6 +373,8 @@ namespace Ogre
                          "Image2::flipAroundY" );
         }
 
+        detachFromBackingStream();
+
         for( uint8 i = 0; i < mNumMipmaps; ++i )
             flipAroundY( i );
     }
@@ -235,6 +411,8 @@ namespace Ogre
                          "Image2::flipAroundX" );
         }
 
+        detachFromBackingStream();
+
         void *pTempBuffer = OGRE_MALLOC_SIMD( getBytesPerRow( 0 ), MEMCATEGORY_RESOURCE );
 
         for( uint8 i = 0; i < mNumMipmaps; ++i )
@@ -703,7 +881,20 @@ namespace Ogre
         OgreProfileExhaustive( "Image2::load2" );
 
         freeMemory();
+        load( stream, findCodec( stream, filename ) );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Image2::decodeStreaming( DataStreamPtr &stream, const String &filename,
+                                  ImageCodec2::StreamingListener *listener, uint32 maxRowsPerBatch )
+    {
+        OgreProfileExhaustive( "Image2::decodeStreaming" );
 
+        ImageCodec2 *pCodec = static_cast<ImageCodec2 *>( findCodec( stream, filename ) );
+        return pCodec->decodeStreaming( stream, listener, maxRowsPerBatch );
+    }
+    //-----------------------------------------------------------------------------------
+    Codec *Image2::findCodec( DataStreamPtr &stream, const String &filename )
+    {
         Codec *pCodec = 0;
 
         // read the first 128 bytes or file size, if less
@@ -751,7 +942,7 @@ namespace Ogre
                          "Image2::load" );
         }
 
-        load( stream, pCodec );
+        return pCodec;
     }
     //-----------------------------------------------------------------------------------
     void Image2::load( DataStreamPtr &stream, Codec *pCodec )
@@ -775,8 +966,9 @@ namespace Ogre
         mBuffer = pData->box.data;
         // Make sure stream does not delete
         pData->freeOnDestruction = false;
-        // make sure we delete
+        // make sure we delete (or release the mapping, if the codec decoded in place)
         mAutoDelete = true;
+        mBackingStream = pData->backingStream;
     }
     //-----------------------------------------------------------------------------------
     String Image2::getFileExtFromMagic( DataStreamPtr &stream )
@@ -803,6 +995,7 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Image2::setColourAt( const ColourValue &cv, size_t x, size_t y, size_t z, uint8 mipLevel )
     {
+        detachFromBackingStream();
         TextureBox textureBox = getData( mipLevel );
         textureBox.setColourAt( cv, x, y, z, mPixelFormat );
     }
@@ -875,6 +1068,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Image2::resize( uint32 width, uint32 height, Filter filter )
     {
+        detachFromBackingStream();
+
         // resizing dynamic images is not supported
         assert( mAutoDelete );
         assert( mTextureType == TextureTypes::Type2D && "Texture type not supported" );
@@ -1080,10 +1275,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter )
+    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter,
+                                  UniformScalableTaskExecutor *executor )
     {
         OgreProfileExhaustive( "Image2::generateMipmaps" );
 
+        detachFromBackingStream();
+
         // resizing dynamic images is not supported
         assert( mAutoDelete );
         assert( ( mTextureType == TextureTypes::Type2D || mTextureType == TextureTypes::TypeCube ||
@@ -1166,6 +1364,10 @@ namespace Ogre
 
         const FilterKernel &chosenFilter = c_filterKernels[filterIdx];
 
+        // Bilinear has a SIMD path which can also be split across threads
+        ImageDownsampler2DBilinear *bilinear2DFunc =
+            filterIdx == 1 ? getBilinearDownsampler( mPixelFormat, gammaCorrected ) : 0;
+
         for( uint8 i = 1u; i < mNumMipmaps; ++i )
         {
             uint32 srcWidth = dstWidth;
@@ -1180,21 +1382,19 @@ namespace Ogre
 
             if( mTextureType == TextureTypes::TypeCube )
             {
-                uint8 const *upFaces[6];
-                for( size_t j = 0; j < 6; ++j )
-                    upFaces[j] = reinterpret_cast<uint8 *>( box0.at( 0, 0, j ) );
-
-                for( size_t j = 0; j < 6; ++j )
-                {
-                    uint8 *downFace = reinterpret_cast<uint8 *>( box1.at( 0, 0, j ) );
-                    ( *downsamplerCubeFunc )(
-                        reinterpret_cast<uint8 *>( downFace ), upFaces, static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( srcHeight ),
-                        static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
-                        chosenFilter.kernelStartX, chosenFilter.kernelEndX, chosenFilter.kernelStartY,
-                        chosenFilter.kernelEndY, static_cast<uint8>( j ) );
-                }
+                CubeDownsampleTask task;
+                task.downsampler = downsamplerCubeFunc;
+                task.box0 = box0;
+                task.box1 = box1;
+                task.dstWidth = static_cast<int32>( dstWidth );
+                task.dstHeight = static_cast<int32>( dstHeight );
+                task.srcWidth = static_cast<int32>( srcWidth );
+                task.srcHeight = static_cast<int32>( srcHeight );
+                task.filter = &chosenFilter;
+                if( executor )
+                    executor->executeUniformScalableTask( &task, 6u );
+                else
+                    task.execute( 0u, 1u );
             }
             else if( mTextureType == TextureTypes::Type3D )
             {
@@ -1208,7 +1408,19 @@ namespace Ogre
             }
             else
             {
-                if( filter != FILTER_GAUSSIAN_HIGH )
+                if( bilinear2DFunc && filter != FILTER_GAUSSIAN_HIGH )
+                {
+                    BilinearDownsampleTask task;
+                    task.downsampler = bilinear2DFunc;
+                    task.dstPtr = reinterpret_cast<uint8 *>( box1.data );
+                    task.srcPtr = reinterpret_cast<uint8 *>( box0.data );
+                    task.dstWidth = static_cast<int32>( dstWidth );
+                    task.dstHeight = static_cast<int32>( dstHeight );
+                    task.dstBytesPerRow = static_cast<int32>( box1.bytesPerRow );
+                    task.srcBytesPerRow = static_cast<int32>( box0.bytesPerRow );
+                    task.run( executor );
+                }
+                else if( filter != FILTER_GAUSSIAN_HIGH )
                 {
                     ( *downsampler2DFunc )(
                         reinterpret_cast<uint8 *>( box1.data ), reinterpret_cast<uint8 *>( box0.data ),
@@ -1244,13 +1456,29 @@ namespace Ogre
                                               separableKernel.kernelEnd );
 
                     // Now that tmpImage0 is blurred, bilinear downsample its contents into box1.
-                    ( *downsampler2DFunc )(
-                        reinterpret_cast<uint8 *>( box1.data ),
-                        reinterpret_cast<uint8 *>( tmpImage0.mBuffer ), static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( box0.bytesPerRow ),
-                        chosenFilter.kernel, chosenFilter.kernelStartX, chosenFilter.kernelEndX,
-                        chosenFilter.kernelStartY, chosenFilter.kernelEndY );
+                    if( bilinear2DFunc )
+                    {
+                        BilinearDownsampleTask task;
+                        task.downsampler = bilinear2DFunc;
+                        task.dstPtr = reinterpret_cast<uint8 *>( box1.data );
+                        task.srcPtr = reinterpret_cast<uint8 *>( tmpImage0.mBuffer );
+                        task.dstWidth = static_cast<int32>( dstWidth );
+                        task.dstHeight = static_cast<int32>( dstHeight );
+                        task.dstBytesPerRow = static_cast<int32>( box1.bytesPerRow );
+                        task.srcBytesPerRow = static_cast<int32>( box0.bytesPerRow );
+                        task.run( executor );
+                    }
+                    else
+                    {
+                        ( *downsampler2DFunc )(
+                            reinterpret_cast<uint8 *>( box1.data ),
+                            reinterpret_cast<uint8 *>( tmpImage0.mBuffer ),
+                            static_cast<int32>( dstWidth ), static_cast<int32>( dstHeight ),
+                            static_cast<int32>( box1.bytesPerRow ), static_cast<int32>( srcWidth ),
+                            static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
+                            chosenFilter.kernelStartX, chosenFilter.kernelEndX,
+                            chosenFilter.kernelStartY, chosenFilter.kernelEndY );
+                    }
                 }
             }
         }
@@ -182,6 +182,8 @@ namespace Ogre
 #define OGRE_UINT8 uint8
 #define OGRE_UINT32 uint32
 #define OGRE_ROUND_HALF 0.5f
+// Alpha is not averaged but rounded up, so that opaque texels stay opaque
+#define OGRE_ALPHA_DIVIDE( accum, divisor ) ( ( accum + divisor - 1 ) / divisor )
 
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_DOWNSAMPLE_G 1
@@ -309,9 +311,11 @@ namespace Ogre
 #undef OGRE_UINT8
 #undef OGRE_UINT32
 #undef OGRE_ROUND_HALF
+#undef OGRE_ALPHA_DIVIDE
 #define OGRE_UINT8 float
 #define OGRE_UINT32 float
 #define OGRE_ROUND_HALF 0.0f
+#define OGRE_ALPHA_DIVIDE( accum, divisor ) ( accum / divisor )
 
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_DOWNSAMPLE_G 1
@@ -380,9 +384,11 @@ namespace Ogre
 #undef OGRE_UINT8
 #undef OGRE_UINT32
 #undef OGRE_ROUND_HALF
+#undef OGRE_ALPHA_DIVIDE
 #define OGRE_UINT8 uint8
 #define OGRE_UINT32 uint32
 #define OGRE_ROUND_HALF 0.5f
+#define OGRE_ALPHA_DIVIDE( accum, divisor ) ( ( accum + divisor - 1 ) / divisor )
 
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_DOWNSAMPLE_G 1
@@ -0,0 +1,385 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreImageDownsampler.h"
+
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+// Float NEON isn't IEEE compliant on ARMv7 (denormals are flushed) and lacks vsqrtq_f32,
+// thus the float paths can only be bit-exact with the generic downsamplers on AArch64
+#if __OGRE_HAVE_NEON && defined( __aarch64__ )
+#    define OGRE_DOWNSAMPLER_NEON_FLOAT 1
+#else
+#    define OGRE_DOWNSAMPLER_NEON_FLOAT 0
+#endif
+
+namespace Ogre
+{
+    namespace
+    {
+        // Each struct provides:
+        //  pixel():
+        //      Averages a single pixel the same way DOWNSAMPLE_NAME in
+        //      OgreImageDownsamplerImpl.inl does. src1 is null for the last row,
+        //      and hasNextCol false for the last column.
+        //  interior():
+        //      Processes as many of the first numPixels pixels as possible using SIMD
+        //      (all of them average 2x2 texels). Returns how many were processed.
+        //      The rest is done via pixel().
+        struct BilinearXXXA8888
+        {
+            typedef uint8 Type;
+
+            static void pixel( uint8 *RESTRICT_ALIAS dst, const uint8 *RESTRICT_ALIAS src0,
+                               const uint8 *RESTRICT_ALIAS src1, bool hasNextCol )
+            {
+                uint32 accum[4] = { 0u, 0u, 0u, 0u };
+                uint32 divisor = 0u;
+                const uint8 *rows[2] = { src0, src1 };
+                for( size_t k_y = 0u; k_y < 2u && rows[k_y]; ++k_y )
+                {
+                    for( size_t k_x = 0u; k_x < ( hasNextCol ? 2u : 1u ); ++k_x )
+                    {
+                        for( size_t c = 0u; c < 4u; ++c )
+                            accum[c] += rows[k_y][k_x * 4u + c];
+                        ++divisor;
+                    }
+                }
+
+                const float invDivisor = 1.0f / static_cast<float>( divisor );
+                for( size_t c = 0u; c < 3u; ++c )
+                    dst[c] = static_cast<uint8>( static_cast<float>( accum[c] ) * invDivisor + 0.5f );
+                dst[3] = static_cast<uint8>( ( accum[3] + divisor - 1u ) / divisor );
+            }
+
+            static int32 interior( uint8 *RESTRICT_ALIAS dst, const uint8 *RESTRICT_ALIAS src0,
+                                   const uint8 *RESTRICT_ALIAS src1, int32 numPixels )
+            {
+                int32 x = 0;
+#if __OGRE_HAVE_SSE
+                const __m128i zero = _mm_setzero_si128();
+                // RGB rounds to nearest, alpha rounds up
+                const __m128i bias = _mm_setr_epi16( 2, 2, 2, 3, 2, 2, 2, 3 );
+                for( ; x + 4 <= numPixels; x += 4 )
+                {
+                    const __m128i *s0 = reinterpret_cast<const __m128i *>( src0 + x * 8 );
+                    const __m128i *s1 = reinterpret_cast<const __m128i *>( src1 + x * 8 );
+                    const __m128i a0 = _mm_loadu_si128( s0 );
+                    const __m128i b0 = _mm_loadu_si128( s0 + 1 );
+                    const __m128i a1 = _mm_loadu_si128( s1 );
+                    const __m128i b1 = _mm_loadu_si128( s1 + 1 );
+
+                    // Vertical sums, 16 bits per channel. 2 pixels per register
+                    const __m128i aLo =
+                        _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( a1, zero ) );
+                    const __m128i aHi =
+                        _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( a1, zero ) );
+                    const __m128i bLo =
+                        _mm_add_epi16( _mm_unpacklo_epi8( b0, zero ), _mm_unpacklo_epi8( b1, zero ) );
+                    const __m128i bHi =
+                        _mm_add_epi16( _mm_unpackhi_epi8( b0, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+                    // Horizontal sums, the result is in the lower 64 bits
+                    const __m128i d0 = _mm_add_epi16( aLo, _mm_srli_si128( aLo, 8 ) );
+                    const __m128i d1 = _mm_add_epi16( aHi, _mm_srli_si128( aHi, 8 ) );
+                    const __m128i d2 = _mm_add_epi16( bLo, _mm_srli_si128( bLo, 8 ) );
+                    const __m128i d3 = _mm_add_epi16( bHi, _mm_srli_si128( bHi, 8 ) );
+
+                    __m128i d01 = _mm_unpacklo_epi64( d0, d1 );
+                    __m128i d23 = _mm_unpacklo_epi64( d2, d3 );
+                    d01 = _mm_srli_epi16( _mm_add_epi16( d01, bias ), 2 );
+                    d23 = _mm_srli_epi16( _mm_add_epi16( d23, bias ), 2 );
+
+                    _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + x * 4 ),
+                                      _mm_packus_epi16( d01, d23 ) );
+                }
+#elif __OGRE_HAVE_NEON
+                for( ; x + 8 <= numPixels; x += 8 )
+                {
+                    const uint8x16x4_t a = vld4q_u8( src0 + x * 8 );
+                    const uint8x16x4_t b = vld4q_u8( src1 + x * 8 );
+
+                    uint8x8x4_t result;
+                    for( int c = 0; c < 3; ++c )
+                    {
+                        const uint16x8_t sum = vpadalq_u8( vpaddlq_u8( a.val[c] ), b.val[c] );
+                        result.val[c] = vrshrn_n_u16( sum, 2 );  // ( sum + 2 ) >> 2
+                    }
+                    const uint16x8_t sumA = vpadalq_u8( vpaddlq_u8( a.val[3] ), b.val[3] );
+                    result.val[3] = vshrn_n_u16( vaddq_u16( sumA, vdupq_n_u16( 3u ) ), 2 );
+
+                    vst4_u8( dst + x * 4, result );
+                }
+#endif
+                return x;
+            }
+        };
+        //-------------------------------------------------------------------------------------
+        struct BilinearSRgbXXXA8888
+        {
+            typedef uint8 Type;
+
+            static void pixel( uint8 *RESTRICT_ALIAS dst, const uint8 *RESTRICT_ALIAS src0,
+                               const uint8 *RESTRICT_ALIAS src1, bool hasNextCol )
+            {
+                uint32 accum[4] = { 0u, 0u, 0u, 0u };
+                uint32 divisor = 0u;
+                const uint8 *rows[2] = { src0, src1 };
+                for( size_t k_y = 0u; k_y < 2u && rows[k_y]; ++k_y )
+                {
+                    for( size_t k_x = 0u; k_x < ( hasNextCol ? 2u : 1u ); ++k_x )
+                    {
+                        for( size_t c = 0u; c < 3u; ++c )
+                        {
+                            const uint32 value = rows[k_y][k_x * 4u + c];
+                            accum[c] += value * value;
+                        }
+                        accum[3] += rows[k_y][k_x * 4u + 3u];
+                        ++divisor;
+                    }
+                }
+
+                const float invDivisor = 1.0f / static_cast<float>( divisor );
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    dst[c] = static_cast<uint8>(
+                        sqrtf( static_cast<float>( accum[c] ) * invDivisor ) + 0.5f );
+                }
+                dst[3] = static_cast<uint8>( ( accum[3] + divisor - 1u ) / divisor );
+            }
+
+            static int32 interior( uint8 *RESTRICT_ALIAS dst, const uint8 *RESTRICT_ALIAS src0,
+                                   const uint8 *RESTRICT_ALIAS src1, int32 numPixels )
+            {
+                int32 x = 0;
+#if __OGRE_HAVE_SSE
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i alphaMask = _mm_setr_epi32( 0, 0, 0, -1 );
+                const __m128i alphaBias = _mm_set1_epi32( 3 );
+                const __m128 quarter = _mm_set1_ps( 0.25f );
+                const __m128 half = _mm_set1_ps( 0.5f );
+                for( ; x < numPixels; ++x )
+                {
+                    // 2 pixels per row, 16 bits per channel
+                    const __m128i r0 = _mm_unpacklo_epi8(
+                        _mm_loadl_epi64( reinterpret_cast<const __m128i *>( src0 + x * 8 ) ), zero );
+                    const __m128i r1 = _mm_unpacklo_epi8(
+                        _mm_loadl_epi64( reinterpret_cast<const __m128i *>( src1 + x * 8 ) ), zero );
+
+                    // 1 pixel per register, 32 bits per channel
+                    const __m128i p00 = _mm_unpacklo_epi16( r0, zero );
+                    const __m128i p01 = _mm_unpackhi_epi16( r0, zero );
+                    const __m128i p10 = _mm_unpacklo_epi16( r1, zero );
+                    const __m128i p11 = _mm_unpackhi_epi16( r1, zero );
+
+                    // The high 16 bits are 0, thus madd yields value * value
+                    const __m128i sumSq =
+                        _mm_add_epi32( _mm_add_epi32( _mm_madd_epi16( p00, p00 ),
+                                                      _mm_madd_epi16( p01, p01 ) ),
+                                       _mm_add_epi32( _mm_madd_epi16( p10, p10 ),
+                                                      _mm_madd_epi16( p11, p11 ) ) );
+                    const __m128i sum =
+                        _mm_add_epi32( _mm_add_epi32( p00, p01 ), _mm_add_epi32( p10, p11 ) );
+
+                    // Exact conversions (sums are < 2^24), and sqrt is correctly rounded,
+                    // thus this matches sqrtf() in pixel()
+                    const __m128i rgb = _mm_cvttps_epi32( _mm_add_ps(
+                        _mm_sqrt_ps( _mm_mul_ps( _mm_cvtepi32_ps( sumSq ), quarter ) ), half ) );
+                    const __m128i alpha = _mm_srli_epi32( _mm_add_epi32( sum, alphaBias ), 2 );
+
+                    __m128i result = _mm_or_si128( _mm_and_si128( alphaMask, alpha ),
+                                                   _mm_andnot_si128( alphaMask, rgb ) );
+                    result = _mm_packs_epi32( result, result );
+                    result = _mm_packus_epi16( result, result );
+
+                    const int32 packed = _mm_cvtsi128_si32( result );
+                    memcpy( dst + x * 4, &packed, sizeof( packed ) );
+                }
+#elif OGRE_DOWNSAMPLER_NEON_FLOAT
+                const uint32 c_alphaMask[4] = { 0u, 0u, 0u, 0xFFFFFFFFu };
+                const uint32x4_t alphaMask = vld1q_u32( c_alphaMask );
+                for( ; x < numPixels; ++x )
+                {
+                    // 2 pixels per row, 16 bits per channel
+                    const uint16x8_t r0 = vmovl_u8( vld1_u8( src0 + x * 8 ) );
+                    const uint16x8_t r1 = vmovl_u8( vld1_u8( src1 + x * 8 ) );
+
+                    uint32x4_t sumSq = vmull_u16( vget_low_u16( r0 ), vget_low_u16( r0 ) );
+                    sumSq = vmlal_u16( sumSq, vget_high_u16( r0 ), vget_high_u16( r0 ) );
+                    sumSq = vmlal_u16( sumSq, vget_low_u16( r1 ), vget_low_u16( r1 ) );
+                    sumSq = vmlal_u16( sumSq, vget_high_u16( r1 ), vget_high_u16( r1 ) );
+                    const uint16x4_t sum =
+                        vadd_u16( vadd_u16( vget_low_u16( r0 ), vget_high_u16( r0 ) ),
+                                  vadd_u16( vget_low_u16( r1 ), vget_high_u16( r1 ) ) );
+
+                    const float32x4_t linear = vmulq_n_f32( vcvtq_f32_u32( sumSq ), 0.25f );
+                    const uint32x4_t rgb =
+                        vcvtq_u32_f32( vaddq_f32( vsqrtq_f32( linear ), vdupq_n_f32( 0.5f ) ) );
+                    const uint32x4_t alpha =
+                        vshrq_n_u32( vaddq_u32( vmovl_u16( sum ), vdupq_n_u32( 3u ) ), 2 );
+
+                    const uint16x4_t result16 = vmovn_u32( vbslq_u32( alphaMask, alpha, rgb ) );
+                    const uint8x8_t result8 = vmovn_u16( vcombine_u16( result16, result16 ) );
+                    vst1_lane_u32( reinterpret_cast<uint32_t *>( dst + x * 4 ),
+                                   vreinterpret_u32_u8( result8 ), 0 );
+                }
+#endif
+                return x;
+            }
+        };
+        //-------------------------------------------------------------------------------------
+        struct BilinearFloat32XXXA
+        {
+            typedef float Type;
+
+            static void pixel( uint8 *RESTRICT_ALIAS _dst, const uint8 *RESTRICT_ALIAS _src0,
+                               const uint8 *RESTRICT_ALIAS _src1, bool hasNextCol )
+            {
+                float *dst = reinterpret_cast<float *>( _dst );
+                const float *rows[2] = { reinterpret_cast<const float *>( _src0 ),
+                                         reinterpret_cast<const float *>( _src1 ) };
+
+                float accum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                float divisor = 0.0f;
+                for( size_t k_y = 0u; k_y < 2u && rows[k_y]; ++k_y )
+                {
+                    for( size_t k_x = 0u; k_x < ( hasNextCol ? 2u : 1u ); ++k_x )
+                    {
+                        for( size_t c = 0u; c < 4u; ++c )
+                            accum[c] += rows[k_y][k_x * 4u + c];
+                        divisor += 1.0f;
+                    }
+                }
+
+                const float invDivisor = 1.0f / divisor;
+                for( size_t c = 0u; c < 3u; ++c )
+                    dst[c] = accum[c] * invDivisor + 0.0f;
+                dst[3] = accum[3] / divisor;
+            }
+
+            static int32 interior( uint8 *RESTRICT_ALIAS _dst, const uint8 *RESTRICT_ALIAS _src0,
+                                   const uint8 *RESTRICT_ALIAS _src1, int32 numPixels )
+            {
+                int32 x = 0;
+#if __OGRE_HAVE_SSE || OGRE_DOWNSAMPLER_NEON_FLOAT
+                float *dst = reinterpret_cast<float *>( _dst );
+                const float *src0 = reinterpret_cast<const float *>( _src0 );
+                const float *src1 = reinterpret_cast<const float *>( _src1 );
+                // Adding +0 to RGB (and -0 to alpha, which leaves it untouched) reproduces
+                // the '+ OGRE_ROUND_HALF' of the generic version bit by bit, including -0
+                const float c_signFix[4] = { 0.0f, 0.0f, 0.0f, -0.0f };
+#endif
+#if __OGRE_HAVE_SSE
+                const __m128 quarter = _mm_set1_ps( 0.25f );
+                const __m128 signFix = _mm_loadu_ps( c_signFix );
+                for( ; x < numPixels; ++x )
+                {
+                    // Same summation order as pixel()
+                    __m128 accum = _mm_add_ps( _mm_setzero_ps(), _mm_loadu_ps( src0 + x * 8 ) );
+                    accum = _mm_add_ps( accum, _mm_loadu_ps( src0 + x * 8 + 4 ) );
+                    accum = _mm_add_ps( accum, _mm_loadu_ps( src1 + x * 8 ) );
+                    accum = _mm_add_ps( accum, _mm_loadu_ps( src1 + x * 8 + 4 ) );
+                    _mm_storeu_ps( dst + x * 4, _mm_add_ps( _mm_mul_ps( accum, quarter ), signFix ) );
+                }
+#elif OGRE_DOWNSAMPLER_NEON_FLOAT
+                const float32x4_t signFix = vld1q_f32( c_signFix );
+                for( ; x < numPixels; ++x )
+                {
+                    // Same summation order as pixel()
+                    float32x4_t accum = vaddq_f32( vdupq_n_f32( 0.0f ), vld1q_f32( src0 + x * 8 ) );
+                    accum = vaddq_f32( accum, vld1q_f32( src0 + x * 8 + 4 ) );
+                    accum = vaddq_f32( accum, vld1q_f32( src1 + x * 8 ) );
+                    accum = vaddq_f32( accum, vld1q_f32( src1 + x * 8 + 4 ) );
+                    vst1q_f32( dst + x * 4, vaddq_f32( vmulq_n_f32( accum, 0.25f ), signFix ) );
+                }
+#endif
+                return x;
+            }
+        };
+        //-------------------------------------------------------------------------------------
+        template <typename T>
+        void downscale2xBilinear( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
+                                  int32 dstHeight, int32 dstBytesPerRow, int32 srcBytesPerRow,
+                                  int32 rowStart, int32 rowEnd )
+        {
+            const size_t bytesPerPixel = 4u * sizeof( typename T::Type );
+
+            for( int32 y = rowStart; y < rowEnd; ++y )
+            {
+                uint8 *dst = dstPtr + size_t( y ) * size_t( dstBytesPerRow );
+                const uint8 *src0 = srcPtr + size_t( y ) * 2u * size_t( srcBytesPerRow );
+                // Like the generic version, the last row & column are not averaged
+                // against the next one, even if the source has it.
+                const uint8 *src1 = y + 1 < dstHeight ? src0 + srcBytesPerRow : 0;
+
+                int32 x = 0;
+                if( src1 )
+                    x = T::interior( dst, src0, src1, dstWidth - 1 );
+                for( ; x < dstWidth; ++x )
+                {
+                    T::pixel( dst + size_t( x ) * bytesPerPixel,
+                              src0 + size_t( x ) * 2u * bytesPerPixel,
+                              src1 ? src1 + size_t( x ) * 2u * bytesPerPixel : 0, x + 1 < dstWidth );
+                }
+            }
+        }
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    void downscale2xBilinear_XXXA8888( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
+                                       int32 dstHeight, int32 dstBytesPerRow, int32 srcBytesPerRow,
+                                       int32 rowStart, int32 rowEnd )
+    {
+        downscale2xBilinear<BilinearXXXA8888>( dstPtr, srcPtr, dstWidth, dstHeight, dstBytesPerRow,
+                                               srcBytesPerRow, rowStart, rowEnd );
+    }
+    //-----------------------------------------------------------------------------------
+    void downscale2xBilinear_sRGB_XXXA8888( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
+                                            int32 dstHeight, int32 dstBytesPerRow,
+                                            int32 srcBytesPerRow, int32 rowStart, int32 rowEnd )
+    {
+        downscale2xBilinear<BilinearSRgbXXXA8888>( dstPtr, srcPtr, dstWidth, dstHeight,
+                                                   dstBytesPerRow, srcBytesPerRow, rowStart, rowEnd );
+    }
+    //-----------------------------------------------------------------------------------
+    void downscale2xBilinear_Float32_XXXA( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
+                                           int32 dstHeight, int32 dstBytesPerRow,
+                                           int32 srcBytesPerRow, int32 rowStart, int32 rowEnd )
+    {
+        downscale2xBilinear<BilinearFloat32XXXA>( dstPtr, srcPtr, dstWidth, dstHeight,
+                                                  dstBytesPerRow, srcBytesPerRow, rowStart, rowEnd );
+    }
+}  // namespace Ogre
@@ -119,7 +119,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -222,7 +222,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                     dstPtr[OGRE_DOWNSAMPLE_A] =
-                        static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                        static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                     dstPtr += OGRE_TOTAL_SIZE;
@@ -363,7 +363,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -447,7 +447,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -525,7 +525,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -609,7 +609,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -684,7 +684,7 @@ namespace Ogre
 #endif
 #ifdef OGRE_DOWNSAMPLE_A
                 dstPtr[OGRE_DOWNSAMPLE_A] =
-                    static_cast<OGRE_UINT8>( ( accumA + divisor - 1 ) / divisor );
+                    static_cast<OGRE_UINT8>( OGRE_ALPHA_DIVIDE( accumA, divisor ) );
 #endif
 
                 dstPtr += OGRE_TOTAL_SIZE;
@@ -125,6 +125,7 @@ namespace Ogre
         mObjectData.mWorldAabb->setFromAabb( aabb, mObjectData.mIndex );
         mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
         mObjectData.mWorldRadius[mObjectData.mIndex] = aabb.getRadius();
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
         if( mParentNode )
         {
             updateSingleWorldAabb();
@@ -143,6 +144,7 @@ namespace Ogre
         // Delete submeshes
         mSubItems.clear();
         mRenderables.clear();
+        notifyCullingChanged();
 
         // If mesh is skeletally animated: destroy instance
         assert( mManager || !mSkeletonInstance );
@@ -187,6 +189,8 @@ namespace Ogre
     {
         for( SubItem &subitem : mSubItems )
             subitem.setDatablock( datablock );
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------
     void Item::setDatablock( IdString datablockName )
@@ -204,6 +208,8 @@ namespace Ogre
         // Set for all subentities
         for( SubItem &subitem : mSubItems )
             subitem.setDatablockOrMaterialName( name, groupName );
+
+        notifyCullingChanged();
     }
     //-----------------------------------------------------------------------
     void Item::setMaterialName(
@@ -91,6 +91,7 @@ namespace Ogre
     void Light::setType( LightTypes type )
     {
         mLightType = type;
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
         switch( mLightType )
         {
@@ -231,6 +232,7 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void Light::resetAabb()
     {
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
         mObjectData.mLocalRadius[mObjectData.mIndex] = 1.0f;
         if( mLightType == LT_POINT || mLightType == LT_VPL )
         {
@@ -261,6 +263,7 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void Light::updateLightBounds()
     {
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
         if( mLightType == LT_POINT || mLightType == LT_VPL )
         {
             if( !mAffectParentNode )
@@ -89,6 +89,7 @@ namespace Ogre
             mObjectData.mLocalRadius[mObjectData.mIndex] = 0.0f;
 
             mObjectData.mLocalAabb->setFromAabb( Aabb::BOX_NULL, mObjectData.mIndex );
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
             OGRE_DELETE mEdgeList;
             mEdgeList = 0;
@@ -290,6 +291,7 @@ namespace Ogre
             mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
             mObjectData.mLocalRadius[mObjectData.mIndex] =
                 std::max( mObjectData.mLocalRadius[mObjectData.mIndex], mTempVertex.position.length() );
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
             // reset current texture coord
             mTexCoordIndex = 0;
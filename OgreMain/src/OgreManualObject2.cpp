@@ -81,6 +81,7 @@ namespace Ogre
 
         mObjectData.mLocalRadius[mObjectData.mIndex] = 0.0f;
         mObjectData.mLocalAabb->setFromAabb( Aabb::BOX_NULL, mObjectData.mIndex );
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
         mRenderables.clear();
 
@@ -687,6 +688,7 @@ namespace Ogre
         aabb.merge( mCurrentSection->mAabb );
         mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
         mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
 
         mCurrentSection = 0;
 
@@ -822,6 +824,7 @@ namespace Ogre
 
         mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
         mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
     }
     //-----------------------------------------------------------------------------
     size_t ManualObject::currentIndexCount() { return mIndices; }
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "Animation/OgreSkeletonDef.h"
 #include "Animation/OgreSkeletonManager.h"
 #include "OgreException.h"
+#include "OgreFileSystem.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreIteratorWrappers.h"
 #include "OgreLodStrategyManager.h"
@@ -54,6 +55,7 @@ namespace Ogre
 {
     bool Mesh::msOptimizeForShadowMapping = false;
     bool Mesh::msUseTimestampAsHash = false;
+    bool Mesh::msUseMemoryMappedFiles = false;
 
     //-----------------------------------------------------------------------
     Mesh::Mesh( ResourceManager *creator, const String &name, ResourceHandle handle, const String &group,
@@ -155,10 +157,33 @@ namespace Ogre
         if( getCreator()->getVerbose() )
             LogManager::getSingleton().logMessage( "Mesh: Loading " + mName + "." );
 
-        mFreshFromDisk = ResourceGroupManager::getSingleton().openResource( mName, mGroup, true, this );
+        ResourceGroupManager &resourceGroupManager = ResourceGroupManager::getSingleton();
 
-        // fully prebuffer into host RAM
-        mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+        // Loading listeners may want to supply their own stream; don't bypass them
+        if( Mesh::msUseMemoryMappedFiles && !resourceGroupManager.getLoadingListener() )
+        {
+            try
+            {
+                Archive *archive = resourceGroupManager._getArchiveToResource( mName, mGroup, true );
+                if( archive->getType() == "FileSystem" )
+                {
+                    mFreshFromDisk =
+                        static_cast<FileSystemArchive *>( archive )->openMemoryMapped( mName );
+                }
+            }
+            catch( Exception & )
+            {
+                // openResource below will report the error
+            }
+        }
+
+        if( !mFreshFromDisk )
+        {
+            mFreshFromDisk = resourceGroupManager.openResource( mName, mGroup, true, this );
+
+            // fully prebuffer into host RAM
+            mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+        }
     }
     //-----------------------------------------------------------------------
     void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
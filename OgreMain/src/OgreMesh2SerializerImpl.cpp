@@ -61,7 +61,9 @@ namespace Ogre
     /// stream overhead = ID + size
     const long MSTREAM_OVERHEAD_SIZE = sizeof( uint16 ) + sizeof( uint32 );
     //---------------------------------------------------------------------
-    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) : mVaoManager( vaoManager )
+    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) :
+        mVaoManager( vaoManager ),
+        mBlobAlignment( 0u )
     {
         // Version number
         mVersion = "[MeshSerializer_v2.1 R2]";
@@ -388,6 +390,8 @@ namespace Ogre
                 ( indexBuffer && indexBuffer->getIndexType() == IndexBufferPacked::IT_32BIT );
             writeBools( &idx32bit, 1 );
 
+            const uint8 padding = writeBlobPadding();
+
             // uint16* faceVertexIndices ((indexCount)
             AsyncTicketPtr asyncTicket = indexBuffer->readRequest( 0, indexCount );
             const void *pIdx = asyncTicket->map();
@@ -404,6 +408,8 @@ namespace Ogre
                 addToHash( pIdx16, indexCount * sizeof( uint16 ) );
             }
             asyncTicket->unmap();
+
+            writeBlobPaddingTail( padding );
         }
     }
     //---------------------------------------------------------------------
@@ -465,8 +471,8 @@ namespace Ogre
 
             for( uint8 i = 0; i < numSources; ++i )
             {
-                size_t size =
-                    MSTREAM_OVERHEAD_SIZE + ( sizeof( uint8 ) * 2 ) + vertexData[i]->getTotalSizeBytes();
+                size_t size = MSTREAM_OVERHEAD_SIZE + ( sizeof( uint8 ) * 2 ) + mBlobAlignment +
+                              vertexData[i]->getTotalSizeBytes();
 
                 pushInnerChunk( mStream );
                 writeChunkHeader( M_SUBMESH_M_GEOMETRY_VERTEX_BUFFER, size );
@@ -478,6 +484,8 @@ namespace Ogre
                 const uint8 bytesPerVertex = (uint8)vertexData[i]->getBytesPerElement();
                 writeData( &bytesPerVertex, 1, 1 );
 
+                const uint8 padding = writeBlobPadding();
+
                 AsyncTicketPtr asyncTicket =
                     vertexData[i]->readRequest( 0, vertexData[i]->getNumElements() );
 
@@ -507,6 +515,8 @@ namespace Ogre
 
                 asyncTicket->unmap();
 
+                writeBlobPaddingTail( padding );
+
                 popInnerChunk( mStream );
             }
         }
@@ -624,7 +634,7 @@ namespace Ogre
             // bool indexes32bit
             size += sizeof( bool );
 
-            size += indexBuffer->getTotalSizeBytes();
+            size += mBlobAlignment + indexBuffer->getTotalSizeBytes();
         }
 
         if( !skipVertexBuffer )
@@ -662,7 +672,8 @@ namespace Ogre
 
         // Buffers
         {
-            size += vertexData.size() * ( MSTREAM_OVERHEAD_SIZE + ( sizeof( uint8 ) * 2 ) );
+            size += vertexData.size() *
+                    ( MSTREAM_OVERHEAD_SIZE + ( sizeof( uint8 ) * 2 ) + mBlobAlignment );
 
             VertexBufferPackedVec::const_iterator itor = vertexData.begin();
             VertexBufferPackedVec::const_iterator endt = vertexData.end();
@@ -892,27 +903,7 @@ namespace Ogre
         }
         catch( Exception & )
         {
-            SubMeshLodVec::iterator itor = totalSubmeshLods.begin();
-            SubMeshLodVec::iterator endt = totalSubmeshLods.end();
-
-            while( itor != endt )
-            {
-                Uint8Vec::iterator it = itor->vertexBuffers.begin();
-                Uint8Vec::iterator en = itor->vertexBuffers.end();
-
-                while( it != en )
-                    OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
-
-                itor->vertexBuffers.clear();
-
-                if( itor->indexData )
-                {
-                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
-                    itor->indexData = 0;
-                }
-
-                ++itor;
-            }
+            freeSubMeshLodData( totalSubmeshLods );
 
             // TODO: Delete created mVaos. Don't erase the data from those vaos?
 
@@ -941,14 +932,28 @@ namespace Ogre
             {
                 if( subMeshLod.vertexDeclarations.size() == 1 )
                 {
+                    const bool shadowed = sm->mParent->isVertexBufferShadowed();
+
+                    uint8 *vertexData = subMeshLod.vertexBuffers[0];
+                    if( shadowed && subMeshLod.vertexDataInPlace )
+                    {
+                        // The shadow copy takes ownership; it can't be the stream's memory
+                        const size_t sizeBytes =
+                            subMeshLod.numVertices *
+                            VaoManager::calculateVertexSize( subMeshLod.vertexDeclarations[0] );
+                        vertexData = reinterpret_cast<uint8 *>(
+                            OGRE_MALLOC_SIMD( sizeBytes, MEMCATEGORY_GEOMETRY ) );
+                        memcpy( vertexData, subMeshLod.vertexBuffers[0], sizeBytes );
+                    }
+
                     VertexBufferPacked *vertexBuffer = mVaoManager->createVertexBuffer(
                         subMeshLod.vertexDeclarations[0], subMeshLod.numVertices,
-                        sm->mParent->getVertexBufferDefaultType(), subMeshLod.vertexBuffers[0],
-                        sm->mParent->isVertexBufferShadowed() );
+                        sm->mParent->getVertexBufferDefaultType(), vertexData, shadowed );
 
-                    if( !sm->mParent->isVertexBufferShadowed() )
+                    if( !shadowed )
                     {
-                        OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
+                        if( !subMeshLod.vertexDataInPlace )
+                            OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
                         submeshLods[i].vertexBuffers.erase( submeshLods[i].vertexBuffers.begin() );
                     }
 
@@ -987,14 +992,27 @@ namespace Ogre
             IndexBufferPacked *indexBuffer = 0;
             if( subMeshLod.indexData )
             {
+                const bool shadowed = sm->mParent->isIndexBufferShadowed();
+
+                void *indexData = subMeshLod.indexData;
+                if( shadowed && subMeshLod.indexDataInPlace )
+                {
+                    // The shadow copy takes ownership; it can't be the stream's memory
+                    const size_t sizeBytes =
+                        subMeshLod.numIndices * ( subMeshLod.index32Bit ? 4u : 2u );
+                    indexData = OGRE_MALLOC_SIMD( sizeBytes, MEMCATEGORY_GEOMETRY );
+                    memcpy( indexData, subMeshLod.indexData, sizeBytes );
+                }
+
                 indexBuffer = mVaoManager->createIndexBuffer(
                     subMeshLod.index32Bit ? IndexBufferPacked::IT_32BIT : IndexBufferPacked::IT_16BIT,
-                    subMeshLod.numIndices, sm->mParent->getIndexBufferDefaultType(),
-                    subMeshLod.indexData, sm->mParent->isIndexBufferShadowed() );
+                    subMeshLod.numIndices, sm->mParent->getIndexBufferDefaultType(), indexData,
+                    shadowed );
 
-                if( !sm->mParent->isIndexBufferShadowed() )
+                if( !shadowed )
                 {
-                    OGRE_FREE_SIMD( subMeshLod.indexData, MEMCATEGORY_GEOMETRY );
+                    if( !subMeshLod.indexDataInPlace )
+                        OGRE_FREE_SIMD( subMeshLod.indexData, MEMCATEGORY_GEOMETRY );
                     submeshLods[i].indexData = 0;
                 }
             }
@@ -1006,6 +1024,35 @@ namespace Ogre
         }
     }
     //---------------------------------------------------------------------
+    void MeshSerializerImpl::freeSubMeshLodData( SubMeshLodVec &submeshLods )
+    {
+        SubMeshLodVec::iterator itor = submeshLods.begin();
+        SubMeshLodVec::iterator endt = submeshLods.end();
+
+        while( itor != endt )
+        {
+            if( !itor->vertexDataInPlace )
+            {
+                Uint8Vec::iterator it = itor->vertexBuffers.begin();
+                Uint8Vec::iterator en = itor->vertexBuffers.end();
+
+                while( it != en )
+                    OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
+            }
+
+            itor->vertexBuffers.clear();
+
+            if( itor->indexData )
+            {
+                if( !itor->indexDataInPlace )
+                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
+                itor->indexData = 0;
+            }
+
+            ++itor;
+        }
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::readSubMeshLod( DataStreamPtr &stream, Mesh *pMesh, SubMeshLod *subLod,
                                              uint8 currentLod )
     {
@@ -1080,7 +1127,18 @@ namespace Ogre
         {
             readBools( stream, &subLod->index32Bit, 1 );
 
-            if( subLod->index32Bit )
+            const uint8 padding = readBlobPadding( stream );
+
+            const size_t sizeBytes =
+                ( subLod->index32Bit ? sizeof( uint32 ) : sizeof( uint16 ) ) * subLod->numIndices;
+            const void *inPlaceData = readBlobInPlace( stream, sizeBytes );
+
+            if( inPlaceData )
+            {
+                subLod->indexData = const_cast<void *>( inPlaceData );
+                subLod->indexDataInPlace = true;
+            }
+            else if( subLod->index32Bit )
             {
                 subLod->indexData =
                     OGRE_MALLOC_SIMD( sizeof( uint32 ) * subLod->numIndices, MEMCATEGORY_GEOMETRY );
@@ -1093,6 +1151,8 @@ namespace Ogre
                 readShorts( stream, reinterpret_cast<uint16 *>( subLod->indexData ),
                             subLod->numIndices );
             }
+
+            skipBlobPaddingTail( stream, padding );
         }
     }
     //---------------------------------------------------------------------
@@ -1187,14 +1247,105 @@ namespace Ogre
                          "MeshSerializerImpl::readVertexBuffer" );
         }
 
-        uint8 *vertexData = reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD(
-            sizeof( uint8 ) * bytesPerVertex * subLod->numVertices, MEMCATEGORY_GEOMETRY ) );
-        subLod->vertexBuffers[source] = vertexData;
+        const uint8 padding = readBlobPadding( stream );
 
-        stream->read( vertexData, bytesPerVertex * subLod->numVertices );
+        const size_t sizeBytes = sizeof( uint8 ) * bytesPerVertex * subLod->numVertices;
 
-        // Endian conversion
-        flipLittleEndian( vertexData, subLod->numVertices, bytesPerVertex, vertexElements );
+        // Multiple sources aren't supported by createSubMeshVao, so a single flag is enough
+        const void *inPlaceData = 0;
+        if( subLod->vertexBuffers.size() == 1u )
+            inPlaceData = readBlobInPlace( stream, sizeBytes );
+
+        if( inPlaceData )
+        {
+            subLod->vertexBuffers[source] = static_cast<uint8 *>( const_cast<void *>( inPlaceData ) );
+            subLod->vertexDataInPlace = true;
+        }
+        else
+        {
+            uint8 *vertexData =
+                reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( sizeBytes, MEMCATEGORY_GEOMETRY ) );
+            subLod->vertexBuffers[source] = vertexData;
+
+            stream->read( vertexData, sizeBytes );
+
+            // Endian conversion
+            flipLittleEndian( vertexData, subLod->numVertices, bytesPerVertex, vertexElements );
+        }
+
+        skipBlobPaddingTail( stream, padding );
+    }
+    //---------------------------------------------------------------------
+    const void *MeshSerializerImpl::readBlobInPlace( DataStreamPtr &stream, size_t sizeBytes )
+    {
+        if( mFlipEndian )
+            return 0;
+
+        const void *retVal = 0;
+
+        DataStream *dataStream = stream.get();
+        if( MemoryMappedDataStream *mappedStream = dynamic_cast<MemoryMappedDataStream *>( dataStream ) )
+            retVal = mappedStream->getCurrentPtr();
+        else if( MemoryDataStream *memoryStream = dynamic_cast<MemoryDataStream *>( dataStream ) )
+            retVal = memoryStream->getCurrentPtr();
+
+        // The aligned format pads blobs to 16 bytes. Don't require OGRE_SIMD_ALIGNMENT, which is
+        // 32 with AVX2: mapped blobs would never qualify. The VaoManager copies the data anyway.
+        const size_t alignment = mBlobAlignment ? mBlobAlignment : 16u;
+        if( !retVal || ( reinterpret_cast<uintptr_t>( retVal ) % alignment ) != 0u ||
+            stream->size() - stream->tell() < sizeBytes )
+        {
+            return 0;
+        }
+
+        stream->skip( static_cast<long>( sizeBytes ) );
+        return retVal;
+    }
+    //---------------------------------------------------------------------
+    uint8 MeshSerializerImpl::writeBlobPadding()
+    {
+        if( !mBlobAlignment )
+            return 0u;
+
+        // The padding size itself is written first, then the padding bytes
+        const size_t offset = mStream->tell() + 1u;
+        const uint8 padding = static_cast<uint8>( ( mBlobAlignment - offset % mBlobAlignment ) %
+                                                  mBlobAlignment );
+        const uint8 zeroes[256] = {};
+        writeData( &padding, 1, 1 );
+        writeData( zeroes, 1, padding );
+        return padding;
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::writeBlobPaddingTail( uint8 padding )
+    {
+        if( !mBlobAlignment )
+            return;
+
+        const uint8 zeroes[256] = {};
+        writeData( zeroes, 1, mBlobAlignment - 1u - padding );
+    }
+    //---------------------------------------------------------------------
+    uint8 MeshSerializerImpl::readBlobPadding( DataStreamPtr &stream )
+    {
+        if( !mBlobAlignment )
+            return 0u;
+
+        uint8 padding = 0u;
+        readChar( stream, &padding );
+        if( padding >= mBlobAlignment )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR, "Invalid blob padding. This mesh is invalid.",
+                         "MeshSerializerImpl::readBlobPadding" );
+        }
+        stream->skip( padding );
+        return padding;
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::skipBlobPaddingTail( DataStreamPtr &stream, uint8 padding )
+    {
+        if( mBlobAlignment )
+            stream->skip( static_cast<long>( mBlobAlignment - 1u - padding ) );
     }
     //---------------------------------------------------------------------
     void MeshSerializerImpl::readSubMeshLodOperation( DataStreamPtr &stream, SubMeshLod *subLod )
@@ -2287,10 +2438,27 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
         lodSource( 0 ),
         index32Bit( false ),
         numIndices( 0 ),
-        indexData( 0 )
+        indexData( 0 ),
+        operationType( OT_TRIANGLE_LIST ),
+        vertexDataInPlace( false ),
+        indexDataInPlace( false )
     {
     }
 
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    //---------------------------------------------------------------------
+    MeshSerializerImpl_v2_1_R2_Aligned::MeshSerializerImpl_v2_1_R2_Aligned( VaoManager *vaoManager ) :
+        MeshSerializerImpl( vaoManager )
+    {
+        // Version number
+        mVersion = "[MeshSerializer_v2.1 R2 Aligned]";
+        mBlobAlignment = 16u;
+    }
+    //---------------------------------------------------------------------
+    MeshSerializerImpl_v2_1_R2_Aligned::~MeshSerializerImpl_v2_1_R2_Aligned() {}
+
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
@@ -2351,27 +2519,7 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
         }
         catch( Exception & )
         {
-            SubMeshLodVec::iterator itor = totalSubmeshLods.begin();
-            SubMeshLodVec::iterator endt = totalSubmeshLods.end();
-
-            while( itor != endt )
-            {
-                Uint8Vec::iterator it = itor->vertexBuffers.begin();
-                Uint8Vec::iterator en = itor->vertexBuffers.end();
-
-                while( it != en )
-                    OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
-
-                itor->vertexBuffers.clear();
-
-                if( itor->indexData )
-                {
-                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
-                    itor->indexData = 0;
-                }
-
-                ++itor;
-            }
+            freeSubMeshLodData( totalSubmeshLods );
 
             // TODO: Delete created mVaos. Don't erase the data from those vaos?
 
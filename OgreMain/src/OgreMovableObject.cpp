@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "OgreMovableObject.h"
 
 #include "Animation/OgreSkeletonInstance.h"
+#include "Compute/OgreGpuCulling.h"
 #include "Math/Array/OgreArraySphere.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "OgreCamera.h"
@@ -71,6 +72,8 @@ namespace Ogre
         mListener( 0 ),
         mSkeletonInstance( 0 ),
         mObjectMemoryManager( objectMemoryManager ),
+        mGpuCulling( 0 ),
+        mGpuCullingSlot( std::numeric_limits<uint32>::max() ),
         mGlobalIndex( std::numeric_limits<size_t>::max() ),
         mParentIndex( std::numeric_limits<size_t>::max() )
     {
@@ -95,6 +98,8 @@ namespace Ogre
         mListener( 0 ),
         mSkeletonInstance( 0 ),
         mObjectMemoryManager( 0 ),
+        mGpuCulling( 0 ),
+        mGpuCullingSlot( std::numeric_limits<uint32>::max() ),
         mGlobalIndex( std::numeric_limits<size_t>::max() ),
         mParentIndex( std::numeric_limits<size_t>::max() )
     {
@@ -117,6 +122,9 @@ namespace Ogre
             static_cast<SceneNode *>( mParentNode )->detachObject( this );
         }
 
+        if( mGpuCulling )
+            mGpuCulling->untrackObject( this );
+
         if( mObjectMemoryManager )
             mObjectMemoryManager->objectDestroyed( mObjectData, mRenderQueueID );
 
@@ -133,6 +141,7 @@ namespace Ogre
         if( different )
         {
             mParentNode = parent;
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
             if( parent )
                 mObjectData.mParents[mObjectData.mIndex] = parent;
             else
@@ -168,6 +177,14 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void MovableObject::resetMeshLod() { mCurrentMeshLod = 0u; }
     //-----------------------------------------------------------------------
+    void MovableObject::notifyCullingChanged()
+    {
+        if( mObjectMemoryManager )
+            mObjectMemoryManager->_notifyObjectsChanged( mRenderQueueID );
+        if( mGpuCulling )
+            mGpuCulling->updateObject( this );
+    }
+    //-----------------------------------------------------------------------
     bool MovableObject::isStatic() const
     {
         return mObjectMemoryManager->getMemoryManagerType() == SCENE_STATIC;
@@ -298,6 +315,7 @@ namespace Ogre
     {
         mObjectData.mLocalAabb->setFromAabb( box, mObjectData.mIndex );
         mObjectData.mLocalRadius[mObjectData.mIndex] = box.getRadius();
+        mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
     }
     //-----------------------------------------------------------------------
     Aabb MovableObject::getLocalAabb() const
@@ -367,11 +385,31 @@ namespace Ogre
         return mWorldBoundingSphere;
     }*/
     //-----------------------------------------------------------------------
-    void MovableObject::updateAllBounds( const size_t numNodes, ObjectData objData )
+    bool MovableObject::updateAllBounds( const size_t numNodes, ObjectData objData, bool dirtyOnly,
+                                         MovableObjectArray *outChangedObjects )
     {
+        bool anyChanged = false;
         SimpleMatrix4 mats[ARRAY_PACKED_REALS];
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
         {
+            if( dirtyOnly )
+            {
+                bool blockDirty = false;
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    const Transform &parentTransform = objData.mParents[j]->_getTransform();
+                    blockDirty |= objData.mBoundsDirty[j];
+                    blockDirty |= ( parentTransform.mDirtyFlags[parentTransform.mIndex] &
+                                    TransformDirtyFlags::DerivedChanged ) != 0;
+                }
+
+                if( !blockDirty )
+                {
+                    objData.advanceBoundsPack();
+                    continue;
+                }
+            }
+
             // Retrieve from parents. Unfortunately we need to do SoA -> AoS -> SoA conversion
             ArrayMatrix4 parentMat;
             ArrayVector3 parentScale;
@@ -410,9 +448,28 @@ namespace Ogre
             ArrayReal *RESTRICT_ALIAS localRadius =
                 reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mLocalRadius );
 
-            *objData.mWorldAabb = *objData.mLocalAabb;
-            objData.mWorldAabb->transformAffine( parentMat );
-            *worldRadius = ( *localRadius ) * parentScale.getMaxComponent();
+            ArrayAabb newWorldAabb = *objData.mLocalAabb;
+            newWorldAabb.transformAffine( parentMat );
+            const ArrayReal newWorldRadius = ( *localRadius ) * parentScale.getMaxComponent();
+
+            // Only report blocks whose bounds really differ, so that still objects
+            // don't invalidate cached culling results every frame
+            if( memcmp( objData.mWorldAabb, &newWorldAabb, sizeof( ArrayAabb ) ) != 0 ||
+                memcmp( worldRadius, &newWorldRadius, sizeof( ArrayReal ) ) != 0 )
+            {
+                *objData.mWorldAabb = newWorldAabb;
+                *worldRadius = newWorldRadius;
+                anyChanged = true;
+
+                if( outChangedObjects )
+                {
+                    for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                    {
+                        if( objData.mOwner[j] && objData.mOwner[j]->mGpuCulling )
+                            outChangedObjects->push_back( objData.mOwner[j] );
+                    }
+                }
+            }
 
 #if OGRE_DEBUG_MODE
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
@@ -422,8 +479,13 @@ namespace Ogre
             }
 #endif
 
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                objData.mBoundsDirty[j] = false;
+
             objData.advanceBoundsPack();
         }
+
+        return anyChanged;
     }
     //-----------------------------------------------------------------------
     inline ArrayReal MovableObject::calculateCameraDistance( uint32 _cameraSortMode,
@@ -394,11 +394,34 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------
-    void Node::updateAllTransforms( const size_t numNodes, Transform t )
+    void Node::updateAllTransforms( const size_t numNodes, Transform t, bool dirtyOnly )
     {
         ArrayMatrix4 derivedTransform;
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
         {
+            if( dirtyOnly )
+            {
+                // Parents were already processed (they're in a lower depth level) so
+                // their DerivedChanged flag belongs to this frame
+                uint8 blockDirty = 0;
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    const Transform &parentTransform = t.mParents[j]->mTransform;
+                    blockDirty |= t.mDirtyFlags[j] & TransformDirtyFlags::LocalDirty;
+                    blockDirty |= parentTransform.mDirtyFlags[parentTransform.mIndex] &
+                                  TransformDirtyFlags::DerivedChanged;
+                }
+
+                if( !blockDirty )
+                {
+                    // Nothing changed. Our children & objects don't need updating either
+                    for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                        t.mDirtyFlags[j] = 0;
+                    t.advancePack();
+                    continue;
+                }
+            }
+
 #if OGRE_NODE_INHERIT_TRANSFORM
             // determine our transform, without parent part
             ArrayMatrix4 trSoA;
@@ -492,6 +515,10 @@ namespace Ogre
             }
 #endif
 
+            // The whole block was recalculated, even the nodes that weren't dirty
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                t.mDirtyFlags[j] = TransformDirtyFlags::DerivedChanged;
+
             t.advancePack();
         }
     }
@@ -571,6 +598,7 @@ namespace Ogre
         assert( !q.isNaN() && "Invalid orientation supplied as parameter" );
         q.normalise();
         mTransform.mOrientation->setFromQuaternion( q, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -582,6 +610,7 @@ namespace Ogre
     void Node::resetOrientation()
     {
         mTransform.mOrientation->setFromQuaternion( Quaternion::IDENTITY, mTransform.mIndex );
+        _setTransformDirty();
     }
 
     //-----------------------------------------------------------------------
@@ -589,6 +618,7 @@ namespace Ogre
     {
         assert( !pos.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mPosition->setFromVector3( pos, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -645,6 +675,7 @@ namespace Ogre
         }
 
         mTransform.mPosition->setFromVector3( position, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -715,6 +746,7 @@ namespace Ogre
         orientation.normalise();
 
         mTransform.mOrientation->setFromQuaternion( orientation, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
 
@@ -851,6 +883,7 @@ namespace Ogre
     {
         assert( !inScale.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mScale->setFromVector3( inScale, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -861,6 +894,7 @@ namespace Ogre
     void Node::setInheritOrientation( bool inherit )
     {
         mTransform.mInheritOrientation[mTransform.mIndex] = inherit;
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -872,6 +906,7 @@ namespace Ogre
     void Node::setInheritScale( bool inherit )
     {
         mTransform.mInheritScale[mTransform.mIndex] = inherit;
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -881,6 +916,7 @@ namespace Ogre
     {
         mTransform.mScale->setFromVector3(
             mTransform.mScale->getAsVector3( mTransform.mIndex ) * inScale, mTransform.mIndex );
+        _setTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -251,10 +251,24 @@ namespace Ogre
                                                                               imgData->numMipmaps,     //
                                                                               rowAlignment );
 
-        // Bind output buffer
-        imgData->box.data = OGRE_MALLOC_SIMD( requiredBytes, MEMCATEGORY_RESOURCE );
+        // OITD data is already laid out exactly like Image2 wants it. If the file is mapped,
+        // point straight into it instead of copying it to the heap.
+        const MemoryMappedDataStream *mappedStream =
+            dynamic_cast<const MemoryMappedDataStream *>( stream.get() );
+        if( mappedStream && stream->size() - stream->tell() >= requiredBytes )
+        {
+            imgData->box.data = const_cast<uchar *>( mappedStream->getCurrentPtr() );
+            imgData->freeOnDestruction = false;
+            imgData->backingStream = stream;
+            stream->skip( static_cast<long>( requiredBytes ) );
+        }
+        else
+        {
+            // Bind output buffer
+            imgData->box.data = OGRE_MALLOC_SIMD( requiredBytes, MEMCATEGORY_RESOURCE );
 
-        stream->read( imgData->box.data, requiredBytes );
+            stream->read( imgData->box.data, requiredBytes );
+        }
 
         DecodeResult ret;
         ret.first.reset();
@@ -179,7 +179,33 @@ namespace Ogre
     void ObjCmdBuffer::UploadFromStagingTex::execute()
     {
         OgreProfileExhaustive( "ObjCmdBuffer::UploadFromStagingTex::execute" );
-        stagingTexture->upload( box, dstTexture, mipLevel, &dstBox, &dstBox );
+#ifdef OGRE_PROFILING_TEXTURES
+        Timer profilingTimer;
+#endif
+        if( box.equalSize( dstBox ) )
+            stagingTexture->upload( box, dstTexture, mipLevel, &dstBox, &dstBox );
+        else
+        {
+            // Padded in case the texture got packed into a bigger TexturePool. Upload as
+            // much of it as the slice really has (i.e. none of it if it didn't get packed).
+            // Packed textures never have a system RAM copy.
+            const TexturePool *pool = dstTexture->getTexturePool();
+            const uint32 sliceWidth = pool ? pool->masterTexture->getWidth() : dstTexture->getWidth();
+            const uint32 sliceHeight =
+                pool ? pool->masterTexture->getHeight() : dstTexture->getHeight();
+
+            TextureBox srcBox = box;
+            srcBox.width = std::min( box.width, std::max( 1u, sliceWidth >> mipLevel ) );
+            srcBox.height = std::min( box.height, std::max( 1u, sliceHeight >> mipLevel ) );
+            TextureBox paddedDstBox = dstBox;
+            paddedDstBox.width = srcBox.width;
+            paddedDstBox.height = srcBox.height;
+            stagingTexture->upload( srcBox, dstTexture, mipLevel, 0, &paddedDstBox, true );
+        }
+#ifdef OGRE_PROFILING_TEXTURES
+        dstTexture->getTextureManager()->_addLoadingStageTime(
+            dstTexture, TextureLoadStage::GpuUpload, profilingTimer.getMicroseconds() );
+#endif
     }
     //-----------------------------------------------------------------------------------
     ObjCmdBuffer::NotifyDataIsReady::NotifyDataIsReady( TextureGpu *_textureGpu,
@@ -209,10 +235,15 @@ namespace Ogre
 #ifdef OGRE_PROFILING_TEXTURES
     //-----------------------------------------------------------------------------------
     ObjCmdBuffer::LogProfilingData::LogProfilingData( TextureGpu *_textureGpu, uint32 _dstSliceOrDepth,
-                                                      uint64 microsecondsTaken ) :
+                                                      uint64 microsecondsTaken,
+                                                      const uint64 *usStages ) :
         texture( _textureGpu ),
         dstSliceOrDepth( _dstSliceOrDepth ),
-        millisecondsTaken( static_cast<uint32>( microsecondsTaken / 10ul ) )
+        millisecondsTaken( static_cast<uint32>( microsecondsTaken / 10ul ) ),
+        usFileIo( usStages[TextureLoadStage::FileIo] ),
+        usDecode( usStages[TextureLoadStage::Decode] ),
+        usFilters( usStages[TextureLoadStage::Filters] ),
+        usStagingCopy( usStages[TextureLoadStage::StagingCopy] )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -232,6 +263,12 @@ namespace Ogre
             logMsg.a( dstSliceOrDepth, " ", texture->getNameStr().c_str() );
 
         LogManager::getSingleton().logMessage( String( logMsg.c_str(), logMsg.size() ) );
+
+        TextureGpuManager *textureManager = texture->getTextureManager();
+        textureManager->_addLoadingStageTime( texture, TextureLoadStage::FileIo, usFileIo );
+        textureManager->_addLoadingStageTime( texture, TextureLoadStage::Decode, usDecode );
+        textureManager->_addLoadingStageTime( texture, TextureLoadStage::Filters, usFilters );
+        textureManager->_addLoadingStageTime( texture, TextureLoadStage::StagingCopy, usStagingCopy );
     }
 #endif
 }  // namespace Ogre
@@ -915,6 +915,7 @@ namespace Ogre
 
             mObjectData.mLocalAabb->setFromAabb( aabb, mObjectData.mIndex );
             mObjectData.mLocalRadius[mObjectData.mIndex] = aabb.getRadius();
+            mObjectData.mBoundsDirty[mObjectData.mIndex] = true;
         }
     }
     //-----------------------------------------------------------------------
@@ -38,6 +38,12 @@ THE SOFTWARE.
 #include "OgreProfiler.h"
 #include "OgreTextureBox.h"
 
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#endif
+
 namespace Ogre
 {
 #if OGRE_COMPILER == OGRE_COMPILER_MSVC && OGRE_COMP_VER < 1800
@@ -1302,6 +1308,92 @@ namespace Ogre
         void convCopy2Bpx( uint8 *src, uint8 *dst, size_t width ) { memcpy( dst, src, 2 * width ); }
         void convCopy1Bpx( uint8 *src, uint8 *dst, size_t width ) { memcpy( dst, src, 1 * width ); }
 
+        /// Processes as many pixels as possible in batches, returns how many were converted.
+        /// Only covers layouts which are hot enough to deserve it (image loading & readbacks).
+        size_t convRGBAtoBGRABatch( const uint8 *src, uint8 *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_SSE
+            const __m128i maskAG = _mm_set1_epi32( static_cast<int>( 0xFF00FF00 ) );
+            const __m128i maskR = _mm_set1_epi32( 0x000000FF );
+            for( ; x + 4u <= width; x += 4u )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + x * 4u ) );
+                __m128i result = _mm_and_si128( v, maskAG );
+                result = _mm_or_si128( result, _mm_slli_epi32( _mm_and_si128( v, maskR ), 16 ) );
+                result = _mm_or_si128( result, _mm_and_si128( _mm_srli_epi32( v, 16 ), maskR ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + x * 4u ), result );
+            }
+#elif __OGRE_HAVE_NEON
+            for( ; x + 16u <= width; x += 16u )
+            {
+                uint8x16x4_t v = vld4q_u8( src + x * 4u );
+                const uint8x16_t tmp = v.val[0];
+                v.val[0] = v.val[2];
+                v.val[2] = tmp;
+                vst4q_u8( dst + x * 4u, v );
+            }
+#endif
+            return x;
+        }
+
+        size_t convRGBtoRGBABatch( const uint8 *src, uint8 *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_NEON
+            for( ; x + 16u <= width; x += 16u )
+            {
+                const uint8x16x3_t v = vld3q_u8( src + x * 3u );
+                uint8x16x4_t result;
+                result.val[0] = v.val[0];
+                result.val[1] = v.val[1];
+                result.val[2] = v.val[2];
+                result.val[3] = vdupq_n_u8( 0xFF );
+                vst4q_u8( dst + x * 4u, result );
+            }
+#elif OGRE_ENDIAN == OGRE_ENDIAN_LITTLE
+            // 4 pixels are exactly 3 words in and 4 words out
+            for( ; x + 4u <= width; x += 4u )
+            {
+                uint32 w[3];
+                memcpy( w, src + x * 3u, sizeof( w ) );
+                const uint32 p[4] = { w[0] | 0xFF000000u,                         //
+                                      ( w[0] >> 24u ) | ( w[1] << 8u ) | 0xFF000000u,  //
+                                      ( w[1] >> 16u ) | ( w[2] << 16u ) | 0xFF000000u,  //
+                                      ( w[2] >> 8u ) | 0xFF000000u };
+                memcpy( dst + x * 4u, p, sizeof( p ) );
+            }
+#endif
+            return x;
+        }
+
+        size_t convRGBAtoRGBBatch( const uint8 *src, uint8 *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_NEON
+            for( ; x + 16u <= width; x += 16u )
+            {
+                const uint8x16x4_t v = vld4q_u8( src + x * 4u );
+                uint8x16x3_t result;
+                result.val[0] = v.val[0];
+                result.val[1] = v.val[1];
+                result.val[2] = v.val[2];
+                vst3q_u8( dst + x * 3u, result );
+            }
+#elif OGRE_ENDIAN == OGRE_ENDIAN_LITTLE
+            for( ; x + 4u <= width; x += 4u )
+            {
+                uint32 p[4];
+                memcpy( p, src + x * 4u, sizeof( p ) );
+                const uint32 w[3] = { ( p[0] & 0x00FFFFFFu ) | ( p[1] << 24u ),
+                                      ( ( p[1] >> 8u ) & 0x0000FFFFu ) | ( p[2] << 16u ),
+                                      ( ( p[2] >> 16u ) & 0x000000FFu ) | ( p[3] << 8u ) };
+                memcpy( dst + x * 3u, w, sizeof( w ) );
+            }
+#endif
+            return x;
+        }
+
         // clang-format off
         void convRGBA32toRGB32(uint8* _src, uint8* _dst, size_t width) {
             uint32* src = (uint32*)_src; uint32* dst = (uint32*)_dst;
@@ -1343,10 +1435,14 @@ namespace Ogre
         }
 
         void convRGBAtoBGRA(uint8* src, uint8* dst, size_t width) {
+            const size_t x = convRGBAtoBGRABatch(src, dst, width);
+            src += x * 4; dst += x * 4; width -= x;
             while (width--)
             { dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0]; dst[3] = src[3]; src += 4; dst += 4; }
         }
         void convRGBAtoRGB(uint8* src, uint8* dst, size_t width) {
+            const size_t x = convRGBAtoRGBBatch(src, dst, width);
+            src += x * 4; dst += x * 3; width -= x;
             while (width--) { dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; src += 4; dst += 3; }
         }
         void convRGBAtoBGR(uint8* src, uint8* dst, size_t width) {
@@ -1388,6 +1484,8 @@ namespace Ogre
         }
 
         void convRGBtoRGBA(uint8* src, uint8* dst, size_t width) {
+            const size_t x = convRGBtoRGBABatch(src, dst, width);
+            src += x * 3; dst += x * 4; width -= x;
             while (width--)
             { dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 0xFF; src += 3; dst += 4; }
         }
@@ -1440,6 +1538,432 @@ namespace Ogre
             while (width--) { dst[0] = src[0]; src += 2; dst += 1; }
         }
         // clang-format on
+
+        /// Lookup tables for the fast paths of bulkPixelConversion. They're built with
+        /// unpackColour & packColour so that results are bit-exact with the generic path.
+        struct ConversionTables
+        {
+            float unormToFloat[256];
+            float srgbToFloat[256];
+            uint8 unormToSrgb[256];
+            uint8 srgbToUnorm[256];
+            /// floatToSrgb[i] is the smallest float that is encoded as the sRGB value i
+            float floatToSrgb[256];
+            /// Encoded value of the smallest float with the given upper 16 bits, in [0; 1)
+            uint8 floatToSrgbStart[0x3F80];
+
+            ConversionTables()
+            {
+                float rgba[4];
+                for( size_t i = 0u; i < 256u; ++i )
+                {
+                    const uint8 value[4] = { uint8( i ), uint8( i ), uint8( i ), uint8( i ) };
+                    uint8 result[4];
+
+                    PixelFormatGpuUtils::unpackColour( rgba, PFG_RGBA8_UNORM, value );
+                    unormToFloat[i] = rgba[0];
+                    PixelFormatGpuUtils::packColour( rgba, PFG_RGBA8_UNORM_SRGB, result );
+                    unormToSrgb[i] = result[0];
+
+                    PixelFormatGpuUtils::unpackColour( rgba, PFG_RGBA8_UNORM_SRGB, value );
+                    srgbToFloat[i] = rgba[0];
+                    PixelFormatGpuUtils::packColour( rgba, PFG_RGBA8_UNORM, result );
+                    srgbToUnorm[i] = result[0];
+                }
+
+                // Binary search over the bit patterns of [0; 1], which sort like the floats do
+                floatToSrgb[0] = 0.0f;
+                for( size_t i = 1u; i < 256u; ++i )
+                {
+                    uint32 lo = 0u;
+                    uint32 hi = 0x3F800000;  // 1.0f
+                    while( lo < hi )
+                    {
+                        const uint32 mid = lo + ( hi - lo ) / 2u;
+                        float value;
+                        memcpy( &value, &mid, sizeof( value ) );
+                        if( encodeSrgb( value ) >= i )
+                            hi = mid;
+                        else
+                            lo = mid + 1u;
+                    }
+                    memcpy( &floatToSrgb[i], &lo, sizeof( float ) );
+                }
+
+                size_t idx = 0u;
+                for( uint32 i = 0u; i < 0x3F80u; ++i )
+                {
+                    const uint32 bits = i << 16u;
+                    float value;
+                    memcpy( &value, &bits, sizeof( value ) );
+                    while( idx < 255u && value >= floatToSrgb[idx + 1u] )
+                        ++idx;
+                    floatToSrgbStart[i] = static_cast<uint8>( idx );
+                }
+            }
+
+            static uint8 encodeSrgb( float value )
+            {
+                const float rgba[4] = { value, value, value, value };
+                uint8 result[4];
+                PixelFormatGpuUtils::packColour( rgba, PFG_RGBA8_UNORM_SRGB, result );
+                return result[0];
+            }
+        };
+
+        const ConversionTables &getConversionTables()
+        {
+            static const ConversionTables tables;
+            return tables;
+        }
+
+        /// Same as convertFromFloat for an unsigned normalized 8-bit value
+        inline uint8 floatToUnorm8( float value )
+        {
+            return static_cast<uint8>( roundf( Math::saturate( value ) * 255.0f ) );
+        }
+
+        /// Same as convertFromFloat for an sRGB 8-bit value
+        inline uint8 floatToSrgb8( const ConversionTables &tables, float value )
+        {
+            if( !( value > 0.0f ) )
+                return 0u;  // Also catches NaNs
+            if( value >= tables.floatToSrgb[255] )
+                return 255u;
+
+            // Start close and find the last entry <= value. It's rarely more than one step away.
+            uint32 bits;
+            memcpy( &bits, &value, sizeof( bits ) );
+            size_t idx = tables.floatToSrgbStart[bits >> 16u];
+            while( value >= tables.floatToSrgb[idx + 1u] )
+                ++idx;
+            return static_cast<uint8>( idx );
+        }
+
+        /// Converts between the 8-bit sRGB & linear versions of RGBA8 / BGRA8, with R & B
+        /// at the given offsets in the source
+        template <size_t R, size_t B, bool toSRgb>
+        void convRGBA8ColourSpace( uint8 *src, uint8 *dst, size_t width )
+        {
+            const ConversionTables &tables = getConversionTables();
+            const uint8 *lut = toSRgb ? tables.unormToSrgb : tables.srgbToUnorm;
+            while( width-- )
+            {
+                dst[0] = lut[src[R]];
+                dst[1] = lut[src[1]];
+                dst[2] = lut[src[B]];
+                dst[3] = src[3];
+                src += 4;
+                dst += 4;
+            }
+        }
+
+        /** Conversions through float are done in two steps with a small RGBA32_FLOAT buffer in
+            between, so that each format only needs to know how to unpack & pack itself.
+            Results are bit-exact with unpackColour & packColour (NaNs aside).
+        */
+        typedef void ( *row_unpack_func_t )( const uint8 *src, float *dst, size_t width );
+        typedef void ( *row_pack_func_t )( const float *src, uint8 *dst, size_t width );
+
+        static const size_t c_conversionBatchSize = 64u;
+
+        template <size_t R, size_t B, bool sRGB>
+        void unpackRGBA8( const uint8 *src, float *dst, size_t width )
+        {
+            const ConversionTables &tables = getConversionTables();
+            const float *lut = sRGB ? tables.srgbToFloat : tables.unormToFloat;
+            while( width-- )
+            {
+                dst[0] = lut[src[R]];
+                dst[1] = lut[src[1]];
+                dst[2] = lut[src[B]];
+                dst[3] = tables.unormToFloat[src[3]];
+                src += 4;
+                dst += 4;
+            }
+        }
+
+        template <size_t R, size_t B>
+        void packRGBA8( const float *src, uint8 *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const __m128 c255 = _mm_set1_ps( 255.0f );
+            const __m128 half = _mm_set1_ps( 0.5f );
+            for( ; x + 4u <= width; x += 4u )
+            {
+                __m128i pixels[4];
+                for( size_t i = 0u; i < 4u; ++i )
+                {
+                    __m128 v = _mm_loadu_ps( src + ( x + i ) * 4u );
+                    if( R != 0u )
+                        v = _mm_shuffle_ps( v, v, _MM_SHUFFLE( 3, 0, 1, 2 ) );
+                    v = _mm_mul_ps( _mm_min_ps( _mm_max_ps( v, zero ), one ), c255 );
+                    // Round half away from zero like roundf, not to nearest even
+                    const __m128i truncated = _mm_cvttps_epi32( v );
+                    const __m128 fraction = _mm_sub_ps( v, _mm_cvtepi32_ps( truncated ) );
+                    pixels[i] = _mm_sub_epi32( truncated,
+                                               _mm_castps_si128( _mm_cmpge_ps( fraction, half ) ) );
+                }
+                const __m128i packed = _mm_packus_epi16( _mm_packs_epi32( pixels[0], pixels[1] ),
+                                                         _mm_packs_epi32( pixels[2], pixels[3] ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + x * 4u ), packed );
+            }
+#endif
+            for( ; x < width; ++x )
+            {
+                dst[x * 4u + R] = floatToUnorm8( src[x * 4u + 0u] );
+                dst[x * 4u + 1u] = floatToUnorm8( src[x * 4u + 1u] );
+                dst[x * 4u + B] = floatToUnorm8( src[x * 4u + 2u] );
+                dst[x * 4u + 3u] = floatToUnorm8( src[x * 4u + 3u] );
+            }
+        }
+
+        template <size_t R, size_t B>
+        void packRGBA8_sRGB( const float *src, uint8 *dst, size_t width )
+        {
+            const ConversionTables &tables = getConversionTables();
+            while( width-- )
+            {
+                dst[R] = floatToSrgb8( tables, src[0] );
+                dst[1] = floatToSrgb8( tables, src[1] );
+                dst[B] = floatToSrgb8( tables, src[2] );
+                dst[3] = floatToUnorm8( src[3] );
+                src += 4;
+                dst += 4;
+            }
+        }
+
+        void unpackRGB10A2( const uint8 *src, float *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_SSE
+            const __m128i mask10 = _mm_set1_epi32( 0x3FF );
+            const __m128 c1023 = _mm_set1_ps( 1023.0f );
+            const __m128 c3 = _mm_set1_ps( 3.0f );
+            for( ; x + 4u <= width; x += 4u )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + x * 4u ) );
+                __m128 r = _mm_div_ps( _mm_cvtepi32_ps( _mm_and_si128( v, mask10 ) ), c1023 );
+                __m128 g = _mm_div_ps(
+                    _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 10 ), mask10 ) ), c1023 );
+                __m128 b = _mm_div_ps(
+                    _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 20 ), mask10 ) ), c1023 );
+                __m128 a = _mm_div_ps( _mm_cvtepi32_ps( _mm_srli_epi32( v, 30 ) ), c3 );
+                _MM_TRANSPOSE4_PS( r, g, b, a );
+                _mm_storeu_ps( dst + x * 4u + 0u, r );
+                _mm_storeu_ps( dst + x * 4u + 4u, g );
+                _mm_storeu_ps( dst + x * 4u + 8u, b );
+                _mm_storeu_ps( dst + x * 4u + 12u, a );
+            }
+#endif
+            for( ; x < width; ++x )
+                PixelFormatGpuUtils::unpackColour( dst + x * 4u, PFG_R10G10B10A2_UNORM, src + x * 4u );
+        }
+
+        void packRGB10A2( const float *src, uint8 *dst, size_t width )
+        {
+            size_t x = 0u;
+#if __OGRE_HAVE_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const __m128 half = _mm_set1_ps( 0.5f );
+            const __m128 c1023 = _mm_set1_ps( 1023.0f );
+            const __m128 c3 = _mm_set1_ps( 3.0f );
+            for( ; x + 4u <= width; x += 4u )
+            {
+                __m128 r = _mm_loadu_ps( src + x * 4u + 0u );
+                __m128 g = _mm_loadu_ps( src + x * 4u + 4u );
+                __m128 b = _mm_loadu_ps( src + x * 4u + 8u );
+                __m128 a = _mm_loadu_ps( src + x * 4u + 12u );
+                _MM_TRANSPOSE4_PS( r, g, b, a );
+                r = _mm_add_ps( _mm_mul_ps( _mm_min_ps( _mm_max_ps( r, zero ), one ), c1023 ), half );
+                g = _mm_add_ps( _mm_mul_ps( _mm_min_ps( _mm_max_ps( g, zero ), one ), c1023 ), half );
+                b = _mm_add_ps( _mm_mul_ps( _mm_min_ps( _mm_max_ps( b, zero ), one ), c1023 ), half );
+                a = _mm_add_ps( _mm_mul_ps( _mm_min_ps( _mm_max_ps( a, zero ), one ), c3 ), half );
+                __m128i packed = _mm_cvttps_epi32( r );
+                packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( g ), 10 ) );
+                packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( b ), 20 ) );
+                packed = _mm_or_si128( packed, _mm_slli_epi32( _mm_cvttps_epi32( a ), 30 ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + x * 4u ), packed );
+            }
+#endif
+            for( ; x < width; ++x )
+                PixelFormatGpuUtils::packColour( src + x * 4u, PFG_R10G10B10A2_UNORM, dst + x * 4u );
+        }
+
+#if __OGRE_HAVE_SSE
+        /// Vectorized Bitwise::halfToFloatI on the low 16 bits of each lane
+        inline __m128 halfToFloat4( __m128i h )
+        {
+            const __m128i shifted = _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 0x7FFF ) ), 13 );
+            const __m128i exponent = _mm_and_si128( shifted, _mm_set1_epi32( 0x0F800000 ) );
+            const __m128i expAdjust = _mm_set1_epi32( ( 127 - 15 ) << 23 );
+
+            __m128i result = _mm_add_epi32( shifted, expAdjust );
+            // Inf & NaN: the exponent goes all the way up
+            const __m128i isInfNan = _mm_cmpeq_epi32( exponent, _mm_set1_epi32( 0x0F800000 ) );
+            result = _mm_add_epi32( result, _mm_and_si128( isInfNan, expAdjust ) );
+            // Zero & denormals: renormalize with float math, which is exact here
+            const __m128i isDenormal = _mm_cmpeq_epi32( exponent, _mm_setzero_si128() );
+            const __m128i magic = _mm_set1_epi32( 113 << 23 );
+            const __m128i renormalized = _mm_castps_si128(
+                _mm_sub_ps( _mm_castsi128_ps( _mm_add_epi32( result, _mm_set1_epi32( 1 << 23 ) ) ),
+                            _mm_castsi128_ps( magic ) ) );
+            result = _mm_or_si128( _mm_andnot_si128( isDenormal, result ),
+                                   _mm_and_si128( isDenormal, renormalized ) );
+
+            const __m128i sign = _mm_slli_epi32( _mm_and_si128( h, _mm_set1_epi32( 0x8000 ) ), 16 );
+            return _mm_castsi128_ps( _mm_or_si128( result, sign ) );
+        }
+
+        /// Vectorized Bitwise::floatToHalfI, including its truncation & handling of tiny values
+        inline __m128i floatToHalf4( __m128 value )
+        {
+            const __m128i i = _mm_castps_si128( value );
+            const __m128i absI = _mm_and_si128( i, _mm_set1_epi32( 0x7FFFFFFF ) );
+            const __m128i exponent = _mm_srli_epi32( absI, 23 );
+            const __m128i mantissa = _mm_and_si128( i, _mm_set1_epi32( 0x007FFFFF ) );
+
+            // Normal
+            __m128i result = _mm_sub_epi32( _mm_srli_epi32( absI, 13 ),
+                                            _mm_set1_epi32( ( 127 - 15 ) << 10 ) );
+            // Denormal: ( m | 0x00800000 ) >> ( 1 - e ) >> 13 is a truncation of |value| * 2^24
+            const __m128i isDenormal = _mm_cmplt_epi32( exponent, _mm_set1_epi32( 127 - 15 + 1 ) );
+            const __m128i denormal = _mm_cvttps_epi32(
+                _mm_mul_ps( _mm_castsi128_ps( absI ), _mm_set1_ps( 16777216.0f ) ) );
+            result = _mm_or_si128( _mm_andnot_si128( isDenormal, result ),
+                                   _mm_and_si128( isDenormal, denormal ) );
+            // Overflow, Inf & NaN
+            const __m128i isInfNan = _mm_cmpgt_epi32( exponent, _mm_set1_epi32( 127 + 15 ) );
+            const __m128i isNan = _mm_andnot_si128(
+                _mm_cmpeq_epi32( mantissa, _mm_setzero_si128() ),
+                _mm_cmpeq_epi32( exponent, _mm_set1_epi32( 0xFF ) ) );
+            __m128i nanBits = _mm_srli_epi32( mantissa, 13 );
+            nanBits = _mm_or_si128(
+                nanBits, _mm_and_si128( _mm_cmpeq_epi32( nanBits, _mm_setzero_si128() ),
+                                        _mm_set1_epi32( 1 ) ) );
+            const __m128i infNan =
+                _mm_or_si128( _mm_set1_epi32( 0x7C00 ), _mm_and_si128( isNan, nanBits ) );
+            result = _mm_or_si128( _mm_andnot_si128( isInfNan, result ),
+                                   _mm_and_si128( isInfNan, infNan ) );
+            // Values so small they become 0 also lose their sign
+            const __m128i keepsSign = _mm_cmpgt_epi32( exponent, _mm_set1_epi32( 127 - 15 - 11 ) );
+            const __m128i sign =
+                _mm_and_si128( _mm_srli_epi32( i, 16 ), _mm_set1_epi32( 0x8000 ) );
+            return _mm_or_si128( result, _mm_and_si128( keepsSign, sign ) );
+        }
+#endif
+
+        void unpackRGBA16Float( const uint8 *_src, float *dst, size_t width )
+        {
+            const uint16 *src = reinterpret_cast<const uint16 *>( _src );
+            const size_t numValues = width * 4u;
+            size_t i = 0u;
+#if __OGRE_HAVE_SSE
+            for( ; i + 8u <= numValues; i += 8u )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src + i ) );
+                _mm_storeu_ps( dst + i, halfToFloat4( _mm_unpacklo_epi16( v, _mm_setzero_si128() ) ) );
+                _mm_storeu_ps( dst + i + 4u,
+                               halfToFloat4( _mm_unpackhi_epi16( v, _mm_setzero_si128() ) ) );
+            }
+#endif
+            for( ; i < numValues; ++i )
+                dst[i] = Bitwise::halfToFloat( src[i] );
+        }
+
+        void packRGBA16Float( const float *src, uint8 *_dst, size_t width )
+        {
+            uint16 *dst = reinterpret_cast<uint16 *>( _dst );
+            const size_t numValues = width * 4u;
+            size_t i = 0u;
+#if __OGRE_HAVE_SSE
+            for( ; i + 8u <= numValues; i += 8u )
+            {
+                __m128i lo = floatToHalf4( _mm_loadu_ps( src + i ) );
+                __m128i hi = floatToHalf4( _mm_loadu_ps( src + i + 4u ) );
+                // Sign extend so that packs doesn't saturate
+                lo = _mm_srai_epi32( _mm_slli_epi32( lo, 16 ), 16 );
+                hi = _mm_srai_epi32( _mm_slli_epi32( hi, 16 ), 16 );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst + i ), _mm_packs_epi32( lo, hi ) );
+            }
+#endif
+            for( ; i < numValues; ++i )
+                dst[i] = Bitwise::floatToHalf( src[i] );
+        }
+
+        void unpackRGBA32Float( const uint8 *src, float *dst, size_t width )
+        {
+            memcpy( dst, src, width * 4u * sizeof( float ) );
+        }
+
+        void packRGBA32Float( const float *src, uint8 *_dst, size_t width )
+        {
+            float *dst = reinterpret_cast<float *>( _dst );
+            // The generic path does rgba * 1.0f + 0.0f, which turns -0 into +0
+            for( size_t i = 0u; i < width * 4u; ++i )
+                dst[i] = src[i] + 0.0f;
+        }
+
+        row_unpack_func_t getRowUnpackFunc( PixelFormatGpu format )
+        {
+            switch( format )
+            {
+                // clang-format off
+            case PFG_RGBA8_UNORM:       return unpackRGBA8<0, 2, false>;
+            case PFG_RGBA8_UNORM_SRGB:  return unpackRGBA8<0, 2, true>;
+            case PFG_BGRA8_UNORM:       return unpackRGBA8<2, 0, false>;
+            case PFG_BGRA8_UNORM_SRGB:  return unpackRGBA8<2, 0, true>;
+            case PFG_R10G10B10A2_UNORM: return unpackRGB10A2;
+            case PFG_RGBA16_FLOAT:      return unpackRGBA16Float;
+            case PFG_RGBA32_FLOAT:      return unpackRGBA32Float;
+            default:                    return 0;
+                // clang-format on
+            }
+        }
+
+        row_pack_func_t getRowPackFunc( PixelFormatGpu format )
+        {
+            switch( format )
+            {
+                // clang-format off
+            case PFG_RGBA8_UNORM:       return packRGBA8<0, 2>;
+            case PFG_RGBA8_UNORM_SRGB:  return packRGBA8_sRGB<0, 2>;
+            case PFG_BGRA8_UNORM:       return packRGBA8<2, 0>;
+            case PFG_BGRA8_UNORM_SRGB:  return packRGBA8_sRGB<2, 0>;
+            case PFG_R10G10B10A2_UNORM: return packRGB10A2;
+            case PFG_RGBA16_FLOAT:      return packRGBA16Float;
+            case PFG_RGBA32_FLOAT:      return packRGBA32Float;
+            default:                    return 0;
+                // clang-format on
+            }
+        }
+
+        /// Returns a direct conversion between sRGB & linear RGBA8 / BGRA8, if that's the case
+        row_conversion_func_t getColourSpaceConversionFunc( PixelFormatGpu srcFormat,
+                                                            PixelFormatGpu dstFormat )
+        {
+            const bool srcIsBgra = srcFormat == PFG_BGRA8_UNORM || srcFormat == PFG_BGRA8_UNORM_SRGB;
+            const bool dstIsBgra = dstFormat == PFG_BGRA8_UNORM || dstFormat == PFG_BGRA8_UNORM_SRGB;
+            if( !srcIsBgra && srcFormat != PFG_RGBA8_UNORM && srcFormat != PFG_RGBA8_UNORM_SRGB )
+                return 0;
+            if( !dstIsBgra && dstFormat != PFG_RGBA8_UNORM && dstFormat != PFG_RGBA8_UNORM_SRGB )
+                return 0;
+
+            const bool srcIsSRgb = PixelFormatGpuUtils::isSRgb( srcFormat );
+            if( srcIsSRgb == PixelFormatGpuUtils::isSRgb( dstFormat ) )
+                return 0;  // Not a colour space conversion
+
+            if( srcIsBgra == dstIsBgra )
+            {
+                return srcIsSRgb ? convRGBA8ColourSpace<0, 2, false>
+                                 : convRGBA8ColourSpace<0, 2, true>;
+            }
+            return srcIsSRgb ? convRGBA8ColourSpace<2, 0, false> : convRGBA8ColourSpace<2, 0, true>;
+        }
     }  // namespace
     //-----------------------------------------------------------------------------------
     void PixelFormatGpuUtils::bulkPixelConversion( const TextureBox &src, PixelFormatGpu srcFormat,
@@ -1542,7 +2066,7 @@ namespace Ogre
             case PFL_PAIR( PFL_BGR8, PFL_RGBA8 ): rowConversionFunc = convRGBtoBGRA; break;
             case PFL_PAIR( PFL_BGR8, PFL_BGRA8 ): rowConversionFunc = convRGBtoRGBA; break;
             case PFL_PAIR( PFL_BGR8, PFL_BGRX8 ): rowConversionFunc = convRGBtoRGBA; break;
-            case PFL_PAIR( PFL_BGR8, PFL_RGB8 ): rowConversionFunc = convRGBAtoBGR; break;
+            case PFL_PAIR( PFL_BGR8, PFL_RGB8 ): rowConversionFunc = convRGBtoBGR; break;
             case PFL_PAIR( PFL_BGR8, PFL_RG8 ): rowConversionFunc = convBGRtoRG; break;
             case PFL_PAIR( PFL_BGR8, PFL_R8 ): rowConversionFunc = convBGRtoR; break;
 
@@ -1588,6 +2112,9 @@ namespace Ogre
         }
 #undef PFL_PAIR
 
+        if( !rowConversionFunc )
+            rowConversionFunc = getColourSpaceConversionFunc( srcFormat, dstFormat );
+
         if( rowConversionFunc )
         {
             for( size_t z = 0; z < depthOrSlices; ++z )
@@ -1603,6 +2130,29 @@ namespace Ogre
             return;
         }
 
+        const row_unpack_func_t rowUnpackFunc = getRowUnpackFunc( srcFormat );
+        const row_pack_func_t rowPackFunc = getRowPackFunc( dstFormat );
+        if( rowUnpackFunc && rowPackFunc )
+        {
+            float tmpRgba[c_conversionBatchSize * 4u];
+            for( size_t z = 0; z < depthOrSlices; ++z )
+            {
+                for( size_t y = 0; y < height; ++y )
+                {
+                    size_t dest_y = verticalFlip ? height - 1 - y : y;
+                    uint8 *srcPtr = srcData + src.bytesPerImage * z + src.bytesPerRow * y;
+                    uint8 *dstPtr = dstData + dst.bytesPerImage * z + dst.bytesPerRow * dest_y;
+                    for( size_t x = 0; x < width; x += c_conversionBatchSize )
+                    {
+                        const size_t batchSize = std::min( width - x, c_conversionBatchSize );
+                        rowUnpackFunc( srcPtr + x * srcBytesPerPixel, tmpRgba, batchSize );
+                        rowPackFunc( tmpRgba, dstPtr + x * dstBytesPerPixel, batchSize );
+                    }
+                }
+            }
+            return;
+        }
+
         // The brute force fallback
         float rangeM = 1.0f;
         float rangeA = 0.0f;
@@ -33,6 +33,8 @@ THE SOFTWARE.
 #include "CommandBuffer/OgreCbPipelineStateObject.h"
 #include "CommandBuffer/OgreCbShaderBuffer.h"
 #include "CommandBuffer/OgreCommandBuffer.h"
+#include "Compute/OgreGpuCulling.h"
+#include "OgreCamera.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
@@ -46,7 +48,9 @@ THE SOFTWARE.
 #include "OgreSceneManager.h"
 #include "OgreSceneManagerEnumerator.h"
 #include "OgreTechnique.h"
+#include "OgreTextureGpuManager.h"
 #include "ParticleSystem/OgreParticleSystem2.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Vao/OgreConstBufferPacked.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreIndirectBufferPacked.h"
@@ -97,13 +101,19 @@ namespace Ogre
         mLastIndexData( 0 ),
         mLastTextureHash( 0 ),
         mCommandBuffer( 0 ),
-        mRenderingStarted( 0u )
+        mRenderingStarted( 0u ),
+        mGpuCulling( 0 ),
+        mGpuCullingFirstRq( 0u ),
+        mGpuCullingLastRq( 0u )
     {
         mCommandBuffer = new CommandBuffer();
 
         for( size_t i = 0; i < 256; ++i )
             mRenderQueues[i].mQueuedRenderablesPerThread.resize( sceneManager->getNumWorkerThreads() );
 
+        mSortTask.renderQueue = this;
+        mThreadSortScratch.resize( sceneManager->getNumWorkerThreads() );
+
         // Set some defaults:
         // RQs [0; 100)   and [200; 225) are for v2 objects
         // RQs [100; 200) and [225; 256) are for v1 objects
@@ -379,12 +389,19 @@ namespace Ogre
 
         mCommandBuffer->setCurrentRenderSystem( rs );
 
+        // Must happen before mParallelHlmsCompileQueue.start() takes over the worker threads
+        sortPerThreadQueues( firstRq, lastRq );
+
+        // Shadow casters are seen from the light, not the camera
+        if( !casterPass && rs->getTextureGpuManager()->getPriorityStreaming() )
+            notifyTexturesUsed( firstRq, lastRq );
+
         ParallelHlmsCompileQueue *parallelCompileQueue = 0;
 
         if( rs->supportsMultithreadedShaderCompilation() && mSceneManager->getNumWorkerThreads() > 1u )
         {
             parallelCompileQueue = &mParallelHlmsCompileQueue;
-            mParallelHlmsCompileQueue.start( mSceneManager );
+            mParallelHlmsCompileQueue.start( mSceneManager, mHlmsManager );
         }
 
         bool supportsIndirectBuffers = mVaoManager->supportsIndirectBuffers();
@@ -410,6 +427,20 @@ namespace Ogre
             startIndirectDraw = indirectDraw;
         }
 
+        bool gpuCullingActive = false;
+        if( numNeededV2Draws > 0u && mGpuCulling && !casterPass )
+        {
+            for( size_t i = firstRq; i < lastRq && !gpuCullingActive; ++i )
+                gpuCullingActive = isGpuCulled( static_cast<uint8>( i ), casterPass );
+
+            if( gpuCullingActive )
+            {
+                // Must happen before recording, as the draw commands hold the indirect buffer
+                mGpuCulling->reserveDraws( numNeededV2Draws );
+                mGpuCulling->clearDraws();
+            }
+        }
+
         for( size_t i = firstRq; i < lastRq; ++i )
         {
             QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
@@ -420,44 +451,32 @@ namespace Ogre
             {
                 OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
 
-                size_t numRenderables = 0;
-                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
-                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
-
-                while( itor != endt )
+                if( mRenderQueues[i].mSortMode == DisableSort )
                 {
-                    numRenderables += itor->q.size();
-                    ++itor;
-                }
+                    size_t numRenderables = 0;
+                    QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
+                    QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
 
-                queuedRenderables.reserve( numRenderables );
+                    while( itor != endt )
+                    {
+                        numRenderables += itor->q.size();
+                        ++itor;
+                    }
 
-                itor = perThreadQueue.begin();
-                while( itor != endt )
-                {
-                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
-                    ++itor;
-                }
+                    queuedRenderables.reserve( numRenderables );
 
-                // TODO: Exploit temporal coherence across frames then use insertion sorts.
-                // As explained by L. Spiro in
-                // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
-                // Keep a list of sorted indices from the previous frame (one per camera).
-                // If we have the sorted list "5, 1, 4, 3, 2, 0":
-                //  * If it grew from last frame, append: 5, 1, 4, 3, 2, 0, 6, 7 and use insertion sort.
-                //  * If it's the same, leave it as is, and use insertion sort just in case.
-                //  * If it's shorter, reset the indices 0, 1, 2, 3, 4; probably use quicksort or other
-                //  generic sort
-                //
-                // TODO2: Explore sorting first on multiple threads, then merge sort into one.
-                if( mRenderQueues[i].mSortMode == NormalSort )
-                {
-                    std::sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
+                    itor = perThreadQueue.begin();
+                    while( itor != endt )
+                    {
+                        queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
+                        ++itor;
+                    }
                 }
-                else if( mRenderQueues[i].mSortMode == StableSort )
+                else
                 {
-                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
+                    // Each per-thread queue was already sorted by sortPerThreadQueues.
+                    // The merge is stable, thus NormalSort and StableSort share the same path.
+                    mergeSortedThreadQueues( mRenderQueues[i], mMergeHeads );
                     mRenderQueues[i].mSorted = true;
                 }
             }
@@ -490,15 +509,27 @@ namespace Ogre
             }
             else if( numNeededV2Draws > 0 /*&& mRenderQueues[i].mMode == FAST*/ )
             {
-                indirectDraw =
-                    renderGL3( rs, casterPass, dualParaboloid, mPassCache, mRenderQueues[i],
-                               parallelCompileQueue, indirectBuffer, indirectDraw, startIndirectDraw );
+                GpuCulling *gpuCulling =
+                    isGpuCulled( static_cast<uint8>( i ), casterPass ) ? mGpuCulling : 0;
+                indirectDraw = renderGL3( rs, casterPass, dualParaboloid, mPassCache, mRenderQueues[i],
+                                          parallelCompileQueue, indirectBuffer, indirectDraw,
+                                          startIndirectDraw, gpuCulling );
             }
         }
 
         if( supportsIndirectBuffers && indirectBuffer )
             indirectBuffer->unmap( UO_KEEP_PERSISTENT );
 
+        if( gpuCullingActive && mGpuCulling->getNumDraws() > 0u )
+        {
+            // This interrupts the render pass (if the API has such concept), which the
+            // RenderSystem resumes when the command buffer sets the first PSO.
+            // Objects in the queue already passed the visibility flags test on the CPU
+            mGpuCulling->upload();
+            mGpuCulling->cull( mSceneManager->getCamerasInProgress().cullingCamera,
+                               mGpuCulling->getHiZTexture(), VisibilityFlags::LAYER_VISIBILITY );
+        }
+
         if( parallelCompileQueue )
             mParallelHlmsCompileQueue.stopAndWait( mSceneManager );
 
@@ -529,6 +560,222 @@ namespace Ogre
         OgreProfileEndGroup( "Command Execution", OGREPROF_RENDERING );
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::setGpuCulling( GpuCulling *gpuCulling, uint8 firstRq, uint8 lastRq )
+    {
+        mGpuCulling = gpuCulling;
+        mGpuCullingFirstRq = firstRq;
+        mGpuCullingLastRq = lastRq;
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::isGpuCulled( uint8 rqId, bool casterPass ) const
+    {
+        return mGpuCulling && !casterPass && rqId >= mGpuCullingFirstRq && rqId < mGpuCullingLastRq &&
+               mRenderQueues[rqId].mMode == FAST && mVaoManager->supportsIndirectBuffers() &&
+               !mSceneManager->isUsingInstancedStereo();
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::notifyTexturesUsed( uint8 firstRq, uint8 lastRq )
+    {
+        OgreProfileExhaustive( "RenderQueue::notifyTexturesUsed" );
+
+        const Camera *camera = mSceneManager->getCamerasInProgress().lodCamera;
+        const Vector3 cameraPos = camera->_getCachedDerivedPosition();
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            for( const ThreadRenderQueue &threadRenderQueue :
+                 mRenderQueues[i].mQueuedRenderablesPerThread )
+            {
+                for( const QueuedRenderable &queuedRenderable : threadRenderQueue.q )
+                {
+                    // Divide by the radius to account for the size on screen
+                    const MovableObject *movableObject = queuedRenderable.movableObject;
+                    const Real radius = std::max( movableObject->getWorldRadius(), Real( 1e-6 ) );
+                    const Real distance =
+                        cameraPos.distance( movableObject->getWorldAabb().mCenter ) / radius;
+                    HlmsDatablock *datablock = queuedRenderable.renderable->getDatablock();
+                    if( datablock )
+                        datablock->notifyTexturesUsed( static_cast<float>( distance ) );
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::SortTask::execute( size_t threadId, size_t /*numThreads*/ )
+    {
+        ThreadSortScratch &scratch = renderQueue->mThreadSortScratch[threadId];
+
+        FastArray<uint8>::const_iterator itor = renderQueue->mPendingSortRqs.begin();
+        FastArray<uint8>::const_iterator endt = renderQueue->mPendingSortRqs.end();
+
+        while( itor != endt )
+        {
+            RenderQueueGroup &renderQueueGroup = renderQueue->mRenderQueues[*itor];
+            sortThreadQueue( renderQueueGroup.mQueuedRenderablesPerThread[threadId], scratch,
+                             renderQueueGroup.mReuseSortOrder );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::sortPerThreadQueues( uint8 firstRq, uint8 lastRq )
+    {
+        mPendingSortRqs.clear();
+
+        size_t numRenderables = 0u;
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            const RenderQueueGroup &renderQueueGroup = mRenderQueues[i];
+            if( renderQueueGroup.mSorted || renderQueueGroup.mSortMode == DisableSort )
+                continue;
+
+            size_t numInRq = 0u;
+            for( const ThreadRenderQueue &threadRenderQueue :
+                 renderQueueGroup.mQueuedRenderablesPerThread )
+            {
+                numInRq += threadRenderQueue.q.size();
+            }
+
+            if( numInRq > 0u )
+            {
+                mPendingSortRqs.push_back( static_cast<uint8>( i ) );
+                numRenderables += numInRq;
+            }
+        }
+
+        if( mPendingSortRqs.empty() )
+            return;
+
+        OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
+
+        // Waking up the worker threads isn't free. Don't bother for small queues
+        const size_t numThreads = mThreadSortScratch.size();
+        if( numThreads > 1u && numRenderables >= 2048u )
+        {
+            mSceneManager->executeUserScalableTask( &mSortTask, true );
+        }
+        else
+        {
+            for( size_t i = 0u; i < numThreads; ++i )
+                mSortTask.execute( i, numThreads );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::sortThreadQueue( ThreadRenderQueue &threadQueue, ThreadSortScratch &scratch,
+                                       bool reuseSortOrder )
+    {
+        QueuedRenderableArray &queuedRenderables = threadQueue.q;
+        FastArray<uint32> &lastOrder = threadQueue.lastOrder;
+        const size_t numRenderables = queuedRenderables.size();
+
+        SortKeyVec &keys = scratch.keys;
+        keys.resize( numRenderables );
+
+        bool sorted = false;
+
+        if( reuseSortOrder && lastOrder.size() == numRenderables )
+        {
+            for( size_t i = 0u; i < numRenderables; ++i )
+            {
+                keys[i].hash = queuedRenderables[lastOrder[i]].hash;
+                keys[i].idx = lastOrder[i];
+            }
+
+            // Insertion sort starting from last order. Ties are resolved by idx so that the
+            // result is the same as with the radix sort (which is stable).
+            // Give up once we've moved more elements than there are.
+            size_t budget = numRenderables;
+            sorted = true;
+            for( size_t i = 1u; i < numRenderables && sorted; ++i )
+            {
+                const SortKey key = keys[i];
+                size_t j = i;
+                while( j > 0u && ( keys[j - 1u].hash > key.hash ||
+                                   ( keys[j - 1u].hash == key.hash && keys[j - 1u].idx > key.idx ) ) )
+                {
+                    if( budget == 0u )
+                    {
+                        sorted = false;
+                        break;
+                    }
+                    --budget;
+                    keys[j] = keys[j - 1u];
+                    --j;
+                }
+                keys[j] = key;
+            }
+        }
+
+        if( !sorted )
+        {
+            for( size_t i = 0u; i < numRenderables; ++i )
+            {
+                keys[i].hash = queuedRenderables[i].hash;
+                keys[i].idx = static_cast<uint32>( i );
+            }
+            scratch.radixSort.sort( keys, SortKeyFunctor() );
+        }
+
+        QueuedRenderableArray &tmp = scratch.tmp;
+        tmp.resizePOD( numRenderables );
+        lastOrder.resizePOD( numRenderables );
+        for( size_t i = 0u; i < numRenderables; ++i )
+        {
+            tmp[i] = queuedRenderables[keys[i].idx];
+            lastOrder[i] = keys[i].idx;
+        }
+        queuedRenderables.swap( tmp );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::mergeSortedThreadQueues( RenderQueueGroup &renderQueueGroup,
+                                               FastArray<MergeHead> &mergeHeads )
+    {
+        QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const QueuedRenderableArrayPerThread &perThreadQueue =
+            renderQueueGroup.mQueuedRenderablesPerThread;
+
+        size_t numRenderables = 0u;
+        mergeHeads.clear();
+        for( size_t i = 0u; i < perThreadQueue.size(); ++i )
+        {
+            const QueuedRenderableArray &q = perThreadQueue[i].q;
+            if( !q.empty() )
+            {
+                const MergeHead mergeHead = { q.begin(), q.end(), i };
+                mergeHeads.push_back( mergeHead );
+                numRenderables += q.size();
+            }
+        }
+
+        queuedRenderables.reserve( queuedRenderables.size() + numRenderables );
+
+        if( mergeHeads.size() == 1u )
+        {
+            queuedRenderables.appendPOD( mergeHeads[0].itor, mergeHeads[0].end );
+            return;
+        }
+
+        // Min-heap of the heads. Ties go to the lowest thread so the merge is stable
+        auto greaterThan = []( const MergeHead &a, const MergeHead &b )
+        {
+            return a.itor->hash > b.itor->hash ||
+                   ( a.itor->hash == b.itor->hash && a.threadIdx > b.threadIdx );
+        };
+
+        std::make_heap( mergeHeads.begin(), mergeHeads.end(), greaterThan );
+
+        while( !mergeHeads.empty() )
+        {
+            std::pop_heap( mergeHeads.begin(), mergeHeads.end(), greaterThan );
+            MergeHead &mergeHead = mergeHeads.back();
+            queuedRenderables.push_back( *mergeHead.itor );
+            ++mergeHead.itor;
+            if( mergeHead.itor == mergeHead.end )
+                mergeHeads.pop_back();
+            else
+                std::push_heap( mergeHeads.begin(), mergeHeads.end(), greaterThan );
+        }
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::warmUpShadersCollect( const uint8 firstRq, const uint8 lastRq,
                                             const bool casterPass )
     {
@@ -591,6 +838,33 @@ namespace Ogre
         OgreProfileEndGroup( "RenderQueue::warmUpShadersTrigger", OGREPROF_RENDERING );
     }
     //-----------------------------------------------------------------------
+    bool RenderQueue::warmUpRecordedPso( Hlms *hlms, const HlmsCache &passCache,
+                                         uint32 renderableHash, const HlmsPso &recordedPso )
+    {
+        const size_t numWorkerThreads = mSceneManager->getNumWorkerThreads();
+        if( mRoot->getRenderSystem()->supportsMultithreadedShaderCompilation() &&
+            numWorkerThreads > 1u )
+        {
+            hlms->_setNumThreads( numWorkerThreads );
+        }
+
+        // Recorded PSOs tend to share a handful of passes. Don't duplicate them
+        size_t passCacheIdx = 0u;
+        const size_t numPendingPassCaches = mPendingPassCaches.size();
+        while( passCacheIdx < numPendingPassCaches &&
+               ( mPendingPassCaches[passCacheIdx].hash != passCache.hash ||
+                 mPendingPassCaches[passCacheIdx].type != passCache.type ) )
+        {
+            ++passCacheIdx;
+        }
+
+        if( passCacheIdx == numPendingPassCaches )
+            mPendingPassCaches.push_back( passCache );
+
+        return hlms->_warmUpRecordedPso( mPendingPassCaches[passCacheIdx], passCacheIdx,
+                                         renderableHash, recordedPso, mParallelHlmsCompileQueue );
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::renderES2( RenderSystem *rs, bool casterPass, bool dualParaboloid,
                                  HlmsCache passCache[HLMS_MAX],
                                  const RenderQueueGroup &renderQueueGroup )
@@ -837,10 +1111,12 @@ namespace Ogre
                                            ParallelHlmsCompileQueue *parallelCompileQueue,
                                            IndirectBufferPacked *indirectBuffer,
                                            unsigned char *indirectDraw,
-                                           unsigned char *startIndirectDraw )
+                                           unsigned char *startIndirectDraw,
+                                           GpuCulling *gpuCulling )
     {
         VertexArrayObject *lastVao = 0;
         uint32 lastVaoName = mLastVaoName;
+        IndirectBufferPacked *lastIndirectBuffer = indirectBuffer;
         HlmsCache const *lastHlmsCache = &c_dummyCache;
         uint32 lastHlmsCacheHash = 0;
 
@@ -894,7 +1170,17 @@ namespace Ogre
             uint32 baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
                                                           lastHlmsCacheHash, mCommandBuffer );
 
-            if( drawCmd != mCommandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() )
+            // Objects are tracked the first time they're drawn, and stay
+            // resident in the GpuCulling until they're destroyed
+            uint32 cullSlot = GpuCulling::InvalidSlot;
+            if( gpuCulling && vao->getIndexBuffer() )
+                cullSlot = gpuCulling->trackObject( queuedRenderable.movableObject );
+
+            IndirectBufferPacked *drawIndirectBuffer =
+                cullSlot != GpuCulling::InvalidSlot ? gpuCulling->getIndirectBuffer() : indirectBuffer;
+
+            if( drawCmd != mCommandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() ||
+                lastIndirectBuffer != drawIndirectBuffer )
             {
                 // Different mesh, vertex buffers or layout. Make a new draw call.
                 //(or also the the Hlms made a batch-breaking command)
@@ -903,16 +1189,23 @@ namespace Ogre
                                     "Invalid Vao name! This can happen if a BT_IMMUTABLE buffer was "
                                     "recently created and VaoManager::_beginFrame() wasn't called" );
 
-                if( lastVaoName != vao->getVaoName() )
+                if( lastVaoName != vao->getVaoName() || lastIndirectBuffer != drawIndirectBuffer )
                 {
-                    *mCommandBuffer->addCommand<CbVao>() = CbVao( vao );
-                    *mCommandBuffer->addCommand<CbIndirectBuffer>() = CbIndirectBuffer( indirectBuffer );
+                    if( lastVaoName != vao->getVaoName() )
+                        *mCommandBuffer->addCommand<CbVao>() = CbVao( vao );
+                    *mCommandBuffer->addCommand<CbIndirectBuffer>() =
+                        CbIndirectBuffer( drawIndirectBuffer );
                     lastVaoName = vao->getVaoName();
+                    lastIndirectBuffer = drawIndirectBuffer;
                 }
 
+                const size_t drawOffset =
+                    cullSlot != GpuCulling::InvalidSlot
+                        ? gpuCulling->getNumDraws() * sizeof( CbDrawIndexed )
+                        : static_cast<size_t>( indirectDraw - startIndirectDraw );
+
                 void *offset = reinterpret_cast<void *>(
-                    static_cast<ptrdiff_t>( indirectBuffer->_getFinalBufferStart() ) +
-                    ( indirectDraw - startIndirectDraw ) );
+                    static_cast<ptrdiff_t>( drawIndirectBuffer->_getFinalBufferStart() + drawOffset ) );
 
                 if( vao->getIndexBuffer() )
                 {
@@ -931,12 +1224,28 @@ namespace Ogre
                 stats.mDrawCount += 1u;
             }
 
-            if( lastVao != vao )
+            if( lastVao != vao || cullSlot != GpuCulling::InvalidSlot )
             {
                 // Different mesh, but same vertex buffers & layouts. Advance indirection buffer.
                 ++drawCmd->numDraws;
 
-                if( vao->mIndexBuffer )
+                if( cullSlot != GpuCulling::InvalidSlot )
+                {
+                    // Each object is culled on its own, thus it can't be instanced together
+                    // with the previous one. The GpuCulling writes the final args.
+                    CbDrawIndexed drawArgs;
+                    drawArgs.primCount = vao->mPrimCount;
+                    drawArgs.instanceCount = instancesPerDraw;
+                    drawArgs.firstVertexIndex =
+                        uint32( vao->mIndexBuffer->_getFinalBufferStart() + vao->mPrimStart );
+                    drawArgs.baseVertex = uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() );
+                    drawArgs.baseInstance = baseInstance << baseInstanceShift;
+                    gpuCulling->addDraw( cullSlot, drawArgs );
+
+                    drawCountPtr = 0;
+                    instanceCount = instancesPerDraw;
+                }
+                else if( vao->mIndexBuffer )
                 {
                     CbDrawIndexed *drawIndexedPtr = reinterpret_cast<CbDrawIndexed *>( indirectDraw );
                     indirectDraw += sizeof( CbDrawIndexed );
@@ -999,6 +1308,10 @@ namespace Ogre
 
         rs->_addMetrics( stats );
 
+        // The next queue assumes our indirect buffer is bound unless the Vao changes
+        if( lastIndirectBuffer != indirectBuffer )
+            lastVaoName = 0;
+
         mLastVaoName = lastVaoName;
         mLastVertexData = 0;
         mLastIndexData = 0;
@@ -1188,20 +1501,102 @@ namespace Ogre
         mParallelHlmsCompileQueue.updateThread( threadIdx, mHlmsManager );
     }
     //-----------------------------------------------------------------------
-    void ParallelHlmsCompileQueue::start( SceneManager *sceneManager )
+    void ParallelHlmsCompileQueue::CompileTask::execute( size_t threadId, size_t numThreads )
+    {
+        queue->updateTask( this );
+    }
+    //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::start( SceneManager *sceneManager, HlmsManager *hlmsManager )
     {
         mKeepCompiling = true;
-        sceneManager->_fireParallelHlmsCompile();
+
+        mTaskScheduler = sceneManager->getTaskScheduler();
+        if( !mTaskScheduler )
+        {
+            sceneManager->_fireParallelHlmsCompile();
+            return;
+        }
+
+        mHlmsManager = hlmsManager;
+
+        const size_t numTasks = sceneManager->getNumWorkerThreads();
+        mCompileTasks.resize( numTasks );
+        mIdleCompileTasks.clear();
+        for( size_t i = numTasks; i--; )
+        {
+            mCompileTasks[i].queue = this;
+            mCompileTasks[i].tid = i;
+            mIdleCompileTasks.push_back( i );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::pushRequest( const Request &&request )
+    {
+        size_t compileTaskIdx = std::numeric_limits<size_t>::max();
+        {
+            ScopedLock lock( mMutex );
+            mRequests.emplace_back( request );
+            if( !mTaskScheduler )
+            {
+                mSemaphore.increment();
+                return;
+            }
+
+            // If every CompileTask is already scheduled, one of them will grab this request
+            // before returning. See updateTask().
+            if( !mIdleCompileTasks.empty() && mTaskScheduler->canAddTask() )
+            {
+                compileTaskIdx = mIdleCompileTasks.back();
+                mIdleCompileTasks.pop_back();
+            }
+        }
+
+        if( compileTaskIdx != std::numeric_limits<size_t>::max() )
+        {
+            mScheduledTasks.push_back(
+                mTaskScheduler->addTask( &mCompileTasks[compileTaskIdx], 1u ) );
+        }
     }
     //-----------------------------------------------------------------------
     void ParallelHlmsCompileQueue::stopAndWait( SceneManager *sceneManager )
     {
-        // There is no need to incur in the perf penalty of locking mMutex because we guarantee
-        // no more entries will be added to mRequests. (Unless I missed something?).
-        // The mMutex locks (and mSemaphore) already guarantee ordering.
-        mKeepCompiling.store( false, std::memory_order::memory_order_relaxed );
-        mSemaphore.increment( static_cast<uint32_t>( sceneManager->getNumWorkerThreads() ) );
-        sceneManager->waitForParallelHlmsCompile();
+        if( mTaskScheduler )
+        {
+            mKeepCompiling.store( false, std::memory_order::memory_order_relaxed );
+
+            std::vector<uint32>::const_iterator itor = mScheduledTasks.begin();
+            std::vector<uint32>::const_iterator endt = mScheduledTasks.end();
+            while( itor != endt )
+                mTaskScheduler->waitFor( *itor++ );
+            mScheduledTasks.clear();
+            mTaskScheduler = 0;
+
+            // Requests pushed while the TaskScheduler was full and no CompileTask was running.
+            // Every CompileTask is done, thus any tid is free.
+            if( !mExceptionFound )
+            {
+                std::vector<Request> requests;
+                requests.swap( mRequests );
+                for( const Request &request : requests )
+                {
+                    const HlmsDatablock *datablock =
+                        request.queuedRenderable.renderable->getDatablock();
+                    Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+                    hlms->compileStubEntry( *request.passCache, request.reservedStubEntry,
+                                            request.queuedRenderable, request.renderableHash,
+                                            request.finalHash, 0u );
+                }
+            }
+        }
+        else
+        {
+            // There is no need to incur in the perf penalty of locking mMutex because we guarantee
+            // no more entries will be added to mRequests. (Unless I missed something?).
+            // The mMutex locks (and mSemaphore) already guarantee ordering.
+            mKeepCompiling.store( false, std::memory_order::memory_order_relaxed );
+            mSemaphore.increment( static_cast<uint32_t>( sceneManager->getNumWorkerThreads() ) );
+            sceneManager->waitForParallelHlmsCompile();
+        }
 
         // No need to use mMutex because we guarantee no write access from other threads
         // after this point.
@@ -1233,6 +1628,27 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::compileWarmUpRequest( const Request &request,
+                                                         HlmsManager *hlmsManager,
+                                                         const HlmsCache *passCaches, size_t tid )
+    {
+        const HlmsCache &passCache = passCaches[reinterpret_cast<size_t>( request.passCache )];
+        if( request.recordedPso )
+        {
+            Hlms *hlms = hlmsManager->getHlms(
+                static_cast<HlmsTypes>( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( request.finalHash ) ) );
+            hlms->_compileRecordedPso( passCache, request.reservedStubEntry, request.renderableHash,
+                                       request.finalHash, *request.recordedPso, tid );
+        }
+        else
+        {
+            const HlmsDatablock *datablock = request.queuedRenderable.renderable->getDatablock();
+            Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+            hlms->compileStubEntry( passCache, request.reservedStubEntry, request.queuedRenderable,
+                                    request.renderableHash, request.finalHash, tid );
+        }
+    }
+    //-----------------------------------------------------------------------
     void ParallelHlmsCompileQueue::updateWarmUpThread( size_t threadIdx, HlmsManager *hlmsManager,
                                                        const HlmsCache *passCaches )
     {
@@ -1253,13 +1669,9 @@ namespace Ogre
             mRequests.pop_back();
             mMutex.unlock();
 
-            const HlmsDatablock *datablock = request.queuedRenderable.renderable->getDatablock();
-            Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
             try
             {
-                hlms->compileStubEntry( passCaches[reinterpret_cast<size_t>( request.passCache )],
-                                        request.reservedStubEntry, request.queuedRenderable,
-                                        request.renderableHash, request.finalHash, threadIdx );
+                compileWarmUpRequest( request, hlmsManager, passCaches, threadIdx );
             }
             catch( Exception & )
             {
@@ -1278,13 +1690,7 @@ namespace Ogre
     void ParallelHlmsCompileQueue::warmUpSerial( HlmsManager *hlmsManager, const HlmsCache *passCaches )
     {
         for( const Request &request : mRequests )
-        {
-            const HlmsDatablock *datablock = request.queuedRenderable.renderable->getDatablock();
-            Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
-            hlms->compileStubEntry( passCaches[reinterpret_cast<size_t>( request.passCache )],
-                                    request.reservedStubEntry, request.queuedRenderable,
-                                    request.renderableHash, request.finalHash, 0u );
-        }
+            compileWarmUpRequest( request, hlmsManager, passCaches, 0u );
 
         mRequests.clear();
     }
@@ -1373,6 +1779,51 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::updateTask( CompileTask *compileTask )
+    {
+        const size_t tid = compileTask->tid;
+#ifdef OGRE_SHADER_THREADING_BACKWARDS_COMPATIBLE_API
+#    ifdef OGRE_SHADER_THREADING_USE_TLS
+        Hlms::msThreadId = static_cast<uint32>( tid );
+#    endif
+#endif
+        while( true )
+        {
+            mMutex.lock();
+            if( mRequests.empty() )
+            {
+                // Must happen inside mMutex, so that pushRequest either sees us idle and
+                // schedules us again, or pushes its request while we can still see it.
+                mIdleCompileTasks.push_back( tid );
+                mMutex.unlock();
+                break;
+            }
+            Request request = std::move( mRequests.back() );
+            mRequests.pop_back();
+            mMutex.unlock();
+
+            const HlmsDatablock *datablock = request.queuedRenderable.renderable->getDatablock();
+            Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+            try
+            {
+                hlms->compileStubEntry( *request.passCache, request.reservedStubEntry,
+                                        request.queuedRenderable, request.renderableHash,
+                                        request.finalHash, tid );
+            }
+            catch( Exception & )
+            {
+                ScopedLock lock( mMutex );
+                // We can only report one exception.
+                if( !mExceptionFound )
+                {
+                    mRequests.clear();  // Only way to signal other tasks to stop early.
+                    mExceptionFound = true;
+                    mThreadedException = std::current_exception();
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::renderSingleObject( Renderable *pRend, const MovableObject *pMovableObject,
                                           RenderSystem *rs, bool casterPass, bool dualParaboloid )
     {
@@ -1465,11 +1916,124 @@ namespace Ogre
         return mRenderQueues[rqId].mSortMode;
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::setReuseSortOrder( uint8 rqId, bool bReuse )
+    {
+        mRenderQueues[rqId].mReuseSortOrder = bReuse;
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueue::getReuseSortOrder( uint8 rqId ) const
+    {
+        return mRenderQueues[rqId].mReuseSortOrder;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_recordSnapshot( RenderQueueSnapshot &snapshot, uint8 firstRq,
+                                       uint8 lastRq ) const
+    {
+        snapshot.mNumEntries = 0u;
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            const RenderQueueGroup &renderQueueGroup = mRenderQueues[i];
+            if( renderQueueGroup.mMode != FAST || renderQueueGroup.mQueuedRenderables.empty() )
+                continue;
+
+            // Keep the previous entries around to reuse their memory
+            if( snapshot.mNumEntries == snapshot.mEntries.size() )
+                snapshot.mEntries.push_back( RenderQueueSnapshot::Entry() );
+
+            RenderQueueSnapshot::Entry &entry = snapshot.mEntries[snapshot.mNumEntries++];
+            entry.rqId = static_cast<uint8>( i );
+            entry.queuedRenderables.clear();
+            entry.queuedRenderables.appendPOD( renderQueueGroup.mQueuedRenderables.begin(),
+                                               renderQueueGroup.mQueuedRenderables.end() );
+        }
+
+        snapshot._notifyRecorded();
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_restoreSnapshot( const RenderQueueSnapshot &snapshot )
+    {
+        for( size_t i = 0u; i < snapshot.mNumEntries; ++i )
+        {
+            const RenderQueueSnapshot::Entry &entry = snapshot.mEntries[i];
+            RenderQueueGroup &renderQueueGroup = mRenderQueues[entry.rqId];
+
+            if( renderQueueGroup.mMode != FAST )
+                continue;
+
+            // render() counts the draws it needs from the per-thread queues,
+            // the actual drawing is done from the sorted mQueuedRenderables
+            ThreadRenderQueue &threadRenderQueue = renderQueueGroup.mQueuedRenderablesPerThread[0];
+            threadRenderQueue.q.appendPOD( entry.queuedRenderables.begin(),
+                                           entry.queuedRenderables.end() );
+            renderQueueGroup.mQueuedRenderables.appendPOD( entry.queuedRenderables.begin(),
+                                                           entry.queuedRenderables.end() );
+            renderQueueGroup.mSorted = true;
+        }
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    RenderQueueSnapshot::Key::Key() :
+        viewMatrix( Matrix4::ZERO ),
+        projectionMatrix( Matrix4::ZERO ),
+        lodViewMatrix( Matrix4::ZERO ),
+        changeKey( 0u ),
+        visibilityMask( 0u ),
+        firstRq( 0u ),
+        lastRq( 0u ),
+        casterPass( false ),
+        reflected( false )
+    {
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueueSnapshot::Key::operator==( const Key &other ) const
+    {
+        return changeKey == other.changeKey && visibilityMask == other.visibilityMask &&
+               firstRq == other.firstRq && lastRq == other.lastRq &&
+               casterPass == other.casterPass && reflected == other.reflected &&
+               viewMatrix == other.viewMatrix && projectionMatrix == other.projectionMatrix &&
+               lodViewMatrix == other.lodViewMatrix;
+    }
+    //-----------------------------------------------------------------------
+    RenderQueueSnapshot::RenderQueueSnapshot() :
+        mNumEntries( 0u ),
+        mValid( false ),
+        mPendingRecord( false )
+    {
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueueSnapshot::invalidate()
+    {
+        mValid = false;
+        mPendingRecord = false;
+    }
+    //-----------------------------------------------------------------------
+    bool RenderQueueSnapshot::_prepareReplay( const Key &key )
+    {
+        if( mValid && mKey == key )
+            return true;
+
+        // Can't replay. The pass must cull as usual and record the result
+        mValid = false;
+        mPendingRecord = true;
+        mKey = key;
+        return false;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueueSnapshot::_notifyRecorded()
+    {
+        mValid = true;
+        mPendingRecord = false;
+    }
+    //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     ParallelHlmsCompileQueue::ParallelHlmsCompileQueue() :
         mSemaphore( 0u ),
         mKeepCompiling( false ),
+        mTaskScheduler( 0 ),
+        mHlmsManager( 0 ),
         mExceptionFound( false )
     {
     }
@@ -120,6 +120,17 @@ namespace Ogre
         file << "\t" << "gl1_5_nohwocclusion " << StringConverter::toString(caps->hasCapability(RSC_GL1_5_NOHWOCCLUSION)) << endl;
         file << "\t" << "perstageconstant " << StringConverter::toString(caps->hasCapability(RSC_PERSTAGECONSTANT)) << endl;
         file << "\t" << "vao " << StringConverter::toString(caps->hasCapability(RSC_VAO)) << endl;
+        file << "\t" << "texture_2d_array " << StringConverter::toString(caps->hasCapability(RSC_TEXTURE_2D_ARRAY)) << endl;
+        file << "\t" << "texture_cube_map_array " << StringConverter::toString(caps->hasCapability(RSC_TEXTURE_CUBE_MAP_ARRAY)) << endl;
+        file << "\t" << "texture_gather " << StringConverter::toString(caps->hasCapability(RSC_TEXTURE_GATHER)) << endl;
+        file << "\t" << "hw_gamma " << StringConverter::toString(caps->hasCapability(RSC_HW_GAMMA)) << endl;
+        file << "\t" << "uav " << StringConverter::toString(caps->hasCapability(RSC_UAV)) << endl;
+        file << "\t" << "typed_uav_loads " << StringConverter::toString(caps->hasCapability(RSC_TYPED_UAV_LOADS)) << endl;
+        file << "\t" << "explicit_api " << StringConverter::toString(caps->hasCapability(RSC_EXPLICIT_API)) << endl;
+        file << "\t" << "separate_samplers_from_textures " << StringConverter::toString(caps->hasCapability(RSC_SEPARATE_SAMPLERS_FROM_TEXTURES)) << endl;
+        file << "\t" << "const_buffer_slots_in_shader " << StringConverter::toString(caps->hasCapability(RSC_CONST_BUFFER_SLOTS_IN_SHADER)) << endl;
+        file << "\t" << "shader_float16 " << StringConverter::toString(caps->hasCapability(RSC_SHADER_FLOAT16)) << endl;
+        file << "\t" << "shader_relaxed_float " << StringConverter::toString(caps->hasCapability(RSC_SHADER_RELAXED_FLOAT)) << endl;
         file << endl;
 
         RenderSystemCapabilities::ShaderProfiles profiles = caps->getSupportedShaderProfiles();
@@ -430,6 +441,7 @@ namespace Ogre
         addKeywordType("cubemapping", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("hwstencil", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("vbo", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("32bit_index", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("vertex_program", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("geometry_program", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("fragment_program", SET_CAPABILITY_ENUM_BOOL);
@@ -472,6 +484,17 @@ namespace Ogre
         addKeywordType("perstageconstant", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("vao", SET_CAPABILITY_ENUM_BOOL);
         addKeywordType("separate_shader_objects", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("texture_2d_array", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("texture_cube_map_array", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("texture_gather", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("hw_gamma", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("uav", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("typed_uav_loads", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("explicit_api", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("separate_samplers_from_textures", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("const_buffer_slots_in_shader", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("shader_float16", SET_CAPABILITY_ENUM_BOOL);
+        addKeywordType("shader_relaxed_float", SET_CAPABILITY_ENUM_BOOL);
 
         addCapabilitiesMapping("fixed_function", RSC_FIXED_FUNCTION);
         addCapabilitiesMapping("automipmap", RSC_AUTOMIPMAP);
@@ -523,6 +546,17 @@ namespace Ogre
         addCapabilitiesMapping("gl1_5_nohwocclusion", RSC_GL1_5_NOHWOCCLUSION);
         addCapabilitiesMapping("perstageconstant", RSC_PERSTAGECONSTANT);
         addCapabilitiesMapping("vao", RSC_VAO);
+        addCapabilitiesMapping("texture_2d_array", RSC_TEXTURE_2D_ARRAY);
+        addCapabilitiesMapping("texture_cube_map_array", RSC_TEXTURE_CUBE_MAP_ARRAY);
+        addCapabilitiesMapping("texture_gather", RSC_TEXTURE_GATHER);
+        addCapabilitiesMapping("hw_gamma", RSC_HW_GAMMA);
+        addCapabilitiesMapping("uav", RSC_UAV);
+        addCapabilitiesMapping("typed_uav_loads", RSC_TYPED_UAV_LOADS);
+        addCapabilitiesMapping("explicit_api", RSC_EXPLICIT_API);
+        addCapabilitiesMapping("separate_samplers_from_textures", RSC_SEPARATE_SAMPLERS_FROM_TEXTURES);
+        addCapabilitiesMapping("const_buffer_slots_in_shader", RSC_CONST_BUFFER_SLOTS_IN_SHADER);
+        addCapabilitiesMapping("shader_float16", RSC_SHADER_FLOAT16);
+        addCapabilitiesMapping("shader_relaxed_float", RSC_SHADER_RELAXED_FLOAT);
     }
 
     void RenderSystemCapabilitiesSerializer::parseCapabilitiesLines(CapabilitiesLinesList& lines)
@@ -48,6 +48,42 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    namespace
+    {
+        int stbiReadFromDataStream( void *user, char *data, int size )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( user );
+            return static_cast<int>( stream->read( data, static_cast<size_t>( size ) ) );
+        }
+        void stbiSkipDataStream( void *user, int n )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( user );
+            stream->skip( n );
+        }
+        int stbiDataStreamEof( void *user )
+        {
+            DataStream *stream = reinterpret_cast<DataStream *>( user );
+            return stream->eof() ? 1 : 0;
+        }
+
+        /// Same format mapping as STBIImageCodec::decode
+        PixelFormatGpu stbiComponentsToFormat( int components )
+        {
+            switch( components )
+            {
+            case 1:
+                return PFG_R8_UNORM;
+            case 2:
+                return PFG_RG8_UNORM;
+            case 3:
+            case 4:
+                return PFG_RGBA8_UNORM;
+            default:
+                return PFG_UNKNOWN;
+            }
+        }
+    }  // namespace
+
     STBIImageCodec::RegisteredCodecList STBIImageCodec::msCodecList;
     //---------------------------------------------------------------------
     void STBIImageCodec::startup()
@@ -205,6 +241,98 @@ namespace Ogre
         return ret;
     }
     //---------------------------------------------------------------------
+    bool STBIImageCodec::decodeStreaming( DataStreamPtr &input, StreamingListener *listener,
+                                          uint32 maxRowsPerBatch ) const
+    {
+        stbi_io_callbacks callbacks;
+        callbacks.read = stbiReadFromDataStream;
+        callbacks.skip = stbiSkipDataStream;
+        callbacks.eof = stbiDataStreamEof;
+
+        int width, height, components;
+        stbi_uc *pixelData =
+            stbi_load_from_callbacks( &callbacks, input.get(), &width, &height, &components, 0 );
+
+        if( !pixelData )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR,
+                         "Error decoding image: " + String( stbi_failure_reason() ),
+                         "STBIImageCodec::decodeStreaming" );
+        }
+
+        const PixelFormatGpu format = stbiComponentsToFormat( components );
+        if( format == PFG_UNKNOWN )
+        {
+            stbi_image_free( pixelData );
+            OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND, "Unknown or unsupported image format",
+                         "STBIImageCodec::decodeStreaming" );
+        }
+
+        ImageData2 header;
+        header.box.width = static_cast<uint32>( width );
+        header.box.height = static_cast<uint32>( height );
+        header.box.depth = 1u;
+        header.box.numSlices = 1u;
+        header.box.bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( format );
+        header.box.bytesPerRow = static_cast<uint32>(
+            PixelFormatGpuUtils::getSizeBytes( header.box.width, 1u, 1u, 1u, format, 4u ) );
+        header.box.bytesPerImage = size_t( header.box.bytesPerRow ) * size_t( header.box.height );
+        header.textureType = TextureTypes::Type2D;
+        header.format = format;
+        header.numMipmaps = 1u;
+        header.freeOnDestruction = false;
+
+        bool retVal = listener->headerDecoded( header );
+
+        maxRowsPerBatch = std::max( maxRowsPerBatch, 1u );
+        const uint32 stbiBytesPerRow = static_cast<uint32>( width * components );
+
+        // RGB must be expanded to RGBA, everything else can be handed out as is
+        uint8 *expanded = 0;
+        if( components == 3 )
+        {
+            expanded = reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD(
+                size_t( header.box.bytesPerRow ) * maxRowsPerBatch, MEMCATEGORY_RESOURCE ) );
+        }
+
+        for( uint32 y = 0u; y < header.box.height && retVal; y += maxRowsPerBatch )
+        {
+            TextureBox rows = header.box;
+            rows.height = std::min( maxRowsPerBatch, header.box.height - y );
+
+            if( !expanded )
+            {
+                rows.bytesPerRow = stbiBytesPerRow;
+                rows.data = pixelData + size_t( y ) * stbiBytesPerRow;
+            }
+            else
+            {
+                rows.data = expanded;
+                for( uint32 rowIdx = 0u; rowIdx < rows.height; ++rowIdx )
+                {
+                    uint8 *pDst = reinterpret_cast<uint8 *>( rows.at( 0u, rowIdx, 0u ) );
+                    uint8 const *pSrc = pixelData + size_t( y + rowIdx ) * stbiBytesPerRow;
+                    for( size_t x = 0; x < (size_t)width; ++x )
+                    {
+                        *pDst++ = *pSrc++;
+                        *pDst++ = *pSrc++;
+                        *pDst++ = *pSrc++;
+                        *pDst++ = 0xFF;
+                    }
+                }
+            }
+            rows.bytesPerImage = size_t( rows.bytesPerRow ) * rows.height;
+
+            retVal = listener->rowsDecoded( rows, 0u, 0u, y );
+        }
+
+        if( expanded )
+            OGRE_FREE_SIMD( expanded, MEMCATEGORY_RESOURCE );
+        stbi_image_free( pixelData );
+
+        return retVal;
+    }
+    //---------------------------------------------------------------------
     String STBIImageCodec::getType() const { return mType; }
     //---------------------------------------------------------------------
     String STBIImageCodec::magicNumberToFileExt( const char *magicNumberPtr, size_t maxbytes ) const
@@ -34,9 +34,11 @@ THE SOFTWARE.
 #include "Animation/OgreTagPoint.h"
 #include "Compositor/OgreCompositorShadowNode.h"
 #include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
+#include "Compute/OgreGpuCulling.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "OgreAnimation.h"
 #include "OgreAtmosphereComponent.h"
+#include "OgreBatchRaySceneQuery.h"
 #include "OgreBillboardChain.h"
 #include "OgreBillboardSet.h"
 #include "OgreCamera.h"
@@ -71,6 +73,7 @@ THE SOFTWARE.
 #include "OgreRibbonTrail.h"
 #include "OgreRoot.h"
 #include "OgreSceneNode.h"
+#include "OgreSceneQueryBvh.h"
 #include "OgreSubEntity.h"
 #include "OgreTechnique.h"
 #include "OgreTextureGpuManager.h"
@@ -79,6 +82,7 @@ THE SOFTWARE.
 #include "ParticleSystem/OgreParticleSystem2.h"
 #include "ParticleSystem/OgreParticleSystemManager2.h"
 #include "Threading/OgreBarrier.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Threading/OgreUniformScalableTask.h"
 
 // This class implements the most basic scene manager
@@ -174,6 +178,16 @@ namespace Ogre
         mUserTask( 0 ),
         mRequestType( NUM_REQUESTS ),
         mWorkerThreadsBarrier( 0 ),
+        mTaskScheduler( 0 ),
+        mPendingWorkerTask( 0u ),
+        mNumChunkedTasks( 0u ),
+        mLastChunkedTask( 0u ),
+        mTaskChunkSize( 512u ),
+        mChainChunkedTasks( false ),
+        mCullTask( 0 ),
+        mCullVisibilityMask( 0u ),
+        mIncrementalTransformUpdates( false ),
+        mRenderQueueSnapshot( 0 ),
         mSuppressRenderStateChanges( false ),
         mLastLightHash( 0 ),
         mLastLightLimit( 0 ),
@@ -181,7 +195,10 @@ namespace Ogre
         mGpuParamsDirty( (uint16)GPV_ALL )
     {
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
             mSceneRoot[i] = 0;
+            mSceneQueryBvh[i] = 0;
+        }
         mSceneDummy = 0;
 
         memset( mAmbientSphericalHarmonics, 0, sizeof( mAmbientSphericalHarmonics ) );
@@ -214,7 +231,10 @@ namespace Ogre
         mBuildLightListRequestPerThread.resize( mNumWorkerThreads );
         mVisibleObjects.resize( mNumWorkerThreads );
         mTmpVisibleObjects.resize( mNumWorkerThreads );
+        mChangedBoundsPerThread.resize( mNumWorkerThreads );
+        mChangedGpuCulledPerThread.resize( mNumWorkerThreads );
 
+        mWorkerThreadsTask.sceneManager = this;
         startWorkerThreads();
 
         // Init shadow caster material for texture shadows
@@ -286,6 +306,8 @@ namespace Ogre
         OGRE_DELETE mRadialDensityMask;
         mRadialDensityMask = 0;
 
+        setSceneQueryBvhEnabled( false );
+
         fireSceneManagerDestroyed();
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
@@ -322,6 +344,12 @@ namespace Ogre
         delete mParticleSystemManager2;
 
         stopWorkerThreads();
+
+        FastArray<ChunkedTask *>::const_iterator itor = mChunkedTasks.begin();
+        FastArray<ChunkedTask *>::const_iterator endt = mChunkedTasks.end();
+        while( itor != endt )
+            delete *itor++;
+        mChunkedTasks.clear();
     }
     //-----------------------------------------------------------------------
     SceneManager::MovableObjectVec SceneManager::findMovableObjects( const String &type,
@@ -1365,6 +1393,10 @@ namespace Ogre
 
             mRenderQueue->clear();
 
+            const bool replaySnapshot = mFindVisibleObjects && mRenderQueueSnapshot &&
+                                        prepareRenderQueueSnapshot( cullCamera, lodCamera, firstRq,
+                                                                    lastRq );
+
             // Invert vertex winding?
             if( cullCamera->isReflected() )
                 mDestRenderSystem->setInvertVertexWinding( true );
@@ -1384,6 +1416,9 @@ namespace Ogre
 
             mRenderQueue->renderPassPrepare( mIlluminationStage == IRS_RENDER_TO_TEXTURE, false );
 
+            if( replaySnapshot )
+                mRenderQueue->_restoreSnapshot( *mRenderQueueSnapshot );
+
             if( mFindVisibleObjects )
             {
                 assert( !mEntitiesMemoryManagerCulledList.empty() );
@@ -1413,6 +1448,7 @@ namespace Ogre
                 CullFrustumRequest cullRequest(
                     realFirstRq, realLastRq, mIlluminationStage == IRS_RENDER_TO_TEXTURE, true, false,
                     &mEntitiesMemoryManagerCulledList, cullCamera, lodCamera );
+                cullRequest.skipFastRqs = replaySnapshot;
                 fireCullFrustumThreads( cullRequest );
             }
         }  // end lock on scene graph mutex
@@ -1435,6 +1471,28 @@ namespace Ogre
         Root::getSingleton()._popCurrentSceneManager( this );
     }
     //-----------------------------------------------------------------------
+    bool SceneManager::prepareRenderQueueSnapshot( const Camera *cullCamera, const Camera *lodCamera,
+                                                   uint8 firstRq, uint8 lastRq )
+    {
+        const Viewport *viewport = cullCamera->getLastViewport();
+
+        RenderQueueSnapshot::Key key;
+        key.viewMatrix = cullCamera->getViewMatrix( true );
+        key.projectionMatrix = cullCamera->getProjectionMatrix();
+        key.lodViewMatrix = lodCamera->getViewMatrix( true );
+        key.changeKey = getRenderQueueChangeKey( firstRq, lastRq );
+        key.visibilityMask =
+            ( viewport->getVisibilityMask() & this->getVisibilityMask() ) |
+            ( viewport->getVisibilityMask() & ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
+        key.firstRq = firstRq;
+        key.lastRq = lastRq;
+        key.casterPass = mIlluminationStage == IRS_RENDER_TO_TEXTURE;
+        key.reflected = cullCamera->isReflected();
+
+        // If it can't be replayed, we cull as usual and record the result in _renderPhase02
+        return mRenderQueueSnapshot->_prepareReplay( key );
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::_renderPhase02( Camera *camera, const Camera *lodCamera, uint8 firstRq,
                                        uint8 lastRq, bool includeOverlays )
     {
@@ -1566,6 +1624,9 @@ namespace Ogre
             // TODO: RENDER QUEUE Add Dual Paraboloid mapping
             mRenderQueue->render( mDestRenderSystem, firstRq, lastRq,
                                   mIlluminationStage == IRS_RENDER_TO_TEXTURE, false );
+
+            if( mRenderQueueSnapshot && mRenderQueueSnapshot->_isPendingRecord() )
+                mRenderQueue->_recordSnapshot( *mRenderQueueSnapshot, firstRq, lastRq );
         }
 
         // Restore vertex winding
@@ -1693,45 +1754,26 @@ namespace Ogre
     {
         mRequestType = WARM_UP_SHADERS_COMPILE;
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
     void SceneManager::_fireParallelHlmsCompile()
     {
         mRequestType = PARALLEL_HLMS_COMPILE;
-
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-            mWorkerThreadsBarrier->sync();  // Fire threads
+        fireWorkerThreads();
     }
     //-----------------------------------------------------------------------
     void SceneManager::waitForParallelHlmsCompile()
     {
-        if( !mForceMainThread )
-        {
-            OGRE_ASSERT_LOW( mRequestType == PARALLEL_HLMS_COMPILE );
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        OGRE_ASSERT_LOW( mForceMainThread || mRequestType == PARALLEL_HLMS_COMPILE );
+        waitForWorkerThreads();
     }
     //-----------------------------------------------------------------------
     void SceneManager::_fireParticleSystemManager2Update()
     {
         mRequestType = PARTICLE_SYSTEM_MANAGER2;
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
     void SceneManager::_frameEnded() { mRenderQueue->frameEnded(); }
@@ -1892,6 +1934,15 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllAnimations()
     {
+        if( useChunkedTasks() )
+        {
+            // Skeletons are distributed per thread (see BySkeletonDef::threadStarts)
+            fireChunkedTask( allocateChunkedTask( UPDATE_ALL_ANIMATIONS ), mNumWorkerThreads );
+            if( !mChainChunkedTasks )
+                waitForChunkedTasks();
+            return;
+        }
+
         mRequestType = UPDATE_ALL_ANIMATIONS;
         fireWorkerThreadsAndWait();
     }
@@ -1908,7 +1959,7 @@ namespace Ogre
         const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
         t.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-        Node::updateAllTransforms( numNodes, t );
+        Node::updateAllTransforms( numNodes, t, mIncrementalTransformUpdates );
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransforms()
@@ -1932,6 +1983,15 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
+                if( numNodes && useChunkedTasks() )
+                {
+                    // Each depth waits for its parents in the previous task
+                    ChunkedTask &task = allocateChunkedTask( UPDATE_ALL_TRANSFORMS );
+                    addTransformChunks( task, t, numNodes );
+                    fireChunkedTask( task, task.chunks.size() );
+                    continue;
+                }
+
                 // nodesPerThread must be multiple of ARRAY_PACKED_REALS
                 size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
                 nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
@@ -1950,6 +2010,10 @@ namespace Ogre
             ++it;
         }
 
+        // Listeners expect the transforms to be up to date
+        if( !mChainChunkedTasks || !mSceneNodesWithListeners.empty() )
+            waitForChunkedTasks();
+
         // Call all listeners
         SceneNodeList::const_iterator itor = mSceneNodesWithListeners.begin();
         SceneNodeList::const_iterator endt = mSceneNodesWithListeners.end();
@@ -1980,6 +2044,14 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
+                if( numNodes && useChunkedTasks() )
+                {
+                    ChunkedTask &task = allocateChunkedTask( mRequestType );
+                    addTransformChunks( task, t, numNodes );
+                    fireChunkedTask( task, task.chunks.size() );
+                    continue;
+                }
+
                 // nodesPerThread must be multiple of ARRAY_PACKED_REALS
                 size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
                 nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
@@ -1996,6 +2068,9 @@ namespace Ogre
 
             ++it;
         }
+
+        if( !mChainChunkedTasks )
+            waitForChunkedTasks();
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
@@ -2031,6 +2106,9 @@ namespace Ogre
     void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
                                               size_t threadIdx )
     {
+        MovableObject::MovableObjectArray *changedGpuCulled =
+            mRenderQueue->getGpuCulling() ? &mChangedGpuCulledPerThread[threadIdx] : 0;
+
         ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
         ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
 
@@ -2057,7 +2135,12 @@ namespace Ogre
                 numObjs = std::min( numObjs, totalObjs - toAdvance );
                 objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-                MovableObject::updateAllBounds( numObjs, objData );
+                if( MovableObject::updateAllBounds( numObjs, objData, mIncrementalTransformUpdates,
+                                                    changedGpuCulled ) )
+                {
+                    const ChangedBoundsEntry entry = { memoryManager, i };
+                    mChangedBoundsPerThread[threadIdx].push_back( entry );
+                }
             }
 
             ++it;
@@ -2066,9 +2149,166 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
     {
+        if( useChunkedTasks() )
+        {
+            ChunkedTask &task = allocateChunkedTask( UPDATE_ALL_BOUNDS );
+
+            ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
+            ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
+
+            while( it != en )
+            {
+                ObjectMemoryManager *memoryManager = *it;
+                const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+                for( size_t i = 0; i < numRenderQueues; ++i )
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+                    addObjectChunks( task, objData, totalObjs, memoryManager, static_cast<uint8>( i ) );
+                }
+
+                ++it;
+            }
+
+            task.changedObjects.clear();
+            if( mRenderQueue->getGpuCulling() )
+                task.changedObjects.resize( task.chunks.size() );
+
+            // waitForChunkedTasks bumps the change counters and feeds the GpuCulling
+            fireChunkedTask( task, task.chunks.size() );
+            if( !mChainChunkedTasks )
+                waitForChunkedTasks();
+            return;
+        }
+
         mUpdateBoundsRequest = &objectMemManager;
         mRequestType = UPDATE_ALL_BOUNDS;
         fireWorkerThreadsAndWait();
+
+        // The change counters are not thread safe, bump them now from the main thread
+        vector<ChangedBoundsEntryArray>::type::iterator itor = mChangedBoundsPerThread.begin();
+        vector<ChangedBoundsEntryArray>::type::iterator endt = mChangedBoundsPerThread.end();
+
+        while( itor != endt )
+        {
+            ChangedBoundsEntryArray::const_iterator itEntry = itor->begin();
+            ChangedBoundsEntryArray::const_iterator enEntry = itor->end();
+
+            while( itEntry != enEntry )
+            {
+                itEntry->memoryManager->_notifyObjectsChanged( itEntry->renderQueue );
+                ++itEntry;
+            }
+
+            itor->clear();
+            ++itor;
+        }
+
+        GpuCulling *gpuCulling = mRenderQueue->getGpuCulling();
+        if( gpuCulling )
+        {
+            vector<MovableObject::MovableObjectArray>::type::iterator itChanged =
+                mChangedGpuCulledPerThread.begin();
+            vector<MovableObject::MovableObjectArray>::type::iterator enChanged =
+                mChangedGpuCulledPerThread.end();
+
+            while( itChanged != enChanged )
+            {
+                updateGpuCulledObjects( gpuCulling, *itChanged );
+                ++itChanged;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateGpuCulledObjects( GpuCulling *gpuCulling,
+                                               MovableObject::MovableObjectArray &changedObjects )
+    {
+        MovableObject::MovableObjectArray::const_iterator itor = changedObjects.begin();
+        MovableObject::MovableObjectArray::const_iterator endt = changedObjects.end();
+
+        while( itor != endt )
+            gpuCulling->updateObject( *itor++ );
+
+        changedObjects.clear();
+    }
+    //-----------------------------------------------------------------------
+    uint64 SceneManager::getRenderQueueChangeKey( uint8 firstRq, uint8 lastRq ) const
+    {
+        // Counters only ever go up, thus their sum changes whenever any of them does
+        uint64 changeKey = mEntitiesMemoryManagerCulledList.size();
+
+        ObjectMemoryManagerVec::const_iterator itor = mEntitiesMemoryManagerCulledList.begin();
+        ObjectMemoryManagerVec::const_iterator endt = mEntitiesMemoryManagerCulledList.end();
+
+        while( itor != endt )
+        {
+            for( size_t i = firstRq; i < lastRq; ++i )
+            {
+                if( mRenderQueue->getRenderQueueMode( static_cast<uint8>( i ) ) == RenderQueue::FAST )
+                    changeKey += ( *itor )->getChangeCounter( i );
+            }
+            ++itor;
+        }
+
+        return changeKey;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::setSceneQueryBvhEnabled( bool bEnabled )
+    {
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            if( bEnabled && !mSceneQueryBvh[i] )
+            {
+                mSceneQueryBvh[i] = OGRE_NEW SceneQueryBvh( &mEntityMemoryManager[i] );
+            }
+            else if( !bEnabled )
+            {
+                OGRE_DELETE mSceneQueryBvh[i];
+                mSceneQueryBvh[i] = 0;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateSceneQueryBvhThread( size_t threadIdx )
+    {
+        // Each tree is processed entirely by one thread. Trees are
+        // independent so we just distribute them in round robin.
+        size_t treeIdx = 0;
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            SceneQueryBvh *bvh = mSceneQueryBvh[i];
+            const size_t numTrees = bvh->_getNumTrees();
+            for( size_t rq = 0; rq < numTrees; ++rq )
+            {
+                if( ( treeIdx++ % mNumWorkerThreads ) == threadIdx )
+                    bvh->_updateTree( rq );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateSceneQueryBvh()
+    {
+        if( !mSceneQueryBvh[0] )
+            return;
+
+        OgreProfile( "updateSceneQueryBvh" );
+
+        bool anyPending = false;
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            const bool boundsUpdated =
+                std::find( mEntitiesMemoryManagerUpdateList.begin(),
+                           mEntitiesMemoryManagerUpdateList.end(),
+                           &mEntityMemoryManager[i] ) != mEntitiesMemoryManagerUpdateList.end();
+            anyPending |= mSceneQueryBvh[i]->_prepareForUpdate( boundsUpdated );
+        }
+
+        if( anyPending )
+        {
+            mRequestType = UPDATE_SCENE_QUERY_BVH;
+            fireWorkerThreadsAndWait();
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx )
@@ -2122,6 +2362,36 @@ namespace Ogre
         mUpdateLodRequest.camera->getFrustumPlanes();
         mUpdateLodRequest.lodCamera->getFrustumPlanes();
 
+        if( useChunkedTasks() )
+        {
+            ChunkedTask &task = allocateChunkedTask( UPDATE_ALL_LODS );
+
+            ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
+            ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
+
+            while( it != en )
+            {
+                ObjectMemoryManager *memoryManager = *it;
+                const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+                const size_t rqStart = std::min<size_t>( mUpdateLodRequest.firstRq, numRenderQueues );
+                const size_t rqEnd = std::min<size_t>( mUpdateLodRequest.lastRq, numRenderQueues );
+
+                for( size_t i = rqStart; i < rqEnd; ++i )
+                {
+                    ObjectData objData;
+                    const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+                    addObjectChunks( task, objData, totalObjs, memoryManager, static_cast<uint8>( i ) );
+                }
+
+                ++it;
+            }
+
+            fireChunkedTask( task, task.chunks.size() );
+            waitForChunkedTasks();
+            return;
+        }
+
         fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
@@ -2141,17 +2411,10 @@ namespace Ogre
         }
 
         const Camera *camera = request.camera;
-        const Camera *lodCamera = request.lodCamera;
-
-        const uint32 visibilityMask =
-            request.cullingLights
-                ? ( camera->getLastViewport()->getLightVisibilityMask() & mLightMask )
-                : ( ( camera->getLastViewport()->getVisibilityMask() & this->getVisibilityMask() ) |
-                    ( camera->getLastViewport()->getVisibilityMask() &
-                      ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
-
-        CullFrustumPreparedData preparedData;
-        MovableObject::cullFrustumPrepare( camera, visibilityMask, lodCamera, preparedData );
+        // Filled by fireCullFrustumThreads
+        const uint32 visibilityMask = mCullVisibilityMask;
+        const bool anyGpuCulled =
+            mRenderQueue->getGpuCulling() && request.addToRenderQueue && !request.cullingLights;
 
         ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
         ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
@@ -2166,14 +2429,20 @@ namespace Ogre
 
             for( size_t i = firstRq; i < lastRq; ++i )
             {
+                const uint8 currRqId = static_cast<uint8>( i );
+
+                if( request.skipFastRqs &&
+                    mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST )
+                {
+                    continue;
+                }
+
                 MovableObject::MovableObjectArray &outVisibleObjects =
                     *( visibleObjectsPerRq.begin() + i );
 
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
 
-                const uint8 currRqId = static_cast<uint8>( i );
-
                 // Skip if totalObjs == 0u. Profiling shows there is considerable gains.
                 // Too much (255 queues, most of them empty, multiples scene passes...)
                 if( totalObjs > 0u )
@@ -2191,8 +2460,11 @@ namespace Ogre
                     numObjs = std::min( numObjs, totalObjs - toAdvance );
                     objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
+                    const bool isGpuCulled =
+                        anyGpuCulled && mRenderQueue->isGpuCulled( currRqId, request.casterPass );
+
                     MovableObject::cullFrustum( numObjs, objData, camera, outVisibleObjects,
-                                                preparedData );
+                                                mCullPreparedData[isGpuCulled ? 0u : 1u] );
 
                     if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
                         request.addToRenderQueue )
@@ -2415,13 +2687,7 @@ namespace Ogre
             }
         }
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreadsAndWait();
 
         // Now merge the results into a single list.
 
@@ -2453,13 +2719,7 @@ namespace Ogre
         {
             // Now fire the threads again, to build the per-MovableObject lists
             mRequestType = BUILD_LIGHT_LIST02;
-            if( mForceMainThread )
-                updateWorkerThreadImpl( 0 );
-            else
-            {
-                mWorkerThreadsBarrier->sync();  // Fire threads
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-            }
+            fireWorkerThreadsAndWait();
         }
     }
     //-----------------------------------------------------------------------
@@ -2726,11 +2986,17 @@ namespace Ogre
 
         highLevelCull();
         _applySceneAnimations();
+
+        // With a TaskScheduler these are sent as a chain of dependent tasks
+        mChainChunkedTasks = useChunkedTasks();
         updateAllTransforms();
         updateAllAnimations();
         updateAllTagPoints();
         updateAllBounds( mEntitiesMemoryManagerUpdateList );
         updateAllBounds( mLightsMemoryManagerCulledList );
+        mChainChunkedTasks = false;
+        waitForChunkedTasks();
+        updateSceneQueryBvh();
 
         mPrepareParticleFx = false;
 
@@ -4135,6 +4401,13 @@ namespace Ogre
         return q;
     }
     //---------------------------------------------------------------------
+    BatchRaySceneQuery *SceneManager::createBatchRayQuery( uint32 mask )
+    {
+        BatchRaySceneQuery *q = OGRE_NEW BatchRaySceneQuery( this );
+        q->setQueryMask( mask );
+        return q;
+    }
+    //---------------------------------------------------------------------
     IntersectionSceneQuery *SceneManager::createIntersectionQuery( uint32 mask )
     {
         DefaultIntersectionSceneQuery *q = OGRE_NEW DefaultIntersectionSceneQuery( this );
@@ -4605,14 +4878,353 @@ namespace Ogre
             mGpuParamsDirty = 0;
         }
     }
-    void SceneManager::fireWorkerThreadsAndWait()
+    //---------------------------------------------------------------------
+    void SceneManager::fireWorkerThreads()
     {
+        // Requests sent this way read their parameters from us, they can't overlap
+        waitForChunkedTasks();
+
         if( mForceMainThread )
             updateWorkerThreadImpl( 0 );
+        else if( mTaskScheduler )
+            mPendingWorkerTask = mTaskScheduler->addTask( &mWorkerThreadsTask, mNumWorkerThreads );
         else
-        {
             mWorkerThreadsBarrier->sync();  // Fire threads
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::waitForWorkerThreads()
+    {
+        if( mForceMainThread )
+            return;
+
+        if( mTaskScheduler )
+            mTaskScheduler->waitFor( mPendingWorkerTask );
+        else
             mWorkerThreadsBarrier->sync();  // Wait them to complete
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::fireWorkerThreadsAndWait()
+    {
+        fireWorkerThreads();
+        waitForWorkerThreads();
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::addTransformChunks( ChunkedTask &task, Transform t, size_t numNodes )
+    {
+        // mTaskChunkSize is a multiple of ARRAY_PACKED_REALS, thus every chunk starts at a pack
+        for( size_t i = 0u; i < numNodes; i += mTaskChunkSize )
+        {
+            WorkChunk chunk;
+            chunk.t = t;
+            chunk.numElements = std::min( mTaskChunkSize, numNodes - i );
+            chunk.memoryManager = 0;
+            chunk.renderQueue = 0u;
+            chunk.gpuCulled = false;
+            chunk.boundsChanged = false;
+            task.chunks.push_back( chunk );
+
+            if( numNodes - i > mTaskChunkSize )
+                t.advancePack( mTaskChunkSize / ARRAY_PACKED_REALS );
+        }
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::addObjectChunks( ChunkedTask &task, ObjectData objData, size_t numObjs,
+                                        ObjectMemoryManager *memoryManager, uint8 renderQueue,
+                                        bool gpuCulled )
+    {
+        for( size_t i = 0u; i < numObjs; i += mTaskChunkSize )
+        {
+            WorkChunk chunk;
+            chunk.objData = objData;
+            chunk.numElements = std::min( mTaskChunkSize, numObjs - i );
+            chunk.memoryManager = memoryManager;
+            chunk.renderQueue = renderQueue;
+            chunk.gpuCulled = gpuCulled;
+            chunk.boundsChanged = false;
+            task.chunks.push_back( chunk );
+
+            if( numObjs - i > mTaskChunkSize )
+                objData.advancePack( mTaskChunkSize / ARRAY_PACKED_REALS );
+        }
+    }
+    //---------------------------------------------------------------------
+    SceneManager::ChunkedTask &SceneManager::allocateChunkedTask( RequestType requestType )
+    {
+        if( mNumChunkedTasks == mChunkedTasks.size() )
+        {
+            ChunkedTask *newTask = new ChunkedTask();
+            newTask->sceneManager = this;
+            mChunkedTasks.push_back( newTask );
+        }
+
+        ChunkedTask &task = *mChunkedTasks[mNumChunkedTasks++];
+        task.requestType = requestType;
+        task.chunks.clear();
+        return task;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::fireChunkedTask( ChunkedTask &task, size_t numChunks )
+    {
+        OGRE_ASSERT_LOW( mTaskScheduler && &task == mChunkedTasks[mNumChunkedTasks - 1u] &&
+                         "Tasks must be fired right after allocateChunkedTask" );
+
+        // Every task depends on the previous one. The one before it depends on its
+        // predecessor, and so on; thus when the last one finishes, all of them did.
+        const TaskScheduler::TaskId prevTask = mLastChunkedTask;
+        const size_t numDependencies = mNumChunkedTasks > 1u ? 1u : 0u;
+        mLastChunkedTask = mTaskScheduler->addTask( &task, numChunks, &prevTask, numDependencies );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::waitForChunkedTasks()
+    {
+        if( !mNumChunkedTasks )
+            return;
+
+        mTaskScheduler->waitFor( mLastChunkedTask );
+
+        // The change counters are not thread safe, bump them now from the main thread
+        for( size_t i = 0u; i < mNumChunkedTasks; ++i )
+        {
+            const ChunkedTask &task = *mChunkedTasks[i];
+            if( task.requestType != UPDATE_ALL_BOUNDS )
+                continue;
+
+            const WorkChunk *lastNotified = 0;
+            FastArray<WorkChunk>::const_iterator itor = task.chunks.begin();
+            FastArray<WorkChunk>::const_iterator endt = task.chunks.end();
+
+            while( itor != endt )
+            {
+                // Chunks of the same render queue are contiguous. Bump them once.
+                if( itor->boundsChanged &&
+                    ( !lastNotified || lastNotified->memoryManager != itor->memoryManager ||
+                      lastNotified->renderQueue != itor->renderQueue ) )
+                {
+                    itor->memoryManager->_notifyObjectsChanged( itor->renderQueue );
+                    lastNotified = itor;
+                }
+                ++itor;
+            }
+
+            GpuCulling *gpuCulling = mRenderQueue->getGpuCulling();
+            if( gpuCulling )
+            {
+                FastArray<MovableObject::MovableObjectArray>::iterator itChanged =
+                    mChunkedTasks[i]->changedObjects.begin();
+                FastArray<MovableObject::MovableObjectArray>::iterator enChanged =
+                    mChunkedTasks[i]->changedObjects.end();
+
+                while( itChanged != enChanged )
+                {
+                    updateGpuCulledObjects( gpuCulling, *itChanged );
+                    ++itChanged;
+                }
+            }
+        }
+
+        mNumChunkedTasks = 0u;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::ChunkedTask::execute( size_t threadId, size_t /*numThreads*/ )
+    {
+        sceneManager->executeChunk( *this, threadId );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::executeChunk( ChunkedTask &task, size_t chunkIdx )
+    {
+        switch( task.requestType )
+        {
+        case CULL_FRUSTUM:
+        {
+            const WorkChunk &chunk = task.chunks[chunkIdx];
+            MovableObject::cullFrustum( chunk.numElements, chunk.objData,
+                                        mCurrentCullFrustumRequest.camera,
+                                        mCullChunkVisibleObjects[chunkIdx],
+                                        mCullPreparedData[chunk.gpuCulled ? 0u : 1u] );
+            break;
+        }
+        case COLLECT_CULLED_OBJECTS:
+            collectCulledObjects( mCurrentCullFrustumRequest, chunkIdx );
+            break;
+        case UPDATE_ALL_ANIMATIONS:
+            updateAllAnimationsThread( chunkIdx );
+            if( mPrepareParticleFx )
+                mParticleSystemManager2->_prepareParallel();
+            break;
+        case UPDATE_ALL_TRANSFORMS:
+        {
+            const WorkChunk &chunk = task.chunks[chunkIdx];
+            Node::updateAllTransforms( chunk.numElements, chunk.t, mIncrementalTransformUpdates );
+            break;
+        }
+        case UPDATE_ALL_BONE_TO_TAG_TRANSFORMS:
+        {
+            const WorkChunk &chunk = task.chunks[chunkIdx];
+            TagPoint::updateAllTransformsBoneToTag( chunk.numElements, chunk.t );
+            break;
+        }
+        case UPDATE_ALL_TAG_ON_TAG_TRANSFORMS:
+        {
+            const WorkChunk &chunk = task.chunks[chunkIdx];
+            TagPoint::updateAllTransformsTagOnTag( chunk.numElements, chunk.t );
+            break;
+        }
+        case UPDATE_ALL_BOUNDS:
+        {
+            WorkChunk &chunk = task.chunks[chunkIdx];
+            chunk.boundsChanged = MovableObject::updateAllBounds(
+                chunk.numElements, chunk.objData, mIncrementalTransformUpdates,
+                task.changedObjects.empty() ? 0 : &task.changedObjects[chunkIdx] );
+            break;
+        }
+        case UPDATE_ALL_LODS:
+        {
+            const WorkChunk &chunk = task.chunks[chunkIdx];
+            LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
+            lodStrategy->lodUpdateImpl( chunk.numElements, chunk.objData, mUpdateLodRequest.lodCamera,
+                                        mUpdateLodRequest.lodBias );
+            break;
+        }
+        default:
+            OGRE_ASSERT_LOW( false && "Request type can't be chunked" );
+            break;
+        }
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::fireChunkedCullFrustum( const CullFrustumRequest &request )
+    {
+        ChunkedTask &cullTask = allocateChunkedTask( CULL_FRUSTUM );
+
+        const bool anyGpuCulled =
+            mRenderQueue->getGpuCulling() && request.addToRenderQueue && !request.cullingLights;
+
+        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
+        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
+
+        while( it != en )
+        {
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+            const size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
+            const size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
+
+            for( size_t i = firstRq; i < lastRq; ++i )
+            {
+                const uint8 currRqId = static_cast<uint8>( i );
+
+                if( request.skipFastRqs &&
+                    mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST )
+                {
+                    continue;
+                }
+
+                ObjectData objData;
+                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+                const bool isGpuCulled =
+                    anyGpuCulled && mRenderQueue->isGpuCulled( currRqId, request.casterPass );
+                addObjectChunks( cullTask, objData, totalObjs, memoryManager, currRqId, isGpuCulled );
+            }
+
+            ++it;
+        }
+
+        // collectCulledObjects leaves them empty
+        const size_t numChunks = cullTask.chunks.size();
+        if( mCullChunkVisibleObjects.size() < numChunks )
+            mCullChunkVisibleObjects.resize( numChunks );
+
+        mCullTask = &cullTask;
+        fireChunkedTask( cullTask, numChunks );
+        // Each thread's results go to its own mVisibleObjects & RenderQueue slots
+        fireChunkedTask( allocateChunkedTask( COLLECT_CULLED_OBJECTS ), mNumWorkerThreads );
+        waitForChunkedTasks();
+        mCullTask = 0;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::collectCulledObjects( const CullFrustumRequest &request, size_t threadIdx )
+    {
+        VisibleObjectsPerRq &visibleObjectsPerRq = *( mVisibleObjects.begin() + threadIdx );
+        {
+            visibleObjectsPerRq.resize( 255 );
+            VisibleObjectsPerRq::iterator itor = visibleObjectsPerRq.begin();
+            VisibleObjectsPerRq::iterator endt = visibleObjectsPerRq.end();
+
+            while( itor != endt )
+            {
+                itor->clear();
+                ++itor;
+            }
+        }
+
+        // Each thread takes a contiguous range of chunks. Objects thus end up in the
+        // same order cullFrustum would have produced once all threads are merged.
+        const size_t numChunks = mCullTask->chunks.size();
+        const size_t firstChunk = ( numChunks * threadIdx ) / mNumWorkerThreads;
+        const size_t lastChunk = ( numChunks * ( threadIdx + 1u ) ) / mNumWorkerThreads;
+
+        for( size_t i = firstChunk; i < lastChunk; ++i )
+        {
+            const uint8 currRqId = mCullTask->chunks[i].renderQueue;
+            MovableObject::MovableObjectArray &culledObjects = mCullChunkVisibleObjects[i];
+
+            if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
+                request.addToRenderQueue )
+            {
+                // V2 meshes can be added to the render queue in parallel
+                MovableObject::MovableObjectArray::const_iterator itor = culledObjects.begin();
+                MovableObject::MovableObjectArray::const_iterator endt = culledObjects.end();
+
+                while( itor != endt )
+                {
+                    RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
+                    RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
+
+                    while( itRend != enRend )
+                    {
+                        if( ( *itRend )->mRenderableVisible )
+                        {
+                            mRenderQueue->addRenderableV2( threadIdx, currRqId, request.casterPass,
+                                                           *itRend, *itor );
+                        }
+                        ++itRend;
+                    }
+                    ++itor;
+                }
+            }
+            else
+            {
+                visibleObjectsPerRq[currRqId].appendPOD( culledObjects.begin(), culledObjects.end() );
+            }
+
+            culledObjects.clear();
+        }
+
+        if( !request.addToRenderQueue )
+            return;
+
+        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
+        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
+
+        while( it != en )
+        {
+            const size_t numRenderQueues = ( *it )->getNumRenderQueues();
+            const size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
+            const size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
+
+            for( size_t i = firstRq; i < lastRq; ++i )
+            {
+                const uint8 currRqId = static_cast<uint8>( i );
+                if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::PARTICLE_SYSTEM )
+                {
+                    mParticleSystemManager2->_addToRenderQueue( threadIdx, mNumWorkerThreads,
+                                                                mRenderQueue, currRqId,
+                                                                mCullVisibilityMask,
+                                                                !request.casterPass );
+                }
+            }
+
+            ++it;
         }
     }
     //---------------------------------------------------------------------
@@ -4626,7 +5238,35 @@ namespace Ogre
         // in case they weren't up to date.
         mCurrentCullFrustumRequest.camera->getFrustumPlanes();
         mCurrentCullFrustumRequest.lodCamera->getFrustumPlanes();
-        fireWorkerThreadsAndWait();
+
+        const Camera *camera = request.camera;
+        mCullVisibilityMask =
+            request.cullingLights
+                ? ( camera->getLastViewport()->getLightVisibilityMask() & mLightMask )
+                : ( ( camera->getLastViewport()->getVisibilityMask() & this->getVisibilityMask() ) |
+                    ( camera->getLastViewport()->getVisibilityMask() &
+                      ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
+
+        MovableObject::cullFrustumPrepare( camera, mCullVisibilityMask, request.lodCamera,
+                                           mCullPreparedData[1] );
+
+        // Render queues culled by the GpuCulling skip the frustum planes test, which is
+        // performed on the GPU. Visibility flags, rendering distance & LOD still happen here
+        if( mRenderQueue->getGpuCulling() && request.addToRenderQueue && !request.cullingLights )
+        {
+            mCullPreparedData[0] = mCullPreparedData[1];
+            for( size_t i = 0; i < 6u; ++i )
+            {
+                mCullPreparedData[0].planes[i].planeNormal = ArrayVector3::ZERO;
+                mCullPreparedData[0].planes[i].signFlip = ArrayVector3::ZERO;
+                mCullPreparedData[0].planes[i].planeNegD = Mathlib::MAX_NEG;
+            }
+        }
+
+        if( useChunkedTasks() )
+            fireChunkedCullFrustum( mCurrentCullFrustumRequest );
+        else
+            fireWorkerThreadsAndWait();
     }
     //---------------------------------------------------------------------
     void SceneManager::executeUserScalableTask( UniformScalableTask *task, bool bBlock )
@@ -4634,23 +5274,15 @@ namespace Ogre
         mRequestType = USER_UNIFORM_SCALABLE_TASK;
         mUserTask = task;
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            if( bBlock )
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreads();
+        if( bBlock )
+            waitForWorkerThreads();
     }
     //---------------------------------------------------------------------
     void SceneManager::waitForPendingUserScalableTask()
     {
-        if( !mForceMainThread )
-        {
-            assert( mRequestType == USER_UNIFORM_SCALABLE_TASK );
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        assert( mForceMainThread || mRequestType == USER_UNIFORM_SCALABLE_TASK );
+        waitForWorkerThreads();
     }
     //---------------------------------------------------------------------
     unsigned long updateWorkerThread( ThreadHandle *threadHandle )
@@ -4665,7 +5297,7 @@ namespace Ogre
     //---------------------------------------------------------------------
     void SceneManager::startWorkerThreads()
     {
-        if( !mForceMainThread )
+        if( !mForceMainThread && !mTaskScheduler && !mWorkerThreadsBarrier )
         {
             mWorkerThreadsBarrier = new Barrier( mNumWorkerThreads + 1 );
             mWorkerThreads.reserve( mNumWorkerThreads );
@@ -4679,18 +5311,45 @@ namespace Ogre
     //---------------------------------------------------------------------
     void SceneManager::stopWorkerThreads()
     {
-        if( !mForceMainThread )
+        if( mWorkerThreadsBarrier )
         {
             mRequestType = STOP_THREADS;
-            fireWorkerThreadsAndWait();
+            mWorkerThreadsBarrier->sync();  // Fire threads
+            mWorkerThreadsBarrier->sync();  // Wait them to complete
 
             Threads::WaitForThreads( mWorkerThreads );
+            mWorkerThreads.clear();
 
             delete mWorkerThreadsBarrier;
             mWorkerThreadsBarrier = 0;
         }
     }
     //---------------------------------------------------------------------
+    void SceneManager::setTaskScheduler( TaskScheduler *taskScheduler )
+    {
+        if( mTaskScheduler == taskScheduler )
+            return;
+
+        waitForChunkedTasks();
+
+        stopWorkerThreads();
+        mTaskScheduler = taskScheduler;
+        startWorkerThreads();
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::setTaskChunkSize( size_t chunkSize )
+    {
+        mTaskChunkSize = ( ( std::max<size_t>( chunkSize, 1u ) + ARRAY_PACKED_REALS - 1u ) /
+                           ARRAY_PACKED_REALS ) *
+                         ARRAY_PACKED_REALS;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::WorkerThreadsTask::execute( size_t threadId, size_t numThreads )
+    {
+        OGRE_ASSERT_MEDIUM( numThreads == sceneManager->getNumWorkerThreads() );
+        sceneManager->updateWorkerThreadImpl( threadId );
+    }
+    //---------------------------------------------------------------------
     unsigned long SceneManager::_updateWorkerThread( ThreadHandle *threadHandle )
     {
         bool exitThread = false;
@@ -4734,6 +5393,9 @@ namespace Ogre
         case UPDATE_ALL_LODS:
             updateAllLodsThread( mUpdateLodRequest, threadIdx );
             break;
+        case UPDATE_SCENE_QUERY_BVH:
+            updateSceneQueryBvhThread( threadIdx );
+            break;
         case BUILD_LIGHT_LIST01:
             buildLightListThread01( mBuildLightListRequestPerThread[threadIdx], threadIdx );
             break;
@@ -0,0 +1,548 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreSceneQueryBvh.h"
+
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "OgreMovableObject.h"
+#include "OgreRay.h"
+#include "OgreSceneQuery.h"
+#include "OgreSphere.h"
+
+#include <algorithm>
+
+namespace Ogre
+{
+    /// Max depth of the trees. With MaxLeafSize = 4 and a median split, 64 levels
+    /// is enough for far more objects than what can be addressed.
+    static const size_t c_maxTraversalDepth = 64u;
+
+    struct CentroidAxisLess
+    {
+        const Vector3 *RESTRICT_ALIAS centroids;
+        size_t                        axis;
+
+        CentroidAxisLess( const Vector3 *_centroids, size_t _axis ) :
+            centroids( _centroids ),
+            axis( _axis )
+        {
+        }
+
+        bool operator()( uint32 a, uint32 b ) const { return centroids[a][axis] < centroids[b][axis]; }
+    };
+
+    //-------------------------------------------------------------------------
+    /// Slab test. Returns true if the ray hits the box, and outT contains the distance
+    /// to the entry point (0 if the origin is inside the box).
+    static inline bool rayIntersectsBox( const Vector3 &origin, const Vector3 &invDir,
+                                         const Vector3 &vMin, const Vector3 &vMax, Real &outT )
+    {
+        Real tNear = 0;
+        Real tFar = std::numeric_limits<Real>::infinity();
+
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            if( Math::Abs( invDir[i] ) == std::numeric_limits<Real>::infinity() )
+            {
+                // Ray is parallel to this slab
+                if( origin[i] < vMin[i] || origin[i] > vMax[i] )
+                    return false;
+            }
+            else
+            {
+                Real t0 = ( vMin[i] - origin[i] ) * invDir[i];
+                Real t1 = ( vMax[i] - origin[i] ) * invDir[i];
+                if( t0 > t1 )
+                    std::swap( t0, t1 );
+                // Written this way so that NaNs (i.e. infinite boxes) don't discard the hit
+                if( t0 > tNear )
+                    tNear = t0;
+                if( t1 < tFar )
+                    tFar = t1;
+                if( tNear > tFar )
+                    return false;
+            }
+        }
+
+        outT = tNear;
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    static inline bool sphereIntersectsBox( const Sphere &sphere, const Vector3 &vMin,
+                                            const Vector3 &vMax )
+    {
+        const Vector3 &center = sphere.getCenter();
+        const Vector3 closest( Math::Clamp( center.x, vMin.x, vMax.x ),
+                               Math::Clamp( center.y, vMin.y, vMax.y ),
+                               Math::Clamp( center.z, vMin.z, vMax.z ) );
+        return center.squaredDistance( closest ) <= sphere.getRadius() * sphere.getRadius();
+    }
+    //-------------------------------------------------------------------------
+    static inline bool boxIntersectsBox( const Vector3 &aMin, const Vector3 &aMax, const Vector3 &bMin,
+                                         const Vector3 &bMax )
+    {
+        return !( aMax.x < bMin.x || aMax.y < bMin.y || aMax.z < bMin.z ||  //
+                  aMin.x > bMax.x || aMin.y > bMax.y || aMin.z > bMax.z );
+    }
+    //-------------------------------------------------------------------------
+    static inline bool slotPassesFlags( const ObjectData &objData, size_t slot, uint32 queryMask )
+    {
+        return ( objData.mQueryFlags[slot] & queryMask ) &&
+               ( objData.mVisibilityFlags[slot] & VisibilityFlags::LAYER_VISIBILITY );
+    }
+    //-------------------------------------------------------------------------
+    SceneQueryBvh::Tree::Tree() :
+        ownerBase( 0 ),
+        numSlots( 0 ),
+        builtCost( 0 ),
+        pendingUpdate( true )
+    {
+    }
+    //-------------------------------------------------------------------------
+    SceneQueryBvh::SceneQueryBvh( ObjectMemoryManager *memoryManager ) :
+        mMemoryManager( memoryManager ),
+        mRebuildThreshold( 2.0f )
+    {
+    }
+    //-------------------------------------------------------------------------
+    SceneQueryBvh::~SceneQueryBvh() {}
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::setRebuildThreshold( Real threshold )
+    {
+        mRebuildThreshold = std::max<Real>( threshold, 1.0f );
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::getSlotBounds( const ObjectData &objData, size_t slot, Vector3 &outMin,
+                                       Vector3 &outMax )
+    {
+        Aabb aabb;
+        objData.mWorldAabb[slot / ARRAY_PACKED_REALS].getAsAabb( aabb, slot % ARRAY_PACKED_REALS );
+        // Sphere queries test against the world radius, which may stick out of the Aabb
+        Vector3 halfSize( objData.mWorldRadius[slot] );
+        halfSize.makeCeil( aabb.mHalfSize );
+        outMin = aabb.mCenter - halfSize;
+        outMax = aabb.mCenter + halfSize;
+    }
+    //-------------------------------------------------------------------------
+    Real SceneQueryBvh::getSurfaceArea( const Node &node )
+    {
+        const Vector3 size = node.vMax - node.vMin;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::rebuild( Tree &tree, const ObjectData &objData, size_t numSlots )
+    {
+        tree.nodes.clear();
+        tree.slots.resize( numSlots );
+        tree.owners.resize( numSlots );
+        tree.tmpCentroids.resize( numSlots );
+        tree.ownerBase = objData.mOwner;
+        tree.numSlots = numSlots;
+        tree.builtCost = 0;
+
+        if( !numSlots )
+            return;
+
+        tree.nodes.reserve( ( numSlots * 2u ) / MaxLeafSize + 1u );
+
+        for( size_t i = 0; i < numSlots; ++i )
+        {
+            Aabb aabb;
+            objData.mWorldAabb[i / ARRAY_PACKED_REALS].getAsAabb( aabb, i % ARRAY_PACKED_REALS );
+            tree.slots[i] = static_cast<uint32>( i );
+            tree.owners[i] = objData.mOwner[i];
+            tree.tmpCentroids[i] = aabb.mCenter;
+        }
+
+        struct BuildEntry
+        {
+            uint32 nodeIdx;
+            uint32 begin;
+            uint32 end;
+        };
+
+        BuildEntry stack[c_maxTraversalDepth * 2u];
+        size_t stackSize = 0;
+
+        tree.nodes.push_back( Node() );
+        stack[stackSize].nodeIdx = 0u;
+        stack[stackSize].begin = 0u;
+        stack[stackSize].end = static_cast<uint32>( numSlots );
+        ++stackSize;
+
+        const Vector3 *centroids = &tree.tmpCentroids[0];
+
+        while( stackSize )
+        {
+            const BuildEntry entry = stack[--stackSize];
+
+            Vector3 vMin( Vector3( std::numeric_limits<Real>::max() ) );
+            Vector3 vMax( -vMin );
+            Vector3 centroidMin( vMin );
+            Vector3 centroidMax( vMax );
+
+            for( uint32 i = entry.begin; i < entry.end; ++i )
+            {
+                const uint32 slot = tree.slots[i];
+                Vector3 slotMin, slotMax;
+                getSlotBounds( objData, slot, slotMin, slotMax );
+                vMin.makeFloor( slotMin );
+                vMax.makeCeil( slotMax );
+                centroidMin.makeFloor( centroids[slot] );
+                centroidMax.makeCeil( centroids[slot] );
+            }
+
+            Node &node = tree.nodes[entry.nodeIdx];
+            node.vMin = vMin;
+            node.vMax = vMax;
+
+            const uint32 count = entry.end - entry.begin;
+            if( count <= MaxLeafSize )
+            {
+                node.firstIdx = entry.begin;
+                node.count = count;
+            }
+            else
+            {
+                // Median split along the axis where centroids are more spread
+                const Vector3 extent = centroidMax - centroidMin;
+                size_t axis = 0u;
+                if( extent.y > extent[axis] )
+                    axis = 1u;
+                if( extent.z > extent[axis] )
+                    axis = 2u;
+
+                const uint32 mid = entry.begin + count / 2u;
+                std::nth_element( tree.slots.begin() + entry.begin, tree.slots.begin() + mid,
+                                  tree.slots.begin() + entry.end, CentroidAxisLess( centroids, axis ) );
+
+                const uint32 firstChild = static_cast<uint32>( tree.nodes.size() );
+                node.firstIdx = firstChild;
+                node.count = 0u;
+                // 'node' gets invalidated after this point
+                tree.nodes.push_back( Node() );
+                tree.nodes.push_back( Node() );
+
+                stack[stackSize].nodeIdx = firstChild;
+                stack[stackSize].begin = entry.begin;
+                stack[stackSize].end = mid;
+                ++stackSize;
+                stack[stackSize].nodeIdx = firstChild + 1u;
+                stack[stackSize].begin = mid;
+                stack[stackSize].end = entry.end;
+                ++stackSize;
+            }
+        }
+
+        NodeVec::const_iterator itor = tree.nodes.begin();
+        NodeVec::const_iterator endt = tree.nodes.end();
+        while( itor != endt )
+            tree.builtCost += getSurfaceArea( *itor++ );
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::refit( Tree &tree, const ObjectData &objData )
+    {
+        Real cost = 0;
+
+        NodeVec::reverse_iterator itor = tree.nodes.rbegin();
+        NodeVec::reverse_iterator endt = tree.nodes.rend();
+
+        while( itor != endt )
+        {
+            Node &node = *itor;
+            if( node.count )
+            {
+                Vector3 vMin( Vector3( std::numeric_limits<Real>::max() ) );
+                Vector3 vMax( -vMin );
+                for( uint32 i = node.firstIdx; i < node.firstIdx + node.count; ++i )
+                {
+                    const uint32 slot = tree.slots[i];
+                    if( objData.mOwner[slot] != tree.owners[slot] )
+                        return false;
+                    Vector3 slotMin, slotMax;
+                    getSlotBounds( objData, slot, slotMin, slotMax );
+                    vMin.makeFloor( slotMin );
+                    vMax.makeCeil( slotMax );
+                }
+                node.vMin = vMin;
+                node.vMax = vMax;
+            }
+            else
+            {
+                // Children always come after their parents, thus they've already been refitted
+                const Node &left = tree.nodes[node.firstIdx];
+                const Node &right = tree.nodes[node.firstIdx + 1u];
+                node.vMin = left.vMin;
+                node.vMin.makeFloor( right.vMin );
+                node.vMax = left.vMax;
+                node.vMax.makeCeil( right.vMax );
+            }
+
+            cost += getSurfaceArea( node );
+            ++itor;
+        }
+
+        // Written this way so that NaNs (i.e. infinite boxes) don't trigger a rebuild every frame
+        return !( cost > tree.builtCost * mRebuildThreshold );
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::isUpToDate( size_t renderQueue ) const
+    {
+        if( renderQueue >= mTrees.size() )
+            return false;
+
+        const Tree &tree = mTrees[renderQueue];
+
+        ObjectData objData;
+        const size_t numSlots = mMemoryManager->getFirstObjectData( objData, renderQueue );
+
+        return !tree.pendingUpdate && tree.numSlots == numSlots &&
+               ( !numSlots || tree.ownerBase == objData.mOwner );
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::_prepareForUpdate( bool boundsUpdated )
+    {
+        const size_t numRenderQueues = mMemoryManager->getNumRenderQueues();
+        mTrees.resize( numRenderQueues );
+
+        bool anyPending = false;
+
+        for( size_t i = 0; i < numRenderQueues; ++i )
+        {
+            Tree &tree = mTrees[i];
+            if( boundsUpdated )
+            {
+                tree.pendingUpdate = true;
+            }
+            else if( !tree.pendingUpdate )
+            {
+                ObjectData objData;
+                const size_t numSlots = mMemoryManager->getFirstObjectData( objData, i );
+                tree.pendingUpdate =
+                    tree.numSlots != numSlots || ( numSlots && tree.ownerBase != objData.mOwner );
+            }
+            anyPending |= tree.pendingUpdate;
+        }
+
+        return anyPending;
+    }
+    //-------------------------------------------------------------------------
+    void SceneQueryBvh::_updateTree( size_t renderQueue )
+    {
+        Tree &tree = mTrees[renderQueue];
+        if( !tree.pendingUpdate )
+            return;
+
+        ObjectData objData;
+        const size_t numSlots = mMemoryManager->getFirstObjectData( objData, renderQueue );
+
+        const bool layoutChanged =
+            tree.numSlots != numSlots || ( numSlots && tree.ownerBase != objData.mOwner );
+
+        if( layoutChanged || !refit( tree, objData ) )
+            rebuild( tree, objData, numSlots );
+
+        tree.pendingUpdate = false;
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::queryAabb( size_t renderQueue, const Aabb &aabb, uint32 queryMask,
+                                   SceneQueryListener *listener ) const
+    {
+        const Tree &tree = mTrees[renderQueue];
+        if( tree.nodes.empty() )
+            return true;
+
+        ObjectData objData;
+        mMemoryManager->getFirstObjectData( objData, renderQueue );
+
+        const Vector3 queryMin = aabb.getMinimum();
+        const Vector3 queryMax = aabb.getMaximum();
+
+        uint32 stack[c_maxTraversalDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = tree.nodes[stack[--stackSize]];
+
+            if( !boxIntersectsBox( node.vMin, node.vMax, queryMin, queryMax ) )
+                continue;
+
+            if( node.count )
+            {
+                for( uint32 i = node.firstIdx; i < node.firstIdx + node.count; ++i )
+                {
+                    const uint32 slot = tree.slots[i];
+                    if( !slotPassesFlags( objData, slot, queryMask ) )
+                        continue;
+
+                    Aabb slotAabb;
+                    objData.mWorldAabb[slot / ARRAY_PACKED_REALS].getAsAabb(
+                        slotAabb, slot % ARRAY_PACKED_REALS );
+                    if( boxIntersectsBox( slotAabb.getMinimum(), slotAabb.getMaximum(), queryMin,
+                                          queryMax ) )
+                    {
+#if OGRE_DEBUG_MODE
+                        assert( !objData.mOwner[slot]->isCachedAabbOutOfDate() &&
+                                "Perform the queries after MovableObject::updateAllBounds has been "
+                                "called!" );
+#endif
+                        if( !listener->queryResult( objData.mOwner[slot] ) )
+                            return false;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.firstIdx + 1u;
+                stack[stackSize++] = node.firstIdx;
+            }
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::querySphere( size_t renderQueue, const Sphere &sphere, uint32 queryMask,
+                                     SceneQueryListener *listener ) const
+    {
+        const Tree &tree = mTrees[renderQueue];
+        if( tree.nodes.empty() )
+            return true;
+
+        ObjectData objData;
+        mMemoryManager->getFirstObjectData( objData, renderQueue );
+
+        uint32 stack[c_maxTraversalDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = tree.nodes[stack[--stackSize]];
+
+            if( !sphereIntersectsBox( sphere, node.vMin, node.vMax ) )
+                continue;
+
+            if( node.count )
+            {
+                for( uint32 i = node.firstIdx; i < node.firstIdx + node.count; ++i )
+                {
+                    const uint32 slot = tree.slots[i];
+                    if( !slotPassesFlags( objData, slot, queryMask ) )
+                        continue;
+
+                    // Same test as DefaultSphereSceneQuery: the object is
+                    // represented by a sphere centered at its world Aabb
+                    Aabb slotAabb;
+                    objData.mWorldAabb[slot / ARRAY_PACKED_REALS].getAsAabb(
+                        slotAabb, slot % ARRAY_PACKED_REALS );
+                    const Sphere slotSphere( slotAabb.mCenter, objData.mWorldRadius[slot] );
+                    if( sphere.intersects( slotSphere ) )
+                    {
+#if OGRE_DEBUG_MODE
+                        assert( !objData.mOwner[slot]->isCachedAabbOutOfDate() &&
+                                "Perform the queries after MovableObject::updateAllBounds has been "
+                                "called!" );
+#endif
+                        if( !listener->queryResult( objData.mOwner[slot] ) )
+                            return false;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.firstIdx + 1u;
+                stack[stackSize++] = node.firstIdx;
+            }
+        }
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    bool SceneQueryBvh::queryRay( size_t renderQueue, const Ray &ray, uint32 queryMask,
+                                  RaySceneQueryListener *listener ) const
+    {
+        const Tree &tree = mTrees[renderQueue];
+        if( tree.nodes.empty() )
+            return true;
+
+        ObjectData objData;
+        mMemoryManager->getFirstObjectData( objData, renderQueue );
+
+        const Vector3 &origin = ray.getOrigin();
+        const Vector3 &dir = ray.getDirection();
+        const Vector3 invDir( Real( 1.0 ) / dir.x, Real( 1.0 ) / dir.y, Real( 1.0 ) / dir.z );
+
+        uint32 stack[c_maxTraversalDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0u;
+
+        while( stackSize )
+        {
+            const Node &node = tree.nodes[stack[--stackSize]];
+
+            Real distance;
+            if( !rayIntersectsBox( origin, invDir, node.vMin, node.vMax, distance ) )
+                continue;
+
+            if( node.count )
+            {
+                for( uint32 i = node.firstIdx; i < node.firstIdx + node.count; ++i )
+                {
+                    const uint32 slot = tree.slots[i];
+                    if( !slotPassesFlags( objData, slot, queryMask ) )
+                        continue;
+
+                    Aabb slotAabb;
+                    objData.mWorldAabb[slot / ARRAY_PACKED_REALS].getAsAabb(
+                        slotAabb, slot % ARRAY_PACKED_REALS );
+                    if( rayIntersectsBox( origin, invDir, slotAabb.getMinimum(),
+                                          slotAabb.getMaximum(), distance ) )
+                    {
+#if OGRE_DEBUG_MODE
+                        assert( !objData.mOwner[slot]->isCachedAabbOutOfDate() &&
+                                "Perform the queries after MovableObject::updateAllBounds has been "
+                                "called!" );
+#endif
+                        if( !listener->queryResult( objData.mOwner[slot], distance ) )
+                            return false;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.firstIdx + 1u;
+                stack[stackSize++] = node.firstIdx;
+            }
+        }
+
+        return true;
+    }
+}  // namespace Ogre
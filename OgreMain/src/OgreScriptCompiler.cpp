@@ -1290,6 +1290,7 @@ namespace Ogre
         mIds["lod_update_list"] = ID_LOD_UPDATE_LIST;
         mIds["lod_camera"] = ID_LOD_CAMERA;
         mIds["cull_reuse_data"] = ID_CULL_REUSE_DATA;
+        mIds["cache_render_queue"] = ID_CACHE_RENDER_QUEUE;
         mIds["cull_camera"] = ID_CULL_CAMERA;
         mIds["material_scheme"] = ID_MATERIAL_SCHEME;
         mIds["visibility_mask"] = ID_VISIBILITY_MASK;
@@ -9757,6 +9757,21 @@ namespace Ogre{
                         }
                     }
                     break;
+                case ID_CACHE_RENDER_QUEUE:
+                    {
+                        if( prop->values.empty() )
+                        {
+                            compiler->addError( ScriptCompiler::CE_STRINGEXPECTED, prop->file, prop->line );
+                            return;
+                        }
+
+                        AbstractNodeList::const_iterator it0 = prop->values.begin();
+                        if( !getBoolean( *it0, &passScene->mCacheRenderQueue ) )
+                        {
+                             compiler->addError( ScriptCompiler::CE_NUMBEREXPECTED, prop->file, prop->line );
+                        }
+                    }
+                    break;
                 case ID_VISIBILITY_MASK:
                     {
                         if(prop->values.empty())
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "OgreException.h"
 #include "OgreLogManager.h"
 #include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureGpuManager.h"
 #include "Vao/OgreVaoManager.h"
 
 namespace Ogre
@@ -117,9 +118,12 @@ namespace Ogre
 #if OGRE_DEBUG_MODE
         mUserQueriedIfUploadWillStall = false;
 #endif
+        // Textures packed into a bigger TexturePool also write to the rest of their slice
+        const TextureGpu *sliceTexture =
+            dstTexture->getTexturePool() ? dstTexture->getTexturePool()->masterTexture : dstTexture;
         const TextureBox fullDstTextureBox(
-            std::max( 1u, dstTexture->getInternalWidth() >> mipLevel ),
-            std::max( 1u, dstTexture->getInternalHeight() >> mipLevel ),
+            std::max( 1u, sliceTexture->getInternalWidth() >> mipLevel ),
+            std::max( 1u, sliceTexture->getInternalHeight() >> mipLevel ),
             std::max( 1u, dstTexture->getDepth() >> mipLevel ), dstTexture->getNumSlices(),
             PixelFormatGpuUtils::getBytesPerPixel( dstTexture->getPixelFormat() ),
             dstTexture->_getSysRamCopyBytesPerRow( mipLevel ),
@@ -30,14 +30,56 @@ THE SOFTWARE.
 
 #include "OgreTextureFilters.h"
 
+#include "OgreArchive.h"
+#include "OgreBCnEncoder.h"
+#include "OgreException.h"
+#include "OgreIdString.h"
 #include "OgreImage2.h"
+#include "OgreLogManager.h"
 #include "OgrePixelFormatGpuUtils.h"
 #include "OgreProfiler.h"
 #include "OgreTextureBox.h"
 #include "OgreTextureGpuManager.h"
+#include "Threading/OgreLightweightMutex.h"
+
+#include "Hash/MurmurHash3.h"
+
+#include <limits>
 
 namespace Ogre
 {
+    namespace
+    {
+        /// Bump this value whenever BCnEncoder's output changes, to discard old cache entries
+        const uint32 c_bcnCacheVersion = 1u;
+        const uint32 c_bcnCacheMagic = 0x434E4342u;  // 'BCNC'
+
+        /// Protects TextureGpuManager::getBCnCompressionCache against concurrent access
+        /// from the streaming worker threads
+        LightweightMutex sBCnCacheMutex;
+
+        /// Returns true if any pixel in mip 0 of an RGBA8 image is not fully opaque
+        bool hasTranslucentPixels( const Image2 &image )
+        {
+            const TextureBox box = image.getData( 0 );
+            const uint32 depthOrSlices = box.getDepthOrSlices();
+            for( uint32 z = 0u; z < depthOrSlices; ++z )
+            {
+                for( uint32 y = 0u; y < box.height; ++y )
+                {
+                    const uint8 *RESTRICT_ALIAS data =
+                        reinterpret_cast<const uint8 * RESTRICT_ALIAS>( box.at( 0, y, z ) );
+                    for( uint32 x = 0u; x < box.width; ++x )
+                    {
+                        if( data[x * 4u + 3u] != 255u )
+                            return true;
+                    }
+                }
+            }
+            return false;
+        }
+    }  // namespace
+
     namespace TextureFilter
     {
         FilterBase::~FilterBase() {}
@@ -101,6 +143,21 @@ namespace Ogre
                 filtersVec.push_back( OGRE_NEW TextureFilter::PremultiplyAlpha() );
             }
 
+            if( filters & TextureFilter::TypeCompressBCn )
+            {
+                const PixelFormatGpu compressedFormat = CompressBCn::getDestinationFormat(
+                    filters, image, finalPixelFormat, texture->getTextureManager() );
+                // Cubemaps made of multiple images: the 2nd face onwards must follow
+                // whatever the 1st face decided
+                if( compressedFormat != finalPixelFormat ||
+                    BCnEncoder::isSupported( finalPixelFormat, texture->getPixelFormat() ) )
+                {
+                    // CompressBCn generates the mipmaps itself (in SW) before compressing
+                    filtersVec.push_back( OGRE_NEW TextureFilter::CompressBCn( filters ) );
+                    filters &= ~static_cast<uint32>( TextureFilter::TypeGenerateDefaultMipmaps );
+                }
+            }
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
@@ -142,11 +199,17 @@ namespace Ogre
             if( filters & TextureFilter::TypeLeaveChannelR )
                 inOutPixelFormat = LeaveChannelR::getDestinationFormat( inOutPixelFormat );
 
+            const PixelFormatGpu compressedFormat = CompressBCn::getDestinationFormat(
+                filters, image, inOutPixelFormat, textureGpuManager );
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
+                // CompressBCn always generates the mipmaps in SW
                 const uint8 mipmapGen =
-                    selectMipmapGen( filters, image, inOutPixelFormat, textureGpuManager );
+                    compressedFormat != inOutPixelFormat
+                        ? static_cast<uint8>( DefaultMipmapGen::SwMode )
+                        : selectMipmapGen( filters, image, inOutPixelFormat, textureGpuManager );
 
                 const bool canDoMipmaps =
                     ( mipmapGen == DefaultMipmapGen::HwMode &&
@@ -163,6 +226,8 @@ namespace Ogre
                         image.getWidth(), image.getHeight(), image.getDepth() );
                 }
             }
+
+            inOutPixelFormat = compressedFormat;
         }
         //-----------------------------------------------------------------------------------
         uint32 GenerateSwMipmaps::getFilter( const Image2 &image )
@@ -181,7 +246,7 @@ namespace Ogre
             const Image2::Filter filter = static_cast<Image2::Filter>( getFilter( image ) );
 
             const bool isSRgb = PixelFormatGpuUtils::isSRgb( texture->getPixelFormat() );
-            image.generateMipmaps( isSRgb, filter );
+            image.generateMipmaps( isSRgb, filter, texture->getTextureManager() );
             if( texture->getNumMipmaps() != image.getNumMipmaps() )
                 texture->setNumMipmaps( image.getNumMipmaps() );
         }
@@ -217,15 +282,23 @@ namespace Ogre
                     TextureFlags::DiscardableContent,  //
                 texture->getTextureType() );
             tempTexture->copyParametersFrom( texture );
+
+            // Packed textures include the padding of their slice so that it gets mipmapped
+            // as well. See TextureGpuManager::setAutoPackingMaxResolution
+            const TexturePool *pool = texture->getTexturePool();
+            const uint32 width = pool ? pool->masterTexture->getWidth() : texture->getWidth();
+            const uint32 height = pool ? pool->masterTexture->getHeight() : texture->getHeight();
+            tempTexture->setResolution( width, height, texture->getDepthOrSlices() );
+
             tempTexture->unsafeScheduleTransitionTo( GpuResidency::Resident );
-            TextureBox box = texture->getEmptyBox( 0 );
+            TextureBox box = tempTexture->getEmptyBox( 0 );
             texture->copyTo( tempTexture, box, 0, box, 0 );
             tempTexture->_autogenerateMipmaps();
 
             uint8 numMipmaps = texture->getNumMipmaps();
             for( uint8 i = 1u; i < numMipmaps; ++i )
             {
-                box = texture->getEmptyBox( i );
+                box = tempTexture->getEmptyBox( i );
                 tempTexture->copyTo( texture, box, i, box, i );
             }
 
@@ -493,5 +566,250 @@ namespace Ogre
                 }
             }
         }
+        //-----------------------------------------------------------------------------------
+        PixelFormatGpu CompressBCn::getDestinationFormat( uint32 filters, const Image2 &image,
+                                                          PixelFormatGpu srcFormat,
+                                                          const TextureGpuManager *textureManager )
+        {
+            if( !( filters & TextureFilter::TypeCompressBCn ) )
+                return srcFormat;
+
+            const TextureTypes::TextureTypes textureType = image.getTextureType();
+            if( textureType != TextureTypes::Type2D && textureType != TextureTypes::Type2DArray &&
+                textureType != TextureTypes::TypeCube && textureType != TextureTypes::TypeCubeArray )
+            {
+                return srcFormat;
+            }
+
+            // Block compressed formats require the top mip to be a multiple of the block size
+            if( ( image.getWidth() & 0x03u ) || ( image.getHeight() & 0x03u ) )
+                return srcFormat;
+
+            PixelFormatGpu dstFormat;
+            switch( PixelFormatGpuUtils::getEquivalentLinear( srcFormat ) )
+            {
+            case PFG_RGBA8_UNORM:
+                if( filters & TextureFilter::TypeCompressBCnPreferBC7 )
+                    dstFormat = PFG_BC7_UNORM;
+                else if( PixelFormatGpuUtils::getEquivalentLinear( image.getPixelFormat() ) ==
+                             PFG_RGBA8_UNORM &&
+                         hasTranslucentPixels( image ) )
+                {
+                    dstFormat = PFG_BC3_UNORM;
+                }
+                else
+                    dstFormat = PFG_BC1_UNORM;
+                break;
+            case PFG_RG8_UNORM:
+                dstFormat = PFG_BC5_UNORM;
+                break;
+            case PFG_RG8_SNORM:
+                dstFormat = PFG_BC5_SNORM;
+                break;
+            case PFG_R8_UNORM:
+                dstFormat = PFG_BC4_UNORM;
+                break;
+            case PFG_R8_SNORM:
+                dstFormat = PFG_BC4_SNORM;
+                break;
+            default:
+                return srcFormat;
+            }
+
+            if( PixelFormatGpuUtils::isSRgb( srcFormat ) )
+                dstFormat = PixelFormatGpuUtils::getEquivalentSRGB( dstFormat );
+
+            if( !textureManager->checkSupport( dstFormat, textureType, 0 ) )
+                return srcFormat;
+
+            return dstFormat;
+        }
+        //-----------------------------------------------------------------------------------
+        String CompressBCn::getCacheFilename( const Image2 &image, PixelFormatGpu dstFormat,
+                                              bool generateMipmaps )
+        {
+            // Everything that affects the output other than the pixels themselves
+            const uint32 key[] = { c_bcnCacheVersion,
+                                   static_cast<uint32>( image.getPixelFormat() ),
+                                   static_cast<uint32>( dstFormat ),
+                                   image.getWidth(),
+                                   image.getHeight(),
+                                   image.getDepthOrSlices(),
+                                   static_cast<uint32>( image.getTextureType() ),
+                                   image.getNumMipmaps(),
+                                   generateMipmaps ? 1u : 0u };
+            uint32 keyHash[4];
+            MurmurHash3_x86_128( key, static_cast<int>( sizeof( key ) ), IdString::Seed, keyHash );
+
+            uint32 hash[4];
+            MurmurHash3_x86_128( image.getData( 0 ).data, static_cast<int>( image.getSizeBytes() ),
+                                 keyHash[0] ^ keyHash[1] ^ keyHash[2] ^ keyHash[3], hash );
+
+            char filename[64];
+            snprintf( filename, sizeof( filename ), "%08x%08x%08x%08x.bcn", hash[0], hash[1], hash[2],
+                      hash[3] );
+            return filename;
+        }
+        //-----------------------------------------------------------------------------------
+        bool CompressBCn::loadFromCache( Archive *cache, const String &filename, Image2 &image,
+                                         PixelFormatGpu dstFormat )
+        {
+            ScopedLock lock( sBCnCacheMutex );
+
+            DataStreamPtr stream;
+            try
+            {
+                if( cache->exists( filename ) )
+                    stream = cache->open( filename );
+            }
+            catch( Exception &e )
+            {
+                LogManager::getSingleton().logMessage( e.getFullDescription(), LML_CRITICAL );
+            }
+
+            if( !stream )
+                return false;
+
+            uint32 header[8];
+            if( stream->read( header, sizeof( header ) ) != sizeof( header ) )
+                return false;
+
+            const uint32 maxMipmaps = PixelFormatGpuUtils::getMaxMipmapCount(
+                image.getWidth(), image.getHeight(), image.getDepth() );
+
+            if( header[0] != c_bcnCacheMagic || header[1] != c_bcnCacheVersion ||
+                header[2] != image.getWidth() || header[3] != image.getHeight() ||
+                header[4] != image.getDepthOrSlices() ||
+                header[5] != static_cast<uint32>( image.getTextureType() ) ||
+                header[6] != static_cast<uint32>( dstFormat ) || header[7] == 0u ||
+                header[7] > maxMipmaps )
+            {
+                LogManager::getSingleton().logMessage( "[WARNING] Ignoring invalid BCn cache entry " +
+                                                       filename );
+                return false;
+            }
+
+            const uint8 numMipmaps = static_cast<uint8>( header[7] );
+            const size_t sizeBytes = PixelFormatGpuUtils::calculateSizeBytes(
+                image.getWidth(), image.getHeight(), image.getDepth(), image.getNumSlices(),
+                dstFormat, numMipmaps, 4u );
+
+            void *data = OGRE_MALLOC_SIMD( sizeBytes, MEMCATEGORY_RESOURCE );
+            if( stream->read( data, sizeBytes ) != sizeBytes )
+            {
+                OGRE_FREE_SIMD( data, MEMCATEGORY_RESOURCE );
+                return false;
+            }
+
+            assert( image.getAutoDelete() && "This should be impossible. Memory will leak." );
+            image.loadDynamicImage( data, image.getWidth(), image.getHeight(), image.getDepthOrSlices(),
+                                    image.getTextureType(), dstFormat, true, numMipmaps );
+            return true;
+        }
+        //-----------------------------------------------------------------------------------
+        void CompressBCn::saveToCache( Archive *cache, const String &filename, const Image2 &image )
+        {
+            ScopedLock lock( sBCnCacheMutex );
+
+            try
+            {
+                DataStreamPtr stream = cache->create( filename );
+                const uint32 header[8] = { c_bcnCacheMagic,
+                                           c_bcnCacheVersion,
+                                           image.getWidth(),
+                                           image.getHeight(),
+                                           image.getDepthOrSlices(),
+                                           static_cast<uint32>( image.getTextureType() ),
+                                           static_cast<uint32>( image.getPixelFormat() ),
+                                           image.getNumMipmaps() };
+                stream->write( header, sizeof( header ) );
+                stream->write( image.getData( 0 ).data, image.getSizeBytes() );
+            }
+            catch( Exception &e )
+            {
+                LogManager::getSingleton().logMessage( e.getFullDescription(), LML_CRITICAL );
+            }
+        }
+        //-----------------------------------------------------------------------------------
+        void CompressBCn::_executeStreaming( Image2 &image, TextureGpu *texture )
+        {
+            OgreProfileExhaustive( "CompressBCn::_executeStreaming" );
+
+            const PixelFormatGpu srcFormat = image.getPixelFormat();
+
+            // If the texture is no longer OnStorage then its format has already been decided
+            // (by the metadata cache, or by the 1st face of a cubemap made of multiple images)
+            PixelFormatGpu dstFormat = texture->getPixelFormat();
+            if( !BCnEncoder::isSupported( srcFormat, dstFormat ) )
+            {
+                if( texture->getResidencyStatus() != GpuResidency::OnStorage )
+                    return;
+                dstFormat =
+                    getDestinationFormat( mFilters, image, dstFormat, texture->getTextureManager() );
+                if( !BCnEncoder::isSupported( srcFormat, dstFormat ) )
+                    return;
+            }
+
+            const Image2::Filter filter =
+                static_cast<Image2::Filter>( GenerateSwMipmaps::getFilter( image ) );
+            const bool generateMipmaps =
+                ( mFilters & TextureFilter::TypeGenerateDefaultMipmaps ) &&
+                image.getNumMipmaps() <= 1u &&
+                Image2::supportsSwMipmaps( srcFormat, image.getDepthOrSlices(),
+                                           image.getTextureType(), filter );
+
+            Archive *cache = texture->getTextureManager()->getBCnCompressionCache();
+            if( image.getSizeBytes() > static_cast<size_t>( std::numeric_limits<int>::max() ) )
+                cache = 0;  // Too big for our hash function
+
+            String cacheFilename;
+            bool loadedFromCache = false;
+            if( cache )
+            {
+                cacheFilename = getCacheFilename( image, dstFormat, generateMipmaps );
+                loadedFromCache = loadFromCache( cache, cacheFilename, image, dstFormat );
+            }
+
+            if( !loadedFromCache )
+            {
+                if( generateMipmaps )
+                {
+                    image.generateMipmaps( PixelFormatGpuUtils::isSRgb( dstFormat ), filter,
+                                           texture->getTextureManager() );
+                }
+
+                const uint8 numMipmaps = image.getNumMipmaps();
+
+                const size_t dstSizeBytes = PixelFormatGpuUtils::calculateSizeBytes(
+                    image.getWidth(), image.getHeight(), image.getDepth(), image.getNumSlices(),
+                    dstFormat, numMipmaps, 4u );
+
+                void *data = OGRE_MALLOC_SIMD( dstSizeBytes, MEMCATEGORY_RESOURCE );
+
+                Image2 dstImage;
+                dstImage.loadDynamicImage( data, image.getWidth(), image.getHeight(),
+                                           image.getDepthOrSlices(), image.getTextureType(),
+                                           dstFormat, false, numMipmaps );
+
+                for( uint8 mip = 0; mip < numMipmaps; ++mip )
+                {
+                    BCnEncoder::compress( image.getData( mip ), srcFormat, dstImage.getData( mip ),
+                                          dstFormat );
+                }
+
+                assert( image.getAutoDelete() && "This should be impossible. Memory will leak." );
+                image.loadDynamicImage( data, image.getWidth(), image.getHeight(),
+                                        image.getDepthOrSlices(), image.getTextureType(), dstFormat,
+                                        true, numMipmaps );
+
+                if( cache && !cache->isReadOnly() )
+                    saveToCache( cache, cacheFilename, image );
+            }
+
+            if( texture->getPixelFormat() != dstFormat )
+                texture->setPixelFormat( dstFormat );
+            if( texture->getNumMipmaps() != image.getNumMipmaps() )
+                texture->setNumMipmaps( image.getNumMipmaps() );
+        }
     }  // namespace TextureFilter
 }  // namespace Ogre
@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "OgreTextureBox.h"
 #include "OgreTextureGpuListener.h"
 #include "OgreTextureGpuManager.h"
+#include "OgreVector2.h"
 
 // Needed by _resolveTo
 #include "OgreRenderPassDescriptor.h"
@@ -280,6 +281,33 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     uint16 TextureGpu::getInternalSliceStart() const { return mInternalSliceStart; }
     //-----------------------------------------------------------------------------------
+    Vector2 TextureGpu::getInternalUvScale() const
+    {
+        if( !mTexturePool )
+            return Vector2::UNIT_SCALE;
+
+        const TextureGpu *masterTexture = mTexturePool->masterTexture;
+        if( mWidth == masterTexture->getWidth() && mHeight == masterTexture->getHeight() )
+            return Vector2::UNIT_SCALE;
+
+        // [0; 1] goes from the centre of the first texel to the centre of the last one
+        return Vector2( Real( mWidth - 1u ) / Real( masterTexture->getWidth() ),
+                        Real( mHeight - 1u ) / Real( masterTexture->getHeight() ) );
+    }
+    //-----------------------------------------------------------------------------------
+    Vector2 TextureGpu::getInternalUvOffset() const
+    {
+        if( !mTexturePool )
+            return Vector2::ZERO;
+
+        const TextureGpu *masterTexture = mTexturePool->masterTexture;
+        if( mWidth == masterTexture->getWidth() && mHeight == masterTexture->getHeight() )
+            return Vector2::ZERO;
+
+        return Vector2( Real( 0.5 ) / Real( masterTexture->getWidth() ),
+                        Real( 0.5 ) / Real( masterTexture->getHeight() ) );
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpu::_setSourceType( uint8 type ) { mSourceType = type; }
     //-----------------------------------------------------------------------------------
     uint8 TextureGpu::getSourceType() const { return mSourceType; }
@@ -831,6 +859,11 @@ namespace Ogre
         return ( mTextureFlags & TextureFlags::DiscardableContent ) != 0;
     }
     //-----------------------------------------------------------------------------------
+    bool TextureGpu::allowsAutoPacking() const
+    {
+        return ( mTextureFlags & TextureFlags::AllowAutoPacking ) != 0;
+    }
+    //-----------------------------------------------------------------------------------
     bool TextureGpu::isOpenGLRenderWindow() const { return false; }
     //-----------------------------------------------------------------------------------
     void TextureGpu::setOrientationMode( OrientationMode orientationMode )
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "OgreBitwise.h"
 #include "OgreCommon.h"
 #include "OgreException.h"
+#include "OgreFileSystem.h"
 #include "OgreHlmsDatablock.h"
 #include "OgreId.h"
 #include "OgreImage2.h"
@@ -57,6 +58,7 @@ THE SOFTWARE.
 #include "Vao/OgreVaoManager.h"
 
 #include <fstream>
+#include <thread>
 
 #if !OGRE_NO_JSON
 #    include "OgreStringConverter.h"
@@ -92,6 +94,12 @@ namespace Ogre
 
     static DefaultTextureGpuManagerListener sDefaultTextureGpuManagerListener;
 
+    /// Formats whose codecs can decode straight from a MemoryMappedDataStream
+    static bool isMemoryMappable( const String &filename )
+    {
+        return StringUtil::endsWith( filename, ".oitd" ) || StringUtil::endsWith( filename, ".dds" );
+    }
+
     unsigned long updateStreamingWorkerThread( ThreadHandle *threadHandle );
     THREAD_DECLARE( updateStreamingWorkerThread );
     unsigned long updateTextureMultiLoadWorkerThread( ThreadHandle *threadHandle );
@@ -119,6 +127,11 @@ namespace Ogre
 #else
         mStagingTextureMaxBudgetBytes( 128u * 1024u * 1024u ),
 #endif
+        mBCnCompressionCache( 0 ),
+        mPriorityStreaming( false ),
+        mStreamingVramBudget( 0u ),
+        mUseMemoryMappedFiles( false ),
+        mAutoPackingMaxResolution( 0u ),
         mDelayListenerCalls( false ),
         mIgnoreScheduledTasks( false ),
 #ifdef OGRE_PROFILING_TEXTURES
@@ -222,6 +235,13 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::destroyAll()
     {
+        // Must be done before the pools are gone
+        if( !mMetadataCacheFile.empty() )
+        {
+            saveTextureMetadataCacheBinary( mMetadataCacheFile );
+            mMetadataCacheFile.clear();
+        }
+
         mMutex.lock();
         abortAllRequests();
         destroyAllStagingBuffers();
@@ -578,6 +598,7 @@ namespace Ogre
             }
 
             itor->second.destroyRequested = true;
+            mTexturesEvictedByBudget.erase( texture );
 
             ScheduledTasks task;
             task.tasksType = TaskTypeDestroyTexture;
@@ -919,22 +940,31 @@ namespace Ogre
     bool TextureGpuManager::applyMetadataCacheTo( TextureGpu *texture )
     {
         bool retVal = false;
+        MetadataCacheEntry cacheEntry;
+
+        mEntriesMutex.lock();
         MetadataCacheMap::const_iterator itor = mMetadataCache.find( texture->getName() );
         if( itor != mMetadataCache.end() )
         {
-            MetadataCacheEntry cacheEntry = itor->second;
+            cacheEntry = itor->second;
+            retVal = true;
+        }
+        mEntriesMutex.unlock();
+
+        if( retVal )
+        {
             texture->setResolution( cacheEntry.width, cacheEntry.height, cacheEntry.depthOrSlices );
             texture->setNumMipmaps( cacheEntry.numMipmaps );
             texture->setTextureType( cacheEntry.textureType );
             texture->setPixelFormat( cacheEntry.pixelFormat );
             texture->setTexturePoolId( cacheEntry.poolId );
-            retVal = true;
         }
         return retVal;
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_updateMetadataCache( TextureGpu *texture )
     {
+        ScopedLock lock( mEntriesMutex );
         ResourceEntryMap::const_iterator itor = mEntries.find( texture->getName() );
 
         if( itor != mEntries.end() )
@@ -956,6 +986,7 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_removeMetadataCacheEntry( TextureGpu *texture )
     {
+        ScopedLock lock( mEntriesMutex );
         mMetadataCache.erase( texture->getName() );
     }
     //-----------------------------------------------------------------------------------
@@ -1074,7 +1105,9 @@ namespace Ogre
                             PixelFormatGpuUtils::getFormatFromName( itor->value.GetString() );
                     }
 
+                    mEntriesMutex.lock();
                     mMetadataCache[aliasName] = entry;
+                    mEntriesMutex.unlock();
                 }
 
                 ++itTex;
@@ -1127,6 +1160,8 @@ namespace Ogre
 
         jsonStr.a( "\n\t],\n\t\"textures\" :\n\t{" );
         firstIteration = true;
+
+        ScopedLock lock( mEntriesMutex );
         MetadataCacheMap::const_iterator itor = mMetadataCache.begin();
         MetadataCacheMap::const_iterator endt = mMetadataCache.end();
 
@@ -1160,6 +1195,277 @@ namespace Ogre
         jsonStr.clear();
     }
     //-----------------------------------------------------------------------------------
+    namespace
+    {
+        // Binary metadata cache layout:
+        //  BinaryMetadataHeader
+        //  BinaryMetadataPool[numPools]
+        //  BinaryMetadataTexture[numTextures]
+        //  char aliasNames[] (concatenated, not null terminated; see aliasLength)
+        static const uint32 c_metadataCacheMagic = 0x434D544F;  // OTMC
+        static const uint32 c_metadataCacheVersion = 1u;
+
+        struct BinaryMetadataHeader
+        {
+            uint32 magic;
+            uint32 version;
+            uint32 numPools;
+            uint32 numTextures;
+        };
+        struct BinaryMetadataPool
+        {
+            uint32 poolId;
+            uint32 width;
+            uint32 height;
+            uint32 depthOrSlices;
+            uint32 pixelFormat;
+            uint32 numMipmaps;
+        };
+        struct BinaryMetadataTexture
+        {
+            uint32 width;
+            uint32 height;
+            uint32 depthOrSlices;
+            uint32 poolId;
+            uint16 pixelFormat;
+            uint8  textureType;
+            uint8  numMipmaps;
+            uint32 aliasLength;
+        };
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::exportTextureMetadataCacheBinary( vector<uint8>::type &outData ) const
+    {
+        OgreProfileExhaustive( "TextureGpuManager::exportTextureMetadataCacheBinary" );
+
+        ScopedLock lock( mEntriesMutex );
+
+        BinaryMetadataHeader header;
+        header.magic = c_metadataCacheMagic;
+        header.version = c_metadataCacheVersion;
+        header.numPools = 0u;
+        header.numTextures = static_cast<uint32>( mMetadataCache.size() );
+
+        size_t aliasNamesBytes = 0u;
+        {
+            TexturePoolList::const_iterator itor = mTexturePool.begin();
+            TexturePoolList::const_iterator endt = mTexturePool.end();
+            while( itor != endt )
+            {
+                if( itor->manuallyReserved )
+                    ++header.numPools;
+                ++itor;
+            }
+
+            MetadataCacheMap::const_iterator itEntry = mMetadataCache.begin();
+            MetadataCacheMap::const_iterator enEntry = mMetadataCache.end();
+            while( itEntry != enEntry )
+            {
+                aliasNamesBytes += itEntry->second.aliasName.size();
+                ++itEntry;
+            }
+        }
+
+        outData.resize( sizeof( BinaryMetadataHeader ) +
+                        header.numPools * sizeof( BinaryMetadataPool ) +
+                        header.numTextures * sizeof( BinaryMetadataTexture ) + aliasNamesBytes );
+
+        uint8 *dstPtr = outData.data();
+        memcpy( dstPtr, &header, sizeof( header ) );
+        dstPtr += sizeof( header );
+
+        {
+            TexturePoolList::const_iterator itor = mTexturePool.begin();
+            TexturePoolList::const_iterator endt = mTexturePool.end();
+            while( itor != endt )
+            {
+                if( itor->manuallyReserved )
+                {
+                    const TextureGpu *masterTexture = itor->masterTexture;
+                    BinaryMetadataPool pool;
+                    pool.poolId = masterTexture->getTexturePoolId();
+                    pool.width = masterTexture->getWidth();
+                    pool.height = masterTexture->getHeight();
+                    pool.depthOrSlices = masterTexture->getDepthOrSlices();
+                    pool.pixelFormat = masterTexture->getPixelFormat();
+                    pool.numMipmaps = masterTexture->getNumMipmaps();
+                    memcpy( dstPtr, &pool, sizeof( pool ) );
+                    dstPtr += sizeof( pool );
+                }
+                ++itor;
+            }
+        }
+
+        uint8 *aliasNamesPtr = dstPtr + header.numTextures * sizeof( BinaryMetadataTexture );
+
+        MetadataCacheMap::const_iterator itor = mMetadataCache.begin();
+        MetadataCacheMap::const_iterator endt = mMetadataCache.end();
+        while( itor != endt )
+        {
+            const MetadataCacheEntry &entry = itor->second;
+            BinaryMetadataTexture texture;
+            texture.width = entry.width;
+            texture.height = entry.height;
+            texture.depthOrSlices = entry.depthOrSlices;
+            texture.poolId = entry.poolId;
+            texture.pixelFormat = static_cast<uint16>( entry.pixelFormat );
+            texture.textureType = static_cast<uint8>( entry.textureType );
+            texture.numMipmaps = entry.numMipmaps;
+            texture.aliasLength = static_cast<uint32>( entry.aliasName.size() );
+            memcpy( dstPtr, &texture, sizeof( texture ) );
+            dstPtr += sizeof( texture );
+
+            memcpy( aliasNamesPtr, entry.aliasName.c_str(), entry.aliasName.size() );
+            aliasNamesPtr += entry.aliasName.size();
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::importTextureMetadataCacheBinary( const void *data, size_t sizeBytes,
+                                                              bool bCreateReservedPools )
+    {
+        OgreProfileExhaustive( "TextureGpuManager::importTextureMetadataCacheBinary" );
+
+        const uint8 *srcPtr = reinterpret_cast<const uint8 *>( data );
+
+        BinaryMetadataHeader header;
+        if( sizeBytes < sizeof( header ) )
+            return false;
+        memcpy( &header, srcPtr, sizeof( header ) );
+
+        const size_t recordsBytes = sizeof( header ) +
+                                    size_t( header.numPools ) * sizeof( BinaryMetadataPool ) +
+                                    size_t( header.numTextures ) * sizeof( BinaryMetadataTexture );
+
+        if( header.magic != c_metadataCacheMagic || header.version != c_metadataCacheVersion ||
+            recordsBytes > sizeBytes )
+        {
+            return false;
+        }
+
+        const uint8 *poolsPtr = srcPtr + sizeof( header );
+        const uint8 *texturesPtr = poolsPtr + header.numPools * sizeof( BinaryMetadataPool );
+        const char *aliasNamesPtr = reinterpret_cast<const char *>( srcPtr + recordsBytes );
+
+        // Validate the alias names fit before touching anything
+        size_t aliasNamesBytes = 0u;
+        for( uint32 i = 0u; i < header.numTextures; ++i )
+        {
+            BinaryMetadataTexture texture;
+            memcpy( &texture, texturesPtr + i * sizeof( texture ), sizeof( texture ) );
+            aliasNamesBytes += texture.aliasLength;
+        }
+        if( aliasNamesBytes > sizeBytes - recordsBytes )
+            return false;
+
+        if( bCreateReservedPools )
+        {
+            for( uint32 i = 0u; i < header.numPools; ++i )
+            {
+                BinaryMetadataPool pool;
+                memcpy( &pool, poolsPtr + i * sizeof( pool ), sizeof( pool ) );
+
+                const PixelFormatGpu pixelFormat = static_cast<PixelFormatGpu>( pool.pixelFormat );
+                const uint8 numMipmaps = static_cast<uint8>( pool.numMipmaps );
+                if( pool.width > 0u && pool.height > 0u && pool.depthOrSlices > 0u &&
+                    pixelFormat != PFG_UNKNOWN && pixelFormat < PFG_COUNT &&
+                    !hasPoolId( pool.poolId, pool.width, pool.height, numMipmaps, pixelFormat ) )
+                {
+                    reservePoolId( pool.poolId, pool.width, pool.height, pool.depthOrSlices,
+                                   numMipmaps, pixelFormat );
+                }
+            }
+        }
+
+        ScopedLock lock( mEntriesMutex );
+
+        // Entries were written sorted by key. When the cache was empty (the common case, at
+        // startup) each one goes right after the last one; inserting with that hint is O(1).
+        // Otherwise fall back to a O(log N) search.
+        for( uint32 i = 0u; i < header.numTextures; ++i )
+        {
+            BinaryMetadataTexture texture;
+            memcpy( &texture, texturesPtr + i * sizeof( texture ), sizeof( texture ) );
+
+            MetadataCacheEntry entry;
+            entry.aliasName.assign( aliasNamesPtr, texture.aliasLength );
+            entry.width = texture.width;
+            entry.height = texture.height;
+            entry.depthOrSlices = texture.depthOrSlices;
+            entry.pixelFormat = static_cast<PixelFormatGpu>(
+                std::min<uint32>( texture.pixelFormat, PFG_COUNT - 1u ) );
+            entry.poolId = texture.poolId;
+            entry.textureType = static_cast<TextureTypes::TextureTypes>(
+                std::min<uint32>( texture.textureType, TextureTypes::Type3D ) );
+            entry.numMipmaps = texture.numMipmaps;
+            aliasNamesPtr += texture.aliasLength;
+
+            const IdString aliasName( entry.aliasName );
+            if( mMetadataCache.empty() || mMetadataCache.rbegin()->first < aliasName )
+            {
+                mMetadataCache.insert( mMetadataCache.end(),
+                                       MetadataCacheMap::value_type( aliasName, entry ) );
+            }
+            else
+            {
+                MetadataCacheMap::iterator itor = mMetadataCache.lower_bound( aliasName );
+                if( itor != mMetadataCache.end() && itor->first == aliasName )
+                    itor->second = entry;
+                else
+                    mMetadataCache.insert( itor, MetadataCacheMap::value_type( aliasName, entry ) );
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::loadTextureMetadataCacheBinary( const String &fullPath,
+                                                            bool bCreateReservedPools )
+    {
+        MemoryMappedDataStream stream( fullPath, fullPath );
+        if( !stream.isMapped() )
+            return false;
+
+        const bool retVal =
+            importTextureMetadataCacheBinary( stream.getPtr(), stream.size(), bCreateReservedPools );
+        if( !retVal )
+        {
+            LogManager::getSingleton().logMessage( "[WARNING] Ignoring invalid or out of date " +
+                                                   fullPath + " texture metadata cache" );
+        }
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::saveTextureMetadataCacheBinary( const String &fullPath ) const
+    {
+        vector<uint8>::type data;
+        exportTextureMetadataCacheBinary( data );
+
+        std::ofstream outFile( fullPath.c_str(), std::ios::binary | std::ios::out );
+        if( outFile.is_open() )
+        {
+            outFile.write( reinterpret_cast<const char *>( data.data() ),
+                           static_cast<std::streamsize>( data.size() ) );
+            outFile.close();
+        }
+
+        if( !outFile )
+        {
+            LogManager::getSingleton().logMessage(
+                "[WARNING] Could not write texture metadata cache to " + fullPath );
+            return false;
+        }
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setTextureMetadataCacheFile( const String &fullPath,
+                                                         bool bCreateReservedPools )
+    {
+        mMetadataCacheFile = fullPath;
+        if( !fullPath.empty() )
+            loadTextureMetadataCacheBinary( fullPath, bCreateReservedPools );
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::getMemoryStats( size_t &outTextureBytesCpu, size_t &outTextureBytesGpu,
                                             size_t &outUsedStagingTextureBytes,
                                             size_t &outAvailableStagingTextureBytes )
@@ -1395,6 +1701,48 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::HelperTask::runChunks()
+    {
+        size_t chunkIdx = nextChunk.fetch_add( 1u, std::memory_order_relaxed );
+        while( chunkIdx < numChunks )
+        {
+            task->execute( chunkIdx, numChunks );
+            chunkIdx = nextChunk.fetch_add( 1u, std::memory_order_relaxed );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::executeUniformScalableTask( UniformScalableTask *task, size_t numChunks )
+    {
+        if( !mUseMultiload.load( std::memory_order_relaxed ) || numChunks <= 1u )
+        {
+            for( size_t i = 0u; i < numChunks; ++i )
+                task->execute( i, numChunks );
+            return;
+        }
+
+        HelperTask helperTask( task, numChunks );
+
+        mMultiLoadsMutex.lock();
+        helperTask.wakeTickets = static_cast<uint32>(
+            std::min<size_t>( numChunks - 1u, mMultiLoadWorkerThreads.size() ) );
+        mHelperTasks.push_back( &helperTask );
+        mMultiLoadsMutex.unlock();
+        mMultiLoadsSemaphore.increment( helperTask.wakeTickets );
+
+        helperTask.runChunks();
+
+        // Stop new helpers from joining. Tickets not consumed become spurious wakeups.
+        mMultiLoadsMutex.lock();
+        FastArray<HelperTask *>::iterator itor =
+            std::find( mHelperTasks.begin(), mHelperTasks.end(), &helperTask );
+        efficientVectorRemove( mHelperTasks, itor );
+        mMultiLoadsMutex.unlock();
+
+        // Wait for helpers still executing their last chunk. They hold no locks.
+        while( helperTask.numHelpers.load( std::memory_order_acquire ) != 0u )
+            std::this_thread::yield();
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::setWorkerThreadMinimumBudget( const BudgetEntryVec &budget,
                                                           uint32 maxSplitResolution )
     {
@@ -1456,6 +1804,228 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::resetLoadingStats() { mLoadingStats.reset(); }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_addLoadingStageTime( TextureGpu *texture,
+                                                  TextureLoadStage::TextureLoadStage stage,
+                                                  uint64 microseconds )
+    {
+#ifdef OGRE_PROFILING_TEXTURES
+        if( !mProfilingLoadingTime )
+            return;
+
+        std::map<IdString, ProfilingEntry>::iterator itor = mProfilingData.find( texture->getName() );
+        if( itor != mProfilingData.end() )
+            itor->second.usStages[stage] += microseconds;
+#endif
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::sampleLoadingStats( size_t pendingLoadRequests )
+    {
+        const size_t numQueuedImages = mStreamingData.queuedImages.size();
+        if( pendingLoadRequests == 0u && numQueuedImages == 0u && !mStreamingData.workerThreadRan )
+            return;  // Nothing is streaming. Don't skew the averages
+
+        const size_t stagingBytes = getConsumedMemoryByStagingTextures( mAvailableStagingTextures ) +
+                                    getConsumedMemoryByStagingTextures( mUsedStagingTextures );
+
+        LoadingStats &stats = mLoadingStats;
+        stats.maxPendingLoadRequests = std::max( stats.maxPendingLoadRequests, pendingLoadRequests );
+        stats.maxQueuedImages = std::max( stats.maxQueuedImages, numQueuedImages );
+        stats.maxStagingTextureBytes = std::max( stats.maxStagingTextureBytes, stagingBytes );
+        stats.accumStagingTextureBytes += stagingBytes;
+        stats.stagingTextureMaxBudgetBytes = mStagingTextureMaxBudgetBytes;
+        stats.maxPreloadedBytes = std::max( stats.maxPreloadedBytes, mStreamingData.bytesPreloaded );
+        stats.accumPreloadedBytes += mStreamingData.bytesPreloaded;
+        stats.maxPreloadBytes = mMaxPreloadBytes;
+        ++stats.numSamples;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::dumpLoadingStatsStr( String &outCsvPerTexture, String &outCsvAccum ) const
+    {
+        static const char *c_stageNames[TextureLoadStage::NumTextureLoadStages] = {
+            "FileIo", "Decode", "Filters", "StagingCopy", "GpuUpload", "Waiting"
+        };
+
+        char tmpBuffer[512];
+        LwString tmpStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        {
+            String csvString;
+            csvString += "Name";
+            for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+                csvString += String( "|" ) + c_stageNames[i];
+            csvString += "|Total|Bytes\n";
+
+            TextureLoadTimingsVec::const_iterator itor = mLoadingStats.textures.begin();
+            TextureLoadTimingsVec::const_iterator endt = mLoadingStats.textures.end();
+
+            while( itor != endt )
+            {
+                csvString += itor->name;
+                tmpStr.clear();
+                for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+                    tmpStr.a( "|", LwString::Float( (float)( (double)itor->usStages[i] / 1000.0 ), 2 ) );
+                tmpStr.a( "|", LwString::Float( (float)( (double)itor->usTotal / 1000.0 ), 2 ) );
+                tmpStr.a( "|", (uint64)itor->sizeBytes, "\n" );
+                csvString += tmpStr.c_str();
+                ++itor;
+            }
+
+            outCsvPerTexture.swap( csvString );
+        }
+
+        {
+            String csvString;
+            csvString += "Name|Milliseconds|%\n";
+
+            uint64 usAccum = 0u;
+            for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+                usAccum += mLoadingStats.usStagesAccum[i];
+
+            for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+            {
+                const uint64 usTaken = mLoadingStats.usStagesAccum[i];
+                const double percentage =
+                    usAccum ? ( 100.0 * ( (double)usTaken / (double)usAccum ) ) : 0.0;
+                tmpStr.clear();
+                tmpStr.a( c_stageNames[i], "|", LwString::Float( (float)( usTaken / 1000.0 ), 2 ), "|",
+                          LwString::Float( (float)percentage, 2 ), "%\n" );
+                csvString += tmpStr.c_str();
+            }
+
+            outCsvAccum.swap( csvString );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::dumpLoadingStatsJson( String &outJson ) const
+    {
+        static const char *c_stageNames[TextureLoadStage::NumTextureLoadStages] = {
+            "file_io", "decode", "filters", "staging_copy", "gpu_upload", "waiting"
+        };
+
+        char tmpBuffer[512];
+        LwString tmpStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        const LoadingStats &stats = mLoadingStats;
+        const uint32 numSamples = std::max( stats.numSamples, 1u );
+
+        String jsonStr;
+        jsonStr += "{\n";
+
+        tmpStr.clear();
+        tmpStr.a( "\t\"num_textures\" : ", (uint64)stats.textures.size(), ",\n" );
+        tmpStr.a( "\t\"total_ms\" : ", LwString::Float( (float)( stats.usTotalAccum / 1000.0 ), 2 ),
+                  ",\n" );
+        jsonStr += tmpStr.c_str();
+
+        jsonStr += "\t\"stages_ms\" :\n\t{";
+        for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+        {
+            tmpStr.clear();
+            tmpStr.a( i ? "," : "", "\n\t\t\"", c_stageNames[i], "\" : ",
+                      LwString::Float( (float)( stats.usStagesAccum[i] / 1000.0 ), 2 ) );
+            jsonStr += tmpStr.c_str();
+        }
+        jsonStr += "\n\t},\n";
+
+        tmpStr.clear();
+        tmpStr.a( "\t\"queues\" :\n\t{\n" );
+        tmpStr.a( "\t\t\"max_pending_load_requests\" : ", (uint64)stats.maxPendingLoadRequests,
+                  ",\n" );
+        tmpStr.a( "\t\t\"max_queued_images\" : ", (uint64)stats.maxQueuedImages, "\n\t},\n" );
+        jsonStr += tmpStr.c_str();
+
+        tmpStr.clear();
+        tmpStr.a( "\t\"staging\" :\n\t{\n" );
+        tmpStr.a( "\t\t\"budget_bytes\" : ", (uint64)stats.stagingTextureMaxBudgetBytes, ",\n" );
+        tmpStr.a( "\t\t\"max_bytes\" : ", (uint64)stats.maxStagingTextureBytes, ",\n" );
+        tmpStr.a( "\t\t\"avg_bytes\" : ", stats.accumStagingTextureBytes / numSamples, ",\n" );
+        tmpStr.a( "\t\t\"preload_budget_bytes\" : ", (uint64)stats.maxPreloadBytes, ",\n" );
+        tmpStr.a( "\t\t\"max_preloaded_bytes\" : ", (uint64)stats.maxPreloadedBytes, ",\n" );
+        tmpStr.a( "\t\t\"avg_preloaded_bytes\" : ", stats.accumPreloadedBytes / numSamples, ",\n" );
+        tmpStr.a( "\t\t\"num_samples\" : ", stats.numSamples, "\n\t},\n" );
+        jsonStr += tmpStr.c_str();
+
+        jsonStr += "\t\"textures\" :\n\t[";
+
+        TextureLoadTimingsVec::const_iterator itor = stats.textures.begin();
+        TextureLoadTimingsVec::const_iterator endt = stats.textures.end();
+
+        while( itor != endt )
+        {
+            jsonStr += itor == stats.textures.begin() ? "\n\t\t{\n" : ",\n\t\t{\n";
+
+            // Escape the name, it's a path
+            jsonStr += "\t\t\t\"name\" : \"";
+            String::const_iterator itChar = itor->name.begin();
+            String::const_iterator enChar = itor->name.end();
+            while( itChar != enChar )
+            {
+                if( *itChar == '"' || *itChar == '\\' )
+                    jsonStr.push_back( '\\' );
+                if( static_cast<unsigned char>( *itChar ) >= 0x20u )
+                    jsonStr.push_back( *itChar );
+                ++itChar;
+            }
+            jsonStr += "\",\n";
+
+            for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+            {
+                tmpStr.clear();
+                tmpStr.a( "\t\t\t\"", c_stageNames[i], "_ms\" : ",
+                          LwString::Float( (float)( itor->usStages[i] / 1000.0 ), 2 ), ",\n" );
+                jsonStr += tmpStr.c_str();
+            }
+
+            tmpStr.clear();
+            tmpStr.a( "\t\t\t\"total_ms\" : ", LwString::Float( (float)( itor->usTotal / 1000.0 ), 2 ),
+                      ",\n" );
+            tmpStr.a( "\t\t\t\"bytes\" : ", (uint64)itor->sizeBytes, "\n\t\t}" );
+            jsonStr += tmpStr.c_str();
+            ++itor;
+        }
+
+        jsonStr += "\n\t]\n}\n";
+
+        outJson.swap( jsonStr );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::dumpLoadingStats( const String &fullPathPerTexture,
+                                              const String &fullPathAccum,
+                                              const String &fullPathJson ) const
+    {
+        String csvStringPerTexture;
+        String csvStringAccum;
+        dumpLoadingStatsStr( csvStringPerTexture, csvStringAccum );
+
+        if( !fullPathPerTexture.empty() )
+        {
+            std::ofstream outFile( fullPathPerTexture.c_str(), std::ios::binary | std::ios::out );
+            outFile.write( csvStringPerTexture.c_str(),
+                           static_cast<std::streamsize>( csvStringPerTexture.size() ) );
+            outFile.close();
+        }
+
+        if( !fullPathAccum.empty() )
+        {
+            std::ofstream outFile( fullPathAccum.c_str(), std::ios::binary | std::ios::out );
+            outFile.write( csvStringAccum.c_str(),
+                           static_cast<std::streamsize>( csvStringAccum.size() ) );
+            outFile.close();
+        }
+
+        if( !fullPathJson.empty() )
+        {
+            String jsonString;
+            dumpLoadingStatsJson( jsonString );
+
+            std::ofstream outFile( fullPathJson.c_str(), std::ios::binary | std::ios::out );
+            outFile.write( jsonString.c_str(), static_cast<std::streamsize>( jsonString.size() ) );
+            outFile.close();
+        }
+    }
+    //-----------------------------------------------------------------------------------
     const String *TextureGpuManager::findAliasNameStr( IdString idName ) const
     {
         const String *retVal = 0;
@@ -1641,19 +2211,41 @@ namespace Ogre
             switch( reason )
             {
             case TextureGpuListener::GainedResidency:
-                mProfilingData[texture->getName()] = Ogre::Timer();
+                mProfilingData[texture->getName()] = ProfilingEntry();
                 break;
             case TextureGpuListener::ReadyForRendering:
             {
-                std::map<IdString, Timer>::iterator itor = mProfilingData.find( texture->getName() );
+                std::map<IdString, ProfilingEntry>::iterator itor =
+                    mProfilingData.find( texture->getName() );
                 if( itor != mProfilingData.end() )
                 {
-                    uint64 timeMs = itor->second.getMilliseconds();
+                    const uint64 usTotal = itor->second.timer.getMicroseconds();
+                    uint64 timeMs = usTotal / 1000u;
                     LogManager::getSingleton().logMessage(
                         "[LATENCY PROFILE] Took " + std::to_string( timeMs ) +
                         " ms to go from Resident to Ready. Actual loading time may be lower if system "
                         "was occupied with another texture. Texture: " +
                         texture->getNameStr() );
+
+                    TextureLoadTimings timings;
+                    timings.name = texture->getNameStr();
+                    timings.usTotal = usTotal;
+                    timings.sizeBytes = texture->getSizeBytes();
+                    memcpy( timings.usStages, itor->second.usStages, sizeof( timings.usStages ) );
+
+                    uint64 usAccounted = 0u;
+                    for( size_t i = 0u; i < TextureLoadStage::Waiting; ++i )
+                        usAccounted += timings.usStages[i];
+                    timings.usStages[TextureLoadStage::Waiting] =
+                        usTotal > usAccounted ? ( usTotal - usAccounted ) : 0u;
+
+                    for( size_t i = 0u; i < TextureLoadStage::NumTextureLoadStages; ++i )
+                        mLoadingStats.usStagesAccum[i] += timings.usStages[i];
+                    mLoadingStats.usTotalAccum += usTotal;
+                    mLoadingStats.textures.push_back( timings );
+
+                    // Don't count it twice if it gets ReadyForRendering again (e.g. reuploads)
+                    mProfilingData.erase( itor );
                 }
                 break;
             }
@@ -2094,6 +2686,200 @@ namespace Ogre
         return mDefaultMipmapGenCubemaps;
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setBCnCompressionCache( Archive *cache ) { mBCnCompressionCache = cache; }
+    //-----------------------------------------------------------------------------------
+    namespace
+    {
+        struct LruTextureCmp
+        {
+            bool operator()( const TextureGpu *a, const TextureGpu *b ) const
+            {
+                return TextureGpuManager::_isPagedOutBefore( *a, *b );
+            }
+        };
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setPriorityStreaming( bool bEnabled, size_t vramBudgetBytes )
+    {
+        mPriorityStreaming = bEnabled;
+        mStreamingVramBudget = bEnabled ? vramBudgetBytes : 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setUseMemoryMappedFiles( bool bUseMemoryMappedFiles )
+    {
+        mUseMemoryMappedFiles = bUseMemoryMappedFiles;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setAutoPackingMaxResolution( uint32 maxResolution )
+    {
+        mAutoPackingMaxResolution = maxResolution;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_getPoolResolutionFor( uint32 width, uint32 height, uint8 numMipmaps,
+                                                   bool allowAutoPacking,
+                                                   uint32 autoPackingMaxResolution, uint32 &outWidth,
+                                                   uint32 &outHeight )
+    {
+        outWidth = width;
+        outHeight = height;
+
+        // Every mip must cover the same proportion of the pool's mip, otherwise the
+        // UV transform would only be right for some of them
+        const uint32 mipAlignment = numMipmaps > 1u ? 1u << ( numMipmaps - 1u ) : 1u;
+
+        if( allowAutoPacking && width <= autoPackingMaxResolution &&
+            height <= autoPackingMaxResolution && ( width % mipAlignment ) == 0u &&
+            ( height % mipAlignment ) == 0u )
+        {
+            outWidth = Bitwise::firstPO2From( width );
+            outHeight = Bitwise::firstPO2From( height );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::_isPoolCompatible( uint32 poolWidth, uint32 poolHeight,
+                                               uint8 poolNumMipmaps, uint32 width, uint32 height,
+                                               uint8 numMipmaps, bool allowAutoPacking,
+                                               uint32 autoPackingMaxResolution )
+    {
+        // Pools never get more mips than their textures, otherwise the extra ones
+        // would be left uninitialized
+        if( poolNumMipmaps != numMipmaps )
+            return false;
+        if( poolWidth == width && poolHeight == height )
+            return true;
+
+        uint32 packedWidth, packedHeight;
+        _getPoolResolutionFor( width, height, numMipmaps, allowAutoPacking, autoPackingMaxResolution,
+                               packedWidth, packedHeight );
+        return poolWidth == packedWidth && poolHeight == packedHeight;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_padPackedTexture( const TextureBox &box, uint32 usedWidth,
+                                               uint32 usedHeight )
+    {
+        OGRE_ASSERT_LOW( !box.isCompressed() && box.getDepthOrSlices() == 1u );
+        OGRE_ASSERT_LOW( usedWidth > 0u && usedWidth <= box.width );
+        OGRE_ASSERT_LOW( usedHeight > 0u && usedHeight <= box.height );
+
+        const size_t bytesPerPixel = box.bytesPerPixel;
+        const uint32 z = box.getZOrSlice();
+
+        for( uint32 y = 0u; y < usedHeight; ++y )
+        {
+            const uint8 *edge = reinterpret_cast<const uint8 *>( box.at( usedWidth - 1u, y, z ) );
+            uint8 *dst = reinterpret_cast<uint8 *>( box.at( usedWidth, y, z ) );
+            for( uint32 x = usedWidth; x < box.width; ++x )
+            {
+                memcpy( dst, edge, bytesPerPixel );
+                dst += bytesPerPixel;
+            }
+        }
+
+        const void *lastRow = box.at( 0u, usedHeight - 1u, z );
+        for( uint32 y = usedHeight; y < box.height; ++y )
+            memcpy( box.at( 0u, y, z ), lastRow, bytesPerPixel * box.width );
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::canAutoPack( const TextureGpu *texture )
+    {
+        // The padding is written from the staging texture only, thus a system RAM copy
+        // would be missing it. Compressed blocks can't repeat single texels.
+        return texture->hasAutomaticBatching() && texture->allowsAutoPacking() &&
+               !PixelFormatGpuUtils::isCompressed( texture->getPixelFormat() ) &&
+               texture->getGpuPageOutStrategy() != GpuPageOutStrategy::AlwaysKeepSystemRamCopy;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::StreamingPriorityCmp::operator()( const TextureGpu *a,
+                                                              const TextureGpu *b ) const
+    {
+        return _isStreamedBefore( *a, *b, frameCount );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::sortStreamingByPriority()
+    {
+        OgreProfileExhaustive( "TextureGpuManager::sortStreamingByPriority" );
+
+        // Stable so that textures made from multiple images (e.g. cubemaps from 6 files)
+        // and textures no one reported keep their order.
+        const StreamingPriorityCmp cmp( mVaoManager->getFrameCount() );
+        LoadRequestVec &loadRequests = mThreadData[c_workerThread].loadRequests;
+        std::stable_sort( loadRequests.begin(), loadRequests.end(), cmp );
+        std::stable_sort( mStreamingData.queuedImages.begin(), mStreamingData.queuedImages.end(),
+                          cmp );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::enforceStreamingVramBudget()
+    {
+        OgreProfileExhaustive( "TextureGpuManager::enforceStreamingVramBudget" );
+
+        const uint32 frameCount = mVaoManager->getFrameCount();
+
+        // Bring back paged out textures that are being used again
+        set<TextureGpu *>::type::iterator itEvicted = mTexturesEvictedByBudget.begin();
+        set<TextureGpu *>::type::iterator enEvicted = mTexturesEvictedByBudget.end();
+        while( itEvicted != enEvicted )
+        {
+            TextureGpu *texture = *itEvicted;
+            if( frameCount - texture->getLastFrameUsed() <= 1u )
+            {
+                texture->scheduleTransitionTo( GpuResidency::Resident );
+                mTexturesEvictedByBudget.erase( itEvicted++ );
+            }
+            else
+            {
+                ++itEvicted;
+            }
+        }
+
+        size_t residentBytes = 0u;
+        vector<TextureGpu *>::type candidates;
+
+        mEntriesMutex.lock();
+        ResourceEntryMap::const_iterator itor = mEntries.begin();
+        ResourceEntryMap::const_iterator endt = mEntries.end();
+        while( itor != endt )
+        {
+            TextureGpu *texture = itor->second.texture;
+            if( texture->getNextResidencyStatus() == GpuResidency::Resident &&
+                !texture->isManualTexture() )
+            {
+                residentBytes += texture->getSizeBytes();
+
+                // Only page out what is fully loaded, was reported by the user at some point,
+                // and wasn't used in the last 2 frames
+                if( !itor->second.destroyRequested &&
+                    texture->getResidencyStatus() == GpuResidency::Resident &&
+                    texture->getPendingResidencyChanges() == 0u && texture->isDataReady() &&
+                    _isPageOutCandidate( *texture, frameCount ) )
+                {
+                    candidates.push_back( texture );
+                }
+            }
+            ++itor;
+        }
+        mEntriesMutex.unlock();
+
+        if( residentBytes <= mStreamingVramBudget )
+            return;
+
+        // Least recently used first. On ties, farthest first.
+        std::sort( candidates.begin(), candidates.end(), LruTextureCmp() );
+
+        vector<TextureGpu *>::type::const_iterator itCandidate = candidates.begin();
+        vector<TextureGpu *>::type::const_iterator enCandidate = candidates.end();
+        while( itCandidate != enCandidate && residentBytes > mStreamingVramBudget )
+        {
+            TextureGpu *texture = *itCandidate;
+            residentBytes -= std::min( residentBytes, texture->getSizeBytes() );
+            if( texture->getGpuPageOutStrategy() == GpuPageOutStrategy::Discard )
+                texture->scheduleTransitionTo( GpuResidency::OnStorage );
+            else
+                texture->scheduleTransitionTo( GpuResidency::OnSystemRam );
+            mTexturesEvictedByBudget.insert( texture );
+            ++itCandidate;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::setAllowMemoryless( const bool bAllowMemoryLess )
     {
         if( !mRenderSystem->getCapabilities()->hasCapability( RSC_IS_TILER ) )
@@ -2113,6 +2899,12 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_reserveSlotForTexture( TextureGpu *texture )
     {
+        const bool allowAutoPacking = canAutoPack( texture );
+
+        uint32 poolWidth, poolHeight;
+        _getPoolResolutionFor( texture->getWidth(), texture->getHeight(), texture->getNumMipmaps(),
+                               allowAutoPacking, mAutoPackingMaxResolution, poolWidth, poolHeight );
+
         bool matchFound = false;
 
         TexturePoolList::iterator itor = mTexturePool.begin();
@@ -2122,11 +2914,14 @@ namespace Ogre
         {
             const TexturePool &pool = *itor;
 
-            matchFound = pool.hasFreeSlot() && pool.masterTexture->getWidth() == texture->getWidth() &&
-                         pool.masterTexture->getHeight() == texture->getHeight() &&
+            matchFound = pool.hasFreeSlot() &&
                          pool.masterTexture->getPixelFormat() == texture->getPixelFormat() &&
-                         pool.masterTexture->getNumMipmaps() == texture->getNumMipmaps() &&
-                         pool.masterTexture->getTexturePoolId() == texture->getTexturePoolId();
+                         pool.masterTexture->getTexturePoolId() == texture->getTexturePoolId() &&
+                         _isPoolCompatible( pool.masterTexture->getWidth(),
+                                            pool.masterTexture->getHeight(),
+                                            pool.masterTexture->getNumMipmaps(), texture->getWidth(),
+                                            texture->getHeight(), texture->getNumMipmaps(),
+                                            allowAutoPacking, mAutoPackingMaxResolution );
 
             TODO_grow_pool;
 
@@ -2153,7 +2948,7 @@ namespace Ogre
             newPool.usedMemory = 0;
             newPool.usedSlots.reserve( numSlices );
 
-            newPool.masterTexture->setResolution( texture->getWidth(), texture->getHeight(), numSlices );
+            newPool.masterTexture->setResolution( poolWidth, poolHeight, numSlices );
             newPool.masterTexture->setPixelFormat( texture->getPixelFormat() );
             newPool.masterTexture->setNumMipmaps( texture->getNumMipmaps() );
             newPool.masterTexture->setTexturePoolId( texture->getTexturePoolId() );
@@ -2580,10 +3375,24 @@ namespace Ogre
         const uint8 firstMip = queuedImage.getMinMipLevel();
         const uint8 numMips = queuedImage.getMaxMipLevelPlusOne();
 
+        // The pool isn't known yet, but if the texture gets packed it will be this big.
+        // UploadFromStagingTex only uploads the padding if it really was packed.
+        uint32 packedWidth = texture->getWidth();
+        uint32 packedHeight = texture->getHeight();
+        if( !is3DVolume && canAutoPack( texture ) )
+        {
+            _getPoolResolutionFor( texture->getWidth(), texture->getHeight(),
+                                   texture->getNumMipmaps(), true,
+                                   texture->getTextureManager()->getAutoPackingMaxResolution(),
+                                   packedWidth, packedHeight );
+        }
+
         for( uint8 i = firstMip; i < numMips; ++i )
         {
             TextureBox srcBox = img.getData( i );
             const uint32 imgDepthOrSlices = srcBox.getDepthOrSlices();
+            const uint32 paddedWidth = std::max( 1u, packedWidth >> i );
+            const uint32 paddedHeight = std::max( 1u, packedHeight >> i );
 
             OGRE_ASSERT_MEDIUM( imgDepthOrSlices < std::numeric_limits<uint8>::max() );
 
@@ -2596,13 +3405,35 @@ namespace Ogre
                     srcBox.depth = 1u;
                     srcBox.numSlices = 1u;
 
+                    const bool padded = srcBox.width != paddedWidth || srcBox.height != paddedHeight;
+                    TextureBox paddedBox = srcBox;
+                    paddedBox.width = paddedWidth;
+                    paddedBox.height = paddedHeight;
+
                     StagingTexture *stagingTexture = 0;
-                    TextureBox dstBox = getStreaming( workerData, streamingData, srcBox,
+                    TextureBox dstBox = getStreaming( workerData, streamingData,
+                                                      padded ? paddedBox : srcBox,
                                                       img.getPixelFormat(), &stagingTexture );
                     if( dstBox.data )
                     {
                         // Upload to staging area. CPU -> GPU
-                        dstBox.copyFrom( srcBox );
+#ifdef OGRE_PROFILING_TEXTURES
+                        Timer copyTimer;
+#endif
+                        if( !padded )
+                            dstBox.copyFrom( srcBox );
+                        else
+                        {
+                            TextureBox usedBox = dstBox;
+                            usedBox.width = srcBox.width;
+                            usedBox.height = srcBox.height;
+                            usedBox.copyFrom( srcBox );
+                            _padPackedTexture( dstBox, srcBox.width, srcBox.height );
+                        }
+#ifdef OGRE_PROFILING_TEXTURES
+                        queuedImage.usStages[TextureLoadStage::StagingCopy] +=
+                            copyTimer.getMicroseconds();
+#endif
                         if( queuedImage.dstSliceOrDepth != std::numeric_limits<uint32>::max() )
                         {
                             if( !is3DVolume )
@@ -2625,6 +3456,17 @@ namespace Ogre
 
         if( queuedImage.empty() )
         {
+#ifdef OGRE_PROFILING_TEXTURES
+            // Must be added before NotifyDataIsReady, so that the timings
+            // are known by the time the texture becomes ReadyForRendering
+            queuedImage.microsecondsTaken += profilingTimer.getMicroseconds();
+            ObjCmdBuffer::LogProfilingData *profilingCmd =
+                commandBuffer->addCommand<ObjCmdBuffer::LogProfilingData>();
+            new( profilingCmd )
+                ObjCmdBuffer::LogProfilingData( texture, queuedImage.dstSliceOrDepth,
+                                                queuedImage.microsecondsTaken, queuedImage.usStages );
+#endif
+
             // We're done uploading this image. Time to run NotifyDataIsReady,
             // unless there's more QueuedImage like us because the Texture is
             // being loaded from multiple files.
@@ -2657,14 +3499,6 @@ namespace Ogre
                 TextureFilter::FilterBase::destroyFilters( queuedImage.filters );
             }
 
-#ifdef OGRE_PROFILING_TEXTURES
-            queuedImage.microsecondsTaken += profilingTimer.getMicroseconds();
-            ObjCmdBuffer::LogProfilingData *cmd =
-                commandBuffer->addCommand<ObjCmdBuffer::LogProfilingData>();
-            new( cmd ) ObjCmdBuffer::LogProfilingData( texture, queuedImage.dstSliceOrDepth,
-                                                       queuedImage.microsecondsTaken );
-#endif
-
             // We don't restore bytesPreloaded because it gets reset to 0 by worker thread.
             // Doing so could increase throughput of data we can preload. However it can
             // cause a positive feedback effect where limits don't get respected at all
@@ -2712,9 +3546,23 @@ namespace Ogre
             mMultiLoadsSemaphore.decrementOrWait();
 
             bool bWorkGrabbed = false;
+            HelperTask *helperTask = 0;
 
             mMultiLoadsMutex.lock();
-            if( !mMultiLoads.empty() )
+            // Helping with a task someone else is waiting on has priority over loading
+            FastArray<HelperTask *>::const_iterator itHelper = mHelperTasks.begin();
+            FastArray<HelperTask *>::const_iterator enHelper = mHelperTasks.end();
+            while( itHelper != enHelper && !helperTask )
+            {
+                if( ( *itHelper )->wakeTickets > 0u )
+                {
+                    helperTask = *itHelper;
+                    --helperTask->wakeTickets;
+                    ++helperTask->numHelpers;
+                }
+                ++itHelper;
+            }
+            if( !helperTask && !mMultiLoads.empty() )
             {
                 loadRequest = std::move( mMultiLoads.back() );
                 mMultiLoads.pop_back();
@@ -2725,7 +3573,13 @@ namespace Ogre
             bUseMultiload = mUseMultiload.load( std::memory_order_relaxed );
             mMultiLoadsMutex.unlock();
 
-            if( bWorkGrabbed )
+            if( helperTask )
+            {
+                helperTask->runChunks();
+                // helperTask lives in the stack of the thread waiting for us. Don't touch it after this.
+                helperTask->numHelpers.fetch_sub( 1u, std::memory_order_release );
+            }
+            else if( bWorkGrabbed )
             {
                 OGRE_ASSERT_LOW( !loadRequest.image );
 
@@ -2745,7 +3599,7 @@ namespace Ogre
                 {
                     try
                     {
-                        data = loadRequest.archive->open( loadRequest.name );
+                        data = openFromArchive( loadRequest );
                         if( loadRequest.loadingListener )
                         {
                             loadRequest.loadingListener->grouplessResourceOpened(
@@ -2817,6 +3671,22 @@ namespace Ogre
         return 0;
     }
     //-----------------------------------------------------------------------------------
+    DataStreamPtr TextureGpuManager::openFromArchive( const LoadRequest &loadRequest )
+    {
+        // PremultiplyAlpha modifies the pixels in place, which a mapped file can't do
+        if( mUseMemoryMappedFiles && !loadRequest.loadingListener &&
+            !( loadRequest.filters & TextureFilter::TypePremultiplyAlpha ) &&
+            loadRequest.archive->getType() == "FileSystem" && isMemoryMappable( loadRequest.name ) )
+        {
+            DataStreamPtr data = static_cast<FileSystemArchive *>( loadRequest.archive )
+                                     ->openMemoryMapped( loadRequest.name );
+            if( data )
+                return data;
+        }
+
+        return loadRequest.archive->open( loadRequest.name );
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
                                                 const LoadRequest &loadRequest )
     {
@@ -2858,6 +3728,12 @@ namespace Ogre
                 LML_CRITICAL );
         }
 
+#ifdef OGRE_PROFILING_TEXTURES
+        uint64 usStages[TextureLoadStage::NumTextureLoadStages];
+        memset( usStages, 0, sizeof( usStages ) );
+        Timer stageTimer;
+#endif
+
         DataStreamPtr data;
         if( !loadRequest.archive && !loadRequest.image )
             data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
@@ -2865,7 +3741,7 @@ namespace Ogre
         {
             try
             {
-                data = loadRequest.archive->open( loadRequest.name );
+                data = openFromArchive( loadRequest );
                 if( loadRequest.loadingListener )
                 {
                     loadRequest.loadingListener->grouplessResourceOpened( loadRequest.name,
@@ -2885,6 +3761,11 @@ namespace Ogre
             }
         }
 
+#ifdef OGRE_PROFILING_TEXTURES
+        usStages[TextureLoadStage::FileIo] = stageTimer.getMicroseconds();
+        stageTimer.reset();
+#endif
+
         // Load the image from file into system RAM
         Image2 imgStack;
         Image2 *img = loadRequest.image;
@@ -2935,6 +3816,10 @@ namespace Ogre
             }
         }
 
+#ifdef OGRE_PROFILING_TEXTURES
+        usStages[TextureLoadStage::Decode] = stageTimer.getMicroseconds();
+#endif
+
         if( ( loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() ||
               loadRequest.sliceOrDepth == 0 ) &&
             loadRequest.texture->getResidencyStatus() != GpuResidency::OnStorage )
@@ -3001,6 +3886,9 @@ namespace Ogre
                     loadRequest.texture->setNumMipmaps( img->getNumMipmaps() );
                 }
 
+#ifdef OGRE_PROFILING_TEXTURES
+                stageTimer.reset();
+#endif
                 FilterBaseArray::const_iterator itFilters = filters.begin();
                 FilterBaseArray::const_iterator enFilters = filters.end();
                 while( itFilters != enFilters )
@@ -3008,6 +3896,9 @@ namespace Ogre
                     ( *itFilters )->_executeStreaming( *img, loadRequest.texture );
                     ++itFilters;
                 }
+#ifdef OGRE_PROFILING_TEXTURES
+                usStages[TextureLoadStage::Filters] = stageTimer.getMicroseconds();
+#endif
 
                 const bool needsMultipleImages =
                     img->getTextureType() != loadRequest.texture->getTextureType() &&
@@ -3023,7 +3914,7 @@ namespace Ogre
                 void *sysRamCopy = 0;
                 if( mustKeepSysRamPtr )
                 {
-                    if( !needsMultipleImages &&
+                    if( !needsMultipleImages && !img->isMemoryMapped() &&
                         img->getNumMipmaps() == loadRequest.texture->getNumMipmaps() )
                     {
                         // Pass the raw pointer and transfer ownership to TextureGpu
@@ -3087,6 +3978,9 @@ namespace Ogre
             else
             {
                 // Loading a cubemap made of 6 files (the last 5 files will take this path)
+#ifdef OGRE_PROFILING_TEXTURES
+                stageTimer.reset();
+#endif
                 FilterBaseArray::const_iterator itFilters = filters.begin();
                 FilterBaseArray::const_iterator enFilters = filters.end();
                 while( itFilters != enFilters )
@@ -3094,6 +3988,9 @@ namespace Ogre
                     ( *itFilters )->_executeStreaming( *img, loadRequest.texture );
                     ++itFilters;
                 }
+#ifdef OGRE_PROFILING_TEXTURES
+                usStages[TextureLoadStage::Filters] = stageTimer.getMicroseconds();
+#endif
 
                 if( loadRequest.toSysRam || loadRequest.texture->getGpuPageOutStrategy() ==
                                                 GpuPageOutStrategy::AlwaysKeepSystemRamCopy )
@@ -3153,7 +4050,8 @@ namespace Ogre
                                                                     loadRequest.sliceOrDepth, filters
 #ifdef OGRE_PROFILING_TEXTURES
                                                                     ,
-                                                                    profilingTimer.getMicroseconds()
+                                                                    profilingTimer.getMicroseconds(),
+                                                                    usStages
 #endif
                                                                         ) );
                 if( loadRequest.autoDeleteImage )
@@ -3521,12 +4419,23 @@ namespace Ogre
                 mTryLockMutexFailureCount = 0;
                 std::swap( mainData.objCmdBuffer, workerData.objCmdBuffer );
                 mainData.usedStagingTex.swap( workerData.usedStagingTex );
+#ifdef OGRE_PROFILING_TEXTURES
+                // Must happen before fullfillBudget resets bytesPreloaded
+                if( mProfilingLoadingTime )
+                {
+                    sampleLoadingStats( mainData.loadRequests.size() +
+                                        workerData.loadRequests.size() );
+                }
+#endif
                 if( mStreamingData.workerThreadRan )
                 {
                     fullfillBudget();
                     mStreamingData.workerThreadRan = false;
                 }
 
+                if( mPriorityStreaming )
+                    sortStreamingByPriority();
+
                 isDone = mainData.loadRequests.empty() && workerData.loadRequests.empty() &&
                          mStreamingData.queuedImages.empty() && isPendingMultiLoadDone;
                 mMutex.unlock();
@@ -3587,6 +4496,9 @@ namespace Ogre
             mainData.usedStagingTex.clear();
         }
 
+        if( mStreamingVramBudget )
+            enforceStreamingVramBudget();
+
         processDownloadToRamQueue();
 
         // After we've checked mainData.loadRequests.empty() inside the lock;
@@ -3729,7 +4641,7 @@ namespace Ogre
                                                  uint32 _dstSliceOrDepth, FilterBaseArray &inOutFilters
 #ifdef OGRE_PROFILING_TEXTURES
                                                  ,
-                                                 uint64 _microsecondsTaken
+                                                 uint64 _microsecondsTaken, const uint64 *_usStages
 #endif
                                                  ) :
         dstTexture( _dstTexture ),
@@ -3742,6 +4654,10 @@ namespace Ogre
     {
         assert( srcImage.getDepthOrSlices() >= 1u );
 
+#ifdef OGRE_PROFILING_TEXTURES
+        memcpy( usStages, _usStages, sizeof( usStages ) );
+#endif
+
         filters.swap( inOutFilters );
 
         // Prevent destroying the internal data in srcImage if QueuedImageVec
@@ -3830,6 +4746,31 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
+    TextureGpuManager::LoadingStats::LoadingStats() { reset(); }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::LoadingStats::reset()
+    {
+        textures.clear();
+        memset( usStagesAccum, 0, sizeof( usStagesAccum ) );
+        usTotalAccum = 0u;
+        maxPendingLoadRequests = 0u;
+        maxQueuedImages = 0u;
+        maxStagingTextureBytes = 0u;
+        accumStagingTextureBytes = 0u;
+        stagingTextureMaxBudgetBytes = 0u;
+        maxPreloadedBytes = 0u;
+        accumPreloadedBytes = 0u;
+        maxPreloadBytes = 0u;
+        numSamples = 0u;
+    }
+    //-----------------------------------------------------------------------------------
+#ifdef OGRE_PROFILING_TEXTURES
+    TextureGpuManager::ProfilingEntry::ProfilingEntry()
+    {
+        memset( usStages, 0, sizeof( usStages ) );
+    }
+    //-----------------------------------------------------------------------------------
+#endif
     bool TextureGpuManager::BudgetEntry::operator()( const BudgetEntry &_l, const BudgetEntry &_r ) const
     {
         // Biggest ones come first
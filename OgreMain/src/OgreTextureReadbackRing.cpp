@@ -0,0 +1,319 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreTextureReadbackRing.h"
+
+#include "OgreAsyncTextureTicket.h"
+#include "OgreException.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureGpuManager.h"
+
+namespace Ogre
+{
+    TextureReadbackListener::~TextureReadbackListener() {}
+    //-------------------------------------------------------------------------
+    TextureReadbackRing::Slot::Slot() :
+        ticket( 0 ),
+        frameId( 0u ),
+        cpuData( 0 ),
+        rawData( 0 ),
+        state( SlotFree )
+    {
+    }
+    //-------------------------------------------------------------------------
+    unsigned long updateTextureReadbackRingWorkerThread( ThreadHandle *threadHandle )
+    {
+        Threads::SetThreadName(
+            threadHandle, "Readback#" + StringConverter::toString( threadHandle->getThreadIdx() ) );
+
+        TextureReadbackRing *ring =
+            reinterpret_cast<TextureReadbackRing *>( threadHandle->getUserParam() );
+        return ring->_updateWorkerThread( threadHandle );
+    }
+    THREAD_DECLARE( updateTextureReadbackRingWorkerThread );
+    //-------------------------------------------------------------------------
+    TextureReadbackRing::TextureReadbackRing( TextureGpuManager *textureManager, uint32 width,
+                                              uint32 height, PixelFormatGpu pixelFormat,
+                                              size_t numTickets, TextureReadbackListener *listener,
+                                              size_t numWorkerThreads,
+                                              PixelFormatGpu dstPixelFormat ) :
+        mTextureManager( textureManager ),
+        mListener( listener ),
+        mSlots( 0 ),
+        mNumSlots( std::max<size_t>( numTickets, 1u ) ),
+        mNextSlot( 0u ),
+        mOldestSlot( 0u ),
+        mNumDownloading( 0u ),
+        mSrcPixelFormat( PixelFormatGpuUtils::getFamily( pixelFormat ) ),
+        mDstPixelFormat( dstPixelFormat ),
+        mJobsAvailable( 0u ),
+        mNumPendingJobs( 0u ),
+        mExitThreads( false )
+    {
+        OGRE_ASSERT_LOW( listener );
+
+        if( mDstPixelFormat == mSrcPixelFormat )
+            mDstPixelFormat = PFG_UNKNOWN;
+
+        if( mDstPixelFormat != PFG_UNKNOWN && ( PixelFormatGpuUtils::isCompressed( mSrcPixelFormat ) ||
+                                                PixelFormatGpuUtils::isCompressed( mDstPixelFormat ) ) )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Cannot convert from " +
+                             String( PixelFormatGpuUtils::toString( mSrcPixelFormat ) ) + " to " +
+                             PixelFormatGpuUtils::toString( mDstPixelFormat ) +
+                             ". Compressed formats are not supported",
+                         "TextureReadbackRing::TextureReadbackRing" );
+        }
+
+        mSlots = new Slot[mNumSlots];
+
+        // The slots need their own CPU copy if the listener won't be called
+        // while the ticket is mapped, or if we have to convert the data.
+        const bool needsCpuCopy = numWorkerThreads > 0u || mDstPixelFormat != PFG_UNKNOWN;
+        const PixelFormatGpu cpuFormat =
+            mDstPixelFormat != PFG_UNKNOWN ? mDstPixelFormat : mSrcPixelFormat;
+        // The worker threads convert from an unconverted copy, since
+        // the ticket must be unmapped from the main thread
+        const bool needsRawCopy = numWorkerThreads > 0u && mDstPixelFormat != PFG_UNKNOWN;
+
+        for( size_t i = 0u; i < mNumSlots; ++i )
+        {
+            Slot &slot = mSlots[i];
+            slot.ticket = mTextureManager->createAsyncTextureTicket(
+                width, height, 1u, TextureTypes::Type2D, mSrcPixelFormat );
+
+            if( needsCpuCopy )
+            {
+                const size_t bytesPerImage =
+                    PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, cpuFormat, 4u );
+                slot.cpuBox = TextureBox(
+                    width, height, 1u, 1u, PixelFormatGpuUtils::getBytesPerPixel( cpuFormat ),
+                    static_cast<uint32>( bytesPerImage / height ), bytesPerImage );
+                if( PixelFormatGpuUtils::isCompressed( cpuFormat ) )
+                {
+                    slot.cpuBox.bytesPerRow = static_cast<uint32>( PixelFormatGpuUtils::getSizeBytes(
+                        width, 1u, 1u, 1u, cpuFormat, 4u ) );
+                    slot.cpuBox.setCompressedPixelFormat( cpuFormat );
+                }
+                slot.cpuData =
+                    reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( bytesPerImage, MEMCATEGORY_RESOURCE ) );
+                slot.cpuBox.data = slot.cpuData;
+            }
+
+            if( needsRawCopy )
+            {
+                const size_t bytesPerImage =
+                    PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, mSrcPixelFormat, 4u );
+                slot.rawBox = TextureBox(
+                    width, height, 1u, 1u, PixelFormatGpuUtils::getBytesPerPixel( mSrcPixelFormat ),
+                    static_cast<uint32>( bytesPerImage / height ), bytesPerImage );
+                slot.rawData =
+                    reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( bytesPerImage, MEMCATEGORY_RESOURCE ) );
+                slot.rawBox.data = slot.rawData;
+            }
+        }
+
+        mWorkerThreads.reserve( numWorkerThreads );
+        for( size_t i = 0u; i < numWorkerThreads; ++i )
+        {
+            ThreadHandlePtr th = Threads::CreateThread(
+                THREAD_GET( updateTextureReadbackRingWorkerThread ), i, this );
+            mWorkerThreads.push_back( th );
+        }
+    }
+    //-------------------------------------------------------------------------
+    TextureReadbackRing::~TextureReadbackRing()
+    {
+        flush();
+
+        mExitThreads.store( true, std::memory_order_release );
+        if( !mWorkerThreads.empty() )
+        {
+            mJobsAvailable.increment( static_cast<uint32_t>( mWorkerThreads.size() ) );
+            Threads::WaitForThreads( mWorkerThreads );
+            mWorkerThreads.clear();
+        }
+
+        for( size_t i = 0u; i < mNumSlots; ++i )
+        {
+            Slot &slot = mSlots[i];
+            mTextureManager->destroyAsyncTextureTicket( slot.ticket );
+            slot.ticket = 0;
+            if( slot.cpuData )
+            {
+                OGRE_FREE_SIMD( slot.cpuData, MEMCATEGORY_RESOURCE );
+                slot.cpuData = 0;
+            }
+            if( slot.rawData )
+            {
+                OGRE_FREE_SIMD( slot.rawData, MEMCATEGORY_RESOURCE );
+                slot.rawData = 0;
+            }
+        }
+
+        delete[] mSlots;
+        mSlots = 0;
+    }
+    //-------------------------------------------------------------------------
+    bool TextureReadbackRing::readback( TextureGpu *texture, uint64 frameId, uint8 mipLevel )
+    {
+        Slot &slot = mSlots[mNextSlot];
+        if( slot.state.load( std::memory_order_acquire ) != SlotFree )
+            return false;  // Every ticket is busy
+
+        slot.frameId = frameId;
+        slot.state.store( SlotDownloading, std::memory_order_relaxed );
+        downloadToSlot( slot, texture, mipLevel );
+
+        mNextSlot = ( mNextSlot + 1u ) % mNumSlots;
+        ++mNumDownloading;
+
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    void TextureReadbackRing::downloadToSlot( Slot &slot, TextureGpu *texture, uint8 mipLevel )
+    {
+        slot.ticket->download( texture, mipLevel, true );
+    }
+    //-------------------------------------------------------------------------
+    void TextureReadbackRing::processSlot( Slot &slot )
+    {
+        const TextureBox mappedBox = slot.ticket->map( 0u );
+
+        if( slot.cpuData )
+        {
+            if( slot.rawData )
+            {
+                // The worker thread will convert it
+                slot.rawBox.copyFrom( mappedBox );
+            }
+            else if( mDstPixelFormat != PFG_UNKNOWN )
+            {
+                PixelFormatGpuUtils::bulkPixelConversion( mappedBox, mSrcPixelFormat, slot.cpuBox,
+                                                          mDstPixelFormat );
+            }
+            else
+            {
+                slot.cpuBox.copyFrom( mappedBox );
+            }
+            slot.ticket->unmap();
+
+            if( !mWorkerThreads.empty() )
+            {
+                slot.state.store( SlotProcessing, std::memory_order_relaxed );
+                mNumPendingJobs.fetch_add( 1u, std::memory_order_relaxed );
+                mJobMutex.lock();
+                mJobs.push_back( &slot );
+                mJobMutex.unlock();
+                mJobsAvailable.increment();
+            }
+            else
+            {
+                mListener->readbackFinished( slot.cpuBox, mDstPixelFormat, slot.frameId );
+                slot.state.store( SlotFree, std::memory_order_relaxed );
+            }
+        }
+        else
+        {
+            mListener->readbackFinished( mappedBox, mSrcPixelFormat, slot.frameId );
+            slot.ticket->unmap();
+            slot.state.store( SlotFree, std::memory_order_relaxed );
+        }
+    }
+    //-------------------------------------------------------------------------
+    size_t TextureReadbackRing::poll()
+    {
+        size_t numDelivered = 0u;
+        while( mNumDownloading > 0u )
+        {
+            Slot &slot = mSlots[mOldestSlot];
+            if( !slot.ticket->queryIsTransferDone() )
+                break;  // Deliver in order. If this one isn't ready, newer ones won't be either
+
+            processSlot( slot );
+            mOldestSlot = ( mOldestSlot + 1u ) % mNumSlots;
+            --mNumDownloading;
+            ++numDelivered;
+        }
+        return numDelivered;
+    }
+    //-------------------------------------------------------------------------
+    void TextureReadbackRing::flush()
+    {
+        while( mNumDownloading > 0u )
+        {
+            processSlot( mSlots[mOldestSlot] );
+            mOldestSlot = ( mOldestSlot + 1u ) % mNumSlots;
+            --mNumDownloading;
+        }
+
+        waitForWorkers();
+    }
+    //-------------------------------------------------------------------------
+    void TextureReadbackRing::waitForWorkers()
+    {
+        while( mNumPendingJobs.load( std::memory_order_acquire ) > 0u )
+            mJobFinished.wait();
+    }
+    //-------------------------------------------------------------------------
+    unsigned long TextureReadbackRing::_updateWorkerThread( ThreadHandle * )
+    {
+        while( true )
+        {
+            mJobsAvailable.decrementOrWait();
+
+            if( mExitThreads.load( std::memory_order_acquire ) )
+                break;
+
+            mJobMutex.lock();
+            Slot *slot = mJobs.front();
+            mJobs.pop_front();
+            mJobMutex.unlock();
+
+            if( slot->rawData )
+            {
+                PixelFormatGpuUtils::bulkPixelConversion( slot->rawBox, mSrcPixelFormat, slot->cpuBox,
+                                                          mDstPixelFormat );
+            }
+
+            const PixelFormatGpu pixelFormat =
+                mDstPixelFormat != PFG_UNKNOWN ? mDstPixelFormat : mSrcPixelFormat;
+            mListener->readbackFinished( slot->cpuBox, pixelFormat, slot->frameId );
+
+            slot->state.store( SlotFree, std::memory_order_release );
+            mNumPendingJobs.fetch_sub( 1u, std::memory_order_acq_rel );
+            mJobFinished.wake();
+        }
+
+        return 0;
+    }
+}  // namespace Ogre
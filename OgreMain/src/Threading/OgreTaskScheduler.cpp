@@ -0,0 +1,336 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-present Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Threading/OgreTaskScheduler.h"
+
+#include "OgreException.h"
+#include "OgreStringConverter.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include <thread>
+
+namespace Ogre
+{
+    TaskScheduler::Task::Task() :
+        task( 0 ),
+        numChunks( 0u ),
+        pendingChunks( 0u ),
+        finished( false ),
+        pendingDependencies( 0u )
+    {
+    }
+    //-------------------------------------------------------------------------
+    unsigned long updateTaskSchedulerWorkerThread( ThreadHandle *threadHandle )
+    {
+        Threads::SetThreadName(
+            threadHandle, "TaskSched#" + StringConverter::toString( threadHandle->getThreadIdx() ) );
+
+        TaskScheduler *scheduler = reinterpret_cast<TaskScheduler *>( threadHandle->getUserParam() );
+        return scheduler->_updateWorkerThread( threadHandle );
+    }
+    THREAD_DECLARE( updateTaskSchedulerWorkerThread );
+    //-------------------------------------------------------------------------
+    TaskScheduler::TaskScheduler( size_t numWorkerThreads, uint32 maxTasks ) :
+        mQueues( 0 ),
+        mNumQueues( numWorkerThreads + 1u ),
+        mTasks( 0 ),
+        mMaxTasks( std::max( maxTasks, 1u ) ),
+        mNumTasks( 0u ),
+        mFirstTaskId( 0u ),
+        mNumUnfinishedTasks( 0u ),
+        mWakeUpWorkers( 0u ),
+        mExitThreads( false ),
+        mNumStolenChunks( 0u )
+    {
+        mQueues = new WorkerQueue[mNumQueues];
+        mTasks = new Task[mMaxTasks];
+
+        mWorkerThreads.reserve( numWorkerThreads );
+        for( size_t i = 0; i < numWorkerThreads; ++i )
+        {
+            ThreadHandlePtr th =
+                Threads::CreateThread( THREAD_GET( updateTaskSchedulerWorkerThread ), i + 1u, this );
+            mWorkerThreads.push_back( th );
+        }
+    }
+    //-------------------------------------------------------------------------
+    TaskScheduler::~TaskScheduler()
+    {
+        waitForAll();
+
+        mExitThreads.store( true, std::memory_order_release );
+        if( !mWorkerThreads.empty() )
+        {
+            mWakeUpWorkers.increment( static_cast<uint32_t>( mWorkerThreads.size() ) );
+            Threads::WaitForThreads( mWorkerThreads );
+        }
+
+        delete[] mTasks;
+        mTasks = 0;
+        delete[] mQueues;
+        mQueues = 0;
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::enqueueChunks( uint32 taskIdx )
+    {
+        Task &task = mTasks[taskIdx];
+
+        if( !task.numChunks )
+        {
+            onTaskFinished( taskIdx );
+            return;
+        }
+
+        // Give each queue a contiguous range of chunks. Chunks next to each other
+        // usually touch memory next to each other.
+        const uint32 numChunks = task.numChunks;
+        const size_t numQueues = std::min<size_t>( mNumQueues, numChunks );
+        for( size_t i = 0; i < numQueues; ++i )
+        {
+            const uint32 firstChunk = static_cast<uint32>( ( numChunks * i ) / numQueues );
+            const uint32 lastChunk = static_cast<uint32>( ( numChunks * ( i + 1u ) ) / numQueues );
+
+            WorkerQueue &queue = mQueues[i];
+            queue.mutex.lock();
+            for( uint32 chunkIdx = firstChunk; chunkIdx < lastChunk; ++chunkIdx )
+            {
+                const WorkItem item = { taskIdx, chunkIdx };
+                queue.items.push_back( item );
+            }
+            queue.mutex.unlock();
+        }
+
+        if( !mWorkerThreads.empty() )
+        {
+            mWakeUpWorkers.increment(
+                static_cast<uint32_t>( std::min<size_t>( numChunks, mWorkerThreads.size() ) ) );
+        }
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::onTaskFinished( uint32 taskIdx )
+    {
+        // When called from enqueueChunks we already hold the lock
+        Task &task = mTasks[taskIdx];
+
+        vector<uint32>::type::const_iterator itor = task.dependents.begin();
+        vector<uint32>::type::const_iterator endt = task.dependents.end();
+
+        while( itor != endt )
+        {
+            Task &dependent = mTasks[*itor];
+            OGRE_ASSERT_LOW( dependent.pendingDependencies > 0u );
+            if( --dependent.pendingDependencies == 0u )
+                enqueueChunks( *itor );
+            ++itor;
+        }
+
+        // Decrement before publishing. Otherwise the main thread could see the task finished
+        // from waitFor() and then call addTask() while mNumUnfinishedTasks still counts it,
+        // failing with "Too many tasks in flight" even though everything is done.
+        mNumUnfinishedTasks.fetch_sub( 1u, std::memory_order_acq_rel );
+        task.finished.store( true, std::memory_order_release );
+    }
+    //-------------------------------------------------------------------------
+    bool TaskScheduler::popOrSteal( size_t queueIdx, WorkItem &outItem )
+    {
+        {
+            // Own queue. Pop from the front to preserve the order of the chunks
+            WorkerQueue &queue = mQueues[queueIdx];
+            queue.mutex.lock();
+            if( !queue.items.empty() )
+            {
+                outItem = queue.items.front();
+                queue.items.pop_front();
+                queue.mutex.unlock();
+                return true;
+            }
+            queue.mutex.unlock();
+        }
+
+        // Steal from the back of the others, starting from our neighbour
+        // so not everyone tries to steal from the same victim
+        for( size_t i = 1u; i < mNumQueues; ++i )
+        {
+            WorkerQueue &queue = mQueues[( queueIdx + i ) % mNumQueues];
+            queue.mutex.lock();
+            if( !queue.items.empty() )
+            {
+                outItem = queue.items.back();
+                queue.items.pop_back();
+                queue.mutex.unlock();
+                mNumStolenChunks.fetch_add( 1u, std::memory_order_relaxed );
+                return true;
+            }
+            queue.mutex.unlock();
+        }
+
+        return false;
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::executeWorkItem( const WorkItem &item )
+    {
+        Task &task = mTasks[item.taskIdx];
+        task.task->execute( item.chunkIdx, task.numChunks );
+
+        if( task.pendingChunks.fetch_sub( 1u, std::memory_order_acq_rel ) == 1u )
+        {
+            mGraphMutex.lock();
+            onTaskFinished( item.taskIdx );
+            mGraphMutex.unlock();
+        }
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::resetGraph()
+    {
+        OGRE_ASSERT_LOW( mNumUnfinishedTasks.load( std::memory_order_acquire ) == 0u );
+
+        // The last task may have been counted as finished while its worker is still inside
+        // onTaskFinished. Taking the lock waits for it before its slot gets recycled.
+        mGraphMutex.lock();
+        for( uint32 i = 0u; i < mNumTasks; ++i )
+            mTasks[i].dependents.clear();
+        mGraphMutex.unlock();
+
+        mFirstTaskId += mNumTasks;
+        mNumTasks = 0u;
+    }
+    //-------------------------------------------------------------------------
+    TaskScheduler::TaskId TaskScheduler::addTask( UniformScalableTask *task, size_t numChunks,
+                                                  const TaskId *dependencies, size_t numDependencies )
+    {
+        if( mNumTasks == mMaxTasks )
+        {
+            if( mNumUnfinishedTasks.load( std::memory_order_acquire ) != 0u )
+            {
+                OGRE_EXCEPT( Exception::ERR_INVALID_STATE,
+                             "Too many tasks in flight (" + StringConverter::toString( mMaxTasks ) +
+                                 "). Call waitForAll or increase maxTasks",
+                             "TaskScheduler::addTask" );
+            }
+            resetGraph();
+        }
+
+        const uint32 taskIdx = mNumTasks++;
+        const TaskId taskId = mFirstTaskId + taskIdx;
+
+        Task &newTask = mTasks[taskIdx];
+        newTask.task = task;
+        newTask.numChunks = static_cast<uint32>( numChunks );
+        newTask.pendingChunks.store( static_cast<uint32>( numChunks ), std::memory_order_relaxed );
+        newTask.finished.store( false, std::memory_order_relaxed );
+        newTask.pendingDependencies = 0u;
+        newTask.dependents.clear();
+
+        mNumUnfinishedTasks.fetch_add( 1u, std::memory_order_acq_rel );
+
+        mGraphMutex.lock();
+        for( size_t i = 0; i < numDependencies; ++i )
+        {
+            // Tasks from previous graphs are always finished
+            if( dependencies[i] >= mFirstTaskId )
+            {
+                const uint32 depIdx = dependencies[i] - mFirstTaskId;
+                OGRE_ASSERT_LOW( depIdx < taskIdx && "Dependency must be added before this task" );
+                Task &dependency = mTasks[depIdx];
+                if( !dependency.finished.load( std::memory_order_acquire ) )
+                {
+                    dependency.dependents.push_back( taskIdx );
+                    ++newTask.pendingDependencies;
+                }
+            }
+        }
+
+        if( !newTask.pendingDependencies )
+            enqueueChunks( taskIdx );
+        mGraphMutex.unlock();
+
+        return taskId;
+    }
+    //-------------------------------------------------------------------------
+    bool TaskScheduler::canAddTask() const
+    {
+        return mNumTasks < mMaxTasks || mNumUnfinishedTasks.load( std::memory_order_acquire ) == 0u;
+    }
+    //-------------------------------------------------------------------------
+    bool TaskScheduler::isTaskFinished( TaskId taskId ) const
+    {
+        if( taskId < mFirstTaskId )
+            return true;
+        OGRE_ASSERT_LOW( taskId - mFirstTaskId < mNumTasks );
+        return mTasks[taskId - mFirstTaskId].finished.load( std::memory_order_acquire );
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::waitFor( TaskId taskId )
+    {
+        WorkItem item;
+        while( !isTaskFinished( taskId ) )
+        {
+            if( popOrSteal( 0u, item ) )
+                executeWorkItem( item );
+            else
+                std::this_thread::yield();
+        }
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::waitForAll()
+    {
+        WorkItem item;
+        while( mNumUnfinishedTasks.load( std::memory_order_acquire ) != 0u )
+        {
+            if( popOrSteal( 0u, item ) )
+                executeWorkItem( item );
+            else
+                std::this_thread::yield();
+        }
+
+        resetGraph();
+    }
+    //-------------------------------------------------------------------------
+    void TaskScheduler::executeUniformScalableTask( UniformScalableTask *task, size_t numChunks )
+    {
+        waitFor( addTask( task, numChunks ) );
+    }
+    //-------------------------------------------------------------------------
+    unsigned long TaskScheduler::_updateWorkerThread( ThreadHandle *threadHandle )
+    {
+        const size_t queueIdx = threadHandle->getThreadIdx();
+
+        WorkItem item;
+        while( !mExitThreads.load( std::memory_order_acquire ) )
+        {
+            if( popOrSteal( queueIdx, item ) )
+                executeWorkItem( item );
+            else
+                mWakeUpWorkers.decrementOrWait();
+        }
+
+        return 0;
+    }
+}  // namespace Ogre
@@ -64,6 +64,7 @@ namespace Ogre
 
         NULLPixelFormatToShaderType mPixelFormatToShaderType;
 
+
     public:
         NULLRenderSystem();
         ~NULLRenderSystem() override;
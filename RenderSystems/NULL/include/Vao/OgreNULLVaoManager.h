@@ -186,7 +186,10 @@ namespace Ogre
                                      size_t newPoolIdx, BufferPacked *buffer ) override;
 
     public:
-        NULLVaoManager();
+        /// @param readOnlyIsTexBuffer
+        ///     Value of readOnlyIsTexBuffer to report. Tools emulating another
+        ///     RenderSystem set it to match it, since Hlms generates different shaders
+        NULLVaoManager( bool readOnlyIsTexBuffer = true );
         ~NULLVaoManager() override;
 
         void getMemoryStats( MemoryStatsEntryVec &outStats, size_t &outCapacityBytes,
@@ -130,18 +130,34 @@ namespace Ogre
 
         if( !mInitialized )
         {
+            bool readOnlyIsTexBuffer = true;
             if( miscParams )
             {
                 NameValuePairList::const_iterator itOption = miscParams->find( "reverse_depth" );
                 if( itOption != miscParams->end() )
                     mReverseDepth = StringConverter::parseBool( itOption->second, true );
+
+                // Offline tools (e.g. OgreHlmsPrecompiler) run headless but need Hlms to
+                // believe it's talking to the real target API. Its capabilities come from
+                // useCustomRenderSystemCapabilities; these aren't part of them.
+                itOption = miscParams->find( "emulated_shading_language_version" );
+                if( itOption != miscParams->end() )
+                {
+                    mNativeShadingLanguageVersion =
+                        static_cast<uint16>( StringConverter::parseUnsignedInt( itOption->second ) );
+                }
+                itOption = miscParams->find( "emulated_read_only_is_tex_buffer" );
+                if( itOption != miscParams->end() )
+                    readOnlyIsTexBuffer = StringConverter::parseBool( itOption->second, true );
             }
 
             mRealCapabilities = createRenderSystemCapabilities();
-            mCurrentCapabilities = mRealCapabilities;
+            // use real capabilities if custom capabilities are not available
+            if( !mUseCustomCapabilities )
+                mCurrentCapabilities = mRealCapabilities;
 
             mHardwareBufferManager = new v1::DefaultHardwareBufferManager();
-            mVaoManager = OGRE_NEW NULLVaoManager();
+            mVaoManager = OGRE_NEW NULLVaoManager( readOnlyIsTexBuffer );
             mTextureGpuManager = OGRE_NEW NULLTextureGpuManager( mVaoManager, this );
 
             mInitialized = true;
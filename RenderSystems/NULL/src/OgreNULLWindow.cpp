@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "OgreNULLTextureGpu.h"
 #include "OgreNULLTextureGpuManager.h"
+#include "OgreStringConverter.h"
 
 namespace Ogre
 {
@@ -85,7 +86,8 @@ namespace Ogre
     //-------------------------------------------------------------------------
     bool NULLWindow::isHidden() const { return false; }
     //-------------------------------------------------------------------------
-    void NULLWindow::_initialize( TextureGpuManager *textureGpuManager, const NameValuePairList * )
+    void NULLWindow::_initialize( TextureGpuManager *textureGpuManager,
+                                  const NameValuePairList *miscParams )
     {
         destroy();
 
@@ -100,7 +102,17 @@ namespace Ogre
         mStencilBuffer = mDepthBuffer;
 
         setFinalResolution( mRequestedWidth, mRequestedHeight );
-        mTexture->setPixelFormat( PFG_RGBA8_UNORM );
+        // Honour "gamma" like the real RenderSystems do, since the format
+        // affects the PSOs generated by tools emulating them
+        bool hwGamma = false;
+        if( miscParams )
+        {
+            NameValuePairList::const_iterator itOption = miscParams->find( "gamma" );
+            if( itOption != miscParams->end() )
+                hwGamma = StringConverter::parseBool( itOption->second );
+        }
+
+        mTexture->setPixelFormat( hwGamma ? PFG_RGBA8_UNORM_SRGB : PFG_RGBA8_UNORM );
         mDepthBuffer->setPixelFormat( PFG_D32_FLOAT_S8X24_UINT );
 
         mTexture->_transitionTo( GpuResidency::Resident, (uint8 *)0 );
@@ -45,8 +45,10 @@ THE SOFTWARE.
 
 namespace Ogre
 {
-    NULLVaoManager::NULLVaoManager() : VaoManager( 0 ), mDrawId( 0 )
+    NULLVaoManager::NULLVaoManager( bool readOnlyIsTexBuffer ) : VaoManager( 0 ), mDrawId( 0 )
     {
+        mReadOnlyIsTexBuffer = readOnlyIsTexBuffer;
+
         mConstBufferAlignment = 256;
         mTexBufferAlignment = 256;
 
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "OgreMovableObject.h"
+#include "OgrePixelFormatGpu.h"
 #include "OgreShaderParams.h"
 
 #include "Terra/TerrainCell.h"
@@ -124,16 +125,31 @@ namespace Ogre
         uint32 mHlmsTerraIndex;
 
     protected:
+        /// Receives the heightmap rows and fills both the CPU-side buffers and
+        /// the heightmap texture. See Image2::decodeStreaming
+        class HeightmapStreamer;
+
         void destroyHeightmapTexture();
 
-        /// Creates the Ogre texture based on the image data.
-        /// Called by @see createHeightmap
-        void createHeightmapTexture( const Image2 &image, const String &imageName );
+        /// Creates the (empty) Ogre texture for a heightmap of the given format.
+        /// Called by @see HeightmapStreamer
+        void createHeightmapTexture( PixelFormatGpu pixelFormat, const String &imageName );
 
-        /// Calls createHeightmapTexture, loads image data to our CPU-side buffers
+        /// Loads image data to our CPU-side buffers and the heightmap texture
         void createHeightmap( Image2 &image, const String &imageName, bool bMinimizeMemoryConsumption,
                               bool bLowResShadow );
 
+        /// Same as createHeightmap, but decodes the image straight from the stream a few rows
+        /// at a time, so the whole image never has to be loaded in memory.
+        void createHeightmapStreaming( DataStreamPtr &stream, const String &imageName,
+                                       bool bMinimizeMemoryConsumption, bool bLowResShadow );
+
+        /// Called once the heightmap is loaded. Creates the normal & shadow maps
+        void finishCreatingHeightmap( bool bMinimizeMemoryConsumption, bool bLowResShadow );
+
+        /// Sets the dimensions of the terrain. Called before loading it.
+        void setTerrainDimensions( Vector3 center, Vector3 dimensions );
+
         void createNormalTexture();
         void destroyNormalTexture();
 
@@ -204,6 +220,9 @@ namespace Ogre
 
         /**
         @brief load
+            Loads the heightmap from the given resource. The image is decoded
+            incrementally straight into the heightmap texture and CPU-side buffers,
+            keeping peak memory low for huge heightmaps.
         @param texName
         @param center
         @param dimensions
@@ -38,6 +38,7 @@ THE SOFTWARE.
 #include "OgreImage2.h"
 #include "OgreMaterialManager.h"
 #include "OgrePixelFormatGpuUtils.h"
+#include "OgreResourceGroupManager.h"
 #include "OgreSceneManager.h"
 #include "OgreStagingTexture.h"
 #include "OgreTechnique.h"
@@ -157,24 +158,149 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void Terra::createHeightmapTexture( const Ogre::Image2 &image, const String &imageName )
+    /// Writes the heightmap rows both to Terra::m_heightMap and to a StagingTexture
+    /// that gets uploaded to Terra::m_heightMapTex once all rows arrived.
+    class Terra::HeightmapStreamer : public ImageCodec2::StreamingListener
+    {
+        Terra *m_terra;
+        String m_imageName;
+
+        PixelFormatGpu m_pixelFormat;
+        float          m_heightScale;
+
+        StagingTexture *m_stagingTexture;
+        TextureBox      m_stagingBox;
+
+    public:
+        HeightmapStreamer( Terra *terra, const String &imageName ) :
+            m_terra( terra ),
+            m_imageName( imageName ),
+            m_pixelFormat( PFG_UNKNOWN ),
+            m_heightScale( 1.0f ),
+            m_stagingTexture( 0 )
+        {
+        }
+
+        ~HeightmapStreamer() override
+        {
+            if( m_stagingTexture )
+            {
+                // Loading was aborted
+                m_stagingTexture->stopMapRegion();
+                getTextureManager()->removeStagingTexture( m_stagingTexture );
+                m_stagingTexture = 0;
+            }
+        }
+
+        TextureGpuManager *getTextureManager() const
+        {
+            return m_terra->mManager->getDestinationRenderSystem()->getTextureGpuManager();
+        }
+
+        bool headerDecoded( const ImageCodec2::ImageData2 &header ) override
+        {
+            m_terra->m_width = header.box.width;
+            m_terra->m_depth = header.box.height;
+            m_terra->m_depthWidthRatio = float( m_terra->m_depth ) / float( m_terra->m_width );
+            m_terra->m_invWidth = 1.0f / float( m_terra->m_width );
+            m_terra->m_invDepth = 1.0f / float( m_terra->m_depth );
+
+            m_terra->createHeightmapTexture( header.format, m_imageName );
+
+            m_terra->m_heightMap.resize( m_terra->m_width * m_terra->m_depth );
+
+            m_pixelFormat = header.format;
+            if( m_pixelFormat == PFG_R32_FLOAT )
+            {
+                m_heightScale = m_terra->m_height;
+            }
+            else
+            {
+                float fBpp = (float)( PixelFormatGpuUtils::getBytesPerPixel( m_pixelFormat ) << 3u );
+                const float maxValue = powf( 2.0f, fBpp ) - 1.0f;
+                m_heightScale = m_terra->m_height / maxValue;
+            }
+
+            TextureGpu *heightMapTex = m_terra->m_heightMapTex;
+            m_stagingTexture = getTextureManager()->getStagingTexture(
+                heightMapTex->getWidth(), heightMapTex->getHeight(), 1u, 1u,
+                heightMapTex->getPixelFormat() );
+            m_stagingTexture->startMapRegion();
+            m_stagingBox =
+                m_stagingTexture->mapRegion( heightMapTex->getWidth(), heightMapTex->getHeight(), 1u,
+                                             1u, heightMapTex->getPixelFormat() );
+
+            return true;
+        }
+
+        bool rowsDecoded( const TextureBox &rows, uint8 mipLevel, uint32 zOrSlice,
+                          uint32 firstRow ) override
+        {
+            if( mipLevel != 0u || zOrSlice != 0u )
+                return true;  // We only want the first mip
+
+            const uint32 width = m_terra->m_width;
+            const size_t bytesPerRow = width * rows.bytesPerPixel;
+            float *RESTRICT_ALIAS heightMap = &m_terra->m_heightMap[firstRow * width];
+
+            for( uint32 y = 0; y < rows.height; ++y )
+            {
+                const void *srcRow = rows.at( 0, y, 0 );
+                memcpy( m_stagingBox.at( 0, firstRow + y, 0 ), srcRow, bytesPerRow );
+
+                if( m_pixelFormat == PFG_R8_UNORM )
+                {
+                    const uint8 *RESTRICT_ALIAS data =
+                        reinterpret_cast<const uint8 * RESTRICT_ALIAS>( srcRow );
+                    for( uint32 x = 0; x < width; ++x )
+                        heightMap[x] = data[x] * m_heightScale;
+                }
+                else if( m_pixelFormat == PFG_R16_UNORM )
+                {
+                    const uint16 *RESTRICT_ALIAS data =
+                        reinterpret_cast<const uint16 * RESTRICT_ALIAS>( srcRow );
+                    for( uint32 x = 0; x < width; ++x )
+                        heightMap[x] = data[x] * m_heightScale;
+                }
+                else
+                {
+                    const float *RESTRICT_ALIAS data =
+                        reinterpret_cast<const float * RESTRICT_ALIAS>( srcRow );
+                    for( uint32 x = 0; x < width; ++x )
+                        heightMap[x] = data[x] * m_heightScale;
+                }
+
+                heightMap += width;
+            }
+
+            return true;
+        }
+
+        /// Sends the heightmap to the GPU. Call once all rows have been decoded
+        void upload()
+        {
+            m_stagingTexture->stopMapRegion();
+            m_stagingTexture->upload( m_stagingBox, m_terra->m_heightMapTex, 0, 0, 0 );
+            getTextureManager()->removeStagingTexture( m_stagingTexture );
+            m_stagingTexture = 0;
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    void Terra::createHeightmapTexture( PixelFormatGpu pixelFormat, const String &imageName )
     {
         destroyHeightmapTexture();
 
-        if( image.getPixelFormat() != PFG_R8_UNORM && image.getPixelFormat() != PFG_R16_UNORM &&
-            image.getPixelFormat() != PFG_R32_FLOAT )
+        if( pixelFormat != PFG_R8_UNORM && pixelFormat != PFG_R16_UNORM &&
+            pixelFormat != PFG_R32_FLOAT )
         {
             OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
                          "Texture " + imageName + "must be greyscale 8 bpp, 16 bpp, or 32-bit Float",
                          "Terra::createHeightmapTexture" );
         }
 
-        // const uint8 numMipmaps = image.getNumMipmaps();
-
         TextureGpuManager *textureManager =
             mManager->getDestinationRenderSystem()->getTextureGpuManager();
         m_heightUnormScaled = m_height;
-        PixelFormatGpu pixelFormat = image.getPixelFormat();
 #if OGRE_PLATFORM == OGRE_PLATFORM_ANDROID
         // Many Android GPUs don't support PFG_R16_UNORM so we scale it by hand
         if( pixelFormat == PFG_R16_UNORM &&
@@ -188,77 +314,41 @@ namespace Ogre
         m_heightMapTex = textureManager->createTexture(
             "HeightMapTex" + StringConverter::toString( getId() ), GpuPageOutStrategy::SaveToSystemRam,
             TextureFlags::ManualTexture, TextureTypes::Type2D );
-        m_heightMapTex->setResolution( image.getWidth(), image.getHeight() );
+        m_heightMapTex->setResolution( m_width, m_depth );
         m_heightMapTex->setPixelFormat( pixelFormat );
         m_heightMapTex->scheduleTransitionTo( GpuResidency::Resident );
-
-        StagingTexture *stagingTexture = textureManager->getStagingTexture(
-            image.getWidth(), image.getHeight(), 1u, 1u, pixelFormat );
-        stagingTexture->startMapRegion();
-        TextureBox texBox =
-            stagingTexture->mapRegion( image.getWidth(), image.getHeight(), 1u, 1u, pixelFormat );
-
-        // for( uint8 mip=0; mip<numMipmaps; ++mip )
-        texBox.copyFrom( image.getData( 0 ) );
-        stagingTexture->stopMapRegion();
-        stagingTexture->upload( texBox, m_heightMapTex, 0, 0, 0 );
-        textureManager->removeStagingTexture( stagingTexture );
-        stagingTexture = 0;
     }
     //-----------------------------------------------------------------------------------
     void Terra::createHeightmap( Image2 &image, const String &imageName, bool bMinimizeMemoryConsumption,
                                  bool bLowResShadow )
     {
-        m_width = image.getWidth();
-        m_depth = image.getHeight();
-        m_depthWidthRatio = float( m_depth ) / float( m_width );
-        m_invWidth = 1.0f / float( m_width );
-        m_invDepth = 1.0f / float( m_depth );
-
-        // image.generateMipmaps( false, Image::FILTER_NEAREST );
-
-        createHeightmapTexture( image, imageName );
-
-        m_heightMap.resize( m_width * m_depth );
-
-        float fBpp = (float)( PixelFormatGpuUtils::getBytesPerPixel( image.getPixelFormat() ) << 3u );
-        const float maxValue = powf( 2.0f, fBpp ) - 1.0f;
-        const float invMaxValue = 1.0f / maxValue;
-
-        if( image.getPixelFormat() == PFG_R8_UNORM )
-        {
-            for( uint32 y = 0; y < m_depth; ++y )
-            {
-                TextureBox texBox = image.getData( 0 );
-                const uint8 *RESTRICT_ALIAS data =
-                    reinterpret_cast<uint8 * RESTRICT_ALIAS>( texBox.at( 0, y, 0 ) );
-                for( uint32 x = 0; x < m_width; ++x )
-                    m_heightMap[y * m_width + x] = ( data[x] * invMaxValue ) * m_height;
-            }
-        }
-        else if( image.getPixelFormat() == PFG_R16_UNORM )
-        {
-            TextureBox texBox = image.getData( 0 );
-            for( uint32 y = 0; y < m_depth; ++y )
-            {
-                const uint16 *RESTRICT_ALIAS data =
-                    reinterpret_cast<uint16 * RESTRICT_ALIAS>( texBox.at( 0, y, 0 ) );
-                for( uint32 x = 0; x < m_width; ++x )
-                    m_heightMap[y * m_width + x] = ( data[x] * invMaxValue ) * m_height;
-            }
-        }
-        else if( image.getPixelFormat() == PFG_R32_FLOAT )
-        {
-            TextureBox texBox = image.getData( 0 );
-            for( uint32 y = 0; y < m_depth; ++y )
-            {
-                const float *RESTRICT_ALIAS data =
-                    reinterpret_cast<float * RESTRICT_ALIAS>( texBox.at( 0, y, 0 ) );
-                for( uint32 x = 0; x < m_width; ++x )
-                    m_heightMap[y * m_width + x] = data[x] * m_height;
-            }
-        }
+        ImageCodec2::ImageData2 header;
+        header.box = image.getData( 0 );
+        header.textureType = image.getTextureType();
+        header.format = image.getPixelFormat();
+        header.numMipmaps = 1u;
+        header.freeOnDestruction = false;  // We don't own the data
+
+        HeightmapStreamer streamer( this, imageName );
+        streamer.headerDecoded( header );
+        streamer.rowsDecoded( header.box, 0u, 0u, 0u );
+        streamer.upload();
+
+        finishCreatingHeightmap( bMinimizeMemoryConsumption, bLowResShadow );
+    }
+    //-----------------------------------------------------------------------------------
+    void Terra::createHeightmapStreaming( DataStreamPtr &stream, const String &imageName,
+                                          bool bMinimizeMemoryConsumption, bool bLowResShadow )
+    {
+        HeightmapStreamer streamer( this, imageName );
+        Image2::decodeStreaming( stream, imageName, &streamer );
+        streamer.upload();
 
+        finishCreatingHeightmap( bMinimizeMemoryConsumption, bLowResShadow );
+    }
+    //-----------------------------------------------------------------------------------
+    void Terra::finishCreatingHeightmap( bool bMinimizeMemoryConsumption, bool bLowResShadow )
+    {
         m_xzRelativeSize =
             m_xzDimensions / Vector2( static_cast<Real>( m_width ), static_cast<Real>( m_depth ) );
 
@@ -709,14 +799,23 @@ namespace Ogre
     void Terra::load( const String &texName, const Vector3 &center, const Vector3 &dimensions,
                       bool bMinimizeMemoryConsumption, bool bLowResShadow )
     {
-        Ogre::Image2 image;
-        image.load( texName, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
+        DataStreamPtr stream = ResourceGroupManager::getSingleton().openResource(
+            texName, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
 
-        load( image, center, dimensions, bMinimizeMemoryConsumption, bLowResShadow, texName );
+        setTerrainDimensions( center, dimensions );
+        createHeightmapStreaming( stream, texName, bMinimizeMemoryConsumption, bLowResShadow );
+        createTerrainCells();
     }
     //-----------------------------------------------------------------------------------
     void Terra::load( Image2 &image, Vector3 center, Vector3 dimensions, bool bMinimizeMemoryConsumption,
                       bool bLowResShadow, const String &imageName )
+    {
+        setTerrainDimensions( center, dimensions );
+        createHeightmap( image, imageName, bMinimizeMemoryConsumption, bLowResShadow );
+        createTerrainCells();
+    }
+    //-----------------------------------------------------------------------------------
+    void Terra::setTerrainDimensions( Vector3 center, Vector3 dimensions )
     {
         // Use sign-preserving because origin in XZ plane is always from
         // bottom-left to top-right.
@@ -728,8 +827,6 @@ namespace Ogre
         m_xzInvDimensions = 1.0f / m_xzDimensions;
         m_height = dimensions.y;
         m_basePixelDimension = 64u;
-        createHeightmap( image, imageName, bMinimizeMemoryConsumption, bLowResShadow );
-        createTerrainCells();
     }
     //-----------------------------------------------------------------------------------
     void Terra::setBasePixelDimension( uint32 basePixelDimension )
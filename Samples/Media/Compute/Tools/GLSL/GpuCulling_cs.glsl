@@ -0,0 +1,150 @@
+#version 430
+
+@property( syntax != glslvk )
+	#define texture2D sampler2D
+@end
+
+@property( syntax == glsl )
+	#define ogre_U0 binding = 0
+	#define ogre_U1 binding = 1
+	#define ogre_U2 binding = 2
+@end
+
+struct ObjectBounds
+{
+	vec3 center;
+	uint visibilityFlags;
+	vec3 halfSize;
+	uint padding;
+};
+
+layout( std430, ogre_U0 ) readonly restrict buffer objectBoundsLayout
+{
+	ObjectBounds objectBounds[];
+};
+
+/// 6 uints per draw: indexCount, instanceCount, firstIndex, baseVertex, baseInstance, objectSlot
+layout( std430, ogre_U1 ) readonly restrict buffer drawEntriesLayout
+{
+	uint drawEntries[];
+};
+
+layout( std430, ogre_U2 ) writeonly restrict buffer culledDrawArgsLayout
+{
+	uint culledDrawArgs[];
+};
+
+@property( use_hiz )
+	vulkan_layout( ogre_t0 ) uniform texture2D hiZTex;
+@end
+
+vulkan( layout( ogre_P0 ) uniform Params { )
+	uniform vec4 frustumPlanes[6];
+	uniform uvec2 numDraws_visibilityMask;
+@property( use_hiz )
+	uniform mat4 viewProjMatrix;
+	uniform vec4 hiZSize_maxMip_depthScale;
+	uniform uint reverseDepth;
+@end
+vulkan( }; )
+
+layout( local_size_x = @value( threads_per_group_x ),
+        local_size_y = @value( threads_per_group_y ),
+        local_size_z = @value( threads_per_group_z ) ) in;
+
+bool isInsideFrustum( vec3 center, vec3 halfSize )
+{
+	for( int i = 0; i < 6; ++i )
+	{
+		float dist = dot( frustumPlanes[i].xyz, center ) + frustumPlanes[i].w;
+		float maxAbsDist = dot( abs( frustumPlanes[i].xyz ), halfSize );
+		if( dist < -maxAbsDist )
+			return false;
+	}
+	return true;
+}
+
+@property( use_hiz )
+bool isOccluded( vec3 center, vec3 halfSize )
+{
+	vec2 minUv = vec2( 1.0, 1.0 );
+	vec2 maxUv = vec2( 0.0, 0.0 );
+	float closestDepth = reverseDepth != 0u ? 0.0 : 1.0;
+
+	for( int i = 0; i < 8; ++i )
+	{
+		vec3 corner = center + halfSize * vec3( ( i & 1 ) != 0 ? 1.0 : -1.0,
+												( i & 2 ) != 0 ? 1.0 : -1.0,
+												( i & 4 ) != 0 ? 1.0 : -1.0 );
+		vec4 clipPos = viewProjMatrix * vec4( corner, 1.0 );
+
+		// Crosses the near plane. Can't project it reliably; assume visible
+		if( clipPos.w <= 0.0 )
+			return false;
+
+		vec3 ndc = clipPos.xyz / clipPos.w;
+	@property( syntax == glsl )
+		vec2 uv = ndc.xy * 0.5 + 0.5;
+	@else
+		vec2 uv = ndc.xy * vec2( 0.5, -0.5 ) + 0.5;
+	@end
+		minUv = min( minUv, uv );
+		maxUv = max( maxUv, uv );
+
+		float depth = hiZSize_maxMip_depthScale.w == 1.0 ? ndc.z : ndc.z * 0.5 + 0.5;
+		closestDepth = reverseDepth != 0u ? max( closestDepth, depth ) : min( closestDepth, depth );
+	}
+
+	minUv = clamp( minUv, 0.0, 1.0 );
+	maxUv = clamp( maxUv, 0.0, 1.0 );
+
+	// Pick the mip where the rect covers at most 2x2 texels
+	vec2 sizeInTexels = ( maxUv - minUv ) * hiZSize_maxMip_depthScale.xy;
+	float mip = ceil( log2( max( max( sizeInTexels.x, sizeInTexels.y ), 1.0 ) ) );
+	mip = clamp( mip, 0.0, hiZSize_maxMip_depthScale.z );
+
+	ivec2 mipSize = max( ivec2( hiZSize_maxMip_depthScale.xy ) >> int( mip ), ivec2( 1, 1 ) );
+	ivec2 minTexel = clamp( ivec2( minUv * vec2( mipSize ) ), ivec2( 0, 0 ), mipSize - 1 );
+	ivec2 maxTexel = clamp( ivec2( maxUv * vec2( mipSize ) ), ivec2( 0, 0 ), mipSize - 1 );
+
+	float d0 = texelFetch( hiZTex, ivec2( minTexel.x, minTexel.y ), int( mip ) ).x;
+	float d1 = texelFetch( hiZTex, ivec2( maxTexel.x, minTexel.y ), int( mip ) ).x;
+	float d2 = texelFetch( hiZTex, ivec2( minTexel.x, maxTexel.y ), int( mip ) ).x;
+	float d3 = texelFetch( hiZTex, ivec2( maxTexel.x, maxTexel.y ), int( mip ) ).x;
+
+	if( reverseDepth != 0u )
+	{
+		float farthestOccluder = min( min( d0, d1 ), min( d2, d3 ) );
+		return closestDepth < farthestOccluder;
+	}
+	else
+	{
+		float farthestOccluder = max( max( d0, d1 ), max( d2, d3 ) );
+		return closestDepth > farthestOccluder;
+	}
+}
+@end
+
+void main()
+{
+	uint drawIdx = gl_GlobalInvocationID.x;
+	if( drawIdx >= numDraws_visibilityMask.x )
+		return;
+
+	uint entryStart = drawIdx * 6u;
+	ObjectBounds obj = objectBounds[drawEntries[entryStart + 5u]];
+
+	bool isVisible = ( obj.visibilityFlags & numDraws_visibilityMask.y ) != 0u &&
+					 isInsideFrustum( obj.center, obj.halfSize );
+@property( use_hiz )
+	if( isVisible )
+		isVisible = !isOccluded( obj.center, obj.halfSize );
+@end
+
+	uint argsStart = drawIdx * 5u;
+	culledDrawArgs[argsStart + 0u] = drawEntries[entryStart + 0u];
+	culledDrawArgs[argsStart + 1u] = isVisible ? drawEntries[entryStart + 1u] : 0u;
+	culledDrawArgs[argsStart + 2u] = drawEntries[entryStart + 2u];
+	culledDrawArgs[argsStart + 3u] = drawEntries[entryStart + 3u];
+	culledDrawArgs[argsStart + 4u] = drawEntries[entryStart + 4u];
+}
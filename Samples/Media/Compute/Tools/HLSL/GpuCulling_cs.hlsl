@@ -0,0 +1,118 @@
+struct ObjectBounds
+{
+	float3 center;
+	uint visibilityFlags;
+	float3 halfSize;
+	uint padding;
+};
+
+RWStructuredBuffer<ObjectBounds> objectBounds	: register(u0);
+/// 6 uints per draw: indexCount, instanceCount, firstIndex, baseVertex, baseInstance, objectSlot
+RWStructuredBuffer<uint> drawEntries			: register(u1);
+RWStructuredBuffer<uint> culledDrawArgs			: register(u2);
+
+@property( use_hiz )
+	Texture2D<float> hiZTex : register(t0);
+@end
+
+uniform float4 frustumPlanes[6];
+uniform uint2 numDraws_visibilityMask;
+@property( use_hiz )
+	uniform float4x4 viewProjMatrix;
+	uniform float4 hiZSize_maxMip_depthScale;
+	uniform uint reverseDepth;
+@end
+
+bool isInsideFrustum( float3 center, float3 halfSize )
+{
+	for( int i = 0; i < 6; ++i )
+	{
+		float dist = dot( frustumPlanes[i].xyz, center ) + frustumPlanes[i].w;
+		float maxAbsDist = dot( abs( frustumPlanes[i].xyz ), halfSize );
+		if( dist < -maxAbsDist )
+			return false;
+	}
+	return true;
+}
+
+@property( use_hiz )
+bool isOccluded( float3 center, float3 halfSize )
+{
+	float2 minUv = float2( 1.0, 1.0 );
+	float2 maxUv = float2( 0.0, 0.0 );
+	float closestDepth = reverseDepth != 0u ? 0.0 : 1.0;
+
+	for( int i = 0; i < 8; ++i )
+	{
+		float3 corner = center + halfSize * float3( ( i & 1 ) != 0 ? 1.0 : -1.0,
+													( i & 2 ) != 0 ? 1.0 : -1.0,
+													( i & 4 ) != 0 ? 1.0 : -1.0 );
+		float4 clipPos = mul( viewProjMatrix, float4( corner, 1.0 ) );
+
+		// Crosses the near plane. Can't project it reliably; assume visible
+		if( clipPos.w <= 0.0 )
+			return false;
+
+		float3 ndc = clipPos.xyz / clipPos.w;
+		float2 uv = ndc.xy * float2( 0.5, -0.5 ) + 0.5;
+		minUv = min( minUv, uv );
+		maxUv = max( maxUv, uv );
+
+		float depth = hiZSize_maxMip_depthScale.w == 1.0 ? ndc.z : ndc.z * 0.5 + 0.5;
+		closestDepth = reverseDepth != 0u ? max( closestDepth, depth ) : min( closestDepth, depth );
+	}
+
+	minUv = saturate( minUv );
+	maxUv = saturate( maxUv );
+
+	// Pick the mip where the rect covers at most 2x2 texels
+	float2 sizeInTexels = ( maxUv - minUv ) * hiZSize_maxMip_depthScale.xy;
+	float mip = ceil( log2( max( max( sizeInTexels.x, sizeInTexels.y ), 1.0 ) ) );
+	mip = clamp( mip, 0.0, hiZSize_maxMip_depthScale.z );
+
+	int2 mipSize = max( int2( hiZSize_maxMip_depthScale.xy ) >> int( mip ), int2( 1, 1 ) );
+	int2 minTexel = clamp( int2( minUv * float2( mipSize ) ), int2( 0, 0 ), mipSize - 1 );
+	int2 maxTexel = clamp( int2( maxUv * float2( mipSize ) ), int2( 0, 0 ), mipSize - 1 );
+
+	float d0 = hiZTex.Load( int3( minTexel.x, minTexel.y, int( mip ) ) ).x;
+	float d1 = hiZTex.Load( int3( maxTexel.x, minTexel.y, int( mip ) ) ).x;
+	float d2 = hiZTex.Load( int3( minTexel.x, maxTexel.y, int( mip ) ) ).x;
+	float d3 = hiZTex.Load( int3( maxTexel.x, maxTexel.y, int( mip ) ) ).x;
+
+	if( reverseDepth != 0u )
+	{
+		float farthestOccluder = min( min( d0, d1 ), min( d2, d3 ) );
+		return closestDepth < farthestOccluder;
+	}
+	else
+	{
+		float farthestOccluder = max( max( d0, d1 ), max( d2, d3 ) );
+		return closestDepth > farthestOccluder;
+	}
+}
+@end
+
+[numthreads(@value( threads_per_group_x ), @value( threads_per_group_y ), @value( threads_per_group_z ))]
+void main( uint3 gl_GlobalInvocationID : SV_DispatchThreadId )
+{
+	uint drawIdx = gl_GlobalInvocationID.x;
+	if( drawIdx >= numDraws_visibilityMask.x )
+		return;
+
+	uint entryStart = drawIdx * 6u;
+	ObjectBounds obj = objectBounds[drawEntries[entryStart + 5u]];
+
+	bool isVisible = ( obj.visibilityFlags & numDraws_visibilityMask.y ) != 0u &&
+					 isInsideFrustum( obj.center, obj.halfSize );
+@property( use_hiz )
+	if( isVisible )
+		isVisible = !isOccluded( obj.center, obj.halfSize );
+@end
+
+	uint argsStart = drawIdx * 5u;
+	culledDrawArgs[argsStart + 0u] = drawEntries[entryStart + 0u];
+	culledDrawArgs[argsStart + 1u] = isVisible ? drawEntries[entryStart + 1u] : 0u;
+	culledDrawArgs[argsStart + 2u] = drawEntries[entryStart + 2u];
+	culledDrawArgs[argsStart + 3u] = drawEntries[entryStart + 3u];
+	culledDrawArgs[argsStart + 4u] = drawEntries[entryStart + 4u];
+}
@@ -0,0 +1,130 @@
+#include <metal_stdlib>
+using namespace metal;
+
+struct ObjectBounds
+{
+	packed_float3 center;
+	uint visibilityFlags;
+	packed_float3 halfSize;
+	uint padding;
+};
+
+struct Params
+{
+	float4 frustumPlanes[6];
+	uint2 numDraws_visibilityMask;
+@property( use_hiz )
+	float4x4 viewProjMatrix;
+	float4 hiZSize_maxMip_depthScale;
+	uint reverseDepth;
+@end
+};
+
+static bool isInsideFrustum( float3 center, float3 halfSize, constant Params &p )
+{
+	for( int i = 0; i < 6; ++i )
+	{
+		float dist = dot( p.frustumPlanes[i].xyz, center ) + p.frustumPlanes[i].w;
+		float maxAbsDist = dot( abs( p.frustumPlanes[i].xyz ), halfSize );
+		if( dist < -maxAbsDist )
+			return false;
+	}
+	return true;
+}
+
+@property( use_hiz )
+static bool isOccluded( float3 center, float3 halfSize, constant Params &p,
+						texture2d<float, access::read> hiZTex )
+{
+	float2 minUv = float2( 1.0, 1.0 );
+	float2 maxUv = float2( 0.0, 0.0 );
+	float closestDepth = p.reverseDepth != 0u ? 0.0 : 1.0;
+
+	for( int i = 0; i < 8; ++i )
+	{
+		float3 corner = center + halfSize * float3( ( i & 1 ) != 0 ? 1.0 : -1.0,
+													( i & 2 ) != 0 ? 1.0 : -1.0,
+													( i & 4 ) != 0 ? 1.0 : -1.0 );
+		float4 clipPos = p.viewProjMatrix * float4( corner, 1.0 );
+
+		// Crosses the near plane. Can't project it reliably; assume visible
+		if( clipPos.w <= 0.0 )
+			return false;
+
+		float3 ndc = clipPos.xyz / clipPos.w;
+		float2 uv = ndc.xy * float2( 0.5, -0.5 ) + 0.5;
+		minUv = min( minUv, uv );
+		maxUv = max( maxUv, uv );
+
+		float depth = p.hiZSize_maxMip_depthScale.w == 1.0 ? ndc.z : ndc.z * 0.5 + 0.5;
+		closestDepth = p.reverseDepth != 0u ? max( closestDepth, depth ) : min( closestDepth, depth );
+	}
+
+	minUv = saturate( minUv );
+	maxUv = saturate( maxUv );
+
+	// Pick the mip where the rect covers at most 2x2 texels
+	float2 sizeInTexels = ( maxUv - minUv ) * p.hiZSize_maxMip_depthScale.xy;
+	float mip = ceil( log2( max( max( sizeInTexels.x, sizeInTexels.y ), 1.0 ) ) );
+	mip = clamp( mip, 0.0, p.hiZSize_maxMip_depthScale.z );
+
+	uint lod = uint( mip );
+	int2 mipSize = max( int2( p.hiZSize_maxMip_depthScale.xy ) >> int( lod ), int2( 1, 1 ) );
+	uint2 minTexel = uint2( clamp( int2( minUv * float2( mipSize ) ), int2( 0, 0 ), mipSize - 1 ) );
+	uint2 maxTexel = uint2( clamp( int2( maxUv * float2( mipSize ) ), int2( 0, 0 ), mipSize - 1 ) );
+
+	float d0 = hiZTex.read( uint2( minTexel.x, minTexel.y ), lod ).x;
+	float d1 = hiZTex.read( uint2( maxTexel.x, minTexel.y ), lod ).x;
+	float d2 = hiZTex.read( uint2( minTexel.x, maxTexel.y ), lod ).x;
+	float d3 = hiZTex.read( uint2( maxTexel.x, maxTexel.y ), lod ).x;
+
+	if( p.reverseDepth != 0u )
+	{
+		float farthestOccluder = min( min( d0, d1 ), min( d2, d3 ) );
+		return closestDepth < farthestOccluder;
+	}
+	else
+	{
+		float farthestOccluder = max( max( d0, d1 ), max( d2, d3 ) );
+		return closestDepth > farthestOccluder;
+	}
+}
+@end
+
+kernel void main_metal
+(
+	device const ObjectBounds *objectBounds	[[buffer(UAV_SLOT_START+0)]],
+	// 6 uints per draw: indexCount, instanceCount, firstIndex, baseVertex, baseInstance, objectSlot
+	device const uint *drawEntries			[[buffer(UAV_SLOT_START+1)]],
+	device uint *culledDrawArgs				[[buffer(UAV_SLOT_START+2)]],
+
+@property( use_hiz )
+	texture2d<float, access::read> hiZTex	[[texture(0)]],
+@end
+
+	constant Params &p						[[buffer(PARAMETER_SLOT)]],
+
+	uint3 gl_GlobalInvocationID			[[thread_position_in_grid]]
+)
+{
+	uint drawIdx = gl_GlobalInvocationID.x;
+	if( drawIdx >= p.numDraws_visibilityMask.x )
+		return;
+
+	uint entryStart = drawIdx * 6u;
+	ObjectBounds obj = objectBounds[drawEntries[entryStart + 5u]];
+
+	bool isVisible = ( obj.visibilityFlags & p.numDraws_visibilityMask.y ) != 0u &&
+					 isInsideFrustum( float3( obj.center ), float3( obj.halfSize ), p );
+@property( use_hiz )
+	if( isVisible )
+		isVisible = !isOccluded( float3( obj.center ), float3( obj.halfSize ), p, hiZTex );
+@end
+
+	uint argsStart = drawIdx * 5u;
+	culledDrawArgs[argsStart + 0u] = drawEntries[entryStart + 0u];
+	culledDrawArgs[argsStart + 1u] = isVisible ? drawEntries[entryStart + 1u] : 0u;
+	culledDrawArgs[argsStart + 2u] = drawEntries[entryStart + 2u];
+	culledDrawArgs[argsStart + 3u] = drawEntries[entryStart + 3u];
+	culledDrawArgs[argsStart + 4u] = drawEntries[entryStart + 4u];
+}
@@ -0,0 +1,63 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ArrayMathTests_H__
+#define __ArrayMathTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class ArrayMathTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(ArrayMathTests);
+    CPPUNIT_TEST(testMatrixAoSRoundtrip);
+    CPPUNIT_TEST(testBooleanMask);
+    CPPUNIT_TEST(testCollapse);
+    CPPUNIT_TEST(testRayIntersects);
+    CPPUNIT_TEST(testRayIntersectsFlatAabb);
+    CPPUNIT_TEST(testTransformCullBenchmark);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testMatrixAoSRoundtrip();
+    void testBooleanMask();
+    void testCollapse();
+    /// Compares ArrayRay::intersects against Math::intersects( Ray, AxisAlignedBox )
+    void testRayIntersects();
+    /// Zero-thickness Aabbs and rays grazing or lying on an Aabb's face must hit
+    void testRayIntersectsFlatAabb();
+    /// Times a transform + world bounds + frustum cull pass over 100k nodes,
+    /// roughly what SceneManager does every frame. Prints the result so the
+    /// SSE2 and AVX2 backends (OGRE_SIMD_AVX2) can be compared.
+    void testTransformCullBenchmark();
+};
+
+#endif
@@ -48,6 +48,8 @@ class FileSystemArchiveTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testFindFileInfoNonRecursive);
     CPPUNIT_TEST(testFindFileInfoRecursive);
     CPPUNIT_TEST(testFileRead);
+    CPPUNIT_TEST(testFileReadMemoryMapped);
+    CPPUNIT_TEST(testImageReadMemoryMapped);
     CPPUNIT_TEST(testReadInterleave);
     CPPUNIT_TEST(testCreateAndRemoveFile);
     CPPUNIT_TEST_SUITE_END();
@@ -70,6 +72,8 @@ public:
     void testFindFileInfoNonRecursive();
     void testFindFileInfoRecursive();
     void testFileRead();
+    void testFileReadMemoryMapped();
+    void testImageReadMemoryMapped();
     void testReadInterleave();
     void testCreateAndRemoveFile();
 };
@@ -56,6 +56,7 @@ class RenderSystemCapabilitiesTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testWriteAllFalseCapabilities);
     CPPUNIT_TEST(testWriteAllTrueCapabilities);
     CPPUNIT_TEST(testWriteAndReadComplexCapabilities);
+    CPPUNIT_TEST(testWriteAndReadHlmsCapabilities);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -81,6 +82,8 @@ public:
 
     // Test serializing to and from the file
     void testWriteAndReadComplexCapabilities();
+    // Capabilities Hlms generates different shaders for
+    void testWriteAndReadHlmsCapabilities();
 
     // For serializing .rendercaps we need RSCManager
     RenderSystemCapabilitiesManager* mRenderSystemCapabilitiesManager;
@@ -0,0 +1,396 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ArrayMathTests.h"
+
+#include "Math/Array/OgreArrayAabb.h"
+#include "Math/Array/OgreArrayMatrix4.h"
+#include "Math/Array/OgreArrayMatrixAf4x3.h"
+#include "Math/Array/OgreArrayQuaternion.h"
+#include "Math/Array/OgreArrayRay.h"
+#include "Math/Array/OgreArrayVector3.h"
+#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreMathlib.h"
+#include "OgreAxisAlignedBox.h"
+#include "OgreLogManager.h"
+#include "OgreMath.h"
+#include "OgreRay.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayMathTests);
+
+//--------------------------------------------------------------------------
+void ArrayMathTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testMatrixAoSRoundtrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OGRE_SIMD_ALIGNED_DECL( Matrix4, src[ARRAY_PACKED_REALS] );
+    OGRE_SIMD_ALIGNED_DECL( Matrix4, dst[ARRAY_PACKED_REALS] );
+
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        for( size_t j = 0; j < 16u; ++j )
+            src[i][0][j] = Real( i * 100u + j );
+    }
+
+    ArrayMatrix4 arrayMat;
+    arrayMat.loadFromAoS( src );
+    arrayMat.storeToAoS( dst );
+
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        Matrix4 mat;
+        arrayMat.getAsMatrix4( mat, i );
+        CPPUNIT_ASSERT( mat == src[i] );
+        CPPUNIT_ASSERT( dst[i] == src[i] );
+    }
+
+    // Affine version. The last row must come back as ( 0, 0, 0, 1 )
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        src[i][3][0] = 0;
+        src[i][3][1] = 0;
+        src[i][3][2] = 0;
+        src[i][3][3] = 1;
+    }
+
+    ArrayMatrixAf4x3 arrayMatAf;
+    arrayMatAf.loadFromAoS( src );
+    arrayMatAf.streamToAoS( dst );
+
+    OGRE_SIMD_ALIGNED_DECL( SimpleMatrixAf4x3, simpleMats[ARRAY_PACKED_REALS] );
+    arrayMatAf.storeToAoS( simpleMats );
+
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        CPPUNIT_ASSERT( dst[i] == src[i] );
+        Matrix4 mat;
+        simpleMats[i].store( &mat );
+        CPPUNIT_ASSERT( mat == src[i] );
+    }
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testBooleanMask()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    bool booleans[ARRAY_PACKED_REALS];
+    bool allSet[ARRAY_PACKED_REALS];
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        booleans[i] = ( i % 3u ) == 0u;
+        allSet[i] = true;
+    }
+
+    const uint32 scalarMask = BooleanMask4::getScalarMask( BooleanMask4::getMask( booleans ) );
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        CPPUNIT_ASSERT_EQUAL( booleans[i], IS_BIT_SET( i, scalarMask ) );
+
+    CPPUNIT_ASSERT( BooleanMask4::allBitsSet( allSet, allSet ) );
+    CPPUNIT_ASSERT( !BooleanMask4::allBitsSet( allSet, booleans ) );
+    CPPUNIT_ASSERT_EQUAL( ( 1u << ARRAY_PACKED_REALS ) - 1u,
+                          BooleanMask4::getScalarMask( BooleanMask4::getAllSetMask() ) );
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testCollapse()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ArrayVector3 arrayVec;
+    Vector3 expectedMin( Math::POS_INFINITY );
+    Vector3 expectedMax( Math::NEG_INFINITY );
+
+    for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+    {
+        const Vector3 v( Math::RangeRandom( -100.0f, 100.0f ), Math::RangeRandom( -100.0f, 100.0f ),
+                         Math::RangeRandom( -100.0f, 100.0f ) );
+        arrayVec.setFromVector3( v, i );
+        expectedMin.makeFloor( v );
+        expectedMax.makeCeil( v );
+    }
+
+    CPPUNIT_ASSERT( arrayVec.collapseMin() == expectedMin );
+    CPPUNIT_ASSERT( arrayVec.collapseMax() == expectedMax );
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testRayIntersects()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    size_t numHits = 0;
+
+    for( size_t i = 0; i < 1000; ++i )
+    {
+        const Aabb aabb( Vector3( Math::RangeRandom( -10.0f, 10.0f ), Math::RangeRandom( -10.0f, 10.0f ),
+                                  Math::RangeRandom( -10.0f, 10.0f ) ),
+                         Vector3( Math::RangeRandom( 0.1f, 5.0f ), Math::RangeRandom( 0.1f, 5.0f ),
+                                  Math::RangeRandom( 0.1f, 5.0f ) ) );
+        ArrayAabb arrayAabb( ArrayVector3::ZERO, ArrayVector3::ZERO );
+        arrayAabb.setAll( aabb );
+
+        Ray rays[ARRAY_PACKED_REALS];
+        ArrayRay arrayRay;
+        ArrayVector3 invDir;
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            // Every 4th iteration, make the rays parallel to the XY plane
+            Vector3 dir( Math::RangeRandom( -1.0f, 1.0f ), Math::RangeRandom( -1.0f, 1.0f ),
+                         ( i % 4u ) ? Math::RangeRandom( -1.0f, 1.0f ) : 0.0f );
+            dir.normalise();
+            rays[j] = Ray( Vector3( Math::RangeRandom( -20.0f, 20.0f ),
+                                    Math::RangeRandom( -20.0f, 20.0f ),
+                                    Math::RangeRandom( -20.0f, 20.0f ) ),
+                           dir );
+            arrayRay.mOrigin.setFromVector3( rays[j].getOrigin(), j );
+            arrayRay.mDirection.setFromVector3( dir, j );
+            invDir.setFromVector3( Vector3( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z ), j );
+        }
+
+        ArrayReal distance;
+        const uint32 mask = BooleanMask4::getScalarMask( arrayRay.intersects( arrayAabb ) );
+        const uint32 maskDist =
+            BooleanMask4::getScalarMask( arrayRay.intersects( arrayAabb, invDir, distance ) );
+        OGRE_ALIGNED_DECL( Real, scalarDistance[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        CastArrayToReal( scalarDistance, distance );
+
+        CPPUNIT_ASSERT_EQUAL( mask, maskDist );
+
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            const std::pair<bool, Real> expected = Math::intersects(
+                rays[j], AxisAlignedBox( aabb.getMinimum(), aabb.getMaximum() ) );
+            CPPUNIT_ASSERT_EQUAL( expected.first, IS_BIT_SET( j, mask ) );
+            if( expected.first )
+            {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL( expected.second, scalarDistance[j], 1e-3f );
+                ++numHits;
+            }
+        }
+    }
+
+    // Make sure the test is meaningful
+    CPPUNIT_ASSERT( numHits > 0u );
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testRayIntersectsFlatAabb()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Flat on Z
+    const Aabb flatAabb( Vector3( 1.0f, 2.0f, 3.0f ), Vector3( 2.0f, 1.0f, 0.0f ) );
+    ArrayAabb arrayAabb( ArrayVector3::ZERO, ArrayVector3::ZERO );
+    arrayAabb.setAll( flatAabb );
+
+    size_t numHits = 0;
+
+    for( size_t i = 0; i < 1000; ++i )
+    {
+        Ray rays[ARRAY_PACKED_REALS];
+        Vector3 targets[ARRAY_PACKED_REALS];
+        ArrayRay arrayRay;
+        ArrayVector3 invDir;
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            // Aim at random points around the Aabb's plane so plenty of rays hit
+            const Vector3 origin( Math::RangeRandom( -10.0f, 10.0f ), Math::RangeRandom( -10.0f, 10.0f ),
+                                  Math::RangeRandom( -10.0f, 10.0f ) );
+            const Vector3 target( Math::RangeRandom( -2.0f, 4.0f ), Math::RangeRandom( 0.0f, 4.0f ),
+                                  3.0f );
+            targets[j] = target;
+            rays[j] = Ray( origin, ( target - origin ).normalisedCopy() );
+            const Vector3 dir = rays[j].getDirection();
+            arrayRay.mOrigin.setFromVector3( origin, j );
+            arrayRay.mDirection.setFromVector3( dir, j );
+            invDir.setFromVector3( Vector3( 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z ), j );
+        }
+
+        ArrayReal distance;
+        const uint32 mask =
+            BooleanMask4::getScalarMask( arrayRay.intersects( arrayAabb, invDir, distance ) );
+        OGRE_ALIGNED_DECL( Real, scalarDistance[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        CastArrayToReal( scalarDistance, distance );
+
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            // Skip targets right at the edges, where rounding decides either way
+            if( Math::Abs( Math::Abs( targets[j].x - 1.0f ) - 2.0f ) < 1e-3f ||
+                Math::Abs( Math::Abs( targets[j].y - 2.0f ) - 1.0f ) < 1e-3f )
+            {
+                continue;
+            }
+            const std::pair<bool, Real> expected = Math::intersects(
+                rays[j], AxisAlignedBox( flatAabb.getMinimum(), flatAabb.getMaximum() ) );
+            CPPUNIT_ASSERT_EQUAL( expected.first, IS_BIT_SET( j, mask ) );
+            if( expected.first )
+            {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL( expected.second, scalarDistance[j], 1e-3f );
+                ++numHits;
+            }
+        }
+    }
+
+    CPPUNIT_ASSERT( numHits > 0u );
+
+    // Rays parallel to the flat Aabb. Directions with zeroes produce 0 * inf = NaN in the slabs
+    // whose planes contain the origin
+    const Vector3 origins[4] = {
+        Vector3( -5.0f, 2.0f, 3.0f ),  // In the Aabb's plane, heading towards it
+        Vector3( -5.0f, 2.0f, 3.5f ),  // Above the Aabb's plane
+        Vector3( -5.0f, 3.0f, 3.0f ),  // In the Aabb's plane, grazing its max Y edge
+        Vector3( -5.0f, 3.5f, 3.0f ),  // In the Aabb's plane, but past its max Y edge
+    };
+    const bool expectedHit[4] = { true, false, true, false };
+
+    for( size_t i = 0; i < 4u; ++i )
+    {
+        ArrayVector3 origin;
+        origin.setAll( origins[i] );
+        const ArrayRay arrayRay( origin, ArrayVector3::UNIT_X );
+        const ArrayVector3 invDir = Mathlib::SetAll( 1.0f ) / arrayRay.mDirection;
+
+        ArrayReal distance;
+        const uint32 mask =
+            BooleanMask4::getScalarMask( arrayRay.intersects( arrayAabb, invDir, distance ) );
+        OGRE_ALIGNED_DECL( Real, scalarDistance[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        CastArrayToReal( scalarDistance, distance );
+
+        CPPUNIT_ASSERT_EQUAL( expectedHit[i], IS_BIT_SET( 0u, mask ) );
+        if( expectedHit[i] )
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( 4.0f, scalarDistance[0], 1e-5f );
+    }
+}
+//--------------------------------------------------------------------------
+void ArrayMathTests::testTransformCullBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numNodes = 100000u;
+    const size_t numBlocks = ( numNodes + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+    const size_t numIterations = 20u;
+
+    ArrayVector3 *positions = OGRE_ALLOC_T_SIMD( ArrayVector3, numBlocks, MEMCATEGORY_GENERAL );
+    ArrayVector3 *scales = OGRE_ALLOC_T_SIMD( ArrayVector3, numBlocks, MEMCATEGORY_GENERAL );
+    ArrayQuaternion *orientations =
+        OGRE_ALLOC_T_SIMD( ArrayQuaternion, numBlocks, MEMCATEGORY_GENERAL );
+    ArrayAabb *localAabbs = OGRE_ALLOC_T_SIMD( ArrayAabb, numBlocks, MEMCATEGORY_GENERAL );
+    ArrayAabb *worldAabbs = OGRE_ALLOC_T_SIMD( ArrayAabb, numBlocks, MEMCATEGORY_GENERAL );
+
+    for( size_t i = 0; i < numBlocks; ++i )
+    {
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            positions[i].setFromVector3( Vector3( Math::RangeRandom( -500.0f, 500.0f ),
+                                                  Math::RangeRandom( -500.0f, 500.0f ),
+                                                  Math::RangeRandom( -500.0f, 500.0f ) ),
+                                         j );
+            scales[i].setFromVector3( Vector3( Math::RangeRandom( 0.5f, 2.0f ) ), j );
+            orientations[i].setFromQuaternion(
+                Quaternion( Radian( Math::RangeRandom( 0.0f, Math::TWO_PI ) ), Vector3::UNIT_Y ),
+                j );
+            localAabbs[i].setFromAabb( Aabb( Vector3::ZERO, Vector3( 1.0f ) ), j );
+        }
+    }
+
+    // Axis-aligned "frustum": a box from -250 to 250 in every axis
+    const Vector3 normals[6] = { Vector3::UNIT_X, Vector3::NEGATIVE_UNIT_X,
+                                 Vector3::UNIT_Y, Vector3::NEGATIVE_UNIT_Y,
+                                 Vector3::UNIT_Z, Vector3::NEGATIVE_UNIT_Z };
+    ArrayVector3 planeNormals[6];
+    ArrayVector3 signFlips[6];
+    const ArrayReal planeNegD = Mathlib::SetAll( -250.0f );
+    for( size_t p = 0; p < 6u; ++p )
+    {
+        planeNormals[p].setAll( normals[p] );
+        signFlips[p].setAll( normals[p] );
+        signFlips[p].setToSign();
+    }
+
+    size_t numVisible = 0;
+    Timer timer;
+
+    for( size_t it = 0; it < numIterations; ++it )
+    {
+        numVisible = 0;
+        for( size_t i = 0; i < numBlocks; ++i )
+        {
+            ArrayMatrix4 worldMat;
+            worldMat.makeTransform( positions[i], scales[i], orientations[i] );
+
+            worldAabbs[i] = localAabbs[i];
+            worldAabbs[i].transformAffine( worldMat );
+
+            // Same test as MovableObject::cullFrustum
+            ArrayMaskR isVisible = BooleanMask4::getAllSetMask();
+            for( size_t p = 0; p < 6u; ++p )
+            {
+                const ArrayVector3 centerPlusFlippedHS =
+                    worldAabbs[i].mCenter + worldAabbs[i].mHalfSize * signFlips[p];
+                const ArrayReal dotResult = planeNormals[p].dotProduct( centerPlusFlippedHS );
+                isVisible = Mathlib::And( isVisible, Mathlib::CompareGreater( dotResult, planeNegD ) );
+            }
+
+            const uint32 scalarMask = BooleanMask4::getScalarMask( isVisible );
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                numVisible += IS_BIT_SET( j, scalarMask ) ? 1u : 0u;
+        }
+    }
+
+    const uint64 elapsed = timer.getMicroseconds();
+
+    LogManager::getSingleton().logMessage(
+        "ArrayMath (ARRAY_PACKED_REALS = " + StringConverter::toString( ARRAY_PACKED_REALS ) +
+        "): " + StringConverter::toString( numNodes ) + " nodes x " +
+        StringConverter::toString( numIterations ) + " iterations in " +
+        StringConverter::toString( elapsed ) + " us (" +
+        StringConverter::toString( elapsed / numIterations ) + " us per pass). " +
+        StringConverter::toString( numVisible ) + " visible" );
+
+    // Roughly 1/8th of the nodes are inside the box. Make sure culling did something sane
+    CPPUNIT_ASSERT( numVisible > 0u && numVisible < numBlocks * ARRAY_PACKED_REALS );
+
+    OGRE_FREE_SIMD( worldAabbs, MEMCATEGORY_GENERAL );
+    OGRE_FREE_SIMD( localAabbs, MEMCATEGORY_GENERAL );
+    OGRE_FREE_SIMD( orientations, MEMCATEGORY_GENERAL );
+    OGRE_FREE_SIMD( scales, MEMCATEGORY_GENERAL );
+    OGRE_FREE_SIMD( positions, MEMCATEGORY_GENERAL );
+}
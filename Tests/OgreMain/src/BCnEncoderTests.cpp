@@ -0,0 +1,362 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "BCnEncoderTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreBCnEncoder.h"
+#include "OgreTextureBox.h"
+
+#include <cmath>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(BCnEncoderTests);
+
+namespace
+{
+    // Reference decoders, straight from the D3D specification
+
+    void decodeBC1(const uint8 *block, uint8 *outRgba)
+    {
+        const uint16 c0 = static_cast<uint16>(block[0] | (block[1] << 8u));
+        const uint16 c1 = static_cast<uint16>(block[2] | (block[3] << 8u));
+        int palette[4][4];
+        const uint16 c[2] = { c0, c1 };
+        for (int j = 0; j < 2; ++j)
+        {
+            const int r = (c[j] >> 11) & 0x1F, g = (c[j] >> 5) & 0x3F, b = c[j] & 0x1F;
+            palette[j][0] = (r << 3) | (r >> 2);
+            palette[j][1] = (g << 2) | (g >> 4);
+            palette[j][2] = (b << 3) | (b >> 2);
+            palette[j][3] = 255;
+        }
+        for (int ch = 0; ch < 3; ++ch)
+        {
+            if (c0 > c1)
+            {
+                palette[2][ch] = (2 * palette[0][ch] + palette[1][ch]) / 3;
+                palette[3][ch] = (palette[0][ch] + 2 * palette[1][ch]) / 3;
+            }
+            else
+            {
+                palette[2][ch] = (palette[0][ch] + palette[1][ch]) / 2;
+                palette[3][ch] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = c0 > c1 ? 255 : 0;
+
+        const uint32 indices = static_cast<uint32>(block[4] | (block[5] << 8u) | (block[6] << 16u) |
+                                                   (block[7] << 24u));
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int ch = 0; ch < 4; ++ch)
+                outRgba[i * 4 + ch] = static_cast<uint8>(palette[(indices >> (i * 2)) & 0x03][ch]);
+        }
+    }
+
+    void decodeBC4(const uint8 *block, bool isSigned, int *outValues)
+    {
+        const int a0 = isSigned ? static_cast<int8>(block[0]) : block[0];
+        const int a1 = isSigned ? static_cast<int8>(block[1]) : block[1];
+        int palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+        {
+            for (int k = 2; k < 8; ++k)
+                palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+        }
+        else
+        {
+            for (int k = 2; k < 6; ++k)
+                palette[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+            palette[6] = isSigned ? -127 : 0;
+            palette[7] = isSigned ? 127 : 255;
+        }
+
+        uint64 indices = 0;
+        for (int i = 0; i < 6; ++i)
+            indices |= static_cast<uint64>(block[2 + i]) << (i * 8);
+        for (int i = 0; i < 16; ++i)
+            outValues[i] = palette[(indices >> (i * 3)) & 0x07];
+    }
+
+    uint32 getBits(const uint8 *block, uint32 &bitPos, uint32 numBits)
+    {
+        uint32 retVal = 0;
+        for (uint32 b = 0; b < numBits; ++b, ++bitPos)
+            retVal |= ((block[bitPos >> 3u] >> (bitPos & 0x07u)) & 0x01u) << b;
+        return retVal;
+    }
+
+    /// Only supports mode 6
+    void decodeBC7Mode6(const uint8 *block, uint8 *outRgba)
+    {
+        uint32 bitPos = 0;
+        CPPUNIT_ASSERT_EQUAL(64u, getBits(block, bitPos, 7u));
+        int e[2][4];
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            e[0][ch] = static_cast<int>(getBits(block, bitPos, 7u)) << 1;
+            e[1][ch] = static_cast<int>(getBits(block, bitPos, 7u)) << 1;
+        }
+        const int p0 = static_cast<int>(getBits(block, bitPos, 1u));
+        const int p1 = static_cast<int>(getBits(block, bitPos, 1u));
+        for (int ch = 0; ch < 4; ++ch)
+        {
+            e[0][ch] |= p0;
+            e[1][ch] |= p1;
+        }
+
+        static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        for (int i = 0; i < 16; ++i)
+        {
+            const uint32 idx = getBits(block, bitPos, i == 0 ? 3u : 4u);
+            for (int ch = 0; ch < 4; ++ch)
+            {
+                outRgba[i * 4 + ch] = static_cast<uint8>(
+                    ((64 - weights[idx]) * e[0][ch] + weights[idx] * e[1][ch] + 32) >> 6);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(128u, bitPos);
+    }
+
+    double rootMeanSquareError(const uint8 *a, const uint8 *b, size_t count, size_t stride,
+                               size_t numChannels)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                const double diff = double(a[i * stride + ch]) - double(b[i * stride + ch]);
+                sum += diff * diff;
+            }
+        }
+        return std::sqrt(sum / double(count * numChannels));
+    }
+
+    /// Smooth block with some noise, typical of photographic content
+    void makeTestBlock(uint8 *outRgba, uint32 seed)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>((seed >> 24u) & 0x07u) - 4;
+            const int t = (i % 4) * 4 + (i / 4) * 2;
+            outRgba[i * 4 + 0] = static_cast<uint8>(Math::Clamp(60 + t * 2 + noise, 0, 255));
+            outRgba[i * 4 + 1] = static_cast<uint8>(Math::Clamp(40 + t + noise, 0, 255));
+            outRgba[i * 4 + 2] = static_cast<uint8>(Math::Clamp(200 - t + noise, 0, 255));
+            outRgba[i * 4 + 3] = static_cast<uint8>(Math::Clamp(255 - t * 3, 0, 255));
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::testBC1()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint8 src[64];
+    uint8 block[8];
+    uint8 decoded[64];
+
+    // Solid colour: only the 565 quantization error is allowed
+    for (int i = 0; i < 16; ++i)
+    {
+        src[i * 4 + 0] = 200;
+        src[i * 4 + 1] = 100;
+        src[i * 4 + 2] = 50;
+        src[i * 4 + 3] = 255;
+    }
+    BCnEncoder::encodeBlockBC1(src, block);
+    decodeBC1(block, decoded);
+    for (int i = 0; i < 16; ++i)
+    {
+        CPPUNIT_ASSERT(std::abs(decoded[i * 4 + 0] - 200) <= 4);
+        CPPUNIT_ASSERT(std::abs(decoded[i * 4 + 1] - 100) <= 2);
+        CPPUNIT_ASSERT(std::abs(decoded[i * 4 + 2] - 50) <= 4);
+        // Must not have picked the 3-colour mode's transparent entry
+        CPPUNIT_ASSERT_EQUAL(uint8(255), decoded[i * 4 + 3]);
+    }
+
+    for (uint32 seed = 0; seed < 16; ++seed)
+    {
+        makeTestBlock(src, seed);
+        BCnEncoder::encodeBlockBC1(src, block);
+        decodeBC1(block, decoded);
+        CPPUNIT_ASSERT(rootMeanSquareError(src, decoded, 16, 4, 3) < 6.0);
+    }
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::testBC4()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint8 src[16];
+    uint8 block[8];
+    int decoded[16];
+
+    for (int i = 0; i < 16; ++i)
+        src[i] = static_cast<uint8>(i * 17);
+    BCnEncoder::encodeBlockBC4(src, 1u, block);
+    decodeBC4(block, false, decoded);
+    // 8 evenly spaced values over 0..255: error is at most half a step
+    for (int i = 0; i < 16; ++i)
+        CPPUNIT_ASSERT(std::abs(decoded[i] - src[i]) <= 19);
+    CPPUNIT_ASSERT_EQUAL(0, decoded[0]);
+    CPPUNIT_ASSERT_EQUAL(255, decoded[15]);
+
+    // Strided (i.e. alpha channel of RGBA) and constant
+    uint8 rgba[64];
+    for (int i = 0; i < 64; ++i)
+        rgba[i] = (i % 4) == 3 ? 77u : 0u;
+    BCnEncoder::encodeBlockBC4(rgba + 3, 4u, block);
+    decodeBC4(block, false, decoded);
+    for (int i = 0; i < 16; ++i)
+        CPPUNIT_ASSERT_EQUAL(77, decoded[i]);
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::testBC4Snorm()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    int8 src[16];
+    uint8 block[8];
+    int decoded[16];
+
+    for (int i = 0; i < 16; ++i)
+        src[i] = static_cast<int8>(-128 + i * 17);
+    BCnEncoder::encodeBlockBC4Snorm(src, 1u, block);
+    decodeBC4(block, true, decoded);
+    for (int i = 0; i < 16; ++i)
+        CPPUNIT_ASSERT(std::abs(decoded[i] - std::max<int>(src[i], -127)) <= 19);
+    CPPUNIT_ASSERT_EQUAL(-127, decoded[0]);
+    CPPUNIT_ASSERT_EQUAL(127, decoded[15]);
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::testBC7()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint8 src[64];
+    uint8 block[16];
+    uint8 decoded[64];
+
+    for (int i = 0; i < 64; ++i)
+        src[i] = static_cast<uint8>((i % 4) * 60 + 13);
+    BCnEncoder::encodeBlockBC7(src, block);
+    decodeBC7Mode6(block, decoded);
+    for (int i = 0; i < 64; ++i)
+        CPPUNIT_ASSERT(std::abs(decoded[i] - src[i]) <= 1);
+
+    double bc7Error = 0;
+    double bc3Error = 0;
+    for (uint32 seed = 0; seed < 16; ++seed)
+    {
+        makeTestBlock(src, seed);
+        BCnEncoder::encodeBlockBC7(src, block);
+        decodeBC7Mode6(block, decoded);
+        const double error = rootMeanSquareError(src, decoded, 16, 4, 4);
+        CPPUNIT_ASSERT(error < 4.0);
+        bc7Error += error;
+
+        BCnEncoder::encodeBlockBC3(src, block);
+        decodeBC1(block + 8, decoded);
+        bc3Error += rootMeanSquareError(src, decoded, 16, 4, 3);
+    }
+    // BC7 should never be worse than BC3 for the colour channels
+    CPPUNIT_ASSERT(bc7Error <= bc3Error);
+}
+//--------------------------------------------------------------------------
+void BCnEncoderTests::testCompressPartialBlocks()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // 6x6 RGBA8 image; needs 2x2 blocks, the right & bottom ones being partial.
+    // Every block is a different solid colour so that reading the wrong
+    // pixels (or garbage past the borders) is easy to spot.
+    const uint32 width = 6u, height = 6u;
+    uint8 src[width * height * 4u];
+    for (uint32 y = 0; y < height; ++y)
+    {
+        for (uint32 x = 0; x < width; ++x)
+        {
+            uint8 *pixel = &src[(y * width + x) * 4u];
+            pixel[0] = static_cast<uint8>(40 + (x / 4u) * 160);
+            pixel[1] = static_cast<uint8>(40 + (y / 4u) * 160);
+            pixel[2] = 128;
+            pixel[3] = 255;
+        }
+    }
+
+    TextureBox srcBox(width, height, 1u, 1u, 4u, width * 4u, width * height * 4u);
+    srcBox.data = src;
+
+    uint8 dst[4 * 8];
+    memset(dst, 0xCD, sizeof(dst));
+    TextureBox dstBox(width, height, 1u, 1u, 0u, 2u * 8u, 4u * 8u);
+    dstBox.setCompressedPixelFormat(PFG_BC1_UNORM);
+    dstBox.data = dst;
+
+    CPPUNIT_ASSERT(BCnEncoder::isSupported(PFG_RGBA8_UNORM_SRGB, PFG_BC1_UNORM_SRGB));
+    CPPUNIT_ASSERT(!BCnEncoder::isSupported(PFG_RGBA16_FLOAT, PFG_BC1_UNORM));
+    BCnEncoder::compress(srcBox, PFG_RGBA8_UNORM, dstBox, PFG_BC1_UNORM);
+
+    uint8 decoded[64];
+    for (uint32 blockY = 0; blockY < 2u; ++blockY)
+    {
+        for (uint32 blockX = 0; blockX < 2u; ++blockX)
+        {
+            decodeBC1(&dst[(blockY * 2u + blockX) * 8u], decoded);
+            for (uint32 py = 0; py < 4u; ++py)
+            {
+                for (uint32 px = 0; px < 4u; ++px)
+                {
+                    // Pixels outside the image replicate the border
+                    const uint32 x = std::min(blockX * 4u + px, width - 1u);
+                    const uint32 y = std::min(blockY * 4u + py, height - 1u);
+                    const uint8 *expected = &src[(y * width + x) * 4u];
+                    const uint8 *actual = &decoded[(py * 4u + px) * 4u];
+                    for (int ch = 0; ch < 3; ++ch)
+                        CPPUNIT_ASSERT(std::abs(expected[ch] - actual[ch]) <= 8);
+                }
+            }
+        }
+    }
+}
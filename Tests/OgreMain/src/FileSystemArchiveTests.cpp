@@ -29,6 +29,8 @@ THE SOFTWARE.
 #include "OgreFileSystem.h"
 #include "OgreException.h"
 #include "OgreCommon.h"
+#include "OgreImage2.h"
+#include "OgreOITDCodec.h"
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
 #include "macUtils.h"
@@ -298,6 +300,103 @@ void FileSystemArchiveTests::testFileRead()
     CPPUNIT_ASSERT(stream->eof());
 }
 //--------------------------------------------------------------------------
+void FileSystemArchiveTests::testFileReadMemoryMapped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FileSystemArchive arch(mTestPath, "FileSystem", true);
+    arch.load();
+
+    DataStreamPtr stream = arch.openMemoryMapped("rootfile.txt");
+    CPPUNIT_ASSERT(stream);
+    CPPUNIT_ASSERT_EQUAL(arch.open("rootfile.txt")->size(), stream->size());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 1 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 2 in file 1"), stream->getLine());
+    stream->skipLine();
+    stream->skipLine();
+    CPPUNIT_ASSERT_EQUAL(String("this is line 5 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(BLANKSTRING, stream->getLine()); // blank at end of file
+    CPPUNIT_ASSERT(stream->eof());
+
+    // Data is read in place from the mapping
+    MemoryMappedDataStream *mappedStream = static_cast<MemoryMappedDataStream*>(stream.get());
+    stream->seek(0);
+    CPPUNIT_ASSERT(mappedStream->getCurrentPtr() == mappedStream->getPtr());
+    CPPUNIT_ASSERT_EQUAL(0, memcmp(mappedStream->getPtr(), "this is line 1", 14));
+
+    CPPUNIT_ASSERT(!arch.openMemoryMapped("this_file_does_not_exist.txt"));
+}
+//--------------------------------------------------------------------------
+void FileSystemArchiveTests::testImageReadMemoryMapped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FileSystemArchive arch("./", "FileSystem", false);
+    arch.load();
+
+    // 4x4 RGBA8 with 3 mips
+    uint8 pixels[(16u + 4u + 1u) * 4u];
+    for(size_t i = 0; i < sizeof(pixels); ++i)
+        pixels[i] = static_cast<uint8>(i * 7u);
+
+    OITDCodec codec;
+    const bool registerCodec = !Codec::isCodecRegistered(codec.getType());
+    if(registerCodec)
+        Codec::registerCodec(&codec);
+    {
+        ImageCodec2::ImageData2 *imgData = OGRE_NEW ImageCodec2::ImageData2();
+        imgData->box = TextureBox(4u, 4u, 1u, 1u, 4u, 16u, 64u);
+        imgData->box.data = pixels;
+        imgData->textureType = TextureTypes::Type2D;
+        imgData->format = PFG_RGBA8_UNORM;
+        imgData->numMipmaps = 3u;
+        imgData->freeOnDestruction = false;
+
+        MemoryDataStreamPtr input;
+        Codec::CodecDataPtr codecData(imgData);
+        DataStreamPtr encoded = codec.encode(input, codecData);
+
+        DataStreamPtr file = arch.create("a_test_image.oitd");
+        file->write(static_cast<MemoryDataStream*>(encoded.get())->getPtr(), encoded->size());
+        file->close();
+    }
+
+    {
+        DataStreamPtr stream = arch.openMemoryMapped("a_test_image.oitd");
+        CPPUNIT_ASSERT(stream);
+        const uint8 *mappedPtr = static_cast<MemoryMappedDataStream*>(stream.get())->getPtr();
+
+        Image2 image;
+        image.load(stream, "oitd");
+        stream.reset();
+
+        // Pixels are read in place, and stay valid after the stream was released
+        CPPUNIT_ASSERT(image.isMemoryMapped());
+        CPPUNIT_ASSERT(image.getData(0).data > mappedPtr);
+        CPPUNIT_ASSERT_EQUAL((uint8)3u, image.getNumMipmaps());
+        CPPUNIT_ASSERT_EQUAL(sizeof(pixels), image.getSizeBytes());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(image.getData(0).data, pixels, sizeof(pixels)));
+
+        // Copies get their own memory
+        Image2 copy(image);
+        CPPUNIT_ASSERT(!copy.isMemoryMapped());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(copy.getData(0).data, pixels, sizeof(pixels)));
+
+        // Modifying makes a private copy rather than writing to the mapping
+        image.flipAroundX();
+        CPPUNIT_ASSERT(!image.isMemoryMapped());
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(image.getData(0).data, pixels + 48u, 16u));
+        image.flipAroundX();
+        CPPUNIT_ASSERT_EQUAL(0, memcmp(image.getData(0).data, pixels, sizeof(pixels)));
+    }
+
+    if(registerCodec)
+        Codec::unregisterCodec(&codec);
+
+    arch.remove("a_test_image.oitd");
+    CPPUNIT_ASSERT(!arch.exists("a_test_image.oitd"));
+}
+//--------------------------------------------------------------------------
 void FileSystemArchiveTests::testReadInterleave()
 {
     UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
@@ -0,0 +1,670 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "GpuCullingTests.h"
+#include "UnitTestSuite.h"
+
+#include "Compute/OgreGpuCulling.h"
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreId.h"
+#include "OgreLogManager.h"
+#include "OgreMovableObject.h"
+#include "OgrePlane.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include <stddef.h>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(GpuCullingTests);
+
+namespace
+{
+    /// Lets us set the world bounds directly, without needing a SceneManager
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        TestMovableObject(ObjectMemoryManager *objectMemoryManager, uint8 renderQueue,
+                          SceneManager *manager = 0) :
+            MovableObject(Id::generateNewId<MovableObject>(), objectMemoryManager, manager,
+                          renderQueue)
+        {
+            mObjectData.mVisibilityFlags[mObjectData.mIndex] |= VisibilityFlags::LAYER_VISIBILITY;
+        }
+
+        void setWorldAabb(const Aabb &aabb)
+        {
+            mObjectData.mWorldAabb->setFromAabb(aabb, mObjectData.mIndex);
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    /// A box-shaped "frustum" covering [-10; 10] in all axes, normals pointing inwards
+    void makeBoxPlanes(Plane planes[6])
+    {
+        planes[0] = Plane(Vector3::UNIT_X, Vector3(-10, 0, 0));
+        planes[1] = Plane(Vector3::NEGATIVE_UNIT_X, Vector3(10, 0, 0));
+        planes[2] = Plane(Vector3::UNIT_Y, Vector3(0, -10, 0));
+        planes[3] = Plane(Vector3::NEGATIVE_UNIT_Y, Vector3(0, 10, 0));
+        planes[4] = Plane(Vector3::UNIT_Z, Vector3(0, 0, -10));
+        planes[5] = Plane(Vector3::NEGATIVE_UNIT_Z, Vector3(0, 0, 10));
+    }
+
+    /// Returns a Root using the NULL RenderSystem, or null if it's not available
+    Root *createNullRoot()
+    {
+        Root *root = OGRE_NEW Root(0, "plugins" OGRE_BUILD_SUFFIX ".cfg", "", "GpuCullingTests.log");
+
+        RenderSystem *renderSystem = root->getRenderSystemByName("NULL Rendering Subsystem");
+        if (!renderSystem)
+        {
+            OGRE_DELETE root;
+            return 0;
+        }
+
+        root->setRenderSystem(renderSystem);
+        root->initialise(false);
+        root->createRenderWindow("GpuCullingTests", 320u, 240u, false, 0);
+        return root;
+    }
+
+    CbDrawIndexed makeDrawArgs(uint32 idx)
+    {
+        CbDrawIndexed drawArgs;
+        drawArgs.primCount = 36u;
+        drawArgs.instanceCount = 1u;
+        drawArgs.firstVertexIndex = idx * 100u;
+        drawArgs.baseVertex = 0u;
+        drawArgs.baseInstance = idx;
+        return drawArgs;
+    }
+}
+
+//--------------------------------------------------------------------------
+void GpuCullingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testObjectBoundsLayout()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Must match struct ObjectBounds in the GpuCulling_cs shaders (std430)
+    CPPUNIT_ASSERT_EQUAL((size_t)32u, sizeof(GpuCulling::ObjectBounds));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, offsetof(GpuCulling::ObjectBounds, center));
+    CPPUNIT_ASSERT_EQUAL((size_t)12u, offsetof(GpuCulling::ObjectBounds, visibilityFlags));
+    CPPUNIT_ASSERT_EQUAL((size_t)16u, offsetof(GpuCulling::ObjectBounds, halfSize));
+    CPPUNIT_ASSERT_EQUAL((size_t)28u, offsetof(GpuCulling::ObjectBounds, padding));
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testDrawArgsLayout()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // The shaders treat the draw args as 5 consecutive uints, in the order
+    // expected by DrawIndexedInstancedIndirect / glMultiDrawElementsIndirect.
+    // Draw i must start at i * 5 uints
+    CPPUNIT_ASSERT_EQUAL((size_t)20u, sizeof(CbDrawIndexed));
+
+    CbDrawIndexed drawArgs[3];
+    const uint32 *asUints = reinterpret_cast<const uint32*>(drawArgs);
+    for (uint32 i = 0; i < 3u; ++i)
+    {
+        drawArgs[i].primCount = i * 10u + 0u;
+        drawArgs[i].instanceCount = i * 10u + 1u;
+        drawArgs[i].firstVertexIndex = i * 10u + 2u;
+        drawArgs[i].baseVertex = i * 10u + 3u;
+        drawArgs[i].baseInstance = i * 10u + 4u;
+    }
+    for (uint32 i = 0; i < 3u * 5u; ++i)
+        CPPUNIT_ASSERT_EQUAL((i / 5u) * 10u + (i % 5u), asUints[i]);
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testPackObjectBounds()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Aabb aabb(Vector3(1.0f, -2.0f, 3.5f), Vector3(0.5f, 4.0f, 0.25f));
+    const GpuCulling::ObjectBounds bounds = GpuCulling::packObjectBounds(aabb, 0x00F0u);
+
+    CPPUNIT_ASSERT_EQUAL(1.0f, bounds.center[0]);
+    CPPUNIT_ASSERT_EQUAL(-2.0f, bounds.center[1]);
+    CPPUNIT_ASSERT_EQUAL(3.5f, bounds.center[2]);
+    CPPUNIT_ASSERT_EQUAL(0.5f, bounds.halfSize[0]);
+    CPPUNIT_ASSERT_EQUAL(4.0f, bounds.halfSize[1]);
+    CPPUNIT_ASSERT_EQUAL(0.25f, bounds.halfSize[2]);
+    CPPUNIT_ASSERT_EQUAL((uint32)0x00F0u, bounds.visibilityFlags);
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, bounds.padding);
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testFrustumCulling()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Plane planes[6];
+    makeBoxPlanes(planes);
+
+    const uint32 visFlags = 0x01u;
+
+    // Fully inside
+    CPPUNIT_ASSERT(GpuCulling::isVisible(
+        GpuCulling::packObjectBounds(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE), visFlags),
+        planes, 0xFFFFFFFFu));
+    // Intersecting a plane
+    CPPUNIT_ASSERT(GpuCulling::isVisible(
+        GpuCulling::packObjectBounds(Aabb(Vector3(10.5f, 0, 0), Vector3::UNIT_SCALE), visFlags),
+        planes, 0xFFFFFFFFu));
+    // Fully outside
+    CPPUNIT_ASSERT(!GpuCulling::isVisible(
+        GpuCulling::packObjectBounds(Aabb(Vector3(0, 0, -12.0f), Vector3::UNIT_SCALE), visFlags),
+        planes, 0xFFFFFFFFu));
+    // Inside, but rejected by the visibility mask
+    CPPUNIT_ASSERT(!GpuCulling::isVisible(
+        GpuCulling::packObjectBounds(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE), visFlags),
+        planes, 0x02u));
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testDrawEntryLayout()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Must match the 6 uints per draw the GpuCulling_cs shaders read
+    CPPUNIT_ASSERT_EQUAL((size_t)24u, sizeof(GpuCulling::DrawEntry));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, offsetof(GpuCulling::DrawEntry, drawArgs));
+    CPPUNIT_ASSERT_EQUAL((size_t)20u, offsetof(GpuCulling::DrawEntry, slot));
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testOnlyNewObjectsAreGathered()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *objects[3];
+    for (size_t i = 0; i < 3u; ++i)
+    {
+        objects[i] = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+        objects[i]->setWorldAabb(Aabb(Vector3((Real)i, 0, 0), Vector3::UNIT_SCALE));
+    }
+
+    GpuCulling gpuCulling(0, 0);
+
+    // Everything is new
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.gatherObjects(memoryManager, 0u, 255u));
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumObjects());
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumDirtySlots());
+
+    // Nothing changed. The render queue isn't even walked
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.gatherObjects(memoryManager, 0u, 255u));
+
+    // The render queue is walked, but tracked objects are left alone
+    // (bounds changes are pushed via updateObject)
+    objects[1]->setWorldAabb(Aabb(Vector3(5, 5, 5), Vector3::UNIT_SCALE));
+    memoryManager._notifyObjectsChanged(0u);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.gatherObjects(memoryManager, 0u, 255u));
+    CPPUNIT_ASSERT_EQUAL(1.0f, gpuCulling.getObjectBounds(gpuCulling.getSlot(objects[1])).center[0]);
+
+    // Tracking is idempotent
+    const uint32 slot = gpuCulling.getSlot(objects[1]);
+    CPPUNIT_ASSERT(slot != GpuCulling::InvalidSlot);
+    CPPUNIT_ASSERT_EQUAL(slot, gpuCulling.trackObject(objects[1]));
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumObjects());
+
+    // Invisible objects are not tracked
+    TestMovableObject *invisibleObject = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+    invisibleObject->setVisible(false);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.gatherObjects(memoryManager, 0u, 255u));
+    CPPUNIT_ASSERT_EQUAL(GpuCulling::InvalidSlot, gpuCulling.getSlot(invisibleObject));
+
+    // Render queues outside the range are ignored
+    TestMovableObject *otherRqObject = OGRE_NEW TestMovableObject(&memoryManager, 5u);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.gatherObjects(memoryManager, 0u, 5u));
+    CPPUNIT_ASSERT_EQUAL(GpuCulling::InvalidSlot, gpuCulling.getSlot(otherRqObject));
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, gpuCulling.gatherObjects(memoryManager, 0u, 255u));
+    CPPUNIT_ASSERT(gpuCulling.getSlot(otherRqObject) != GpuCulling::InvalidSlot);
+
+    OGRE_DELETE otherRqObject;
+    OGRE_DELETE invisibleObject;
+    for (size_t i = 0; i < 3u; ++i)
+        OGRE_DELETE objects[i];
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testChangedObjectsAreUpdated()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Two SIMD blocks worth of objects, with identity parents
+    const size_t numObjects = ARRAY_PACKED_REALS * 2u;
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *objects[numObjects];
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        objects[i] = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+        objects[i]->setLocalAabb(Aabb(Vector3((Real)i, 0, 0), Vector3::UNIT_SCALE));
+    }
+
+    ObjectData objData;
+    size_t totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+    MovableObject::updateAllBounds(totalObjs, objData);
+
+    // Track all but the last one
+    GpuCulling gpuCulling(0, 0);
+    for (size_t i = 0; i < numObjects - 1u; ++i)
+        gpuCulling.trackObject(objects[i]);
+
+    // Nothing changed
+    MovableObject::MovableObjectArray changedObjects;
+    totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+    MovableObject::updateAllBounds(totalObjs, objData, false, &changedObjects);
+    CPPUNIT_ASSERT(changedObjects.empty());
+
+    // The whole block gets reported, but only the object that moved is refreshed
+    objects[1]->setLocalAabb(Aabb(Vector3(5, 5, 5), Vector3::UNIT_SCALE));
+    totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+    MovableObject::updateAllBounds(totalObjs, objData, false, &changedObjects);
+    CPPUNIT_ASSERT_EQUAL((size_t)ARRAY_PACKED_REALS, changedObjects.size());
+    size_t numUpdated = 0u;
+    for (size_t i = 0; i < changedObjects.size(); ++i)
+    {
+        if (gpuCulling.updateObject(changedObjects[i]))
+            ++numUpdated;
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, numUpdated);
+    const uint32 slot = gpuCulling.getSlot(objects[1]);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0f, gpuCulling.getObjectBounds(slot).center[0], 1e-4f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0f, gpuCulling.getObjectBounds(slot).center[1], 1e-4f);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0f, gpuCulling.getObjectBounds(slot).center[2], 1e-4f);
+
+    // Untracked objects are not reported
+    changedObjects.clear();
+    objects[numObjects - 1u]->setLocalAabb(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE));
+    totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+    MovableObject::updateAllBounds(totalObjs, objData, false, &changedObjects);
+    CPPUNIT_ASSERT_EQUAL((size_t)ARRAY_PACKED_REALS - 1u, changedObjects.size());
+    for (size_t i = 0; i < changedObjects.size(); ++i)
+        CPPUNIT_ASSERT(!gpuCulling.updateObject(changedObjects[i]));
+
+    // Flags changes are pushed by the object itself
+    objects[2]->setVisible(false);
+    CPPUNIT_ASSERT_EQUAL(
+        (uint32)0u, gpuCulling.getObjectBounds(gpuCulling.getSlot(objects[2])).visibilityFlags &
+                        VisibilityFlags::LAYER_VISIBILITY);
+
+    for (size_t i = 0; i < numObjects; ++i)
+        OGRE_DELETE objects[i];
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testSlotsFollowObjectLifetime()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *objects[3];
+    for (size_t i = 0; i < 3u; ++i)
+        objects[i] = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+
+    GpuCulling gpuCulling(0, 0);
+    for (size_t i = 0; i < 3u; ++i)
+        gpuCulling.trackObject(objects[i]);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumObjects());
+
+    const uint32 slot0 = gpuCulling.getSlot(objects[0]);
+    const uint32 slot1 = gpuCulling.getSlot(objects[1]);
+    const uint32 slot2 = gpuCulling.getSlot(objects[2]);
+
+    // Destroying an object releases its slot right away. The rest keep theirs
+    OGRE_DELETE objects[1];
+    objects[1] = 0;
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, gpuCulling.getNumObjects());
+    CPPUNIT_ASSERT(!gpuCulling.getObject(slot1));
+    CPPUNIT_ASSERT_EQUAL(slot0, gpuCulling.getSlot(objects[0]));
+    CPPUNIT_ASSERT_EQUAL(slot2, gpuCulling.getSlot(objects[2]));
+
+    // New objects reuse free slots
+    objects[1] = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+    CPPUNIT_ASSERT_EQUAL(slot1, gpuCulling.trackObject(objects[1]));
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumObjects());
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, gpuCulling.getNumSlots());
+
+    // Moving an object to another render queue keeps it tracked
+    objects[2]->setRenderQueueGroup(3u);
+    CPPUNIT_ASSERT_EQUAL(slot2, gpuCulling.getSlot(objects[2]));
+
+    {
+        // Objects tracked by another GpuCulling are moved to it. Destroying
+        // a GpuCulling before its objects is fine
+        GpuCulling otherGpuCulling(0, 0);
+        otherGpuCulling.trackObject(objects[0]);
+        CPPUNIT_ASSERT_EQUAL(GpuCulling::InvalidSlot, gpuCulling.getSlot(objects[0]));
+        CPPUNIT_ASSERT_EQUAL((size_t)2u, gpuCulling.getNumObjects());
+        CPPUNIT_ASSERT_EQUAL((size_t)1u, otherGpuCulling.getNumObjects());
+    }
+    CPPUNIT_ASSERT_EQUAL(GpuCulling::InvalidSlot, gpuCulling.getSlot(objects[0]));
+
+    gpuCulling.untrackObject(objects[2]);
+    CPPUNIT_ASSERT_EQUAL(GpuCulling::InvalidSlot, gpuCulling.getSlot(objects[2]));
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, gpuCulling.getNumObjects());
+
+    for (size_t i = 0; i < 3u; ++i)
+        OGRE_DELETE objects[i];
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumObjects());
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testCullDraws()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *inside = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+    TestMovableObject *outside = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+    inside->setWorldAabb(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE));
+    outside->setWorldAabb(Aabb(Vector3(0, 0, -12.0f), Vector3::UNIT_SCALE));
+
+    Plane planes[6];
+    makeBoxPlanes(planes);
+
+    GpuCulling gpuCulling(0, 0);
+    gpuCulling.gatherObjects(memoryManager, 0u, 255u);
+
+    // Objects may have more than one draw (e.g. one per SubItem). Each one is
+    // culled against the bounds of the object that owns it
+    const uint32 slots[4] = { gpuCulling.getSlot(inside), gpuCulling.getSlot(outside),
+                              gpuCulling.getSlot(outside), gpuCulling.getSlot(inside) };
+    gpuCulling.clearDraws();
+    for (uint32 i = 0; i < 4u; ++i)
+        CPPUNIT_ASSERT_EQUAL(i, gpuCulling.addDraw(slots[i], makeDrawArgs(i)));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, gpuCulling.cullOnCpu(planes, 0xFFFFFFFFu));
+
+    const vector<CbDrawIndexed>::type &culledArgs = gpuCulling.getCpuCulledDrawArgs();
+    CPPUNIT_ASSERT_EQUAL((size_t)4u, culledArgs.size());
+    const uint32 expectedInstances[4] = { 1u, 0u, 0u, 1u };
+    for (uint32 i = 0; i < 4u; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(expectedInstances[i], culledArgs[i].instanceCount);
+        // Only instanceCount is touched
+        CPPUNIT_ASSERT_EQUAL(36u, culledArgs[i].primCount);
+        CPPUNIT_ASSERT_EQUAL(i * 100u, culledArgs[i].firstVertexIndex);
+        CPPUNIT_ASSERT_EQUAL(i, culledArgs[i].baseInstance);
+    }
+
+    // LAYER_VISIBILITY is kept so it can be used to skip the visibility flags test
+    CPPUNIT_ASSERT_EQUAL((size_t)2u,
+                         gpuCulling.cullOnCpu(planes, VisibilityFlags::LAYER_VISIBILITY));
+    // No user bit in common. The objects push their new flags themselves
+    inside->setVisibilityFlags(0x01u);
+    outside->setVisibilityFlags(0x01u);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.cullOnCpu(planes, 0x02u));
+
+    OGRE_DELETE inside;
+    OGRE_DELETE outside;
+}
+//--------------------------------------------------------------------------
+//--------------------------------------------------------------------------
+void GpuCullingTests::testDrawsStayResident()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = createNullRoot();
+    if (!root)
+    {
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    {
+        ObjectMemoryManager memoryManager;
+        TestMovableObject *object = OGRE_NEW TestMovableObject(&memoryManager, 0u);
+
+        GpuCulling gpuCulling(0, root->getRenderSystem()->getVaoManager());
+        const uint32 slot = gpuCulling.trackObject(object);
+
+        const uint32 numDraws = 8u;
+        gpuCulling.reserveDraws(numDraws);
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i));
+        CPPUNIT_ASSERT_EQUAL((size_t)numDraws, gpuCulling.getNumDirtyDraws());
+        gpuCulling.upload();
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtyDraws());
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtySlots());
+
+        // Same draws as in the previous pass. Nothing to upload
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i));
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtyDraws());
+        gpuCulling.upload();
+
+        // Only the draw that changed is uploaded
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i == 5u ? 50u : i));
+        CPPUNIT_ASSERT_EQUAL((size_t)1u, gpuCulling.getNumDirtyDraws());
+        CPPUNIT_ASSERT_EQUAL(50u, gpuCulling.getDraw(5u).drawArgs.baseInstance);
+        gpuCulling.upload();
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtyDraws());
+
+        // Passes with fewer draws don't discard the rest
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws / 2u; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i));
+        gpuCulling.upload();
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i == 5u ? 50u : i));
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtyDraws());
+        gpuCulling.upload();
+
+        // Growing the buffers loses their contents
+        gpuCulling.reserveDraws(1000u);
+        gpuCulling.clearDraws();
+        for (uint32 i = 0; i < numDraws; ++i)
+            gpuCulling.addDraw(slot, makeDrawArgs(i == 5u ? 50u : i));
+        CPPUNIT_ASSERT_EQUAL((size_t)numDraws, gpuCulling.getNumDirtyDraws());
+        gpuCulling.upload();
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtyDraws());
+
+        OGRE_DELETE object;
+    }
+
+    OGRE_DELETE root;
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testSceneManagerUpdatesChangedObjects()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = createNullRoot();
+    if (!root)
+    {
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    TaskScheduler scheduler(1u);
+
+    // Worker threads and TaskScheduler paths
+    for (int useScheduler = 0; useScheduler < 2; ++useScheduler)
+    {
+        SceneManager *sceneManager = root->createSceneManager(ST_GENERIC, 2u);
+        if (useScheduler)
+            sceneManager->setTaskScheduler(&scheduler);
+
+        GpuCulling gpuCulling(0, root->getRenderSystem()->getVaoManager());
+        sceneManager->getRenderQueue()->setGpuCulling(&gpuCulling, 0u, 255u);
+
+        const size_t numObjects = 64u;
+        std::vector<SceneNode*> nodes;
+        std::vector<TestMovableObject*> objects;
+        for (size_t i = 0; i < numObjects; ++i)
+        {
+            nodes.push_back(sceneManager->getRootSceneNode()->createChildSceneNode());
+            nodes.back()->setPosition(Vector3((Real)i, 0, 0));
+            objects.push_back(OGRE_NEW TestMovableObject(
+                &sceneManager->_getEntityMemoryManager(SCENE_DYNAMIC), 0u, sceneManager));
+            objects.back()->setLocalAabb(Aabb(Vector3::ZERO, Vector3::UNIT_SCALE));
+            nodes.back()->attachObject(objects.back());
+        }
+
+        sceneManager->updateSceneGraph();
+        for (size_t i = 0; i < numObjects; ++i)
+            gpuCulling.trackObject(objects[i]);
+        gpuCulling.upload();
+
+        // Still scene. Nothing to upload
+        sceneManager->updateSceneGraph();
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumDirtySlots());
+
+        nodes[10]->setPosition(Vector3(0, 10, 0));
+        nodes[37]->setPosition(Vector3(0, 37, 0));
+        sceneManager->updateSceneGraph();
+        CPPUNIT_ASSERT_EQUAL((size_t)2u, gpuCulling.getNumDirtySlots());
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(
+            10.0f, gpuCulling.getObjectBounds(gpuCulling.getSlot(objects[10])).center[1], 1e-4f);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(
+            37.0f, gpuCulling.getObjectBounds(gpuCulling.getSlot(objects[37])).center[1], 1e-4f);
+        gpuCulling.upload();
+
+        sceneManager->getRenderQueue()->setGpuCulling(0, 0u, 0u);
+        for (size_t i = 0; i < numObjects; ++i)
+            OGRE_DELETE objects[i];
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, gpuCulling.getNumObjects());
+        sceneManager->setTaskScheduler(0);
+        root->destroySceneManager(sceneManager);
+    }
+
+    OGRE_DELETE root;
+}
+//--------------------------------------------------------------------------
+void GpuCullingTests::testResidentUpdateBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = createNullRoot();
+    if (!root)
+    {
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    // A fixed amount of objects move every frame, no matter how big the scene is.
+    // Compares what GpuCulling costs on the CPU against walking every object
+    // (what gathering the whole scene each frame costs)
+    const size_t numMovingObjects = 64u;
+    const size_t numFrames = 32u;
+    const size_t sceneSizes[] = { 4096u, 16384u, 65536u };
+
+    LogManager::getSingleton().logMessage(
+        "GpuCulling CPU cost per frame with " + StringConverter::toString(numMovingObjects) +
+        " moving objects:");
+
+    Timer timer;
+    for (size_t sizeIdx = 0; sizeIdx < sizeof(sceneSizes) / sizeof(sceneSizes[0]); ++sizeIdx)
+    {
+        const size_t numObjects = sceneSizes[sizeIdx];
+
+        ObjectMemoryManager memoryManager;
+        std::vector<TestMovableObject*> objects;
+        for (size_t i = 0; i < numObjects; ++i)
+        {
+            objects.push_back(OGRE_NEW TestMovableObject(&memoryManager, 0u));
+            objects.back()->setLocalAabb(Aabb(Vector3((Real)i, 0, 0), Vector3::UNIT_SCALE));
+        }
+
+        ObjectData objData;
+        size_t totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+        MovableObject::updateAllBounds(totalObjs, objData);
+
+        GpuCulling gpuCulling(0, root->getRenderSystem()->getVaoManager());
+        for (size_t i = 0; i < numObjects; ++i)
+            gpuCulling.trackObject(objects[i]);
+        gpuCulling.upload();
+
+        uint64 residentUs = 0u;
+        uint64 fullWalkUs = 0u;
+        MovableObject::MovableObjectArray changedObjects;
+
+        for (size_t frame = 0; frame < numFrames; ++frame)
+        {
+            for (size_t i = 0; i < numMovingObjects; ++i)
+            {
+                const size_t idx = i * (numObjects / numMovingObjects);
+                objects[idx]->setLocalAabb(
+                    Aabb(Vector3((Real)idx, (Real)(frame + 1u), 0), Vector3::UNIT_SCALE));
+            }
+            // What SceneManager::updateAllBounds does. Not part of the measurements
+            totalObjs = memoryManager.getFirstObjectData(objData, 0u);
+            MovableObject::updateAllBounds(totalObjs, objData, true, &changedObjects);
+
+            timer.reset();
+            for (size_t i = 0; i < changedObjects.size(); ++i)
+                gpuCulling.updateObject(changedObjects[i]);
+            CPPUNIT_ASSERT_EQUAL(numMovingObjects, gpuCulling.getNumDirtySlots());
+            gpuCulling.upload();
+            residentUs += timer.getMicroseconds();
+            changedObjects.clear();
+
+            timer.reset();
+            for (size_t i = 0; i < numObjects; ++i)
+                gpuCulling.updateObject(objects[i]);
+            gpuCulling.upload();
+            fullWalkUs += timer.getMicroseconds();
+        }
+
+        LogManager::getSingleton().logMessage(
+            "  " + StringConverter::toString(numObjects) + " objects. Resident: " +
+            StringConverter::toString(Real(residentUs) / Real(numFrames)) + " us. Full walk: " +
+            StringConverter::toString(Real(fullWalkUs) / Real(numFrames)) + " us");
+
+        for (size_t i = 0; i < numObjects; ++i)
+            OGRE_DELETE objects[i];
+    }
+
+    OGRE_DELETE root;
+}
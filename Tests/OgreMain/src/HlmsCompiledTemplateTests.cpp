@@ -0,0 +1,408 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsCompiledTemplateTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreFileSystem.h"
+#include "OgreHlms.h"
+#include "OgreHlmsCompiledTemplate.h"
+#include "OgreLogManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsCompiledTemplateTests);
+
+namespace
+{
+    /// Enough of an Hlms to run the text parser (no RenderSystem is needed)
+    class TemplateTestHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &, size_t) override {}
+        HlmsDatablock *createDatablockImpl(IdString, const HlmsMacroblock *, const HlmsBlendblock *,
+                                           const HlmsParamVec &) override
+        {
+            return 0;
+        }
+
+    public:
+        TemplateTestHlms() : Hlms(HLMS_USER0, "TemplateTest", 0, 0) {}
+
+        uint32 fillBuffersFor(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                              uint32) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+
+        /// Same passes as Hlms::parseTemplateFile without precompiled templates.
+        /// Returns false on syntax error.
+        bool parseText(const String &source, HlmsPropertyVec &properties, String &outString)
+        {
+            mT[kNoTid].setProperties.swap(properties);
+
+            String inString;
+            bool syntaxError = parseMath(source, outString, kNoTid);
+            while (!syntaxError && outString.find("@foreach") != String::npos)
+            {
+                syntaxError |= parseForEach(outString, inString, kNoTid);
+                inString.swap(outString);
+            }
+            syntaxError |= parseProperties(outString, inString, kNoTid);
+            outString.swap(inString);
+
+            mT[kNoTid].setProperties.swap(properties);
+
+            return !syntaxError;
+        }
+    };
+
+    HlmsPropertyVec makeProperties(const char *names[], const int32 values[], size_t numProperties)
+    {
+        HlmsPropertyVec retVal;
+        for (size_t i = 0; i < numProperties; ++i)
+            Hlms::setProperty(retVal, names[i], values[i]);
+        return retVal;
+    }
+
+    void checkMatchesTextParser(TemplateTestHlms &hlms, const HlmsCompiledTemplate &compiled,
+                                const HlmsPropertyVec &properties)
+    {
+        HlmsPropertyVec textProperties = properties;
+        String textOutput;
+        CPPUNIT_ASSERT(hlms.parseText(compiled.getOriginalSource(), textProperties, textOutput));
+
+        HlmsPropertyVec compiledProperties = properties;
+        String compiledOutput;
+        CPPUNIT_ASSERT(compiled.generate(compiledProperties, compiledOutput));
+
+        CPPUNIT_ASSERT(textOutput == compiledOutput);
+        CPPUNIT_ASSERT(textProperties == compiledProperties);
+    }
+
+    /// A few sets of properties resembling what HlmsPbs sets for different passes
+    vector<HlmsPropertyVec>::type getPbsLikeProperties()
+    {
+        vector<HlmsPropertyVec>::type retVal;
+
+        const char *names[] = { "GL3+",
+                                "syntax",
+                                "glsl",
+                                "hlms_normal",
+                                "hlms_qtangent",
+                                "hlms_tangent",
+                                "hlms_uv_count",
+                                "hlms_uv_count0",
+                                "hlms_uv_count1",
+                                "hlms_skeleton",
+                                "hlms_bones_per_vertex",
+                                "hlms_pose",
+                                "normal_map",
+                                "normal_map_tex",
+                                "diffuse_map",
+                                "diffuse_map0",
+                                "specular_map",
+                                "roughness_map",
+                                "num_textures",
+                                "hlms_lights_directional",
+                                "hlms_lights_directional_non_caster",
+                                "hlms_lights_point",
+                                "hlms_lights_spot",
+                                "hlms_num_shadow_map_lights",
+                                "hlms_num_shadow_map_textures",
+                                "hlms_shadowmap0_is_directional_light",
+                                "hlms_shadowmap1_is_point_light",
+                                "hlms_shadowmap2_is_spot_light",
+                                "hlms_pssm_splits",
+                                "hlms_pssm_blend",
+                                "hlms_pssm_fade",
+                                "hlms_forwardplus",
+                                "hlms_forwardplus_fine_light_mask",
+                                "envprobe_map",
+                                "hlms_shadowcaster",
+                                "hlms_shadow_uses_depth_texture",
+                                "fresnel_scalar",
+                                "hlms_alphablend",
+                                "metallic_workflow",
+                                "BRDF_Default",
+                                "first_valid_detail_map_nm",
+                                "second_valid_detail_map_nm" };
+
+        const int32 glslValue = static_cast<int32>(IdString("glsl").getU32Value());
+
+        // Bare minimum HlmsPbs always sets (@foreach starts must not be negative)
+        {
+            HlmsPropertyVec properties;
+            Hlms::setProperty(properties, "hlms_lights_directional", 0);
+            Hlms::setProperty(properties, "hlms_lights_directional_non_caster", 0);
+            Hlms::setProperty(properties, "hlms_lights_point", 0);
+            Hlms::setProperty(properties, "first_valid_detail_map_nm", 4);
+            Hlms::setProperty(properties, "second_valid_detail_map_nm", 4);
+            retVal.push_back(properties);
+        }
+
+        // Forward lit pass, textured & skinned
+        {
+            const int32 values[] = { 450, glslValue, glslValue, 1, 1, 0, 2, 2, 2, 1, 4, 0, 1, 1, 1,
+                                     1, 1, 1, 3, 1, 1, 2, 3, 3, 3, 1, 1, 1, 3, 1, 1, 1, 1, 1, 0, 0,
+                                     1, 0, 1, 1, 4, 4 };
+            retVal.push_back(makeProperties(names, values, sizeof(values) / sizeof(values[0])));
+        }
+
+        // Shadow caster pass
+        {
+            const int32 values[] = { 450, glslValue, glslValue, 1, 0, 0, 1, 2, 0, 0, 0, 0, 0, 0, 0,
+                                     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                     0, 0, 1, 1, 4, 4 };
+            retVal.push_back(makeProperties(names, values, sizeof(values) / sizeof(values[0])));
+        }
+
+        // Untextured, Forward+ with many shadow maps
+        {
+            const int32 values[] = { 450, glslValue, glslValue, 1, 0, 1, 1, 2, 0, 0, 0, 1, 0, 0, 0,
+                                     0, 0, 0, 0, 2, 2, 5, 6, 6, 8, 1, 1, 1, 4, 1, 0, 2, 0, 0, 0, 0,
+                                     0, 1, 0, 1, 4, 4 };
+            retVal.push_back(makeProperties(names, values, sizeof(values) / sizeof(values[0])));
+        }
+
+        return retVal;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+    mPbsPath = "../../Samples/Media/Hlms/Pbs/";
+#else
+    mPbsPath = "./Samples/Media/Hlms/Pbs/";
+#endif
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::tearDown() {}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::testMatchesTextParser()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const char *templates[] = {
+        "a @property( x )X@end b @property( !x && y )Y@else N@end c\n",
+
+        "@property( x > 1 && (y == 2 || !z) )\n"
+        "\tA\n"
+        "\t@property( w )\n\tB @insertpiece( foo )\n\t@end\n"
+        "@else\n"
+        "\tC\n"
+        "@end\n",
+
+        "@foreach( n, i )\n"
+        "\tlight@i @property( light@i_enabled )on@i@else off@end\n"
+        "@end\n",
+
+        "@foreach( 2, a )\n"
+        "@foreach( count@a, b, 1 )\n"
+        "\t[@a, @b] @property( @a == 1 && @b >= 2 )match@end\n"
+        "@end\n"
+        "@end\n",
+
+        "@pset( n, 3 )@padd( m, n, 2 )@pmul( z, m, 2 )\n"
+        "@foreach( m, i )@i,@end\n"
+        "@property( m == 5 && z == 10 )five@end\n",
+
+        "@piece( foo )@property( x )X@end\n@end\n"
+        "@insertpiece( foo ) @counter( c ) @value( c )\n",
+
+        "no blocks at all\n",
+    };
+
+    const char *names[] = { "x", "y", "z", "w", "n", "count0", "count1", "light1_enabled" };
+    const int32 values[4][8] = { { 0, 0, 0, 0, 0, 0, 0, 0 },
+                                 { 1, 0, 0, 0, 1, 0, 0, 0 },
+                                 { 2, 2, 0, 1, 3, 2, 3, 1 },
+                                 { 2, 1, 1, 1, 4, 3, 0, 1 } };
+
+    TemplateTestHlms hlms;
+
+    for (size_t i = 0; i < sizeof(templates) / sizeof(templates[0]); ++i)
+    {
+        HlmsCompiledTemplate compiled(templates[i]);
+        CPPUNIT_ASSERT(compiled.isValid());
+
+        checkMatchesTextParser(hlms, compiled, HlmsPropertyVec());
+        for (size_t j = 0; j < 4u; ++j)
+            checkMatchesTextParser(hlms, compiled, makeProperties(names, values[j], 8u));
+    }
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::testUnsupportedTemplates()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Inner @end glued to the outer one
+    CPPUNIT_ASSERT(!HlmsCompiledTemplate("@property( x )@property( y )Y@end@end\n").isValid());
+    // Syntax errors
+    CPPUNIT_ASSERT(!HlmsCompiledTemplate("@property( x &&& )X@end\n").isValid());
+    CPPUNIT_ASSERT(!HlmsCompiledTemplate("@property( x )X\n").isValid());
+    CPPUNIT_ASSERT(!HlmsCompiledTemplate("@pset( x )\n").isValid());
+    // Counter that would be replaced inside @end
+    CPPUNIT_ASSERT(!HlmsCompiledTemplate("@foreach( 2, e )@property( x )X@end\n@end\n").isValid());
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::testRuntimeError()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // @foreach with a negative start can only be detected when generating.
+    HlmsCompiledTemplate compiled("@pset( s, x )@foreach( 2, i, s )@i@end\n");
+    CPPUNIT_ASSERT(compiled.isValid());
+
+    HlmsPropertyVec properties;
+    Hlms::setProperty(properties, "x", -1);
+    const HlmsPropertyVec originalProperties = properties;
+
+    String output;
+    CPPUNIT_ASSERT(!compiled.generate(properties, output));
+    CPPUNIT_ASSERT(properties == originalProperties);
+
+    Hlms::setProperty(properties, "x", 1);
+    CPPUNIT_ASSERT(compiled.generate(properties, output));
+    CPPUNIT_ASSERT(output == "1");
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::testPbsTemplates()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const char *folders[] = { "Any", "Any/Main", "GLSL" };
+
+    vector<HlmsCompiledTemplate *>::type templates;
+
+    Timer timer;
+    uint64 compileTime = 0;
+    size_t numFiles = 0;
+
+    for (size_t i = 0; i < sizeof(folders) / sizeof(folders[0]); ++i)
+    {
+        FileSystemArchive archive(mPbsPath + folders[i], "FileSystem", true);
+        archive.load();
+
+        StringVectorPtr files = archive.find("*.*", false);
+        for (StringVector::const_iterator itor = files->begin(); itor != files->end(); ++itor)
+        {
+            DataStreamPtr stream = archive.open(*itor);
+            const String source = stream->getAsString();
+
+            timer.reset();
+            HlmsCompiledTemplate *compiled = new HlmsCompiledTemplate(source);
+            compileTime += timer.getMicroseconds();
+
+            ++numFiles;
+            if (compiled->isValid())
+                templates.push_back(compiled);
+            else
+                delete compiled;
+        }
+    }
+
+    if (!numFiles)
+    {
+        LogManager::getSingleton().logMessage("Pbs templates not found in " + mPbsPath +
+                                              ", skipping.");
+        return;
+    }
+
+    // Every Pbs template is expected to be supported
+    CPPUNIT_ASSERT_EQUAL(numFiles, templates.size());
+
+    TemplateTestHlms hlms;
+    const vector<HlmsPropertyVec>::type propertySets = getPbsLikeProperties();
+
+    for (size_t i = 0; i < templates.size(); ++i)
+    {
+        for (size_t j = 0; j < propertySets.size(); ++j)
+            checkMatchesTextParser(hlms, *templates[i], propertySets[j]);
+    }
+
+    // Benchmark generating all the templates for every set of properties
+    const size_t numIterations = 20u;
+    String output;
+
+    timer.reset();
+    for (size_t n = 0; n < numIterations; ++n)
+    {
+        for (size_t i = 0; i < templates.size(); ++i)
+        {
+            for (size_t j = 0; j < propertySets.size(); ++j)
+            {
+                HlmsPropertyVec properties = propertySets[j];
+                hlms.parseText(templates[i]->getOriginalSource(), properties, output);
+            }
+        }
+    }
+    const uint64 textTime = timer.getMicroseconds();
+
+    timer.reset();
+    for (size_t n = 0; n < numIterations; ++n)
+    {
+        for (size_t i = 0; i < templates.size(); ++i)
+        {
+            for (size_t j = 0; j < propertySets.size(); ++j)
+            {
+                HlmsPropertyVec properties = propertySets[j];
+                templates[i]->generate(properties, output);
+            }
+        }
+    }
+    const uint64 compiledTime = timer.getMicroseconds();
+
+    for (size_t i = 0; i < templates.size(); ++i)
+        delete templates[i];
+
+    LogManager::getSingleton().logMessage(
+        "Hlms Pbs templates, " + StringConverter::toString(numFiles) + " files x " +
+        StringConverter::toString(propertySets.size()) + " property sets x " +
+        StringConverter::toString(numIterations) + ": text parser " +
+        StringConverter::toString(textTime) + " us, precompiled " +
+        StringConverter::toString(compiledTime) + " us (compiled once in " +
+        StringConverter::toString(compileTime) + " us)");
+}
@@ -0,0 +1,379 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsDiskCacheTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreArchiveManager.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreHighLevelGpuProgram.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsDiskCache.h"
+#include "OgreHlmsManager.h"
+#include "OgreRoot.h"
+#include "OgreStringConverter.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsDiskCacheTests);
+
+namespace
+{
+    HlmsDiskCache::SourceCode createSourceCode(int32 idx)
+    {
+        HlmsDiskCache::SourceCode sourceCode;
+        Hlms::setProperty(sourceCode.mergedCache.setProperties, "hlms_normal", 1);
+        Hlms::setProperty(sourceCode.mergedCache.setProperties, "shader_idx", idx);
+        sourceCode.mergedCache.pieces[PixelShader]["custom_ps"] = "float x;";
+        sourceCode.sourceFile[VertexShader] = "vs " + StringConverter::toString(idx);
+        sourceCode.sourceFile[PixelShader] = "ps " + StringConverter::toString(idx);
+        return sourceCode;
+    }
+
+    /// Saves a cache with the given shaders and returns the file
+    std::vector<uint8> saveCache(const int32 *shaderIdx, size_t numShaders)
+    {
+        HlmsDiskCache diskCache(0);
+        diskCache.mCache.type = HLMS_PBS;
+        diskCache.mShaderProfile = "glsl";
+        for (size_t i = 0; i < numShaders; ++i)
+            diskCache.mCache.sourceCode.push_back(createSourceCode(shaderIdx[i]));
+
+        std::vector<uint8> buffer(1024u * 1024u);
+        DataStreamPtr dataStream(OGRE_NEW MemoryDataStream(buffer.data(), buffer.size()));
+        diskCache.saveTo(dataStream);
+        buffer.resize(dataStream->tell());
+        return buffer;
+    }
+
+    size_t getHeaderSize() { return saveCache(0, 0u).size(); }
+
+    /// Loads the file and returns the shader_idx of each shader in it
+    std::vector<int32> loadCache(std::vector<uint8> buffer, size_t *outValidSize = 0)
+    {
+        HlmsDiskCache diskCache(0);
+        DataStreamPtr dataStream(OGRE_NEW MemoryDataStream(buffer.data(), buffer.size(), false, true));
+        diskCache.loadFrom(dataStream);
+
+        CPPUNIT_ASSERT_EQUAL((uint8)HLMS_PBS, diskCache.mCache.type);
+        CPPUNIT_ASSERT_EQUAL(String("glsl"), diskCache.mShaderProfile);
+
+        std::vector<int32> retVal;
+        for (size_t i = 0; i < diskCache.mCache.sourceCode.size(); ++i)
+        {
+            const HlmsDiskCache::SourceCode &sourceCode = diskCache.mCache.sourceCode[i];
+            const int32 idx = Hlms::getProperty(sourceCode.mergedCache.setProperties, "shader_idx");
+            const HlmsDiskCache::SourceCode expected = createSourceCode(idx);
+            CPPUNIT_ASSERT(sourceCode.mergedCache == expected.mergedCache);
+            for (size_t j = 0; j < NumShaderTypes; ++j)
+                CPPUNIT_ASSERT_EQUAL(expected.sourceFile[j], sourceCode.sourceFile[j]);
+            retVal.push_back(idx);
+        }
+
+        if (outValidSize)
+            *outValidSize = diskCache.mValidStreamSize;
+
+        return retVal;
+    }
+
+    /// Just enough of an Hlms to generate shaders & PSOs from a template
+    class WarmUpTestHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &, size_t) override {}
+        HlmsDatablock *createDatablockImpl(IdString name, const HlmsMacroblock *macroblock,
+                                           const HlmsBlendblock *blendblock,
+                                           const HlmsParamVec &paramVec) override
+        {
+            return OGRE_NEW HlmsDatablock(name, this, macroblock, blendblock, paramVec);
+        }
+
+        const HlmsCache *createShaderCacheEntry(uint32 renderableHash, const HlmsCache &passCache,
+                                                uint32 finalHash,
+                                                const QueuedRenderable &queuedRenderable,
+                                                HlmsCache *reservedStubEntry, size_t tid) override
+        {
+            const HlmsCache *retVal = Hlms::createShaderCacheEntry(
+                renderableHash, passCache, finalHash, queuedRenderable, reservedStubEntry, tid);
+            // The RenderSystem has just created the PSO. Its blocks must've been active
+            psoBlocksWereActive =
+                retVal->pso.macroblock->mRefCount > 0u && retVal->pso.blendblock->mRefCount > 0u;
+            psoCullMode = retVal->pso.macroblock->mCullMode;
+            return retVal;
+        }
+
+    public:
+        bool psoBlocksWereActive;
+        CullingMode psoCullMode;
+
+        WarmUpTestHlms(Archive *dataFolder) :
+            Hlms(HLMS_USER0, "WarmUpTest", dataFolder, 0),
+            psoBlocksWereActive(false),
+            psoCullMode(CULL_CLOCKWISE)
+        {
+        }
+
+        uint32 fillBuffersFor(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                              uint32) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+    };
+
+    /// Records a cache with a single PSO, as if a previous session had rendered it
+    std::vector<uint8> saveRecordedPso(HlmsManager *hlmsManager, Hlms *hlms)
+    {
+        HlmsDiskCache diskCache(hlmsManager);
+        diskCache.copyFrom(hlms);
+
+        HlmsDiskCache::Pso pso;
+        pso.pso.initialize();
+        pso.pso.operationType = OT_TRIANGLE_LIST;
+        Hlms::setProperty(pso.renderableCache.setProperties, "test_renderable", 1);
+        Hlms::setProperty(pso.passProperties, "test_pass", 1);
+        // Set by the Hlms after preparePassHashBase. The shader needs them too
+        pso.passCacheProperties = pso.passProperties;
+        Hlms::setProperty(pso.passCacheProperties, "test_pass_cache", 1);
+        pso.macroblock.mCullMode = CULL_NONE;
+        diskCache.mCache.pso.push_back(pso);
+
+        std::vector<uint8> buffer(64u * 1024u);
+        DataStreamPtr dataStream(OGRE_NEW MemoryDataStream(buffer.data(), buffer.size()));
+        diskCache.saveTo(dataStream);
+        buffer.resize(dataStream->tell());
+        return buffer;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::setUp() {}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::tearDown() {}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testSaveLoad()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const int32 shaderIdx[] = { 0, 1, 2 };
+    const std::vector<uint8> file = saveCache(shaderIdx, 3u);
+
+    size_t validSize = 0;
+    const std::vector<int32> loaded = loadCache(file, &validSize);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, loaded.size());
+    for (size_t i = 0; i < loaded.size(); ++i)
+        CPPUNIT_ASSERT_EQUAL(shaderIdx[i], loaded[i]);
+    CPPUNIT_ASSERT_EQUAL(file.size(), validSize);
+
+    // Identical entries are only saved once
+    const int32 duplicatedIdx[] = { 0, 1, 1, 2, 0 };
+    CPPUNIT_ASSERT_EQUAL(file.size(), saveCache(duplicatedIdx, 5u).size());
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testAppendedRecords()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t headerSize = getHeaderSize();
+
+    // Append the records from another run, which generated shader 1 again and shader 2
+    const int32 firstRun[] = { 0, 1 };
+    const int32 secondRun[] = { 1, 2 };
+    std::vector<uint8> file = saveCache(firstRun, 2u);
+    const std::vector<uint8> appended = saveCache(secondRun, 2u);
+    file.insert(file.end(), appended.begin() + (long)headerSize, appended.end());
+
+    const std::vector<int32> loaded = loadCache(file);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, loaded.size());
+    CPPUNIT_ASSERT_EQUAL(0, loaded[0]);
+    CPPUNIT_ASSERT_EQUAL(1, loaded[1]);
+    CPPUNIT_ASSERT_EQUAL(2, loaded[2]);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testIncompleteRecord()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t headerSize = getHeaderSize();
+
+    const int32 shaderIdx[] = { 0, 1 };
+    const int32 lastShaderIdx[] = { 2 };
+    const std::vector<uint8> file = saveCache(shaderIdx, 2u);
+    const std::vector<uint8> lastRecord = saveCache(lastShaderIdx, 1u);
+
+    // The app crashed while appending shader 2
+    for (size_t cut = 1u; cut < lastRecord.size() - headerSize; cut += 7u)
+    {
+        std::vector<uint8> truncated = file;
+        truncated.insert(truncated.end(), lastRecord.begin() + (long)headerSize,
+                         lastRecord.end() - (long)cut);
+
+        size_t validSize = 0;
+        const std::vector<int32> loaded = loadCache(truncated, &validSize);
+        CPPUNIT_ASSERT_EQUAL((size_t)2u, loaded.size());
+        CPPUNIT_ASSERT_EQUAL(file.size(), validSize);
+    }
+
+    // Garbage after the last record
+    std::vector<uint8> garbage = file;
+    for (uint8 i = 0; i < 64u; ++i)
+        garbage.push_back(static_cast<uint8>(i * 37u + 11u));
+
+    size_t validSize = 0;
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, loadCache(garbage, &validSize).size());
+    CPPUNIT_ASSERT_EQUAL(file.size(), validSize);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testPassPropertiesDiff()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsPropertyVec passProperties;
+    Hlms::setProperty(passProperties, "hlms_shadowcaster", 0);
+    Hlms::setProperty(passProperties, "hlms_forwardplus", 1);
+    Hlms::setProperty(passProperties, "hlms_pssm_splits", 3);
+
+    // Properties set by the Hlms after preparePassHashBase
+    HlmsPropertyVec passCacheProperties = passProperties;
+    Hlms::setProperty(passCacheProperties, "hw_gamma_write", 1);
+    Hlms::setProperty(passCacheProperties, "hlms_pssm_splits", 4);
+
+    HlmsPropertyVec diff;
+    CPPUNIT_ASSERT(HlmsDiskCache::diffProperties(passProperties, passCacheProperties, diff));
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, diff.size());
+
+    HlmsPropertyVec merged = passProperties;
+    HlmsDiskCache::mergeProperties(merged, diff);
+    CPPUNIT_ASSERT(merged == passCacheProperties);
+
+    // Identical properties need no diff
+    CPPUNIT_ASSERT(HlmsDiskCache::diffProperties(passProperties, passProperties, diff));
+    CPPUNIT_ASSERT(diff.empty());
+
+    // A diff can't express removed properties
+    HlmsPropertyVec removed = passCacheProperties;
+    removed.erase(removed.begin());
+    CPPUNIT_ASSERT(!HlmsDiskCache::diffProperties(passProperties, removed, diff));
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testWarmUpPsos()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = OGRE_NEW Root(0, "plugins" OGRE_BUILD_SUFFIX ".cfg", "", "HlmsDiskCacheTests.log");
+
+    RenderSystem *renderSystem = root->getRenderSystemByName("NULL Rendering Subsystem");
+    if (!renderSystem)
+    {
+        OGRE_DELETE root;
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    const String dataFolderPath = "./HlmsDiskCacheTests/";
+    const String templateFilename = "VertexShader_vs.glsl";
+
+    size_t numBuilt = 0u;
+    size_t numBuiltAgain = 0u;
+    size_t numShaders = 0u;
+    String vertexShaderSource;
+    bool psoBlocksWereActive = false;
+    CullingMode psoCullMode = CULL_CLOCKWISE;
+
+    try
+    {
+        root->setRenderSystem(renderSystem);
+        root->initialise(false);
+        root->createRenderWindow("HlmsDiskCacheTests", 320u, 240u, false, 0);
+
+        FileSystemLayer::createDirectory(dataFolderPath);
+        Archive *dataFolder =
+            ArchiveManager::getSingleton().load(dataFolderPath, "FileSystem", false);
+        {
+            const String source = "@property( test_pass_cache && test_renderable )both@end";
+            DataStreamPtr templateFile = dataFolder->create(templateFilename);
+            templateFile->write(source.c_str(), source.size());
+        }
+
+        HlmsManager *hlmsManager = root->getHlmsManager();
+        WarmUpTestHlms *hlms = OGRE_NEW WarmUpTestHlms(dataFolder);
+        hlmsManager->registerHlms(hlms);
+
+        SceneManager *sceneManager =
+            root->createSceneManager(ST_GENERIC, 1u, "HlmsDiskCacheTests");
+
+        std::vector<uint8> buffer = saveRecordedPso(hlmsManager, hlms);
+
+        // Next session: load the cache and build its PSOs before anything is rendered
+        HlmsDiskCache diskCache(hlmsManager);
+        DataStreamPtr dataStream(
+            OGRE_NEW MemoryDataStream(buffer.data(), buffer.size(), false, true));
+        diskCache.loadFrom(dataStream);
+        diskCache.applyTo(hlms, 1u);
+
+        numBuilt = diskCache.warmUpPsos(hlms, sceneManager);
+        numBuiltAgain = diskCache.warmUpPsos(hlms, sceneManager);
+
+        numShaders = hlms->getShaderCodeCache().size();
+        if (numShaders == 1u && hlms->getShaderCodeCache()[0].shaders[VertexShader])
+            vertexShaderSource = hlms->getShaderCodeCache()[0].shaders[VertexShader]->getSource();
+        psoBlocksWereActive = hlms->psoBlocksWereActive;
+        psoCullMode = hlms->psoCullMode;
+    }
+    catch (...)
+    {
+        OGRE_DELETE root;
+        FileSystemLayer::removeFile(dataFolderPath + templateFilename);
+        FileSystemLayer::removeDirectory(dataFolderPath);
+        throw;
+    }
+
+    OGRE_DELETE root;
+    FileSystemLayer::removeFile(dataFolderPath + templateFilename);
+    FileSystemLayer::removeDirectory(dataFolderPath);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, numBuilt);
+    // Already built
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, numBuiltAgain);
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, numShaders);
+    // Generated with both the recorded pass and renderable properties
+    CPPUNIT_ASSERT(vertexShaderSource.find("both") != String::npos);
+    CPPUNIT_ASSERT(psoBlocksWereActive);
+    CPPUNIT_ASSERT_EQUAL(CULL_NONE, psoCullMode);
+}
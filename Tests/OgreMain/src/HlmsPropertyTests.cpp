@@ -0,0 +1,265 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsPropertyTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreHlms.h"
+#include "OgreLogManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsPropertyTests);
+
+namespace
+{
+    /// Enough of an Hlms to exercise the renderable cache (no RenderSystem is needed)
+    class PropertyTestHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &, size_t) override {}
+        HlmsDatablock *createDatablockImpl(IdString, const HlmsMacroblock *, const HlmsBlendblock *,
+                                           const HlmsParamVec &) override
+        {
+            return 0;
+        }
+
+    public:
+        PropertyTestHlms() : Hlms(HLMS_USER0, "PropertyTest", 0, 0) {}
+
+        uint32 fillBuffersFor(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                              uint32) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *, const QueuedRenderable &, bool, uint32,
+                                CommandBuffer *) override
+        {
+            return 0;
+        }
+
+        /// What calculateHashFor does for a Renderable, with made up properties.
+        void calculateHashForItem(const IdStringVec &propertyNames, size_t itemIdx,
+                                  uint32 &outHash, uint32 &outCasterHash)
+        {
+            mT[kNoTid].setProperties.clear();
+
+            for (size_t i = 0; i < propertyNames.size(); ++i)
+                setProperty(kNoTid, propertyNames[i], static_cast<int32>((itemIdx + i) % 3u));
+
+            // Something unique per item, e.g. its input layout or its macroblock
+            setProperty(kNoTid, "unique_id", static_cast<int32>(itemIdx));
+
+            outHash = addRenderableCache(mT[kNoTid].setProperties, 0);
+
+            setProperty(kNoTid, propertyNames[0], 0);
+            setProperty(kNoTid, propertyNames[1], 0);
+            outCasterHash = addRenderableCache(mT[kNoTid].setProperties, 0);
+        }
+
+        uint32 _addRenderableCache(const HlmsPropertyVec &properties, const PiecesMap *pieces)
+        {
+            return addRenderableCache(properties, pieces);
+        }
+
+        size_t getNumRenderableCacheEntries() const { return mRenderableCache.size(); }
+    };
+
+    /// Same property names calculateHashFor & HlmsPbs::calculateHashForPreCreate typically set
+    IdStringVec getTypicalPropertyNames()
+    {
+        const char *names[] = { "hlms_skeleton",
+                                "hlms_pose",
+                                "hlms_pose_half",
+                                "hlms_pose_normals",
+                                "hlms_uv_count",
+                                "hlms_uv_count0",
+                                "hlms_uv_count1",
+                                "hlms_normal",
+                                "hlms_qtangent",
+                                "hlms_tangent",
+                                "hlms_tangent4",
+                                "hlms_colour",
+                                "hlms_bones_per_vertex",
+                                "hlms_identity_world",
+                                "hlms_identity_viewproj",
+                                "hlms_identity_viewproj_dynamic",
+                                "PsoMacroblock",
+                                "PsoBlendblock",
+                                "PsoInputLayoutId",
+                                "hlms_alphablend",
+                                "alpha_test",
+                                "normal_map",
+                                "normal_map_tex",
+                                "diffuse_map",
+                                "diffuse_map0",
+                                "specular_map",
+                                "roughness_map",
+                                "emissive_map",
+                                "detail_weight_map",
+                                "detail_maps_diffuse",
+                                "detail_maps_normal",
+                                "first_valid_detail_map_nm",
+                                "second_valid_detail_map_nm",
+                                "num_textures",
+                                "num_samplers",
+                                "fresnel_scalar",
+                                "metallic_workflow",
+                                "BRDF_Default",
+                                "receive_shadows",
+                                "two_sided_lighting",
+                                "uv_diffuse",
+                                "uv_normal",
+                                "uv_specular",
+                                "uv_roughness",
+                                "uv_emissive" };
+
+        IdStringVec retVal;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+            retVal.push_back(names[i]);
+        return retVal;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsPropertyTests::setUp() {}
+//--------------------------------------------------------------------------
+void HlmsPropertyTests::tearDown() {}
+//--------------------------------------------------------------------------
+void HlmsPropertyTests::testFindPropertyLowerBound()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsPropertyVec properties;
+    for (size_t numProperties = 0; numProperties < 300u; ++numProperties)
+    {
+        for (size_t i = 0; i < numProperties + 8u; ++i)
+        {
+            // Even keys are in the vector when i < numProperties, odd keys never are
+            const IdString key("property" + StringConverter::toString(i));
+            const size_t expected = static_cast<size_t>(
+                std::lower_bound(properties.begin(), properties.end(), HlmsProperty(key, 0),
+                                 OrderPropertyByIdString) -
+                properties.begin());
+            CPPUNIT_ASSERT_EQUAL(expected, findPropertyLowerBound(properties, key));
+        }
+
+        Hlms::setProperty(properties, "property" + StringConverter::toString(numProperties),
+                          static_cast<int32>(numProperties));
+        CPPUNIT_ASSERT_EQUAL(numProperties + 1u, properties.size());
+    }
+
+    for (size_t i = 0; i < properties.size(); ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(static_cast<int32>(i),
+                             Hlms::getProperty(properties, "property" + StringConverter::toString(i),
+                                               -1));
+    }
+    CPPUNIT_ASSERT_EQUAL(-1, Hlms::getProperty(properties, "not_set", -1));
+}
+//--------------------------------------------------------------------------
+void HlmsPropertyTests::testRenderableCache()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PropertyTestHlms hlms;
+
+    HlmsPropertyVec propertiesA;
+    Hlms::setProperty(propertiesA, "hlms_normal", 1);
+    Hlms::setProperty(propertiesA, "hlms_uv_count", 2);
+
+    HlmsPropertyVec propertiesB = propertiesA;
+    Hlms::setProperty(propertiesB, "hlms_uv_count", 1);
+
+    PiecesMap pieces[NumShaderTypes];
+    pieces[PixelShader]["alpha_test_cmp_func"] = "<";
+
+    const uint32 hashA = hlms._addRenderableCache(propertiesA, 0);
+    const uint32 hashB = hlms._addRenderableCache(propertiesB, 0);
+    const uint32 hashAPieces = hlms._addRenderableCache(propertiesA, pieces);
+
+    CPPUNIT_ASSERT(hashA != hashB);
+    CPPUNIT_ASSERT(hashA != hashAPieces);
+    CPPUNIT_ASSERT(hashB != hashAPieces);
+
+    // Same contents must return the same entry
+    PiecesMap emptyPieces[NumShaderTypes];
+    CPPUNIT_ASSERT_EQUAL(hashA, hlms._addRenderableCache(propertiesA, 0));
+    CPPUNIT_ASSERT_EQUAL(hashA, hlms._addRenderableCache(propertiesA, emptyPieces));
+    CPPUNIT_ASSERT_EQUAL(hashB, hlms._addRenderableCache(propertiesB, 0));
+    CPPUNIT_ASSERT_EQUAL(hashAPieces, hlms._addRenderableCache(propertiesA, pieces));
+
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, hlms.getNumRenderableCacheEntries());
+}
+//--------------------------------------------------------------------------
+void HlmsPropertyTests::testCalculateHashForBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numItems = 50000u;
+    const IdStringVec propertyNames = getTypicalPropertyNames();
+
+    PropertyTestHlms hlms;
+
+    Timer timer;
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        uint32 hash, casterHash;
+        hlms.calculateHashForItem(propertyNames, i, hash, casterHash);
+    }
+    const uint64 uniqueTime = timer.getMicroseconds();
+
+    CPPUNIT_ASSERT_EQUAL(numItems * 2u, hlms.getNumRenderableCacheEntries());
+
+    // Spawning the same items again must reuse every entry
+    timer.reset();
+    for (size_t i = 0; i < numItems; ++i)
+    {
+        uint32 hash, casterHash;
+        hlms.calculateHashForItem(propertyNames, i, hash, casterHash);
+        CPPUNIT_ASSERT_EQUAL(static_cast<uint32>(i * 2u),
+                             (hash >> HlmsBits::RenderableShift) & HlmsBits::RenderableMask);
+    }
+    const uint64 repeatedTime = timer.getMicroseconds();
+
+    CPPUNIT_ASSERT_EQUAL(numItems * 2u, hlms.getNumRenderableCacheEntries());
+
+    LogManager::getSingleton().logMessage(
+        "calculateHashFor, " + StringConverter::toString(numItems) + " unique items with " +
+        StringConverter::toString(propertyNames.size() + 1u) + " properties: " +
+        StringConverter::toString(uniqueTime) + " us, " + StringConverter::toString(numItems) +
+        " repeated items: " + StringConverter::toString(repeatedTime) + " us");
+}
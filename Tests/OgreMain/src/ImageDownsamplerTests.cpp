@@ -0,0 +1,275 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ImageDownsamplerTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreImageDownsampler.h"
+#include "OgreLogManager.h"
+#include "OgrePlatformInformation.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageDownsamplerTests);
+
+namespace
+{
+    enum DownsamplerFormat
+    {
+        FormatXXXA8888,
+        FormatSRgbXXXA8888,
+        FormatFloat32XXXA
+    };
+
+    ImageDownsampler2D *getGenericDownsampler(DownsamplerFormat format)
+    {
+        switch (format)
+        {
+        case FormatXXXA8888:
+            return downscale2x_XXXA8888;
+        case FormatSRgbXXXA8888:
+            return downscale2x_sRGB_XXXA8888;
+        case FormatFloat32XXXA:
+            break;
+        }
+        return downscale2x_Float32_XXXA;
+    }
+
+    ImageDownsampler2DBilinear *getBilinearDownsampler(DownsamplerFormat format)
+    {
+        switch (format)
+        {
+        case FormatXXXA8888:
+            return downscale2xBilinear_XXXA8888;
+        case FormatSRgbXXXA8888:
+            return downscale2xBilinear_sRGB_XXXA8888;
+        case FormatFloat32XXXA:
+            break;
+        }
+        return downscale2xBilinear_Float32_XXXA;
+    }
+
+    struct TestImage
+    {
+        std::vector<uint8> data;
+        int32 width;
+        int32 height;
+        int32 bytesPerRow;
+        int32 dstWidth;
+        int32 dstHeight;
+        int32 dstBytesPerRow;
+
+        TestImage(DownsamplerFormat format, int32 _width, int32 _height, uint32 seed) :
+            width(_width),
+            height(_height)
+        {
+            const int32 bytesPerPixel = format == FormatFloat32XXXA ? 16 : 4;
+            bytesPerRow = width * bytesPerPixel;
+            dstWidth = std::max(width >> 1, 1);
+            dstHeight = std::max(height >> 1, 1);
+            dstBytesPerRow = dstWidth * bytesPerPixel;
+            data.resize(size_t(bytesPerRow) * size_t(height));
+
+            // Deterministic LCG so that failures can be reproduced
+            if (format == FormatFloat32XXXA)
+            {
+                float *dataF32 = reinterpret_cast<float *>(&data[0]);
+                for (size_t i = 0; i < data.size() / sizeof(float); ++i)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    dataF32[i] = float(int32(seed >> 8u) - (1 << 23)) / float(1 << 20);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < data.size(); ++i)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    data[i] = static_cast<uint8>(seed >> 24u);
+                }
+            }
+        }
+
+        void downscaleGeneric(DownsamplerFormat format, uint8 *dst) const
+        {
+            const FilterKernel &filter = c_filterKernels[1];
+            (*getGenericDownsampler(format))(dst, &data[0], dstWidth, dstHeight, dstBytesPerRow,
+                                             width, bytesPerRow, filter.kernel, filter.kernelStartX,
+                                             filter.kernelEndX, filter.kernelStartY,
+                                             filter.kernelEndY);
+        }
+
+        void downscaleBilinear(DownsamplerFormat format, uint8 *dst, int32 rowStart,
+                               int32 rowEnd) const
+        {
+            (*getBilinearDownsampler(format))(dst, &data[0], dstWidth, dstHeight, dstBytesPerRow,
+                                              bytesPerRow, rowStart, rowEnd);
+        }
+    };
+
+    /// Checks the SIMD bilinear downsampler is bit-exact with the generic one
+    void testBilinearBitExact(DownsamplerFormat format)
+    {
+        // Odd sizes exercise the scalar tails and the last row/column not being averaged
+        const int32 sizes[][2] = { { 1, 1 },   { 2, 2 },   { 3, 3 },   { 7, 5 },  { 8, 8 },
+                                   { 17, 9 },  { 31, 2 },  { 64, 64 }, { 1, 33 }, { 129, 1 },
+                                   { 130, 67 } };
+
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+        {
+            const TestImage image(format, sizes[i][0], sizes[i][1], static_cast<uint32>(i + 1u));
+            const size_t dstSize = size_t(image.dstBytesPerRow) * size_t(image.dstHeight);
+
+            std::vector<uint8> expected(dstSize, 0xCD);
+            std::vector<uint8> result(dstSize, 0xAB);
+            image.downscaleGeneric(format, &expected[0]);
+            image.downscaleBilinear(format, &result[0], 0, image.dstHeight);
+
+            CPPUNIT_ASSERT(memcmp(&expected[0], &result[0], dstSize) == 0);
+        }
+    }
+
+    struct DownsampleTask : public UniformScalableTask
+    {
+        const TestImage &image;
+        DownsamplerFormat format;
+        uint8 *dst;
+
+        DownsampleTask(const TestImage &_image, DownsamplerFormat _format, uint8 *_dst) :
+            image(_image),
+            format(_format),
+            dst(_dst)
+        {
+        }
+
+        void execute(size_t chunkIdx, size_t numChunks) override
+        {
+            const size_t height = size_t(image.dstHeight);
+            image.downscaleBilinear(format, dst, int32(height * chunkIdx / numChunks),
+                                    int32(height * (chunkIdx + 1u) / numChunks));
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testBilinearXXXA8888()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    testBilinearBitExact(FormatXXXA8888);
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testBilinearSRgbXXXA8888()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    testBilinearBitExact(FormatSRgbXXXA8888);
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testBilinearFloat32XXXA()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    testBilinearBitExact(FormatFloat32XXXA);
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testBilinearRowRanges()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Splitting the work across threads must produce the same result
+    const TestImage image(FormatXXXA8888, 101, 203, 1234u);
+    const size_t dstSize = size_t(image.dstBytesPerRow) * size_t(image.dstHeight);
+
+    std::vector<uint8> expected(dstSize, 0xCD);
+    image.downscaleGeneric(FormatXXXA8888, &expected[0]);
+
+    TaskScheduler scheduler(3u);
+    const size_t numChunks[] = { 1u, 2u, 7u, size_t(image.dstHeight) };
+    for (size_t i = 0; i < sizeof(numChunks) / sizeof(numChunks[0]); ++i)
+    {
+        std::vector<uint8> result(dstSize, 0xAB);
+        DownsampleTask task(image, FormatXXXA8888, &result[0]);
+        scheduler.executeUniformScalableTask(&task, numChunks[i]);
+        CPPUNIT_ASSERT(memcmp(&expected[0], &result[0], dstSize) == 0);
+    }
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testBilinearBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Timings are informative only
+    const size_t numThreads = std::max<size_t>(PlatformInformation::getNumLogicalCores(), 2u);
+    TaskScheduler scheduler(numThreads - 1u);
+
+    const char *formatNames[] = { "RGBA8", "RGBA8 sRGB", "RGBA32F" };
+    const DownsamplerFormat formats[] = { FormatXXXA8888, FormatSRgbXXXA8888, FormatFloat32XXXA };
+    const int numIterations = 8;
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+    {
+        const TestImage image(formats[i], 2048, 2048, 42u);
+        std::vector<uint8> dst(size_t(image.dstBytesPerRow) * size_t(image.dstHeight));
+
+        Timer timer;
+        for (int j = 0; j < numIterations; ++j)
+            image.downscaleGeneric(formats[i], &dst[0]);
+        const double genericTime = double(timer.getMicroseconds()) / numIterations;
+
+        timer.reset();
+        for (int j = 0; j < numIterations; ++j)
+            image.downscaleBilinear(formats[i], &dst[0], 0, image.dstHeight);
+        const double simdTime = double(timer.getMicroseconds()) / numIterations;
+
+        DownsampleTask task(image, formats[i], &dst[0]);
+        timer.reset();
+        for (int j = 0; j < numIterations; ++j)
+            scheduler.executeUniformScalableTask(&task, size_t(image.dstHeight) / 64u);
+        const double threadedTime = double(timer.getMicroseconds()) / numIterations;
+
+        LogManager::getSingleton().logMessage(
+            "ImageDownsampler 2048x2048 " + String(formatNames[i]) + ": generic " +
+            StringConverter::toString(genericTime) + " us, SIMD " +
+            StringConverter::toString(simdTime) + " us, SIMD + " +
+            StringConverter::toString(numThreads) + " threads " +
+            StringConverter::toString(threadedTime) + " us");
+    }
+}
@@ -0,0 +1,197 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ImageStreamingDecodeTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgrePrerequisites.h"
+
+#if OGRE_NO_STBI_CODEC == 0
+
+#include "OgreDataStream.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreSTBICodec.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageStreamingDecodeTests);
+
+namespace
+{
+    /// Builds an uncompressed, top-left origin TGA with a different value in every byte
+    std::vector<uint8> createTga(uint16 width, uint16 height, uint8 bitsPerPixel)
+    {
+        const size_t headerSize = 18u;
+        const size_t numBytes = size_t(width) * height * (bitsPerPixel / 8u);
+
+        std::vector<uint8> retVal(headerSize + numBytes, 0u);
+        retVal[2] = bitsPerPixel == 8u ? 3u : 2u;  // Greyscale or truecolour
+        retVal[12] = static_cast<uint8>(width & 0xFF);
+        retVal[13] = static_cast<uint8>(width >> 8u);
+        retVal[14] = static_cast<uint8>(height & 0xFF);
+        retVal[15] = static_cast<uint8>(height >> 8u);
+        retVal[16] = bitsPerPixel;
+        retVal[17] = 0x20;  // Top-left origin
+
+        for (size_t i = 0; i < numBytes; ++i)
+            retVal[headerSize + i] = static_cast<uint8>(i * 7u + i / 251u);
+        return retVal;
+    }
+
+    DataStreamPtr createStream(std::vector<uint8> &file)
+    {
+        return DataStreamPtr(OGRE_NEW MemoryDataStream(&file[0], file.size(), false, true));
+    }
+
+    /// Stores the rows it receives tightly packed, and checks they arrive in order
+    class RowCollector : public ImageCodec2::StreamingListener
+    {
+    public:
+        ImageCodec2::ImageData2 header;
+        std::vector<uint8> pixels;
+        uint32 maxRowsSeen;
+        uint32 numBatches;
+        uint32 maxBatches;
+        bool rowsInOrder;
+
+        RowCollector() : maxRowsSeen(0u), numBatches(0u), maxBatches(~0u), rowsInOrder(true) {}
+
+        bool headerDecoded(const ImageCodec2::ImageData2 &_header) override
+        {
+            header = _header;
+            return true;
+        }
+
+        bool rowsDecoded(const TextureBox &rows, uint8 mipLevel, uint32 zOrSlice,
+                         uint32 firstRow) override
+        {
+            const size_t bytesPerRow = size_t(rows.width) * rows.bytesPerPixel;
+            if (mipLevel != 0u || zOrSlice != 0u || firstRow * bytesPerRow != pixels.size())
+                rowsInOrder = false;
+
+            for (uint32 y = 0u; y < rows.height; ++y)
+            {
+                const uint8 *row = reinterpret_cast<const uint8 *>(rows.at(0u, y, 0u));
+                pixels.insert(pixels.end(), row, row + bytesPerRow);
+            }
+            maxRowsSeen = std::max(maxRowsSeen, rows.height);
+            ++numBatches;
+            return numBatches < maxBatches;
+        }
+    };
+
+    /// Returns decode()'s pixels tightly packed
+    std::vector<uint8> decodeWhole(const STBIImageCodec &codec, std::vector<uint8> &file,
+                                   PixelFormatGpu &outFormat)
+    {
+        DataStreamPtr stream = createStream(file);
+        Codec::DecodeResult res = codec.decode(stream);
+        const ImageCodec2::ImageData2 *imgData =
+            static_cast<const ImageCodec2::ImageData2 *>(res.second.get());
+
+        outFormat = imgData->format;
+        const TextureBox &box = imgData->box;
+        const size_t bytesPerRow = size_t(box.width) * box.bytesPerPixel;
+
+        std::vector<uint8> retVal;
+        for (uint32 y = 0u; y < box.height; ++y)
+        {
+            const uint8 *row = reinterpret_cast<const uint8 *>(box.at(0u, y, 0u));
+            retVal.insert(retVal.end(), row, row + bytesPerRow);
+        }
+        return retVal;
+    }
+
+    void checkRowsMatchDecode(uint16 width, uint16 height, uint8 bitsPerPixel,
+                              uint32 maxRowsPerBatch)
+    {
+        STBIImageCodec codec("tga");
+        std::vector<uint8> file = createTga(width, height, bitsPerPixel);
+
+        PixelFormatGpu format;
+        const std::vector<uint8> expected = decodeWhole(codec, file, format);
+
+        RowCollector collector;
+        DataStreamPtr stream = createStream(file);
+        CPPUNIT_ASSERT(codec.decodeStreaming(stream, &collector, maxRowsPerBatch));
+
+        CPPUNIT_ASSERT_EQUAL(uint32(width), collector.header.box.width);
+        CPPUNIT_ASSERT_EQUAL(uint32(height), collector.header.box.height);
+        CPPUNIT_ASSERT(collector.header.format == format);
+        CPPUNIT_ASSERT(collector.header.box.data == 0);
+
+        CPPUNIT_ASSERT(collector.rowsInOrder);
+        CPPUNIT_ASSERT_EQUAL(maxRowsPerBatch, collector.maxRowsSeen);
+        CPPUNIT_ASSERT_EQUAL((height + maxRowsPerBatch - 1u) / maxRowsPerBatch,
+                             collector.numBatches);
+        CPPUNIT_ASSERT(collector.pixels == expected);
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ImageStreamingDecodeTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void ImageStreamingDecodeTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ImageStreamingDecodeTests::testRgbRowsMatchDecode()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // RGB gets expanded to RGBA a batch at a time. The last batch is shorter
+    checkRowsMatchDecode(7u, 10u, 24u, 3u);
+}
+//--------------------------------------------------------------------------
+void ImageStreamingDecodeTests::testGreyRowsMatchDecode()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Rows are handed out from stb_image's buffer, which isn't padded to 4 bytes
+    checkRowsMatchDecode(5u, 9u, 8u, 4u);
+}
+//--------------------------------------------------------------------------
+void ImageStreamingDecodeTests::testListenerCanAbort()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    STBIImageCodec codec("tga");
+    std::vector<uint8> file = createTga(4u, 16u, 24u);
+
+    RowCollector collector;
+    collector.maxBatches = 2u;
+    DataStreamPtr stream = createStream(file);
+    CPPUNIT_ASSERT(!codec.decodeStreaming(stream, &collector, 4u));
+    CPPUNIT_ASSERT_EQUAL(2u, collector.numBatches);
+}
+//--------------------------------------------------------------------------
+#endif
@@ -0,0 +1,452 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "IncrementalTransformTests.h"
+#include "UnitTestSuite.h"
+
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreId.h"
+#include "OgreLogManager.h"
+#include "OgreMovableObject.h"
+#include "OgreSceneNode.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(IncrementalTransformTests);
+
+namespace
+{
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        TestMovableObject(ObjectMemoryManager *objectMemoryManager) :
+            MovableObject(Id::generateNewId<MovableObject>(), objectMemoryManager, 0, 0)
+        {
+            setLocalAabb(Aabb(Vector3::ZERO, Vector3(0.5f)));
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    /// Creates a node without a SceneManager, optionally attached to parent
+    SceneNode* createNode(NodeMemoryManager &nodeMemoryManager, SceneNode *parent)
+    {
+        SceneNode *node = OGRE_NEW SceneNode(Id::generateNewId<Node>(), 0, &nodeMemoryManager, 0);
+        if (parent)
+            parent->addChild(node);
+        return node;
+    }
+
+    void destroyNodes(std::vector<SceneNode*> &nodes)
+    {
+        for (size_t i = 0; i < nodes.size(); ++i)
+            OGRE_DELETE nodes[i];
+        nodes.clear();
+    }
+
+    /// Same as SceneManager::updateAllTransforms with setIncrementalTransformUpdates( true )
+    void updateAllTransforms(NodeMemoryManager &nodeMemoryManager, bool incremental = true)
+    {
+        const size_t numDepths = nodeMemoryManager.getNumDepths();
+        for (size_t i = 0; i < numDepths; ++i)
+        {
+            Transform t;
+            const size_t numNodes = nodeMemoryManager.getFirstNode(t, i);
+            Node::updateAllTransforms(numNodes, t, incremental);
+        }
+    }
+
+    /// Same as SceneManager::updateAllBounds with setIncrementalTransformUpdates( true )
+    void updateAllBounds(ObjectMemoryManager &objectMemoryManager, bool incremental = true)
+    {
+        const size_t numRenderQueues = objectMemoryManager.getNumRenderQueues();
+        for (size_t i = 0; i < numRenderQueues; ++i)
+        {
+            ObjectData objData;
+            const size_t numObjs = objectMemoryManager.getFirstObjectData(objData, i);
+            MovableObject::updateAllBounds(numObjs, objData, incremental);
+        }
+    }
+
+    uint8 getDirtyFlags(Node *node)
+    {
+        const Transform &t = node->_getTransform();
+        return t.mDirtyFlags[t.mIndex];
+    }
+
+    /// Reads the SoA memory directly; _getDerivedPosition asserts if the node is out of date
+    Vector3 getDerivedPosition(Node *node)
+    {
+        const Transform &t = node->_getTransform();
+        return t.mDerivedPosition->getAsVector3(t.mIndex);
+    }
+
+    void setDerivedPosition(Node *node, const Vector3 &derivedPos)
+    {
+        Transform &t = node->_getTransform();
+        t.mDerivedPosition->setFromVector3(derivedPos, t.mIndex);
+    }
+
+    /// Reads the SoA memory directly, like getDerivedPosition
+    Aabb getWorldAabb(MovableObject *object)
+    {
+        const ObjectData &objData = object->_getObjectData();
+        Aabb aabb;
+        objData.mWorldAabb->getAsAabb(aabb, objData.mIndex);
+        return aabb;
+    }
+
+    Real getWorldRadius(MovableObject *object)
+    {
+        const ObjectData &objData = object->_getObjectData();
+        return objData.mWorldRadius[objData.mIndex];
+    }
+
+    void setWorldBounds(MovableObject *object, const Aabb &aabb, Real radius)
+    {
+        ObjectData &objData = object->_getObjectData();
+        objData.mWorldAabb->setFromAabb(aabb, objData.mIndex);
+        objData.mWorldRadius[objData.mIndex] = radius;
+    }
+
+    /// World Aabb of a TestMovableObject whose node is at (x, 0, 0) with scale 1
+    Aabb expectedAabb(size_t x, Real halfSize = 0.5f)
+    {
+        return Aabb(Vector3((Real)x, 0, 0), Vector3(halfSize));
+    }
+
+    bool positionEquals(const Aabb &a, const Aabb &b)
+    {
+        return a.mCenter.positionEquals(b.mCenter) && a.mHalfSize.positionEquals(b.mHalfSize);
+    }
+
+    /// Destroys them in reverse creation order, which doesn't trigger defragmentation
+    void destroyObjects(std::vector<TestMovableObject*> &objects)
+    {
+        for (size_t i = objects.size(); i--;)
+        {
+            objects[i]->detachFromParent();
+            OGRE_DELETE objects[i];
+        }
+        objects.clear();
+    }
+}
+
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::testCleanSubtreeIsSkipped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Two groups of ARRAY_PACKED_REALS roots with one child each, so that
+    // each group fills its own pack at every depth level
+    const size_t numPerGroup = ARRAY_PACKED_REALS;
+
+    NodeMemoryManager nodeMemoryManager;
+    std::vector<SceneNode*> roots;
+    std::vector<SceneNode*> children;
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        roots.push_back(createNode(nodeMemoryManager, 0));
+        roots.back()->setPosition(Vector3((Real)i, 0, 0));
+    }
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        children.push_back(createNode(nodeMemoryManager, roots[i]));
+        children.back()->setPosition(Vector3(0, 1, 0));
+    }
+
+    // Group A and group B must not share packs, otherwise this test is meaningless
+    CPPUNIT_ASSERT(roots[0]->_getTransform().mPosition !=
+                   roots[numPerGroup]->_getTransform().mPosition);
+    CPPUNIT_ASSERT(children[0]->_getTransform().mPosition !=
+                   children[numPerGroup]->_getTransform().mPosition);
+
+    // Newly created nodes are dirty
+    updateAllTransforms(nodeMemoryManager);
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(roots[i]));
+        CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(children[i]));
+        CPPUNIT_ASSERT(getDerivedPosition(children[i]) == Vector3((Real)i, 1, 0));
+    }
+
+    // Nothing changed. If anything were recalculated the garbage would be overwritten
+    const Vector3 garbage(999, 999, 999);
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+        setDerivedPosition(children[i], garbage);
+    updateAllTransforms(nodeMemoryManager);
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(roots[i]));
+        CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(children[i]));
+        CPPUNIT_ASSERT(getDerivedPosition(children[i]) == garbage);
+    }
+
+    // Move a root from group A. Its whole pack gets recalculated, group B is left alone
+    roots[0]->setPosition(Vector3(0, 0, 5));
+    updateAllTransforms(nodeMemoryManager);
+    for (size_t i = 0; i < numPerGroup; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(roots[i]));
+        CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(children[i]));
+    }
+    CPPUNIT_ASSERT(getDerivedPosition(children[0]) == Vector3(0, 1, 5));
+    for (size_t i = 1; i < numPerGroup; ++i)
+        CPPUNIT_ASSERT(getDerivedPosition(children[i]) == Vector3((Real)i, 1, 0));
+    for (size_t i = numPerGroup; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(roots[i]));
+        CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(children[i]));
+        CPPUNIT_ASSERT(getDerivedPosition(children[i]) == garbage);
+    }
+
+    destroyNodes(children);
+    destroyNodes(roots);
+}
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::testDirtyParentPropagatesToChildren()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    NodeMemoryManager nodeMemoryManager;
+    std::vector<SceneNode*> nodes;
+    SceneNode *root = createNode(nodeMemoryManager, 0);
+    SceneNode *child = createNode(nodeMemoryManager, root);
+    SceneNode *grandChild = createNode(nodeMemoryManager, child);
+    nodes.push_back(grandChild);
+    nodes.push_back(child);
+    nodes.push_back(root);
+
+    child->setPosition(Vector3(0, 1, 0));
+    grandChild->setPosition(Vector3(0, 0, 1));
+    updateAllTransforms(nodeMemoryManager);
+    updateAllTransforms(nodeMemoryManager);
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(grandChild));
+    CPPUNIT_ASSERT(getDerivedPosition(grandChild) == Vector3(0, 1, 1));
+
+    // Only the root was touched, but the change must reach the grand child
+    root->setPosition(Vector3(5, 0, 0));
+    root->setScale(Vector3(2, 2, 2));
+    updateAllTransforms(nodeMemoryManager);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(nodes[i]));
+    CPPUNIT_ASSERT(getDerivedPosition(child) == Vector3(5, 2, 0));
+    CPPUNIT_ASSERT(getDerivedPosition(grandChild) == Vector3(5, 2, 2));
+
+    // Changes deeper in the hierarchy don't dirty the ancestors
+    grandChild->setPosition(Vector3(0, 0, 3));
+    updateAllTransforms(nodeMemoryManager);
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(root));
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(child));
+    CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(grandChild));
+    CPPUNIT_ASSERT(getDerivedPosition(grandChild) == Vector3(5, 2, 6));
+
+    // Writing the SoA memory directly requires flagging the node by hand
+    Transform &childTransform = child->_getTransform();
+    childTransform.mPosition->setFromVector3(Vector3(0, 2, 0), childTransform.mIndex);
+    child->_setTransformDirty();
+    updateAllTransforms(nodeMemoryManager);
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, getDirtyFlags(root));
+    CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(child));
+    CPPUNIT_ASSERT_EQUAL((uint8)TransformDirtyFlags::DerivedChanged, getDirtyFlags(grandChild));
+    CPPUNIT_ASSERT(getDerivedPosition(grandChild) == Vector3(5, 4, 6));
+
+    destroyNodes(nodes);
+}
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::testCleanBoundsAreSkipped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Two packs of objects, each object attached to its own node
+    const size_t numPerGroup = ARRAY_PACKED_REALS;
+
+    NodeMemoryManager nodeMemoryManager;
+    ObjectMemoryManager objectMemoryManager;
+    std::vector<SceneNode*> nodes;
+    std::vector<TestMovableObject*> objects;
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        nodes.push_back(createNode(nodeMemoryManager, 0));
+        nodes.back()->setPosition(Vector3((Real)i, 0, 0));
+        objects.push_back(OGRE_NEW TestMovableObject(&objectMemoryManager));
+        nodes.back()->attachObject(objects.back());
+    }
+
+    // Group A and group B must not share packs, otherwise this test is meaningless
+    CPPUNIT_ASSERT(objects[0]->_getObjectData().mWorldAabb !=
+                   objects[numPerGroup]->_getObjectData().mWorldAabb);
+
+    updateAllTransforms(nodeMemoryManager);
+    updateAllBounds(objectMemoryManager);
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT(positionEquals(getWorldAabb(objects[i]), expectedAabb(i)));
+        CPPUNIT_ASSERT(Math::RealEqual(objects[i]->getLocalRadius(), getWorldRadius(objects[i])));
+    }
+
+    // Nothing changed. If anything were recalculated the garbage would be overwritten
+    const Aabb garbageAabb(Vector3(999, 999, 999), Vector3(1, 1, 1));
+    const Real garbageRadius = 999.0f;
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+        setWorldBounds(objects[i], garbageAabb, garbageRadius);
+    updateAllTransforms(nodeMemoryManager);
+    updateAllBounds(objectMemoryManager);
+    for (size_t i = 0; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT(getWorldAabb(objects[i]) == garbageAabb);
+        CPPUNIT_ASSERT_EQUAL(garbageRadius, getWorldRadius(objects[i]));
+    }
+
+    // Move the node of an object from group A. Its whole pack gets recalculated,
+    // group B is left alone
+    nodes[0]->setPosition(Vector3(0, 0, 5));
+    nodes[0]->setScale(Vector3(2, 2, 2));
+    updateAllTransforms(nodeMemoryManager);
+    updateAllBounds(objectMemoryManager);
+    CPPUNIT_ASSERT(positionEquals(getWorldAabb(objects[0]), Aabb(Vector3(0, 0, 5), Vector3(1.0f))));
+    CPPUNIT_ASSERT(
+        Math::RealEqual(objects[0]->getLocalRadius() * 2.0f, getWorldRadius(objects[0])));
+    for (size_t i = 1; i < numPerGroup; ++i)
+    {
+        CPPUNIT_ASSERT(positionEquals(getWorldAabb(objects[i]), expectedAabb(i)));
+        CPPUNIT_ASSERT(Math::RealEqual(objects[i]->getLocalRadius(), getWorldRadius(objects[i])));
+    }
+    for (size_t i = numPerGroup; i < numPerGroup * 2u; ++i)
+    {
+        CPPUNIT_ASSERT(getWorldAabb(objects[i]) == garbageAabb);
+        CPPUNIT_ASSERT_EQUAL(garbageRadius, getWorldRadius(objects[i]));
+    }
+
+    // Changing the local bounds of an object in group B only recalculates group B
+    for (size_t i = 0; i < numPerGroup; ++i)
+        setWorldBounds(objects[i], garbageAabb, garbageRadius);
+    objects[numPerGroup]->setLocalAabb(Aabb(Vector3::ZERO, Vector3(3.0f)));
+    updateAllTransforms(nodeMemoryManager);
+    updateAllBounds(objectMemoryManager);
+    for (size_t i = 0; i < numPerGroup; ++i)
+    {
+        CPPUNIT_ASSERT(getWorldAabb(objects[i]) == garbageAabb);
+        CPPUNIT_ASSERT_EQUAL(garbageRadius, getWorldRadius(objects[i]));
+    }
+    CPPUNIT_ASSERT(
+        positionEquals(getWorldAabb(objects[numPerGroup]), expectedAabb(numPerGroup, 3.0f)));
+    for (size_t i = numPerGroup + 1u; i < numPerGroup * 2u; ++i)
+        CPPUNIT_ASSERT(positionEquals(getWorldAabb(objects[i]), expectedAabb(i)));
+
+    destroyObjects(objects);
+    destroyNodes(nodes);
+}
+//--------------------------------------------------------------------------
+void IncrementalTransformTests::testUpdateBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // 500k nodes with one object each, 5% of them (chosen at random) moving every frame.
+    // Compares a full transform + bounds update against the incremental one.
+    // Timings are informative only.
+    const size_t numNodes = 500000u;
+    const size_t numMoving = numNodes / 20u;
+    const int numFrames = 10;
+
+    NodeMemoryManager nodeMemoryManager;
+    ObjectMemoryManager objectMemoryManager;
+    std::vector<SceneNode*> nodes;
+    std::vector<TestMovableObject*> objects;
+    nodes.reserve(numNodes);
+    objects.reserve(numNodes);
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        nodes.push_back(createNode(nodeMemoryManager, 0));
+        nodes.back()->setPosition(Vector3((Real)(i % 1000u), 0, (Real)(i / 1000u)));
+        objects.push_back(OGRE_NEW TestMovableObject(&objectMemoryManager));
+        nodes.back()->attachObject(objects.back());
+    }
+
+    srand(0);
+    std::vector<SceneNode*> moving;
+    moving.reserve(numMoving);
+    for (size_t i = 0; i < numMoving; ++i)
+        moving.push_back(nodes[(size_t)rand() % numNodes]);
+
+    uint64 times[2] = { 0u, 0u };
+    Timer timer;
+    for (int incremental = 0; incremental < 2; ++incremental)
+    {
+        updateAllTransforms(nodeMemoryManager, false);
+        updateAllBounds(objectMemoryManager, false);
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            for (size_t i = 0; i < numMoving; ++i)
+                moving[i]->translate(Vector3(0, 0.1f, 0));
+
+            timer.reset();
+            updateAllTransforms(nodeMemoryManager, incremental != 0);
+            updateAllBounds(objectMemoryManager, incremental != 0);
+            times[incremental] += timer.getMicroseconds();
+        }
+    }
+
+    // Both passes moved the same nodes, so the results must be the up to date ones
+    for (size_t i = 0; i < numMoving; ++i)
+    {
+        const Aabb aabb = getWorldAabb(moving[i]->getAttachedObject(0));
+        CPPUNIT_ASSERT(aabb.mCenter.positionEquals(getDerivedPosition(moving[i])));
+    }
+
+    LogManager::getSingleton().logMessage(
+        "Transform + bounds update, " + StringConverter::toString(numNodes) + " nodes, " +
+        StringConverter::toString(numMoving) + " moving. Mean frame time: full " +
+        StringConverter::toString(times[0] / numFrames) + " us, incremental " +
+        StringConverter::toString(times[1] / numFrames) + " us");
+
+    destroyObjects(objects);
+    std::reverse(nodes.begin(), nodes.end());
+    destroyNodes(nodes);
+}
@@ -0,0 +1,215 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "PixelFormatGpuUtilsTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTimer.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(PixelFormatGpuUtilsTests);
+
+namespace
+{
+    // Formats with fast paths in bulkPixelConversion
+    const PixelFormatGpu c_fastFormats[] = {
+        PFG_RGBA8_UNORM,       PFG_RGBA8_UNORM_SRGB, PFG_BGRA8_UNORM,  PFG_BGRA8_UNORM_SRGB,
+        PFG_R10G10B10A2_UNORM, PFG_RGBA16_FLOAT,     PFG_RGBA32_FLOAT, PFG_RGB8_UNORM,
+        PFG_BGR8_UNORM
+    };
+
+    struct TestImage
+    {
+        std::vector<uint8> data;
+        TextureBox box;
+
+        TestImage(PixelFormatGpu format, uint32 width, uint32 height)
+        {
+            const uint32 bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel(format);
+            // Padding at the end of each row must be left untouched
+            const uint32 bytesPerRow = width * bytesPerPixel + 4u;
+            data.resize(size_t(bytesPerRow) * height, 0xCD);
+            box = TextureBox(width, height, 1u, 1u, bytesPerPixel, bytesPerRow,
+                             size_t(bytesPerRow) * height);
+            box.data = &data[0];
+        }
+
+        void randomize(PixelFormatGpu format, uint32 seed)
+        {
+            for (uint32 y = 0; y < box.height; ++y)
+            {
+                uint8 *row = reinterpret_cast<uint8 *>(box.at(0, y, 0));
+                for (size_t i = 0; i < box.width * box.bytesPerPixel; ++i)
+                {
+                    // Deterministic LCG so that failures can be reproduced
+                    seed = seed * 1664525u + 1013904223u;
+                    row[i] = static_cast<uint8>(seed >> 24u);
+                }
+
+                if (format == PFG_RGBA32_FLOAT)
+                {
+                    // Mostly in [-0.5; 1.5] so that the interesting range is covered
+                    float *rowF32 = reinterpret_cast<float *>(row);
+                    for (size_t i = 0; i < box.width * 4u; ++i)
+                    {
+                        seed = seed * 1664525u + 1013904223u;
+                        rowF32[i] = float(seed >> 8u) / float(1u << 23u) - 0.5f;
+                    }
+                    rowF32[0] = -0.0f;
+                }
+                else if (format == PFG_RGBA16_FLOAT)
+                {
+                    // Remove NaNs, their payload isn't preserved the same way
+                    uint16 *rowF16 = reinterpret_cast<uint16 *>(row);
+                    for (size_t i = 0; i < box.width * 4u; ++i)
+                    {
+                        if ((rowF16[i] & 0x7C00) == 0x7C00)
+                            rowF16[i] &= 0xFC00;
+                    }
+                }
+            }
+        }
+    };
+
+    /// Per pixel conversion through float, the way the generic path does it
+    void referenceConversion(const TextureBox &src, PixelFormatGpu srcFormat, TextureBox &dst,
+                             PixelFormatGpu dstFormat, bool verticalFlip)
+    {
+        float rgba[4];
+        for (uint32 y = 0; y < src.height; ++y)
+        {
+            const uint32 dstY = verticalFlip ? src.height - 1u - y : y;
+            for (uint32 x = 0; x < src.width; ++x)
+            {
+                PixelFormatGpuUtils::unpackColour(rgba, srcFormat, src.at(x, y, 0));
+                for (size_t i = 0; i < 4u; ++i)
+                    rgba[i] = rgba[i] * 1.0f + 0.0f;
+                PixelFormatGpuUtils::packColour(rgba, dstFormat, dst.at(x, dstY, 0));
+            }
+        }
+    }
+
+    void testConversion(PixelFormatGpu srcFormat, PixelFormatGpu dstFormat, bool verticalFlip)
+    {
+        // Odd width exercises the scalar tails of the SIMD paths
+        TestImage src(srcFormat, 131u, 7u);
+        src.randomize(srcFormat, static_cast<uint32>(srcFormat * 256u + dstFormat));
+
+        TestImage expected(dstFormat, src.box.width, src.box.height);
+        TestImage result(dstFormat, src.box.width, src.box.height);
+
+        referenceConversion(src.box, srcFormat, expected.box, dstFormat, verticalFlip);
+        PixelFormatGpuUtils::bulkPixelConversion(src.box, srcFormat, result.box, dstFormat,
+                                                 verticalFlip);
+
+        CPPUNIT_ASSERT_MESSAGE(String("Mismatch converting ") +
+                                   PixelFormatGpuUtils::toString(srcFormat) + " to " +
+                                   PixelFormatGpuUtils::toString(dstFormat),
+                               expected.data == result.data);
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void PixelFormatGpuUtilsTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuUtilsTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuUtilsTests::testBulkConversionFastPaths()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numFormats = sizeof(c_fastFormats) / sizeof(c_fastFormats[0]);
+    for (size_t i = 0; i < numFormats; ++i)
+    {
+        for (size_t j = 0; j < numFormats; ++j)
+        {
+            if (i != j)
+                testConversion(c_fastFormats[i], c_fastFormats[j], false);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuUtilsTests::testBulkConversionVerticalFlip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    testConversion(PFG_RGBA8_UNORM, PFG_RGBA8_UNORM, true);
+    testConversion(PFG_RGBA16_FLOAT, PFG_RGBA8_UNORM_SRGB, true);
+    testConversion(PFG_RGB8_UNORM, PFG_RGBA8_UNORM, true);
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuUtilsTests::testBulkConversionBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Timings are informative only. The generic path is emulated by referenceConversion.
+    const PixelFormatGpu pairs[][2] = {
+        { PFG_RGB8_UNORM, PFG_RGBA8_UNORM },          { PFG_BGRA8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGBA8_UNORM_SRGB, PFG_RGBA8_UNORM },    { PFG_RGBA8_UNORM, PFG_RGBA32_FLOAT },
+        { PFG_RGBA16_FLOAT, PFG_RGBA8_UNORM },        { PFG_RGBA16_FLOAT, PFG_RGBA8_UNORM_SRGB },
+        { PFG_RGBA32_FLOAT, PFG_RGBA16_FLOAT },       { PFG_R10G10B10A2_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGBA32_FLOAT, PFG_R10G10B10A2_UNORM },
+    };
+    const uint32 width = 1024u;
+    const uint32 height = 1024u;
+
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i)
+    {
+        TestImage src(pairs[i][0], width, height);
+        src.randomize(pairs[i][0], 42u);
+        TestImage dst(pairs[i][1], width, height);
+
+        Timer timer;
+        referenceConversion(src.box, pairs[i][0], dst.box, pairs[i][1], false);
+        const double genericTime = double(timer.getMicroseconds());
+
+        timer.reset();
+        PixelFormatGpuUtils::bulkPixelConversion(src.box, pairs[i][0], dst.box, pairs[i][1]);
+        const double fastTime = double(timer.getMicroseconds());
+
+        const double megapixels = double(width * height) / 1000000.0;
+        LogManager::getSingleton().logMessage(
+            String("bulkPixelConversion ") + PixelFormatGpuUtils::toString(pairs[i][0]) + " -> " +
+            PixelFormatGpuUtils::toString(pairs[i][1]) + ": generic " +
+            StringConverter::toString(megapixels / (genericTime * 1e-6)) + " MPix/s, fast path " +
+            StringConverter::toString(megapixels / (std::max(fastTime, 1.0) * 1e-6)) + " MPix/s");
+    }
+}
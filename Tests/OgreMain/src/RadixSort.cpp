@@ -75,6 +75,20 @@ public:
     }
 };
 //--------------------------------------------------------------------------
+struct UInt64Entry
+{
+    uint64 key;
+    size_t originalIdx;
+};
+class UInt64SortFunctor
+{
+public:
+    uint64 operator()(const UInt64Entry& p) const
+    {
+        return p.key;
+    }
+};
+//--------------------------------------------------------------------------
 void RadixSortTests::testFloatVector()
 {
     UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
@@ -219,5 +233,34 @@ void RadixSortTests::testIntVector()
     }
 }
 //--------------------------------------------------------------------------
+//--------------------------------------------------------------------------
+void RadixSortTests::testUInt64VectorStable()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
 
+    std::vector<UInt64Entry> container;
+    UInt64SortFunctor func;
+    RadixSort<std::vector<UInt64Entry>, UInt64Entry, uint64> sorter;
 
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        // Use the upper bits (like RenderQueue hashes do) and leave some bytes
+        // constant so that passes get skipped. Few distinct values to test stability
+        UInt64Entry entry;
+        entry.key = ((uint64)(rand() % 7) << 56u) | ((uint64)(rand() % 5) << 24u) | 0x00AB0000u;
+        entry.originalIdx = i;
+        container.push_back(entry);
+    }
+
+    sorter.sort(container, func);
+
+    std::vector<UInt64Entry>::iterator v = container.begin();
+    UInt64Entry lastValue = *v++;
+    for (;v != container.end(); ++v)
+    {
+        CPPUNIT_ASSERT(v->key >= lastValue.key);
+        if (v->key == lastValue.key)
+            CPPUNIT_ASSERT(v->originalIdx > lastValue.originalIdx);
+        lastValue = *v;
+    }
+}
@@ -0,0 +1,216 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "RenderQueueSnapshotTests.h"
+#include "UnitTestSuite.h"
+
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreId.h"
+#include "OgreMovableObject.h"
+#include "OgreRenderQueue.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(RenderQueueSnapshotTests);
+
+namespace
+{
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        TestMovableObject(ObjectMemoryManager *objectMemoryManager, uint8 renderQueue) :
+            MovableObject(Id::generateNewId<MovableObject>(), objectMemoryManager, 0, renderQueue)
+        {
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    /// What SceneManager::updateAllBounds does for a single RQ
+    bool updateAllBounds(ObjectMemoryManager &memoryManager, uint8 renderQueue,
+                         bool incremental = true)
+    {
+        ObjectData objData;
+        const size_t numObjs = memoryManager.getFirstObjectData(objData, renderQueue);
+        return MovableObject::updateAllBounds(numObjs, objData, incremental);
+    }
+}
+
+//--------------------------------------------------------------------------
+void RenderQueueSnapshotTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void RenderQueueSnapshotTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void RenderQueueSnapshotTests::testSourceChangesBumpChangeCounter()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint8 rqA = 10u;
+    const uint8 rqB = 11u;
+    const uint8 rqUnrelated = 12u;
+
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *unrelated = OGRE_NEW TestMovableObject(&memoryManager, rqUnrelated);
+    const uint32 unrelatedCounter = memoryManager.getChangeCounter(rqUnrelated);
+
+    uint32 lastCounter = memoryManager.getChangeCounter(rqA);
+    TestMovableObject *object = OGRE_NEW TestMovableObject(&memoryManager, rqA);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqA) != lastCounter);
+
+    lastCounter = memoryManager.getChangeCounter(rqA);
+    object->setVisible(false);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqA) != lastCounter);
+
+    lastCounter = memoryManager.getChangeCounter(rqA);
+    object->setVisibilityFlags(0x01);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqA) != lastCounter);
+
+    lastCounter = memoryManager.getChangeCounter(rqA);
+    object->setRenderingDistance(100.0f);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqA) != lastCounter);
+
+    // Moving between queues affects both of them
+    lastCounter = memoryManager.getChangeCounter(rqA);
+    uint32 lastCounterB = memoryManager.getChangeCounter(rqB);
+    object->setRenderQueueGroup(rqB);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqA) != lastCounter);
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqB) != lastCounterB);
+
+    lastCounterB = memoryManager.getChangeCounter(rqB);
+    OGRE_DELETE object;
+    CPPUNIT_ASSERT(memoryManager.getChangeCounter(rqB) != lastCounterB);
+
+    CPPUNIT_ASSERT_EQUAL(unrelatedCounter, memoryManager.getChangeCounter(rqUnrelated));
+    OGRE_DELETE unrelated;
+}
+//--------------------------------------------------------------------------
+void RenderQueueSnapshotTests::testBoundsUpdateReportsChanges()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // SceneManager bumps the change counter of every RQ for which this returns true
+    const uint8 rq = 10u;
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *object = OGRE_NEW TestMovableObject(&memoryManager, rq);
+
+    // Creating the object already bumped the counter
+    updateAllBounds(memoryManager, rq);
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq));
+
+    object->setLocalAabb(Aabb(Vector3(0, 0, 0), Vector3(1, 1, 1)));
+    CPPUNIT_ASSERT(updateAllBounds(memoryManager, rq));
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq));
+
+    // Without incremental updates every block gets recalculated, but only
+    // the ones whose bounds end up being different are reported
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq, false));
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq, false));
+
+    object->setLocalAabb(Aabb(Vector3(0, 0, 0), Vector3(2, 2, 2)));
+    CPPUNIT_ASSERT(updateAllBounds(memoryManager, rq, false));
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq, false));
+
+    // Flagged as dirty, but ends up with the same bounds
+    object->setLocalAabb(Aabb(Vector3(0, 0, 0), Vector3(2, 2, 2)));
+    CPPUNIT_ASSERT(!updateAllBounds(memoryManager, rq));
+
+    OGRE_DELETE object;
+}
+//--------------------------------------------------------------------------
+void RenderQueueSnapshotTests::testModifiedSourceInvalidatesSnapshot()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint8 rq = 10u;
+    ObjectMemoryManager memoryManager;
+    TestMovableObject *object = OGRE_NEW TestMovableObject(&memoryManager, rq);
+
+    RenderQueueSnapshot::Key key;
+    key.viewMatrix = Matrix4::IDENTITY;
+    key.projectionMatrix = Matrix4::IDENTITY;
+    key.lodViewMatrix = Matrix4::IDENTITY;
+    key.changeKey = memoryManager.getChangeCounter(rq);
+    key.visibilityMask = 0xFFFFFFFF;
+    key.firstRq = rq;
+    key.lastRq = rq + 1u;
+
+    // Nothing recorded yet
+    RenderQueueSnapshot snapshot;
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    CPPUNIT_ASSERT(snapshot._isPendingRecord());
+    snapshot._notifyRecorded();
+    CPPUNIT_ASSERT(snapshot.isValid());
+
+    // Nothing changed
+    CPPUNIT_ASSERT(snapshot._prepareReplay(key));
+    CPPUNIT_ASSERT(!snapshot._isPendingRecord());
+
+    // Modifying an object in the cached RQ must invalidate it
+    object->setVisible(false);
+    key.changeKey = memoryManager.getChangeCounter(rq);
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    CPPUNIT_ASSERT(!snapshot.isValid());
+    CPPUNIT_ASSERT(snapshot._isPendingRecord());
+    snapshot._notifyRecorded();
+    CPPUNIT_ASSERT(snapshot._prepareReplay(key));
+
+    // Same with its bounds
+    object->setLocalAabb(Aabb(Vector3(0, 0, 0), Vector3(2, 2, 2)));
+    if (updateAllBounds(memoryManager, rq))
+        memoryManager._notifyObjectsChanged(rq);
+    key.changeKey = memoryManager.getChangeCounter(rq);
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    snapshot._notifyRecorded();
+
+    // Destroying it too
+    OGRE_DELETE object;
+    key.changeKey = memoryManager.getChangeCounter(rq);
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    snapshot._notifyRecorded();
+
+    // The camera moved
+    key.viewMatrix.makeTrans(Vector3(0, 0, 1));
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    snapshot._notifyRecorded();
+    CPPUNIT_ASSERT(snapshot._prepareReplay(key));
+
+    // Manual invalidation
+    snapshot.invalidate();
+    CPPUNIT_ASSERT(!snapshot._prepareReplay(key));
+    CPPUNIT_ASSERT(snapshot._isPendingRecord());
+}
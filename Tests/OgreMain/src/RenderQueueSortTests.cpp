@@ -0,0 +1,292 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "RenderQueueSortTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreLogManager.h"
+#include "OgrePlatformInformation.h"
+#include "OgreRenderQueue.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(RenderQueueSortTests);
+
+namespace Ogre
+{
+    /// Exposes the sorting internals of RenderQueue. Befriended by it
+    class RenderQueueSortTestAccess
+    {
+    public:
+        typedef RenderQueue::MergeHead MergeHead;
+        typedef RenderQueue::QueuedRenderableArray QueuedRenderableArray;
+        typedef RenderQueue::RenderQueueGroup RenderQueueGroup;
+        typedef RenderQueue::ThreadRenderQueue ThreadRenderQueue;
+        typedef RenderQueue::ThreadSortScratch ThreadSortScratch;
+
+        static void sortThreadQueue(ThreadRenderQueue &threadQueue, ThreadSortScratch &scratch,
+                                    bool reuseSortOrder)
+        {
+            RenderQueue::sortThreadQueue(threadQueue, scratch, reuseSortOrder);
+        }
+
+        static void mergeSortedThreadQueues(RenderQueueGroup &group,
+                                            FastArray<MergeHead> &mergeHeads)
+        {
+            RenderQueue::mergeSortedThreadQueues(group, mergeHeads);
+        }
+    };
+}
+
+namespace
+{
+    typedef RenderQueueSortTestAccess::RenderQueueGroup RenderQueueGroup;
+    typedef RenderQueueSortTestAccess::ThreadRenderQueue ThreadRenderQueue;
+    typedef RenderQueueSortTestAccess::ThreadSortScratch ThreadSortScratch;
+    typedef RenderQueueSortTestAccess::QueuedRenderableArray QueuedRenderableArray;
+    typedef FastArray<RenderQueueSortTestAccess::MergeHead> MergeHeadArray;
+
+    /// Resembles the hashes of a FAST RQ: few distinct values in the upper bits
+    /// (many ties), depth in the lower ones, and some bytes that never change
+    uint64 randomHash()
+    {
+        return ((uint64)(rand() % 64) << 58u) | ((uint64)(rand() % 512) << 40u) |
+               ((uint64)(rand() % 65536) << 16u);
+    }
+
+    /// The renderable pointer is only used to identify each entry, it is never dereferenced
+    void fillQueues(RenderQueueGroup &group, size_t numThreads, size_t numPerThread)
+    {
+        group.mQueuedRenderablesPerThread.resize(numThreads);
+        group.mQueuedRenderables.clear();
+        size_t id = 1u;
+        for (size_t i = 0; i < numThreads; ++i)
+        {
+            QueuedRenderableArray &q = group.mQueuedRenderablesPerThread[i].q;
+            q.clear();
+            for (size_t j = 0; j < numPerThread; ++j)
+                q.push_back(QueuedRenderable(randomHash(), reinterpret_cast<Renderable*>(id++), 0));
+        }
+    }
+
+    bool hashLess(const QueuedRenderable &a, const QueuedRenderable &b)
+    {
+        return a.hash < b.hash;
+    }
+
+    /// What RenderQueue did before sorting per thread: concatenate and sort on one thread
+    void concatenate(const RenderQueueGroup &group, std::vector<QueuedRenderable> &out)
+    {
+        out.clear();
+        for (size_t i = 0; i < group.mQueuedRenderablesPerThread.size(); ++i)
+        {
+            const QueuedRenderableArray &q = group.mQueuedRenderablesPerThread[i].q;
+            out.insert(out.end(), q.begin(), q.end());
+        }
+    }
+
+    void checkSameOrder(const std::vector<QueuedRenderable> &expected,
+                        const QueuedRenderableArray &actual)
+    {
+        CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            CPPUNIT_ASSERT_EQUAL(expected[i].hash, actual[i].hash);
+            CPPUNIT_ASSERT(expected[i].renderable == actual[i].renderable);
+        }
+    }
+
+    /// Sorts each per-thread queue from a different chunk, like RenderQueue::SortTask
+    class SortTask : public UniformScalableTask
+    {
+    public:
+        RenderQueueGroup *group;
+        std::vector<ThreadSortScratch> *scratch;
+
+        void execute(size_t threadId, size_t numThreads) override
+        {
+            RenderQueueSortTestAccess::sortThreadQueue(
+                group->mQueuedRenderablesPerThread[threadId], (*scratch)[threadId], false);
+        }
+    };
+}
+
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testMergeMatchesStableSort()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Includes empty and single-queue cases, which take shortcuts
+    const size_t numThreads[] = { 1u, 3u, 8u, 8u };
+    const size_t numPerThread[] = { 500u, 1000u, 1u, 0u };
+
+    std::vector<ThreadSortScratch> scratch(8u);
+    MergeHeadArray mergeHeads;
+    std::vector<QueuedRenderable> expected;
+
+    for (size_t i = 0; i < sizeof(numThreads) / sizeof(numThreads[0]); ++i)
+    {
+        RenderQueueGroup group;
+        fillQueues(group, numThreads[i], numPerThread[i]);
+
+        concatenate(group, expected);
+        std::stable_sort(expected.begin(), expected.end(), hashLess);
+
+        for (size_t j = 0; j < numThreads[i]; ++j)
+        {
+            RenderQueueSortTestAccess::sortThreadQueue(group.mQueuedRenderablesPerThread[j],
+                                                       scratch[j], false);
+        }
+        RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+
+        checkSameOrder(expected, group.mQueuedRenderables);
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testReuseSortOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ThreadSortScratch scratch;
+    RenderQueueGroup group;
+    fillQueues(group, 1u, 2000u);
+    ThreadRenderQueue &threadQueue = group.mQueuedRenderablesPerThread[0];
+
+    // Keep the unsorted input around, the next frames submit the same objects in the same order
+    const QueuedRenderableArray unsorted = threadQueue.q;
+    std::vector<QueuedRenderable> expected(unsorted.begin(), unsorted.end());
+    std::stable_sort(expected.begin(), expected.end(), hashLess);
+
+    RenderQueueSortTestAccess::sortThreadQueue(threadQueue, scratch, true);
+    MergeHeadArray mergeHeads;
+    RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+    checkSameOrder(expected, group.mQueuedRenderables);
+
+    // Same frame again: last order is already the right one
+    threadQueue.q = unsorted;
+    group.mQueuedRenderables.clear();
+    RenderQueueSortTestAccess::sortThreadQueue(threadQueue, scratch, true);
+    RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+    checkSameOrder(expected, group.mQueuedRenderables);
+
+    // A few objects moved: the insertion sort must fix it. Then everything changes
+    // and the budget runs out, falling back to the radix sort
+    const size_t numChanged[] = { 5u, unsorted.size() };
+    for (size_t i = 0; i < sizeof(numChanged) / sizeof(numChanged[0]); ++i)
+    {
+        threadQueue.q = unsorted;
+        for (size_t j = 0; j < numChanged[i]; ++j)
+            threadQueue.q[(size_t)rand() % threadQueue.q.size()].hash = randomHash();
+        expected.assign(threadQueue.q.begin(), threadQueue.q.end());
+        std::stable_sort(expected.begin(), expected.end(), hashLess);
+
+        group.mQueuedRenderables.clear();
+        RenderQueueSortTestAccess::sortThreadQueue(threadQueue, scratch, true);
+        RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+        checkSameOrder(expected, group.mQueuedRenderables);
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testSortBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Compares what RenderQueue used to do (concatenate all per-thread queues and std::sort
+    // them on the main thread) against radix sorting each queue in its own thread followed
+    // by the k-way merge. Timings are informative only.
+    const size_t numThreads = std::max<size_t>(PlatformInformation::getNumLogicalCores(), 2u);
+    const size_t numRenderables = 64u * 1024u;
+    const size_t numPerThread = numRenderables / numThreads;
+    const int numFrames = 30;
+
+    TaskScheduler scheduler(numThreads - 1u);
+    std::vector<ThreadSortScratch> scratch(numThreads);
+    MergeHeadArray mergeHeads;
+    std::vector<QueuedRenderable> concatenated;
+    std::vector<QueuedRenderable> expected;
+
+    RenderQueueGroup group;
+    SortTask sortTask;
+    sortTask.group = &group;
+    sortTask.scratch = &scratch;
+
+    double stdSortTime = 0.0, serialTime = 0.0, parallelTime = 0.0;
+    Timer timer;
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        fillQueues(group, numThreads, numPerThread);
+        const RenderQueueGroup unsorted = group;
+
+        concatenate(group, concatenated);
+        timer.reset();
+        std::sort(concatenated.begin(), concatenated.end(), hashLess);
+        stdSortTime += (double)timer.getMicroseconds();
+
+        concatenate(group, expected);
+        std::stable_sort(expected.begin(), expected.end(), hashLess);
+
+        // Per-thread radix sort + merge, all on this thread
+        timer.reset();
+        for (size_t i = 0; i < numThreads; ++i)
+            sortTask.execute(i, numThreads);
+        RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+        serialTime += (double)timer.getMicroseconds();
+        checkSameOrder(expected, group.mQueuedRenderables);
+
+        // Per-thread radix sort in parallel + merge
+        group = unsorted;
+        timer.reset();
+        scheduler.executeUniformScalableTask(&sortTask, numThreads);
+        RenderQueueSortTestAccess::mergeSortedThreadQueues(group, mergeHeads);
+        parallelTime += (double)timer.getMicroseconds();
+        checkSameOrder(expected, group.mQueuedRenderables);
+    }
+
+    LogManager::getSingleton().logMessage(
+        "RenderQueue sort: " + StringConverter::toString(numRenderables) + " renderables, " +
+        StringConverter::toString(numThreads) + " threads. Mean frame time: std::sort " +
+        StringConverter::toString(stdSortTime / numFrames) + " us, radix sort + merge " +
+        StringConverter::toString(serialTime / numFrames) + " us (single thread), " +
+        StringConverter::toString(parallelTime / numFrames) + " us (parallel)");
+}
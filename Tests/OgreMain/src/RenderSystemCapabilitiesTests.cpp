@@ -690,4 +690,51 @@ void RenderSystemCapabilitiesTests::testWriteAndReadComplexCapabilities()
     dataStreamPtr.reset();
 }
 //--------------------------------------------------------------------------
+void RenderSystemCapabilitiesTests::testWriteAndReadHlmsCapabilities()
+{
+    using namespace Ogre;
+    using namespace std;
+
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    String name = "hlms caps";
+    String filename = "hlmsCapsTest.rendercaps";
+
+    RenderSystemCapabilitiesSerializer serializer;
+    RenderSystemCapabilities caps;
+
+    const Capabilities setCaps[] = { RSC_TEXTURE_2D_ARRAY, RSC_TEXTURE_GATHER, RSC_HW_GAMMA,
+                                     RSC_UAV, RSC_SEPARATE_SAMPLERS_FROM_TEXTURES,
+                                     RSC_CONST_BUFFER_SLOTS_IN_SHADER, RSC_SHADER_FLOAT16 };
+    const Capabilities unsetCaps[] = { RSC_TEXTURE_CUBE_MAP_ARRAY, RSC_TYPED_UAV_LOADS,
+                                       RSC_EXPLICIT_API, RSC_SHADER_RELAXED_FLOAT };
+    const size_t numSetCaps = sizeof(setCaps) / sizeof(setCaps[0]);
+    const size_t numUnsetCaps = sizeof(unsetCaps) / sizeof(unsetCaps[0]);
+
+    for (size_t i = 0; i < numSetCaps; ++i)
+        caps.setCapability(setCaps[i]);
+    caps.addShaderProfile("glslvk");
+    caps.addShaderProfile("glsl");
+
+    serializer.writeScript(&caps, name, filename);
 
+    FileStreamDataStream* fdatastream = new FileStreamDataStream(filename,
+            OGRE_NEW_T(ifstream, MEMCATEGORY_GENERAL)(filename.c_str()));
+    DataStreamPtr dataStreamPtr(fdatastream);
+    serializer.parseScript(dataStreamPtr);
+
+    RenderSystemCapabilities* rsc = mRenderSystemCapabilitiesManager->loadParsedCapabilities(name);
+    CPPUNIT_ASSERT(rsc != 0);
+
+    for (size_t i = 0; i < numSetCaps; ++i)
+        CPPUNIT_ASSERT(rsc->hasCapability(setCaps[i]));
+    for (size_t i = 0; i < numUnsetCaps; ++i)
+        CPPUNIT_ASSERT(!rsc->hasCapability(unsetCaps[i]));
+
+    CPPUNIT_ASSERT(rsc->isShaderProfileSupported("glslvk"));
+    CPPUNIT_ASSERT(rsc->isShaderProfileSupported("glsl"));
+    CPPUNIT_ASSERT(!rsc->isShaderProfileSupported("hlsl"));
+
+    dataStreamPtr.reset();
+}
+//--------------------------------------------------------------------------
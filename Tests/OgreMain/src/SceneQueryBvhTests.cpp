@@ -0,0 +1,563 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "SceneQueryBvhTests.h"
+#include "UnitTestSuite.h"
+
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "Math/Array/OgreObjectMemoryManager.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreId.h"
+#include "OgreMovableObject.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreSceneQueryBvh.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SceneQueryBvhTests);
+
+namespace
+{
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        TestMovableObject(ObjectMemoryManager *objectMemoryManager, SceneManager *manager,
+                          uint8 renderQueue) :
+            MovableObject(Id::generateNewId<MovableObject>(), objectMemoryManager, manager,
+                          renderQueue)
+        {
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    struct Hit
+    {
+        MovableObject *object;
+        Real distance;
+
+        bool operator<(const Hit &other) const { return object < other.object; }
+    };
+    typedef std::vector<Hit> HitVec;
+
+    class CollectListener : public SceneQueryListener, public RaySceneQueryListener
+    {
+    public:
+        HitVec hits;
+
+        bool queryResult(MovableObject *object) override
+        {
+            return queryResult(object, 0);
+        }
+        bool queryResult(SceneQuery::WorldFragment *) override { return true; }
+        bool queryResult(MovableObject *object, Real distance) override
+        {
+            const Hit hit = { object, distance };
+            hits.push_back(hit);
+            return true;
+        }
+        bool queryResult(SceneQuery::WorldFragment *, Real) override { return true; }
+
+        bool contains(const MovableObject *object) const
+        {
+            for (size_t i = 0; i < hits.size(); ++i)
+            {
+                if (hits[i].object == object)
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    Vector3 randomVector(Real low, Real high)
+    {
+        return Vector3(Math::RangeRandom(low, high), Math::RangeRandom(low, high),
+                       Math::RangeRandom(low, high));
+    }
+
+    /// Objects and nodes without a SceneManager. Each object gets its own node
+    class TestScene
+    {
+    public:
+        NodeMemoryManager nodeMemoryManager;
+        ObjectMemoryManager objectMemoryManager;
+        std::vector<SceneNode*> nodes;
+        std::vector<TestMovableObject*> objects;
+
+        ~TestScene()
+        {
+            while (!objects.empty())
+                destroyObject(objects.size() - 1u);
+        }
+
+        TestMovableObject* createObject(uint8 renderQueue)
+        {
+            SceneNode *node =
+                OGRE_NEW SceneNode(Id::generateNewId<Node>(), 0, &nodeMemoryManager, 0);
+            node->setPosition(randomVector(-100, 100));
+            node->setScale(Vector3(Math::RangeRandom(0.5f, 2.0f)));
+
+            TestMovableObject *object =
+                OGRE_NEW TestMovableObject(&objectMemoryManager, 0, renderQueue);
+            object->setLocalAabb(Aabb(randomVector(-1, 1), randomVector(0.1f, 5.0f)));
+            node->attachObject(object);
+
+            nodes.push_back(node);
+            objects.push_back(object);
+            return object;
+        }
+
+        void destroyObject(size_t idx)
+        {
+            objects[idx]->detachFromParent();
+            OGRE_DELETE objects[idx];
+            OGRE_DELETE nodes[idx];
+            objects.erase(objects.begin() + (ptrdiff_t)idx);
+            nodes.erase(nodes.begin() + (ptrdiff_t)idx);
+        }
+
+        /// What SceneManager::updateSceneGraph does to the transforms and bounds
+        void update()
+        {
+            const size_t numDepths = nodeMemoryManager.getNumDepths();
+            for (size_t i = 0; i < numDepths; ++i)
+            {
+                Transform t;
+                const size_t numNodes = nodeMemoryManager.getFirstNode(t, i);
+                Node::updateAllTransforms(numNodes, t);
+            }
+
+            const size_t numRenderQueues = objectMemoryManager.getNumRenderQueues();
+            for (size_t i = 0; i < numRenderQueues; ++i)
+            {
+                ObjectData objData;
+                const size_t numObjs = objectMemoryManager.getFirstObjectData(objData, i);
+                MovableObject::updateAllBounds(numObjs, objData);
+            }
+        }
+    };
+
+    /// What SceneManager::updateSceneQueryBvh does
+    void updateBvh(SceneQueryBvh &bvh, bool boundsUpdated)
+    {
+        bvh._prepareForUpdate(boundsUpdated);
+        for (size_t i = 0; i < bvh._getNumTrees(); ++i)
+            bvh._updateTree(i);
+    }
+
+    Ray randomRay()
+    {
+        Vector3 dir = randomVector(-1, 1);
+        if (dir.isZeroLength())
+            dir = Vector3::UNIT_Z;
+        return Ray(randomVector(-150, 150), dir.normalisedCopy());
+    }
+
+    /// Both paths must report the same objects. The order is allowed to differ
+    void checkSameHits(HitVec linear, HitVec accelerated, bool compareDistances)
+    {
+        std::sort(linear.begin(), linear.end());
+        std::sort(accelerated.begin(), accelerated.end());
+
+        CPPUNIT_ASSERT_EQUAL(linear.size(), accelerated.size());
+        for (size_t i = 0; i < linear.size(); ++i)
+        {
+            CPPUNIT_ASSERT(linear[i].object == accelerated[i].object);
+            if (compareDistances)
+            {
+                CPPUNIT_ASSERT(Math::RealEqual(linear[i].distance, accelerated[i].distance,
+                                               1e-3f * std::max<Real>(1, linear[i].distance)));
+            }
+        }
+    }
+
+    /// Runs the query on every render queue with both paths. Returns the number of hits
+    size_t checkRayQuery(TestScene &scene, const SceneQueryBvh &bvh, const Ray &ray,
+                         uint32 queryMask)
+    {
+        DefaultRaySceneQuery query(0);
+        query.setRay(ray);
+        query.setQueryMask(queryMask);
+
+        size_t numHits = 0;
+        const size_t numRenderQueues = scene.objectMemoryManager.getNumRenderQueues();
+        for (size_t rq = 0; rq < numRenderQueues; ++rq)
+        {
+            CPPUNIT_ASSERT(bvh.isUpToDate(rq));
+            CollectListener linear, accelerated;
+            ObjectData objData;
+            const size_t numObjs = scene.objectMemoryManager.getFirstObjectData(objData, rq);
+            query.execute(objData, numObjs, &linear);
+            bvh.queryRay(rq, ray, queryMask, &accelerated);
+            checkSameHits(linear.hits, accelerated.hits, true);
+            numHits += linear.hits.size();
+        }
+        return numHits;
+    }
+
+    size_t checkSphereQuery(TestScene &scene, const SceneQueryBvh &bvh, const Sphere &sphere,
+                            uint32 queryMask)
+    {
+        DefaultSphereSceneQuery query(0);
+        query.setSphere(sphere);
+        query.setQueryMask(queryMask);
+
+        size_t numHits = 0;
+        const size_t numRenderQueues = scene.objectMemoryManager.getNumRenderQueues();
+        for (size_t rq = 0; rq < numRenderQueues; ++rq)
+        {
+            CPPUNIT_ASSERT(bvh.isUpToDate(rq));
+            CollectListener linear, accelerated;
+            ObjectData objData;
+            const size_t numObjs = scene.objectMemoryManager.getFirstObjectData(objData, rq);
+            query.execute(objData, numObjs, &linear);
+            bvh.querySphere(rq, sphere, queryMask, &accelerated);
+            checkSameHits(linear.hits, accelerated.hits, false);
+            numHits += linear.hits.size();
+        }
+        return numHits;
+    }
+
+    size_t checkAabbQuery(TestScene &scene, const SceneQueryBvh &bvh, const AxisAlignedBox &box,
+                          uint32 queryMask)
+    {
+        DefaultAxisAlignedBoxSceneQuery query(0);
+        query.setBox(box);
+        query.setQueryMask(queryMask);
+
+        const Aabb aabb = Aabb::newFromExtents(box.getMinimum(), box.getMaximum());
+
+        size_t numHits = 0;
+        const size_t numRenderQueues = scene.objectMemoryManager.getNumRenderQueues();
+        for (size_t rq = 0; rq < numRenderQueues; ++rq)
+        {
+            CPPUNIT_ASSERT(bvh.isUpToDate(rq));
+            CollectListener linear, accelerated;
+            ObjectData objData;
+            const size_t numObjs = scene.objectMemoryManager.getFirstObjectData(objData, rq);
+            query.execute(objData, numObjs, &linear);
+            bvh.queryAabb(rq, aabb, queryMask, &accelerated);
+            checkSameHits(linear.hits, accelerated.hits, false);
+            numHits += linear.hits.size();
+        }
+        return numHits;
+    }
+
+    /// Fires random rays, spheres and boxes. Returns the total number of hits
+    size_t checkRandomQueries(TestScene &scene, const SceneQueryBvh &bvh, uint32 queryMask)
+    {
+        size_t numHits = 0;
+        for (size_t i = 0; i < 100u; ++i)
+        {
+            numHits += checkRayQuery(scene, bvh, randomRay(), queryMask);
+
+            const Sphere sphere(randomVector(-120, 120), Math::RangeRandom(1, 40));
+            numHits += checkSphereQuery(scene, bvh, sphere, queryMask);
+
+            const Vector3 corner = randomVector(-120, 120);
+            const AxisAlignedBox box(corner, corner + randomVector(1, 60));
+            numHits += checkAabbQuery(scene, bvh, box, queryMask);
+        }
+        return numHits;
+    }
+}
+
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::testMatchesLinearQueries()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Render queues 1 and 2 are left empty on purpose
+    TestScene scene;
+    for (size_t i = 0; i < 1000u; ++i)
+        scene.createObject(i % 2u ? 0u : 3u);
+    scene.update();
+
+    SceneQueryBvh bvh(&scene.objectMemoryManager);
+    updateBvh(bvh, true);
+
+    CPPUNIT_ASSERT(!bvh.getNodes(0).empty());
+    CPPUNIT_ASSERT(bvh.getNodes(1).empty());
+    CPPUNIT_ASSERT(!bvh.getNodes(3).empty());
+
+    // Make sure the queries aren't trivially empty
+    CPPUNIT_ASSERT(checkRandomQueries(scene, bvh, 0xFFFFFFFF) > 100u);
+
+    // A ray starting inside an object reports a distance of 0
+    const Vector3 center = scene.objects[0]->getWorldAabb().mCenter;
+    CollectListener listener;
+    bvh.queryRay(scene.objects[0]->getRenderQueueGroup(), Ray(center, Vector3::UNIT_X),
+                 0xFFFFFFFF, &listener);
+    checkRayQuery(scene, bvh, Ray(center, Vector3::UNIT_X), 0xFFFFFFFF);
+    CPPUNIT_ASSERT(listener.contains(scene.objects[0]));
+    for (size_t i = 0; i < listener.hits.size(); ++i)
+    {
+        if (listener.hits[i].object == scene.objects[0])
+            CPPUNIT_ASSERT_EQUAL((Real)0, listener.hits[i].distance);
+    }
+}
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::testQueryAndVisibilityMasks()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TestScene scene;
+    for (size_t i = 0; i < 500u; ++i)
+    {
+        TestMovableObject *object = scene.createObject(0u);
+        object->setQueryFlags(1u << (i % 3u));
+        if (i % 7u == 0u)
+            object->setVisible(false);
+    }
+    scene.update();
+
+    SceneQueryBvh bvh(&scene.objectMemoryManager);
+    updateBvh(bvh, true);
+
+    const uint32 queryMasks[] = { 0xFFFFFFFF, 1u, 2u, 4u, 1u | 4u, 8u };
+    for (size_t i = 0; i < sizeof(queryMasks) / sizeof(queryMasks[0]); ++i)
+    {
+        const size_t numHits = checkRandomQueries(scene, bvh, queryMasks[i]);
+        CPPUNIT_ASSERT(queryMasks[i] == 8u ? numHits == 0u : numHits > 0u);
+    }
+
+    // A box enclosing everything only returns visible objects that pass the mask
+    const AxisAlignedBox everything(Vector3(-1000), Vector3(1000));
+    const Aabb everythingAabb = Aabb::newFromExtents(everything.getMinimum(),
+                                                     everything.getMaximum());
+    CollectListener listener;
+    bvh.queryAabb(0u, everythingAabb, 2u, &listener);
+    for (size_t i = 0; i < scene.objects.size(); ++i)
+    {
+        const bool expected = i % 7u != 0u && i % 3u == 1u;
+        CPPUNIT_ASSERT_EQUAL(expected, listener.contains(scene.objects[i]));
+    }
+
+    // Flags are read at query time: changing them doesn't need an update
+    for (size_t i = 0; i < scene.objects.size(); ++i)
+    {
+        scene.objects[i]->setVisible(i % 7u != 1u);
+        scene.objects[i]->setQueryFlags(1u << (i % 2u));
+    }
+    CPPUNIT_ASSERT(bvh.isUpToDate(0u));
+    checkRandomQueries(scene, bvh, 1u);
+    checkRandomQueries(scene, bvh, 2u);
+
+    listener.hits.clear();
+    bvh.queryAabb(0u, everythingAabb, 2u, &listener);
+    for (size_t i = 0; i < scene.objects.size(); ++i)
+    {
+        const bool expected = i % 7u != 1u && i % 2u == 1u;
+        CPPUNIT_ASSERT_EQUAL(expected, listener.contains(scene.objects[i]));
+    }
+}
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::testCreateDestroyAndMove()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TestScene scene;
+    for (size_t i = 0; i < 500u; ++i)
+        scene.createObject(0u);
+    scene.update();
+
+    SceneQueryBvh bvh(&scene.objectMemoryManager);
+    updateBvh(bvh, true);
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Small movements: the tree gets refitted
+    for (size_t i = 0; i < 50u; ++i)
+        scene.nodes[(size_t)rand() % scene.nodes.size()]->translate(randomVector(-5, 5));
+    scene.update();
+    updateBvh(bvh, true);
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Everything gets shuffled, which degrades the refitted tree enough to rebuild it
+    for (size_t i = 0; i < scene.nodes.size(); ++i)
+        scene.nodes[i]->setPosition(randomVector(-100, 100));
+    scene.update();
+    updateBvh(bvh, true);
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Destroy some objects and create more than that. The tree no longer
+    // matches the memory layout until it gets rebuilt
+    for (size_t i = 0; i < 100u; ++i)
+        scene.destroyObject((size_t)rand() % scene.objects.size());
+    for (size_t i = 0; i < 150u; ++i)
+        scene.createObject(0u);
+    CPPUNIT_ASSERT(!bvh.isUpToDate(0u));
+    scene.update();
+    updateBvh(bvh, true);
+    CPPUNIT_ASSERT(bvh.isUpToDate(0u));
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Same number of objects, but the slots now belong to different objects
+    for (size_t i = 0; i < 20u; ++i)
+    {
+        scene.destroyObject((size_t)rand() % (scene.objects.size() - 1u));
+        scene.createObject(0u);
+    }
+    scene.update();
+    updateBvh(bvh, true);
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Without any bounds update, only layout changes rebuild the tree
+    scene.createObject(0u);
+    scene.update();
+    updateBvh(bvh, false);
+    CPPUNIT_ASSERT(bvh.isUpToDate(0u));
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Moving objects to another render queue affects both trees
+    for (size_t i = 0; i < 30u; ++i)
+        scene.objects[i]->setRenderQueueGroup(5u);
+    scene.update();
+    updateBvh(bvh, true);
+    CPPUNIT_ASSERT(bvh.isUpToDate(0u));
+    CPPUNIT_ASSERT(bvh.isUpToDate(5u));
+    checkRandomQueries(scene, bvh, 0xFFFFFFFF);
+
+    // Everything gone
+    while (!scene.objects.empty())
+        scene.destroyObject(scene.objects.size() - 1u);
+    scene.update();
+    updateBvh(bvh, true);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, checkRandomQueries(scene, bvh, 0xFFFFFFFF));
+}
+//--------------------------------------------------------------------------
+void SceneQueryBvhTests::testStaleBvhFallsBackToLinear()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = OGRE_NEW Root(0, "plugins" OGRE_BUILD_SUFFIX ".cfg", "", "SceneQueryBvhTests.log");
+
+    RenderSystem *renderSystem = root->getRenderSystemByName("NULL Rendering Subsystem");
+    if (!renderSystem)
+    {
+        OGRE_DELETE root;
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    root->setRenderSystem(renderSystem);
+    root->initialise(false);
+    root->createRenderWindow("SceneQueryBvhTests", 320u, 240u, false, 0);
+
+    SceneManager *sceneManager = root->createSceneManager(ST_GENERIC, 1u);
+    sceneManager->setSceneQueryBvhEnabled(true);
+    const SceneQueryBvh *bvh = sceneManager->_getSceneQueryBvh(SCENE_DYNAMIC);
+    CPPUNIT_ASSERT(bvh);
+
+    // A row of objects along the X axis
+    const uint8 renderQueue = 10u;
+    const size_t numObjects = 64u;
+    std::vector<TestMovableObject*> objects;
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        TestMovableObject *object = OGRE_NEW TestMovableObject(
+            &sceneManager->_getEntityMemoryManager(SCENE_DYNAMIC), sceneManager, renderQueue);
+        object->setLocalAabb(Aabb(Vector3::ZERO, Vector3(1.0f)));
+        SceneNode *node = sceneManager->getRootSceneNode()->createChildSceneNode();
+        node->setPosition(Vector3((Real)i * 10.0f, 0, 0));
+        node->attachObject(object);
+        objects.push_back(object);
+    }
+
+    sceneManager->updateSceneGraph();
+    CPPUNIT_ASSERT(bvh->isUpToDate(renderQueue));
+
+    RaySceneQuery *rayQuery =
+        sceneManager->createRayQuery(Ray(Vector3(-100, 0, 0), Vector3::UNIT_X), 0xFFFFFFFF);
+    SphereSceneQuery *sphereQuery =
+        sceneManager->createSphereQuery(Sphere(Vector3(315, 0, 0), 1000.0f), 0xFFFFFFFF);
+    AxisAlignedBoxSceneQuery *aabbQuery = sceneManager->createAABBQuery(
+        AxisAlignedBox(Vector3(-1000), Vector3(1000)), 0xFFFFFFFF);
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        // Frame 0: up to date. Frame 1: the last object got destroyed and the BVH is
+        // stale, the queries must fall back to the linear search. Frame 2: rebuilt.
+        CollectListener rayListener, sphereListener, aabbListener;
+        rayQuery->execute(static_cast<RaySceneQueryListener*>(&rayListener));
+        sphereQuery->execute(static_cast<SceneQueryListener*>(&sphereListener));
+        aabbQuery->execute(static_cast<SceneQueryListener*>(&aabbListener));
+
+        CPPUNIT_ASSERT_EQUAL(objects.size(), rayListener.hits.size());
+        CPPUNIT_ASSERT_EQUAL(objects.size(), sphereListener.hits.size());
+        CPPUNIT_ASSERT_EQUAL(objects.size(), aabbListener.hits.size());
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            CPPUNIT_ASSERT(rayListener.contains(objects[i]));
+            CPPUNIT_ASSERT(sphereListener.contains(objects[i]));
+            CPPUNIT_ASSERT(aabbListener.contains(objects[i]));
+        }
+
+        if (frame == 0)
+        {
+            SceneNode *node = objects.back()->getParentSceneNode();
+            OGRE_DELETE objects.back();
+            objects.pop_back();
+            sceneManager->destroySceneNode(node);
+            CPPUNIT_ASSERT(!bvh->isUpToDate(renderQueue));
+        }
+        else if (frame == 1)
+        {
+            sceneManager->updateSceneGraph();
+            CPPUNIT_ASSERT(bvh->isUpToDate(renderQueue));
+        }
+    }
+
+    sceneManager->destroyQuery(rayQuery);
+    sceneManager->destroyQuery(sphereQuery);
+    sceneManager->destroyQuery(aabbQuery);
+
+    for (size_t i = 0; i < objects.size(); ++i)
+        OGRE_DELETE objects[i];
+    root->destroySceneManager(sceneManager);
+    OGRE_DELETE root;
+}
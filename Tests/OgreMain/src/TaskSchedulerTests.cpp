@@ -0,0 +1,609 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "TaskSchedulerTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreCamera.h"
+#include "OgreId.h"
+#include "OgreLogManager.h"
+#include "OgreMovableObject.h"
+#include "OgrePlatformInformation.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "OgreViewport.h"
+#include "Threading/OgreTaskScheduler.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TaskSchedulerTests);
+
+namespace
+{
+    /// Counts how many times each chunk ran
+    class CountingTask : public UniformScalableTask
+    {
+    public:
+        std::vector<std::atomic<uint32> > chunkCounters;
+        std::atomic<uint32> numExecuted;
+        std::atomic<uint32> badNumChunks;
+
+        CountingTask(size_t numChunks) :
+            chunkCounters(numChunks), numExecuted(0u), badNumChunks(0u)
+        {
+            for (size_t i = 0; i < numChunks; ++i)
+                chunkCounters[i] = 0u;
+        }
+
+        void execute(size_t threadId, size_t numThreads) override
+        {
+            if (numThreads != chunkCounters.size())
+                ++badNumChunks;
+            ++chunkCounters[threadId];
+            ++numExecuted;
+        }
+    };
+
+    /// Records when the first chunk of the task started and when the last one ended
+    class OrderedTask : public UniformScalableTask
+    {
+    public:
+        std::atomic<uint32> *clock;
+        /// Value of the clock seen by the first chunk to start
+        std::atomic<uint32> startTime;
+        std::atomic<uint32> numPending;
+        /// Value of the clock seen by the last chunk to end
+        std::atomic<uint32> endTime;
+
+        OrderedTask(std::atomic<uint32> *_clock, uint32 numChunks) :
+            clock(_clock), startTime(~0u), numPending(numChunks), endTime(0u)
+        {
+        }
+
+        void execute(size_t, size_t) override
+        {
+            uint32 expected = ~0u;
+            startTime.compare_exchange_strong(expected, clock->fetch_add(1u));
+            // Burn some time so chunks from unrelated tasks can interleave
+            volatile uint32 dummy = 0u;
+            for (uint32 i = 0u; i < 2000u; ++i)
+                dummy = dummy + i;
+            if (numPending.fetch_sub(1u) == 1u)
+                endTime = clock->fetch_add(1u);
+        }
+    };
+
+    /// Simulates an unevenly distributed workload (e.g. culling where most
+    /// visible objects happen to be in the same memory block)
+    class UnevenTask : public UniformScalableTask
+    {
+    public:
+        uint32 numUnits;
+        std::atomic<uint64> checksum;
+
+        UnevenTask(uint32 _numUnits) : numUnits(_numUnits), checksum(0u) {}
+
+        static uint32 costOf(uint32 unit)
+        {
+            // One in 8 units is 16x more expensive, and they're clustered together
+            return ((unit / 64u) % 8u) == 0u ? 1600u : 100u;
+        }
+
+        void execute(size_t threadId, size_t numThreads) override
+        {
+            const uint32 firstUnit = static_cast<uint32>((numUnits * threadId) / numThreads);
+            const uint32 lastUnit = static_cast<uint32>((numUnits * (threadId + 1u)) / numThreads);
+
+            uint64 localSum = 0u;
+            for (uint32 unit = firstUnit; unit < lastUnit; ++unit)
+            {
+                const uint32 cost = costOf(unit);
+                uint32 x = unit;
+                for (uint32 i = 0u; i < cost; ++i)
+                    x = x * 1664525u + 1013904223u;
+                localSum += x;
+            }
+            checksum += localSum;
+        }
+    };
+
+    class TestMovableObject : public MovableObject
+    {
+    public:
+        /// Position in the order of creation, which is the same in every SceneManager
+        size_t index;
+
+        TestMovableObject(size_t _index, SceneManager *manager, uint8 renderQueue) :
+            MovableObject(Id::generateNewId<MovableObject>(),
+                          &manager->_getEntityMemoryManager(SCENE_DYNAMIC), manager, renderQueue),
+            index(_index)
+        {
+            setLocalAabb(Aabb(Vector3::ZERO, Vector3(0.5f)));
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType("TestMovableObject");
+            return movableType;
+        }
+    };
+
+    /// Exposes the objects that passed frustum culling
+    class VisibleObjectsSceneManager final : public SceneManager
+    {
+    public:
+        static const String TYPE_NAME;
+
+        VisibleObjectsSceneManager(const String &name, size_t numWorkerThreads) :
+            SceneManager(name, numWorkerThreads)
+        {
+        }
+
+        const String &getTypeName() const override { return TYPE_NAME; }
+
+        /// The frustum culling done by _cullPhase01, which otherwise needs a render pass
+        void cullScene(const Camera *camera)
+        {
+            fireCullFrustumThreads(CullFrustumRequest(0u, 255u, false, true, false,
+                                                      &mEntitiesMemoryManagerCulledList, camera,
+                                                      camera));
+        }
+
+        /// Indices of the objects found visible by the last cullScene, in the
+        /// order they will be rendered (i.e. all the threads merged)
+        std::vector<size_t> getVisibleObjects(uint8 renderQueue) const
+        {
+            std::vector<size_t> retVal;
+            for (size_t i = 0; i < mVisibleObjects.size(); ++i)
+            {
+                const MovableObject::MovableObjectArray &visibleObjects =
+                    mVisibleObjects[i][renderQueue];
+                for (size_t j = 0; j < visibleObjects.size(); ++j)
+                    retVal.push_back(static_cast<TestMovableObject*>(visibleObjects[j])->index);
+            }
+            return retVal;
+        }
+    };
+    const String VisibleObjectsSceneManager::TYPE_NAME = "VisibleObjectsSceneManager";
+
+    class VisibleObjectsSceneManagerFactory final : public SceneManagerFactory
+    {
+    protected:
+        void initMetaData() const override
+        {
+            mMetaData.typeName = VisibleObjectsSceneManager::TYPE_NAME;
+            mMetaData.description = "Exposes the culling results";
+            mMetaData.sceneTypeMask = ST_GENERIC;
+            mMetaData.worldGeometrySupported = false;
+        }
+
+    public:
+        SceneManager *createInstance(const String &instanceName, size_t numWorkerThreads) override
+        {
+            return OGRE_NEW VisibleObjectsSceneManager(instanceName, numWorkerThreads);
+        }
+        void destroyInstance(SceneManager *instance) override { OGRE_DELETE instance; }
+    };
+
+    /// Returns a Root using the NULL RenderSystem, or null if it's not available
+    Root *createNullRoot()
+    {
+        Root *root =
+            OGRE_NEW Root(0, "plugins" OGRE_BUILD_SUFFIX ".cfg", "", "TaskSchedulerTests.log");
+
+        RenderSystem *renderSystem = root->getRenderSystemByName("NULL Rendering Subsystem");
+        if (!renderSystem)
+        {
+            OGRE_DELETE root;
+            return 0;
+        }
+
+        root->setRenderSystem(renderSystem);
+        root->initialise(false);
+        root->createRenderWindow("TaskSchedulerTests", 320u, 240u, false, 0);
+        return root;
+    }
+
+    /// A grid of spinning parents with a few children each. All nodes have an object;
+    /// the camera sees roughly half of them.
+    struct TestScene
+    {
+        static const uint8 RenderQueueId = 10u;
+        static const size_t NumChildren = 3u;
+
+        VisibleObjectsSceneManager *sceneManager;
+        Camera *camera;
+        std::vector<SceneNode*> parents;
+        std::vector<TestMovableObject*> objects;
+
+        TestScene(Root *root, size_t numWorkerThreads, size_t numParents, Viewport *viewport)
+        {
+            sceneManager = static_cast<VisibleObjectsSceneManager*>(root->createSceneManager(
+                VisibleObjectsSceneManager::TYPE_NAME, numWorkerThreads));
+            sceneManager->getRenderQueue()->setRenderQueueMode(RenderQueueId,
+                                                               RenderQueue::V1_LEGACY);
+
+            camera = sceneManager->createCamera("Camera");
+            camera->setNearClipDistance(0.5f);
+            camera->setFarClipDistance(1000.0f);
+            camera->setPosition(Vector3(0, 20, 40));
+            camera->lookAt(Vector3(0, 0, -60));
+            camera->_notifyViewport(viewport);
+
+            for (size_t i = 0; i < numParents; ++i)
+            {
+                SceneNode *parent = sceneManager->getRootSceneNode()->createChildSceneNode();
+                parent->setPosition(
+                    Vector3(Real(i % 64u) * 4.0f - 128.0f, 0, 20.0f - Real(i / 64u) * 4.0f));
+                parents.push_back(parent);
+                attachObject(parent);
+
+                for (size_t j = 0; j < NumChildren; ++j)
+                {
+                    SceneNode *child = parent->createChildSceneNode();
+                    child->setPosition(Vector3(Real(j) + 1.0f, Real(j), 0));
+                    child->setScale(Vector3(0.5f));
+                    attachObject(child);
+                }
+            }
+        }
+
+        void attachObject(SceneNode *node)
+        {
+            objects.push_back(OGRE_NEW TestMovableObject(objects.size(), sceneManager, RenderQueueId));
+            node->attachObject(objects.back());
+        }
+
+        void animate()
+        {
+            for (size_t i = 0; i < parents.size(); ++i)
+                parents[i]->yaw(Radian(0.05f * Real(i % 7u + 1u)));
+        }
+
+        /// Runs what a frame does on the CPU before rendering
+        void update()
+        {
+            sceneManager->updateSceneGraph();
+            sceneManager->cullScene(camera);
+        }
+
+        void destroy(Root *root)
+        {
+            for (size_t i = 0; i < objects.size(); ++i)
+                OGRE_DELETE objects[i];
+            root->destroySceneManager(sceneManager);
+        }
+    };
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testAllChunksExecuted()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler scheduler(4u);
+
+    // More chunks than threads, fewer chunks than threads, and no chunks at all
+    const size_t numChunks[] = { 257u, 3u, 1u, 0u };
+    for (size_t i = 0; i < sizeof(numChunks) / sizeof(numChunks[0]); ++i)
+    {
+        for (int frame = 0; frame < 10; ++frame)
+        {
+            CountingTask task(numChunks[i]);
+            const TaskScheduler::TaskId taskId = scheduler.addTask(&task, numChunks[i]);
+            scheduler.waitFor(taskId);
+
+            CPPUNIT_ASSERT(scheduler.isTaskFinished(taskId));
+            CPPUNIT_ASSERT_EQUAL((uint32)numChunks[i], task.numExecuted.load());
+            CPPUNIT_ASSERT_EQUAL((uint32)0u, task.badNumChunks.load());
+            for (size_t j = 0; j < numChunks[i]; ++j)
+                CPPUNIT_ASSERT_EQUAL((uint32)1u, task.chunkCounters[j].load());
+        }
+    }
+
+    // Overflow maxTasks: once everything is finished the tasks get recycled
+    TaskScheduler smallScheduler(2u, 4u);
+    CountingTask task(8u);
+    for (int i = 0; i < 100; ++i)
+        smallScheduler.waitFor(smallScheduler.addTask(&task, 8u));
+    smallScheduler.waitForAll();
+    CPPUNIT_ASSERT_EQUAL((uint32)800u, task.numExecuted.load());
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testDependencies()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler scheduler(4u);
+
+    for (int frame = 0; frame < 50; ++frame)
+    {
+        // Diamond: transforms -> (bounds, animations) -> culling
+        std::atomic<uint32> clock(0u);
+        OrderedTask transforms(&clock, 16u);
+        OrderedTask bounds(&clock, 16u);
+        OrderedTask animations(&clock, 5u);
+        OrderedTask culling(&clock, 16u);
+        OrderedTask unrelated(&clock, 16u);
+
+        const TaskScheduler::TaskId transformsId = scheduler.addTask(&transforms, 16u);
+        const TaskScheduler::TaskId boundsId = scheduler.addTask(&bounds, 16u, &transformsId, 1u);
+        const TaskScheduler::TaskId animationsId =
+            scheduler.addTask(&animations, 5u, &transformsId, 1u);
+        const TaskScheduler::TaskId cullingDeps[2] = { boundsId, animationsId };
+        const TaskScheduler::TaskId cullingId = scheduler.addTask(&culling, 16u, cullingDeps, 2u);
+        scheduler.addTask(&unrelated, 16u);
+
+        scheduler.waitFor(cullingId);
+        CPPUNIT_ASSERT(scheduler.isTaskFinished(transformsId));
+        CPPUNIT_ASSERT(scheduler.isTaskFinished(boundsId));
+        CPPUNIT_ASSERT(scheduler.isTaskFinished(animationsId));
+        scheduler.waitForAll();
+
+        CPPUNIT_ASSERT(transforms.endTime < bounds.startTime);
+        CPPUNIT_ASSERT(transforms.endTime < animations.startTime);
+        CPPUNIT_ASSERT(bounds.endTime < culling.startTime);
+        CPPUNIT_ASSERT(animations.endTime < culling.startTime);
+        CPPUNIT_ASSERT_EQUAL((uint32)0u, unrelated.numPending.load());
+    }
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testNoWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Everything runs on the calling thread while waiting
+    TaskScheduler scheduler(0u);
+    CountingTask taskA(7u);
+    CountingTask taskB(9u);
+    const TaskScheduler::TaskId taskAId = scheduler.addTask(&taskA, 7u);
+    const TaskScheduler::TaskId taskBId = scheduler.addTask(&taskB, 9u, &taskAId, 1u);
+    CPPUNIT_ASSERT(!scheduler.isTaskFinished(taskBId));
+    scheduler.waitFor(taskBId);
+    CPPUNIT_ASSERT_EQUAL((uint32)7u, taskA.numExecuted.load());
+    CPPUNIT_ASSERT_EQUAL((uint32)9u, taskB.numExecuted.load());
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, scheduler.getNumStolenChunks());
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testRecycleRightAfterWaitFor()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Single chunk tasks finish on a worker thread while we wait. As soon as waitFor
+    // returns, every task must be counted as finished, otherwise addTask would refuse to
+    // recycle them and throw "Too many tasks in flight".
+    TaskScheduler scheduler(4u, 2u);
+    CountingTask task(1u);
+    for (int i = 0; i < 20000; ++i)
+    {
+        const TaskScheduler::TaskId taskId = scheduler.addTask(&task, 1u);
+        scheduler.waitFor(taskId);
+        CPPUNIT_ASSERT(scheduler.canAddTask());
+    }
+    CPPUNIT_ASSERT_EQUAL((uint32)20000u, task.numExecuted.load());
+
+    // Full and still running: can't recycle yet
+    CountingTask pending(1u);
+    TaskScheduler noWorkers(0u, 1u);
+    noWorkers.addTask(&pending, 1u);
+    CPPUNIT_ASSERT(!noWorkers.canAddTask());
+    noWorkers.waitForAll();
+    CPPUNIT_ASSERT(noWorkers.canAddTask());
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testUnevenWorkloadBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Compares one chunk per thread (what SceneManager's barrier-based worker threads do)
+    // against splitting the same work in many small chunks that can be stolen.
+    // Timings are informative only; differences are most noticeable with 16+ cores.
+    const size_t numThreads = std::max<size_t>(PlatformInformation::getNumLogicalCores(), 2u);
+    const uint32 numUnits = 16u * 1024u;
+    const int numFrames = 60;
+
+    TaskScheduler scheduler(numThreads - 1u);
+
+    uint64 referenceChecksum = 0u;
+    const size_t chunksPerThread[] = { 1u, 16u };
+    for (size_t i = 0; i < sizeof(chunksPerThread) / sizeof(chunksPerThread[0]); ++i)
+    {
+        const size_t numChunks = numThreads * chunksPerThread[i];
+        const uint32 stolenBefore = scheduler.getNumStolenChunks();
+
+        double sum = 0.0, sumSq = 0.0;
+        Timer timer;
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            UnevenTask task(numUnits);
+            timer.reset();
+            scheduler.waitFor(scheduler.addTask(&task, numChunks));
+            const double frameTime = (double)timer.getMicroseconds();
+            sum += frameTime;
+            sumSq += frameTime * frameTime;
+
+            if (!referenceChecksum)
+                referenceChecksum = task.checksum;
+            CPPUNIT_ASSERT_EQUAL(referenceChecksum, (uint64)task.checksum);
+        }
+
+        const double mean = sum / numFrames;
+        const double stdDev = std::sqrt(std::max(sumSq / numFrames - mean * mean, 0.0));
+        LogManager::getSingleton().logMessage(
+            "TaskScheduler: " + StringConverter::toString(numThreads) + " threads, " +
+            StringConverter::toString(numChunks) + " chunks. Frame time mean " +
+            StringConverter::toString(mean) + " us, std dev " + StringConverter::toString(stdDev) +
+            " us. Stolen chunks: " +
+            StringConverter::toString(scheduler.getNumStolenChunks() - stolenBefore));
+    }
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testChunkedSceneUpdateMatchesWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = createNullRoot();
+    if (!root)
+    {
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    VisibleObjectsSceneManagerFactory factory;
+    root->addSceneManagerFactory(&factory);
+    Viewport viewport(0, 0, 1, 1);
+    viewport._setVisibilityMask(VisibilityFlags::RESERVED_VISIBILITY_FLAGS,
+                                VisibilityFlags::RESERVED_VISIBILITY_FLAGS);
+
+    // Same scene updated by SceneManager's worker threads and by chained, chunked tasks
+    const size_t numWorkerThreads = 4u;
+    TaskScheduler scheduler(numWorkerThreads - 1u);
+    TestScene threaded(root, numWorkerThreads, 500u, &viewport);
+    TestScene chunked(root, numWorkerThreads, 500u, &viewport);
+    chunked.sceneManager->setTaskScheduler(&scheduler);
+    // Small chunks so every phase gets split in plenty of them
+    chunked.sceneManager->setTaskChunkSize(16u);
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        threaded.animate();
+        chunked.animate();
+        threaded.update();
+        chunked.update();
+
+        for (size_t i = 0; i < threaded.objects.size(); ++i)
+        {
+            const Aabb expected = threaded.objects[i]->getWorldAabb();
+            const Aabb aabb = chunked.objects[i]->getWorldAabb();
+            CPPUNIT_ASSERT(expected.mCenter == aabb.mCenter);
+            CPPUNIT_ASSERT(expected.mHalfSize == aabb.mHalfSize);
+        }
+
+        // Culled in chunks, yet the RenderQueue must get them in the same order
+        const std::vector<size_t> expected =
+            threaded.sceneManager->getVisibleObjects(TestScene::RenderQueueId);
+        CPPUNIT_ASSERT(!expected.empty());
+        CPPUNIT_ASSERT(expected.size() < threaded.objects.size());
+        CPPUNIT_ASSERT(expected == chunked.sceneManager->getVisibleObjects(TestScene::RenderQueueId));
+    }
+
+    chunked.sceneManager->setTaskScheduler(0);
+    threaded.destroy(root);
+    chunked.destroy(root);
+    root->removeSceneManagerFactory(&factory);
+    OGRE_DELETE root;
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testSceneUpdateScalingBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    Root *root = createNullRoot();
+    if (!root)
+    {
+        CPPUNIT_ASSERT_ASSERTION_PASS(
+            "This test is irrelevant because NULL RenderSystem is not available");
+        return;
+    }
+
+    VisibleObjectsSceneManagerFactory factory;
+    root->addSceneManagerFactory(&factory);
+    Viewport viewport(0, 0, 1, 1);
+    viewport._setVisibilityMask(VisibilityFlags::RESERVED_VISIBILITY_FLAGS,
+                                VisibilityFlags::RESERVED_VISIBILITY_FLAGS);
+
+    // Scene graph update + culling with SceneManager's worker threads (one chunk per thread,
+    // separated by barriers) vs chained fine-grained tasks. Always goes up to at least 16
+    // threads; timings are informative only and need as many cores to be meaningful.
+    const size_t maxThreads = std::max<size_t>(PlatformInformation::getNumLogicalCores(), 16u);
+    std::vector<size_t> threadCounts;
+    for (size_t numThreads = 1u; numThreads < maxThreads; numThreads *= 2u)
+        threadCounts.push_back(numThreads);
+    threadCounts.push_back(maxThreads);
+
+    const size_t numParents = 4096u;
+    const int numFrames = 30;
+
+    for (size_t i = 0; i < threadCounts.size(); ++i)
+    {
+        const size_t numThreads = threadCounts[i];
+        TaskScheduler scheduler(numThreads - 1u);
+        TestScene scene(root, numThreads, numParents, &viewport);
+
+        for (int useScheduler = 0; useScheduler < 2; ++useScheduler)
+        {
+            scene.sceneManager->setTaskScheduler(useScheduler ? &scheduler : 0);
+            scene.update();
+
+            double sum = 0.0, sumSq = 0.0;
+            Timer timer;
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                scene.animate();
+                timer.reset();
+                scene.update();
+                const double frameTime = (double)timer.getMicroseconds();
+                sum += frameTime;
+                sumSq += frameTime * frameTime;
+            }
+
+            const double mean = sum / numFrames;
+            const double stdDev = std::sqrt(std::max(sumSq / numFrames - mean * mean, 0.0));
+            LogManager::getSingleton().logMessage(
+                "SceneManager update + cull: " + StringConverter::toString(scene.objects.size()) +
+                " objects, " + StringConverter::toString(numThreads) + " threads, " +
+                (useScheduler ? "chained chunked tasks" : "worker threads") +
+                ". Frame time mean " + StringConverter::toString(mean) + " us, std dev " +
+                StringConverter::toString(stdDev) + " us");
+        }
+
+        scene.sceneManager->setTaskScheduler(0);
+        scene.destroy(root);
+    }
+
+    root->removeSceneManagerFactory(&factory);
+    OGRE_DELETE root;
+}
@@ -0,0 +1,273 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "TextureAutoPackingTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+#include "OgreTextureGpuManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TextureAutoPackingTests);
+
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::testPackingIsOptIn()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint32 width, height;
+
+    // Without TextureFlags::AllowAutoPacking textures keep their own resolution
+    TextureGpuManager::_getPoolResolutionFor(20u, 30u, 1u, false, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(20u, width);
+    CPPUNIT_ASSERT_EQUAL(30u, height);
+
+    TextureGpuManager::_getPoolResolutionFor(20u, 30u, 1u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(32u, width);
+    CPPUNIT_ASSERT_EQUAL(32u, height);
+
+    TextureGpuManager::_getPoolResolutionFor(48u, 24u, 1u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(64u, width);
+    CPPUNIT_ASSERT_EQUAL(32u, height);
+
+    // Above the threshold, or disabled
+    TextureGpuManager::_getPoolResolutionFor(20u, 100u, 1u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(20u, width);
+    CPPUNIT_ASSERT_EQUAL(100u, height);
+
+    TextureGpuManager::_getPoolResolutionFor(20u, 30u, 1u, true, 0u, width, height);
+    CPPUNIT_ASSERT_EQUAL(20u, width);
+    CPPUNIT_ASSERT_EQUAL(30u, height);
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::testPoolMipmapsMatchTexture()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // A 32x32 pool with 5 mips and a 24x24 texture with 4.
+    // The pool's last mip would never be written.
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPoolCompatible(32u, 32u, 5u, 24u, 24u, 4u, true, 64u));
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(32u, 32u, 4u, 24u, 24u, 4u, true, 64u));
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(32u, 32u, 1u, 24u, 24u, 1u, true, 64u));
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPoolCompatible(32u, 32u, 1u, 24u, 24u, 4u, true, 64u));
+
+    // The pool created for a texture can always hold all of its mips
+    for (uint32 height = 1u; height <= 64u; ++height)
+    {
+        for (uint32 width = 1u; width <= 64u; ++width)
+        {
+            const uint8 numMipmaps = PixelFormatGpuUtils::getMaxMipmapCount(width, height);
+            uint32 poolWidth, poolHeight;
+            TextureGpuManager::_getPoolResolutionFor(width, height, numMipmaps, true, 64u,
+                                                     poolWidth, poolHeight);
+            CPPUNIT_ASSERT(numMipmaps <=
+                           PixelFormatGpuUtils::getMaxMipmapCount(poolWidth, poolHeight));
+            CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(
+                poolWidth, poolHeight, numMipmaps, width, height, numMipmaps, true, 64u));
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::testReservedPools()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Pools from reservePoolId of the texture's own resolution are still used when packing
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(20u, 30u, 1u, 20u, 30u, 1u, true, 64u));
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(32u, 32u, 1u, 20u, 30u, 1u, true, 64u));
+
+    // Textures that didn't opt in only go to pools of their exact resolution
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(20u, 30u, 1u, 20u, 30u, 1u, false, 64u));
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPoolCompatible(32u, 32u, 1u, 20u, 30u, 1u, false, 64u));
+
+    // Packing never goes beyond the next power of 2
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPoolCompatible(64u, 64u, 1u, 20u, 30u, 1u, true, 64u));
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::testMipsNeedProportionalSizes()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint32 width, height;
+
+    // 24x12 with 3 mips: 24x12, 12x6, 6x3 always cover 3/4 x 3/4 of the 32x16 pool
+    TextureGpuManager::_getPoolResolutionFor(24u, 12u, 3u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(32u, width);
+    CPPUNIT_ASSERT_EQUAL(16u, height);
+
+    // 24x12 with 4 mips: the last one would be 3x1 in a 4x2 pool mip
+    TextureGpuManager::_getPoolResolutionFor(24u, 12u, 4u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(24u, width);
+    CPPUNIT_ASSERT_EQUAL(12u, height);
+
+    // Full mip chain of a NPOT texture
+    TextureGpuManager::_getPoolResolutionFor(20u, 30u, 5u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(20u, width);
+    CPPUNIT_ASSERT_EQUAL(30u, height);
+
+    // Power of 2 textures are never moved into bigger pools
+    TextureGpuManager::_getPoolResolutionFor(32u, 16u, 6u, true, 64u, width, height);
+    CPPUNIT_ASSERT_EQUAL(32u, width);
+    CPPUNIT_ASSERT_EQUAL(16u, height);
+
+    CPPUNIT_ASSERT(TextureGpuManager::_isPoolCompatible(32u, 16u, 3u, 24u, 12u, 3u, true, 64u));
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPoolCompatible(32u, 16u, 4u, 24u, 12u, 4u, true, 64u));
+}
+//--------------------------------------------------------------------------
+namespace
+{
+    struct Mip
+    {
+        uint32 width;
+        uint32 height;
+        std::vector<uint8> data;
+
+        Mip(uint32 _width, uint32 _height, uint8 value) :
+            width(_width), height(_height), data(_width * _height, value)
+        {
+        }
+
+        TextureBox getBox()
+        {
+            TextureBox box(width, height, 1u, 1u, 1u, width, width * height);
+            box.data = &data[0];
+            return box;
+        }
+
+        uint8 at(int32 x, int32 y) const
+        {
+            // TAM_CLAMP
+            x = std::min(std::max(x, 0), int32(width) - 1);
+            y = std::min(std::max(y, 0), int32(height) - 1);
+            return data[size_t(y) * width + size_t(x)];
+        }
+
+        /// Bilinear filtering, the way GPUs do it
+        float sample(float u, float v) const
+        {
+            const float x = u * float(width) - 0.5f;
+            const float y = v * float(height) - 0.5f;
+            const float x0 = std::floor(x);
+            const float y0 = std::floor(y);
+            const float fx = x - x0;
+            const float fy = y - y0;
+            const int32 ix = int32(x0);
+            const int32 iy = int32(y0);
+
+            return (at(ix, iy) * (1.0f - fx) + at(ix + 1, iy) * fx) * (1.0f - fy) +
+                   (at(ix, iy + 1) * (1.0f - fx) + at(ix + 1, iy + 1) * fx) * fy;
+        }
+    };
+
+    /// Samples every mip of the texture through the pool's slice, and compares
+    /// against sampling the texture on its own. Returns the number of mismatches.
+    size_t countSamplingMismatches(uint32 texWidth, uint32 texHeight, uint8 numMipmaps, bool pad)
+    {
+        uint32 poolWidth, poolHeight;
+        TextureGpuManager::_getPoolResolutionFor(texWidth, texHeight, numMipmaps, true, 64u,
+                                                 poolWidth, poolHeight);
+        CPPUNIT_ASSERT(poolWidth != texWidth || poolHeight != texHeight);
+
+        // Same as TextureGpu::getInternalUvScale & getInternalUvOffset
+        const float scaleU = float(texWidth - 1u) / float(poolWidth);
+        const float scaleV = float(texHeight - 1u) / float(poolHeight);
+        const float offsetU = 0.5f / float(poolWidth);
+        const float offsetV = 0.5f / float(poolHeight);
+
+        size_t numMismatches = 0u;
+        uint32 seed = 12345u;
+
+        for (uint8 i = 0u; i < numMipmaps; ++i)
+        {
+            Mip texMip(std::max(1u, texWidth >> i), std::max(1u, texHeight >> i), 0u);
+            for (size_t j = 0u; j < texMip.data.size(); ++j)
+            {
+                seed = seed * 1103515245u + 12345u;
+                texMip.data[j] = uint8((seed >> 16u) & 0x7Fu);
+            }
+
+            // The rest of the pool's slice starts with garbage (e.g. from a previous texture)
+            Mip poolMip(std::max(1u, poolWidth >> i), std::max(1u, poolHeight >> i), 255u);
+            TextureBox usedBox = poolMip.getBox();
+            usedBox.width = texMip.width;
+            usedBox.height = texMip.height;
+            usedBox.copyFrom(texMip.getBox());
+            if (pad)
+                TextureGpuManager::_padPackedTexture(poolMip.getBox(), texMip.width, texMip.height);
+
+            for (uint32 y = 0u; y <= 16u; ++y)
+            {
+                for (uint32 x = 0u; x <= 16u; ++x)
+                {
+                    const float u = float(x) / 16.0f;
+                    const float v = float(y) / 16.0f;
+
+                    // UV 0 and 1 map to the centres of the first and last texels of mip 0
+                    const float texU = (u * float(texWidth - 1u) + 0.5f) / float(texWidth);
+                    const float texV = (v * float(texHeight - 1u) + 0.5f) / float(texHeight);
+
+                    const float expected = texMip.sample(texU, texV);
+                    const float packed = poolMip.sample(u * scaleU + offsetU, v * scaleV + offsetV);
+                    if (std::abs(expected - packed) > 1e-3f)
+                        ++numMismatches;
+                }
+            }
+        }
+
+        return numMismatches;
+    }
+}
+//--------------------------------------------------------------------------
+void TextureAutoPackingTests::testEdgeAndMipSampling()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, countSamplingMismatches(20u, 30u, 1u, true));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, countSamplingMismatches(24u, 12u, 3u, true));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, countSamplingMismatches(40u, 8u, 4u, true));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, countSamplingMismatches(3u, 5u, 1u, true));
+
+    // Without padding the lower mips filter in the garbage next to the texture
+    CPPUNIT_ASSERT(countSamplingMismatches(24u, 12u, 3u, false) > 0u);
+}
@@ -0,0 +1,212 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "TextureMetadataCacheTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreLogManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreTimer.h"
+
+#include <cstdio>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TextureMetadataCacheTests);
+
+namespace
+{
+    /// Enough of a TextureGpuManager to exercise the metadata cache (no textures are created)
+    class NullTextureGpuManager : public TextureGpuManager
+    {
+    protected:
+        TextureGpu *createTextureImpl(GpuPageOutStrategy::GpuPageOutStrategy, IdString, uint32,
+                                      TextureTypes::TextureTypes) override
+        {
+            return 0;
+        }
+        StagingTexture *createStagingTextureImpl(uint32, uint32, uint32, uint32,
+                                                 PixelFormatGpu) override
+        {
+            return 0;
+        }
+        void destroyStagingTextureImpl(StagingTexture *) override {}
+        AsyncTextureTicket *createAsyncTextureTicketImpl(uint32, uint32, uint32,
+                                                         TextureTypes::TextureTypes,
+                                                         PixelFormatGpu) override
+        {
+            return 0;
+        }
+
+    public:
+        NullTextureGpuManager() : TextureGpuManager(0, 0) {}
+        ~NullTextureGpuManager() override { destroyAll(); }
+
+        void addTestEntries(size_t numTextures)
+        {
+            const PixelFormatGpu formats[] = { PFG_RGBA8_UNORM_SRGB, PFG_BC1_UNORM, PFG_BC5_SNORM,
+                                               PFG_R8_UNORM };
+            for (size_t i = 0; i < numTextures; ++i)
+            {
+                MetadataCacheEntry entry;
+                entry.aliasName = "Textures/Material" + StringConverter::toString(i) + "_diffuse.png";
+                entry.width = 64u << (i % 6u);
+                entry.height = entry.width;
+                entry.depthOrSlices = 1u;
+                entry.pixelFormat = formats[i % 4u];
+                entry.poolId = static_cast<uint32>(i % 3u);
+                entry.textureType = TextureTypes::Type2D;
+                entry.numMipmaps = static_cast<uint8>(i % 6u + 7u);
+                mMetadataCache[entry.aliasName] = entry;
+            }
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void TextureMetadataCacheTests::setUp()
+{
+}
+//--------------------------------------------------------------------------
+void TextureMetadataCacheTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TextureMetadataCacheTests::testBinaryRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    String expectedJson;
+    vector<uint8>::type binary;
+    {
+        NullTextureGpuManager textureManager;
+        textureManager.addTestEntries(100u);
+        textureManager.exportTextureMetadataCache(expectedJson);
+        textureManager.exportTextureMetadataCacheBinary(binary);
+    }
+
+    // From memory
+    {
+        NullTextureGpuManager textureManager;
+        CPPUNIT_ASSERT(
+            textureManager.importTextureMetadataCacheBinary(&binary[0], binary.size(), false));
+        String outJson;
+        textureManager.exportTextureMetadataCache(outJson);
+        CPPUNIT_ASSERT(expectedJson == outJson);
+    }
+
+    // From a memory mapped file written on shutdown
+    const String filename = "./a_test_metadata_cache.bin";
+    std::remove(filename.c_str());
+    {
+        NullTextureGpuManager textureManager;
+        textureManager.setTextureMetadataCacheFile(filename, false);
+        textureManager.addTestEntries(100u);
+    }
+    {
+        NullTextureGpuManager textureManager;
+        CPPUNIT_ASSERT(textureManager.loadTextureMetadataCacheBinary(filename, false));
+        String outJson;
+        textureManager.exportTextureMetadataCache(outJson);
+        CPPUNIT_ASSERT(expectedJson == outJson);
+    }
+    std::remove(filename.c_str());
+}
+//--------------------------------------------------------------------------
+void TextureMetadataCacheTests::testInvalidBinaryData()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    vector<uint8>::type binary;
+    {
+        NullTextureGpuManager textureManager;
+        textureManager.addTestEntries(10u);
+        textureManager.exportTextureMetadataCacheBinary(binary);
+    }
+
+    NullTextureGpuManager textureManager;
+
+    // Truncated (alias names and records)
+    CPPUNIT_ASSERT(
+        !textureManager.importTextureMetadataCacheBinary(&binary[0], binary.size() - 1u, false));
+    CPPUNIT_ASSERT(!textureManager.importTextureMetadataCacheBinary(&binary[0], 20u, false));
+    CPPUNIT_ASSERT(!textureManager.importTextureMetadataCacheBinary(&binary[0], 0u, false));
+
+    // Wrong version
+    binary[4] ^= 0xFF;
+    CPPUNIT_ASSERT(
+        !textureManager.importTextureMetadataCacheBinary(&binary[0], binary.size(), false));
+
+    // Nothing got imported
+    String outJson;
+    textureManager.exportTextureMetadataCache(outJson);
+    CPPUNIT_ASSERT(outJson.find("Material") == String::npos);
+}
+//--------------------------------------------------------------------------
+void TextureMetadataCacheTests::testStartupBenchmark()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numTextures = 20000u;
+
+    String json;
+    vector<uint8>::type binary;
+    {
+        NullTextureGpuManager textureManager;
+        textureManager.addTestEntries(numTextures);
+        textureManager.exportTextureMetadataCache(json);
+        textureManager.exportTextureMetadataCacheBinary(binary);
+    }
+
+    Timer timer;
+    uint64 jsonTime = 0;
+#if !OGRE_NO_JSON
+    {
+        NullTextureGpuManager textureManager;
+        timer.reset();
+        textureManager.importTextureMetadataCache("test", json.c_str(), false);
+        jsonTime = timer.getMicroseconds();
+    }
+#endif
+
+    uint64 binaryTime;
+    {
+        NullTextureGpuManager textureManager;
+        timer.reset();
+        CPPUNIT_ASSERT(
+            textureManager.importTextureMetadataCacheBinary(&binary[0], binary.size(), false));
+        binaryTime = timer.getMicroseconds();
+    }
+
+    LogManager::getSingleton().logMessage(
+        "Texture metadata cache, " + StringConverter::toString(numTextures) + " textures: JSON " +
+        StringConverter::toString(json.size()) + " bytes " + StringConverter::toString(jsonTime) +
+        " us, binary " + StringConverter::toString(binary.size()) + " bytes " +
+        StringConverter::toString(binaryTime) + " us");
+}
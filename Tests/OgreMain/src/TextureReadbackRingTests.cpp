@@ -0,0 +1,258 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "TextureReadbackRingTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreAsyncTextureTicket.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreTextureReadbackRing.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TextureReadbackRingTests);
+
+namespace
+{
+    const uint32 c_width = 4u;
+    const uint32 c_height = 4u;
+
+    /// Ticket whose "downloaded" contents are written directly by the test
+    class FakeAsyncTextureTicket : public AsyncTextureTicket
+    {
+        std::vector<uint8> mData;
+
+    protected:
+        TextureBox mapImpl(uint32 slice) override
+        {
+            const uint32 bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel(mPixelFormatFamily);
+            TextureBox retVal(mWidth, mHeight, 1u, 1u, bytesPerPixel, mWidth * bytesPerPixel,
+                              mData.size());
+            retVal.data = &mData[0];
+            return retVal;
+        }
+        void unmapImpl() override {}
+
+    public:
+        FakeAsyncTextureTicket(uint32 width, uint32 height, PixelFormatGpu pixelFormatFamily) :
+            AsyncTextureTicket(width, height, 1u, TextureTypes::Type2D, pixelFormatFamily),
+            mData(width * height * PixelFormatGpuUtils::getBytesPerPixel(pixelFormatFamily))
+        {
+        }
+
+        void fill(uint8 seed)
+        {
+            for (size_t i = 0; i < mData.size(); ++i)
+                mData[i] = static_cast<uint8>(seed + i);
+        }
+    };
+
+    class FakeTextureGpuManager : public TextureGpuManager
+    {
+    protected:
+        TextureGpu *createTextureImpl(GpuPageOutStrategy::GpuPageOutStrategy, IdString, uint32,
+                                      TextureTypes::TextureTypes) override
+        {
+            return 0;
+        }
+        StagingTexture *createStagingTextureImpl(uint32, uint32, uint32, uint32,
+                                                 PixelFormatGpu) override
+        {
+            return 0;
+        }
+        void destroyStagingTextureImpl(StagingTexture *) override {}
+        AsyncTextureTicket *createAsyncTextureTicketImpl(uint32 width, uint32 height, uint32,
+                                                         TextureTypes::TextureTypes,
+                                                         PixelFormatGpu pixelFormatFamily) override
+        {
+            return OGRE_NEW FakeAsyncTextureTicket(width, height, pixelFormatFamily);
+        }
+
+    public:
+        FakeTextureGpuManager() : TextureGpuManager(0, 0) {}
+        ~FakeTextureGpuManager() override { destroyAll(); }
+    };
+
+    /// Skips the actual GPU download; the test fills the ticket instead
+    class TestReadbackRing : public TextureReadbackRing
+    {
+    protected:
+        void downloadToSlot(Slot &slot, TextureGpu *texture, uint8 mipLevel) override {}
+
+    public:
+        TestReadbackRing(TextureGpuManager *textureManager, PixelFormatGpu pixelFormat,
+                         TextureReadbackListener *listener, size_t numWorkerThreads,
+                         PixelFormatGpu dstPixelFormat) :
+            TextureReadbackRing(textureManager, c_width, c_height, pixelFormat, 3u, listener,
+                                numWorkerThreads, dstPixelFormat)
+        {
+        }
+
+        /// Simulates the download of a texture whose contents are generated from seed
+        bool readbackSeed(uint8 seed)
+        {
+            FakeAsyncTextureTicket *ticket =
+                static_cast<FakeAsyncTextureTicket *>(mSlots[mNextSlot].ticket);
+            if (mSlots[mNextSlot].state.load() != SlotFree)
+                return false;
+            ticket->fill(seed);
+            return TextureReadbackRing::readback(0, seed);
+        }
+
+        FakeAsyncTextureTicket *getTicket(size_t idx)
+        {
+            return static_cast<FakeAsyncTextureTicket *>(mSlots[idx].ticket);
+        }
+    };
+
+    class TestReadbackListener : public TextureReadbackListener
+    {
+    public:
+        std::mutex mutex;
+        std::map<uint64, std::vector<uint8> > results;
+        std::vector<std::thread::id> threadIds;
+
+        void readbackFinished(const TextureBox &box, PixelFormatGpu pixelFormat,
+                              uint64 frameId) override
+        {
+            const size_t bytesPerRow = box.width * PixelFormatGpuUtils::getBytesPerPixel(pixelFormat);
+            std::vector<uint8> data;
+            for (uint32 y = 0; y < box.height; ++y)
+            {
+                const uint8 *row = reinterpret_cast<const uint8 *>(box.at(0, y, 0));
+                data.insert(data.end(), row, row + bytesPerRow);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[frameId] = data;
+            threadIds.push_back(std::this_thread::get_id());
+        }
+    };
+
+    /// What the listener must receive for a texture generated from seed, after conversion
+    std::vector<uint8> getExpected(uint8 seed, PixelFormatGpu srcFormat, PixelFormatGpu dstFormat)
+    {
+        FakeAsyncTextureTicket src(c_width, c_height, srcFormat);
+        src.fill(seed);
+        const TextureBox srcBox = src.map(0u);
+
+        const uint32 bytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel(dstFormat);
+        std::vector<uint8> retVal(c_width * c_height * bytesPerPixel);
+        TextureBox dstBox(c_width, c_height, 1u, 1u, bytesPerPixel, c_width * bytesPerPixel,
+                          retVal.size());
+        dstBox.data = &retVal[0];
+        PixelFormatGpuUtils::bulkPixelConversion(srcBox, srcFormat, dstBox, dstFormat);
+        src.unmap();
+        return retVal;
+    }
+}
+
+//--------------------------------------------------------------------------
+void TextureReadbackRingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TextureReadbackRingTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TextureReadbackRingTests::testConvertOnMainThreadWithoutWorkers()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FakeTextureGpuManager textureManager;
+    TestReadbackListener listener;
+    {
+        TestReadbackRing ring(&textureManager, PFG_RGBA8_UNORM, &listener, 0u, PFG_BGRA8_UNORM);
+        for (uint8 i = 0u; i < 3u; ++i)
+            CPPUNIT_ASSERT(ring.readbackSeed(i));
+        CPPUNIT_ASSERT(!ring.readbackSeed(3u));
+
+        CPPUNIT_ASSERT_EQUAL((size_t)3u, ring.poll());
+        CPPUNIT_ASSERT(ring.readbackSeed(3u));
+        ring.flush();
+    }
+
+    CPPUNIT_ASSERT_EQUAL((size_t)4u, listener.results.size());
+    for (uint8 i = 0u; i < 4u; ++i)
+        CPPUNIT_ASSERT(listener.results[i] == getExpected(i, PFG_RGBA8_UNORM, PFG_BGRA8_UNORM));
+    for (size_t i = 0u; i < listener.threadIds.size(); ++i)
+        CPPUNIT_ASSERT(listener.threadIds[i] == std::this_thread::get_id());
+}
+//--------------------------------------------------------------------------
+void TextureReadbackRingTests::testConvertOnWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint8 numFrames = 32u;
+
+    FakeTextureGpuManager textureManager;
+    TestReadbackListener listener;
+    {
+        TestReadbackRing ring(&textureManager, PFG_RGBA8_UNORM, &listener, 2u, PFG_BGRA8_UNORM);
+        for (uint8 i = 0u; i < numFrames; ++i)
+        {
+            while (!ring.readbackSeed(i))
+                ring.poll();
+        }
+        ring.flush();
+    }
+
+    CPPUNIT_ASSERT_EQUAL((size_t)numFrames, listener.results.size());
+    for (uint8 i = 0u; i < numFrames; ++i)
+        CPPUNIT_ASSERT(listener.results[i] == getExpected(i, PFG_RGBA8_UNORM, PFG_BGRA8_UNORM));
+    for (size_t i = 0u; i < listener.threadIds.size(); ++i)
+        CPPUNIT_ASSERT(listener.threadIds[i] != std::this_thread::get_id());
+}
+//--------------------------------------------------------------------------
+void TextureReadbackRingTests::testTicketReusedBeforeWorkerRuns()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Once poll() returns, the ticket is unmapped and may be overwritten by the next
+    // download before the worker converted it. The worker must use its own copy.
+    FakeTextureGpuManager textureManager;
+    TestReadbackListener listener;
+    {
+        TestReadbackRing ring(&textureManager, PFG_RGBA8_UNORM, &listener, 1u, PFG_BGRA8_UNORM);
+        CPPUNIT_ASSERT(ring.readbackSeed(7u));
+        CPPUNIT_ASSERT_EQUAL((size_t)1u, ring.poll());
+        ring.getTicket(0u)->fill(200u);
+        ring.flush();
+    }
+
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, listener.results.size());
+    CPPUNIT_ASSERT(listener.results[7u] == getExpected(7u, PFG_RGBA8_UNORM, PFG_BGRA8_UNORM));
+}
@@ -0,0 +1,195 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "TextureStreamingPriorityTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreTextureGpuManager.h"
+
+#include <algorithm>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TextureStreamingPriorityTests);
+
+namespace
+{
+    /// Has the same usage interface as GpuResource, without needing a VaoManager
+    struct FakeTexture
+    {
+        uint32 id;
+        uint32 lastFrameUsed;
+        float lowestDistanceToCamera;
+
+        uint32 getLastFrameUsed() const { return lastFrameUsed; }
+        float getLowestDistanceToCamera() const { return lowestDistanceToCamera; }
+    };
+
+    const float c_neverReported = std::numeric_limits<float>::max();
+
+    struct StreamingCmp
+    {
+        uint32 frameCount;
+        bool operator()(const FakeTexture &a, const FakeTexture &b) const
+        {
+            return TextureGpuManager::_isStreamedBefore(a, b, frameCount);
+        }
+    };
+
+    struct PageOutCmp
+    {
+        bool operator()(const FakeTexture &a, const FakeTexture &b) const
+        {
+            return TextureGpuManager::_isPagedOutBefore(a, b);
+        }
+    };
+
+    std::vector<uint32> getIds(const std::vector<FakeTexture> &textures)
+    {
+        std::vector<uint32> retVal;
+        for (size_t i = 0; i < textures.size(); ++i)
+            retVal.push_back(textures[i].id);
+        return retVal;
+    }
+}
+
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::testStreamingOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint32 frameCount = 100u;
+
+    // Used this frame or the previous one: closest first.
+    // Then used in older frames: most recent first.
+    std::vector<FakeTexture> textures;
+    FakeTexture t0 = { 0u, 90u, 1.0f };
+    FakeTexture t1 = { 1u, 100u, 50.0f };
+    FakeTexture t2 = { 2u, 99u, 5.0f };
+    FakeTexture t3 = { 3u, 95u, 0.5f };
+    FakeTexture t4 = { 4u, 100u, 10.0f };
+    textures.push_back(t0);
+    textures.push_back(t1);
+    textures.push_back(t2);
+    textures.push_back(t3);
+    textures.push_back(t4);
+
+    StreamingCmp cmp = { frameCount };
+    std::stable_sort(textures.begin(), textures.end(), cmp);
+
+    const uint32 expected[] = { 2u, 4u, 1u, 3u, 0u };
+    CPPUNIT_ASSERT(getIds(textures) == std::vector<uint32>(expected, expected + 5));
+}
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::testUnreportedTexturesStreamLast()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint32 frameCount = 100u;
+
+    // Textures start with lastFrameUsed = frame they were created in, but no distance.
+    // They must go after everything that was reported, even long ago, in FIFO order.
+    std::vector<FakeTexture> textures;
+    FakeTexture t0 = { 0u, 100u, c_neverReported };
+    FakeTexture t1 = { 1u, 10u, 1000.0f };
+    FakeTexture t2 = { 2u, 99u, c_neverReported };
+    FakeTexture t3 = { 3u, 100u, 1000.0f };
+    FakeTexture t4 = { 4u, 50u, c_neverReported };
+    textures.push_back(t0);
+    textures.push_back(t1);
+    textures.push_back(t2);
+    textures.push_back(t3);
+    textures.push_back(t4);
+
+    StreamingCmp cmp = { frameCount };
+    std::stable_sort(textures.begin(), textures.end(), cmp);
+
+    const uint32 expected[] = { 3u, 1u, 0u, 2u, 4u };
+    CPPUNIT_ASSERT(getIds(textures) == std::vector<uint32>(expected, expected + 5));
+}
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::testPageOutCandidates()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint32 frameCount = 100u;
+
+    const FakeTexture neverReported = { 0u, 10u, c_neverReported };
+    const FakeTexture usedNow = { 1u, 100u, 1.0f };
+    const FakeTexture usedTwoFramesAgo = { 2u, 98u, 1.0f };
+    const FakeTexture usedThreeFramesAgo = { 3u, 97u, 1.0f };
+
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPageOutCandidate(neverReported, frameCount));
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPageOutCandidate(usedNow, frameCount));
+    CPPUNIT_ASSERT(!TextureGpuManager::_isPageOutCandidate(usedTwoFramesAgo, frameCount));
+    CPPUNIT_ASSERT(TextureGpuManager::_isPageOutCandidate(usedThreeFramesAgo, frameCount));
+}
+//--------------------------------------------------------------------------
+void TextureStreamingPriorityTests::testEvictionOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint32 frameCount = 100u;
+
+    std::vector<FakeTexture> textures;
+    FakeTexture t0 = { 0u, 90u, 1.0f };
+    FakeTexture t1 = { 1u, 100u, 1.0f };
+    FakeTexture t2 = { 2u, 20u, 1.0f };
+    FakeTexture t3 = { 3u, 90u, 30.0f };
+    FakeTexture t4 = { 4u, 5u, c_neverReported };
+    FakeTexture t5 = { 5u, 50u, 2.0f };
+    textures.push_back(t0);
+    textures.push_back(t1);
+    textures.push_back(t2);
+    textures.push_back(t3);
+    textures.push_back(t4);
+    textures.push_back(t5);
+
+    // Same selection & order as TextureGpuManager::enforceStreamingVramBudget
+    std::vector<FakeTexture> candidates;
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (TextureGpuManager::_isPageOutCandidate(textures[i], frameCount))
+            candidates.push_back(textures[i]);
+    }
+    std::sort(candidates.begin(), candidates.end(), PageOutCmp());
+
+    // Least recently used first, farthest first on ties.
+    // Never reported & recently used textures are left alone.
+    const uint32 expected[] = { 2u, 5u, 3u, 0u };
+    CPPUNIT_ASSERT(getIds(candidates) == std::vector<uint32>(expected, expected + 4));
+}
@@ -0,0 +1,433 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreArchiveManager.h"
+#include "OgreCamera.h"
+#include "OgreConfigFile.h"
+#include "OgreHlmsDiskCache.h"
+#include "OgreHlmsManager.h"
+#include "OgreLogManager.h"
+#include "OgreRenderSystemCapabilitiesManager.h"
+#include "OgreRoot.h"
+#include "OgreString.h"
+#include "OgreWindow.h"
+
+#include "Compositor/OgreCompositorManager2.h"
+#include "Compositor/OgreCompositorNodeDef.h"
+#include "Compositor/OgreCompositorWorkspace.h"
+#include "Compositor/OgreCompositorWorkspaceDef.h"
+#include "Compositor/Pass/PassWarmUp/OgreCompositorPassWarmUp.h"
+
+#include "OgreHlmsPbs.h"
+#include "OgreHlmsUnlit.h"
+
+#include "OgreSceneFormatImporter.h"
+
+#ifdef OGRE_STATIC_LIB
+#    include "OgreNULLRenderSystem.h"
+#endif
+
+#include <cstdio>
+
+using namespace Ogre;
+
+static void help()
+{
+    printf(
+        "Offline Hlms shader variant precompiler.\n"
+        "Loads a scene exported with SceneFormat, generates every Hlms shader variant\n"
+        "needed to render it through the given compositor node (without frustum culling,\n"
+        "using warm_up passes) and writes hlmsDiskCacheN.bin files that the app can load\n"
+        "with HlmsDiskCache to avoid compiling shaders at runtime.\n"
+        "\n"
+        "No GPU is needed: everything runs on the NULL RenderSystem, which is told to\n"
+        "emulate the capabilities of the target RenderSystem. Hlms derives lots of\n"
+        "properties from them (shader profiles, texture gather, hw gamma, separate\n"
+        "samplers, etc) so they must match exactly or the cache won't hit. Dump them\n"
+        "once on the target device with:\n"
+        "   RenderSystemCapabilitiesSerializer().writeScript(\n"
+        "       renderSystem->getCapabilities(), \"Target\", \"target.rendercaps\" );\n"
+        "\n"
+        "Note: API pipeline caches (e.g. Vulkan's pipelineCache.cache) are GPU and driver\n"
+        "specific and can't be generated offline. They're filled by the app on first run\n"
+        "from the shaders in the Hlms disk cache.\n"
+        "\n"
+        "USAGE:\n"
+        "   OgreHlmsPrecompiler [options] -caps target.rendercaps -n RefNodeName scene.json\n"
+        "                       /path/to/output/folder\n"
+        "\n"
+        "    -n <name>          Compositor node to generate warm_up passes from. Usually the\n"
+        "                       one rendering the scene. All its input channels are bound to\n"
+        "                       the emulated window.\n"
+        "    -r <file>          Resources cfg with the same format as the samples'\n"
+        "                       resources2.cfg. Must contain the material JSONs, meshes and\n"
+        "                       compositor scripts. Defaults to resources2.cfg\n"
+        "    -caps <file>       RenderSystemCapabilities of the target, as written by\n"
+        "                       RenderSystemCapabilitiesSerializer. Required.\n"
+        "    -capsname <name>   Capabilities to use when the file's folder contains more\n"
+        "                       than one .rendercaps entry.\n"
+        "    -glslversion <N>   Shading language version to emulate. Defaults to 450.\n"
+        "    -readonlytexbuffer <Yes|No>\n"
+        "                       Whether ReadOnly buffers are tex buffers in the target\n"
+        "                       (VaoManager::readOnlyIsTexBuffer). Defaults to No, which is\n"
+        "                       the case of Vulkan, D3D11 and GL3+ with SSBOs. Use Yes for\n"
+        "                       Metal and GL3+ without SSBOs.\n"
+        "    -w <width>         Width of the emulated window. Defaults to 1920.\n"
+        "    -h <height>        Height of the emulated window. Defaults to 1080.\n"
+        "    -p <key>=<value>   Extra param for the emulated window (e.g. gamma=Yes,\n"
+        "                       reverse_depth=No). Can be repeated. Must match the app's\n"
+        "                       settings because they're part of the PSO.\n"
+        "\n"
+        "Only the stock HlmsPbs & HlmsUnlit implementations are registered. Variants\n"
+        "depending on custom Hlms implementations or listeners won't be generated.\n" );
+}
+
+static void setupResources( const String &resourcesCfg, String &outRootHlmsFolder )
+{
+    String basename, resourcePath;
+    StringUtil::splitFilename( resourcesCfg, basename, resourcePath );
+
+    ConfigFile cf;
+    cf.load( resourcesCfg );
+
+    outRootHlmsFolder = resourcePath + cf.getSetting( "DoNotUseAsResource", "Hlms", "" );
+    if( outRootHlmsFolder.empty() )
+        outRootHlmsFolder = "./";
+    else if( *( outRootHlmsFolder.end() - 1 ) != '/' )
+        outRootHlmsFolder += "/";
+
+    ConfigFile::SectionIterator seci = cf.getSectionIterator();
+
+    String secName, typeName, archName;
+    while( seci.hasMoreElements() )
+    {
+        secName = seci.peekNextKey();
+        ConfigFile::SettingsMultiMap *settings = seci.getNext();
+
+        if( secName != "Hlms" && secName != "DoNotUseAsResource" )
+        {
+            ConfigFile::SettingsMultiMap::iterator i;
+            for( i = settings->begin(); i != settings->end(); ++i )
+            {
+                typeName = i->first;
+                archName = i->second;
+                ResourceGroupManager::getSingleton().addResourceLocation( resourcePath + archName,
+                                                                          typeName, secName );
+            }
+        }
+    }
+}
+
+static void loadArchives( const String &rootHlmsFolder, const String &mainFolderPath,
+                          const StringVector &libraryFoldersPaths, Archive **outArchive,
+                          ArchiveVec &outLibraryFolders )
+{
+    ArchiveManager &archiveManager = ArchiveManager::getSingleton();
+
+    *outArchive = archiveManager.load( rootHlmsFolder + mainFolderPath, "FileSystem", true );
+
+    StringVector::const_iterator itor = libraryFoldersPaths.begin();
+    StringVector::const_iterator endt = libraryFoldersPaths.end();
+    while( itor != endt )
+    {
+        outLibraryFolders.push_back(
+            archiveManager.load( rootHlmsFolder + *itor, "FileSystem", true ) );
+        ++itor;
+    }
+}
+
+static void registerHlms( const String &rootHlmsFolder )
+{
+    HlmsManager *hlmsManager = Root::getSingleton().getHlmsManager();
+
+    String mainFolderPath;
+    StringVector libraryFoldersPaths;
+
+    {
+        Archive *archiveUnlit = 0;
+        ArchiveVec archiveUnlitLibraryFolders;
+        HlmsUnlit::getDefaultPaths( mainFolderPath, libraryFoldersPaths );
+        loadArchives( rootHlmsFolder, mainFolderPath, libraryFoldersPaths, &archiveUnlit,
+                      archiveUnlitLibraryFolders );
+        hlmsManager->registerHlms( OGRE_NEW HlmsUnlit( archiveUnlit, &archiveUnlitLibraryFolders ) );
+    }
+
+    {
+        Archive *archivePbs = 0;
+        ArchiveVec archivePbsLibraryFolders;
+        HlmsPbs::getDefaultPaths( mainFolderPath, libraryFoldersPaths );
+        loadArchives( rootHlmsFolder, mainFolderPath, libraryFoldersPaths, &archivePbs,
+                      archivePbsLibraryFolders );
+        hlmsManager->registerHlms( OGRE_NEW HlmsPbs( archivePbs, &archivePbsLibraryFolders ) );
+    }
+}
+
+/// Same as GraphicsSystem::loadResources; the availability of these
+/// textures changes the properties (and thus the shaders) Pbs generates.
+static void loadHlmsTextures()
+{
+    HlmsManager *hlmsManager = Root::getSingleton().getHlmsManager();
+    try
+    {
+        hlmsManager->loadBlueNoise();
+    }
+    catch( FileNotFoundException &e )
+    {
+        LogManager::getSingleton().logMessage( e.getFullDescription(), LML_CRITICAL );
+    }
+
+    HlmsPbs *hlmsPbs = static_cast<HlmsPbs *>( hlmsManager->getHlms( HLMS_PBS ) );
+    try
+    {
+        hlmsPbs->loadLtcMatrix();
+    }
+    catch( FileNotFoundException &e )
+    {
+        LogManager::getSingleton().logMessage( e.getFullDescription(), LML_CRITICAL );
+    }
+}
+
+/// Parses every .rendercaps file next to capsFile (the same way Root does with the
+/// "Custom Capabilities" config setting) and returns the requested one.
+static RenderSystemCapabilities *loadCapabilities( const String &capsFile, const String &capsName )
+{
+    String basename, folder;
+    StringUtil::splitFilename( capsFile, basename, folder );
+    if( folder.empty() )
+        folder = "./";
+
+    RenderSystemCapabilitiesManager &rscManager = RenderSystemCapabilitiesManager::getSingleton();
+    rscManager.parseCapabilitiesFromArchive( folder, "FileSystem", false );
+
+    const map<String, RenderSystemCapabilities *>::type &parsedCaps = rscManager.getCapabilities();
+
+    RenderSystemCapabilities *rsc = 0;
+    if( !capsName.empty() )
+    {
+        map<String, RenderSystemCapabilities *>::type::const_iterator itor =
+            parsedCaps.find( capsName );
+        if( itor != parsedCaps.end() )
+            rsc = itor->second;
+    }
+    else if( parsedCaps.size() == 1u )
+    {
+        rsc = parsedCaps.begin()->second;
+    }
+
+    if( !rsc )
+    {
+        OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND,
+                     "Could not find RenderSystemCapabilities '" + capsName + "' in " + folder +
+                         ". Use -capsname if the folder contains more than one.",
+                     "loadCapabilities" );
+    }
+
+    return rsc;
+}
+
+static CompositorWorkspace *setupWarmUpWorkspace( SceneManager *sceneManager, Camera *camera,
+                                                  Window *window, const String &refNodeName )
+{
+    CompositorManager2 *compositorManager = Root::getSingleton().getCompositorManager2();
+
+    if( !compositorManager->hasNodeDefinition( refNodeName ) )
+    {
+        OGRE_EXCEPT( Exception::ERR_ITEM_NOT_FOUND,
+                     "Compositor node '" + refNodeName + "' not found in the resources",
+                     "setupWarmUpWorkspace" );
+    }
+
+    const String warmUpNodeName = "HlmsPrecompiler/WarmUp/" + refNodeName;
+    WarmUpHelper::createFrom( compositorManager, warmUpNodeName, refNodeName, true );
+
+    const CompositorNodeDef *warmUpNodeDef = compositorManager->getNodeDefinition( warmUpNodeName );
+    const uint32 numInputChannels = static_cast<uint32>( warmUpNodeDef->getNumInputChannels() );
+
+    const String workspaceName = "HlmsPrecompiler/Workspace";
+    CompositorWorkspaceDef *workspaceDef = compositorManager->addWorkspaceDefinition( workspaceName );
+
+    // We don't know what the app binds to each channel. Assume it's the window (or at least
+    // something with its format), which is what a scene node usually renders to.
+    CompositorChannelVec externalChannels;
+    for( uint32 i = 0u; i < numInputChannels; ++i )
+    {
+        workspaceDef->connectExternal( i, warmUpNodeName, i );
+        externalChannels.push_back( window->getTexture() );
+    }
+
+    return compositorManager->addWorkspace( sceneManager, externalChannels, camera, workspaceName,
+                                            true );
+}
+
+static void saveHlmsDiskCaches( const String &outputFolder )
+{
+    HlmsManager *hlmsManager = Root::getSingleton().getHlmsManager();
+    HlmsDiskCache diskCache( hlmsManager );
+
+    Archive *outputArchive = ArchiveManager::getSingleton().load( outputFolder, "FileSystem", false );
+
+    for( size_t i = HLMS_LOW_LEVEL + 1u; i < HLMS_MAX; ++i )
+    {
+        Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+        if( hlms )
+        {
+            diskCache.copyFrom( hlms );
+
+            const String filename = "hlmsDiskCache" + StringConverter::toString( i ) + ".bin";
+            DataStreamPtr diskCacheFile = outputArchive->create( filename );
+            diskCache.saveTo( diskCacheFile );
+            diskCacheFile->close();
+
+            printf( "%s: %u shader variants\n", filename.c_str(),
+                    static_cast<unsigned>( hlms->getShaderCodeCache().size() ) );
+        }
+    }
+
+    ArchiveManager::getSingleton().unload( outputArchive );
+}
+
+int main( int numargs, char **args )
+{
+    String refNodeName;
+    String resourcesCfg = "resources2.cfg";
+    String sceneFile;
+    String outputFolder;
+    String capsFile;
+    String capsName;
+    uint32 width = 1920u;
+    uint32 height = 1080u;
+
+    NameValuePairList miscParams;
+    miscParams["emulated_shading_language_version"] = "450";
+    miscParams["emulated_read_only_is_tex_buffer"] = "No";
+
+    int i = 1;
+    for( ; i + 1 < numargs && args[i][0] == '-'; i += 2 )
+    {
+        const String option = args[i];
+        const String value = args[i + 1];
+        if( option == "-n" )
+            refNodeName = value;
+        else if( option == "-r" )
+            resourcesCfg = value;
+        else if( option == "-caps" )
+            capsFile = value;
+        else if( option == "-capsname" )
+            capsName = value;
+        else if( option == "-glslversion" )
+            miscParams["emulated_shading_language_version"] = value;
+        else if( option == "-readonlytexbuffer" )
+            miscParams["emulated_read_only_is_tex_buffer"] = value;
+        else if( option == "-w" )
+            width = StringConverter::parseUnsignedInt( value, width );
+        else if( option == "-h" )
+            height = StringConverter::parseUnsignedInt( value, height );
+        else if( option == "-p" && value.find( '=' ) != String::npos )
+        {
+            const size_t pos = value.find( '=' );
+            miscParams[value.substr( 0, pos )] = value.substr( pos + 1u );
+        }
+        else
+        {
+            fprintf( stderr, "Unknown or malformed option '%s'\n\n", option.c_str() );
+            help();
+            return -1;
+        }
+    }
+
+    if( i + 2 != numargs || refNodeName.empty() || capsFile.empty() )
+    {
+        help();
+        return -1;
+    }
+
+    sceneFile = args[i];
+    outputFolder = args[i + 1];
+
+    String pluginsPath;
+    // only use plugins.cfg if not static
+#ifndef OGRE_STATIC_LIB
+#    if OGRE_DEBUG_MODE
+    pluginsPath = "plugins_tools_d.cfg";
+#    else
+    pluginsPath = "plugins_tools.cfg";
+#    endif
+#endif
+
+    int retCode = 0;
+    Root *root = 0;
+    try
+    {
+        root = OGRE_NEW Root( nullptr, pluginsPath, "", "OgreHlmsPrecompiler.log" );
+
+#ifdef OGRE_STATIC_LIB
+        root->addRenderSystem( new NULLRenderSystem() );
+#endif
+
+        root->setRenderSystem( root->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+        root->useCustomRenderSystemCapabilities( loadCapabilities( capsFile, capsName ) );
+        root->initialise( false );
+
+        Window *window =
+            root->createRenderWindow( "OgreHlmsPrecompiler", width, height, false, &miscParams );
+
+        String rootHlmsFolder;
+        setupResources( resourcesCfg, rootHlmsFolder );
+        registerHlms( rootHlmsFolder );
+
+        // Initialise, parse scripts (compositors, material JSONs) etc
+        ResourceGroupManager::getSingleton().initialiseAllResourceGroups( true );
+
+        loadHlmsTextures();
+
+        SceneManager *sceneManager = root->createSceneManager( ST_GENERIC, 1u, "HlmsPrecompiler" );
+        Camera *camera = sceneManager->createCamera( "HlmsPrecompiler/Camera" );
+
+        {
+            SceneFormatImporter importer( root, sceneManager, BLANKSTRING );
+            importer.importSceneFromFile( sceneFile );
+        }
+
+        setupWarmUpWorkspace( sceneManager, camera, window, refNodeName );
+
+        // The warm_up passes go through every Item & Entity regardless of visibility,
+        // compiling all the shaders & PSOs the reference node would need
+        root->renderOneFrame();
+
+        saveHlmsDiskCaches( outputFolder );
+    }
+    catch( Exception &e )
+    {
+        fprintf( stderr, "%s\n", e.getFullDescription().c_str() );
+        retCode = 1;
+    }
+
+    OGRE_DELETE root;
+
+    return retCode;
+}
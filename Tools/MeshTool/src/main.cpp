@@ -100,7 +100,8 @@ void help()
     cout << "-E endian  = Set endian mode 'big' 'little' or 'native' (default)" << endl;
     cout << "-b         = Recalculate bounding box (static meshes only)" << endl;
     cout << "-V version = Specify OGRE version format to write instead of latest" << endl;
-    cout << "             Options are: 2.1, 1.10, 1.8, 1.7, 1.4, 1.0" << endl;
+    cout << "             Options are: 2.1, 2.1a, 1.10, 1.8, 1.7, 1.4, 1.0" << endl;
+    cout << "             2.1a (v2 only) aligns vertex & index data for memory mapped loading" << endl;
     cout << "-v2          Export the mesh as a v2 object. Keeps the original format otherwise." << endl;
     cout << "             Use this format if you load the mesh by the SceneManager::createItem() method." << endl;
     cout << "-v1          Export the mesh as a v1 object. Keeps the original format otherwise." << endl;
@@ -310,6 +311,11 @@ void parseOpts(UnaryOptionList& unOpts, BinaryOptionList& binOpts)
             opts.targetVersion  = v1::MESH_VERSION_2_1;
             opts.targetVersionV2= MESH_VERSION_2_1;
         }
+        else if (bi->second == "2.1a")
+        {
+            // v2 only: 2.1 with 16-byte aligned vertex & index data
+            opts.targetVersionV2= MESH_VERSION_2_1_ALIGNED;
+        }
 
         if( !opts.exportAsV2 )
         {